@@ -56,6 +56,7 @@
 #include "gromacs/analysisdata/paralleloptions.h"
 #include "gromacs/utility/exceptions.h"
 #include "gromacs/utility/gmxassert.h"
+#include "gromacs/utility/mutex.h"
 
 namespace gmx
 {
@@ -238,7 +239,7 @@ public:
      * There is always one unused frame in the buffer, which is initialized
      * such that when \a firstFrameLocation_ is incremented, it becomes
      * valid.  This makes it easier to rotate the buffer in concurrent
-     * access scenarions (which are not yet otherwise implemented).
+     * access scenarios.
      */
     FrameList frames_;
     //! Location of oldest frame in \a frames_.
@@ -263,6 +264,15 @@ public:
      * frame (see \a frames_).
      */
     int nextIndex_;
+    /*! \brief
+     * Protects the storage state for concurrent access.
+     *
+     * With parallelization factor larger than one, frames can be started
+     * and finished concurrently from multiple threads.  The mutex is held
+     * while \a frames_, \a builders_ and the indices are accessed, but not
+     * during notifications to the modules.
+     */
+    Mutex mutex_;
 };
 
 /********************************************************************
@@ -479,15 +489,25 @@ AnalysisDataFrameBuilderPointer AnalysisDataStorageImpl::getFrameBuilder()
 
 void AnalysisDataStorageImpl::finishFrame(int index)
 {
-    const int storageIndex = computeStorageLocation(index);
-    GMX_RELEASE_ASSERT(storageIndex >= 0, "Out of bounds frame index");
-
-    AnalysisDataStorageFrameData& storedFrame = *frames_[storageIndex];
-    GMX_RELEASE_ASSERT(storedFrame.isStarted(),
-                       "finishFrame() called for frame before startFrame()");
-    GMX_RELEASE_ASSERT(!storedFrame.isFinished(), "finishFrame() called twice for the same frame");
-    GMX_RELEASE_ASSERT(storedFrame.frameIndex() == index, "Inconsistent internal frame indexing");
-    builders_.push_back(storedFrame.finishFrame(isMultipoint()));
+    AnalysisDataStorageFrameData* storedFramePtr;
+    {
+        lock_guard<Mutex> lock(mutex_);
+        const int         storageIndex = computeStorageLocation(index);
+        GMX_RELEASE_ASSERT(storageIndex >= 0, "Out of bounds frame index");
+        storedFramePtr = frames_[storageIndex].get();
+        GMX_RELEASE_ASSERT(storedFramePtr->isStarted(),
+                           "finishFrame() called for frame before startFrame()");
+        GMX_RELEASE_ASSERT(!storedFramePtr->isFinished(),
+                           "finishFrame() called twice for the same frame");
+        GMX_RELEASE_ASSERT(storedFramePtr->frameIndex() == index,
+                           "Inconsistent internal frame indexing");
+    }
+    AnalysisDataStorageFrameData&   storedFrame = *storedFramePtr;
+    AnalysisDataFrameBuilderPointer builder     = storedFrame.finishFrame(isMultipoint());
+    {
+        lock_guard<Mutex> lock(mutex_);
+        builders_.push_back(std::move(builder));
+    }
     modules_->notifyParallelFrameFinish(storedFrame.header());
     if (pendingLimit_ == 1)
     {
@@ -509,7 +529,10 @@ void AnalysisDataStorageImpl::finishFrameSerial(int index)
                        "finishFrameSerial() called twice for the same frame");
     // Increment before the notifications to make the frame available
     // in the module callbacks.
-    ++firstUnnotifiedIndex_;
+    {
+        lock_guard<Mutex> lock(mutex_);
+        ++firstUnnotifiedIndex_;
+    }
     if (shouldNotifyImmediately())
     {
         modules_->notifyFrameFinish(storedFrame.header());
@@ -526,6 +549,7 @@ void AnalysisDataStorageImpl::finishFrameSerial(int index)
     storedFrame.markNotified();
     if (storedFrame.frameIndex() >= storageLimit_)
     {
+        lock_guard<Mutex> lock(mutex_);
         rotateBuffer();
     }
 }
@@ -811,28 +835,32 @@ AnalysisDataStorageFrame& AnalysisDataStorage::startFrame(const AnalysisDataFram
 {
     GMX_ASSERT(header.isValid(), "Invalid header");
     internal::AnalysisDataStorageFrameData* storedFrame;
-    if (impl_->storeAll())
     {
-        size_t size = header.index() + 1;
-        if (impl_->frames_.size() < size)
+        lock_guard<Mutex> lock(impl_->mutex_);
+        if (impl_->storeAll())
         {
-            impl_->extendBuffer(size);
+            size_t size = header.index() + 1;
+            if (impl_->frames_.size() < size)
+            {
+                impl_->extendBuffer(size);
+            }
+            storedFrame = impl_->frames_[header.index()].get();
         }
-        storedFrame = impl_->frames_[header.index()].get();
-    }
-    else
-    {
-        int storageIndex = impl_->computeStorageLocation(header.index());
-        if (storageIndex == -1)
+        else
         {
-            GMX_THROW(APIError("Out of bounds frame index"));
+            int storageIndex = impl_->computeStorageLocation(header.index());
+            if (storageIndex == -1)
+            {
+                GMX_THROW(APIError("Out of bounds frame index"));
+            }
+            storedFrame = impl_->frames_[storageIndex].get();
         }
-        storedFrame = impl_->frames_[storageIndex].get();
+        GMX_RELEASE_ASSERT(!storedFrame->isStarted(),
+                           "startFrame() called twice for the same frame");
+        GMX_RELEASE_ASSERT(storedFrame->frameIndex() == header.index(),
+                           "Inconsistent internal frame indexing");
+        storedFrame->startFrame(header, impl_->getFrameBuilder());
     }
-    GMX_RELEASE_ASSERT(!storedFrame->isStarted(), "startFrame() called twice for the same frame");
-    GMX_RELEASE_ASSERT(storedFrame->frameIndex() == header.index(),
-                       "Inconsistent internal frame indexing");
-    storedFrame->startFrame(header, impl_->getFrameBuilder());
     impl_->modules_->notifyParallelFrameStart(header);
     if (impl_->shouldNotifyImmediately())
     {
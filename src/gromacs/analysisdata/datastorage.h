@@ -252,8 +252,10 @@ private:
  * AnalysisDataStorageFrame::finishPointSet()) take the responsibility of
  * calling all the notification methods in AnalysisDataModuleManager,
  *
- * \todo
- * Proper multi-threaded implementation.
+ * With startParallelDataStorage(), startFrame() and finishFrame() (and the
+ * methods of the returned frame builders) can be called concurrently from
+ * different threads for different frames.  finishFrameSerial() and the other
+ * methods must be called from a single thread.
  *
  * \inlibraryapi
  * \ingroup module_analysisdata
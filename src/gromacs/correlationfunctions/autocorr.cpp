@@ -51,10 +51,12 @@
 #include <cstring>
 
 #include <algorithm>
+#include <vector>
 
 #include "gromacs/correlationfunctions/expfit.h"
 #include "gromacs/correlationfunctions/integrate.h"
 #include "gromacs/correlationfunctions/manyautocorrelation.h"
+#include "gromacs/correlationfunctions/multipletaucorrelator.h"
 #include "gromacs/correlationfunctions/polynomials.h"
 #include "gromacs/fileio/xvgr.h"
 #include "gromacs/math/functions.h"
@@ -807,6 +809,63 @@ void do_autocorr(const char*             fn,
                     acf.bNormalize, bDebugMode(), acf.tbeginfit, acf.tendfit, acf.fitfn);
 }
 
+void do_multipletau_autocorr(const char*                       fn,
+                             const gmx_output_env_t*           oenv,
+                             const char*                       title,
+                             const gmx::MultipleTauCorrelator& correlator,
+                             real                              dt,
+                             gmx_bool                          bAver)
+{
+    if (!bACFinit)
+    {
+        printf("ACF data structures have not been initialised. Call add_acf_pargs\n");
+    }
+
+    sscanf(Leg[0], "%d", &acf.P);
+    if (acf.P > 0)
+    {
+        gmx_fatal(FARGS,
+                  "Legendre polynomials of the correlation can not be computed with the "
+                  "multiple-tau correlator");
+    }
+
+    const std::vector<int64_t> lags = correlator.lags();
+    const std::vector<real>    corr = correlator.correlations(bAver);
+    const int                  nset = bAver ? 1 : correlator.numFunctions();
+
+    /* As for the other methods, the default length is half the number of frames */
+    const int64_t maxLag = (acf.nout > 0) ? acf.nout : (correlator.numSamples() + 1) / 2;
+    const int     nout   = std::lower_bound(lags.begin(), lags.end(), maxLag) - lags.begin();
+
+    FILE* fp  = xvgropen(fn, title, "Time (ps)", "C(t)", oenv);
+    real  sum = 0;
+    for (int set = 0; set < nset; set++)
+    {
+        real c0 = 1;
+        if (acf.bNormalize && nout > 0 && std::fabs(corr[set]) >= 1e-5)
+        {
+            c0 = 1.0 / corr[set];
+        }
+        sum = 0;
+        for (int j = 0; j < nout; j++)
+        {
+            fprintf(fp, "%10.3f  %10.5f\n", lags[j] * dt, corr[j * nset + set] * c0);
+            if (j > 0)
+            {
+                /* Trapezoidal rule on the non-uniform lags */
+                sum += 0.5 * (lags[j] - lags[j - 1]) * dt
+                       * (corr[j * nset + set] + corr[(j - 1) * nset + set]) * c0;
+            }
+        }
+        fprintf(fp, "&\n");
+    }
+    xvgrclose(fp);
+    if (bAver)
+    {
+        printf("Correlation time (integral over corrfn): %g (ps)\n", sum);
+    }
+}
+
 int get_acfnout()
 {
     if (!bACFinit)
@@ -55,6 +55,11 @@
 
 struct gmx_output_env_t;
 
+namespace gmx
+{
+class MultipleTauCorrelator;
+}
+
 /*! \brief Normal correlation f(t)*f(t+dt) */
 #define eacNormal (1 << 0)
 /*! \brief Cosine correlation cos(f(t)-f(t+dt)) */
@@ -127,6 +132,26 @@ void do_autocorr(const char*             fn,
                  unsigned long           mode,
                  gmx_bool                bAver);
 
+/*! \brief
+ * Writes the autocorrelation functions collected by a multiple-tau correlator.
+ *
+ * Uses the normalization and output length chosen with the options from
+ * add_acf_pargs, which has to be called before this can be used.
+ * The time points are not equidistant, so no fitting is done.
+ * \param[in] fn is the file name for xvg output
+ * \param[in] oenv The output environment information
+ * \param[in] title is the title in the output file
+ * \param[in] correlator holds the correlation functions
+ * \param[in] dt is the time between the samples added to \p correlator
+ * \param[in] bAver If set, all C(t) functions are averaged into a single C(t)
+ */
+void do_multipletau_autocorr(const char*                       fn,
+                             const gmx_output_env_t*           oenv,
+                             const char*                       title,
+                             const gmx::MultipleTauCorrelator& correlator,
+                             real                              dt,
+                             gmx_bool                          bAver);
+
 /*! \brief
  * Low level computation of autocorrelation functions
  *
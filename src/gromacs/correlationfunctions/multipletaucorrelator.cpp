@@ -0,0 +1,204 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2021, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Implements gmx::MultipleTauCorrelator.
+ *
+ * \ingroup module_correlationfunctions
+ */
+#include "gmxpre.h"
+
+#include "multipletaucorrelator.h"
+
+#include <algorithm>
+
+#include "gromacs/utility/exceptions.h"
+#include "gromacs/utility/gmxassert.h"
+
+namespace gmx
+{
+
+MultipleTauCorrelator::Level::Level(int blockLength, int width) :
+    history(static_cast<size_t>(blockLength) * width),
+    correlation(static_cast<size_t>(blockLength) * width),
+    count(blockLength),
+    accumulator(width)
+{
+}
+
+MultipleTauCorrelator::MultipleTauCorrelator(int numFunctions,
+                                             int dimension,
+                                             int blockLength,
+                                             int averagingFactor) :
+    numFunctions_(numFunctions),
+    dimension_(dimension),
+    width_(numFunctions * dimension),
+    blockLength_(blockLength),
+    averagingFactor_(averagingFactor)
+{
+    if (numFunctions < 1 || dimension < 1)
+    {
+        GMX_THROW(InvalidInputError("Need at least one function with at least one component"));
+    }
+    if (averagingFactor < 2 || blockLength < averagingFactor || blockLength % averagingFactor != 0)
+    {
+        GMX_THROW(InvalidInputError(
+                "The block length should be a multiple of the averaging factor, which should be "
+                "at least 2"));
+    }
+    carry_.resize(width_);
+    levels_.emplace_back(blockLength_, width_);
+}
+
+void MultipleTauCorrelator::addSample(ArrayRef<const real> values)
+{
+    GMX_RELEASE_ASSERT(values.ssize() == width_, "Need one value per function and component");
+
+    const int   width  = width_;
+    const real* sample = values.data();
+    for (size_t level = 0;; level++)
+    {
+        Level& l = levels_[level];
+
+        l.head = (l.head + 1) % blockLength_;
+        std::copy(sample, sample + width, l.history.begin() + static_cast<size_t>(l.head) * width);
+        l.numStored = std::min(l.numStored + 1, blockLength_);
+
+        /* Lags below blockLength/averagingFactor are covered by the previous level */
+        const int firstLag = (level == 0) ? 0 : blockLength_ / averagingFactor_;
+        for (int lag = firstLag; lag < l.numStored; lag++)
+        {
+            const int   slot  = (l.head - lag + blockLength_) % blockLength_;
+            const real* other = l.history.data() + static_cast<size_t>(slot) * width;
+            double*     corr  = l.correlation.data() + static_cast<size_t>(lag) * width;
+            for (int i = 0; i < width; i++)
+            {
+                corr[i] += sample[i] * other[i];
+            }
+            l.count[lag]++;
+        }
+
+        for (int i = 0; i < width; i++)
+        {
+            l.accumulator[i] += sample[i];
+        }
+        l.numAccumulated++;
+        if (l.numAccumulated < averagingFactor_)
+        {
+            break;
+        }
+
+        const real invFactor = 1.0 / averagingFactor_;
+        for (int i = 0; i < width; i++)
+        {
+            carry_[i]        = l.accumulator[i] * invFactor;
+            l.accumulator[i] = 0;
+        }
+        l.numAccumulated = 0;
+        if (level + 1 == levels_.size())
+        {
+            levels_.emplace_back(blockLength_, width_);
+        }
+        sample = carry_.data();
+    }
+    numSamples_++;
+}
+
+std::vector<int64_t> MultipleTauCorrelator::lags() const
+{
+    std::vector<int64_t> result;
+    int64_t              spacing = 1;
+    for (size_t level = 0; level < levels_.size(); level++)
+    {
+        const int firstLag = (level == 0) ? 0 : blockLength_ / averagingFactor_;
+        for (int lag = firstLag; lag < blockLength_; lag++)
+        {
+            if (levels_[level].count[lag] > 0)
+            {
+                result.push_back(lag * spacing);
+            }
+        }
+        spacing *= averagingFactor_;
+    }
+    return result;
+}
+
+std::vector<real> MultipleTauCorrelator::correlations(bool average) const
+{
+    std::vector<real> result;
+    std::vector<real> point(numFunctions_);
+    for (size_t level = 0; level < levels_.size(); level++)
+    {
+        const Level& l        = levels_[level];
+        const int    firstLag = (level == 0) ? 0 : blockLength_ / averagingFactor_;
+        for (int lag = firstLag; lag < blockLength_; lag++)
+        {
+            if (l.count[lag] == 0)
+            {
+                continue;
+            }
+            const double* corr = l.correlation.data() + static_cast<size_t>(lag) * width_;
+            double        sum  = 0;
+            for (int f = 0; f < numFunctions_; f++)
+            {
+                double c = 0;
+                for (int d = 0; d < dimension_; d++)
+                {
+                    c += corr[f * dimension_ + d];
+                }
+                point[f] = c / l.count[lag];
+                sum += point[f];
+            }
+            if (average)
+            {
+                result.push_back(sum / numFunctions_);
+            }
+            else
+            {
+                result.insert(result.end(), point.begin(), point.end());
+            }
+        }
+    }
+    return result;
+}
+
+void MultipleTauCorrelator::reset()
+{
+    levels_.clear();
+    levels_.emplace_back(blockLength_, width_);
+    numSamples_ = 0;
+}
+
+} // namespace gmx
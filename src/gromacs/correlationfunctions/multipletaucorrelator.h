@@ -0,0 +1,171 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2021, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \libinternal
+ * \file
+ * \brief
+ * Declares a streaming multiple-tau correlator.
+ *
+ * \inlibraryapi
+ * \ingroup module_correlationfunctions
+ */
+#ifndef GMX_CORRELATIONFUNCTIONS_MULTIPLETAUCORRELATOR_H
+#define GMX_CORRELATIONFUNCTIONS_MULTIPLETAUCORRELATOR_H
+
+#include <cstdint>
+
+#include <vector>
+
+#include "gromacs/utility/arrayref.h"
+#include "gromacs/utility/real.h"
+
+namespace gmx
+{
+
+/*! \libinternal
+ * \brief
+ * Computes autocorrelation functions on the fly with the multiple-tau method.
+ *
+ * Samples are added one time step at a time and are not stored. Instead
+ * the correlator keeps a hierarchy of levels, each holding the last
+ * \p blockLength values of the time series averaged over blocks of
+ * \p averagingFactor^level samples, see Ramirez et al.,
+ * J. Chem. Phys. 133, 154103 (2010). The lags of level 0 are 0 to
+ * blockLength-1 sample intervals and are computed exactly, higher levels
+ * cover lags that grow geometrically with a correlation computed from
+ * block averages. Memory use therefore grows only with the logarithm of
+ * the number of samples, which makes the class usable for observables
+ * computed during a simulation as well as for long trajectories.
+ *
+ * The correlator handles many functions at once. Each function has
+ * \p dimension components and its correlation is the sum of the
+ * correlations of the components, i.e. the dot product for vectors.
+ * The values of all functions are stored contiguously per lag, so that
+ * the update is a loop over all functions that the compiler vectorizes.
+ *
+ * Only correlations that are linear in the products of the values, such
+ * as the normal and the vector autocorrelation, can be computed this way.
+ *
+ * \ingroup module_correlationfunctions
+ */
+class MultipleTauCorrelator
+{
+public:
+    /*! \brief Constructs an empty correlator
+     *
+     * \param[in] numFunctions    Number of functions to correlate
+     * \param[in] dimension       Number of components of each function
+     * \param[in] blockLength     Number of lags per level, has to be a multiple of
+     *                            \p averagingFactor
+     * \param[in] averagingFactor Number of values averaged when moving to the next level
+     * \throws InvalidInputError if the parameters are inconsistent.
+     */
+    MultipleTauCorrelator(int numFunctions,
+                          int dimension,
+                          int blockLength     = 16,
+                          int averagingFactor = 2);
+
+    /*! \brief Adds the values at the next time step
+     *
+     * \param[in] values  numFunctions*dimension values, the components of
+     *                    each function are consecutive
+     */
+    void addSample(ArrayRef<const real> values);
+
+    //! Returns the number of samples added since construction or the last reset()
+    int64_t numSamples() const { return numSamples_; }
+
+    //! Returns the number of functions
+    int numFunctions() const { return numFunctions_; }
+
+    /*! \brief Returns the lags, in units of the sample interval, for which
+     * a correlation is available, in increasing order.
+     */
+    std::vector<int64_t> lags() const;
+
+    /*! \brief Returns the correlation functions
+     *
+     * The result has numFunctions entries for each lag returned by lags(),
+     * with the functions consecutive. When \p average is set, the functions
+     * are averaged and the result holds a single value per lag.
+     */
+    std::vector<real> correlations(bool average) const;
+
+    //! Discards all samples, keeping the parameters
+    void reset();
+
+private:
+    //! Data of one level of the hierarchy
+    struct Level
+    {
+        //! Constructs an empty level for \p width values per sample
+        Level(int blockLength, int width);
+
+        //! Ring buffer with the last blockLength samples
+        std::vector<real> history;
+        //! Sum of the products for each lag and value
+        std::vector<double> correlation;
+        //! Number of products summed for each lag
+        std::vector<int64_t> count;
+        //! Sum of the samples to be averaged into the next level
+        std::vector<real> accumulator;
+        //! Number of samples in accumulator
+        int numAccumulated = 0;
+        //! Position of the last sample in history
+        int head = 0;
+        //! Number of valid entries in history
+        int numStored = 0;
+    };
+
+    //! Number of functions
+    int numFunctions_;
+    //! Number of components of each function
+    int dimension_;
+    //! Number of values in one sample
+    int width_;
+    //! Number of lags per level
+    int blockLength_;
+    //! Number of values averaged for the next level
+    int averagingFactor_;
+    //! Number of samples added
+    int64_t numSamples_ = 0;
+    //! The levels, added when needed
+    std::vector<Level> levels_;
+    //! Buffer for passing an averaged sample to the next level
+    std::vector<real> carry_;
+};
+
+} // namespace gmx
+
+#endif
@@ -0,0 +1,169 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2021, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Implements tests of the multiple-tau correlator
+ *
+ * \ingroup module_correlationfunctions
+ */
+#include "gmxpre.h"
+
+#include "gromacs/correlationfunctions/multipletaucorrelator.h"
+
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "gromacs/random/threefry.h"
+#include "gromacs/random/uniformrealdistribution.h"
+#include "gromacs/utility/exceptions.h"
+
+#include "testutils/testasserts.h"
+
+namespace gmx
+{
+namespace
+{
+
+TEST(MultipleTauCorrelatorTest, RejectsInvalidParameters)
+{
+    EXPECT_THROW_GMX(MultipleTauCorrelator(0, 1), InvalidInputError);
+    EXPECT_THROW_GMX(MultipleTauCorrelator(1, 1, 16, 1), InvalidInputError);
+    EXPECT_THROW_GMX(MultipleTauCorrelator(1, 1, 15, 2), InvalidInputError);
+}
+
+TEST(MultipleTauCorrelatorTest, LagsAreSpacedLogarithmically)
+{
+    MultipleTauCorrelator   correlator(1, 1, 4, 2);
+    const std::vector<real> sample = { 1 };
+    for (int i = 0; i < 32; i++)
+    {
+        correlator.addSample(sample);
+    }
+    EXPECT_EQ(32, correlator.numSamples());
+
+    const std::vector<int64_t> expected = { 0, 1, 2, 3, 4, 6, 8, 12, 16, 24 };
+    EXPECT_EQ(expected, correlator.lags());
+}
+
+TEST(MultipleTauCorrelatorTest, ShortLagsAreExact)
+{
+    const int numFunctions = 5;
+    const int dimension    = 3;
+    const int width        = numFunctions * dimension;
+    const int numSamples   = 200;
+    const int blockLength  = 8;
+
+    std::vector<real>             data(numSamples * width);
+    DefaultRandomEngine           rng(1234);
+    UniformRealDistribution<real> dist(-1, 1);
+    for (auto& value : data)
+    {
+        value = dist(rng);
+    }
+
+    MultipleTauCorrelator correlator(numFunctions, dimension, blockLength, 2);
+    for (int t = 0; t < numSamples; t++)
+    {
+        correlator.addSample(constArrayRefFromArray(data.data() + t * width, width));
+    }
+
+    const std::vector<int64_t> lags     = correlator.lags();
+    const std::vector<real>    corr     = correlator.correlations(false);
+    const std::vector<real>    averaged = correlator.correlations(true);
+    ASSERT_EQ(lags.size() * numFunctions, corr.size());
+    ASSERT_EQ(lags.size(), averaged.size());
+
+    test::FloatingPointTolerance tolerance(test::relativeToleranceAsFloatingPoint(1.0, 1e-5));
+    for (int lag = 0; lag < blockLength; lag++)
+    {
+        ASSERT_EQ(lag, lags[lag]);
+        double sum = 0;
+        for (int f = 0; f < numFunctions; f++)
+        {
+            double direct = 0;
+            for (int t = lag; t < numSamples; t++)
+            {
+                for (int d = 0; d < dimension; d++)
+                {
+                    direct += data[t * width + f * dimension + d]
+                              * data[(t - lag) * width + f * dimension + d];
+                }
+            }
+            direct /= numSamples - lag;
+            EXPECT_REAL_EQ_TOL(direct, corr[lag * numFunctions + f], tolerance);
+            sum += direct;
+        }
+        EXPECT_REAL_EQ_TOL(sum / numFunctions, averaged[lag], tolerance);
+    }
+}
+
+TEST(MultipleTauCorrelatorTest, ConstantSignalGivesConstantCorrelation)
+{
+    MultipleTauCorrelator   correlator(2, 1, 4, 2);
+    const std::vector<real> sample = { 2, -3 };
+    for (int i = 0; i < 100; i++)
+    {
+        correlator.addSample(sample);
+    }
+
+    const std::vector<real> corr = correlator.correlations(false);
+    for (size_t i = 0; i < corr.size(); i += 2)
+    {
+        EXPECT_REAL_EQ(4, corr[i]);
+        EXPECT_REAL_EQ(9, corr[i + 1]);
+    }
+}
+
+TEST(MultipleTauCorrelatorTest, ResetDiscardsSamples)
+{
+    MultipleTauCorrelator   correlator(1, 2);
+    const std::vector<real> sample = { 1, 2 };
+    for (int i = 0; i < 40; i++)
+    {
+        correlator.addSample(sample);
+    }
+    correlator.reset();
+    EXPECT_EQ(0, correlator.numSamples());
+    EXPECT_TRUE(correlator.lags().empty());
+
+    correlator.addSample(sample);
+    const std::vector<real> corr = correlator.correlations(true);
+    ASSERT_EQ(1U, corr.size());
+    EXPECT_REAL_EQ(5, corr[0]);
+}
+
+} // namespace
+} // namespace gmx
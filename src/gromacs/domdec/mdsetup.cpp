@@ -100,6 +100,11 @@ void mdAlgorithmsSetupAtomData(const t_commrec*        cr,
         force->resizeWithPadding(numTotalAtoms);
     }
 
+    if (fr->useMts)
+    {
+        fr->forceMtsCombined.resizeWithPadding(numTotalAtoms);
+    }
+
     atoms2md(&top_global, ir, numAtomIndex,
              usingDomDec ? cr->dd->globalAtomIndices : std::vector<int>(), numHomeAtoms, mdAtoms);
 
@@ -129,7 +134,10 @@ void mdAlgorithmsSetupAtomData(const t_commrec*        cr,
         make_local_shells(cr, mdatoms, shellfc);
     }
 
-    fr->listedForces->setup(top->idef, fr->natoms_force, fr->gpuBonded != nullptr);
+    for (auto& listedForces : fr->listedForces)
+    {
+        listedForces.setup(top->idef, fr->natoms_force, fr->gpuBonded != nullptr);
+    }
 
     if (EEL_PME(fr->ic->eeltype) && (cr->duty & DUTY_PME))
     {
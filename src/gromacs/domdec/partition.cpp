@@ -3117,7 +3117,7 @@ void dd_partition_system(FILE*                        fplog,
 
     state_change_natoms(state_local, state_local->natoms);
 
-    if (fr->forceHelperBuffers->haveDirectVirialContributions())
+    if (fr->forceHelperBuffers[0].haveDirectVirialContributions())
     {
         if (vsite && vsite->numInterUpdategroupVirtualSites())
         {
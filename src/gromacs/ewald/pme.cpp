@@ -200,6 +200,10 @@ bool pme_gpu_supports_input(const t_inputrec& ir, std::string* error)
                 "Cannot compute PME interactions on a GPU, because PME GPU requires a dynamical "
                 "integrator (md, sd, etc).");
     }
+    if (ir.useMts)
+    {
+        errorReasons.emplace_back("multiple time stepping");
+    }
     return addMessageIfNotSupported(errorReasons, error);
 }
 
@@ -0,0 +1,425 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2021, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Implements reading and writing of binary columnar time series files.
+ *
+ * \ingroup module_fileio
+ */
+#include "gmxpre.h"
+
+#include "columnardata.h"
+
+#include <cstring>
+
+#include <algorithm>
+
+#include "gromacs/utility/arrayref.h"
+#include "gromacs/utility/exceptions.h"
+#include "gromacs/utility/futil.h"
+#include "gromacs/utility/gmxassert.h"
+#include "gromacs/utility/inmemoryserializer.h"
+
+namespace gmx
+{
+
+namespace
+{
+
+//! Identifies a columnar data file, including the terminating null character
+const char c_columnarDataMagic[] = "GMXCOLS";
+//! The size of the magic identifier in bytes
+constexpr int c_columnarDataMagicSize = sizeof(c_columnarDataMagic);
+//! The version of the file format
+constexpr int32_t c_columnarDataVersion = 1;
+/*! \brief The number of values buffered before a chunk is written
+ *
+ * Large enough to make the per-chunk overhead negligible and small
+ * enough that unwritten output does not need much memory.
+ */
+constexpr int c_columnarDataValuesPerChunk = 1 << 16;
+
+//! The file format is little endian, independently of the host
+constexpr EndianSwapBehavior c_columnarDataEndianSwap = EndianSwapBehavior::SwapIfHostIsBigEndian;
+
+//! Return the number of bytes in a chunk with \p numRows rows of \p numColumns values
+gmx_off_t chunkDataSize(int numRows, int numColumns)
+{
+    return static_cast<gmx_off_t>(numRows) * (sizeof(double) + (numColumns - 1) * sizeof(float));
+}
+
+/*! \brief Write \p buffer to \p fp
+ *
+ * \throws FileIOError when not all data could be written
+ */
+void writeBuffer(FILE* fp, const std::vector<char>& buffer)
+{
+    if (std::fwrite(buffer.data(), sizeof(char), buffer.size(), fp) != buffer.size())
+    {
+        GMX_THROW(FileIOError("Could not write columnar data - maybe you are out of disk space?"));
+    }
+}
+
+/*! \brief Read \p numBytes from \p fp
+ *
+ * \returns the data read, which is shorter than \p numBytes at the end of the file
+ */
+std::vector<char> readBuffer(FILE* fp, size_t numBytes)
+{
+    std::vector<char> buffer(numBytes);
+    buffer.resize(std::fread(buffer.data(), sizeof(char), numBytes, fp));
+    return buffer;
+}
+
+} // namespace
+
+/********************************************************************
+ * ColumnarDataWriter::Impl
+ */
+
+/*! \internal \brief
+ * Private implementation class for ColumnarDataWriter.
+ */
+class ColumnarDataWriter::Impl
+{
+public:
+    Impl(FILE* fp, ArrayRef<const std::string> columnNames, bool appending);
+
+    void addRow(ArrayRef<const double> values);
+    void flush();
+
+    //! The file to write to, owned by the caller
+    FILE* fp_;
+    //! The number of columns, including time
+    int numColumns_;
+    //! The number of rows in a full chunk
+    int rowsPerChunk_;
+    //! The buffered times
+    std::vector<double> times_;
+    //! The buffered values of the other columns, row by row
+    std::vector<float> values_;
+};
+
+ColumnarDataWriter::Impl::Impl(FILE* fp, ArrayRef<const std::string> columnNames, bool appending) :
+    fp_(fp),
+    numColumns_(columnNames.ssize()),
+    rowsPerChunk_(std::max(1, c_columnarDataValuesPerChunk / numColumns_))
+{
+    GMX_RELEASE_ASSERT(numColumns_ > 0, "Need at least a time column");
+
+    if (!appending)
+    {
+        InMemorySerializer serializer(c_columnarDataEndianSwap);
+        char               magic[c_columnarDataMagicSize];
+        std::memcpy(magic, c_columnarDataMagic, c_columnarDataMagicSize);
+        serializer.doOpaque(magic, c_columnarDataMagicSize);
+        int32_t version    = c_columnarDataVersion;
+        int32_t numColumns = numColumns_;
+        serializer.doInt32(&version);
+        serializer.doInt32(&numColumns);
+        for (const std::string& name : columnNames)
+        {
+            std::string nameCopy   = name;
+            int32_t     nameLength = nameCopy.size();
+            serializer.doInt32(&nameLength);
+            serializer.doOpaque(&nameCopy[0], nameLength);
+        }
+        writeBuffer(fp_, serializer.finishAndGetBuffer());
+    }
+}
+
+void ColumnarDataWriter::Impl::addRow(ArrayRef<const double> values)
+{
+    GMX_RELEASE_ASSERT(values.ssize() == numColumns_,
+                       "Need exactly one value for each column of columnar data");
+
+    times_.push_back(values[0]);
+    for (int c = 1; c < numColumns_; c++)
+    {
+        values_.push_back(values[c]);
+    }
+    if (static_cast<int>(times_.size()) == rowsPerChunk_)
+    {
+        flush();
+    }
+}
+
+void ColumnarDataWriter::Impl::flush()
+{
+    if (times_.empty())
+    {
+        return;
+    }
+
+    const int          numRows = times_.size();
+    InMemorySerializer serializer(c_columnarDataEndianSwap);
+    int32_t            numRowsInChunk = numRows;
+    serializer.doInt32(&numRowsInChunk);
+    for (double& time : times_)
+    {
+        serializer.doDouble(&time);
+    }
+    /* Transpose the buffered rows, so each column is contiguous */
+    for (int c = 0; c < numColumns_ - 1; c++)
+    {
+        for (int r = 0; r < numRows; r++)
+        {
+            serializer.doFloat(&values_[r * (numColumns_ - 1) + c]);
+        }
+    }
+    writeBuffer(fp_, serializer.finishAndGetBuffer());
+
+    times_.clear();
+    values_.clear();
+}
+
+/********************************************************************
+ * ColumnarDataWriter
+ */
+
+ColumnarDataWriter::ColumnarDataWriter(FILE*                       fp,
+                                       ArrayRef<const std::string> columnNames,
+                                       bool                        appending) :
+    impl_(new Impl(fp, columnNames, appending))
+{
+}
+
+ColumnarDataWriter::~ColumnarDataWriter() {}
+
+void ColumnarDataWriter::addRow(ArrayRef<const double> values)
+{
+    impl_->addRow(values);
+}
+
+void ColumnarDataWriter::flush()
+{
+    impl_->flush();
+}
+
+/********************************************************************
+ * ColumnarDataReader::Impl
+ */
+
+/*! \internal \brief
+ * Private implementation class for ColumnarDataReader.
+ */
+class ColumnarDataReader::Impl
+{
+public:
+    explicit Impl(const std::string& fileName);
+    ~Impl();
+
+    std::vector<double> readColumn(int column) const;
+
+    //! Describes where the data of a chunk is located
+    struct Chunk
+    {
+        //! The file offset of the first value of the chunk
+        gmx_off_t dataOffset;
+        //! The number of rows in the chunk
+        int numRows;
+    };
+
+    //! The name of the file
+    std::string fileName_;
+    //! The open file
+    FILE* fp_;
+    //! The column names
+    std::vector<std::string> columnNames_;
+    //! The complete chunks in the file
+    std::vector<Chunk> chunks_;
+    //! The total number of rows in the complete chunks
+    int numRows_;
+};
+
+ColumnarDataReader::Impl::Impl(const std::string& fileName) :
+    fileName_(fileName),
+    fp_(nullptr),
+    numRows_(0)
+{
+    if (!gmx_fexist(fileName))
+    {
+        GMX_THROW(FileIOError("Error while reading '" + fileName + "' - file not found."));
+    }
+    fp_ = gmx_ffopen(fileName, "rb");
+
+    const std::string notColumnarData =
+            "Error while reading '" + fileName + "' - not a columnar data file.";
+    std::vector<char> buffer = readBuffer(fp_, c_columnarDataMagicSize + 2 * sizeof(int32_t));
+    if (buffer.size() != c_columnarDataMagicSize + 2 * sizeof(int32_t))
+    {
+        GMX_THROW(FileIOError(notColumnarData));
+    }
+    InMemoryDeserializer deserializer(buffer, false, c_columnarDataEndianSwap);
+    char                 magic[c_columnarDataMagicSize];
+    int32_t              version, numColumns;
+    deserializer.doOpaque(magic, c_columnarDataMagicSize);
+    deserializer.doInt32(&version);
+    deserializer.doInt32(&numColumns);
+    if (std::memcmp(magic, c_columnarDataMagic, c_columnarDataMagicSize) != 0 || numColumns < 1)
+    {
+        GMX_THROW(FileIOError(notColumnarData));
+    }
+    if (version != c_columnarDataVersion)
+    {
+        GMX_THROW(FileIOError("Error while reading '" + fileName
+                              + "' - unsupported columnar data version "
+                              + std::to_string(version) + "."));
+    }
+    for (int c = 0; c < numColumns; c++)
+    {
+        std::vector<char> lengthBuffer = readBuffer(fp_, sizeof(int32_t));
+        if (lengthBuffer.size() != sizeof(int32_t))
+        {
+            GMX_THROW(FileIOError(notColumnarData));
+        }
+        InMemoryDeserializer lengthDeserializer(lengthBuffer, false, c_columnarDataEndianSwap);
+        int32_t              nameLength;
+        lengthDeserializer.doInt32(&nameLength);
+        std::vector<char> name = readBuffer(fp_, std::max(nameLength, 0));
+        if (nameLength < 0 || name.size() != static_cast<size_t>(nameLength))
+        {
+            GMX_THROW(FileIOError(notColumnarData));
+        }
+        columnNames_.emplace_back(name.begin(), name.end());
+    }
+
+    /* Index the chunks by only reading their row counts */
+    gmx_off_t offset = gmx_ftell(fp_);
+    gmx_fseek(fp_, 0, SEEK_END);
+    const gmx_off_t fileSize = gmx_ftell(fp_);
+    while (offset + static_cast<gmx_off_t>(sizeof(int32_t)) <= fileSize)
+    {
+        gmx_fseek(fp_, offset, SEEK_SET);
+        std::vector<char>    rowsBuffer = readBuffer(fp_, sizeof(int32_t));
+        InMemoryDeserializer rowsDeserializer(rowsBuffer, false, c_columnarDataEndianSwap);
+        int32_t              numRows;
+        rowsDeserializer.doInt32(&numRows);
+        if (numRows <= 0)
+        {
+            GMX_THROW(FileIOError("Error while reading '" + fileName
+                                  + "' - corrupted columnar data chunk."));
+        }
+        const gmx_off_t dataOffset = offset + sizeof(int32_t);
+        if (dataOffset + chunkDataSize(numRows, numColumns) > fileSize)
+        {
+            /* The last chunk was not written completely */
+            break;
+        }
+        chunks_.push_back({ dataOffset, numRows });
+        numRows_ += numRows;
+        offset = dataOffset + chunkDataSize(numRows, numColumns);
+    }
+}
+
+ColumnarDataReader::Impl::~Impl()
+{
+    gmx_ffclose(fp_);
+}
+
+std::vector<double> ColumnarDataReader::Impl::readColumn(int column) const
+{
+    GMX_RELEASE_ASSERT(column >= 0 && column < gmx::ssize(columnNames_),
+                       "Column index out of range for columnar data");
+
+    std::vector<double> values;
+    values.reserve(numRows_);
+    for (const Chunk& chunk : chunks_)
+    {
+        /* The time column comes first, in double precision, followed by the
+         * other columns in single precision, so the columns before this one
+         * take as much space as a chunk with column columns */
+        const size_t    valueSize = (column == 0) ? sizeof(double) : sizeof(float);
+        const gmx_off_t offset =
+                chunk.dataOffset + ((column == 0) ? 0 : chunkDataSize(chunk.numRows, column));
+        gmx_fseek(fp_, offset, SEEK_SET);
+        std::vector<char> buffer = readBuffer(fp_, chunk.numRows * valueSize);
+        if (buffer.size() != chunk.numRows * valueSize)
+        {
+            GMX_THROW(FileIOError("Error while reading '" + fileName_
+                                  + "' - file ended unexpectedly."));
+        }
+        InMemoryDeserializer deserializer(buffer, false, c_columnarDataEndianSwap);
+        for (int r = 0; r < chunk.numRows; r++)
+        {
+            if (column == 0)
+            {
+                double value;
+                deserializer.doDouble(&value);
+                values.push_back(value);
+            }
+            else
+            {
+                float value;
+                deserializer.doFloat(&value);
+                values.push_back(value);
+            }
+        }
+    }
+
+    return values;
+}
+
+/********************************************************************
+ * ColumnarDataReader
+ */
+
+ColumnarDataReader::ColumnarDataReader(const std::string& fileName) : impl_(new Impl(fileName))
+{
+}
+
+ColumnarDataReader::~ColumnarDataReader() {}
+
+const std::vector<std::string>& ColumnarDataReader::columnNames() const
+{
+    return impl_->columnNames_;
+}
+
+int ColumnarDataReader::numColumns() const
+{
+    return impl_->columnNames_.size();
+}
+
+int ColumnarDataReader::numRows() const
+{
+    return impl_->numRows_;
+}
+
+std::vector<double> ColumnarDataReader::readColumn(int column) const
+{
+    return impl_->readColumn(column);
+}
+
+} // namespace gmx
@@ -0,0 +1,142 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2021, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \libinternal \file
+ * \brief
+ * Declares reading and writing of binary columnar time series files.
+ *
+ * A columnar data file stores time series, such as pull coordinate
+ * values, as an alternative to xvg files. The file starts with a header
+ * with the column names, followed by chunks of rows. Within a chunk the
+ * values are stored column by column, the first column (time) in double
+ * precision and the other columns in single precision, all little endian.
+ * A reader can thus locate and read a single column without parsing
+ * the other columns. Chunks are appended independently, which allows
+ * appending to a file upon continuation from a checkpoint.
+ *
+ * \inlibraryapi
+ * \ingroup module_fileio
+ */
+#ifndef GMX_FILEIO_COLUMNARDATA_H
+#define GMX_FILEIO_COLUMNARDATA_H
+
+#include <cstdio>
+
+#include <string>
+#include <vector>
+
+#include "gromacs/utility/classhelpers.h"
+
+namespace gmx
+{
+template<typename>
+class ArrayRef;
+
+/*! \libinternal \brief Writes rows of values to a columnar data file.
+ *
+ * Rows are buffered and written as a chunk when the buffer is full or
+ * when flush() is called. The file is opened and closed by the caller,
+ * which should call flush() before the file positions are used, e.g.
+ * for checkpointing, and before closing the file.
+ */
+class ColumnarDataWriter
+{
+public:
+    /*! \brief Prepare writing rows with \p columnNames to \p fp.
+     *
+     * Unless \p appending, the header is written to \p fp.
+     *
+     * \throws FileIOError when writing fails
+     */
+    ColumnarDataWriter(FILE* fp, ArrayRef<const std::string> columnNames, bool appending);
+
+    ~ColumnarDataWriter();
+
+    /*! \brief Add a row with one value per column
+     *
+     * \throws FileIOError when writing a full chunk fails
+     */
+    void addRow(ArrayRef<const double> values);
+
+    /*! \brief Write the buffered rows to the file
+     *
+     * \throws FileIOError when writing fails
+     */
+    void flush();
+
+private:
+    class Impl;
+    PrivateImplPointer<Impl> impl_;
+};
+
+/*! \libinternal \brief Reads columns from a columnar data file.
+ *
+ * Upon construction only the header and the chunk sizes are read,
+ * columns are read on request. A chunk that was not completely written,
+ * e.g. because a simulation was killed, is ignored.
+ */
+class ColumnarDataReader
+{
+public:
+    /*! \brief Open \p fileName and index its chunks
+     *
+     * \throws FileIOError if the file cannot be opened or is not a columnar data file
+     */
+    explicit ColumnarDataReader(const std::string& fileName);
+
+    ~ColumnarDataReader();
+
+    //! Return the names of the columns
+    const std::vector<std::string>& columnNames() const;
+    //! Return the number of columns
+    int numColumns() const;
+    //! Return the number of complete rows in the file
+    int numRows() const;
+
+    /*! \brief Return all values in \p column
+     *
+     * Only the data of this column is read from the file.
+     *
+     * \throws FileIOError when reading fails
+     */
+    std::vector<double> readColumn(int column) const;
+
+private:
+    class Impl;
+    PrivateImplPointer<Impl> impl_;
+};
+
+} // namespace gmx
+
+#endif
@@ -0,0 +1,251 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2021, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Implements gmx::EnergyFrameIndex.
+ *
+ * \ingroup module_fileio
+ */
+#include "gmxpre.h"
+
+#include "enxindex.h"
+
+#include <cstdio>
+
+#include <algorithm>
+
+#include "gromacs/fileio/enxio.h"
+#include "gromacs/fileio/gmxfio.h"
+#include "gromacs/utility/exceptions.h"
+#include "gromacs/utility/futil.h"
+#include "gromacs/utility/gmxassert.h"
+#include "gromacs/utility/inmemoryserializer.h"
+
+namespace gmx
+{
+
+namespace
+{
+
+//! Magic number identifying an energy frame index file ("EDRI").
+const int32_t c_energyIndexMagic = 0x45445249;
+//! Version of the index file format.
+const int32_t c_energyIndexVersion = 1;
+//! The index files are stored big-endian, like the energy files themselves.
+const EndianSwapBehavior c_energyIndexEndianSwap = EndianSwapBehavior::SwapIfHostIsLittleEndian;
+
+//! Returns the size of the file open in \p fio, leaving the position at the end.
+int64_t openFileSize(t_fileio* fio)
+{
+    if (gmx_fseek(gmx_fio_getfp(fio), 0, SEEK_END) != 0)
+    {
+        return -1;
+    }
+    return gmx_fio_ftell(fio);
+}
+
+//! Returns whether the frame header at \p entry.offset matches \p entry.
+bool frameHeaderMatches(ener_file* ef, const EnergyFrameIndexEntry& entry)
+{
+    double  time;
+    int64_t step;
+    return gmx_fio_seek(enx_file_pointer(ef), entry.offset) == 0 && enx_skip_frame(ef, &time, &step)
+           && time == entry.time && step == entry.step;
+}
+
+//! Serializes one index entry.
+void serializeEntry(ISerializer* serializer, EnergyFrameIndexEntry* entry)
+{
+    serializer->doInt64(&entry->offset);
+    serializer->doInt64(&entry->step);
+    serializer->doDouble(&entry->time);
+}
+
+} // namespace
+
+EnergyFrameIndex EnergyFrameIndex::build(ener_file* ef)
+{
+    t_fileio*        fio   = enx_file_pointer(ef);
+    const gmx_off_t  start = gmx_fio_ftell(fio);
+    EnergyFrameIndex index;
+    index.fileSize_ = openFileSize(fio);
+    gmx_fio_seek(fio, start);
+
+    while (true)
+    {
+        EnergyFrameIndexEntry entry;
+        entry.offset = gmx_fio_ftell(fio);
+        if (!enx_skip_frame(ef, &entry.time, &entry.step) || gmx_fio_ftell(fio) > index.fileSize_)
+        {
+            break;
+        }
+        index.frames_.push_back(entry);
+    }
+    return index;
+}
+
+EnergyFrameIndex EnergyFrameIndex::read(const std::string& indexFileName)
+{
+    FILE* fp = std::fopen(indexFileName.c_str(), "rb");
+    if (fp == nullptr)
+    {
+        GMX_THROW(FileIOError("Cannot open energy frame index '" + indexFileName + "'."));
+    }
+    std::vector<char> buffer;
+    if (gmx_fseek(fp, 0, SEEK_END) == 0)
+    {
+        const int64_t size = gmx_ftell(fp);
+        if (size > 0 && gmx_fseek(fp, 0, SEEK_SET) == 0)
+        {
+            buffer.resize(size);
+            if (std::fread(buffer.data(), 1, buffer.size(), fp) != buffer.size())
+            {
+                buffer.clear();
+            }
+        }
+    }
+    std::fclose(fp);
+
+    const std::string error = "'" + indexFileName + "' is not a valid energy frame index.";
+    const size_t      headerSize = 2 * sizeof(int32_t) + 2 * sizeof(int64_t);
+    const size_t      entrySize  = 2 * sizeof(int64_t) + sizeof(double);
+    if (buffer.size() < headerSize)
+    {
+        GMX_THROW(FileIOError(error));
+    }
+    InMemoryDeserializer serializer(buffer, false, c_energyIndexEndianSwap);
+    int32_t              magic;
+    int32_t              version;
+    int64_t              frameCount;
+    EnergyFrameIndex     index;
+    serializer.doInt32(&magic);
+    serializer.doInt32(&version);
+    serializer.doInt64(&index.fileSize_);
+    serializer.doInt64(&frameCount);
+    if (magic != c_energyIndexMagic || version != c_energyIndexVersion || frameCount < 0
+        || buffer.size() != headerSize + frameCount * entrySize)
+    {
+        GMX_THROW(FileIOError(error));
+    }
+    index.frames_.resize(frameCount);
+    for (EnergyFrameIndexEntry& entry : index.frames_)
+    {
+        serializeEntry(&serializer, &entry);
+    }
+    return index;
+}
+
+void EnergyFrameIndex::write(const std::string& indexFileName) const
+{
+    GMX_RELEASE_ASSERT(fileSize_ >= 0, "Only complete indices can be written");
+    InMemorySerializer serializer(c_energyIndexEndianSwap);
+    int32_t            magic      = c_energyIndexMagic;
+    int32_t            version    = c_energyIndexVersion;
+    int64_t            fileSize   = fileSize_;
+    int64_t            frameCount = frames_.size();
+    serializer.doInt32(&magic);
+    serializer.doInt32(&version);
+    serializer.doInt64(&fileSize);
+    serializer.doInt64(&frameCount);
+    for (EnergyFrameIndexEntry entry : frames_)
+    {
+        serializeEntry(&serializer, &entry);
+    }
+    const std::vector<char> buffer = serializer.finishAndGetBuffer();
+
+    // The index is a cache of the energy file contents, so an old index
+    // is overwritten instead of backed up.
+    FILE* fp = std::fopen(indexFileName.c_str(), "wb");
+    if (fp == nullptr)
+    {
+        GMX_THROW(FileIOError("Cannot open '" + indexFileName + "' for writing."));
+    }
+    const bool bOK = (std::fwrite(buffer.data(), 1, buffer.size(), fp) == buffer.size());
+    if (std::fclose(fp) != 0 || !bOK)
+    {
+        GMX_THROW(FileIOError("Error while writing energy frame index '" + indexFileName + "'."));
+    }
+}
+
+bool EnergyFrameIndex::isValidFor(ener_file* ef) const
+{
+    t_fileio* fio   = enx_file_pointer(ef);
+    bool      valid = (fileSize_ >= 0 && openFileSize(fio) == fileSize_);
+    if (valid && !frames_.empty())
+    {
+        valid = frameHeaderMatches(ef, frames_.front()) && frameHeaderMatches(ef, frames_.back())
+                && gmx_fio_ftell(fio) == fileSize_;
+    }
+    return valid;
+}
+
+int EnergyFrameIndex::findFrameAtTime(real time, int firstFrame) const
+{
+    const auto begin = frames_.begin() + std::min(std::max(firstFrame, 0), frameCount());
+    const auto frame = std::find_if(begin, frames_.end(), [time](const EnergyFrameIndexEntry& entry) {
+        return static_cast<real>(entry.time) >= time;
+    });
+    return frame == frames_.end() ? -1 : static_cast<int>(frame - frames_.begin());
+}
+
+std::string energyFrameIndexFileName(const std::string& edrFileName)
+{
+    return edrFileName + ".idx";
+}
+
+std::unique_ptr<EnergyFrameIndex> loadEnergyFrameIndex(const std::string& edrFileName, ener_file* ef)
+{
+    const std::string indexFileName = energyFrameIndexFileName(edrFileName);
+    if (!gmx_fexist(indexFileName))
+    {
+        return nullptr;
+    }
+    std::unique_ptr<EnergyFrameIndex> index;
+    try
+    {
+        index = std::make_unique<EnergyFrameIndex>(EnergyFrameIndex::read(indexFileName));
+    }
+    catch (const FileIOError&)
+    {
+        return nullptr;
+    }
+    if (!index->isValidFor(ef))
+    {
+        return nullptr;
+    }
+    return index;
+}
+
+} // namespace gmx
@@ -0,0 +1,159 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2021, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \libinternal \file
+ * \brief
+ * Declares gmx::EnergyFrameIndex for random access to energy file frames.
+ *
+ * The index maps energy frames to byte offsets in an edr file, so that
+ * tools reading a time range, e.g., gmx energy -b, can jump directly to
+ * the first requested frame. It is stored in a sidecar file next to the
+ * energy file and is rebuilt by enx_seek_time() when the energy file
+ * has changed.
+ *
+ * \inlibraryapi
+ * \ingroup module_fileio
+ */
+#ifndef GMX_FILEIO_ENXINDEX_H
+#define GMX_FILEIO_ENXINDEX_H
+
+#include <cstdint>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "gromacs/utility/arrayref.h"
+#include "gromacs/utility/real.h"
+
+struct ener_file;
+
+namespace gmx
+{
+
+//! Location and header information for one frame of an energy file.
+struct EnergyFrameIndexEntry
+{
+    //! Byte offset of the frame header in the file.
+    int64_t offset;
+    //! MD step stored in the frame header.
+    int64_t step;
+    //! Time stored in the frame header.
+    double time;
+};
+
+/*! \libinternal \brief
+ * Frame-offset index of an energy file.
+ *
+ * An index is built by reading only the frame headers of an energy
+ * file, skipping the energies and blocks by their size. Before an
+ * index read from a sidecar file is used, isValidFor() checks that it
+ * still describes the energy file.
+ *
+ * \inlibraryapi
+ * \ingroup module_fileio
+ */
+class EnergyFrameIndex
+{
+public:
+    /*! \brief
+     * Builds an index of the frames of \p ef from its current position.
+     *
+     * \p ef should be positioned at the first frame, i.e., directly
+     * after do_enxnms(). The file is left at its end. An incomplete
+     * last frame is not included in the index.
+     */
+    static EnergyFrameIndex build(ener_file* ef);
+    /*! \brief
+     * Reads an index from a sidecar file written with write().
+     *
+     * \throws FileIOError if the file cannot be read or is not a valid index.
+     */
+    static EnergyFrameIndex read(const std::string& indexFileName);
+
+    /*! \brief
+     * Writes the index to \p indexFileName.
+     *
+     * \throws FileIOError if the file cannot be written.
+     */
+    void write(const std::string& indexFileName) const;
+
+    /*! \brief
+     * Returns whether the index describes the current contents of \p ef.
+     *
+     * The size of the file must match the size recorded in the index,
+     * and the headers of the first and last indexed frames must be found
+     * at their recorded offsets. Changes the file position of \p ef.
+     */
+    bool isValidFor(ener_file* ef) const;
+
+    //! Returns the number of indexed frames.
+    int frameCount() const { return static_cast<int>(frames_.size()); }
+    //! Returns the indexed frames.
+    ArrayRef<const EnergyFrameIndexEntry> frames() const { return frames_; }
+    //! Returns the size of the indexed file.
+    int64_t fileSize() const { return fileSize_; }
+    /*! \brief
+     * Returns the first frame at or after \p firstFrame with time at least \p time.
+     *
+     * The times are compared in the precision of real, as check_times()
+     * does. Returns -1 if there is no such frame.
+     */
+    int findFrameAtTime(real time, int firstFrame = 0) const;
+
+private:
+    std::vector<EnergyFrameIndexEntry> frames_;
+    int64_t                            fileSize_ = -1;
+};
+
+/*! \brief
+ * Returns the name of the sidecar index file for \p edrFileName.
+ *
+ * The sidecar file is the energy file name with ".idx" appended,
+ * e.g., ener.edr.idx for ener.edr.
+ */
+std::string energyFrameIndexFileName(const std::string& edrFileName);
+
+/*! \brief
+ * Loads the sidecar index of \p edrFileName if it exists and is valid for \p ef.
+ *
+ * \p ef should be open for reading \p edrFileName; its file position
+ * is changed. Returns nullptr if there is no sidecar file, or if it is
+ * unreadable or does not describe the current energy file.
+ */
+std::unique_ptr<EnergyFrameIndex> loadEnergyFrameIndex(const std::string& edrFileName, ener_file* ef);
+
+} // namespace gmx
+
+#endif
@@ -43,7 +43,9 @@
 #include <cstring>
 
 #include <algorithm>
+#include <memory>
 
+#include "gromacs/fileio/enxindex.h"
 #include "gromacs/fileio/gmxfio.h"
 #include "gromacs/fileio/gmxfio_xdr.h"
 #include "gromacs/fileio/xdrf.h"
@@ -56,6 +58,7 @@
 #include "gromacs/topology/topology.h"
 #include "gromacs/trajectory/energyframe.h"
 #include "gromacs/utility/compare.h"
+#include "gromacs/utility/exceptions.h"
 #include "gromacs/utility/fatalerror.h"
 #include "gromacs/utility/futil.h"
 #include "gromacs/utility/gmxassert.h"
@@ -90,12 +93,22 @@ typedef struct
 
 struct ener_file
 {
-    ener_old_t eo;
-    t_fileio*  fio;
-    int        framenr;
-    real       frametime;
+    ener_old_t     eo;
+    t_fileio*      fio;
+    int            framenr;
+    real           frametime;
+    gmx_off_t      firstFrameOffset; /* Offset of the first frame, after the names  */
+    gmx_off_t      fileSize;         /* Size of a file opened for reading           */
+    gmx_bool*      bReadTerm;        /* Energy terms to read, all when NULL         */
+    int            nReadTerm;        /* Number of entries in bReadTerm              */
+    gmx_bool*      bReadBlock;       /* Block ids to read, all when NULL            */
+    unsigned char* buffer;           /* Raw data of selectively read frames         */
+    int64_t        buffer_alloc;     /* Allocated size of buffer                    */
 };
 
+/* Skipped data larger than this is seeked over instead of read */
+static const int64_t c_enxSeekThreshold = 65536;
+
 static void enxsubblock_init(t_enxsubblock* sb)
 {
     sb->nr = 0;
@@ -435,6 +448,7 @@ void do_enxnms(ener_file_t ef, int* nre, gmx_enxnm_t** nms)
     }
 
     edr_strings(xdr, bRead, file_version, *nre, nms);
+    ef->firstFrameOffset = gmx_fio_ftell(ef->fio);
 }
 
 static gmx_bool do_eheader(ener_file_t ef,
@@ -763,6 +777,9 @@ void close_enx(ener_file_t ef)
                 "Cannot close energy file; it might be corrupt, or maybe you are out of disk "
                 "space?");
     }
+    sfree(ef->bReadTerm);
+    sfree(ef->bReadBlock);
+    sfree(ef->buffer);
 }
 
 void done_ener_file(ener_file_t ef)
@@ -861,6 +878,10 @@ ener_file_t open_enx(const char* fn, const char* mode)
         }
         free_enxframe(fr);
         sfree(fr);
+        if (gmx_fseek(gmx_fio_getfp(ef->fio), 0, SEEK_END) == 0)
+        {
+            ef->fileSize = gmx_fio_ftell(ef->fio);
+        }
         gmx_fio_rewind(ef->fio);
     }
     else
@@ -950,6 +971,115 @@ static void convert_full_sums(ener_old_t* ener_old, t_enxframe* fr)
     ener_old->step_prev = fr->step;
 }
 
+/* Returns the size in bytes of the data of sub in the file,
+ * or -1 when the size depends on the data
+ */
+static int64_t enx_subblock_size(const t_enxsubblock* sub)
+{
+    switch (sub->type)
+    {
+        case xdr_datatype_float: return 4 * static_cast<int64_t>(sub->nr);
+        case xdr_datatype_double: return 8 * static_cast<int64_t>(sub->nr);
+        case xdr_datatype_int: return 4 * static_cast<int64_t>(sub->nr);
+        case xdr_datatype_int64: return 8 * static_cast<int64_t>(sub->nr);
+        /* XDR stores each char in 4 bytes */
+        case xdr_datatype_char: return 4 * static_cast<int64_t>(sub->nr);
+        default: return -1;
+    }
+}
+
+/* Reads nbytes of raw data into the buffer of ef, returns NULL on failure */
+static const unsigned char* enx_read_raw(ener_file_t ef, int64_t nbytes)
+{
+    if (nbytes > ef->buffer_alloc)
+    {
+        srenew(ef->buffer, nbytes);
+        ef->buffer_alloc = nbytes;
+    }
+    if (nbytes > 0 && fread(ef->buffer, 1, nbytes, gmx_fio_getfp(ef->fio)) != static_cast<size_t>(nbytes))
+    {
+        return nullptr;
+    }
+    return ef->buffer;
+}
+
+/* Skips nbytes of data without decoding them, returns FALSE when the file is too short */
+static gmx_bool enx_skip_raw(ener_file_t ef, int64_t nbytes)
+{
+    if (nbytes <= c_enxSeekThreshold)
+    {
+        return enx_read_raw(ef, nbytes) != nullptr;
+    }
+    gmx_off_t target = gmx_fio_ftell(ef->fio) + nbytes;
+    if (target > ef->fileSize && gmx_fseek(gmx_fio_getfp(ef->fio), 0, SEEK_END) == 0)
+    {
+        /* The file might have grown since it was opened */
+        ef->fileSize = gmx_fio_ftell(ef->fio);
+    }
+    return target <= ef->fileSize && gmx_fio_seek(ef->fio, target) == 0;
+}
+
+/* Returns the XDR floating-point value of realSize bytes at data */
+static real enx_xdr_real(const unsigned char* data, int realSize)
+{
+    uint64_t word = 0;
+    for (int i = 0; i < realSize; i++)
+    {
+        word = (word << 8) | data[i];
+    }
+    if (realSize == sizeof(float))
+    {
+        const uint32_t word32 = static_cast<uint32_t>(word);
+        float          value;
+        std::memcpy(&value, &word32, sizeof(value));
+        return value;
+    }
+    double value;
+    std::memcpy(&value, &word, sizeof(value));
+    return value;
+}
+
+/* Reads the energies of the selected terms from the raw frame data,
+ * the other terms are set to zero
+ */
+static gmx_bool enx_read_selected_terms(ener_file_t ef, t_enxframe* fr)
+{
+    const int            realSize = gmx_fio_is_double(ef->fio) ? sizeof(double) : sizeof(float);
+    const int            nvalue   = (fr->nsum > 0 ? 3 : 1);
+    const unsigned char* data = enx_read_raw(ef, static_cast<int64_t>(fr->nre) * nvalue * realSize);
+    if (data == nullptr)
+    {
+        return FALSE;
+    }
+    for (int i = 0; i < fr->nre; i++)
+    {
+        t_energy* ener = &fr->ener[i];
+        if (i < ef->nReadTerm && ef->bReadTerm[i])
+        {
+            const unsigned char* value = data + static_cast<int64_t>(i) * nvalue * realSize;
+            ener->e                    = enx_xdr_real(value, realSize);
+            if (nvalue == 3)
+            {
+                ener->eav  = enx_xdr_real(value + realSize, realSize);
+                ener->esum = enx_xdr_real(value + 2 * realSize, realSize);
+            }
+        }
+        else
+        {
+            ener->e    = 0;
+            ener->eav  = 0;
+            ener->esum = 0;
+        }
+    }
+    return TRUE;
+}
+
+/* Returns whether blocks with id should be read */
+static gmx_bool enx_block_selected(const ener_file* ef, int id)
+{
+    return ef->bReadBlock == nullptr || (id >= 0 && id < enxNR && ef->bReadBlock[id]);
+}
+
 gmx_bool do_enx(ener_file_t ef, t_enxframe* fr)
 {
     int      file_version = -1;
@@ -1021,35 +1151,42 @@ gmx_bool do_enx(ener_file_t ef, t_enxframe* fr)
         fr->e_alloc = fr->nre;
     }
 
-    for (i = 0; i < fr->nre; i++)
+    if (bRead && ef->bReadTerm != nullptr && file_version != 1)
     {
-        bOK = bOK && gmx_fio_do_real(ef->fio, fr->ener[i].e);
-
-        /* Do not store sums of length 1,
-         * since this does not add information.
-         */
-        if (file_version == 1 || (bRead && fr->nsum > 0) || fr->nsum > 1)
+        bOK = bOK && enx_read_selected_terms(ef, fr);
+    }
+    else
+    {
+        for (i = 0; i < fr->nre; i++)
         {
-            tmp1 = fr->ener[i].eav;
-            bOK  = bOK && gmx_fio_do_real(ef->fio, tmp1);
-            if (bRead)
-            {
-                fr->ener[i].eav = tmp1;
-            }
+            bOK = bOK && gmx_fio_do_real(ef->fio, fr->ener[i].e);
 
-            /* This is to save only in single precision (unless compiled in DP) */
-            tmp2 = fr->ener[i].esum;
-            bOK  = bOK && gmx_fio_do_real(ef->fio, tmp2);
-            if (bRead)
+            /* Do not store sums of length 1,
+             * since this does not add information.
+             */
+            if (file_version == 1 || (bRead && fr->nsum > 0) || fr->nsum > 1)
             {
-                fr->ener[i].esum = tmp2;
-            }
+                tmp1 = fr->ener[i].eav;
+                bOK  = bOK && gmx_fio_do_real(ef->fio, tmp1);
+                if (bRead)
+                {
+                    fr->ener[i].eav = tmp1;
+                }
 
-            if (file_version == 1)
-            {
-                /* Old, unused real */
-                rdum = 0;
-                bOK  = bOK && gmx_fio_do_real(ef->fio, rdum);
+                /* This is to save only in single precision (unless compiled in DP) */
+                tmp2 = fr->ener[i].esum;
+                bOK  = bOK && gmx_fio_do_real(ef->fio, tmp2);
+                if (bRead)
+                {
+                    fr->ener[i].esum = tmp2;
+                }
+
+                if (file_version == 1)
+                {
+                    /* Old, unused real */
+                    rdum = 0;
+                    bOK  = bOK && gmx_fio_do_real(ef->fio, rdum);
+                }
             }
         }
     }
@@ -1066,13 +1203,19 @@ gmx_bool do_enx(ener_file_t ef, t_enxframe* fr)
     for (b = 0; b < fr->nblock; b++)
     {
         /* now read the subblocks. */
-        int nsub = fr->block[b].nsub; /* shortcut */
-        int i;
+        int            nsub  = fr->block[b].nsub; /* shortcut */
+        const gmx_bool bSkip = bRead && !enx_block_selected(ef, fr->block[b].id);
+        int            i;
 
         for (i = 0; i < nsub; i++)
         {
             t_enxsubblock* sub = &(fr->block[b].sub[i]); /* shortcut */
 
+            if (bSkip && enx_subblock_size(sub) >= 0)
+            {
+                bOK = bOK && enx_skip_raw(ef, enx_subblock_size(sub));
+                continue;
+            }
             if (bRead)
             {
                 enxsubblock_alloc(sub);
@@ -1105,6 +1248,20 @@ gmx_bool do_enx(ener_file_t ef, t_enxframe* fr)
             bOK = bOK && bOK1;
         }
     }
+    if (bRead && ef->bReadBlock != nullptr)
+    {
+        /* Remove the blocks that were not selected, keeping their memory */
+        int nblock = 0;
+        for (b = 0; b < fr->nblock; b++)
+        {
+            if (enx_block_selected(ef, fr->block[b].id))
+            {
+                std::swap(fr->block[nblock], fr->block[b]);
+                nblock++;
+            }
+        }
+        fr->nblock = nblock;
+    }
 
     if (!bRead)
     {
@@ -1131,6 +1288,131 @@ gmx_bool do_enx(ener_file_t ef, t_enxframe* fr)
     return TRUE;
 }
 
+void enx_select_terms(ener_file_t ef, int nre, const gmx_bool* bTerm)
+{
+    sfree(ef->bReadTerm);
+    ef->bReadTerm = nullptr;
+    ef->nReadTerm = 0;
+    if (bTerm != nullptr)
+    {
+        snew(ef->bReadTerm, nre);
+        std::copy(bTerm, bTerm + nre, ef->bReadTerm);
+        ef->nReadTerm = nre;
+    }
+}
+
+void enx_select_blocks(ener_file_t ef, const gmx_bool* bBlock)
+{
+    sfree(ef->bReadBlock);
+    ef->bReadBlock = nullptr;
+    if (bBlock != nullptr)
+    {
+        snew(ef->bReadBlock, enxNR);
+        std::copy(bBlock, bBlock + enxNR, ef->bReadBlock);
+    }
+}
+
+gmx_bool enx_skip_frame(ener_file_t ef, double* t, int64_t* step)
+{
+    t_enxframe fr;
+    int        file_version = -1;
+    gmx_bool   bOK;
+
+    init_enxframe(&fr);
+    gmx_bool bRet = do_eheader(ef, &file_version, &fr, -1, nullptr, &bOK);
+    if (bRet)
+    {
+        const int realSize = gmx_fio_is_double(ef->fio) ? sizeof(double) : sizeof(float);
+        /* Old files store four values per term, see do_enx */
+        const int nvalue = (file_version == 1 ? 4 : (fr.nsum > 0 ? 3 : 1));
+        bRet             = enx_skip_raw(ef, static_cast<int64_t>(fr.nre) * nvalue * realSize);
+        for (int b = 0; b < fr.nblock && bRet; b++)
+        {
+            for (int i = 0; i < fr.block[b].nsub && bRet; i++)
+            {
+                t_enxsubblock* sub = &(fr.block[b].sub[i]);
+                if (enx_subblock_size(sub) >= 0)
+                {
+                    bRet = enx_skip_raw(ef, enx_subblock_size(sub));
+                }
+                else if (sub->type == xdr_datatype_string)
+                {
+                    enxsubblock_alloc(sub);
+                    bRet = gmx_fio_ndo_string(ef->fio, sub->sval, sub->nr);
+                }
+                else
+                {
+                    bRet = FALSE;
+                }
+            }
+        }
+        if (bRet && t != nullptr)
+        {
+            *t = fr.t;
+        }
+        if (bRet && step != nullptr)
+        {
+            *step = fr.step;
+        }
+    }
+    free_enxframe(&fr);
+
+    return bRet;
+}
+
+gmx_bool enx_seek_time(ener_file_t ef, real t)
+{
+    if (ef->eo.bOldFileOpen)
+    {
+        /* The sums in old files are converted using all earlier frames */
+        return TRUE;
+    }
+
+    const gmx_off_t                        position = gmx_fio_ftell(ef->fio);
+    const std::string                      fileName = gmx_fio_getname(ef->fio);
+    std::unique_ptr<gmx::EnergyFrameIndex> index    = gmx::loadEnergyFrameIndex(fileName, ef);
+    if (!index)
+    {
+        /* Without a valid index file, we build the index in memory.
+         * It is only written next to the energy file on request.
+         */
+        gmx_fio_seek(ef->fio, ef->firstFrameOffset);
+        index = std::make_unique<gmx::EnergyFrameIndex>(gmx::EnergyFrameIndex::build(ef));
+        if (getenv("GMX_WRITE_EDR_INDEX") != nullptr)
+        {
+            const std::string indexFileName = gmx::energyFrameIndexFileName(fileName);
+            try
+            {
+                index->write(indexFileName);
+                fprintf(stderr, "\nWrote energy frame index %s\n", indexFileName.c_str());
+            }
+            catch (const gmx::FileIOError&)
+            {
+                /* The index is only a cache, e.g., the directory can be read-only */
+            }
+        }
+    }
+
+    /* Only search forward from the current frame */
+    gmx::ArrayRef<const gmx::EnergyFrameIndexEntry> frames = index->frames();
+    int                                             frame  = 0;
+    while (frame < index->frameCount() && frames[frame].offset < position)
+    {
+        frame++;
+    }
+    frame = index->findFrameAtTime(t, frame);
+    if (frame < 0)
+    {
+        gmx_fio_seek(ef->fio, index->fileSize());
+        ef->framenr = index->frameCount();
+        return FALSE;
+    }
+    gmx_fio_seek(ef->fio, frames[frame].offset);
+    ef->framenr = frame;
+
+    return TRUE;
+}
+
 static real find_energy(const char* name, int nre, gmx_enxnm_t* enm, t_enxframe* fr)
 {
     int i;
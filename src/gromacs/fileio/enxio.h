@@ -178,6 +178,37 @@ void free_enxnms(int n, gmx_enxnm_t* nms);
 gmx_bool do_enx(ener_file_t ef, t_enxframe* fr);
 /* Reads enx_frames, memory in fr is (re)allocated if necessary */
 
+void enx_select_terms(ener_file_t ef, int nre, const gmx_bool* bTerm);
+/* Makes do_enx read only the energy terms i with bTerm[i] set, bTerm
+ * has nre entries. The values of the other terms are set to zero.
+ * With bTerm=NULL all terms are read, which is the default.
+ * The data of skipped terms is not decoded, but the selection is
+ * ignored for files from before version 4.1.
+ */
+
+void enx_select_blocks(ener_file_t ef, const gmx_bool* bBlock);
+/* Makes do_enx read only blocks with bBlock[id] set, bBlock has enxNR
+ * entries. Blocks that are not read are skipped in the file by their
+ * size and are not present in the frame. Blocks with ids not known to
+ * this version are not read. With bBlock=NULL all blocks are read,
+ * which is the default.
+ */
+
+gmx_bool enx_skip_frame(ener_file_t ef, double* t, int64_t* step);
+/* Reads the header of the next frame and skips its data. Returns the
+ * time and step of the frame in t and step, when these are not NULL.
+ * Returns FALSE at the end of the file or for an incomplete frame.
+ */
+
+gmx_bool enx_seek_time(ener_file_t ef, real t);
+/* Positions ef at the first frame with time at least t, searching
+ * forward from the current frame. Uses the frame index next to the
+ * energy file (see enxindex.h) when it is up to date, and otherwise
+ * builds it and tries to store it. Returns FALSE when there is no such
+ * frame. Does nothing for files from before version 4.1, whose sums
+ * are converted using all frames.
+ */
+
 void get_enx_state(const char* fn, real t, const SimulationGroups& groups, t_inputrec* ir, t_state* state);
 /*
  * Reads state variables from enx file fn at time t.
@@ -77,6 +77,9 @@ static const int stxs[] = { efGRO, efG96, efPDB, efBRK, efENT, efESP, efTPR };
 static const int tpss[] = { efTPR, efGRO, efG96, efPDB, efBRK, efENT };
 #define NTPSS asize(tpss)
 
+static const int tsos[] = { efXVG, efCOL };
+#define NTSOS asize(tsos)
+
 typedef struct // NOLINT(clang-analyzer-optin.performance.Padding)
 {
     int         ftype;
@@ -137,6 +140,9 @@ static const t_deffile deffile[efNR] = {
     { eftXDR, ".mtx", "hessian", "-m", "Hessian matrix" },
     { eftASC, ".edi", "sam", nullptr, "ED sampling input" },
     { eftASC, ".cub", "pot", nullptr, "Gaussian cube file" },
+    { eftXDR, ".mrc", "density", nullptr, "Density map in MRC/CCP4 format" },
+    { eftXDR, ".col", "graph", nullptr, "Binary columnar time series" },
+    { eftGEN, ".???", "graph", "-o", "Time series (xvg or binary columnar)", NTSOS, tsos },
     { eftASC, ".xpm", "root", nullptr, "X PixMap compatible matrix file" },
     { eftASC, "", "rundir", nullptr, "Run directory" }
 };
@@ -164,6 +170,7 @@ const char* ftp2ext_generic(int ftp)
             case efSTO: return "sto";
             case efSTX: return "stx";
             case efTPS: return "tps";
+            case efTSO: return "tso";
             default: return ftp2ext(ftp);
         }
     }
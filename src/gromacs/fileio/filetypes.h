@@ -82,6 +82,9 @@ enum GromacsFileType
     efMTX,
     efEDI,
     efCUB,
+    efMRC,
+    efCOL,
+    efTSO,
     efXPM,
     efRND,
     efNR
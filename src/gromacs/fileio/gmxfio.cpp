@@ -43,6 +43,7 @@
 
 #include <cerrno>
 #include <cstdio>
+#include <cstdlib>
 #include <cstring>
 
 #include <vector>
@@ -60,6 +61,7 @@
 #include "gromacs/fileio/md5.h"
 #include "gromacs/utility/fatalerror.h"
 #include "gromacs/utility/futil.h"
+#include "gromacs/utility/gmxassert.h"
 #include "gromacs/utility/mutex.h"
 #include "gromacs/utility/smalloc.h"
 
@@ -385,6 +387,54 @@ int gmx_fio_close(t_fileio* fio)
     return rc;
 }
 
+t_fileio* gmx_fio_open_buffer(int ftp)
+{
+#if !GMX_NATIVE_WINDOWS
+    GMX_RELEASE_ASSERT(ftp_is_xdr(ftp), "In-memory streams are only supported for XDR files");
+
+    t_fileio* fio = new t_fileio{};
+    tMPI_Lock_init(&(fio->mtx));
+    fio->fp = open_memstream(&fio->memBuffer, &fio->memBufferSize);
+    if (fio->fp == nullptr)
+    {
+        delete fio;
+        return nullptr;
+    }
+    fio->iFTP       = ftp;
+    fio->fn         = gmx_strdup("<memory buffer>");
+    fio->xdrmode    = XDR_ENCODE;
+    fio->bRead      = FALSE;
+    fio->bReadWrite = FALSE;
+    fio->bDouble    = (sizeof(real) == sizeof(double));
+    snew(fio->xdr, 1);
+    xdrstdio_create(fio->xdr, fio->fp, fio->xdrmode);
+
+    return fio;
+#else
+    GMX_UNUSED_VALUE(ftp);
+    return nullptr;
+#endif
+}
+
+std::vector<char> gmx_fio_close_buffer(t_fileio* fio)
+{
+    GMX_RELEASE_ASSERT(fio->fp != nullptr, "Can only close an open in-memory stream");
+
+    gmx_fio_lock(fio);
+    xdr_destroy(fio->xdr);
+    sfree(fio->xdr);
+    /* The buffer and its size are only valid after closing the stream */
+    std::fclose(fio->fp);
+    std::vector<char> data(fio->memBuffer, fio->memBuffer + fio->memBufferSize);
+    std::free(fio->memBuffer);
+    gmx_fio_unlock(fio);
+
+    sfree(fio->fn);
+    delete fio;
+
+    return data;
+}
+
 /* close only fp but keep FIO entry. */
 int gmx_fio_fp_close(t_fileio* fio)
 {
@@ -82,6 +82,18 @@ int gmx_fio_fp_close(t_fileio* fp);
  */
 
 
+t_fileio* gmx_fio_open_buffer(int ftp);
+/* Open an in-memory XDR stream for writing data of file type ftp,
+ * e.g. to stage a checkpoint that is written to disk later.
+ * The stream is not part of the list of open output files.
+ * Returns NULL when the platform does not support in-memory streams.
+ */
+
+std::vector<char> gmx_fio_close_buffer(t_fileio* fio);
+/* Close a stream opened with gmx_fio_open_buffer and return
+ * the data that was written to it.
+ */
+
 /* Open a file, return a stream, record the entry in internal FIO object */
 FILE* gmx_fio_fopen(const char* fn, const char* mode);
 
@@ -69,6 +69,9 @@ struct t_fileio
     enum xdr_op xdrmode; /* the xdr mode */
     int         iFTP;    /* the file type identifier */
 
+    char*  memBuffer;     /* contents of an in-memory stream, see gmx_fio_open_buffer */
+    size_t memBufferSize; /* size of memBuffer */
+
     t_fileio *next, *prev; /* next and previous file pointers in the
                               linked list */
     tMPI_Lock_t mtx;       /* content locking mutex. This is a fast lock
@@ -39,6 +39,7 @@
 
 #include <climits>
 #include <cmath>
+#include <cstdint>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
@@ -369,6 +370,268 @@ static void receiveints(int buf[], const int num_of_ints, int num_of_bits, const
     nums[0] = bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) | (bytes[3] << 24);
 }
 
+/*____________________________________________________________________________
+ |
+ | Bit readers used for decoding the compressed coordinates
+ |
+ | ReferenceBitReader decodes through receivebits() and receiveints(), which
+ | read the data byte by byte and do the large-integer divisions of
+ | receiveints() one byte at a time.
+ | FastBitReader keeps up to 64 bits of the stream in a register and does
+ | the divisions of receiveints() with native 64-bit integers whenever the
+ | packed integer fits, which is the case for all but extreme coordinate
+ | ranges. The two produce bit-identical results.
+ |
+ */
+
+class ReferenceBitReader
+{
+public:
+    /* buf holds the state used by receivebits(), followed by the data */
+    explicit ReferenceBitReader(int buf[]) : buf_(buf) { buf_[0] = buf_[1] = buf_[2] = 0; }
+
+    int bits(int num_of_bits) { return receivebits(buf_, num_of_bits); }
+
+    void ints(int num_of_bits, const unsigned int sizes[], int nums[])
+    {
+        receiveints(buf_, 3, num_of_bits, sizes, nums);
+    }
+
+private:
+    int* buf_;
+};
+
+class FastBitReader
+{
+public:
+    FastBitReader(const unsigned char* data, int num_of_bytes) :
+        data_(data),
+        end_(data + num_of_bytes),
+        cache_(0),
+        cachedBits_(0)
+    {
+    }
+
+    /* Read num_of_bits <= 32 bits, most significant bit first */
+    int bits(int num_of_bits)
+    {
+        if (cachedBits_ < num_of_bits)
+        {
+            refill();
+        }
+        cachedBits_ -= num_of_bits;
+        return static_cast<int>((cache_ >> cachedBits_) & ((uint64_t(1) << num_of_bits) - 1));
+    }
+
+    /* Decode three integers packed with sendints() into num_of_bits bits */
+    void ints(int num_of_bits, const unsigned int sizes[], int nums[])
+    {
+        if (num_of_bits > 64)
+        {
+            intsLarge(num_of_bits, sizes, nums);
+            return;
+        }
+        /* The bytes are stored least significant first */
+        uint64_t num   = 0;
+        int      shift = 0;
+        while (num_of_bits > 8)
+        {
+            num |= static_cast<uint64_t>(bits(8)) << shift;
+            shift += 8;
+            num_of_bits -= 8;
+        }
+        num |= static_cast<uint64_t>(bits(num_of_bits)) << shift;
+
+        nums[2] = static_cast<int>(num % sizes[2]);
+        num /= sizes[2];
+        nums[1] = static_cast<int>(num % sizes[1]);
+        nums[0] = static_cast<int>(num / sizes[1]);
+    }
+
+private:
+    void refill()
+    {
+        /* Past the end of the data, zeros are shifted in */
+        while (cachedBits_ <= 56)
+        {
+            cache_ = (cache_ << 8) | (data_ < end_ ? *data_++ : 0);
+            cachedBits_ += 8;
+        }
+    }
+
+    /* Same algorithm as receiveints(), for integers that do not fit in 64 bits */
+    void intsLarge(int num_of_bits, const unsigned int sizes[], int nums[])
+    {
+        int bytes[32];
+        int num_of_bytes = 0;
+
+        bytes[0] = bytes[1] = bytes[2] = bytes[3] = 0;
+        while (num_of_bits > 8)
+        {
+            bytes[num_of_bytes++] = bits(8);
+            num_of_bits -= 8;
+        }
+        if (num_of_bits > 0)
+        {
+            bytes[num_of_bytes++] = bits(num_of_bits);
+        }
+        for (int i = 2; i > 0; i--)
+        {
+            int num = 0;
+            for (int j = num_of_bytes - 1; j >= 0; j--)
+            {
+                num      = (num << 8) | bytes[j];
+                int p    = num / sizes[i];
+                bytes[j] = p;
+                num      = num - p * sizes[i];
+            }
+            nums[i] = num;
+        }
+        nums[0] = bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) | (bytes[3] << 24);
+    }
+
+    const unsigned char* data_;
+    const unsigned char* end_;
+    uint64_t             cache_;
+    int                  cachedBits_;
+};
+
+/*____________________________________________________________________________
+ |
+ | xtc_decode_coords - decode the compressed coordinates read by xdr3dfcoord
+ |
+ | ip is scratch space for 3*lsize integers, and the decoded coordinates
+ | are stored in fp.
+ |
+ */
+
+template<typename BitReader>
+static void xtc_decode_coords(BitReader*         reader,
+                              int                lsize,
+                              const int          minint[3],
+                              const unsigned int sizeint[3],
+                              const unsigned int bitsizeint[3],
+                              unsigned int       bitsize,
+                              int                smallidx,
+                              float              precision,
+                              int*               ip,
+                              float*             fp)
+{
+    int      smaller, smallnum, is_smaller, run, flag, i, k, tmp;
+    int *    thiscoord, prevcoord[3];
+    unsigned sizesmall[3];
+    float*   lfp;
+    float    inv_precision;
+
+    smaller      = magicints[std::max(FIRSTIDX, smallidx - 1)] / 2;
+    smallnum     = magicints[smallidx] / 2;
+    sizesmall[0] = sizesmall[1] = sizesmall[2] = magicints[smallidx];
+
+    lfp           = fp;
+    inv_precision = 1.0 / precision;
+    run           = 0;
+    i             = 0;
+    while (i < lsize)
+    {
+        thiscoord = ip + i * 3;
+
+        if (bitsize == 0)
+        {
+            thiscoord[0] = reader->bits(bitsizeint[0]);
+            thiscoord[1] = reader->bits(bitsizeint[1]);
+            thiscoord[2] = reader->bits(bitsizeint[2]);
+        }
+        else
+        {
+            reader->ints(bitsize, sizeint, thiscoord);
+        }
+
+        i++;
+        thiscoord[0] += minint[0];
+        thiscoord[1] += minint[1];
+        thiscoord[2] += minint[2];
+
+        prevcoord[0] = thiscoord[0];
+        prevcoord[1] = thiscoord[1];
+        prevcoord[2] = thiscoord[2];
+
+
+        flag       = reader->bits(1);
+        is_smaller = 0;
+        if (flag == 1)
+        {
+            run        = reader->bits(5);
+            is_smaller = run % 3;
+            run -= is_smaller;
+            is_smaller--;
+        }
+        if (run > 0)
+        {
+            thiscoord += 3;
+            for (k = 0; k < run; k += 3)
+            {
+                reader->ints(smallidx, sizesmall, thiscoord);
+                i++;
+                thiscoord[0] += prevcoord[0] - smallnum;
+                thiscoord[1] += prevcoord[1] - smallnum;
+                thiscoord[2] += prevcoord[2] - smallnum;
+                if (k == 0)
+                {
+                    /* interchange first with second atom for better
+                     * compression of water molecules
+                     */
+                    tmp          = thiscoord[0];
+                    thiscoord[0] = prevcoord[0];
+                    prevcoord[0] = tmp;
+                    tmp          = thiscoord[1];
+                    thiscoord[1] = prevcoord[1];
+                    prevcoord[1] = tmp;
+                    tmp          = thiscoord[2];
+                    thiscoord[2] = prevcoord[2];
+                    prevcoord[2] = tmp;
+                    *lfp++       = prevcoord[0] * inv_precision;
+                    *lfp++       = prevcoord[1] * inv_precision;
+                    *lfp++       = prevcoord[2] * inv_precision;
+                }
+                else
+                {
+                    prevcoord[0] = thiscoord[0];
+                    prevcoord[1] = thiscoord[1];
+                    prevcoord[2] = thiscoord[2];
+                }
+                *lfp++ = thiscoord[0] * inv_precision;
+                *lfp++ = thiscoord[1] * inv_precision;
+                *lfp++ = thiscoord[2] * inv_precision;
+            }
+        }
+        else
+        {
+            *lfp++ = thiscoord[0] * inv_precision;
+            *lfp++ = thiscoord[1] * inv_precision;
+            *lfp++ = thiscoord[2] * inv_precision;
+        }
+        smallidx += is_smaller;
+        if (is_smaller < 0)
+        {
+            smallnum = smaller;
+            if (smallidx > FIRSTIDX)
+            {
+                smaller = magicints[smallidx - 1] / 2;
+            }
+            else
+            {
+                smaller = 0;
+            }
+        }
+        else if (is_smaller > 0)
+        {
+            smaller  = smallnum;
+            smallnum = magicints[smallidx] / 2;
+        }
+        sizesmall[0] = sizesmall[1] = sizesmall[2] = magicints[smallidx];
+    }
+}
+
 /*____________________________________________________________________________
  |
  | xdr3dfcoord - read or write compressed 3d coordinates to xdr file.
@@ -396,7 +659,7 @@ static void receiveints(int buf[], const int num_of_ints, int num_of_bits, const
  |
  */
 
-int xdr3dfcoord(XDR* xdrs, float* fp, int* size, float* precision)
+static int xdr3dfcoord_impl(XDR* xdrs, float* fp, int* size, float* precision, gmx_bool bReferenceDecoder)
 {
     int*     ip  = nullptr;
     int*     buf = nullptr;
@@ -412,7 +675,7 @@ int xdr3dfcoord(XDR* xdrs, float* fp, int* size, float* precision)
     int          lint1, lint2, lint3, oldlint1, oldlint2, oldlint3, smallidx;
     int          minidx, maxidx;
     unsigned     sizeint[3], sizesmall[3], bitsizeint[3], size3, *luip;
-    int          flag, k;
+    int          k;
     int          smallnum, smaller, larger, i, is_small, is_smaller, run, prevrun;
     float *      lfp, lf;
     int          tmp, *thiscoord, prevcoord[3];
@@ -420,7 +683,6 @@ int xdr3dfcoord(XDR* xdrs, float* fp, int* size, float* precision)
 
     int          bufsize, lsize;
     unsigned int bitsize;
-    float        inv_precision;
     int          errval = 1;
     int          rc;
 
@@ -865,10 +1127,6 @@ int xdr3dfcoord(XDR* xdrs, float* fp, int* size, float* precision)
             return 0;
         }
 
-        smaller      = magicints[std::max(FIRSTIDX, smallidx - 1)] / 2;
-        smallnum     = magicints[smallidx] / 2;
-        sizesmall[0] = sizesmall[1] = sizesmall[2] = magicints[smallidx];
-
         /* buf[0] holds the length in bytes */
 
         if (xdr_int(xdrs, &(buf[0])) == 0)
@@ -893,111 +1151,18 @@ int xdr3dfcoord(XDR* xdrs, float* fp, int* size, float* precision)
         }
 
 
-        buf[0] = buf[1] = buf[2] = 0;
-
-        lfp           = fp;
-        inv_precision = 1.0 / *precision;
-        run           = 0;
-        i             = 0;
-        lip           = ip;
-        while (i < lsize)
+        /* Decode the coordinates from the data in buf */
+        if (bReferenceDecoder)
         {
-            thiscoord = reinterpret_cast<int*>(lip) + i * 3;
-
-            if (bitsize == 0)
-            {
-                thiscoord[0] = receivebits(buf, bitsizeint[0]);
-                thiscoord[1] = receivebits(buf, bitsizeint[1]);
-                thiscoord[2] = receivebits(buf, bitsizeint[2]);
-            }
-            else
-            {
-                receiveints(buf, 3, bitsize, sizeint, thiscoord);
-            }
-
-            i++;
-            thiscoord[0] += minint[0];
-            thiscoord[1] += minint[1];
-            thiscoord[2] += minint[2];
-
-            prevcoord[0] = thiscoord[0];
-            prevcoord[1] = thiscoord[1];
-            prevcoord[2] = thiscoord[2];
-
-
-            flag       = receivebits(buf, 1);
-            is_smaller = 0;
-            if (flag == 1)
-            {
-                run        = receivebits(buf, 5);
-                is_smaller = run % 3;
-                run -= is_smaller;
-                is_smaller--;
-            }
-            if (run > 0)
-            {
-                thiscoord += 3;
-                for (k = 0; k < run; k += 3)
-                {
-                    receiveints(buf, 3, smallidx, sizesmall, thiscoord);
-                    i++;
-                    thiscoord[0] += prevcoord[0] - smallnum;
-                    thiscoord[1] += prevcoord[1] - smallnum;
-                    thiscoord[2] += prevcoord[2] - smallnum;
-                    if (k == 0)
-                    {
-                        /* interchange first with second atom for better
-                         * compression of water molecules
-                         */
-                        tmp          = thiscoord[0];
-                        thiscoord[0] = prevcoord[0];
-                        prevcoord[0] = tmp;
-                        tmp          = thiscoord[1];
-                        thiscoord[1] = prevcoord[1];
-                        prevcoord[1] = tmp;
-                        tmp          = thiscoord[2];
-                        thiscoord[2] = prevcoord[2];
-                        prevcoord[2] = tmp;
-                        *lfp++       = prevcoord[0] * inv_precision;
-                        *lfp++       = prevcoord[1] * inv_precision;
-                        *lfp++       = prevcoord[2] * inv_precision;
-                    }
-                    else
-                    {
-                        prevcoord[0] = thiscoord[0];
-                        prevcoord[1] = thiscoord[1];
-                        prevcoord[2] = thiscoord[2];
-                    }
-                    *lfp++ = thiscoord[0] * inv_precision;
-                    *lfp++ = thiscoord[1] * inv_precision;
-                    *lfp++ = thiscoord[2] * inv_precision;
-                }
-            }
-            else
-            {
-                *lfp++ = thiscoord[0] * inv_precision;
-                *lfp++ = thiscoord[1] * inv_precision;
-                *lfp++ = thiscoord[2] * inv_precision;
-            }
-            smallidx += is_smaller;
-            if (is_smaller < 0)
-            {
-                smallnum = smaller;
-                if (smallidx > FIRSTIDX)
-                {
-                    smaller = magicints[smallidx - 1] / 2;
-                }
-                else
-                {
-                    smaller = 0;
-                }
-            }
-            else if (is_smaller > 0)
-            {
-                smaller  = smallnum;
-                smallnum = magicints[smallidx] / 2;
-            }
-            sizesmall[0] = sizesmall[1] = sizesmall[2] = magicints[smallidx];
+            ReferenceBitReader reader(buf);
+            xtc_decode_coords(&reader, lsize, minint, sizeint, bitsizeint, bitsize, smallidx,
+                              *precision, ip, fp);
+        }
+        else
+        {
+            FastBitReader reader(reinterpret_cast<unsigned char*>(&(buf[3])), buf[0]);
+            xtc_decode_coords(&reader, lsize, minint, sizeint, bitsizeint, bitsize, smallidx,
+                              *precision, ip, fp);
         }
     }
     if (we_should_free)
@@ -1008,6 +1173,16 @@ int xdr3dfcoord(XDR* xdrs, float* fp, int* size, float* precision)
     return 1;
 }
 
+int xdr3dfcoord(XDR* xdrs, float* fp, int* size, float* precision)
+{
+    return xdr3dfcoord_impl(xdrs, fp, size, precision, FALSE);
+}
+
+int xdr3dfcoord_reference(XDR* xdrs, float* fp, int* size, float* precision)
+{
+    return xdr3dfcoord_impl(xdrs, fp, size, precision, TRUE);
+}
+
 
 /******************************************************************
 
@@ -1641,3 +1816,54 @@ int xdr_xtc_get_last_frame_number(FILE* fp, XDR* xdrs, int natoms, gmx_bool* bOK
 
     return frame;
 }
+
+
+int xdr_xtc_skip_frame(FILE* fp, XDR* xdrs, int* natoms, int* step, float* time)
+{
+    int   header[3];
+    int   lsize;
+    int   nbytes;
+    float f;
+
+    /* A clean end of file before the first header field is the only
+     * case that is not an error. */
+    if (!xdr_int(xdrs, &header[0]))
+    {
+        return 0;
+    }
+    if (header[0] != XTC_MAGIC || !xdr_int(xdrs, &header[1]) || !xdr_int(xdrs, &header[2])
+        || !xdr_float(xdrs, &f))
+    {
+        return -1;
+    }
+    *natoms = header[1];
+    *step   = header[2];
+    *time   = f;
+
+    /* Skip the box and read the coordinate count written by xdr3dfcoord */
+    if (gmx_fseek(fp, 9 * XDR_INT_SIZE, SEEK_CUR) || !xdr_int(xdrs, &lsize) || lsize != *natoms)
+    {
+        return -1;
+    }
+    if (lsize <= 9)
+    {
+        /* Small systems are stored as uncompressed floats */
+        nbytes = 3 * lsize * XDR_INT_SIZE;
+    }
+    else
+    {
+        /* Skip precision, minint[3], maxint[3] and smallidx, and read
+         * the byte count of the compressed data, which is padded to
+         * a multiple of four bytes. */
+        if (gmx_fseek(fp, 8 * XDR_INT_SIZE, SEEK_CUR) || !xdr_int(xdrs, &nbytes) || nbytes < 0)
+        {
+            return -1;
+        }
+        nbytes = ((nbytes + XDR_INT_SIZE - 1) / XDR_INT_SIZE) * XDR_INT_SIZE;
+    }
+    if (gmx_fseek(fp, nbytes, SEEK_CUR))
+    {
+        return -1;
+    }
+    return 1;
+}
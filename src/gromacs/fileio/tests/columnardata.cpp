@@ -0,0 +1,166 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2021, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Tests for reading and writing columnar data files.
+ *
+ * \ingroup module_fileio
+ */
+#include "gmxpre.h"
+
+#include "gromacs/fileio/columnardata.h"
+
+#include <cstdio>
+
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "gromacs/utility/arrayref.h"
+#include "gromacs/utility/exceptions.h"
+#include "gromacs/utility/futil.h"
+
+#include "testutils/testfilemanager.h"
+
+namespace gmx
+{
+namespace test
+{
+namespace
+{
+
+class ColumnarDataTest : public ::testing::Test
+{
+public:
+    ColumnarDataTest() :
+        fileName_(fileManager_.getTemporaryFilePath("pullx.col")),
+        columnNames_({ "Time (ps)", "1", "1 ref" })
+    {
+    }
+
+    //! Write \p numRows rows starting at \p firstRow, appending when \p appending
+    void writeRows(int firstRow, int numRows, bool appending)
+    {
+        FILE*              fp = gmx_ffopen(fileName_, appending ? "ab" : "wb");
+        ColumnarDataWriter writer(fp, columnNames_, appending);
+        for (int r = firstRow; r < firstRow + numRows; r++)
+        {
+            writer.addRow(rowValues(r));
+        }
+        writer.flush();
+        gmx_ffclose(fp);
+    }
+
+    //! Return the values of row \p r
+    static std::vector<double> rowValues(int r)
+    {
+        return { 0.002 * r, 1.0 + 0.5 * r, -0.25 * r };
+    }
+
+    //! Check that the file holds rows 0 to \p numRows with the expected values
+    void checkRows(int numRows) const
+    {
+        ColumnarDataReader reader(fileName_);
+        EXPECT_EQ(columnNames_, reader.columnNames());
+        ASSERT_EQ(3, reader.numColumns());
+        ASSERT_EQ(numRows, reader.numRows());
+        for (int c = 0; c < reader.numColumns(); c++)
+        {
+            const std::vector<double> column = reader.readColumn(c);
+            ASSERT_EQ(static_cast<size_t>(numRows), column.size());
+            for (int r = 0; r < numRows; r++)
+            {
+                /* Only the time column is stored in double precision */
+                const double expected = rowValues(r)[c];
+                EXPECT_EQ(c == 0 ? expected : static_cast<float>(expected), column[r])
+                        << "row " << r << " column " << c;
+            }
+        }
+    }
+
+    TestFileManager          fileManager_;
+    std::string              fileName_;
+    std::vector<std::string> columnNames_;
+};
+
+TEST_F(ColumnarDataTest, RoundTripsValuesOverMultipleChunks)
+{
+    const int numRows = 50000;
+    writeRows(0, numRows, false);
+    checkRows(numRows);
+}
+
+TEST_F(ColumnarDataTest, AppendsRows)
+{
+    writeRows(0, 100, false);
+    writeRows(100, 30000, true);
+    checkRows(30100);
+}
+
+TEST_F(ColumnarDataTest, IgnoresIncompleteTrailingChunk)
+{
+    writeRows(0, 100, false);
+    writeRows(100, 50, true);
+
+    /* Cut off the last bytes, as if the writing process was killed */
+    FILE*             fp = gmx_ffopen(fileName_, "rb");
+    std::vector<char> contents(100000);
+    contents.resize(std::fread(contents.data(), 1, contents.size(), fp));
+    gmx_ffclose(fp);
+    fp = gmx_ffopen(fileName_, "wb");
+    std::fwrite(contents.data(), 1, contents.size() - 10, fp);
+    gmx_ffclose(fp);
+
+    checkRows(100);
+}
+
+TEST_F(ColumnarDataTest, ThrowsFileIOErrorWhenFileNotPresent)
+{
+    EXPECT_THROW(ColumnarDataReader(fileManager_.getTemporaryFilePath("missing.col")), FileIOError);
+}
+
+TEST_F(ColumnarDataTest, ThrowsFileIOErrorForOtherFileType)
+{
+    FILE* fp = gmx_ffopen(fileName_, "w");
+    std::fprintf(fp, "@    title \"Pull COM\"\n0.0000\t1.0\n");
+    gmx_ffclose(fp);
+
+    EXPECT_THROW(ColumnarDataReader reader(fileName_), FileIOError);
+}
+
+} // namespace
+} // namespace test
+} // namespace gmx
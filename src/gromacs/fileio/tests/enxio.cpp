@@ -0,0 +1,419 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2021, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Tests for selective and indexed reading of energy files.
+ *
+ * \ingroup module_fileio
+ */
+#include "gmxpre.h"
+
+#include "gromacs/fileio/enxio.h"
+
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "gromacs/fileio/enxindex.h"
+#include "gromacs/fileio/gmxfio.h"
+#include "gromacs/trajectory/energyframe.h"
+#include "gromacs/utility/cstringutil.h"
+#include "gromacs/utility/futil.h"
+#include "gromacs/utility/smalloc.h"
+
+#include "testutils/setenv.h"
+#include "testutils/testfilemanager.h"
+
+namespace gmx
+{
+namespace test
+{
+namespace
+{
+
+//! Number of energy terms in the written energy file.
+const int c_numTerms = 5;
+//! Number of frames in the written energy file.
+const int c_numFrames = 12;
+
+//! Contents of a frame that are compared.
+struct EnergyFrameData
+{
+    //! Time.
+    double time;
+    //! MD step.
+    int64_t step;
+    //! Energies, averages and sums of all terms.
+    std::vector<real> energies;
+    //! Block ids.
+    std::vector<int> blockIds;
+    //! Floating-point block data.
+    std::vector<double> blockValues;
+    //! Integer block data.
+    std::vector<int64_t> blockIntegers;
+};
+
+//! Copies the contents of \p fr.
+EnergyFrameData frameData(const t_enxframe& fr)
+{
+    EnergyFrameData data;
+    data.time = fr.t;
+    data.step = fr.step;
+    for (int i = 0; i < fr.nre; i++)
+    {
+        data.energies.push_back(fr.ener[i].e);
+        data.energies.push_back(fr.ener[i].eav);
+        data.energies.push_back(fr.ener[i].esum);
+    }
+    for (int b = 0; b < fr.nblock; b++)
+    {
+        data.blockIds.push_back(fr.block[b].id);
+        for (int s = 0; s < fr.block[b].nsub; s++)
+        {
+            const t_enxsubblock& sub = fr.block[b].sub[s];
+            for (int i = 0; i < sub.nr; i++)
+            {
+                switch (sub.type)
+                {
+                    case xdr_datatype_float: data.blockValues.push_back(sub.fval[i]); break;
+                    case xdr_datatype_double: data.blockValues.push_back(sub.dval[i]); break;
+                    case xdr_datatype_int: data.blockIntegers.push_back(sub.ival[i]); break;
+                    case xdr_datatype_int64: data.blockIntegers.push_back(sub.lval[i]); break;
+                    case xdr_datatype_char: data.blockIntegers.push_back(sub.cval[i]); break;
+                    default: break;
+                }
+            }
+        }
+    }
+    return data;
+}
+
+/*! \brief
+ * Test fixture that writes an energy file with free-energy and AWH blocks.
+ *
+ * Every third frame has no AWH block, and the size of the delta H
+ * block changes between frames.
+ */
+class EnergyFileReadingTest : public ::testing::Test
+{
+public:
+    EnergyFileReadingTest() : fileName_(fileManager_.getTemporaryFilePath("ener.edr"))
+    {
+        writeFrames(0, c_numFrames);
+    }
+
+    //! Writes frames \p firstFrame to \p lastFrame (exclusive), appending when \p firstFrame > 0.
+    void writeFrames(int firstFrame, int lastFrame)
+    {
+        ener_file_t ef = open_enx(fileName_.c_str(), firstFrame == 0 ? "w" : "a");
+        if (firstFrame == 0)
+        {
+            std::vector<std::string> names = { "LJ (SR)", "Coulomb (SR)", "Potential",
+                                               "Temperature", "Pressure" };
+            gmx_enxnm_t*             enm;
+            snew(enm, c_numTerms);
+            for (int i = 0; i < c_numTerms; i++)
+            {
+                enm[i].name = gmx_strdup(names[i].c_str());
+                enm[i].unit = gmx_strdup("kJ/mol");
+            }
+            int nre = c_numTerms;
+            do_enxnms(ef, &nre, &enm);
+            free_enxnms(nre, enm);
+        }
+
+        std::vector<double>        dhValues(100);
+        std::vector<int>           dhCounts(3);
+        std::vector<float>         awhValues(7);
+        std::vector<unsigned char> awhFlags(5);
+        for (int frame = firstFrame; frame < lastFrame; frame++)
+        {
+            t_enxframe fr;
+            init_enxframe(&fr);
+            fr.t      = 0.5 * frame;
+            fr.step   = 100 * frame;
+            fr.nsteps = 100;
+            fr.dt     = 0.005;
+            fr.nsum   = (frame == 0 ? 1 : 100);
+            fr.nre    = c_numTerms;
+            snew(fr.ener, c_numTerms);
+            fr.e_alloc = c_numTerms;
+            for (int i = 0; i < c_numTerms; i++)
+            {
+                fr.ener[i].e    = -10.0 * i + frame;
+                fr.ener[i].eav  = 0.25 * i * frame;
+                fr.ener[i].esum = 100.0 * fr.ener[i].e;
+            }
+            const bool haveAwh = (frame % 3 != 2);
+            add_blocks_enxframe(&fr, haveAwh ? 2 : 1);
+
+            fr.block[0].id = enxDH;
+            add_subblocks_enxblock(&fr.block[0], 2);
+            fr.block[0].sub[0].type = xdr_datatype_double;
+            fr.block[0].sub[0].nr   = 10 * (frame % 4 + 1);
+            fr.block[0].sub[0].dval = dhValues.data();
+            fr.block[0].sub[1].type = xdr_datatype_int;
+            fr.block[0].sub[1].nr   = dhCounts.size();
+            fr.block[0].sub[1].ival = dhCounts.data();
+            for (size_t i = 0; i < dhValues.size(); i++)
+            {
+                dhValues[i] = 0.1 * i - frame;
+            }
+            for (size_t i = 0; i < dhCounts.size(); i++)
+            {
+                dhCounts[i] = frame * 10 + i;
+            }
+            if (haveAwh)
+            {
+                fr.block[1].id = enxAWH;
+                add_subblocks_enxblock(&fr.block[1], 2);
+                fr.block[1].sub[0].type = xdr_datatype_float;
+                fr.block[1].sub[0].nr   = awhValues.size();
+                fr.block[1].sub[0].fval = awhValues.data();
+                fr.block[1].sub[1].type = xdr_datatype_char;
+                fr.block[1].sub[1].nr   = awhFlags.size();
+                fr.block[1].sub[1].cval = awhFlags.data();
+                for (size_t i = 0; i < awhValues.size(); i++)
+                {
+                    awhValues[i] = 2.0F * i + frame;
+                }
+                for (size_t i = 0; i < awhFlags.size(); i++)
+                {
+                    awhFlags[i] = static_cast<unsigned char>(frame + i);
+                }
+            }
+            do_enx(ef, &fr);
+
+            /* The block data is owned by the vectors */
+            for (int b = 0; b < fr.nblock; b++)
+            {
+                for (int s = 0; s < fr.block[b].nsub; s++)
+                {
+                    fr.block[b].sub[s].fval = nullptr;
+                    fr.block[b].sub[s].dval = nullptr;
+                    fr.block[b].sub[s].ival = nullptr;
+                    fr.block[b].sub[s].cval = nullptr;
+                }
+            }
+            free_enxframe(&fr);
+        }
+        done_ener_file(ef);
+    }
+
+    //! Opens the energy file for reading and reads the names.
+    ener_file_t openForReading()
+    {
+        ener_file_t  ef = open_enx(fileName_.c_str(), "r");
+        int          nre;
+        gmx_enxnm_t* enm = nullptr;
+        do_enxnms(ef, &nre, &enm);
+        free_enxnms(nre, enm);
+        return ef;
+    }
+
+    //! Reads the remaining frames of \p ef.
+    static std::vector<EnergyFrameData> readFrames(ener_file_t ef)
+    {
+        std::vector<EnergyFrameData> frames;
+        t_enxframe                   fr;
+        init_enxframe(&fr);
+        while (do_enx(ef, &fr))
+        {
+            frames.push_back(frameData(fr));
+        }
+        free_enxframe(&fr);
+        return frames;
+    }
+
+    TestFileManager fileManager_;
+    std::string     fileName_;
+};
+
+TEST_F(EnergyFileReadingTest, ReadsSelectedTermsAndBlocks)
+{
+    ener_file_t                        ef        = openForReading();
+    const std::vector<EnergyFrameData> allFrames = readFrames(ef);
+    done_ener_file(ef);
+    ASSERT_EQ(c_numFrames, static_cast<int>(allFrames.size()));
+
+    ef                               = openForReading();
+    const gmx_bool bTerm[c_numTerms] = { FALSE, TRUE, FALSE, FALSE, TRUE };
+    gmx_bool       bBlock[enxNR]     = { FALSE };
+    bBlock[enxAWH]                   = TRUE;
+    enx_select_terms(ef, c_numTerms, bTerm);
+    enx_select_blocks(ef, bBlock);
+    const std::vector<EnergyFrameData> selectedFrames = readFrames(ef);
+    done_ener_file(ef);
+    ASSERT_EQ(allFrames.size(), selectedFrames.size());
+
+    for (int frame = 0; frame < c_numFrames; frame++)
+    {
+        SCOPED_TRACE("Frame " + std::to_string(frame));
+        const EnergyFrameData& all      = allFrames[frame];
+        const EnergyFrameData& selected = selectedFrames[frame];
+        EXPECT_EQ(all.time, selected.time);
+        EXPECT_EQ(all.step, selected.step);
+        for (int i = 0; i < c_numTerms; i++)
+        {
+            for (int j = 0; j < 3; j++)
+            {
+                EXPECT_EQ(bTerm[i] ? all.energies[3 * i + j] : 0, selected.energies[3 * i + j]);
+            }
+        }
+        if (frame % 3 != 2)
+        {
+            /* The AWH block follows the delta H block, which has 3 integers */
+            ASSERT_EQ(std::vector<int>({ enxAWH }), selected.blockIds);
+            EXPECT_EQ(std::vector<double>(all.blockValues.end() - 7, all.blockValues.end()),
+                      selected.blockValues);
+            EXPECT_EQ(std::vector<int64_t>(all.blockIntegers.begin() + 3, all.blockIntegers.end()),
+                      selected.blockIntegers);
+        }
+        else
+        {
+            EXPECT_TRUE(selected.blockIds.empty());
+        }
+    }
+}
+
+TEST_F(EnergyFileReadingTest, SkipsFrames)
+{
+    ener_file_t ef = openForReading();
+    for (int frame = 0; frame < c_numFrames; frame++)
+    {
+        double  time;
+        int64_t step;
+        ASSERT_TRUE(enx_skip_frame(ef, &time, &step));
+        EXPECT_EQ(0.5 * frame, time);
+        EXPECT_EQ(100 * frame, step);
+    }
+    EXPECT_FALSE(enx_skip_frame(ef, nullptr, nullptr));
+    done_ener_file(ef);
+}
+
+TEST_F(EnergyFileReadingTest, SeeksToTimeWithoutWritingIndex)
+{
+    const std::string indexFileName = fileManager_.getTemporaryFilePath("ener.edr.idx");
+    ASSERT_EQ(energyFrameIndexFileName(fileName_), indexFileName);
+    ener_file_t ef = openForReading();
+    ASSERT_TRUE(enx_seek_time(ef, 2.2));
+    std::vector<EnergyFrameData> frames = readFrames(ef);
+    ASSERT_EQ(c_numFrames - 5, static_cast<int>(frames.size()));
+    EXPECT_EQ(2.5, frames[0].time);
+    done_ener_file(ef);
+    EXPECT_FALSE(gmx_fexist(indexFileName));
+}
+
+TEST_F(EnergyFileReadingTest, SeeksToTimeAndWritesIndexOnRequest)
+{
+    const std::string indexFileName = fileManager_.getTemporaryFilePath("ener.edr.idx");
+    ASSERT_EQ(energyFrameIndexFileName(fileName_), indexFileName);
+    gmxSetenv("GMX_WRITE_EDR_INDEX", "1", 1);
+    for (int pass = 0; pass < 2; pass++)
+    {
+        // The second pass uses the index written by the first
+        ener_file_t ef = openForReading();
+        ASSERT_TRUE(enx_seek_time(ef, 2.2));
+        std::vector<EnergyFrameData> frames = readFrames(ef);
+        ASSERT_EQ(c_numFrames - 5, static_cast<int>(frames.size()));
+        EXPECT_EQ(2.5, frames[0].time);
+        done_ener_file(ef);
+        EXPECT_TRUE(gmx_fexist(indexFileName));
+    }
+
+    ener_file_t ef = openForReading();
+    EXPECT_FALSE(enx_seek_time(ef, 0.5 * c_numFrames));
+    done_ener_file(ef);
+
+    // An appended energy file is indexed again
+    writeFrames(c_numFrames, c_numFrames + 3);
+    ef = openForReading();
+    ASSERT_TRUE(enx_seek_time(ef, 0.5 * c_numFrames));
+    std::vector<EnergyFrameData> frames = readFrames(ef);
+    ASSERT_EQ(3U, frames.size());
+    EXPECT_EQ(0.5 * c_numFrames, frames[0].time);
+    done_ener_file(ef);
+    ef = openForReading();
+    std::unique_ptr<EnergyFrameIndex> index = loadEnergyFrameIndex(fileName_, ef);
+    done_ener_file(ef);
+    gmxUnsetenv("GMX_WRITE_EDR_INDEX");
+    ASSERT_TRUE(index);
+    EXPECT_EQ(c_numFrames + 3, index->frameCount());
+}
+
+TEST_F(EnergyFileReadingTest, SeeksOnlyForward)
+{
+    ener_file_t ef = openForReading();
+    t_enxframe  fr;
+    init_enxframe(&fr);
+    for (int frame = 0; frame < 8; frame++)
+    {
+        ASSERT_TRUE(do_enx(ef, &fr));
+    }
+    free_enxframe(&fr);
+    ASSERT_TRUE(enx_seek_time(ef, 1));
+    std::vector<EnergyFrameData> frames = readFrames(ef);
+    ASSERT_EQ(c_numFrames - 8, static_cast<int>(frames.size()));
+    EXPECT_EQ(4, frames[0].time);
+    done_ener_file(ef);
+}
+
+TEST_F(EnergyFileReadingTest, IndexRoundTrips)
+{
+    ener_file_t            ef    = openForReading();
+    const EnergyFrameIndex index = EnergyFrameIndex::build(ef);
+    EXPECT_TRUE(index.isValidFor(ef));
+    done_ener_file(ef);
+    ASSERT_EQ(c_numFrames, index.frameCount());
+    EXPECT_EQ(5, index.findFrameAtTime(2.2));
+    EXPECT_EQ(-1, index.findFrameAtTime(100));
+
+    const std::string indexFileName = fileManager_.getTemporaryFilePath("ener.idx");
+    index.write(indexFileName);
+    const EnergyFrameIndex readIndex = EnergyFrameIndex::read(indexFileName);
+    EXPECT_EQ(index.fileSize(), readIndex.fileSize());
+    ASSERT_EQ(index.frameCount(), readIndex.frameCount());
+    for (int frame = 0; frame < index.frameCount(); frame++)
+    {
+        EXPECT_EQ(index.frames()[frame].offset, readIndex.frames()[frame].offset);
+        EXPECT_EQ(index.frames()[frame].step, readIndex.frames()[frame].step);
+        EXPECT_EQ(index.frames()[frame].time, readIndex.frames()[frame].time);
+    }
+}
+
+} // namespace
+} // namespace test
+} // namespace gmx
@@ -44,6 +44,7 @@
 
 #include <gtest/gtest.h>
 
+#include "gromacs/fileio/filetypes.h"
 #include "gromacs/fileio/gmxfio.h"
 #include "gromacs/fileio/gmxfio_xdr.h"
 #include "gromacs/utility/futil.h"
@@ -145,6 +146,50 @@ TEST_F(FileIOXdrSerializerTest, SizeIsCorrect)
     EXPECT_EQ(fileSize, 72);
 }
 
+//! Serializes the test values, so different streams can be compared.
+void serializeValues(FileIOXdrSerializer* serializer)
+{
+    std::int32_t int32Value  = c_int32Value;
+    std::int64_t int64Value  = c_int64Value;
+    double       doubleValue = c_intAndFloat64.doubleValue_;
+    serializer->doInt32(&int32Value);
+    serializer->doInt64(&int64Value);
+    serializer->doDouble(&doubleValue);
+    std::vector<char> charBuffer = { 'a', 'b', 'c' };
+    serializer->doCharArray(charBuffer.data(), charBuffer.size());
+}
+
+TEST_F(FileIOXdrSerializerTest, BufferHasSameContentsAsFile)
+{
+    t_fileio* buffer = gmx_fio_open_buffer(efEDR);
+    if (buffer == nullptr)
+    {
+        // In-memory streams are not supported on this platform
+        return;
+    }
+    {
+        FileIOXdrSerializer serializer(buffer);
+        serializeValues(&serializer);
+    }
+    std::vector<char> bufferContents = gmx_fio_close_buffer(buffer);
+
+    file_ = gmx_fio_open(filename_.c_str(), "w");
+    {
+        FileIOXdrSerializer serializer(file_);
+        serializeValues(&serializer);
+    }
+    gmx_fio_close(file_);
+    file_ = nullptr;
+
+    std::vector<char> fileContents(bufferContents.size() + 1);
+    FILE*             fp = gmx_ffopen(filename_, "rb");
+    fileContents.resize(std::fread(fileContents.data(), 1, fileContents.size(), fp));
+    gmx_ffclose(fp);
+
+    EXPECT_EQ(bufferContents.size(), 32U);
+    EXPECT_EQ(fileContents, bufferContents);
+}
+
 } // namespace
 } // namespace test
 } // namespace gmx
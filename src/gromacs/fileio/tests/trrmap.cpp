@@ -0,0 +1,268 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2021, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Tests for gmx::TrrMappedFile.
+ *
+ * \ingroup module_fileio
+ */
+#include "gmxpre.h"
+
+#include "gromacs/fileio/trrmap.h"
+
+#include <cstdio>
+
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "gromacs/fileio/gmxfio.h"
+#include "gromacs/fileio/oenv.h"
+#include "gromacs/fileio/trrio.h"
+#include "gromacs/fileio/trxio.h"
+#include "gromacs/math/vec.h"
+#include "gromacs/trajectory/trajectoryframe.h"
+
+#include "testutils/setenv.h"
+#include "testutils/testfilemanager.h"
+
+namespace gmx
+{
+namespace test
+{
+namespace
+{
+
+//! Number of atoms in the written test trajectory.
+const int c_numAtoms = 17;
+//! Number of frames in the written test trajectory.
+const int c_numFrames = 5;
+
+//! Returns the values of \p x as a flat vector.
+std::vector<real> flatten(ArrayRef<const RVec> x)
+{
+    std::vector<real> values;
+    for (const RVec& value : x)
+    {
+        values.insert(values.end(), value.as_vec(), value.as_vec() + DIM);
+    }
+    return values;
+}
+
+/*! \brief
+ * Test fixture that writes a TRR file with varying frame contents.
+ *
+ * Frame 2 has no velocities and frame 3 has no coordinates. Forces are
+ * only written to odd frames.
+ */
+class TrrMappedFileTest : public ::testing::Test
+{
+public:
+    TrrMappedFileTest() : fileName_(fileManager_.getTemporaryFilePath("traj.trr"))
+    {
+        std::vector<RVec> x(c_numAtoms), v(c_numAtoms), f(c_numAtoms);
+        t_fileio*         fio = gmx_trr_open(fileName_.c_str(), "w");
+        for (int frame = 0; frame < c_numFrames; ++frame)
+        {
+            matrix box = { { 3.0F + frame, 0, 0 }, { 0.1F, 3, 0 }, { 0.2F, 0.3F, 4 } };
+            for (int i = 0; i < c_numAtoms; ++i)
+            {
+                x[i] = { 0.1F * i, -0.01F * i * frame, 0.001F * i * i * (frame + 1) };
+                v[i] = { 1.0F * frame, -0.1F * i, 0.5F };
+                f[i] = { -100.0F * i, 1e-3F * frame, 1e4F };
+            }
+            gmx_trr_write_frame(fio, 10 * frame, 0.5 * frame, 0.1 * frame, box, c_numAtoms,
+                                frame != 3 ? as_rvec_array(x.data()) : nullptr,
+                                frame != 2 ? as_rvec_array(v.data()) : nullptr,
+                                frame % 2 == 1 ? as_rvec_array(f.data()) : nullptr);
+        }
+        gmx_fio_close(fio);
+    }
+
+    //! Truncates the test file to \p size bytes.
+    void truncateFile(long size)
+    {
+        std::vector<char> contents(size);
+        FILE*             fp = std::fopen(fileName_.c_str(), "rb");
+        ASSERT_EQ(contents.size(), std::fread(contents.data(), 1, contents.size(), fp));
+        std::fclose(fp);
+        fp = std::fopen(fileName_.c_str(), "wb");
+        std::fwrite(contents.data(), 1, contents.size(), fp);
+        std::fclose(fp);
+    }
+
+    TestFileManager fileManager_;
+    std::string     fileName_;
+};
+
+TEST_F(TrrMappedFileTest, ReadsSameFramesAsXdrReader)
+{
+    TrrMappedFile mapped(fileName_);
+    ASSERT_EQ(c_numFrames, mapped.frameCount());
+
+    t_fileio*         fio = gmx_trr_open(fileName_.c_str(), "r");
+    std::vector<RVec> x(c_numAtoms), v(c_numAtoms), f(c_numAtoms);
+    std::vector<RVec> mappedX(c_numAtoms), mappedV(c_numAtoms), mappedF(c_numAtoms);
+    for (int frame = 0; frame < c_numFrames; ++frame)
+    {
+        SCOPED_TRACE("Frame " + std::to_string(frame));
+        const TrrMappedFrame& mappedFrame = mapped.frames()[frame];
+        EXPECT_EQ(gmx_fio_ftell(fio), mappedFrame.offset);
+        EXPECT_EQ(frame, mapped.frameAtOffset(mappedFrame.offset));
+
+        gmx_trr_header_t header;
+        gmx_bool         bOK;
+        ASSERT_TRUE(gmx_trr_read_frame_header(fio, &header, &bOK));
+        EXPECT_EQ(header.step, mappedFrame.header.step);
+        EXPECT_EQ(header.t, mappedFrame.header.t);
+        EXPECT_EQ(header.lambda, mappedFrame.header.lambda);
+        EXPECT_EQ(header.natoms, mappedFrame.header.natoms);
+        EXPECT_EQ(header.bDouble, mappedFrame.header.bDouble);
+        EXPECT_EQ(header.box_size, mappedFrame.header.box_size);
+        EXPECT_EQ(header.x_size, mappedFrame.header.x_size);
+        EXPECT_EQ(header.v_size, mappedFrame.header.v_size);
+        EXPECT_EQ(header.f_size, mappedFrame.header.f_size);
+
+        matrix box, mappedBox;
+        ASSERT_TRUE(gmx_trr_read_frame_data(fio, &header, box, as_rvec_array(x.data()),
+                                            as_rvec_array(v.data()), as_rvec_array(f.data())));
+        EXPECT_EQ(gmx_fio_ftell(fio), mappedFrame.endOffset);
+        mapped.readFrame(frame, mappedBox, as_rvec_array(mappedX.data()),
+                         as_rvec_array(mappedV.data()), as_rvec_array(mappedF.data()));
+        EXPECT_EQ(std::vector<real>(box[0], box[0] + DIM * DIM),
+                  std::vector<real>(mappedBox[0], mappedBox[0] + DIM * DIM));
+        if (header.x_size > 0)
+        {
+            EXPECT_EQ(flatten(x), flatten(mappedX));
+            EXPECT_EQ(flatten(x), flatten(mapped.x(frame)));
+        }
+        else
+        {
+            EXPECT_TRUE(mapped.x(frame).empty());
+        }
+        if (header.v_size > 0)
+        {
+            EXPECT_EQ(flatten(v), flatten(mappedV));
+            EXPECT_EQ(flatten(v), flatten(mapped.v(frame)));
+        }
+        else
+        {
+            EXPECT_TRUE(mapped.v(frame).empty());
+        }
+        if (header.f_size > 0)
+        {
+            EXPECT_EQ(flatten(f), flatten(mappedF));
+            EXPECT_EQ(flatten(f), flatten(mapped.f(frame)));
+        }
+        else
+        {
+            EXPECT_TRUE(mapped.f(frame).empty());
+        }
+    }
+    gmx_fio_close(fio);
+}
+
+TEST_F(TrrMappedFileTest, FindsFramesOnlyAtHeaders)
+{
+    TrrMappedFile mapped(fileName_);
+    ASSERT_EQ(c_numFrames, mapped.frameCount());
+    EXPECT_EQ(-1, mapped.frameAtOffset(mapped.frames()[1].dataOffset));
+    EXPECT_EQ(-1, mapped.frameAtOffset(mapped.frames()[c_numFrames - 1].endOffset));
+}
+
+TEST_F(TrrMappedFileTest, IgnoresIncompleteLastFrame)
+{
+    int64_t lastFrameEnd;
+    {
+        TrrMappedFile mapped(fileName_);
+        lastFrameEnd = mapped.frames()[c_numFrames - 1].endOffset;
+    }
+    truncateFile(lastFrameEnd - 7);
+    TrrMappedFile mapped(fileName_);
+    EXPECT_EQ(c_numFrames - 1, mapped.frameCount());
+}
+
+TEST_F(TrrMappedFileTest, HandlesEmptyFile)
+{
+    truncateFile(0);
+    TrrMappedFile mapped(fileName_);
+    EXPECT_EQ(0, mapped.frameCount());
+}
+
+TEST_F(TrrMappedFileTest, ReadNextFrameGivesSameFramesWithAndWithoutMapping)
+{
+    gmx_output_env_t* oenv;
+    output_env_init_default(&oenv);
+    std::vector<std::vector<real>> frames[2];
+    for (int useMapping = 0; useMapping < 2; ++useMapping)
+    {
+        if (useMapping)
+        {
+            gmxUnsetenv("GMX_NO_TRR_MMAP");
+        }
+        else
+        {
+            gmxSetenv("GMX_NO_TRR_MMAP", "1", 1);
+        }
+        t_trxstatus* status;
+        t_trxframe   fr;
+        ASSERT_TRUE(read_first_frame(oenv, &status, fileName_.c_str(), &fr,
+                                     TRX_READ_X | TRX_READ_V | TRX_READ_F));
+        do
+        {
+            std::vector<real> values = { real(fr.step), fr.time, fr.lambda };
+            values.insert(values.end(), fr.box[0], fr.box[0] + DIM * DIM);
+            for (rvec* array : { fr.bX ? fr.x : nullptr, fr.bV ? fr.v : nullptr, fr.bF ? fr.f : nullptr })
+            {
+                if (array != nullptr)
+                {
+                    values.insert(values.end(), array[0], array[0] + DIM * fr.natoms);
+                }
+            }
+            frames[useMapping].push_back(values);
+        } while (read_next_frame(oenv, status, &fr));
+        close_trx(status);
+        done_frame(&fr);
+    }
+    gmxUnsetenv("GMX_NO_TRR_MMAP");
+    output_env_done(oenv);
+    EXPECT_EQ(static_cast<size_t>(c_numFrames), frames[1].size());
+    EXPECT_EQ(frames[0], frames[1]);
+}
+
+} // namespace
+} // namespace test
+} // namespace gmx
@@ -0,0 +1,240 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2021, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Tests for reading trajectory frames ahead.
+ *
+ * \ingroup module_fileio
+ */
+#include "gmxpre.h"
+
+#include "gromacs/fileio/trxio.h"
+
+#include "config.h"
+
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "gromacs/fileio/gmxfio.h"
+#include "gromacs/fileio/oenv.h"
+#include "gromacs/fileio/trrio.h"
+#include "gromacs/fileio/xtcio.h"
+#include "gromacs/math/vec.h"
+#include "gromacs/trajectory/trajectoryframe.h"
+#include "gromacs/utility/path.h"
+
+#include "testutils/setenv.h"
+#include "testutils/testfilemanager.h"
+
+namespace gmx
+{
+namespace test
+{
+namespace
+{
+
+//! Number of atoms in the written test trajectories.
+const int c_numAtoms = 20;
+//! Number of frames in the written test trajectories.
+const int c_numFrames = 6;
+
+//! Contents of a frame that are compared.
+struct FrameData
+{
+    //! MD step.
+    int64_t step;
+    //! Time.
+    real time;
+    //! Coordinates.
+    std::vector<real> x;
+    //! Velocities, empty when not present.
+    std::vector<real> v;
+};
+
+/*! \brief
+ * Test fixture that reads a trajectory with different read-ahead depths.
+ *
+ * The parameter is the file extension. XTC and TRR files are written
+ * by the fixture, and for TNG a file from the simulation database is used.
+ */
+class TrxPrefetchTest : public ::testing::TestWithParam<const char*>
+{
+public:
+    TrxPrefetchTest()
+    {
+        output_env_init_default(&oenv_);
+        const std::string extension = GetParam();
+        if (extension == "tng")
+        {
+            fileName_ = Path::join(TestFileManager::getTestSimulationDatabaseDirectory(),
+                                   "spc2-traj.tng");
+            return;
+        }
+        fileName_ = fileManager_.getTemporaryFilePath("traj." + extension);
+        std::vector<RVec> x(c_numAtoms), v(c_numAtoms);
+        matrix            box = { { 3, 0, 0 }, { 0, 3, 0 }, { 0, 0, 3 } };
+        t_fileio*         fio = (extension == "xtc" ? open_xtc(fileName_.c_str(), "w")
+                                            : gmx_trr_open(fileName_.c_str(), "w"));
+        for (int frame = 0; frame < c_numFrames; ++frame)
+        {
+            for (int i = 0; i < c_numAtoms; ++i)
+            {
+                x[i] = { 0.1F * i, 0.01F * i * frame, 0.001F * i * i * (frame + 1) };
+                v[i] = { 1.0F * frame, -0.1F * i, 0.5F };
+            }
+            if (extension == "xtc")
+            {
+                write_xtc(fio, c_numAtoms, 10 * frame, 0.5 * frame, box, as_rvec_array(x.data()), 1000);
+            }
+            else
+            {
+                gmx_trr_write_frame(fio, 10 * frame, 0.5 * frame, 0, box, c_numAtoms,
+                                    as_rvec_array(x.data()), as_rvec_array(v.data()), nullptr);
+            }
+        }
+        gmx_fio_close(fio);
+    }
+    ~TrxPrefetchTest() override { output_env_done(oenv_); }
+
+    //! Copies the contents of \p fr.
+    static FrameData frameData(const t_trxframe& fr)
+    {
+        FrameData data;
+        data.step = fr.step;
+        data.time = fr.time;
+        data.x.assign(fr.x[0], fr.x[0] + DIM * fr.natoms);
+        if (fr.bV)
+        {
+            data.v.assign(fr.v[0], fr.v[0] + DIM * fr.natoms);
+        }
+        return data;
+    }
+
+    //! Reads all frames, reading \p depth frames ahead.
+    std::vector<FrameData> readFrames(int depth)
+    {
+        gmxSetenv("GMX_TRX_PREFETCH", std::to_string(depth).c_str(), 1);
+        std::vector<FrameData> frames;
+        t_trxstatus*           status;
+        t_trxframe             fr;
+        if (read_first_frame(oenv_, &status, fileName_.c_str(), &fr, TRX_NEED_X | TRX_READ_V))
+        {
+            do
+            {
+                frames.push_back(frameData(fr));
+            } while (read_next_frame(oenv_, status, &fr));
+        }
+        if (depth > 0)
+        {
+            // The end of the trajectory is kept when reading ahead.
+            EXPECT_FALSE(read_next_frame(oenv_, status, &fr));
+        }
+        close_trx(status);
+        done_frame(&fr);
+        return frames;
+    }
+
+    //! Checks that \p actual contains the same frames as \p expected.
+    static void compareFrames(const std::vector<FrameData>& expected, const std::vector<FrameData>& actual)
+    {
+        ASSERT_EQ(expected.size(), actual.size());
+        for (size_t frame = 0; frame < expected.size(); ++frame)
+        {
+            EXPECT_EQ(expected[frame].step, actual[frame].step);
+            EXPECT_EQ(expected[frame].time, actual[frame].time);
+            EXPECT_EQ(expected[frame].x, actual[frame].x);
+            EXPECT_EQ(expected[frame].v, actual[frame].v);
+        }
+    }
+
+    TestFileManager   fileManager_;
+    std::string       fileName_;
+    gmx_output_env_t* oenv_;
+};
+
+TEST_P(TrxPrefetchTest, ReadsSameFramesAsWithoutReadAhead)
+{
+    const std::vector<FrameData> reference = readFrames(0);
+    ASSERT_FALSE(reference.empty());
+    compareFrames(reference, readFrames(1));
+    compareFrames(reference, readFrames(3));
+    compareFrames(reference, readFrames(100));
+    gmxUnsetenv("GMX_TRX_PREFETCH");
+}
+
+TEST_P(TrxPrefetchTest, FilePositionMatchesFramesReturned)
+{
+    if (std::string(GetParam()) == "tng")
+    {
+        return;
+    }
+    t_trxstatus* status;
+    t_trxframe   fr;
+    ASSERT_TRUE(read_first_frame(oenv_, &status, fileName_.c_str(), &fr, TRX_NEED_X | TRX_READ_V));
+    ASSERT_TRUE(read_next_frame(oenv_, status, &fr));
+    const gmx_off_t offsetAfterTwoFrames = gmx_fio_ftell(trx_get_fileio(status));
+    close_trx(status);
+    done_frame(&fr);
+
+    ASSERT_TRUE(read_first_frame(oenv_, &status, fileName_.c_str(), &fr, TRX_NEED_X | TRX_READ_V));
+    trx_set_prefetch_depth(status, 3);
+    ASSERT_TRUE(read_next_frame(oenv_, status, &fr));
+    EXPECT_EQ(10, fr.step);
+    // The frames read ahead are dropped and the file is positioned after the second frame.
+    EXPECT_EQ(offsetAfterTwoFrames, gmx_fio_ftell(trx_get_fileio(status)));
+    ASSERT_TRUE(read_next_frame(oenv_, status, &fr));
+    EXPECT_EQ(20, fr.step);
+
+    // Rewinding restarts at the first frame.
+    rewind_trj(status);
+    ASSERT_TRUE(read_next_frame(oenv_, status, &fr));
+    EXPECT_EQ(0, fr.step);
+    ASSERT_TRUE(read_next_frame(oenv_, status, &fr));
+    EXPECT_EQ(10, fr.step);
+    close_trx(status);
+    done_frame(&fr);
+}
+
+#if GMX_USE_TNG
+INSTANTIATE_TEST_CASE_P(TrajectoryFormats, TrxPrefetchTest, ::testing::Values("xtc", "trr", "tng"));
+#else
+INSTANTIATE_TEST_CASE_P(TrajectoryFormats, TrxPrefetchTest, ::testing::Values("xtc", "trr"));
+#endif
+
+} // namespace
+} // namespace test
+} // namespace gmx
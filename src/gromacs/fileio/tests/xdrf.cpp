@@ -0,0 +1,205 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2021, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Tests for the compressed coordinate decoding in xdr3dfcoord.
+ *
+ * \ingroup module_fileio
+ */
+#include "gmxpre.h"
+
+#include "gromacs/fileio/xdrf.h"
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "gromacs/fileio/gmxfio.h"
+#include "gromacs/fileio/gmxfio_xdr.h"
+
+#include "testutils/testfilemanager.h"
+
+namespace gmx
+{
+namespace test
+{
+namespace
+{
+
+//! Description of a set of coordinates to compress.
+struct CoordinateSet
+{
+    //! Name used in the test output.
+    const char* name;
+    //! Number of atoms.
+    int numAtoms;
+    //! Extent of the coordinates in each dimension.
+    float range;
+    //! Compression precision.
+    float precision;
+    //! Whether the atoms come in water-like triplets.
+    bool waterLike;
+};
+
+//! Prints the name of the coordinate set in test output.
+void PrintTo(const CoordinateSet& set, std::ostream* os)
+{
+    *os << set.name;
+}
+
+/*! \brief
+ * Generates coordinates for \p set.
+ *
+ * Water-like sets place three atoms within 0.1 nm of each other, which
+ * exercises the run-length and atom interchange logic of the compressor.
+ */
+std::vector<float> generateCoordinates(const CoordinateSet& set, int seed)
+{
+    std::mt19937                          rng(seed);
+    std::uniform_real_distribution<float> position(0, set.range);
+    std::uniform_real_distribution<float> offset(-0.1, 0.1);
+    std::vector<float>                    x(3 * set.numAtoms);
+    for (int i = 0; i < set.numAtoms; ++i)
+    {
+        for (int d = 0; d < 3; ++d)
+        {
+            if (set.waterLike && i % 3 != 0)
+            {
+                x[3 * i + d] = x[3 * (i - i % 3) + d] + offset(rng);
+            }
+            else
+            {
+                x[3 * i + d] = position(rng);
+            }
+        }
+    }
+    return x;
+}
+
+//! Number of frames written per coordinate set.
+const int c_numFrames = 4;
+
+//! Test fixture that compresses a set of coordinates to a temporary file.
+class XdrCoordinateDecoderTest : public ::testing::TestWithParam<CoordinateSet>
+{
+public:
+    XdrCoordinateDecoderTest() : fileName_(fileManager_.getTemporaryFilePath("coords.xtc")) {}
+
+    /*! \brief
+     * Writes all frames and reads them back with \p decoder.
+     *
+     * Returns the concatenated decoded coordinates.
+     */
+    std::vector<float> writeAndRead(int (*decoder)(XDR*, float*, int*, float*))
+    {
+        const CoordinateSet& set = GetParam();
+        t_fileio*            fio = gmx_fio_open(fileName_.c_str(), "w");
+        for (int frame = 0; frame < c_numFrames; ++frame)
+        {
+            std::vector<float> x         = generateCoordinates(set, frame);
+            int                size      = set.numAtoms;
+            float              precision = set.precision;
+            EXPECT_NE(0, xdr3dfcoord(gmx_fio_getxdr(fio), x.data(), &size, &precision));
+        }
+        gmx_fio_close(fio);
+
+        std::vector<float> result(c_numFrames * 3 * set.numAtoms);
+        fio = gmx_fio_open(fileName_.c_str(), "r");
+        for (int frame = 0; frame < c_numFrames; ++frame)
+        {
+            int   size      = set.numAtoms;
+            float precision = 0;
+            EXPECT_NE(0, decoder(gmx_fio_getxdr(fio), &result[frame * 3 * set.numAtoms], &size,
+                                 &precision));
+            EXPECT_EQ(set.numAtoms, size);
+        }
+        gmx_fio_close(fio);
+        return result;
+    }
+
+    TestFileManager   fileManager_;
+    const std::string fileName_;
+};
+
+TEST_P(XdrCoordinateDecoderTest, DecodersAgreeBitwise)
+{
+    const std::vector<float> reference = writeAndRead(xdr3dfcoord_reference);
+    const std::vector<float> fast      = writeAndRead(xdr3dfcoord);
+    ASSERT_EQ(reference.size(), fast.size());
+    for (size_t i = 0; i < reference.size(); ++i)
+    {
+        // Both decoders compute the same integers, so the results are identical.
+        ASSERT_EQ(reference[i], fast[i]) << "at coordinate " << i;
+    }
+}
+
+TEST_P(XdrCoordinateDecoderTest, DecodesWithinPrecision)
+{
+    const CoordinateSet&     set     = GetParam();
+    const std::vector<float> decoded = writeAndRead(xdr3dfcoord);
+    // Allow for rounding to the precision and for the float resolution of large coordinates.
+    const float tolerance = 0.5F / set.precision + 1e-6F * set.range;
+    for (int frame = 0; frame < c_numFrames; ++frame)
+    {
+        const std::vector<float> x = generateCoordinates(set, frame);
+        for (int i = 0; i < 3 * set.numAtoms; ++i)
+        {
+            EXPECT_NEAR(x[i], decoded[frame * 3 * set.numAtoms + i], tolerance)
+                    << "at coordinate " << i << " in frame " << frame;
+        }
+    }
+}
+
+//! Coordinate sets covering the different code paths of the decoder.
+const CoordinateSet c_coordinateSets[] = {
+    { "Uncompressed", 9, 3, 1000, false },
+    { "Water", 3000, 5, 1000, true },
+    { "WaterHighPrecision", 999, 5, 100000, true },
+    { "Random", 1000, 10, 1000, false },
+    // Three ranges of more than 2^21 values need more than 64 bits.
+    { "WideRange", 200, 4000, 1000, false },
+    // Ranges beyond 2^24 values are stored per dimension.
+    { "HugeRange", 200, 40000, 1000, false },
+};
+
+INSTANTIATE_TEST_CASE_P(XdrCoordinates,
+                        XdrCoordinateDecoderTest,
+                        ::testing::ValuesIn(c_coordinateSets));
+
+} // namespace
+} // namespace test
+} // namespace gmx
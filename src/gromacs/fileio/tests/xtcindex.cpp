@@ -0,0 +1,204 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2020, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Tests for the XTC frame index.
+ *
+ * \ingroup module_fileio
+ */
+#include "gmxpre.h"
+
+#include "gromacs/fileio/xtcindex.h"
+
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "gromacs/fileio/gmxfio.h"
+#include "gromacs/fileio/oenv.h"
+#include "gromacs/fileio/trxio.h"
+#include "gromacs/fileio/xtcio.h"
+#include "gromacs/math/vec.h"
+#include "gromacs/trajectory/trajectoryframe.h"
+#include "gromacs/utility/smalloc.h"
+
+#include "testutils/testfilemanager.h"
+
+namespace gmx
+{
+namespace test
+{
+namespace
+{
+
+//! Number of frames written to the test trajectories.
+const int c_numFrames = 5;
+
+/*! \brief
+ * Test fixture that writes an XTC file, with the number of atoms as parameter.
+ *
+ * Systems with at most nine atoms are stored uncompressed, so both
+ * storage formats are covered.
+ */
+class XtcFrameIndexTest : public ::testing::TestWithParam<int>
+{
+public:
+    XtcFrameIndexTest() :
+        xtcFileName_(fileManager_.getTemporaryFilePath("traj.xtc")),
+        indexFileName_(fileManager_.getTemporaryFilePath("traj.xtc.idx"))
+    {
+        writeFrames("w", 0, c_numFrames);
+    }
+
+    //! Writes frames \p first to \p last-1, opening the file with \p mode.
+    void writeFrames(const char* mode, int first, int last)
+    {
+        const int         natoms = GetParam();
+        std::vector<RVec> x(natoms);
+        matrix            box = { { 3, 0, 0 }, { 0, 3, 0 }, { 0, 0, 3 } };
+        t_fileio*         fio = open_xtc(xtcFileName_.c_str(), mode);
+        for (int frame = first; frame < last; ++frame)
+        {
+            for (int i = 0; i < natoms; ++i)
+            {
+                // Vary the coordinates so that the compressed frames differ in size.
+                x[i] = { 0.1F * i, 0.01F * i * frame, 0.001F * i * i * (frame + 1) };
+            }
+            write_xtc(fio, natoms, 10 * frame, 0.5 * frame, box, as_rvec_array(x.data()), 1000);
+        }
+        close_xtc(fio);
+    }
+
+    TestFileManager   fileManager_;
+    const std::string xtcFileName_;
+    const std::string indexFileName_;
+};
+
+TEST_P(XtcFrameIndexTest, IndexesAllFrames)
+{
+    const XtcFrameIndex index = XtcFrameIndex::build(xtcFileName_);
+    ASSERT_EQ(c_numFrames, index.frameCount());
+    EXPECT_GT(index.fileSize(), 0);
+    EXPECT_EQ(0, index.frames()[0].offset);
+
+    // Every indexed offset must be the start of the corresponding frame.
+    t_fileio* fio = open_xtc(xtcFileName_.c_str(), "r");
+    rvec*     x;
+    snew(x, GetParam());
+    for (int frame = 0; frame < c_numFrames; ++frame)
+    {
+        const XtcFrameIndexEntry& entry = index.frames()[frame];
+        EXPECT_EQ(GetParam(), entry.natoms);
+        EXPECT_EQ(10 * frame, entry.step);
+        EXPECT_EQ(0.5 * frame, entry.time);
+
+        ASSERT_EQ(0, gmx_fio_seek(fio, entry.offset));
+        int64_t  step;
+        real     time;
+        matrix   box;
+        real     prec;
+        gmx_bool bOK;
+        ASSERT_NE(0, read_next_xtc(fio, GetParam(), &step, &time, box, x, &prec, &bOK));
+        EXPECT_EQ(entry.step, step);
+        EXPECT_EQ(entry.time, time);
+    }
+    sfree(x);
+    close_xtc(fio);
+
+    EXPECT_EQ(2, index.findFrameAtTime(1.0));
+    EXPECT_EQ(3, index.findFrameAtTime(1.2));
+    EXPECT_EQ(4, index.findFrameAtTime(0.0, 4));
+    EXPECT_EQ(-1, index.findFrameAtTime(2.1));
+}
+
+TEST_P(XtcFrameIndexTest, RoundTripsThroughSidecarFile)
+{
+    ASSERT_EQ(indexFileName_, xtcFrameIndexFileName(xtcFileName_));
+    EXPECT_EQ(nullptr, loadXtcFrameIndex(xtcFileName_));
+
+    const XtcFrameIndex index = XtcFrameIndex::build(xtcFileName_);
+    index.write(indexFileName_);
+    const auto loaded = loadXtcFrameIndex(xtcFileName_);
+    ASSERT_NE(nullptr, loaded);
+    EXPECT_EQ(index.fileSize(), loaded->fileSize());
+    ASSERT_EQ(index.frameCount(), loaded->frameCount());
+    for (int frame = 0; frame < index.frameCount(); ++frame)
+    {
+        EXPECT_EQ(index.frames()[frame].offset, loaded->frames()[frame].offset);
+        EXPECT_EQ(index.frames()[frame].step, loaded->frames()[frame].step);
+        EXPECT_EQ(index.frames()[frame].time, loaded->frames()[frame].time);
+        EXPECT_EQ(index.frames()[frame].natoms, loaded->frames()[frame].natoms);
+    }
+}
+
+TEST_P(XtcFrameIndexTest, IsInvalidatedByAppendingFrames)
+{
+    XtcFrameIndex::build(xtcFileName_).write(indexFileName_);
+    writeFrames("a", c_numFrames, c_numFrames + 1);
+    EXPECT_EQ(nullptr, loadXtcFrameIndex(xtcFileName_));
+    EXPECT_EQ(c_numFrames + 1, XtcFrameIndex::build(xtcFileName_).frameCount());
+}
+
+TEST_P(XtcFrameIndexTest, SeeksToFramesWhenReading)
+{
+    XtcFrameIndex::build(xtcFileName_).write(indexFileName_);
+
+    gmx_output_env_t* oenv;
+    output_env_init_default(&oenv);
+    t_trxstatus* status;
+    t_trxframe   fr;
+    ASSERT_TRUE(read_first_frame(oenv, &status, xtcFileName_.c_str(), &fr, TRX_NEED_X));
+    EXPECT_EQ(0, fr.step);
+    EXPECT_EQ(0.5 * (c_numFrames - 1), trx_get_time_of_final_frame(status));
+
+    ASSERT_TRUE(trx_seek_frame(status, 3));
+    ASSERT_TRUE(read_next_frame(oenv, status, &fr));
+    EXPECT_EQ(30, fr.step);
+    ASSERT_TRUE(trx_seek_frame(status, 1));
+    ASSERT_TRUE(read_next_frame(oenv, status, &fr));
+    EXPECT_EQ(10, fr.step);
+    EXPECT_FALSE(trx_seek_frame(status, c_numFrames));
+
+    close_trx(status);
+    done_frame(&fr);
+    output_env_done(oenv);
+}
+
+INSTANTIATE_TEST_CASE_P(CompressedAndUncompressed, XtcFrameIndexTest, ::testing::Values(3, 20));
+
+} // namespace
+} // namespace test
+} // namespace gmx
@@ -0,0 +1,467 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2021, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Implements gmx::TrrMappedFile.
+ *
+ * \ingroup module_fileio
+ */
+#include "gmxpre.h"
+
+#include "trrmap.h"
+
+#include "config.h"
+
+#include <cstdio>
+#include <cstring>
+
+#include <algorithm>
+#include <vector>
+
+#if !GMX_NATIVE_WINDOWS
+#    include <fcntl.h>
+#    include <sys/mman.h>
+#    include <sys/stat.h>
+#    include <unistd.h>
+#endif
+
+#include "gromacs/utility/exceptions.h"
+#include "gromacs/utility/stringutil.h"
+
+namespace gmx
+{
+
+namespace
+{
+
+//! Magic number at the start of each TRR frame.
+const int c_trrMagic = 1993;
+
+//! Returns the big-endian 32-bit word at \p p.
+inline uint32_t readXdrWord32(const unsigned char* p)
+{
+    return (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | uint32_t(p[3]);
+}
+
+//! Returns the XDR value of type \p T stored at \p p.
+template<typename T>
+T readXdrValue(const unsigned char* p);
+
+//! Returns the XDR int stored at \p p.
+template<>
+int readXdrValue<int>(const unsigned char* p)
+{
+    return static_cast<int32_t>(readXdrWord32(p));
+}
+
+//! Returns the XDR float stored at \p p.
+template<>
+float readXdrValue<float>(const unsigned char* p)
+{
+    const uint32_t word = readXdrWord32(p);
+    float          value;
+    std::memcpy(&value, &word, sizeof(value));
+    return value;
+}
+
+//! Returns the XDR double stored at \p p.
+template<>
+double readXdrValue<double>(const unsigned char* p)
+{
+    const uint64_t word = (uint64_t(readXdrWord32(p)) << 32) | readXdrWord32(p + 4);
+    double         value;
+    std::memcpy(&value, &word, sizeof(value));
+    return value;
+}
+
+/*! \brief
+ * Converts \p n XDR values of type \p T at \p src to real.
+ *
+ * The elements are independent, so compilers turn the byte assembly
+ * into vector byte shuffles.
+ */
+template<typename T>
+void convertXdrArray(const unsigned char* src, real* dest, std::size_t n)
+{
+    for (std::size_t i = 0; i < n; i++)
+    {
+        dest[i] = static_cast<real>(readXdrValue<T>(src + i * sizeof(T)));
+    }
+}
+
+//! Arrays stored in a TRR frame, in file order.
+enum class TrrSection : int
+{
+    Box,
+    Virial,
+    Pressure,
+    X,
+    V,
+    F,
+    Count
+};
+
+//! Returns the number of bytes of \p section in a frame with \p header.
+int sectionSize(const gmx_trr_header_t& header, TrrSection section)
+{
+    switch (section)
+    {
+        case TrrSection::Box: return header.box_size;
+        case TrrSection::Virial: return header.vir_size;
+        case TrrSection::Pressure: return header.pres_size;
+        case TrrSection::X: return header.x_size;
+        case TrrSection::V: return header.v_size;
+        case TrrSection::F: return header.f_size;
+        default: GMX_THROW(InternalError("Invalid TRR section"));
+    }
+}
+
+//! Returns the byte offset in the file of \p section of \p frame.
+int64_t sectionOffset(const TrrMappedFrame& frame, TrrSection section)
+{
+    int64_t offset = frame.dataOffset;
+    for (int s = 0; s < static_cast<int>(section); s++)
+    {
+        offset += sectionSize(frame.header, static_cast<TrrSection>(s));
+    }
+    return offset;
+}
+
+/*! \brief
+ * Interprets the frame starting at \p offset in \p data of \p size bytes.
+ *
+ * Follows the layout written by gmx_trr_write_frame(). Returns false
+ * when the data is not a complete frame that this reader supports.
+ */
+bool parseFrame(const unsigned char* data, int64_t size, int64_t offset, TrrMappedFrame* frame)
+{
+    int64_t pos     = offset;
+    auto    readInt = [data, size, &pos](int* value) {
+        if (pos + 4 > size)
+        {
+            return false;
+        }
+        *value = readXdrValue<int>(data + pos);
+        pos += 4;
+        return true;
+    };
+
+    /* The version string is stored as its length including the
+     * terminating zero, followed by an XDR string */
+    int magic, stringSize, stringLength;
+    if (!readInt(&magic) || magic != c_trrMagic || !readInt(&stringSize) || !readInt(&stringLength)
+        || stringLength < 0 || stringLength > stringSize)
+    {
+        return false;
+    }
+    pos += (stringLength + 3) / 4 * 4;
+
+    gmx_trr_header_t& sh      = frame->header;
+    int*              sizes[] = { &sh.ir_size,  &sh.e_size,   &sh.box_size, &sh.vir_size,
+                     &sh.pres_size, &sh.top_size, &sh.sym_size, &sh.x_size,
+                     &sh.v_size,    &sh.f_size,   &sh.natoms };
+    for (int* value : sizes)
+    {
+        if (!readInt(value) || *value < 0)
+        {
+            return false;
+        }
+    }
+    /* Frames with other contents are left to the XDR reader, which rejects them */
+    if (sh.ir_size != 0 || sh.e_size != 0 || sh.top_size != 0 || sh.sym_size != 0)
+    {
+        return false;
+    }
+
+    /* Determine the precision as nFloatSize() in trrio.cpp does */
+    int floatSize = 0;
+    if (sh.box_size != 0)
+    {
+        floatSize = sh.box_size / (DIM * DIM);
+    }
+    else if (sh.natoms > 0)
+    {
+        floatSize = std::max({ sh.x_size, sh.v_size, sh.f_size }) / (sh.natoms * DIM);
+    }
+    if (floatSize != sizeof(float) && floatSize != sizeof(double))
+    {
+        return false;
+    }
+    sh.bDouble = (floatSize == sizeof(double));
+
+    const int matrixSize = DIM * DIM * floatSize;
+    const int arraySize  = sh.natoms * DIM * floatSize;
+    for (TrrSection section : { TrrSection::Box, TrrSection::Virial, TrrSection::Pressure })
+    {
+        const int size = sectionSize(sh, section);
+        if (size != 0 && size != matrixSize)
+        {
+            return false;
+        }
+    }
+    for (TrrSection section : { TrrSection::X, TrrSection::V, TrrSection::F })
+    {
+        const int size = sectionSize(sh, section);
+        if (size != 0 && size != arraySize)
+        {
+            return false;
+        }
+    }
+
+    int step;
+    if (!readInt(&step) || !readInt(&sh.nre) || pos + 2 * floatSize > size)
+    {
+        return false;
+    }
+    sh.step = step;
+    if (sh.bDouble)
+    {
+        sh.t      = readXdrValue<double>(data + pos);
+        sh.lambda = readXdrValue<double>(data + pos + floatSize);
+    }
+    else
+    {
+        sh.t      = readXdrValue<float>(data + pos);
+        sh.lambda = readXdrValue<float>(data + pos + floatSize);
+    }
+    sh.fep_state = 0;
+    pos += 2 * floatSize;
+
+    frame->offset     = offset;
+    frame->dataOffset = pos;
+    frame->endOffset  = sectionOffset(*frame, TrrSection::Count);
+    return frame->endOffset <= size;
+}
+
+} // namespace
+
+class TrrMappedFile::Impl
+{
+public:
+    explicit Impl(const std::string& fileName);
+    ~Impl();
+
+    //! Converts \p section of \p frame to real values in \p dest.
+    void convertSection(int frame, TrrSection section, real* dest) const;
+    //! Returns an array section of \p frame, converted into \p buffer when needed.
+    ArrayRef<const RVec> arraySection(int frame, TrrSection section, std::vector<RVec>* buffer) const;
+    //! Returns whether \p frame can be used in place.
+    bool hasNativeLayout(int frame) const;
+
+    //! Start of the file contents.
+    const unsigned char* data_ = nullptr;
+    //! Size of the file in bytes.
+    int64_t size_ = 0;
+    //! Contents of the file when it is read instead of mapped.
+    std::vector<unsigned char> contents_;
+    //! Indexed frames.
+    std::vector<TrrMappedFrame> frames_;
+    //! Buffers for converted arrays.
+    std::vector<RVec> xBuffer_, vBuffer_, fBuffer_;
+};
+
+TrrMappedFile::Impl::Impl(const std::string& fileName)
+{
+#if !GMX_NATIVE_WINDOWS
+    const int fd = open(fileName.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        GMX_THROW(FileIOError(formatString("Could not open TRR file '%s'", fileName.c_str())));
+    }
+    struct stat fileStatus;
+    if (fstat(fd, &fileStatus) != 0)
+    {
+        close(fd);
+        GMX_THROW(FileIOError(formatString("Could not determine the size of '%s'", fileName.c_str())));
+    }
+    size_ = fileStatus.st_size;
+    if (size_ > 0)
+    {
+        void* mapping = mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+        if (mapping == MAP_FAILED)
+        {
+            close(fd);
+            GMX_THROW(FileIOError(formatString("Could not map TRR file '%s'", fileName.c_str())));
+        }
+        /* Frames are usually read in order */
+        posix_madvise(mapping, size_, POSIX_MADV_SEQUENTIAL);
+        data_ = static_cast<const unsigned char*>(mapping);
+    }
+    close(fd);
+#else
+    FILE* fp = std::fopen(fileName.c_str(), "rb");
+    if (fp == nullptr)
+    {
+        GMX_THROW(FileIOError(formatString("Could not open TRR file '%s'", fileName.c_str())));
+    }
+    unsigned char buffer[65536];
+    std::size_t   count;
+    while ((count = std::fread(buffer, 1, sizeof(buffer), fp)) > 0)
+    {
+        contents_.insert(contents_.end(), buffer, buffer + count);
+    }
+    std::fclose(fp);
+    data_ = contents_.data();
+    size_ = contents_.size();
+#endif
+
+    TrrMappedFrame frame;
+    int64_t        offset = 0;
+    while (offset < size_ && parseFrame(data_, size_, offset, &frame))
+    {
+        frames_.push_back(frame);
+        offset = frame.endOffset;
+    }
+}
+
+TrrMappedFile::Impl::~Impl()
+{
+#if !GMX_NATIVE_WINDOWS
+    if (data_ != nullptr)
+    {
+        munmap(const_cast<unsigned char*>(data_), size_);
+    }
+#endif
+}
+
+bool TrrMappedFile::Impl::hasNativeLayout(int frame) const
+{
+    /* XDR stores big-endian IEEE values */
+    return GMX_INTEGER_BIG_ENDIAN && (frames_[frame].header.bDouble == bool(GMX_DOUBLE));
+}
+
+void TrrMappedFile::Impl::convertSection(int frame, TrrSection section, real* dest) const
+{
+    const TrrMappedFrame& mappedFrame = frames_[frame];
+    const unsigned char*  src         = data_ + sectionOffset(mappedFrame, section);
+    const std::size_t     numValues =
+            (section == TrrSection::Box ? DIM * DIM : std::size_t(DIM) * mappedFrame.header.natoms);
+    if (mappedFrame.header.bDouble)
+    {
+        convertXdrArray<double>(src, dest, numValues);
+    }
+    else
+    {
+        convertXdrArray<float>(src, dest, numValues);
+    }
+}
+
+ArrayRef<const RVec> TrrMappedFile::Impl::arraySection(int frame, TrrSection section, std::vector<RVec>* buffer) const
+{
+    const TrrMappedFrame& mappedFrame = frames_[frame];
+    if (sectionSize(mappedFrame.header, section) == 0)
+    {
+        return {};
+    }
+    const unsigned char* src = data_ + sectionOffset(mappedFrame, section);
+    if (hasNativeLayout(frame) && reinterpret_cast<std::uintptr_t>(src) % alignof(RVec) == 0)
+    {
+        const RVec* begin = reinterpret_cast<const RVec*>(src);
+        return { begin, begin + mappedFrame.header.natoms };
+    }
+    buffer->resize(mappedFrame.header.natoms);
+    convertSection(frame, section, as_rvec_array(buffer->data())[0]);
+    return *buffer;
+}
+
+TrrMappedFile::TrrMappedFile(const std::string& trrFileName) : impl_(new Impl(trrFileName)) {}
+
+TrrMappedFile::~TrrMappedFile() {}
+
+int TrrMappedFile::frameCount() const
+{
+    return static_cast<int>(impl_->frames_.size());
+}
+
+ArrayRef<const TrrMappedFrame> TrrMappedFile::frames() const
+{
+    return impl_->frames_;
+}
+
+int TrrMappedFile::frameAtOffset(int64_t offset) const
+{
+    const auto& frames = impl_->frames_;
+    const auto  it     = std::lower_bound(
+            frames.begin(), frames.end(), offset,
+            [](const TrrMappedFrame& frame, int64_t value) { return frame.offset < value; });
+    if (it == frames.end() || it->offset != offset)
+    {
+        return -1;
+    }
+    return static_cast<int>(it - frames.begin());
+}
+
+bool TrrMappedFile::hasNativeLayout(int frame) const
+{
+    return impl_->hasNativeLayout(frame);
+}
+
+ArrayRef<const RVec> TrrMappedFile::x(int frame)
+{
+    return impl_->arraySection(frame, TrrSection::X, &impl_->xBuffer_);
+}
+
+ArrayRef<const RVec> TrrMappedFile::v(int frame)
+{
+    return impl_->arraySection(frame, TrrSection::V, &impl_->vBuffer_);
+}
+
+ArrayRef<const RVec> TrrMappedFile::f(int frame)
+{
+    return impl_->arraySection(frame, TrrSection::F, &impl_->fBuffer_);
+}
+
+void TrrMappedFile::readFrame(int frame, rvec* box, rvec* x, rvec* v, rvec* f) const
+{
+    const gmx_trr_header_t& header = impl_->frames_[frame].header;
+    if (box != nullptr && header.box_size != 0)
+    {
+        impl_->convertSection(frame, TrrSection::Box, box[0]);
+    }
+    if (x != nullptr && header.x_size != 0)
+    {
+        impl_->convertSection(frame, TrrSection::X, x[0]);
+    }
+    if (v != nullptr && header.v_size != 0)
+    {
+        impl_->convertSection(frame, TrrSection::V, v[0]);
+    }
+    if (f != nullptr && header.f_size != 0)
+    {
+        impl_->convertSection(frame, TrrSection::F, f[0]);
+    }
+}
+
+} // namespace gmx
@@ -0,0 +1,136 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2021, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \libinternal \file
+ * \brief
+ * Declares gmx::TrrMappedFile for reading TRR frames from a memory mapping.
+ *
+ * TRR frames store uncompressed XDR arrays, so the coordinates,
+ * velocities and forces of a frame can be used directly from a mapping
+ * of the file when the byte order and precision match those of the
+ * host, and otherwise be converted in a single pass over each array.
+ * read_next_frame() uses the mapping for TRR files automatically.
+ *
+ * \inlibraryapi
+ * \ingroup module_fileio
+ */
+#ifndef GMX_FILEIO_TRRMAP_H
+#define GMX_FILEIO_TRRMAP_H
+
+#include <cstdint>
+
+#include <string>
+
+#include "gromacs/fileio/trrio.h"
+#include "gromacs/math/vectypes.h"
+#include "gromacs/utility/arrayref.h"
+#include "gromacs/utility/classhelpers.h"
+
+namespace gmx
+{
+
+//! Header and location of one frame of a TRR file.
+struct TrrMappedFrame
+{
+    //! The frame header.
+    gmx_trr_header_t header;
+    //! Byte offset of the frame header in the file.
+    int64_t offset;
+    //! Byte offset of the frame data, which follows the header.
+    int64_t dataOffset;
+    //! Byte offset just after the frame.
+    int64_t endOffset;
+};
+
+/*! \libinternal \brief
+ * Memory-mapped TRR file with an index of its frame headers.
+ *
+ * The headers of all frames are indexed when the file is opened.
+ * Indexing stops at the first header that can not be interpreted and
+ * at an incomplete last frame; such data is left to the XDR reader,
+ * which reports the errors. Frames appended after opening the file are
+ * not indexed.
+ *
+ * The array accessors return a view into the mapping when the data can
+ * be used as is, i.e., on big-endian hosts for files with the precision
+ * of real. Otherwise the array is converted into a buffer owned by the
+ * object, which is overwritten by the next call for the same array.
+ *
+ * \inlibraryapi
+ * \ingroup module_fileio
+ */
+class TrrMappedFile
+{
+public:
+    /*! \brief
+     * Maps \p trrFileName and indexes its frames.
+     *
+     * \throws FileIOError if the file can not be opened or mapped.
+     */
+    explicit TrrMappedFile(const std::string& trrFileName);
+    ~TrrMappedFile();
+
+    //! Returns the number of indexed frames.
+    int frameCount() const;
+    //! Returns the indexed frames.
+    ArrayRef<const TrrMappedFrame> frames() const;
+    //! Returns the indexed frame whose header starts at \p offset, or -1 if there is none.
+    int frameAtOffset(int64_t offset) const;
+    //! Returns whether the arrays of \p frame are used without conversion.
+    bool hasNativeLayout(int frame) const;
+
+    //! Returns the coordinates of \p frame, empty when the frame has none.
+    ArrayRef<const RVec> x(int frame);
+    //! Returns the velocities of \p frame, empty when the frame has none.
+    ArrayRef<const RVec> v(int frame);
+    //! Returns the forces of \p frame, empty when the frame has none.
+    ArrayRef<const RVec> f(int frame);
+
+    /*! \brief
+     * Copies the data present in \p frame into the arrays passed.
+     *
+     * Data is not copied into arrays passed as nullptr, or when the
+     * frame does not contain it; as gmx_trr_read_frame_data() does.
+     */
+    void readFrame(int frame, rvec* box, rvec* x, rvec* v, rvec* f) const;
+
+private:
+    class Impl;
+
+    PrivateImplPointer<Impl> impl_;
+};
+
+} // namespace gmx
+
+#endif
@@ -43,8 +43,16 @@
 
 #include <cassert>
 #include <cmath>
+#include <cstdlib>
 #include <cstring>
 
+#include <algorithm>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
 #include "gromacs/fileio/checkpoint.h"
 #include "gromacs/fileio/confio.h"
 #include "gromacs/fileio/filetypes.h"
@@ -58,7 +66,9 @@
 #include "gromacs/fileio/tngio.h"
 #include "gromacs/fileio/tpxio.h"
 #include "gromacs/fileio/trrio.h"
+#include "gromacs/fileio/trrmap.h"
 #include "gromacs/fileio/xdrf.h"
+#include "gromacs/fileio/xtcindex.h"
 #include "gromacs/fileio/xtcio.h"
 #include "gromacs/math/vec.h"
 #include "gromacs/mdtypes/md_enums.h"
@@ -66,6 +76,7 @@
 #include "gromacs/topology/symtab.h"
 #include "gromacs/topology/topology.h"
 #include "gromacs/trajectory/trajectoryframe.h"
+#include "gromacs/utility/exceptions.h"
 #include "gromacs/utility/fatalerror.h"
 #include "gromacs/utility/futil.h"
 #include "gromacs/utility/gmxassert.h"
@@ -75,6 +86,11 @@
 #    include "gromacs/fileio/vmdio.h"
 #endif
 
+namespace gmx
+{
+class TrxPrefetcher;
+} // namespace gmx
+
 /* defines for frame counter output */
 #define SKIP1 10
 #define SKIP2 100
@@ -94,6 +110,12 @@ struct t_trxstatus
     double               DT, BOX[3];
     gmx_bool             bReadBox;
     char*                persistent_line; /* Persistent line for reading g96 trajectories */
+    gmx::XtcFrameIndex*  xtcIndex;        /* Frame index of an XTC file, NULL if none   */
+    gmx::XtcFrameIndex*  xtcIndexBuilder; /* Index assembled while reading sequentially */
+    int                  xtcFrame;        /* Number of the next XTC frame to read       */
+    int                  prefetchDepth;   /* Number of frames to read ahead             */
+    gmx::TrxPrefetcher*  prefetcher;      /* Frames read ahead, NULL if none            */
+    gmx::TrrMappedFile*  trrMap;          /* Mapping of a TRR file, NULL if none        */
 #if GMX_USE_PLUGINS
     gmx_vmdplugin_t* vmdplugin;
 #endif
@@ -167,6 +189,73 @@ static void status_init(t_trxstatus* status)
     status->tf              = 0;
     status->persistent_line = nullptr;
     status->tng             = nullptr;
+    status->xtcIndex        = nullptr;
+    status->xtcIndexBuilder = nullptr;
+    status->xtcFrame        = 0;
+    status->prefetchDepth   = 0;
+    status->prefetcher      = nullptr;
+    status->trrMap          = nullptr;
+}
+
+static void trx_prefetch_stop(t_trxstatus* status, gmx_bool bDiscard);
+static void trx_prefetch_done(t_trxstatus* status);
+
+/* Stop assembling an XTC frame index, e.g., because frames were skipped */
+static void xtc_index_builder_done(t_trxstatus* status)
+{
+    delete status->xtcIndexBuilder;
+    status->xtcIndexBuilder = nullptr;
+}
+
+/* Read an XTC frame, keeping track of the frame number and of the frame
+ * offsets for a sidecar index when it is being assembled.
+ * When the end of the file is reached cleanly after reading all frames
+ * sequentially, the assembled index is written to the sidecar file.
+ */
+static int read_xtc_frame(t_trxstatus* status, t_trxframe* fr, gmx_bool bFirst, gmx_bool* bOK)
+{
+    const gmx_off_t offset = gmx_fio_ftell(status->fio);
+    int             ret;
+    if (bFirst)
+    {
+        ret = read_first_xtc(status->fio, &fr->natoms, &fr->step, &fr->time, fr->box, &fr->x,
+                             &fr->prec, bOK);
+    }
+    else
+    {
+        ret = read_next_xtc(status->fio, fr->natoms, &fr->step, &fr->time, fr->box, fr->x,
+                            &fr->prec, bOK);
+    }
+    if (ret != 0)
+    {
+        if (status->xtcIndexBuilder && status->xtcFrame == status->xtcIndexBuilder->frameCount())
+        {
+            status->xtcIndexBuilder->addFrame({ offset, fr->step, fr->time, fr->natoms });
+        }
+        status->xtcFrame++;
+    }
+    else if (status->xtcIndexBuilder)
+    {
+        if (*bOK && status->xtcFrame == status->xtcIndexBuilder->frameCount())
+        {
+            const char* fn = gmx_fio_getname(status->fio);
+            status->xtcIndexBuilder->setFileSize(offset);
+            if (status->xtcIndexBuilder->isValidFor(fn))
+            {
+                try
+                {
+                    status->xtcIndexBuilder->write(gmx::xtcFrameIndexFileName(fn));
+                }
+                catch (const gmx::FileIOError&)
+                {
+                    /* The index is only an optimization, e.g., the
+                     * directory may be read-only */
+                }
+            }
+        }
+        xtc_index_builder_done(status);
+    }
+    return ret;
 }
 
 
@@ -230,17 +319,25 @@ real ndec2prec(int ndec)
 
 t_fileio* trx_get_fileio(t_trxstatus* status)
 {
+    /* The caller expects the file to be positioned after the last frame
+     * returned by read_next_frame */
+    trx_prefetch_stop(status, TRUE);
     return status->fio;
 }
 
 float trx_get_time_of_final_frame(t_trxstatus* status)
 {
-    t_fileio* stfio    = trx_get_fileio(status);
+    trx_prefetch_stop(status, FALSE);
+    t_fileio* stfio    = status->fio;
     int       filetype = gmx_fio_getftp(stfio);
     gmx_bool  bOK;
     float     lasttime = -1;
 
-    if (filetype == efXTC)
+    if (filetype == efXTC && status->xtcIndex && status->xtcIndex->frameCount() > 0)
+    {
+        lasttime = status->xtcIndex->frames().back().time;
+    }
+    else if (filetype == efXTC)
     {
         lasttime = xdr_xtc_get_last_frame_time(gmx_fio_getfp(stfio), gmx_fio_getxdr(stfio),
                                                status->natoms, &bOK);
@@ -265,6 +362,38 @@ float trx_get_time_of_final_frame(t_trxstatus* status)
     return lasttime;
 }
 
+/* Position an XTC file at frame number frame, returns FALSE when it does not exist */
+static gmx_bool xtc_seek_frame_indexed(t_trxstatus* status, int frame)
+{
+    if (!status->xtcIndex)
+    {
+        status->xtcIndex = new gmx::XtcFrameIndex(gmx::XtcFrameIndex::build(gmx_fio_getname(status->fio)));
+    }
+    if (frame < 0 || frame >= status->xtcIndex->frameCount()
+        || gmx_fio_seek(status->fio, status->xtcIndex->frames()[frame].offset) != 0)
+    {
+        return FALSE;
+    }
+    status->xtcFrame = frame;
+    xtc_index_builder_done(status);
+    return TRUE;
+}
+
+gmx_bool trx_seek_frame(t_trxstatus* status, int frame)
+{
+    if (status->tng || gmx_fio_getftp(status->fio) != efXTC)
+    {
+        gmx_incons("Seeking to a frame is only supported for XTC");
+    }
+    trx_prefetch_stop(status, TRUE);
+    if (!xtc_seek_frame_indexed(status, frame))
+    {
+        return FALSE;
+    }
+    initcount(status);
+    return TRUE;
+}
+
 void clear_trxframe(t_trxframe* fr, gmx_bool bFirst)
 {
     fr->not_ok    = 0;
@@ -598,11 +727,15 @@ void close_trx(t_trxstatus* status)
     {
         return;
     }
+    trx_prefetch_done(status);
     gmx_tng_close(&status->tng);
     if (status->fio)
     {
         gmx_fio_close(status->fio);
     }
+    delete status->xtcIndex;
+    delete status->xtcIndexBuilder;
+    delete status->trrMap;
     sfree(status->persistent_line);
 #if GMX_USE_PLUGINS
     sfree(status->vmdplugin);
@@ -633,10 +766,23 @@ static gmx_bool gmx_next_frame(t_trxstatus* status, t_trxframe* fr)
 {
     gmx_trr_header_t sh;
     gmx_bool         bOK, bRet;
+    int              mappedFrame = -1;
 
     bRet = FALSE;
 
-    if (gmx_trr_read_frame_header(status->fio, &sh, &bOK))
+    /* Frames that are in the mapping of the file are converted from
+     * there, others, e.g., appended after opening, are read with XDR.
+     */
+    if (status->trrMap)
+    {
+        mappedFrame = status->trrMap->frameAtOffset(gmx_fio_ftell(status->fio));
+    }
+    if (mappedFrame >= 0)
+    {
+        sh  = status->trrMap->frames()[mappedFrame].header;
+        bOK = TRUE;
+    }
+    if (mappedFrame >= 0 || gmx_trr_read_frame_header(status->fio, &sh, &bOK))
     {
         fr->bDouble   = sh.bDouble;
         fr->natoms    = sh.natoms;
@@ -672,7 +818,13 @@ static gmx_bool gmx_next_frame(t_trxstatus* status, t_trxframe* fr)
             }
             fr->bF = sh.f_size > 0;
         }
-        if (gmx_trr_read_frame_data(status->fio, &sh, fr->box, fr->x, fr->v, fr->f))
+        if (mappedFrame >= 0)
+        {
+            status->trrMap->readFrame(mappedFrame, fr->box, fr->x, fr->v, fr->f);
+            gmx_fio_seek(status->fio, status->trrMap->frames()[mappedFrame].endOffset);
+            bRet = TRUE;
+        }
+        else if (gmx_trr_read_frame_data(status->fio, &sh, fr->box, fr->x, fr->v, fr->f))
         {
             bRet = TRUE;
         }
@@ -767,13 +919,398 @@ static int pdb_first_x(t_trxstatus* status, FILE* fp, t_trxframe* fr)
     return fr->natoms;
 }
 
+/* Read the next frame from the file without any selection of frames.
+ * tPrevious is the time of the previously read frame, which is used
+ * to seek to the starting time in XTC files. bRestartCount is set when
+ * the frame counter should be reset because the file was repositioned.
+ */
+static bool read_frame_data(t_trxstatus* status, t_trxframe* fr, real tPrevious, gmx_bool* bRestartCount)
+{
+    gmx_bool bOK;
+    bool     bRet = false;
+    int      ftp;
+
+    if (status->tng)
+    {
+        /* Special treatment for TNG files */
+        ftp = efTNG;
+    }
+    else
+    {
+        ftp = gmx_fio_getftp(status->fio);
+    }
+    switch (ftp)
+    {
+        case efTRR: bRet = gmx_next_frame(status, fr); break;
+        case efCPT:
+            /* Checkpoint files can not contain mulitple frames */
+            break;
+        case efG96:
+        {
+            t_symtab* symtab = nullptr;
+            read_g96_conf(gmx_fio_getfp(status->fio), nullptr, nullptr, fr, symtab,
+                          status->persistent_line);
+            bRet = (fr->natoms > 0);
+            break;
+        }
+        case efXTC:
+            if (bTimeSet(TBEGIN) && (tPrevious < rTimeValue(TBEGIN)))
+            {
+                gmx_bool bFound;
+                if (status->xtcIndex)
+                {
+                    /* With an index, the seek is a single positioning */
+                    const int frame = status->xtcIndex->findFrameAtTime(rTimeValue(TBEGIN),
+                                                                        status->xtcFrame);
+                    bFound          = (frame >= 0 && xtc_seek_frame_indexed(status, frame));
+                }
+                else
+                {
+                    bFound = (xtc_seek_time(status->fio, rTimeValue(TBEGIN), fr->natoms, TRUE) == 0);
+                    /* The frame number is not known after bisecting the file */
+                    xtc_index_builder_done(status);
+                }
+                if (!bFound)
+                {
+                    gmx_fatal(FARGS,
+                              "Specified frame (time %f) doesn't exist or file "
+                              "corrupt/inconsistent.",
+                              rTimeValue(TBEGIN));
+                }
+                *bRestartCount = TRUE;
+            }
+            bRet = (read_xtc_frame(status, fr, FALSE, &bOK) != 0);
+            fr->bPrec = (bRet && fr->prec > 0);
+            fr->bStep = bRet;
+            fr->bTime = bRet;
+            fr->bX    = bRet;
+            fr->bBox  = bRet;
+            if (!bOK)
+            {
+                /* Actually the header could also be not ok,
+                   but from bOK from read_next_xtc this can't be distinguished */
+                fr->not_ok = DATA_NOT_OK;
+            }
+            break;
+        case efTNG: bRet = gmx_read_next_tng_frame(status->tng, fr, nullptr, 0); break;
+        case efPDB: bRet = pdb_next_x(status, gmx_fio_getfp(status->fio), fr); break;
+        case efGRO: bRet = gro_next_x_or_v(gmx_fio_getfp(status->fio), fr); break;
+        default:
+#if GMX_USE_PLUGINS
+            bRet = read_next_vmd_frame(status->vmdplugin, fr);
+#else
+            gmx_fatal(FARGS, "DEATH HORROR in read_next_frame ftp=%s,status=%s",
+                      ftp2ext(gmx_fio_getftp(status->fio)), gmx_fio_getname(status->fio));
+#endif
+    }
+
+    return bRet;
+}
+
+/* Return whether frames of the file of status can be read ahead */
+static gmx_bool trx_can_prefetch(t_trxstatus* status)
+{
+    if (status->tng)
+    {
+        return TRUE;
+    }
+    const int ftp = gmx_fio_getftp(status->fio);
+    return (ftp == efXTC || ftp == efTRR);
+}
+
+/* Copy the contents of frame src to the arrays owned by dest */
+static void copy_trxframe_data(const t_trxframe& src, t_trxframe* dest)
+{
+    rvec*    x     = dest->x;
+    rvec*    v     = dest->v;
+    rvec*    f     = dest->f;
+    t_atoms* atoms = dest->atoms;
+    int*     index = dest->index;
+
+    *dest        = src;
+    dest->x      = x;
+    dest->v      = v;
+    dest->f      = f;
+    dest->atoms  = atoms;
+    dest->bIndex = (index != nullptr);
+    dest->index  = index;
+    if (src.bX)
+    {
+        if (dest->x == nullptr)
+        {
+            snew(dest->x, src.natoms);
+        }
+        copy_rvecn(src.x, dest->x, 0, src.natoms);
+    }
+    if (src.bV)
+    {
+        if (dest->v == nullptr)
+        {
+            snew(dest->v, src.natoms);
+        }
+        copy_rvecn(src.v, dest->v, 0, src.natoms);
+    }
+    if (src.bF)
+    {
+        if (dest->f == nullptr)
+        {
+            snew(dest->f, src.natoms);
+        }
+        copy_rvecn(src.f, dest->f, 0, src.natoms);
+    }
+}
+
+namespace gmx
+{
+
+/*! \brief
+ * Reads trajectory frames ahead in a background thread.
+ *
+ * The thread reads and decompresses frames into a ring of frame buffers
+ * while the caller of read_next_frame works on the current frame, and
+ * read_next_frame copies the next ready frame into the frame of the caller.
+ * While the thread runs, only the thread accesses the file. Functions
+ * that use the file directly stop the thread first.
+ */
+class TrxPrefetcher
+{
+public:
+    /*! \brief
+     * Sets up \p depth frame buffers for reading ahead in \p status.
+     *
+     * \p fr is the last frame read, which sets the number of atoms.
+     * The thread is started by the first call to takeFrame().
+     */
+    TrxPrefetcher(t_trxstatus* status, int depth, const t_trxframe& fr);
+    ~TrxPrefetcher();
+
+    /*! \brief
+     * Copies the next frame into \p fr, waiting for it when needed.
+     *
+     * Returns the result of reading the frame, at the end of the file
+     * all later calls return false.
+     */
+    bool takeFrame(t_trxframe* fr, gmx_bool* bRestartCount);
+    //! Stops the thread, the frames already read are kept.
+    void stop();
+    /*! \brief
+     * Stops the thread and drops the frames not yet taken.
+     *
+     * The file is positioned at the first dropped frame, except for
+     * TNG files, which can not be positioned.
+     */
+    void discard();
+
+private:
+    //! Buffer for one frame.
+    struct Slot
+    {
+        //! The frame.
+        t_trxframe frame;
+        //! Return value of reading the frame.
+        bool bRet;
+        //! Whether the frame counter should be reset.
+        gmx_bool bRestartCount;
+        //! File position before reading the frame.
+        gmx_off_t offset;
+        //! XTC frame number before reading the frame.
+        int xtcFrame;
+        //! Exception thrown while reading the frame.
+        std::exception_ptr exception;
+    };
+
+    //! Function run by the thread.
+    void readFrames();
+
+    t_trxstatus*      status_;
+    std::vector<Slot> slots_;
+    //! Index of the next slot to take.
+    int first_ = 0;
+    //! Number of slots read and not yet taken.
+    int numReady_ = 0;
+    //! Whether the last slot read ended the trajectory.
+    bool bEndRead_ = false;
+    //! Whether the thread should stop.
+    bool bStop_ = false;
+    //! Time of the last frame read by the thread.
+    real tPrevious_;
+
+    std::thread             thread_;
+    std::mutex              mutex_;
+    std::condition_variable frameRead_;
+    std::condition_variable slotFreed_;
+};
+
+TrxPrefetcher::TrxPrefetcher(t_trxstatus* status, int depth, const t_trxframe& fr) :
+    status_(status),
+    slots_(depth),
+    tPrevious_(status->tf)
+{
+    for (Slot& slot : slots_)
+    {
+        clear_trxframe(&slot.frame, TRUE);
+        slot.frame.natoms = fr.natoms;
+        /* XTC frames are read into preallocated coordinates */
+        if (fr.x != nullptr)
+        {
+            snew(slot.frame.x, fr.natoms);
+        }
+    }
+}
+
+TrxPrefetcher::~TrxPrefetcher()
+{
+    stop();
+    for (Slot& slot : slots_)
+    {
+        sfree(slot.frame.x);
+        sfree(slot.frame.v);
+        sfree(slot.frame.f);
+    }
+}
+
+void TrxPrefetcher::readFrames()
+{
+    while (true)
+    {
+        int index;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            slotFreed_.wait(lock, [this] { return bStop_ || numReady_ < ssize(slots_); });
+            if (bStop_)
+            {
+                return;
+            }
+            index = (first_ + numReady_) % slots_.size();
+        }
+
+        /* The slot is not accessed by the consumer until it is marked ready */
+        Slot& slot         = slots_[index];
+        slot.offset        = (status_->fio ? gmx_fio_ftell(status_->fio) : 0);
+        slot.xtcFrame      = status_->xtcFrame;
+        slot.bRestartCount = FALSE;
+        slot.exception     = nullptr;
+        clear_trxframe(&slot.frame, FALSE);
+        try
+        {
+            slot.bRet = read_frame_data(status_, &slot.frame, tPrevious_, &slot.bRestartCount);
+        }
+        catch (...)
+        {
+            slot.bRet      = false;
+            slot.exception = std::current_exception();
+        }
+        tPrevious_ = slot.frame.time;
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        numReady_++;
+        bEndRead_ = !slot.bRet;
+        frameRead_.notify_one();
+        if (bEndRead_)
+        {
+            return;
+        }
+    }
+}
+
+bool TrxPrefetcher::takeFrame(t_trxframe* fr, gmx_bool* bRestartCount)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (!thread_.joinable() && !bEndRead_)
+    {
+        thread_ = std::thread([this] { readFrames(); });
+    }
+    frameRead_.wait(lock, [this] { return numReady_ > 0; });
+
+    const Slot& slot = slots_[first_];
+    if (slot.exception)
+    {
+        std::rethrow_exception(slot.exception);
+    }
+    copy_trxframe_data(slot.frame, fr);
+    *bRestartCount = slot.bRestartCount;
+    /* The end of the trajectory stays in the ring */
+    if (slot.bRet)
+    {
+        first_ = (first_ + 1) % slots_.size();
+        numReady_--;
+        slotFreed_.notify_one();
+    }
+    return slot.bRet;
+}
+
+void TrxPrefetcher::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        bStop_ = true;
+    }
+    slotFreed_.notify_one();
+    if (thread_.joinable())
+    {
+        thread_.join();
+    }
+    bStop_ = false;
+}
+
+void TrxPrefetcher::discard()
+{
+    stop();
+    if (numReady_ > 0 && status_->fio)
+    {
+        gmx_fio_seek(status_->fio, slots_[first_].offset);
+        status_->xtcFrame = slots_[first_].xtcFrame;
+        /* The index contains frames that will be read again */
+        xtc_index_builder_done(status_);
+    }
+    first_     = 0;
+    numReady_  = 0;
+    bEndRead_  = false;
+    tPrevious_ = status_->tf;
+}
+
+} // namespace gmx
+
+/* Stop reading ahead, e.g., before the file is used directly. With bDiscard
+ * the frames read ahead are dropped and the file is positioned after the
+ * last frame returned by read_next_frame. Reading ahead resumes with the
+ * next call to read_next_frame.
+ */
+static void trx_prefetch_stop(t_trxstatus* status, gmx_bool bDiscard)
+{
+    if (status->prefetcher)
+    {
+        if (bDiscard)
+        {
+            status->prefetcher->discard();
+        }
+        else
+        {
+            status->prefetcher->stop();
+        }
+    }
+}
+
+/* Stop reading ahead and free the frame buffers */
+static void trx_prefetch_done(t_trxstatus* status)
+{
+    delete status->prefetcher;
+    status->prefetcher = nullptr;
+}
+
+void trx_set_prefetch_depth(t_trxstatus* status, int depth)
+{
+    trx_prefetch_stop(status, TRUE);
+    trx_prefetch_done(status);
+    status->prefetchDepth = std::max(depth, 0);
+}
+
 bool read_next_frame(const gmx_output_env_t* oenv, t_trxstatus* status, t_trxframe* fr)
 {
     real     pt;
     int      ct;
-    gmx_bool bOK, bMissingData = FALSE, bSkip = FALSE;
+    gmx_bool bMissingData = FALSE, bSkip = FALSE, bRestartCount;
     bool     bRet = false;
-    int      ftp;
 
     pt = status->tf;
 
@@ -781,66 +1318,22 @@ bool read_next_frame(const gmx_output_env_t* oenv, t_trxstatus* status, t_trxfra
     {
         clear_trxframe(fr, FALSE);
 
-        if (status->tng)
+        bRestartCount = FALSE;
+        if (status->prefetchDepth > 0 && trx_can_prefetch(status))
         {
-            /* Special treatment for TNG files */
-            ftp = efTNG;
+            if (!status->prefetcher)
+            {
+                status->prefetcher = new gmx::TrxPrefetcher(status, status->prefetchDepth, *fr);
+            }
+            bRet = status->prefetcher->takeFrame(fr, &bRestartCount);
         }
         else
         {
-            ftp = gmx_fio_getftp(status->fio);
+            bRet = read_frame_data(status, fr, status->tf, &bRestartCount);
         }
-        switch (ftp)
+        if (bRestartCount)
         {
-            case efTRR: bRet = gmx_next_frame(status, fr); break;
-            case efCPT:
-                /* Checkpoint files can not contain mulitple frames */
-                break;
-            case efG96:
-            {
-                t_symtab* symtab = nullptr;
-                read_g96_conf(gmx_fio_getfp(status->fio), nullptr, nullptr, fr, symtab,
-                              status->persistent_line);
-                bRet = (fr->natoms > 0);
-                break;
-            }
-            case efXTC:
-                if (bTimeSet(TBEGIN) && (status->tf < rTimeValue(TBEGIN)))
-                {
-                    if (xtc_seek_time(status->fio, rTimeValue(TBEGIN), fr->natoms, TRUE))
-                    {
-                        gmx_fatal(FARGS,
-                                  "Specified frame (time %f) doesn't exist or file "
-                                  "corrupt/inconsistent.",
-                                  rTimeValue(TBEGIN));
-                    }
-                    initcount(status);
-                }
-                bRet = (read_next_xtc(status->fio, fr->natoms, &fr->step, &fr->time, fr->box, fr->x,
-                                      &fr->prec, &bOK)
-                        != 0);
-                fr->bPrec = (bRet && fr->prec > 0);
-                fr->bStep = bRet;
-                fr->bTime = bRet;
-                fr->bX    = bRet;
-                fr->bBox  = bRet;
-                if (!bOK)
-                {
-                    /* Actually the header could also be not ok,
-                       but from bOK from read_next_xtc this can't be distinguished */
-                    fr->not_ok = DATA_NOT_OK;
-                }
-                break;
-            case efTNG: bRet = gmx_read_next_tng_frame(status->tng, fr, nullptr, 0); break;
-            case efPDB: bRet = pdb_next_x(status, gmx_fio_getfp(status->fio), fr); break;
-            case efGRO: bRet = gro_next_x_or_v(gmx_fio_getfp(status->fio), fr); break;
-            default:
-#if GMX_USE_PLUGINS
-                bRet = read_next_vmd_frame(status->vmdplugin, fr);
-#else
-                gmx_fatal(FARGS, "DEATH HORROR in read_next_frame ftp=%s,status=%s",
-                          ftp2ext(gmx_fio_getftp(status->fio)), gmx_fio_getname(status->fio));
-#endif
+            initcount(status);
         }
         status->tf = fr->time;
 
@@ -898,6 +1391,11 @@ bool read_first_frame(const gmx_output_env_t* oenv, t_trxstatus** status, const
     status_init(*status);
     initcount(*status);
     (*status)->flags = flags;
+    const char* prefetchEnv = getenv("GMX_TRX_PREFETCH");
+    if (prefetchEnv != nullptr)
+    {
+        trx_set_prefetch_depth(*status, strtol(prefetchEnv, nullptr, 10));
+    }
 
     if (efTNG == ftp)
     {
@@ -910,7 +1408,19 @@ bool read_first_frame(const gmx_output_env_t* oenv, t_trxstatus** status, const
     }
     switch (ftp)
     {
-        case efTRR: break;
+        case efTRR:
+            if (getenv("GMX_NO_TRR_MMAP") == nullptr)
+            {
+                try
+                {
+                    (*status)->trrMap = new gmx::TrrMappedFile(fn);
+                }
+                catch (const gmx::FileIOError&)
+                {
+                    /* Read the file with XDR only */
+                }
+            }
+            break;
         case efCPT:
             read_checkpoint_trxframe(fio, fr);
             bFirst = FALSE;
@@ -939,7 +1449,12 @@ bool read_first_frame(const gmx_output_env_t* oenv, t_trxstatus** status, const
             break;
         }
         case efXTC:
-            if (read_first_xtc(fio, &fr->natoms, &fr->step, &fr->time, fr->box, &fr->x, &fr->prec, &bOK) == 0)
+            (*status)->xtcIndex = gmx::loadXtcFrameIndex(fn).release();
+            if (!(*status)->xtcIndex && getenv("GMX_WRITE_XTC_INDEX") != nullptr)
+            {
+                (*status)->xtcIndexBuilder = new gmx::XtcFrameIndex;
+            }
+            if (read_xtc_frame(*status, fr, TRUE, &bOK) == 0)
             {
                 GMX_RELEASE_ASSERT(!bOK,
                                    "Inconsistent results - OK status from read_first_xtc, but 0 "
@@ -1076,7 +1591,9 @@ gmx_bool read_next_x(const gmx_output_env_t* oenv, t_trxstatus* status, real* t,
 
 void rewind_trj(t_trxstatus* status)
 {
+    trx_prefetch_stop(status, TRUE);
     initcount(status);
+    status->xtcFrame = 0;
 
     gmx_fio_rewind(status->fio);
 }
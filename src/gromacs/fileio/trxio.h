@@ -165,6 +165,24 @@ struct t_fileio* trx_get_fileio(t_trxstatus* status);
 float trx_get_time_of_final_frame(t_trxstatus* status);
 /* get time of final frame. Only supported for TNG and XTC */
 
+gmx_bool trx_seek_frame(t_trxstatus* status, int frame);
+/* Position the trajectory such that the next call to read_next_frame
+ * reads frame number frame (counting from 0 at the start of the file).
+ * Only supported for XTC. Uses the sidecar frame index when it is present
+ * and valid, so the seek costs a single file positioning; otherwise the
+ * frame headers are scanned once to build an index in memory.
+ * Returns FALSE when the frame does not exist.
+ */
+
+void trx_set_prefetch_depth(t_trxstatus* status, int depth);
+/* Set the number of frames that read_next_frame reads ahead in a
+ * background thread, so reading and decompressing frames overlaps with
+ * the analysis of the current frame. A depth of 0 turns read-ahead off.
+ * Only XTC, TRR and TNG files are read ahead, for other formats this has
+ * no effect. read_first_frame sets the depth from the environment
+ * variable GMX_TRX_PREFETCH, default 0.
+ */
+
 gmx_bool bRmod_fd(double a, double b, double c, gmx_bool bDouble);
 /* Returns TRUE when (a - b) MOD c = 0, using a margin which is slightly
  * larger than the float/double precision.
@@ -58,6 +58,11 @@
 /* Read or write reduced precision *float* coordinates */
 int xdr3dfcoord(XDR* xdrs, float* fp, int* size, float* precision);
 
+/* Same as xdr3dfcoord, but decodes with the original bit-by-bit reader.
+ * Only meant for reading, to test and benchmark the optimized decoder
+ * that xdr3dfcoord uses against. */
+int xdr3dfcoord_reference(XDR* xdrs, float* fp, int* size, float* precision);
+
 
 /* Read or write a *real* value (stored as float) */
 int xdr_real(XDR* xdrs, real* r);
@@ -84,4 +89,11 @@ float xdr_xtc_get_last_frame_time(FILE* fp, XDR* xdrs, int natoms, gmx_bool* bOK
 
 int xdr_xtc_get_last_frame_number(FILE* fp, XDR* xdrs, int natoms, gmx_bool* bOK);
 
+
+/* Read the header of the XTC frame starting at the current position and
+ * position the file at the start of the next frame without decoding the
+ * coordinates. Returns 1 on success, 0 at end of file, and -1 when the
+ * data is not a complete XTC frame. */
+int xdr_xtc_skip_frame(FILE* fp, XDR* xdrs, int* natoms, int* step, float* time);
+
 #endif
@@ -0,0 +1,286 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2020, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Implements gmx::XtcFrameIndex.
+ *
+ * \ingroup module_fileio
+ */
+#include "gmxpre.h"
+
+#include "xtcindex.h"
+
+#include <cstdio>
+
+#include <algorithm>
+
+#include "gromacs/fileio/gmxfio.h"
+#include "gromacs/fileio/gmxfio_xdr.h"
+#include "gromacs/fileio/xdrf.h"
+#include "gromacs/utility/exceptions.h"
+#include "gromacs/utility/futil.h"
+#include "gromacs/utility/gmxassert.h"
+#include "gromacs/utility/inmemoryserializer.h"
+
+namespace gmx
+{
+
+namespace
+{
+
+//! Magic number identifying an XTC frame index file ("XTCI").
+const int32_t c_xtcIndexMagic = 0x58544349;
+//! Version of the index file format.
+const int32_t c_xtcIndexVersion = 1;
+//! The index files are stored big-endian, like the XTC files themselves.
+const EndianSwapBehavior c_xtcIndexEndianSwap = EndianSwapBehavior::SwapIfHostIsLittleEndian;
+
+//! Returns the size of the file open in \p fio, leaving the position at the end.
+int64_t openFileSize(t_fileio* fio)
+{
+    if (gmx_fseek(gmx_fio_getfp(fio), 0, SEEK_END) != 0)
+    {
+        return -1;
+    }
+    return gmx_fio_ftell(fio);
+}
+
+//! Returns whether the frame header at \p entry.offset matches \p entry.
+bool frameHeaderMatches(t_fileio* fio, const XtcFrameIndexEntry& entry)
+{
+    int   natoms;
+    int   step;
+    float time;
+    return gmx_fio_seek(fio, entry.offset) == 0
+           && xdr_xtc_skip_frame(gmx_fio_getfp(fio), gmx_fio_getxdr(fio), &natoms, &step, &time) == 1
+           && natoms == entry.natoms && step == entry.step && static_cast<real>(time) == entry.time;
+}
+
+//! Serializes one index entry.
+void serializeEntry(ISerializer* serializer, XtcFrameIndexEntry* entry)
+{
+    float time = entry->time;
+    serializer->doInt64(&entry->offset);
+    serializer->doInt64(&entry->step);
+    serializer->doFloat(&time);
+    serializer->doInt(&entry->natoms);
+    entry->time = time;
+}
+
+} // namespace
+
+XtcFrameIndex XtcFrameIndex::build(const std::string& xtcFileName)
+{
+    if (!gmx_fexist(xtcFileName))
+    {
+        GMX_THROW(FileIOError("Cannot index '" + xtcFileName + "' - file not found."));
+    }
+    XtcFrameIndex index;
+    t_fileio*     fio  = gmx_fio_open(xtcFileName.c_str(), "r");
+    const int64_t size = openFileSize(fio);
+    gmx_fio_rewind(fio);
+
+    FILE* fp   = gmx_fio_getfp(fio);
+    XDR*  xdrs = gmx_fio_getxdr(fio);
+    while (true)
+    {
+        XtcFrameIndexEntry entry;
+        int                step;
+        float              time;
+        entry.offset = gmx_fio_ftell(fio);
+        if (xdr_xtc_skip_frame(fp, xdrs, &entry.natoms, &step, &time) != 1
+            || gmx_fio_ftell(fio) > size)
+        {
+            break;
+        }
+        entry.step = step;
+        entry.time = time;
+        index.frames_.push_back(entry);
+    }
+    gmx_fio_close(fio);
+
+    if (index.frames_.empty() && size > 0)
+    {
+        GMX_THROW(FileIOError("Cannot index '" + xtcFileName + "' - not a valid XTC file."));
+    }
+    index.fileSize_ = size;
+    return index;
+}
+
+XtcFrameIndex XtcFrameIndex::read(const std::string& indexFileName)
+{
+    FILE* fp = std::fopen(indexFileName.c_str(), "rb");
+    if (fp == nullptr)
+    {
+        GMX_THROW(FileIOError("Cannot open XTC frame index '" + indexFileName + "'."));
+    }
+    std::vector<char> buffer;
+    if (gmx_fseek(fp, 0, SEEK_END) == 0)
+    {
+        const int64_t size = gmx_ftell(fp);
+        if (size > 0 && gmx_fseek(fp, 0, SEEK_SET) == 0)
+        {
+            buffer.resize(size);
+            if (std::fread(buffer.data(), 1, buffer.size(), fp) != buffer.size())
+            {
+                buffer.clear();
+            }
+        }
+    }
+    std::fclose(fp);
+
+    const std::string error = "'" + indexFileName + "' is not a valid XTC frame index.";
+    const size_t      headerSize = 2 * sizeof(int32_t) + 2 * sizeof(int64_t);
+    const size_t      entrySize  = 2 * sizeof(int64_t) + sizeof(float) + sizeof(int32_t);
+    if (buffer.size() < headerSize)
+    {
+        GMX_THROW(FileIOError(error));
+    }
+    InMemoryDeserializer serializer(buffer, false, c_xtcIndexEndianSwap);
+    int32_t              magic;
+    int32_t              version;
+    int64_t              frameCount;
+    XtcFrameIndex        index;
+    serializer.doInt32(&magic);
+    serializer.doInt32(&version);
+    serializer.doInt64(&index.fileSize_);
+    serializer.doInt64(&frameCount);
+    if (magic != c_xtcIndexMagic || version != c_xtcIndexVersion || frameCount < 0
+        || buffer.size() != headerSize + frameCount * entrySize)
+    {
+        GMX_THROW(FileIOError(error));
+    }
+    index.frames_.resize(frameCount);
+    for (XtcFrameIndexEntry& entry : index.frames_)
+    {
+        serializeEntry(&serializer, &entry);
+    }
+    return index;
+}
+
+void XtcFrameIndex::write(const std::string& indexFileName) const
+{
+    GMX_RELEASE_ASSERT(fileSize_ >= 0, "Only complete indices can be written");
+    InMemorySerializer serializer(c_xtcIndexEndianSwap);
+    int32_t            magic      = c_xtcIndexMagic;
+    int32_t            version    = c_xtcIndexVersion;
+    int64_t            fileSize   = fileSize_;
+    int64_t            frameCount = frames_.size();
+    serializer.doInt32(&magic);
+    serializer.doInt32(&version);
+    serializer.doInt64(&fileSize);
+    serializer.doInt64(&frameCount);
+    for (XtcFrameIndexEntry entry : frames_)
+    {
+        serializeEntry(&serializer, &entry);
+    }
+    const std::vector<char> buffer = serializer.finishAndGetBuffer();
+
+    // The index is a cache of the trajectory contents, so an old index is
+    // overwritten instead of backed up.
+    FILE* fp = std::fopen(indexFileName.c_str(), "wb");
+    if (fp == nullptr)
+    {
+        GMX_THROW(FileIOError("Cannot open '" + indexFileName + "' for writing."));
+    }
+    const bool bOK = (std::fwrite(buffer.data(), 1, buffer.size(), fp) == buffer.size());
+    if (std::fclose(fp) != 0 || !bOK)
+    {
+        GMX_THROW(FileIOError("Error while writing XTC frame index '" + indexFileName + "'."));
+    }
+}
+
+bool XtcFrameIndex::isValidFor(const std::string& xtcFileName) const
+{
+    if (fileSize_ < 0 || !gmx_fexist(xtcFileName))
+    {
+        return false;
+    }
+    t_fileio* fio   = gmx_fio_open(xtcFileName.c_str(), "r");
+    bool      valid = (openFileSize(fio) == fileSize_);
+    if (valid && !frames_.empty())
+    {
+        valid = frameHeaderMatches(fio, frames_.front()) && frameHeaderMatches(fio, frames_.back())
+                && gmx_fio_ftell(fio) == fileSize_;
+    }
+    gmx_fio_close(fio);
+    return valid;
+}
+
+void XtcFrameIndex::addFrame(const XtcFrameIndexEntry& entry)
+{
+    GMX_ASSERT(frames_.empty() || entry.offset > frames_.back().offset,
+               "Frames must be added in file order");
+    frames_.push_back(entry);
+}
+
+int XtcFrameIndex::findFrameAtTime(real time, int firstFrame) const
+{
+    const auto begin = frames_.begin() + std::min(std::max(firstFrame, 0), frameCount());
+    const auto frame = std::find_if(begin, frames_.end(), [time](const XtcFrameIndexEntry& entry) {
+        return entry.time >= time;
+    });
+    return frame == frames_.end() ? -1 : static_cast<int>(frame - frames_.begin());
+}
+
+std::string xtcFrameIndexFileName(const std::string& xtcFileName)
+{
+    return xtcFileName + ".idx";
+}
+
+std::unique_ptr<XtcFrameIndex> loadXtcFrameIndex(const std::string& xtcFileName)
+{
+    const std::string indexFileName = xtcFrameIndexFileName(xtcFileName);
+    if (!gmx_fexist(indexFileName))
+    {
+        return nullptr;
+    }
+    std::unique_ptr<XtcFrameIndex> index;
+    try
+    {
+        index = std::make_unique<XtcFrameIndex>(XtcFrameIndex::read(indexFileName));
+    }
+    catch (const FileIOError&)
+    {
+        return nullptr;
+    }
+    if (!index->isValidFor(xtcFileName))
+    {
+        return nullptr;
+    }
+    return index;
+}
+
+} // namespace gmx
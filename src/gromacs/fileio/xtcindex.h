@@ -0,0 +1,174 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2020, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \libinternal \file
+ * \brief
+ * Declares gmx::XtcFrameIndex for random access to XTC frames.
+ *
+ * The index maps frame numbers to byte offsets in an XTC file, so that
+ * seeking to a frame does not require bisecting the file and re-syncing
+ * on frame headers. It can be stored in a sidecar file next to the
+ * trajectory, which is used automatically by read_first_frame() and
+ * read_next_frame() while it still describes the trajectory.
+ *
+ * \inlibraryapi
+ * \ingroup module_fileio
+ */
+#ifndef GMX_FILEIO_XTCINDEX_H
+#define GMX_FILEIO_XTCINDEX_H
+
+#include <cstdint>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "gromacs/utility/arrayref.h"
+#include "gromacs/utility/real.h"
+
+namespace gmx
+{
+
+//! Location and header information for one frame of an XTC file.
+struct XtcFrameIndexEntry
+{
+    //! Byte offset of the frame header in the file.
+    int64_t offset;
+    //! MD step stored in the frame header.
+    int64_t step;
+    //! Time stored in the frame header.
+    real time;
+    //! Number of atoms in the frame.
+    int natoms;
+};
+
+/*! \libinternal \brief
+ * Frame-offset index of an XTC file.
+ *
+ * An index is either built by scanning the frame headers of a trajectory
+ * with build(), or assembled frame by frame with addFrame() while the
+ * trajectory is read sequentially anyway.  Before an index loaded from
+ * a sidecar file is used, isValidFor() checks that it still describes
+ * the trajectory, i.e., that the file has not been replaced or extended.
+ *
+ * \inlibraryapi
+ * \ingroup module_fileio
+ */
+class XtcFrameIndex
+{
+public:
+    /*! \brief
+     * Builds an index by scanning the frame headers of \p xtcFileName.
+     *
+     * Only the headers are read; the coordinates are skipped.
+     * An incomplete last frame is not included in the index.
+     *
+     * \throws FileIOError if the file does not exist or is not an XTC file.
+     */
+    static XtcFrameIndex build(const std::string& xtcFileName);
+    /*! \brief
+     * Reads an index from a sidecar file written with write().
+     *
+     * \throws FileIOError if the file cannot be read or is not a valid index.
+     */
+    static XtcFrameIndex read(const std::string& indexFileName);
+
+    /*! \brief
+     * Writes the index to \p indexFileName.
+     *
+     * \throws FileIOError if the file cannot be written.
+     */
+    void write(const std::string& indexFileName) const;
+
+    /*! \brief
+     * Returns whether the index describes the current contents of \p xtcFileName.
+     *
+     * The size of the file must match the size recorded in the index, and
+     * the headers of the first and last indexed frames must be found at
+     * their recorded offsets.  Does not throw.
+     */
+    bool isValidFor(const std::string& xtcFileName) const;
+
+    /*! \brief
+     * Appends a frame to the index.
+     *
+     * Frames must be added in file order.
+     */
+    void addFrame(const XtcFrameIndexEntry& entry);
+    /*! \brief
+     * Sets the size of the indexed file.
+     *
+     * This marks the index as complete; an index whose file size has not
+     * been set is never valid.
+     */
+    void setFileSize(int64_t fileSize) { fileSize_ = fileSize; }
+
+    //! Returns the number of indexed frames.
+    int frameCount() const { return static_cast<int>(frames_.size()); }
+    //! Returns the indexed frames.
+    ArrayRef<const XtcFrameIndexEntry> frames() const { return frames_; }
+    //! Returns the size of the indexed file, or -1 if the index is incomplete.
+    int64_t fileSize() const { return fileSize_; }
+    /*! \brief
+     * Returns the first frame at or after \p firstFrame with time at least \p time.
+     *
+     * Returns -1 if there is no such frame.
+     */
+    int findFrameAtTime(real time, int firstFrame = 0) const;
+
+private:
+    std::vector<XtcFrameIndexEntry> frames_;
+    int64_t                         fileSize_ = -1;
+};
+
+/*! \brief
+ * Returns the name of the sidecar index file for \p xtcFileName.
+ *
+ * The sidecar file is the trajectory name with ".idx" appended,
+ * e.g., traj.xtc.idx for traj.xtc.
+ */
+std::string xtcFrameIndexFileName(const std::string& xtcFileName);
+
+/*! \brief
+ * Loads the sidecar index of \p xtcFileName if it exists and is valid.
+ *
+ * Returns nullptr if there is no sidecar file, or if it is unreadable or
+ * does not describe the current trajectory. Does not throw other than
+ * std::bad_alloc.
+ */
+std::unique_ptr<XtcFrameIndex> loadXtcFrameIndex(const std::string& xtcFileName);
+
+} // namespace gmx
+
+#endif
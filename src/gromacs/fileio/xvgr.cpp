@@ -41,6 +41,7 @@
 
 #include <cassert>
 #include <cctype>
+#include <cstdlib>
 #include <cstring>
 
 #include <string>
@@ -735,8 +736,6 @@ gmx::MultiDimArray<std::vector<double>, gmx::dynamicExtents2D> readXvgData(const
 {
     FILE* fp = gmx_fio_fopen(fn.c_str(), "r");
     char* ptr;
-    char* base = nullptr;
-    char* fmt  = nullptr;
     char* tmpbuf;
     int   len = STRLEN;
 
@@ -761,27 +760,22 @@ gmx::MultiDimArray<std::vector<double>, gmx::dynamicExtents2D> readXvgData(const
             {
                 return {}; // There are no columns and hence no data to process
             }
-            snew(fmt, 3 * numColumns + 1);
-            snew(base, 3 * numColumns + 1);
         }
-        /* Initiate format string */
-        fmt[0]          = '\0';
-        base[0]         = '\0';
-        int columnCount = 0;
+        /* Convert the columns in a single pass over the line. A column that
+         * does not start with a number ends the line, as with sscanf. */
+        int         columnCount = 0;
+        const char* field       = ptr;
         for (columnCount = 0; (columnCount < numColumns); columnCount++)
         {
-            double lf;
-            std::strcpy(fmt, base);
-            std::strcat(fmt, "%lf");
-            int rval = sscanf(ptr, fmt, &lf);
-            if ((rval == EOF) || (rval == 0))
+            char*  end;
+            double lf = std::strtod(field, &end);
+            if (end == field)
             {
                 break;
             }
             xvgData.push_back(lf);
-            srenew(fmt, 3 * (numColumns + 1) + 1);
-            srenew(base, 3 * numColumns + 1);
-            std::strcat(base, "%*s");
+            /* Skip any trailing characters of this column */
+            for (field = end; *field != '\0' && !std::isspace(*field); field++) {}
         }
 
         if (columnCount != numColumns)
@@ -796,8 +790,6 @@ gmx::MultiDimArray<std::vector<double>, gmx::dynamicExtents2D> readXvgData(const
     gmx_fio_fclose(fp);
 
     sfree(tmpbuf);
-    sfree(base);
-    sfree(fmt);
 
     gmx::MultiDimArray<std::vector<double>, gmx::dynamicExtents2D> xvgDataAsArray(numRows, numColumns);
     std::copy(std::begin(xvgData), std::end(xvgData), begin(xvgDataAsArray.asView()));
@@ -39,12 +39,24 @@
 
 #include "cmat.h"
 
+#include "config.h"
+
+#include <cerrno>
+#include <cstring>
+
 #include <algorithm>
 
+#if !GMX_NATIVE_WINDOWS
+#    include <fcntl.h>
+#    include <sys/mman.h>
+#    include <unistd.h>
+#endif
+
 #include "gromacs/fileio/matio.h"
 #include "gromacs/fileio/xvgr.h"
 #include "gromacs/math/functions.h"
 #include "gromacs/math/vec.h"
+#include "gromacs/utility/fatalerror.h"
 #include "gromacs/utility/futil.h"
 #include "gromacs/utility/smalloc.h"
 
@@ -68,6 +80,63 @@ t_mat* init_mat(int n1, gmx_bool b1D)
     return m;
 }
 
+t_mat* init_mat_mapped(int n1, gmx_bool b1D, const char* fn)
+{
+#if !GMX_NATIVE_WINDOWS
+    t_mat* m;
+    size_t size;
+    void*  mapping = nullptr;
+    int    fd, i;
+
+    size = static_cast<size_t>(n1) * n1 * sizeof(real);
+    if (size > 0)
+    {
+        fd = open(fn, O_RDWR | O_CREAT | O_TRUNC, 0600);
+        if (fd < 0)
+        {
+            gmx_fatal(FARGS, "Could not create matrix file %s: %s", fn, std::strerror(errno));
+        }
+        /* The file is sparse, so all elements start out as zero */
+        if (ftruncate(fd, size) != 0)
+        {
+            gmx_fatal(FARGS, "Could not resize matrix file %s: %s", fn, std::strerror(errno));
+        }
+        mapping = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (mapping == MAP_FAILED)
+        {
+            gmx_fatal(FARGS, "Could not map matrix file %s: %s", fn, std::strerror(errno));
+        }
+        close(fd);
+        /* The mapping keeps the contents alive until it is removed */
+        unlink(fn);
+    }
+
+    snew(m, 1);
+    m->n1          = n1;
+    m->nn          = 0;
+    m->b1D         = b1D;
+    m->maxrms      = 0;
+    m->minrms      = 1e20;
+    m->sumrms      = 0;
+    m->mapping     = mapping;
+    m->mappingSize = size;
+    snew(m->mat, n1);
+    for (i = 0; (i < n1); i++)
+    {
+        m->mat[i] = static_cast<real*>(mapping) + static_cast<size_t>(i) * n1;
+    }
+
+    snew(m->erow, n1);
+    snew(m->m_ind, n1);
+    reset_index(m);
+
+    return m;
+#else
+    fprintf(stderr, "Memory mapping of %s is not supported, storing the matrix in memory\n", fn);
+    return init_mat(n1, b1D);
+#endif
+}
+
 void copy_t_mat(t_mat* dst, t_mat* src)
 {
     int i, j;
@@ -141,7 +210,23 @@ void set_mat_entry(t_mat* m, int i, int j, real val)
 
 void done_mat(t_mat** m)
 {
-    done_matrix((*m)->n1, &((*m)->mat));
+    if ((*m)->mapping != nullptr)
+    {
+#if !GMX_NATIVE_WINDOWS
+        munmap((*m)->mapping, (*m)->mappingSize);
+#endif
+        sfree((*m)->mat);
+    }
+    else if ((*m)->b1D && (*m)->n1 > 0)
+    {
+        /* All rows are stored in the first one */
+        sfree((*m)->mat[0]);
+        sfree((*m)->mat);
+    }
+    else
+    {
+        done_matrix((*m)->n1, &((*m)->mat));
+    }
     sfree((*m)->m_ind);
     sfree((*m)->erow);
     sfree(*m);
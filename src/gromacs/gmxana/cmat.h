@@ -38,6 +38,8 @@
 #ifndef _cmat_h
 #define _cmat_h
 
+#include <cstddef>
+
 #include "gromacs/utility/basedefinitions.h"
 #include "gromacs/utility/real.h"
 
@@ -62,6 +64,9 @@ typedef struct
     real     minrms, maxrms, sumrms;
     real*    erow;
     real**   mat;
+    /* Storage of the matrix elements when they are mapped to a file, nullptr otherwise */
+    void*  mapping;
+    size_t mappingSize;
 } t_mat;
 
 /* The matrix is indexed using the matrix index */
@@ -69,6 +74,14 @@ typedef struct
 
 extern t_mat* init_mat(int n1, gmx_bool b1D);
 
+/* Initializes a matrix with the elements stored in a memory mapping of
+ * the file fn, so the operating system can keep only the parts in use
+ * in memory. The rows are contiguous, as with b1D. The file is removed
+ * right away and disappears when the matrix is freed with done_mat.
+ * Falls back to init_mat when memory mapping is not supported.
+ */
+extern t_mat* init_mat_mapped(int n1, gmx_bool b1D, const char* fn);
+
 extern void copy_t_mat(t_mat* dst, t_mat* src);
 
 extern void enlarge_mat(t_mat* m, int deltan);
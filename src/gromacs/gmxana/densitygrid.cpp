@@ -0,0 +1,326 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2021, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Implements the density grid accumulator used by gmx density, gmx densmap
+ * and gmx spatial.
+ */
+#include "gmxpre.h"
+
+#include "densitygrid.h"
+
+#include <cmath>
+#include <cstdio>
+
+#include <algorithm>
+#include <array>
+
+#include "gromacs/fileio/mrcdensitymap.h"
+#include "gromacs/fileio/mrcdensitymapheader.h"
+#include "gromacs/math/functions.h"
+#include "gromacs/math/gausstransform.h"
+#include "gromacs/utility/exceptions.h"
+#include "gromacs/utility/futil.h"
+#include "gromacs/utility/gmxomp.h"
+#include "gromacs/utility/inmemoryserializer.h"
+
+namespace gmx
+{
+
+namespace
+{
+
+//! Range of the Gaussian spreading in multiples of its width
+constexpr real c_gaussianRangeInSigma = 4;
+
+//! Maximum memory used by the thread-local copies of the grid
+constexpr size_t c_maxThreadGridBytes = size_t(1) << 30;
+
+//! Bins and weights that one point contributes to in one dimension
+struct Stencil
+{
+    std::vector<int>    bin;
+    std::vector<double> weight;
+};
+
+//! Fills \p stencil for lattice coordinate \p u in a dimension of \p numBins bins
+void computeStencil(real                 u,
+                    int                  numBins,
+                    bool                 periodic,
+                    DensitySpreading     spreading,
+                    GaussianOn1DLattice* gauss,
+                    int                  range,
+                    Stencil*             stencil)
+{
+    stencil->bin.clear();
+    stencil->weight.clear();
+    if (numBins == 1)
+    {
+        stencil->bin.push_back(0);
+        stencil->weight.push_back(1);
+        return;
+    }
+    switch (spreading)
+    {
+        case DensitySpreading::NearestBin:
+            stencil->bin.push_back(static_cast<int>(std::floor(u)));
+            stencil->weight.push_back(1);
+            break;
+        case DensitySpreading::Linear:
+        {
+            /* Interpolate between the bin centers */
+            const real   center = u - 0.5_real;
+            const int    k      = static_cast<int>(std::floor(center));
+            const double f      = center - k;
+            stencil->bin.push_back(k);
+            stencil->weight.push_back(1 - f);
+            stencil->bin.push_back(k + 1);
+            stencil->weight.push_back(f);
+            break;
+        }
+        case DensitySpreading::Gaussian:
+        {
+            const real center = u - 0.5_real;
+            const int  k      = roundToInt(center);
+            gauss->spread(1, center - k);
+            ArrayRef<const float> values = gauss->view();
+            double                sum    = 0;
+            for (int i = -range; i <= range; i++)
+            {
+                sum += values[range + i];
+            }
+            for (int i = -range; i <= range; i++)
+            {
+                stencil->bin.push_back(k + i);
+                stencil->weight.push_back(values[range + i] / sum);
+            }
+            break;
+        }
+    }
+    for (size_t i = 0; i < stencil->bin.size(); i++)
+    {
+        int& bin = stencil->bin[i];
+        if (periodic)
+        {
+            bin = ((bin % numBins) + numBins) % numBins;
+        }
+        else if (bin < 0 || bin >= numBins)
+        {
+            stencil->weight[i] = 0;
+            bin                = 0;
+        }
+    }
+}
+
+} // namespace
+
+DensitySpreading densitySpreadingFromName(const char* name)
+{
+    switch (name[0])
+    {
+        case 'l': return DensitySpreading::Linear;
+        case 'g': return DensitySpreading::Gaussian;
+        default: return DensitySpreading::NearestBin;
+    }
+}
+
+DensityGridAccumulator::DensityGridAccumulator(const IVec&                  numBins,
+                                               const std::array<bool, DIM>& periodic,
+                                               DensitySpreading             spreading,
+                                               const RVec&                  sigma,
+                                               int                          numThreads) :
+    numBins_(numBins),
+    periodic_(periodic),
+    spreading_(spreading),
+    sigma_(sigma),
+    grid_(numBins[XX] * numBins[YY] * numBins[ZZ], 0)
+{
+    for (int d = 0; d < DIM; d++)
+    {
+        if (numBins[d] < 1)
+        {
+            GMX_THROW(InvalidInputError("A density grid needs at least one bin in each dimension"));
+        }
+        if (spreading == DensitySpreading::Gaussian && numBins[d] > 1 && sigma[d] < 0.5)
+        {
+            GMX_THROW(InvalidInputError(
+                    "The width of the Gaussian spreading should be at least half a bin"));
+        }
+    }
+    /* Large grids are spread over by fewer threads, to limit the memory
+     * used by the thread-local grids. A single thread spreads directly
+     * on the final grid.
+     */
+    const size_t gridBytes  = grid_.size() * sizeof(double);
+    const int    maxThreads = static_cast<int>(c_maxThreadGridBytes / gridBytes);
+    numThreads_             = std::max(1, std::min(numThreads, maxThreads));
+    if (numThreads_ > 1)
+    {
+        threadGrids_.resize(numThreads_);
+    }
+    points_.reserve(c_pointBufferSize);
+    weights_.reserve(c_pointBufferSize);
+}
+
+void DensityGridAccumulator::flush()
+{
+    const int numPoints = points_.size();
+    if (numPoints == 0)
+    {
+        return;
+    }
+    IVec range = { 0, 0, 0 };
+    if (spreading_ == DensitySpreading::Gaussian)
+    {
+        for (int d = 0; d < DIM; d++)
+        {
+            range[d] = static_cast<int>(std::ceil(c_gaussianRangeInSigma * sigma_[d]));
+        }
+    }
+
+#pragma omp parallel num_threads(numThreads_)
+    {
+        try
+        {
+            std::vector<double>& grid =
+                    (numThreads_ == 1) ? grid_ : threadGrids_[gmx_omp_get_thread_num()];
+            grid.resize(grid_.size(), 0);
+            std::array<Stencil, DIM>         stencil;
+            std::vector<GaussianOn1DLattice> gauss;
+            if (spreading_ == DensitySpreading::Gaussian)
+            {
+                for (int d = 0; d < DIM; d++)
+                {
+                    gauss.emplace_back(range[d], std::max(sigma_[d], 0.5_real));
+                }
+            }
+
+#pragma omp for
+            for (int p = 0; p < numPoints; p++)
+            {
+                for (int d = 0; d < DIM; d++)
+                {
+                    computeStencil(points_[p][d], numBins_[d], periodic_[d], spreading_,
+                                   gauss.empty() ? nullptr : &gauss[d], range[d], &stencil[d]);
+                }
+                for (size_t i = 0; i < stencil[XX].bin.size(); i++)
+                {
+                    const double wx = weights_[p] * stencil[XX].weight[i];
+                    for (size_t j = 0; j < stencil[YY].bin.size(); j++)
+                    {
+                        const double wxy    = wx * stencil[YY].weight[j];
+                        const int    offset = index(stencil[XX].bin[i], stencil[YY].bin[j], 0);
+                        for (size_t k = 0; k < stencil[ZZ].bin.size(); k++)
+                        {
+                            grid[offset + stencil[ZZ].bin[k]] += wxy * stencil[ZZ].weight[k];
+                        }
+                    }
+                }
+            }
+        }
+        GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR
+    }
+
+    points_.clear();
+    weights_.clear();
+}
+
+ArrayRef<const double> DensityGridAccumulator::values()
+{
+    flush();
+    const int gridSize = grid_.size();
+#pragma omp parallel for num_threads(numThreads_)
+    for (int i = 0; i < gridSize; i++)
+    {
+        for (const std::vector<double>& threadGrid : threadGrids_)
+        {
+            if (!threadGrid.empty())
+            {
+                grid_[i] += threadGrid[i];
+            }
+        }
+    }
+    for (std::vector<double>& threadGrid : threadGrids_)
+    {
+        std::vector<double>().swap(threadGrid);
+    }
+    return grid_;
+}
+
+void writeDensityGridMrc(const std::string&    fileName,
+                         const IVec&           numPoints,
+                         const RVec&           origin,
+                         const RVec&           spacing,
+                         ArrayRef<const float> data)
+{
+    constexpr real c_nmToAA = 10;
+
+    MrcDensityMapHeader header;
+    for (int d = 0; d < DIM; d++)
+    {
+        header.numColumnRowSection_[d]   = numPoints[d];
+        header.extent_[d]                = numPoints[d];
+        header.cellLength_[d]            = numPoints[d] * spacing[d] * c_nmToAA;
+        header.userDefinedFloat_[12 + d] = origin[d] * c_nmToAA;
+    }
+    if (!data.empty())
+    {
+        double sum = 0, sum2 = 0;
+        header.dataStatistics_.min_ = *std::min_element(data.begin(), data.end());
+        header.dataStatistics_.max_ = *std::max_element(data.begin(), data.end());
+        for (float value : data)
+        {
+            sum += value;
+            sum2 += square(value);
+        }
+        header.dataStatistics_.mean_ = sum / data.size();
+        header.dataStatistics_.rms_  = std::sqrt(
+                std::max(0.0, sum2 / data.size() - square(sum / data.size())));
+    }
+
+    InMemorySerializer serializer;
+    MrcDensityMapOfFloatWriter(header, data).write(&serializer);
+    const std::vector<char> buffer = serializer.finishAndGetBuffer();
+
+    FILE*      fp  = gmx_ffopen(fileName, "wb");
+    const bool bOK = (std::fwrite(buffer.data(), 1, buffer.size(), fp) == buffer.size());
+    gmx_ffclose(fp);
+    if (!bOK)
+    {
+        GMX_THROW(FileIOError("Error while writing density map '" + fileName + "'."));
+    }
+}
+
+} // namespace gmx
@@ -0,0 +1,159 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2021, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Accumulation of atom weights on density grids, shared by gmx density,
+ * gmx densmap and gmx spatial.
+ */
+#ifndef GMX_GMXANA_DENSITYGRID_H
+#define GMX_GMXANA_DENSITYGRID_H
+
+#include <array>
+#include <string>
+#include <vector>
+
+#include "gromacs/math/vectypes.h"
+#include "gromacs/utility/arrayref.h"
+#include "gromacs/utility/real.h"
+
+namespace gmx
+{
+
+//! How the weight of a point is distributed over the grid
+enum class DensitySpreading
+{
+    NearestBin, //!< All weight to the bin that contains the point
+    Linear,     //!< Linear interpolation between the nearest bin centers in each dimension
+    Gaussian    //!< A normalized Gaussian around the point
+};
+
+/*! \brief Returns the spreading for a command-line enum value
+ *
+ * Uses the first character of \p name, so "nearest", "linear" and
+ * "gauss" select the three spreading methods.
+ */
+DensitySpreading densitySpreadingFromName(const char* name);
+
+/*! \brief Accumulates weights of points on a grid of bins, using threads
+ *
+ * Points are given in lattice coordinates, where bin i in a dimension
+ * covers coordinates [i, i+1). Points are buffered, typically over several
+ * frames, and are spread in parallel by OpenMP threads that each add to
+ * their own copy of the grid. The copies are summed when the values are
+ * requested. For large grids the number of threads is reduced to limit
+ * the memory used by the copies. Dimensions can be periodic, in which case weight is wrapped
+ * around, otherwise weight outside the grid is dropped. Dimensions of
+ * size one are never spread over, so the same class serves one-, two- and
+ * three-dimensional grids.
+ *
+ * The Gaussian is evaluated with GaussianOn1DLattice in each dimension
+ * and normalized on the lattice, so the total weight is conserved.
+ */
+class DensityGridAccumulator
+{
+public:
+    /*! \brief Constructs an empty grid
+     *
+     * \param[in] numBins    Number of bins in each dimension
+     * \param[in] periodic   Whether each dimension is periodic
+     * \param[in] spreading  How to distribute weights over the bins
+     * \param[in] sigma      Gaussian width in bins in each dimension, only used with
+     *                       Gaussian spreading
+     * \param[in] numThreads Number of OpenMP threads to use
+     */
+    DensityGridAccumulator(const IVec&                  numBins,
+                           const std::array<bool, DIM>& periodic,
+                           DensitySpreading             spreading,
+                           const RVec&                  sigma,
+                           int                          numThreads);
+
+    //! Adds a point with weight \p weight at lattice coordinates \p x
+    void add(const RVec& x, real weight)
+    {
+        points_.push_back(x);
+        weights_.push_back(weight);
+        if (points_.size() >= c_pointBufferSize)
+        {
+            flush();
+        }
+    }
+
+    /*! \brief Returns the accumulated values
+     *
+     * The value of bin (i,j,k) is at index (i*ny + j)*nz + k.
+     */
+    ArrayRef<const double> values();
+
+    //! Returns the number of bins in dimension \p d
+    int numBins(int d) const { return numBins_[d]; }
+
+    //! Returns the index in values() of bin (i,j,k)
+    int index(int i, int j, int k) const { return (i * numBins_[YY] + j) * numBins_[ZZ] + k; }
+
+private:
+    //! Spreads the buffered points over the thread-local grids
+    void flush();
+
+    //! Number of buffered points that triggers spreading
+    static constexpr size_t c_pointBufferSize = 1 << 16;
+
+    IVec                             numBins_;
+    std::array<bool, DIM>            periodic_;
+    DensitySpreading                 spreading_;
+    RVec                             sigma_;
+    int                              numThreads_;
+    std::vector<RVec>                points_;
+    std::vector<real>                weights_;
+    std::vector<std::vector<double>> threadGrids_;
+    std::vector<double>              grid_;
+};
+
+/*! \brief Writes a three-dimensional grid to an MRC/CCP4 density map
+ *
+ * \param[in] fileName  Name of the file to write
+ * \param[in] numPoints Number of grid points in each dimension
+ * \param[in] origin    Position of the first grid point (nm)
+ * \param[in] spacing   Distance between grid points (nm)
+ * \param[in] data      Values with the x index varying fastest
+ */
+void writeDensityGridMrc(const std::string&    fileName,
+                         const IVec&           numPoints,
+                         const RVec&           origin,
+                         const RVec&           spacing,
+                         ArrayRef<const float> data);
+
+} // namespace gmx
+
+#endif
@@ -42,6 +42,8 @@
 #include <cstring>
 
 #include <algorithm>
+#include <climits>
+#include <vector>
 
 #include "gromacs/commandline/pargs.h"
 #include "gromacs/commandline/viewit.h"
@@ -51,6 +53,7 @@
 #include "gromacs/fileio/xvgr.h"
 #include "gromacs/gmxana/cmat.h"
 #include "gromacs/gmxana/gmx_ana.h"
+#include "gromacs/gmxana/rmsdmatrix.h"
 #include "gromacs/linearalgebra/eigensolver.h"
 #include "gromacs/math/do_fit.h"
 #include "gromacs/math/vec.h"
@@ -65,6 +68,7 @@
 #include "gromacs/utility/cstringutil.h"
 #include "gromacs/utility/fatalerror.h"
 #include "gromacs/utility/futil.h"
+#include "gromacs/utility/gmxomp.h"
 #include "gromacs/utility/smalloc.h"
 #include "gromacs/utility/stringutil.h"
 
@@ -466,7 +470,6 @@ static void jarvis_patrick(int n1, real** mat, int M, int P, real rmsdcut, t_clu
     int**      nnb;
     int        i, j, k, cid, diff, maxval;
     gmx_bool   bChange;
-    real**     mcpy = nullptr;
 
     if (rmsdcut < 0)
     {
@@ -542,14 +545,20 @@ static void jarvis_patrick(int n1, real** mat, int M, int P, real rmsdcut, t_clu
 
     c = new_clustid(n1);
     fprintf(stderr, "Linking structures ");
-    /* Use mcpy for temporary storage of booleans */
-    mcpy = mk_matrix(n1, n1, FALSE);
+    /* Store the linked pairs per structure, instead of an n1 x n1 matrix of booleans */
+    std::vector<std::vector<int>> links(n1);
     for (i = 0; i < n1; i++)
     {
-        for (j = i + 1; j < n1; j++)
+        for (k = 0; nnb[i][k] >= 0; k++)
         {
-            mcpy[i][j] = static_cast<real>(jp_same(nnb, i, j, P));
+            /* Only neighbors can be linked */
+            j = nnb[i][k];
+            if (j > i && jp_same(nnb, i, j, P))
+            {
+                links[i].push_back(j);
+            }
         }
+        std::sort(links[i].begin(), links[i].end());
     }
     do
     {
@@ -557,22 +566,19 @@ static void jarvis_patrick(int n1, real** mat, int M, int P, real rmsdcut, t_clu
         bChange = FALSE;
         for (i = 0; i < n1; i++)
         {
-            for (j = i + 1; j < n1; j++)
+            for (const int linked : links[i])
             {
-                if (mcpy[i][j] != 0.0F)
+                diff = c[linked].clust - c[i].clust;
+                if (diff)
                 {
-                    diff = c[j].clust - c[i].clust;
-                    if (diff)
+                    bChange = TRUE;
+                    if (diff > 0)
                     {
-                        bChange = TRUE;
-                        if (diff > 0)
-                        {
-                            c[j].clust = c[i].clust;
-                        }
-                        else
-                        {
-                            c[i].clust = c[j].clust;
-                        }
+                        c[linked].clust = c[i].clust;
+                    }
+                    else
+                    {
+                        c[i].clust = c[linked].clust;
                     }
                 }
             }
@@ -611,8 +617,6 @@ static void jarvis_patrick(int n1, real** mat, int M, int P, real rmsdcut, t_clu
         }
     }
 
-    done_matrix(n1, &mcpy);
-
     sfree(c);
     for (i = 0; (i < n1); i++)
     {
@@ -1392,6 +1396,13 @@ int gmx_cluster(int argc, char* argv[])
         "file. When writing all structures, separate numbered files are made",
         "for each cluster.[PAR]",
 
+        "The RMSD matrix is computed in parallel with [TT]-nthreads[tt] threads.",
+        "With [TT]-mmap[tt], the matrix is stored in a memory-mapped scratch",
+        "file instead of in memory, so that large matrices only use as much",
+        "memory as is available. The file is removed at exit. The single linkage,",
+        "Monte Carlo and diagonalization methods still need memory of the",
+        "order of the matrix size.[PAR]",
+
         "Two output files are always written:",
         "",
         " * [TT]-o[tt] writes the RMSD values in the upper left half of the matrix",
@@ -1428,10 +1439,11 @@ int gmx_cluster(int argc, char* argv[])
     FILE *  fp, *log;
     int     nf   = 0, i, i1, i2, j;
     int64_t nrms = 0;
+    int     nthreads;
 
     matrix      box;
     matrix*     boxes = nullptr;
-    rvec *      xtps, *usextps, *x1, **xx = nullptr;
+    rvec *      xtps, *usextps, **xx = nullptr;
     const char *fn, *trx_out_fn;
     t_clusters  clust;
     t_mat *     rms, *orig = nullptr;
@@ -1444,9 +1456,9 @@ int gmx_cluster(int argc, char* argv[])
     int      isize = 0, ifsize = 0, iosize = 0;
     int *    index = nullptr, *fitidx = nullptr, *outidx = nullptr, *frameindices = nullptr;
     char*    grpname;
-    real     rmsd, **d1, **d2, *time = nullptr, time_invfac, *mass = nullptr;
+    real     *time = nullptr, time_invfac, *mass = nullptr;
     char     buf[STRLEN], buf1[80];
-    gmx_bool bAnalyze, bUseRmsdCut, bJP_RMSD = FALSE, bReadMat, bReadTraj, bPBC = TRUE;
+    gmx_bool bAnalyze, bUseRmsdCut, bJP_RMSD = FALSE, bReadMat, bReadTraj, bMapMat, bPBC = TRUE;
 
     int                method, ncluster = 0;
     static const char* methodname[] = { nullptr,       "linkage",         "jarvis-patrick",
@@ -1470,6 +1482,7 @@ int gmx_cluster(int argc, char* argv[])
     static int   nlevels = 40, skip = 1;
     static real  scalemax = -1.0, rmsdcut = 0.1, rmsmin = 0.0;
     gmx_bool     bRMSdist = FALSE, bBinary = FALSE, bAverage = FALSE, bFit = TRUE;
+    int          nThreads = 0;
     static int   niter = 10000, nrandom = 0, seed = 0, write_ncl = 0, write_nst = 1, minstruct = 1;
     static real  kT = 1e-3;
     static int   M = 10, P = 3;
@@ -1551,7 +1564,13 @@ int gmx_cluster(int argc, char* argv[])
           { &kT },
           "Boltzmann weighting factor for Monte Carlo optimization "
           "(zero turns off uphill steps)" },
-        { "-pbc", FALSE, etBOOL, { &bPBC }, "PBC check" }
+        { "-pbc", FALSE, etBOOL, { &bPBC }, "PBC check" },
+        { "-nthreads",
+          FALSE,
+          etINT,
+          { &nThreads },
+          "Number of threads used for computing the RMSD matrix. nThreads <= 0 means "
+          "maximum number of threads. Requires linking with OpenMP." }
     };
     t_filenm fnm[] = {
         { efTRX, "-f", nullptr, ffOPTRD },         { efTPS, "-s", nullptr, ffREAD },
@@ -1561,7 +1580,8 @@ int gmx_cluster(int argc, char* argv[])
         { efXVG, "-ev", "rmsd-eig", ffOPTWR },     { efXVG, "-conv", "mc-conv", ffOPTWR },
         { efXVG, "-sz", "clust-size", ffOPTWR },   { efXPM, "-tr", "clust-trans", ffOPTWR },
         { efXVG, "-ntr", "clust-trans", ffOPTWR }, { efXVG, "-clid", "clust-id", ffOPTWR },
-        { efTRX, "-cl", "clusters.pdb", ffOPTWR }, { efNDX, "-clndx", "clusters.ndx", ffOPTWR }
+        { efTRX, "-cl", "clusters.pdb", ffOPTWR }, { efNDX, "-clndx", "clusters.ndx", ffOPTWR },
+        { efDAT, "-mmap", "rmsd-matrix", ffOPTWR }
     };
 #define NFILE asize(fnm)
 
@@ -1574,6 +1594,8 @@ int gmx_cluster(int argc, char* argv[])
     /* parse options */
     bReadMat  = opt2bSet("-dm", NFILE, fnm);
     bReadTraj = opt2bSet("-f", NFILE, fnm) || !bReadMat;
+    bMapMat   = opt2bSet("-mmap", NFILE, fnm);
+    nthreads  = std::min((nThreads <= 0) ? INT_MAX : nThreads, gmx_omp_get_max_threads());
     if (opt2parg_bSet("-av", asize(pa), pa) || opt2parg_bSet("-wcl", asize(pa), pa)
         || opt2parg_bSet("-nst", asize(pa), pa) || opt2parg_bSet("-rmsmin", asize(pa), pa)
         || opt2bSet("-cl", NFILE, fnm))
@@ -1778,79 +1800,77 @@ int gmx_cluster(int argc, char* argv[])
             time[i] *= time_invfac;
         }
 
-        rms = init_mat(readmat[0].nx, method == m_diagonalize);
+        rms = bMapMat ? init_mat_mapped(readmat[0].nx, method == m_diagonalize,
+                                        opt2fn("-mmap", NFILE, fnm))
+                      : init_mat(readmat[0].nx, method == m_diagonalize);
         convert_mat(&(readmat[0]), rms);
 
         nlevels = gmx::ssize(readmat[0].map);
     }
     else /* !bReadMat */
     {
-        rms  = init_mat(nf, method == m_diagonalize);
+        rms  = bMapMat ? init_mat_mapped(nf, method == m_diagonalize, opt2fn("-mmap", NFILE, fnm))
+                      : init_mat(nf, method == m_diagonalize);
         nrms = (static_cast<int64_t>(nf) * static_cast<int64_t>(nf - 1)) / 2;
         if (!bRMSdist)
         {
-            fprintf(stderr, "Computing %dx%d RMS deviation matrix\n", nf, nf);
-            /* Initialize work array */
-            snew(x1, isize);
-            for (i1 = 0; i1 < nf; i1++)
+            fprintf(stderr, "Computing %dx%d RMS deviation matrix using %d threads\n", nf, nf,
+                    nthreads);
+            calc_rmsd_matrix(rms, nf, isize, xx, mass, bFit, nthreads);
+        }
+        else /* bRMSdist */
+        {
+            fprintf(stderr, "Computing %dx%d RMS distance deviation matrix using %d threads\n", nf,
+                    nf, nthreads);
+
+#pragma omp parallel num_threads(nthreads)
             {
-                for (i2 = i1 + 1; i2 < nf; i2++)
+                real **d1, **d2;
+
+                /* Initiate work arrays */
+                snew(d1, isize);
+                snew(d2, isize);
+                for (int i = 0; (i < isize); i++)
+                {
+                    snew(d1[i], isize);
+                    snew(d2[i], isize);
+                }
+#pragma omp for schedule(dynamic)
+                for (int i1 = 0; i1 < nf; i1++)
                 {
-                    for (i = 0; i < isize; i++)
+                    calc_dist(isize, xx[i1], d1);
+                    for (int i2 = i1 + 1; (i2 < nf); i2++)
                     {
-                        copy_rvec(xx[i1][i], x1[i]);
+                        calc_dist(isize, xx[i2], d2);
+                        rms->mat[i1][i2] = rms_dist(isize, d1, d2);
                     }
-                    if (bFit)
+#pragma omp critical
                     {
-                        do_fit(isize, mass, xx[i2], x1);
+                        nrms -= nf - i1 - 1;
+                        fprintf(stderr,
+                                "\r# RMSD calculations left: "
+                                "%" PRId64 "   ",
+                                nrms);
+                        fflush(stderr);
                     }
-                    rmsd = rmsdev(isize, mass, xx[i2], x1);
-                    set_mat_entry(rms, i1, i2, rmsd);
                 }
-                nrms -= nf - i1 - 1;
-                fprintf(stderr,
-                        "\r# RMSD calculations left: "
-                        "%" PRId64 "   ",
-                        nrms);
-                fflush(stderr);
-            }
-            sfree(x1);
-        }
-        else /* bRMSdist */
-        {
-            fprintf(stderr, "Computing %dx%d RMS distance deviation matrix\n", nf, nf);
-
-            /* Initiate work arrays */
-            snew(d1, isize);
-            snew(d2, isize);
-            for (i = 0; (i < isize); i++)
-            {
-                snew(d1[i], isize);
-                snew(d2[i], isize);
+                /* Clean up work arrays */
+                for (int i = 0; (i < isize); i++)
+                {
+                    sfree(d1[i]);
+                    sfree(d2[i]);
+                }
+                sfree(d1);
+                sfree(d2);
             }
+            /* Symmetrize and collect the statistics in the same order as a serial run */
             for (i1 = 0; i1 < nf; i1++)
             {
-                calc_dist(isize, xx[i1], d1);
                 for (i2 = i1 + 1; (i2 < nf); i2++)
                 {
-                    calc_dist(isize, xx[i2], d2);
-                    set_mat_entry(rms, i1, i2, rms_dist(isize, d1, d2));
+                    set_mat_entry(rms, i1, i2, rms->mat[i1][i2]);
                 }
-                nrms -= nf - i1 - 1;
-                fprintf(stderr,
-                        "\r# RMSD calculations left: "
-                        "%" PRId64 "   ",
-                        nrms);
-                fflush(stderr);
-            }
-            /* Clean up work arrays */
-            for (i = 0; (i < isize); i++)
-            {
-                sfree(d1[i]);
-                sfree(d2[i]);
             }
-            sfree(d1);
-            sfree(d2);
         }
         fprintf(stderr, "\n\n");
     }
@@ -40,6 +40,10 @@
 #include <cmath>
 #include <cstring>
 
+#include <algorithm>
+#include <functional>
+#include <vector>
+
 #include "gromacs/commandline/pargs.h"
 #include "gromacs/fileio/confio.h"
 #include "gromacs/fileio/matio.h"
@@ -48,6 +52,7 @@
 #include "gromacs/gmxana/eigio.h"
 #include "gromacs/gmxana/gmx_ana.h"
 #include "gromacs/linearalgebra/eigensolver.h"
+#include "gromacs/linearalgebra/matrix.h"
 #include "gromacs/math/do_fit.h"
 #include "gromacs/math/vec.h"
 #include "gromacs/pbcutil/pbc.h"
@@ -61,6 +66,9 @@
 #include "gromacs/utility/smalloc.h"
 #include "gromacs/utility/sysinfo.h"
 
+/* Number of frames added to the covariance matrix at once */
+static const int c_frameBlockSize = 64;
+
 int gmx_covar(int argc, char* argv[])
 {
     const char* desc[] = {
@@ -95,11 +103,32 @@ int gmx_covar(int argc, char* argv[])
         "of atoms involved. It is easy to run out of memory, in which",
         "case this tool will probably exit with a 'Segmentation fault'. You",
         "should consider carefully whether a reduced set of atoms will meet",
-        "your needs for lower costs."
+        "your needs for lower costs.",
+        "[PAR]",
+        "When only the first eigenvectors are needed, the diagonalization",
+        "can be made much cheaper with [TT]-diag[tt]. With [TT]lanczos[tt],",
+        "only the eigenvectors up to [TT]-last[tt] are computed with the",
+        "Lanczos method. With [TT]random[tt], the covariance matrix is not",
+        "constructed at all and these eigenvectors are approximated by",
+        "subspace iteration from a set of random vectors, which needs",
+        "[TT]-niter[tt] + 1 extra passes over the trajectory. The accuracy",
+        "of the last eigenvalues increases with [TT]-niter[tt]. With both",
+        "methods only the sum of the computed eigenvalues is known, not the",
+        "sum of all of them."
     };
-    static gmx_bool bFit = TRUE, bRef = FALSE, bM = FALSE, bPBC = TRUE;
-    static int      end  = -1;
-    t_pargs         pa[] = {
+    gmx_bool bFit = TRUE, bRef = FALSE, bM = FALSE, bPBC = TRUE;
+    int      end  = -1;
+    int      niter = 2;
+    enum
+    {
+        edSel,
+        edFull,
+        edLanczos,
+        edRandom,
+        edNR
+    };
+    const char* diagType[edNR + 1] = { nullptr, "full", "lanczos", "random", nullptr };
+    t_pargs     pa[]               = {
         { "-fit", FALSE, etBOOL, { &bFit }, "Fit to a reference structure" },
         { "-ref",
           FALSE,
@@ -109,7 +138,14 @@ int gmx_covar(int argc, char* argv[])
           "average" },
         { "-mwa", FALSE, etBOOL, { &bM }, "Mass-weighted covariance analysis" },
         { "-last", FALSE, etINT, { &end }, "Last eigenvector to write away (-1 is till the last)" },
-        { "-pbc", FALSE, etBOOL, { &bPBC }, "Apply corrections for periodic boundary conditions" }
+        { "-pbc", FALSE, etBOOL, { &bPBC }, "Apply corrections for periodic boundary conditions" },
+        { "-diag",
+          FALSE,
+          etENUM,
+          { diagType },
+          "Diagonalization method, lanczos and random only compute the eigenvectors up to "
+          "[TT]-last[tt]" },
+        { "-niter", FALSE, etINT, { &niter }, "Number of subspace iterations with -diag random" }
     };
     FILE*             out = nullptr; /* initialization makes all compilers happy */
     t_trxstatus*      status;
@@ -120,10 +156,10 @@ int gmx_covar(int argc, char* argv[])
     matrix            box, zerobox;
     real *            sqrtm, *mat, *eigenvalues, sum, trace, inv_nframes;
     real              t, tstart, tend, **mat2;
-    real              xj, *w_rls = nullptr;
+    real*             w_rls = nullptr;
     real              min, max, *axis;
     int               natoms, nat, nframes0, nframes, nlevels;
-    int64_t           ndim, i, j, k, l;
+    int64_t           ndim, i, j, k;
     int               WriteXref;
     const char *      fitfile, *trxfile, *ndxfile;
     const char *      eigvalfile, *eigvecfile, *averfile, *logfile;
@@ -134,6 +170,8 @@ int gmx_covar(int argc, char* argv[])
     gmx_bool          bDiffMass1, bDiffMass2;
     t_rgb             rlo, rmi, rhi;
     real*             eigenvectors;
+    int               diag, nvec;
+    gmx_bool          bPartial;
     gmx_output_env_t* oenv;
     gmx_rmpbc_t       gpbc = nullptr;
 
@@ -254,7 +292,31 @@ int gmx_covar(int argc, char* argv[])
     {
         gmx_fatal(FARGS, "Number of degrees of freedoms to large for matrix.\n");
     }
-    snew(mat, ndim * ndim);
+    diag     = nenum(diagType);
+    bPartial = (diag != edFull);
+    if (bPartial)
+    {
+        if (end <= 0)
+        {
+            gmx_fatal(FARGS, "With -diag %s, set the number of eigenvectors to compute with -last",
+                      diagType[0]);
+        }
+        end = std::min(static_cast<int64_t>(end), ndim);
+    }
+    if (diag == edRandom)
+    {
+        if (asciifile || xpmfile || xpmafile)
+        {
+            gmx_fatal(FARGS,
+                      "The covariance matrix is not constructed with -diag random, so it can not "
+                      "be written with -ascii, -xpm or -xpma");
+        }
+        mat = nullptr;
+    }
+    else
+    {
+        snew(mat, ndim * ndim);
+    }
 
     fprintf(stderr, "Calculating the average structure ...\n");
     nframes0 = 0;
@@ -297,61 +359,59 @@ int gmx_covar(int argc, char* argv[])
                            PbcType::No, zerobox, natoms, index);
     sfree(xread);
 
-    fprintf(stderr, "Constructing covariance matrix (%dx%d) ...\n", static_cast<int>(ndim),
-            static_cast<int>(ndim));
-    nframes = 0;
-    nat     = read_first_x(oenv, &status, trxfile, &t, &xread, box);
-    tstart  = t;
-    do
-    {
-        nframes++;
-        tend = t;
-        /* calculate x: a (fitted) structure of the selected atoms */
-        if (bPBC)
-        {
-            gmx_rmpbc(gpbc, nat, box, xread);
-        }
-        if (bFit)
+    /* Reads the trajectory and passes the deviations of the (fitted) analysis
+     * atoms from the average or reference structure to processBlock, as
+     * blocks of up to c_frameBlockSize vectors of length ndim.
+     */
+    std::vector<real> block(c_frameBlockSize * ndim);
+    const auto readDeviations = [&](const std::function<void(int, real*)>& processBlock) {
+        int nblock = 0;
+        nframes    = 0;
+        nat        = read_first_x(oenv, &status, trxfile, &t, &xread, box);
+        tstart     = t;
+        do
         {
-            reset_x(nfit, ifit, nat, nullptr, xread, w_rls);
-            do_fit(nat, w_rls, xref, xread);
-        }
-        if (bRef)
-        {
-            for (i = 0; i < natoms; i++)
+            nframes++;
+            tend = t;
+            /* calculate x: a (fitted) structure of the selected atoms */
+            if (bPBC)
             {
-                rvec_sub(xread[index[i]], xref[index[i]], x[i]);
+                gmx_rmpbc(gpbc, nat, box, xread);
             }
-        }
-        else
-        {
+            if (bFit)
+            {
+                reset_x(nfit, ifit, nat, nullptr, xread, w_rls);
+                do_fit(nat, w_rls, xref, xread);
+            }
+            real* dx = block.data() + nblock * ndim;
             for (i = 0; i < natoms; i++)
             {
-                rvec_sub(xread[index[i]], xav[i], x[i]);
+                rvec_sub(xread[index[i]], bRef ? xref[index[i]] : xav[i], &dx[DIM * i]);
             }
-        }
-
-        for (j = 0; j < natoms; j++)
-        {
-            for (dj = 0; dj < DIM; dj++)
+            nblock++;
+            if (nblock == c_frameBlockSize)
             {
-                k  = ndim * (DIM * j + dj);
-                xj = x[j][dj];
-                for (i = j; i < natoms; i++)
-                {
-                    l = k + DIM * i;
-                    for (d = 0; d < DIM; d++)
-                    {
-                        mat[l + d] += x[i][d] * xj;
-                    }
-                }
+                processBlock(nblock, block.data());
+                nblock = 0;
             }
+        } while (read_next_x(oenv, status, &t, xread, box) && (bRef || nframes < nframes0));
+        if (nblock > 0)
+        {
+            processBlock(nblock, block.data());
         }
-    } while (read_next_x(oenv, status, &t, xread, box) && (bRef || nframes < nframes0));
-    close_trx(status);
-    gmx_rmpbc_done(gpbc);
+        close_trx(status);
+        sfree(xread);
+    };
 
-    fprintf(stderr, "Read %d frames\n", nframes);
+    if (diag != edRandom)
+    {
+        fprintf(stderr, "Constructing covariance matrix (%dx%d) ...\n", static_cast<int>(ndim),
+                static_cast<int>(ndim));
+        readDeviations([&](int nblock, real* dx) {
+            symmetric_rank_k_update(ndim, nblock, dx, mat);
+        });
+        fprintf(stderr, "Read %d frames\n", nframes);
+    }
 
     if (bRef)
     {
@@ -367,38 +427,42 @@ int gmx_covar(int argc, char* argv[])
         xproj = xav;
     }
 
-    /* correct the covariance matrix for the mass */
-    inv_nframes = 1.0 / nframes;
-    for (j = 0; j < natoms; j++)
+    if (diag != edRandom)
     {
-        for (dj = 0; dj < DIM; dj++)
+        /* correct the covariance matrix for the mass */
+        inv_nframes = 1.0 / nframes;
+        for (j = 0; j < natoms; j++)
         {
-            for (i = j; i < natoms; i++)
+            for (dj = 0; dj < DIM; dj++)
             {
-                k = ndim * (DIM * j + dj) + DIM * i;
-                for (d = 0; d < DIM; d++)
+                for (i = j; i < natoms; i++)
                 {
-                    mat[k + d] = mat[k + d] * inv_nframes * sqrtm[i] * sqrtm[j];
+                    k = ndim * (DIM * j + dj) + DIM * i;
+                    for (d = 0; d < DIM; d++)
+                    {
+                        mat[k + d] = mat[k + d] * inv_nframes * sqrtm[i] * sqrtm[j];
+                    }
                 }
             }
         }
-    }
 
-    /* symmetrize the matrix */
-    for (j = 0; j < ndim; j++)
-    {
-        for (i = j; i < ndim; i++)
+        /* symmetrize the matrix */
+        for (j = 0; j < ndim; j++)
         {
-            mat[ndim * i + j] = mat[ndim * j + i];
+            for (i = j; i < ndim; i++)
+            {
+                mat[ndim * i + j] = mat[ndim * j + i];
+            }
         }
-    }
 
-    trace = 0;
-    for (i = 0; i < ndim; i++)
-    {
-        trace += mat[i * ndim + i];
+        trace = 0;
+        for (i = 0; i < ndim; i++)
+        {
+            trace += mat[i * ndim + i];
+        }
+        fprintf(stderr, "\nTrace of the covariance matrix: %g (%snm^2)\n", trace,
+                bM ? "u " : "");
     }
-    fprintf(stderr, "\nTrace of the covariance matrix: %g (%snm^2)\n", trace, bM ? "u " : "");
 
     if (asciifile)
     {
@@ -516,24 +580,122 @@ int gmx_covar(int argc, char* argv[])
 
     /* call diagonalization routine */
 
-    snew(eigenvalues, ndim);
-    snew(eigenvectors, ndim * ndim);
+    if (diag == edFull)
+    {
+        snew(eigenvalues, ndim);
+        snew(eigenvectors, ndim * ndim);
 
-    std::memcpy(eigenvectors, mat, ndim * ndim * sizeof(real));
-    fprintf(stderr, "\nDiagonalizing ...\n");
-    fflush(stderr);
-    eigensolver(eigenvectors, ndim, 0, ndim, eigenvalues, mat);
-    sfree(eigenvectors);
+        std::memcpy(eigenvectors, mat, ndim * ndim * sizeof(real));
+        fprintf(stderr, "\nDiagonalizing ...\n");
+        fflush(stderr);
+        eigensolver(eigenvectors, ndim, 0, ndim, eigenvalues, mat);
+        sfree(eigenvectors);
+        nvec = ndim;
+    }
+    else
+    {
+        snew(eigenvalues, end);
+        snew(eigenvectors, end * ndim);
+        if (diag == edLanczos)
+        {
+            fprintf(stderr, "\nComputing the %d largest eigenvalues ...\n", end);
+            lanczos_eigensolver(mat, ndim, end, eigenvalues, eigenvectors, 100000);
+            sfree(mat);
+        }
+        else
+        {
+            fprintf(stderr,
+                    "\nComputing the %d largest eigenvalues from %d passes over the "
+                    "trajectory ...\n",
+                    end, niter + 1);
+            /* Multiplies the covariance matrix with nvec vectors, accumulating
+             * the projections of the deviations in each block of frames.
+             */
+            std::vector<real> proj;
+            trace = -1;
+            randomized_eigensolver(
+                    ndim, end, niter,
+                    [&](int nv, const real* v, real* cv) {
+                        double traceSum = 0;
+                        std::fill(cv, cv + nv * ndim, 0);
+                        proj.resize(c_frameBlockSize * nv);
+                        readDeviations([&](int nblock, real* dx) {
+                            for (int b = 0; b < nblock; b++)
+                            {
+                                real* dxb = dx + b * ndim;
+                                for (int r = 0; r < ndim; r++)
+                                {
+                                    dxb[r] *= sqrtm[r / DIM];
+                                    traceSum += dxb[r] * dxb[r];
+                                }
+                                for (int c = 0; c < nv; c++)
+                                {
+                                    const real* vc  = v + c * ndim;
+                                    real        dot = 0;
+                                    for (int r = 0; r < ndim; r++)
+                                    {
+                                        dot += dxb[r] * vc[r];
+                                    }
+                                    proj[b * nv + c] = dot;
+                                }
+                            }
+                            for (int c = 0; c < nv; c++)
+                            {
+                                real* cvc = cv + c * ndim;
+                                for (int b = 0; b < nblock; b++)
+                                {
+                                    const real  p   = proj[b * nv + c];
+                                    const real* dxb = dx + b * ndim;
+                                    for (int r = 0; r < ndim; r++)
+                                    {
+                                        cvc[r] += p * dxb[r];
+                                    }
+                                }
+                            }
+                        });
+                        for (int r = 0; r < nv * ndim; r++)
+                        {
+                            cv[r] /= nframes;
+                        }
+                        if (trace < 0)
+                        {
+                            trace = traceSum / nframes;
+                        }
+                    },
+                    eigenvalues, eigenvectors);
+            fprintf(stderr, "Read %d frames\n", nframes);
+            fprintf(stderr, "\nTrace of the covariance matrix: %g (%snm^2)\n", trace,
+                    bM ? "u " : "");
+        }
+        /* Return the eigenpairs with decreasing eigenvalues */
+        std::reverse(eigenvalues, eigenvalues + end);
+        for (i = 0; i < end / 2; i++)
+        {
+            std::swap_ranges(eigenvectors + i * ndim, eigenvectors + (i + 1) * ndim,
+                             eigenvectors + (end - 1 - i) * ndim);
+        }
+        mat  = eigenvectors;
+        nvec = end;
+    }
+    gmx_rmpbc_done(gpbc);
 
     /* now write the output */
 
     sum = 0;
-    for (i = 0; i < ndim; i++)
+    for (i = 0; i < nvec; i++)
     {
         sum += eigenvalues[i];
     }
-    fprintf(stderr, "\nSum of the eigenvalues: %g (%snm^2)\n", sum, bM ? "u " : "");
-    if (std::abs(trace - sum) > 0.01 * trace)
+    if (bPartial)
+    {
+        fprintf(stderr, "\nSum of the %d largest eigenvalues: %g (%snm^2), %.1f%% of the trace\n",
+                end, sum, bM ? "u " : "", 100 * sum / trace);
+    }
+    else
+    {
+        fprintf(stderr, "\nSum of the eigenvalues: %g (%snm^2)\n", sum, bM ? "u " : "");
+    }
+    if (!bPartial && std::abs(trace - sum) > 0.01 * trace)
     {
         fprintf(stderr,
                 "\nWARNING: eigenvalue sum deviates from the trace of the covariance matrix\n");
@@ -562,7 +724,8 @@ int gmx_covar(int argc, char* argv[])
     out = xvgropen(eigvalfile, "Eigenvalues of the covariance matrix", "Eigenvector index", str, oenv);
     for (i = 0; (i < end); i++)
     {
-        fprintf(out, "%10d %g\n", static_cast<int>(i + 1), eigenvalues[ndim - 1 - i]);
+        fprintf(out, "%10d %g\n", static_cast<int>(i + 1),
+                eigenvalues[bPartial ? i : ndim - 1 - i]);
     }
     xvgrclose(out);
 
@@ -588,8 +751,8 @@ int gmx_covar(int argc, char* argv[])
         WriteXref = eWXR_NOFIT;
     }
 
-    write_eigenvectors(eigvecfile, natoms, mat, TRUE, 1, end, WriteXref, x, bDiffMass1, xproj, bM,
-                       eigenvalues);
+    write_eigenvectors(eigvecfile, natoms, mat, !bPartial, 1, end, WriteXref, x, bDiffMass1, xproj,
+                       bM, eigenvalues);
 
     out = gmx_ffopen(logfile, "w");
 
@@ -627,10 +790,20 @@ int gmx_covar(int argc, char* argv[])
     {
         fprintf(out, "Fit is %smass weighted\n", bDiffMass1 ? "" : "non-");
     }
-    fprintf(out, "Diagonalized the %dx%d covariance matrix\n", static_cast<int>(ndim),
-            static_cast<int>(ndim));
-    fprintf(out, "Trace of the covariance matrix before diagonalizing: %g\n", trace);
-    fprintf(out, "Trace of the covariance matrix after diagonalizing: %g\n\n", sum);
+    if (bPartial)
+    {
+        fprintf(out, "Computed the %d largest eigenvalues of the %dx%d covariance matrix with %s\n",
+                end, static_cast<int>(ndim), static_cast<int>(ndim), diagType[0]);
+        fprintf(out, "Trace of the covariance matrix: %g\n", trace);
+        fprintf(out, "Sum of the computed eigenvalues: %g\n\n", sum);
+    }
+    else
+    {
+        fprintf(out, "Diagonalized the %dx%d covariance matrix\n", static_cast<int>(ndim),
+                static_cast<int>(ndim));
+        fprintf(out, "Trace of the covariance matrix before diagonalizing: %g\n", trace);
+        fprintf(out, "Trace of the covariance matrix after diagonalizing: %g\n\n", sum);
+    }
 
     fprintf(out, "Wrote %d eigenvalues to %s\n", static_cast<int>(end), eigvalfile);
     if (WriteXref == eWXR_YES)
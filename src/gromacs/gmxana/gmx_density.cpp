@@ -42,10 +42,15 @@
 #include <cstdlib>
 #include <cstring>
 
+#include <algorithm>
+#include <climits>
+#include <vector>
+
 #include "gromacs/commandline/pargs.h"
 #include "gromacs/commandline/viewit.h"
 #include "gromacs/fileio/trxio.h"
 #include "gromacs/fileio/xvgr.h"
+#include "gromacs/gmxana/densitygrid.h"
 #include "gromacs/gmxana/gmx_ana.h"
 #include "gromacs/gmxana/gstat.h"
 #include "gromacs/math/units.h"
@@ -59,6 +64,7 @@
 #include "gromacs/utility/fatalerror.h"
 #include "gromacs/utility/futil.h"
 #include "gromacs/utility/gmxassert.h"
+#include "gromacs/utility/gmxomp.h"
 #include "gromacs/utility/smalloc.h"
 
 typedef struct
@@ -168,6 +174,50 @@ static void center_coords(t_atoms* atoms, const int* index_center, int ncenter,
     }
 }
 
+/* Sets up one grid per group, with the slices along the first grid dimension */
+static std::vector<gmx::DensityGridAccumulator> init_slice_grids(int                   nr_grps,
+                                                                 int                   nslices,
+                                                                 gmx::DensitySpreading spreading,
+                                                                 real sigmaInSlices,
+                                                                 int  nthreads)
+{
+    std::vector<gmx::DensityGridAccumulator> grids;
+    for (int n = 0; n < nr_grps; n++)
+    {
+        grids.emplace_back(gmx::IVec(nslices, 1, 1), std::array<bool, DIM>{ { true, true, true } },
+                           spreading, gmx::RVec(sigmaInSlices, 0, 0), nthreads);
+    }
+    return grids;
+}
+
+/* Returns the position of coordinate z in units of slices, counted from the first slice */
+static real slice_coordinate(real z, real boxSz, real slWidth, int nslices, gmx_bool bCenter)
+{
+    if (bCenter)
+    {
+        return (z - boxSz / 2.0) / slWidth + nslices / 2;
+    }
+    else
+    {
+        return z / slWidth;
+    }
+}
+
+/* Stores the grid values averaged over nr_frames in slDensity */
+static void average_slice_grids(gmx::ArrayRef<gmx::DensityGridAccumulator> grids,
+                                double**                                   slDensity,
+                                int                                        nr_frames)
+{
+    for (gmx::index n = 0; n < grids.ssize(); n++)
+    {
+        gmx::ArrayRef<const double> values = grids[n].values();
+        for (int i = 0; i < grids[n].numBins(XX); i++)
+        {
+            slDensity[n][i] = values[grids[n].index(i, 0, 0)] / nr_frames;
+        }
+    }
+}
+
 static void calc_electron_density(const char*             fn,
                                   int**                   index,
                                   const int               gnx[],
@@ -184,6 +234,9 @@ static void calc_electron_density(const char*             fn,
                                   int*                    index_center,
                                   int                     ncenter,
                                   gmx_bool                bRelative,
+                                  gmx::DensitySpreading   spreading,
+                                  real                    sigma,
+                                  int                     nthreads,
                                   const gmx_output_env_t* oenv)
 {
     rvec*        x0;  /* coordinates without pbc */
@@ -192,8 +245,7 @@ static void calc_electron_density(const char*             fn,
     int          natoms; /* nr. atoms in trj */
     t_trxstatus* status;
     int          i, n,     /* loop indices */
-            nr_frames = 0, /* number of frames */
-            slice;         /* current slice */
+            nr_frames = 0; /* number of frames */
     t_electron* found;     /* found by bsearch */
     t_electron  sought;    /* thingie thought by bsearch */
     real        boxSz, aveBox;
@@ -225,6 +277,40 @@ static void calc_electron_density(const char*             fn,
         snew((*slDensity)[i], *nslices);
     }
 
+    /* Look up the number of electrons of each atom once, not every frame */
+    std::vector<real> nr_el(top->atoms.nr, 0);
+    std::vector<bool> bFound(top->atoms.nr, false);
+    for (n = 0; n < nr_grps; n++)
+    {
+        for (i = 0; i < gnx[n]; i++)
+        {
+            int a = index[n][i];
+            if (bFound[a])
+            {
+                continue;
+            }
+            sought.nr_el    = 0;
+            sought.atomname = *(top->atoms.atomname[a]);
+            found           = static_cast<t_electron*>(
+                    bsearch(&sought, eltab, nr, sizeof(t_electron),
+                            reinterpret_cast<int (*)(const void*, const void*)>(compare)));
+
+            if (found == nullptr)
+            {
+                fprintf(stderr, "Couldn't find %s. Add it to the .dat file\n",
+                        *(top->atoms.atomname[a]));
+            }
+            else
+            {
+                nr_el[a]  = found->nr_el - top->atoms.atom[a].q;
+                bFound[a] = true;
+            }
+        }
+    }
+
+    std::vector<gmx::DensityGridAccumulator> grids = init_slice_grids(
+            nr_grps, *nslices, spreading, sigma * (*nslices) / box[axis][axis], nthreads);
+
     gpbc = gmx_rmpbc_init(&top->idef, pbcType, top->atoms.nr);
     /*********** Start processing trajectory ***********/
     do
@@ -258,6 +344,10 @@ static void calc_electron_density(const char*             fn,
         {
             for (i = 0; i < gnx[n]; i++) /* loop over all atoms in index file */
             {
+                if (!bFound[index[n][i]])
+                {
+                    continue;
+                }
                 z = x0[index[n][i]][axis];
                 while (z < 0)
                 {
@@ -273,33 +363,8 @@ static void calc_electron_density(const char*             fn,
                     z = z / box[axis][axis];
                 }
 
-                /* determine which slice atom is in */
-                if (bCenter)
-                {
-                    slice = static_cast<int>(std::floor((z - (boxSz / 2.0)) / (*slWidth)) + *nslices / 2.);
-                }
-                else
-                {
-                    slice = static_cast<int>(z / (*slWidth));
-                }
-                sought.nr_el    = 0;
-                sought.atomname = gmx_strdup(*(top->atoms.atomname[index[n][i]]));
-
-                /* now find the number of electrons. This is not efficient. */
-                found = static_cast<t_electron*>(
-                        bsearch(&sought, eltab, nr, sizeof(t_electron),
-                                reinterpret_cast<int (*)(const void*, const void*)>(compare)));
-
-                if (found == nullptr)
-                {
-                    fprintf(stderr, "Couldn't find %s. Add it to the .dat file\n",
-                            *(top->atoms.atomname[index[n][i]]));
-                }
-                else
-                {
-                    (*slDensity)[n][slice] += (found->nr_el - top->atoms.atom[index[n][i]].q) * invvol;
-                }
-                free(sought.atomname);
+                const real u = slice_coordinate(z, boxSz, *slWidth, *nslices, bCenter);
+                grids[n].add(gmx::RVec(u, 0, 0), nr_el[index[n][i]] * invvol);
             }
         }
         nr_frames++;
@@ -321,13 +386,7 @@ static void calc_electron_density(const char*             fn,
         *slWidth = aveBox / (*nslices);
     }
 
-    for (n = 0; n < nr_grps; n++)
-    {
-        for (i = 0; i < *nslices; i++)
-        {
-            (*slDensity)[n][i] /= nr_frames;
-        }
-    }
+    average_slice_grids(grids, *slDensity, nr_frames);
 
     sfree(x0); /* free memory used by coordinate array */
 }
@@ -346,6 +405,9 @@ static void calc_density(const char*             fn,
                          int*                    index_center,
                          int                     ncenter,
                          gmx_bool                bRelative,
+                         gmx::DensitySpreading   spreading,
+                         real                    sigma,
+                         int                     nthreads,
                          const gmx_output_env_t* oenv,
                          const char**            dens_opt)
 {
@@ -355,8 +417,7 @@ static void calc_density(const char*             fn,
     int          natoms; /* nr. atoms in trj */
     t_trxstatus* status;
     int          i, n,     /* loop indices */
-            nr_frames = 0, /* number of frames */
-            slice;         /* current slice */
+            nr_frames = 0; /* number of frames */
     real        t, z;
     real        boxSz, aveBox;
     real*       den_val; /* values from which the density is calculated */
@@ -386,6 +447,9 @@ static void calc_density(const char*             fn,
         snew((*slDensity)[i], *nslices);
     }
 
+    std::vector<gmx::DensityGridAccumulator> grids = init_slice_grids(
+            nr_grps, *nslices, spreading, sigma * (*nslices) / box[axis][axis], nthreads);
+
     gpbc = gmx_rmpbc_init(&top->idef, pbcType, top->atoms.nr);
     /*********** Start processing trajectory ***********/
 
@@ -458,30 +522,11 @@ static void calc_density(const char*             fn,
                     z = z / box[axis][axis];
                 }
 
-                /* determine which slice atom is in */
-                if (bCenter)
-                {
-                    slice = static_cast<int>(std::floor((z - (boxSz / 2.0)) / (*slWidth)) + *nslices / 2.);
-                }
-                else
-                {
-                    slice = static_cast<int>(std::floor(z / (*slWidth)));
-                }
-
-                /* Slice should already be 0<=slice<nslices, but we just make
-                 * sure we are not hit by IEEE rounding errors since we do
-                 * math operations after applying PBC above.
+                /* Slices outside the box, due to IEEE rounding errors after
+                 * applying PBC above, are wrapped back by the periodic grid.
                  */
-                if (slice < 0)
-                {
-                    slice += *nslices;
-                }
-                else if (slice >= *nslices)
-                {
-                    slice -= *nslices;
-                }
-
-                (*slDensity)[n][slice] += den_val[index[n][i]] * invvol;
+                const real u = slice_coordinate(z, boxSz, *slWidth, *nslices, bCenter);
+                grids[n].add(gmx::RVec(u, 0, 0), den_val[index[n][i]] * invvol);
             }
         }
         nr_frames++;
@@ -503,13 +548,7 @@ static void calc_density(const char*             fn,
         *slWidth = aveBox / (*nslices);
     }
 
-    for (n = 0; n < nr_grps; n++)
-    {
-        for (i = 0; i < *nslices; i++)
-        {
-            (*slDensity)[n][i] /= nr_frames;
-        }
-    }
+    average_slice_grids(grids, *slDensity, nr_frames);
 
     sfree(x0); /* free memory used by coordinate array */
     sfree(den_val);
@@ -659,7 +698,14 @@ int gmx_density(int argc, char* argv[])
         "undulatory fluctuations, where there are 'waves' forming in the system.",
         "This is a fundamental property of the biological system, and if you are",
         "comparing against experiments you likely want to include the undulation",
-        "smearing effect.",
+        "smearing effect.[PAR]",
+
+        "By default each atom is counted in the slice that contains it. With",
+        "[TT]-spread[tt] linear, the weight of an atom is divided between the two",
+        "nearest slices, and with [TT]-spread[tt] gauss it is spread with a Gaussian",
+        "of width [TT]-sigma[tt], which gives smoother profiles from short",
+        "trajectories. Atoms are spread over the slices in parallel using",
+        "[TT]-nthreads[tt] threads.",
         "",
     };
 
@@ -672,6 +718,9 @@ int gmx_density(int argc, char* argv[])
     static gmx_bool    bSymmetrize = FALSE;
     static gmx_bool    bCenter     = FALSE;
     static gmx_bool    bRelative   = FALSE;
+    const char*        spreadopt[] = { nullptr, "nearest", "linear", "gauss", nullptr };
+    real               sigma       = 0.1;
+    int                nThreads    = 0;
 
     t_pargs pa[] = {
         { "-d",
@@ -698,7 +747,19 @@ int gmx_density(int argc, char* argv[])
           FALSE,
           etBOOL,
           { &bRelative },
-          "Use relative coordinates for changing boxes and scale output by average dimensions." }
+          "Use relative coordinates for changing boxes and scale output by average dimensions." },
+        { "-spread", FALSE, etENUM, { spreadopt }, "How to distribute atoms over the slices" },
+        { "-sigma",
+          FALSE,
+          etREAL,
+          { &sigma },
+          "Width (nm) of the Gaussian used with [TT]-spread[tt] gauss" },
+        { "-nthreads",
+          FALSE,
+          etINT,
+          { &nThreads },
+          "Number of threads used for spreading the atoms. nThreads <= 0 means maximum "
+          "number of threads. Requires linking with OpenMP." }
     };
 
     const char* bugs[] = {
@@ -745,6 +806,10 @@ int gmx_density(int argc, char* argv[])
     /* Calculate axis */
     axis = toupper(axtitle[0]) - 'X';
 
+    const int nthreads = std::min((nThreads <= 0) ? INT_MAX : nThreads, gmx_omp_get_max_threads());
+
+    const gmx::DensitySpreading spreading = gmx::densitySpreadingFromName(spreadopt[0]);
+
     top = read_top(ftp2fn(efTPR, NFILE, fnm), &pbcType); /* read topology file */
 
     snew(grpname, ngrps);
@@ -776,12 +841,13 @@ int gmx_density(int argc, char* argv[])
 
         calc_electron_density(ftp2fn(efTRX, NFILE, fnm), index, ngx, &density, &nslices, top,
                               pbcType, axis, ngrps, &slWidth, el_tab, nr_electrons, bCenter,
-                              index_center, ncenter, bRelative, oenv);
+                              index_center, ncenter, bRelative, spreading, sigma, nthreads, oenv);
     }
     else
     {
         calc_density(ftp2fn(efTRX, NFILE, fnm), index, ngx, &density, &nslices, top, pbcType, axis,
-                     ngrps, &slWidth, bCenter, index_center, ncenter, bRelative, oenv, dens_opt);
+                     ngrps, &slWidth, bCenter, index_center, ncenter, bRelative, spreading, sigma,
+                     nthreads, oenv, dens_opt);
     }
 
     plot_density(density, opt2fn("-o", NFILE, fnm), nslices, ngrps, grpname, slWidth, dens_opt,
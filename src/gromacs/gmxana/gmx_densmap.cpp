@@ -40,11 +40,15 @@
 #include <cmath>
 #include <cstring>
 
+#include <algorithm>
+#include <climits>
+
 #include "gromacs/commandline/pargs.h"
 #include "gromacs/commandline/viewit.h"
 #include "gromacs/fileio/confio.h"
 #include "gromacs/fileio/matio.h"
 #include "gromacs/fileio/trxio.h"
+#include "gromacs/gmxana/densitygrid.h"
 #include "gromacs/gmxana/gmx_ana.h"
 #include "gromacs/gmxana/gstat.h"
 #include "gromacs/math/utilities.h"
@@ -57,6 +61,7 @@
 #include "gromacs/utility/fatalerror.h"
 #include "gromacs/utility/futil.h"
 #include "gromacs/utility/gmxassert.h"
+#include "gromacs/utility/gmxomp.h"
 #include "gromacs/utility/smalloc.h"
 
 int gmx_densmap(int argc, char* argv[])
@@ -94,13 +99,24 @@ int gmx_densmap(int argc, char* argv[])
         "Option [TT]count[tt] produces the count for each grid cell.",
         "When you do not want the scale in the output to go",
         "from zero to the maximum density, you can set the maximum",
-        "with the option [TT]-dmax[tt]."
+        "with the option [TT]-dmax[tt].",
+        "[PAR]",
+        "By default each atom is counted in the grid cell that contains it.",
+        "With [TT]-spread[tt] linear, the atom is distributed over the four",
+        "nearest cells by bilinear interpolation, and with [TT]-spread[tt] gauss",
+        "it is spread with a Gaussian of width [TT]-sigma[tt], which gives smoother",
+        "maps from short trajectories. For axial-radial maps, weight that is",
+        "spread outside the map is discarded. Atoms are spread over the grid in",
+        "parallel using [TT]-nthreads[tt] threads."
     };
     static int         n1 = 0, n2 = 0;
     static real        xmin = -1, xmax = -1, bin = 0.02, dmin = 0, dmax = 0, amax = 0, rmax = 0;
     static gmx_bool    bMirror = FALSE, bSums = FALSE;
     static const char* eaver[] = { nullptr, "z", "y", "x", nullptr };
     static const char* eunit[] = { nullptr, "nm-3", "nm-2", "count", nullptr };
+    const char*        espread[] = { nullptr, "nearest", "linear", "gauss", nullptr };
+    real               sigma     = 0.05;
+    int                nThreads  = 0;
 
     t_pargs pa[] = {
         { "-bin", FALSE, etREAL, { &bin }, "Grid size (nm)" },
@@ -116,6 +132,18 @@ int gmx_densmap(int argc, char* argv[])
         { "-unit", FALSE, etENUM, { eunit }, "Unit for the output" },
         { "-dmin", FALSE, etREAL, { &dmin }, "Minimum density in output" },
         { "-dmax", FALSE, etREAL, { &dmax }, "Maximum density in output (0 means calculate it)" },
+        { "-spread", FALSE, etENUM, { espread }, "How to distribute atoms over the grid cells" },
+        { "-sigma",
+          FALSE,
+          etREAL,
+          { &sigma },
+          "Width (nm) of the Gaussian used with [TT]-spread[tt] gauss" },
+        { "-nthreads",
+          FALSE,
+          etINT,
+          { &nThreads },
+          "Number of threads used for spreading the atoms. nThreads <= 0 means maximum number "
+          "of threads. Requires linking with OpenMP." },
     };
     gmx_bool          bXmin, bXmax, bRadial;
     FILE*             fp;
@@ -269,6 +297,16 @@ int gmx_densmap(int argc, char* argv[])
         snew(grid[i], n2);
     }
 
+    /* The planar map is periodic, with the grid cells scaling with the box */
+    const gmx::RVec sigmaInCells = bRadial ? gmx::RVec(sigma * invspa, sigma * invspz, 0)
+                                           : gmx::RVec(sigma * n1 / box[c1][c1],
+                                                       sigma * n2 / box[c2][c2], 0);
+    const int nthreads = std::min((nThreads <= 0) ? INT_MAX : nThreads, gmx_omp_get_max_threads());
+
+    gmx::DensityGridAccumulator accumulator(
+            gmx::IVec(n1, n2, 1), std::array<bool, DIM>{ { !bRadial, !bRadial, true } },
+            gmx::densitySpreadingFromName(espread[0]), sigmaInCells, nthreads);
+
     box1 = 0;
     box2 = 0;
     nfr  = 0;
@@ -310,7 +348,7 @@ int gmx_densmap(int argc, char* argv[])
                     {
                         m2 += 1;
                     }
-                    grid[static_cast<int>(m1 * n1)][static_cast<int>(m2 * n2)] += invcellvol;
+                    accumulator.add(gmx::RVec(m1 * n1, m2 * n2, 0), invcellvol);
                 }
             }
         }
@@ -360,7 +398,7 @@ int gmx_densmap(int argc, char* argv[])
                     {
                         r += rmax;
                     }
-                    grid[static_cast<int>((axial + amax) * invspa)][static_cast<int>(r * invspz)] += 1;
+                    accumulator.add(gmx::RVec((axial + amax) * invspa, r * invspz, 0), 1);
                 }
             }
         }
@@ -368,6 +406,15 @@ int gmx_densmap(int argc, char* argv[])
     } while (read_next_x(oenv, status, &t, x, box));
     close_trx(status);
 
+    gmx::ArrayRef<const double> values = accumulator.values();
+    for (i = 0; i < n1; i++)
+    {
+        for (j = 0; j < n2; j++)
+        {
+            grid[i][j] = values[accumulator.index(i, j, 0)];
+        }
+    }
+
     /* normalize gridpoints */
     maxgrid = 0;
     if (!bRadial)
@@ -41,10 +41,13 @@
 #include <cstring>
 
 #include <algorithm>
+#include <memory>
+#include <vector>
 
 #include "gromacs/commandline/pargs.h"
 #include "gromacs/commandline/viewit.h"
 #include "gromacs/correlationfunctions/autocorr.h"
+#include "gromacs/correlationfunctions/multipletaucorrelator.h"
 #include "gromacs/fileio/confio.h"
 #include "gromacs/fileio/enxio.h"
 #include "gromacs/fileio/matio.h"
@@ -739,6 +742,7 @@ static void do_dip(const t_topology*       top,
                    gmx_bool                bPairs,
                    const char*             corrtype,
                    const char*             corf,
+                   gmx_bool                bMtau,
                    gmx_bool                bGkr,
                    const char*             gkrfn,
                    gmx_bool                bPhi,
@@ -862,7 +866,14 @@ static void do_dip(const t_topology*       top,
     /* Correlation stuff */
     bCorr  = (corrtype[0] != 'n');
     bTotal = (corrtype[0] == 't');
-    if (bCorr)
+    std::unique_ptr<gmx::MultipleTauCorrelator> correlator;
+    std::vector<real>                           muSample;
+    if (bCorr && bMtau)
+    {
+        correlator = std::make_unique<gmx::MultipleTauCorrelator>(bTotal ? 1 : gnx_tot, DIM);
+        muSample.resize(correlator->numFunctions() * DIM);
+    }
+    else if (bCorr)
     {
         if (bTotal)
         {
@@ -1027,7 +1038,7 @@ static void do_dip(const t_topology*       top,
     teller = 0;
     do
     {
-        if (bCorr && (teller >= nframes))
+        if (bCorr && !bMtau && (teller >= nframes))
         {
             nframes += 1000;
             if (bTotal)
@@ -1095,7 +1106,11 @@ static void do_dip(const t_topology*       top,
                             gmx_stats_add_point(Qlsq[m], 0, quad[m], 0, 0);
                         }
                     }
-                    if (bCorr && !bTotal)
+                    if (bCorr && !bTotal && bMtau)
+                    {
+                        copy_rvec(dipole[i], &muSample[DIM * ((n == 0 ? 0 : gnx[0]) + i)]);
+                    }
+                    else if (bCorr && !bTotal)
                     {
                         tel3                = DIM * teller;
                         muall[i][tel3 + XX] = dipole[i][XX];
@@ -1217,13 +1232,24 @@ static void do_dip(const t_topology*       top,
             do_gkr(gkrbin, ncos, gnx, molindex, mols->index, x, dipole, pbcType, box, atom, gkatom);
         }
 
-        if (bTotal)
+        if (bTotal && bMtau)
+        {
+            for (m = 0; (m < DIM); m++)
+            {
+                muSample[m] = M_av[m];
+            }
+        }
+        else if (bTotal)
         {
             tel3                = DIM * teller;
             muall[0][tel3 + XX] = M_av[XX];
             muall[0][tel3 + YY] = M_av[YY];
             muall[0][tel3 + ZZ] = M_av[ZZ];
         }
+        if (bCorr && bMtau)
+        {
+            correlator->addSample(muSample);
+        }
 
         /* Write to file the total dipole moment of the box, and its components
          * for this frame.
@@ -1375,7 +1401,14 @@ static void do_dip(const t_topology*       top,
 
             mode = eacVector;
 
-            if (bTotal)
+            if (bMtau)
+            {
+                do_multipletau_autocorr(corf, oenv,
+                                        bTotal ? "Autocorrelation Function of Total Dipole"
+                                               : "Dipole Autocorrelation Function",
+                                        *correlator, dt, std::strcmp(corrtype, "molsep") != 0);
+            }
+            else if (bTotal)
             {
                 do_autocorr(corf, oenv, "Autocorrelation Function of Total Dipole", teller, 1,
                             muall, dt, mode, TRUE);
@@ -1505,7 +1538,12 @@ int gmx_dipoles(int argc, char* argv[])
         "The correlation functions can be averaged over all molecules",
         "([TT]mol[tt]), plotted per molecule separately ([TT]molsep[tt])",
         "or it can be computed over the total dipole moment of the simulation box",
-        "([TT]total[tt]).[PAR]",
+        "([TT]total[tt]).",
+        "With option [TT]-mtau[tt] the autocorrelation is computed while",
+        "reading the trajectory with a multiple-tau correlator, as in [gmx-velacc],",
+        "instead of storing the dipoles of all frames. Lags up to 15 frames are exact,",
+        "longer lags are computed from block averages and are spaced logarithmically.",
+        "This only supports [TT]-P 0[tt].[PAR]",
         "Option [TT]-g[tt] produces a plot of the distance dependent Kirkwood",
         "G-factor, as well as the average cosine of the angle between the dipoles",
         "as a function of the distance. The plot also includes gOO and hOO",
@@ -1525,7 +1563,7 @@ int gmx_dipoles(int argc, char* argv[])
     };
     real              mu_max = 5, mu_aver = -1, rcmax = 0;
     real              epsilonRF = 0.0, temp = 300;
-    gmx_bool          bPairs = TRUE, bPhi = FALSE, bQuad = FALSE;
+    gmx_bool          bPairs = TRUE, bPhi = FALSE, bQuad = FALSE, bMtau = FALSE;
     const char*       corrtype[] = { nullptr, "none", "mol", "molsep", "total", nullptr };
     const char*       axtitle    = "Z";
     int               nslices    = 10; /* nr of slices defined       */
@@ -1552,6 +1590,11 @@ int gmx_dipoles(int argc, char* argv[])
           { &temp },
           "Average temperature of the simulation (needed for dielectric constant calculation)" },
         { "-corr", FALSE, etENUM, { corrtype }, "Correlation function to calculate" },
+        { "-mtau",
+          FALSE,
+          etBOOL,
+          { &bMtau },
+          "Compute the correlation function on the fly with a multiple-tau correlator" },
         { "-pairs",
           FALSE,
           etBOOL,
@@ -1698,10 +1741,11 @@ int gmx_dipoles(int argc, char* argv[])
     do_dip(top, pbcType, det(box), ftp2fn(efTRX, NFILE, fnm), opt2fn("-o", NFILE, fnm),
            opt2fn("-eps", NFILE, fnm), opt2fn("-a", NFILE, fnm), opt2fn("-d", NFILE, fnm),
            opt2fn_null("-cos", NFILE, fnm), opt2fn_null("-dip3d", NFILE, fnm),
-           opt2fn_null("-adip", NFILE, fnm), bPairs, corrtype[0], opt2fn("-c", NFILE, fnm), bGkr,
-           opt2fn("-g", NFILE, fnm), bPhi, &nlevels, ndegrees, ncos, opt2fn("-cmap", NFILE, fnm),
-           rcmax, bQuad, bMU, opt2fn("-en", NFILE, fnm), gnx, grpindex, mu_max, mu_aver, epsilonRF,
-           temp, nFF, skip, bSlab, nslices, axtitle, opt2fn("-slab", NFILE, fnm), oenv);
+           opt2fn_null("-adip", NFILE, fnm), bPairs, corrtype[0], opt2fn("-c", NFILE, fnm), bMtau,
+           bGkr, opt2fn("-g", NFILE, fnm), bPhi, &nlevels, ndegrees, ncos,
+           opt2fn("-cmap", NFILE, fnm), rcmax, bQuad, bMU, opt2fn("-en", NFILE, fnm), gnx, grpindex,
+           mu_max, mu_aver, epsilonRF, temp, nFF, skip, bSlab, nslices, axtitle,
+           opt2fn("-slab", NFILE, fnm), oenv);
 
     do_view(oenv, opt2fn("-o", NFILE, fnm), "-autoscale xy -nxy");
     do_view(oenv, opt2fn("-eps", NFILE, fnm), "-autoscale xy -nxy");
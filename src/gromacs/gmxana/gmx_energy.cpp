@@ -48,6 +48,7 @@
 #include "gromacs/correlationfunctions/autocorr.h"
 #include "gromacs/fileio/enxio.h"
 #include "gromacs/fileio/gmxfio.h"
+#include "gromacs/fileio/timecontrol.h"
 #include "gromacs/fileio/tpxio.h"
 #include "gromacs/fileio/trxio.h"
 #include "gromacs/fileio/xvgr.h"
@@ -1894,6 +1895,31 @@ int gmx_energy(int argc, char* argv[])
     edat.bHaveSums = TRUE;
     snew(edat.s, nset);
 
+    /* Only decode the data that is used */
+    {
+        gmx_bool* bReadTerm;
+        gmx_bool  bReadBlock[enxNR] = { FALSE };
+
+        snew(bReadTerm, nre);
+        for (i = 0; i < nset; i++)
+        {
+            bReadTerm[set[i]] = TRUE;
+        }
+        if (bDHDL)
+        {
+            bReadBlock[enxDHCOLL] = TRUE;
+            bReadBlock[enxDHHIST] = TRUE;
+            bReadBlock[enxDH]     = TRUE;
+        }
+        enx_select_terms(fp, nre, bReadTerm);
+        enx_select_blocks(fp, bReadBlock);
+        sfree(bReadTerm);
+    }
+    if (bTimeSet(TBEGIN))
+    {
+        enx_seek_time(fp, rTimeValue(TBEGIN));
+    }
+
     /* Initiate counters */
     bFoundStart = FALSE;
     start_step  = 0;
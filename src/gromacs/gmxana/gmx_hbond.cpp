@@ -44,7 +44,9 @@
 #include <cstring>
 
 #include <algorithm>
+#include <map>
 #include <numeric>
+#include <vector>
 
 #include "gromacs/commandline/pargs.h"
 #include "gromacs/commandline/viewit.h"
@@ -63,6 +65,7 @@
 #include "gromacs/math/vec.h"
 #include "gromacs/mdtypes/inputrec.h"
 #include "gromacs/pbcutil/pbc.h"
+#include "gromacs/selection/nbsearch.h"
 #include "gromacs/topology/ifunc.h"
 #include "gromacs/topology/index.h"
 #include "gromacs/topology/topology.h"
@@ -108,8 +111,6 @@ static const unsigned char c_donorMask    = (1 << 1);
 static const unsigned char c_inGroupMask  = (1 << 2);
 
 
-static const char* grpnames[grNR] = { "0", "1", "I" };
-
 static gmx_bool bDebug = FALSE;
 
 #define HB_NO 0
@@ -126,21 +127,17 @@ static gmx_bool bDebug = FALSE;
 #define ISDON(h) ((h)&c_donorMask)
 #define ISINGRP(h) ((h)&c_inGroupMask)
 
-typedef struct
-{
-    int  nr;
-    int  maxnr;
-    int* atoms;
-} t_ncell;
+typedef int t_icell[grNR];
+typedef int h_id[MAXHYDRO];
 
+/* A run of consecutive frames [begin, end) in which a hbond is present,
+ * with frames counted from t_hbond::n0.
+ */
 typedef struct
 {
-    t_ncell d[grNR];
-    t_ncell a[grNR];
-} t_gridcell;
-
-typedef int t_icell[grNR];
-typedef int h_id[MAXHYDRO];
+    int begin;
+    int end;
+} t_hbrun;
 
 typedef struct
 {
@@ -148,13 +145,16 @@ typedef struct
     /* Has this hbond existed ever? If so as hbDist or hbHB or both.
      * Result is stored as a bitmap (1 = hbDist) || (2 = hbHB)
      */
-    /* Bitmask array which tells whether a hbond is present
-     * at a given time. Either of these may be NULL
+    /* Sorted, non-overlapping runs of frames which tell whether a hbond
+     * is present at a given time, one list per hydrogen. Hydrogen bonds
+     * persist over many frames, so the memory needed is set by the number
+     * of times a bond forms and breaks, not by the number of frames.
+     * Both are empty when the hbond has been merged into another one.
      */
-    int            n0;                 /* First frame a HB was found     */
-    int            nframes, maxframes; /* Amount of frames in this hbond */
-    unsigned int** h;
-    unsigned int** g;
+    int                               n0;      /* First frame a HB was found     */
+    int                               nframes; /* Amount of frames in this hbond */
+    std::vector<std::vector<t_hbrun>> h;
+    std::vector<std::vector<t_hbrun>> g;
     /* See Xu and Berne, JPCB 105 (2001), p. 11929. We define the
      * function g(t) = [1-h(t)] H(t) where H(t) is one when the donor-
      * acceptor distance is less than the user-specified distance (typically
@@ -184,7 +184,6 @@ typedef struct
 typedef struct
 {
     gmx_bool bHBmap, bDAnr;
-    int      wordlen;
     /* The following arrays are nframes long */
     int      nframes, max_frames, maxhydro;
     int *    nhb, *ndist;
@@ -195,9 +194,12 @@ typedef struct
     /* These structures are initialized from the topology at start up */
     t_donors    d;
     t_acceptors a;
-    /* This holds a matrix with all possible hydrogen bonds */
-    int        nrhb, nrdist;
-    t_hbond*** hbmap;
+    /* This holds for each donor the hydrogen bonds it has formed,
+     * keyed on acceptor index. Only pairs that have been found within
+     * the cut-off are stored.
+     */
+    int                     nrhb, nrdist;
+    std::map<int, t_hbond>* hbmap;
 } t_hbdata;
 
 /* Changed argument 'bMerge' into 'oneHB' below,
@@ -211,9 +213,8 @@ static t_hbdata* mk_hbdata(gmx_bool bHBmap, gmx_bool bDAnr, gmx_bool oneHB)
     t_hbdata* hb;
 
     snew(hb, 1);
-    hb->wordlen = 8 * sizeof(unsigned int);
-    hb->bHBmap  = bHBmap;
-    hb->bDAnr   = bDAnr;
+    hb->bHBmap = bHBmap;
+    hb->bDAnr  = bDAnr;
     if (oneHB)
     {
         hb->maxhydro = 1;
@@ -227,21 +228,7 @@ static t_hbdata* mk_hbdata(gmx_bool bHBmap, gmx_bool bDAnr, gmx_bool oneHB)
 
 static void mk_hbmap(t_hbdata* hb)
 {
-    int i, j;
-
-    snew(hb->hbmap, hb->d.nrd);
-    for (i = 0; (i < hb->d.nrd); i++)
-    {
-        snew(hb->hbmap[i], hb->a.nra);
-        if (hb->hbmap[i] == nullptr)
-        {
-            gmx_fatal(FARGS, "Could not allocate enough memory for hbmap");
-        }
-        for (j = 0; j < hb->a.nra; j++)
-        {
-            hb->hbmap[i][j] = nullptr;
-        }
-    }
+    hb->hbmap = new std::map<int, t_hbond>[hb->d.nrd];
 }
 
 static void add_frames(t_hbdata* hb, int nframes)
@@ -262,90 +249,107 @@ static void add_frames(t_hbdata* hb, int nframes)
     hb->nframes = nframes;
 }
 
-#define OFFSET(frame) ((frame) / 32)
-#define MASK(frame) (1 << ((frame) % 32))
+static gmx_bool is_hb(const std::vector<t_hbrun>& hbexist, int frame)
+{
+    auto next = std::upper_bound(hbexist.begin(), hbexist.end(), frame,
+                                 [](int f, const t_hbrun& run) { return f < run.begin; });
+
+    return next != hbexist.begin() && frame < (next - 1)->end;
+}
+
+/* Sorts the runs and joins those that overlap or touch */
+static void coalesce_hb(std::vector<t_hbrun>* hbexist)
+{
+    size_t n = 0;
+
+    std::sort(hbexist->begin(), hbexist->end(),
+              [](const t_hbrun& a, const t_hbrun& b) { return a.begin < b.begin; });
+    for (size_t i = 0; i < hbexist->size(); i++)
+    {
+        if (n > 0 && (*hbexist)[i].begin <= (*hbexist)[n - 1].end)
+        {
+            (*hbexist)[n - 1].end = std::max((*hbexist)[n - 1].end, (*hbexist)[i].end);
+        }
+        else
+        {
+            (*hbexist)[n++] = (*hbexist)[i];
+        }
+    }
+    hbexist->resize(n);
+}
 
-static void _set_hb(unsigned int hbexist[], unsigned int frame, gmx_bool bValue)
+static void _set_hb(std::vector<t_hbrun>* hbexist, int frame)
 {
-    if (bValue)
+    if (hbexist->empty() || frame > hbexist->back().end)
     {
-        hbexist[OFFSET(frame)] |= MASK(frame);
+        hbexist->push_back({ frame, frame + 1 });
     }
-    else
+    else if (frame == hbexist->back().end)
+    {
+        hbexist->back().end++;
+    }
+    else if (!is_hb(*hbexist, frame))
     {
-        hbexist[OFFSET(frame)] &= ~MASK(frame);
+        /* Frames normally arrive in order, so this is the rare case */
+        hbexist->push_back({ frame, frame + 1 });
+        coalesce_hb(hbexist);
     }
 }
 
-static gmx_bool is_hb(const unsigned int hbexist[], int frame)
+/* Sets v[j] for j < n to 1 when the hbond is present in frame j,
+ * looking no further than frame nlast, and to 0 otherwise.
+ */
+static void expand_hb(const std::vector<t_hbrun>& hbexist, int nlast, int n, real v[])
 {
-    return (hbexist[OFFSET(frame)] & MASK(frame)) != 0;
+    int end = std::min(nlast + 1, n);
+
+    std::fill(v, v + n, 0);
+    for (const t_hbrun& run : hbexist)
+    {
+        for (int j = run.begin; j < std::min(run.end, end); j++)
+        {
+            v[j] = 1;
+        }
+    }
 }
 
-static void set_hb(t_hbdata* hb, int id, int ih, int ia, int frame, int ihb)
+static void set_hb(t_hbond* hb, int ih, int frame, int ihb)
 {
-    unsigned int* ghptr = nullptr;
+    std::vector<t_hbrun>* ghptr = nullptr;
 
     if (ihb == hbHB)
     {
-        ghptr = hb->hbmap[id][ia]->h[ih];
+        ghptr = &hb->h[ih];
     }
     else if (ihb == hbDist)
     {
-        ghptr = hb->hbmap[id][ia]->g[ih];
+        ghptr = &hb->g[ih];
     }
     else
     {
         gmx_fatal(FARGS, "Incomprehensible iValue %d in set_hb", ihb);
     }
 
-    _set_hb(ghptr, frame - hb->hbmap[id][ia]->n0, TRUE);
+    _set_hb(ghptr, frame - hb->n0);
 }
 
-static void add_ff(t_hbdata* hbd, int id, int h, int ia, int frame, int ihb)
+static void add_ff(t_hbdata* hbd, t_hbond* hb, int id, int h, int frame, int ihb)
 {
-    int      i, j, n;
-    t_hbond* hb       = hbd->hbmap[id][ia];
-    int      maxhydro = std::min(hbd->maxhydro, hbd->d.nhydro[id]);
-    int      wlen     = hbd->wordlen;
-    int      delta    = 32 * wlen;
+    int maxhydro = std::min(hbd->maxhydro, hbd->d.nhydro[id]);
 
-    if (!hb->h[0])
+    if (hb->h.empty())
     {
-        hb->n0        = frame;
-        hb->maxframes = delta;
-        for (i = 0; (i < maxhydro); i++)
-        {
-            snew(hb->h[i], hb->maxframes / wlen);
-            snew(hb->g[i], hb->maxframes / wlen);
-        }
+        hb->n0 = frame;
+        hb->h.resize(maxhydro);
+        hb->g.resize(maxhydro);
     }
     else
     {
         hb->nframes = frame - hb->n0;
-        /* We need a while loop here because hbonds may be returning
-         * after a long time.
-         */
-        while (hb->nframes >= hb->maxframes)
-        {
-            n = hb->maxframes + delta;
-            for (i = 0; (i < maxhydro); i++)
-            {
-                srenew(hb->h[i], n / wlen);
-                srenew(hb->g[i], n / wlen);
-                for (j = hb->maxframes / wlen; (j < n / wlen); j++)
-                {
-                    hb->h[i][j] = 0;
-                    hb->g[i][j] = 0;
-                }
-            }
-
-            hb->maxframes = n;
-        }
     }
     if (frame >= 0)
     {
-        set_hb(hbd, id, h, ia, frame, ihb);
+        set_hb(hb, h, frame, ihb);
     }
 }
 
@@ -429,6 +433,7 @@ add_hbond(t_hbdata* hb, int d, int a, int h, int grpd, int grpa, int frame, gmx_
 {
     int      k, id, ia, hh;
     gmx_bool daSwap = FALSE;
+    t_hbond* hbond  = nullptr;
 
     if ((id = hb->d.dptr[d]) == NOTSET)
     {
@@ -514,13 +519,10 @@ add_hbond(t_hbdata* hb, int d, int a, int h, int grpd, int grpa, int frame, gmx_
             {
                 try
                 {
-                    if (hb->hbmap[id][ia] == nullptr)
-                    {
-                        snew(hb->hbmap[id][ia], 1);
-                        snew(hb->hbmap[id][ia]->h, hb->maxhydro);
-                        snew(hb->hbmap[id][ia]->g, hb->maxhydro);
-                    }
-                    add_ff(hb, id, k, ia, frame, ihb);
+                    /* The map of a donor may be modified by other threads,
+                     * so we only access it here. The hbond itself stays put. */
+                    hbond = &hb->hbmap[id][ia];
+                    add_ff(hb, hbond, id, k, frame, ihb);
                 }
                 GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR
             }
@@ -532,13 +534,13 @@ add_hbond(t_hbdata* hb, int d, int a, int h, int grpd, int grpa, int frame, gmx_
          */
         if (frame >= 0)
         {
-            hh = hb->hbmap[id][ia]->history[k];
+            hh = hbond->history[k];
             if (ihb == hbHB)
             {
                 hb->nhb[frame]++;
                 if (!(ISHB(hh)))
                 {
-                    hb->hbmap[id][ia]->history[k] = hh | 2;
+                    hbond->history[k] = hh | 2;
                     hb->nrhb++;
                 }
             }
@@ -549,7 +551,7 @@ add_hbond(t_hbdata* hb, int d, int a, int h, int grpd, int grpa, int frame, gmx_
                     hb->ndist[frame]++;
                     if (!(ISDIST(hh)))
                     {
-                        hb->hbmap[id][ia]->history[k] = hh | 1;
+                        hbond->history[k] = hh | 1;
                         hb->nrdist++;
                     }
                 }
@@ -878,416 +880,163 @@ static void search_donors(const t_topology* top,
     }
 }
 
-static t_gridcell*** init_grid(gmx_bool bBox, rvec box[], real rcut, ivec ngrid)
+static void reset_nhbonds(t_donors* ddd)
 {
-    t_gridcell*** grid;
-    int           i, y, z;
+    int i, j;
 
-    if (bBox)
+    for (i = 0; (i < ddd->nrd); i++)
     {
-        for (i = 0; i < DIM; i++)
+        for (j = 0; (j < MAXHH); j++)
         {
-            ngrid[i] = static_cast<int>(box[i][i] / (1.2 * rcut));
+            ddd->nhbonds[i][j] = 0;
         }
     }
+}
 
-    if (!bBox || (ngrid[XX] < 3) || (ngrid[YY] < 3) || (ngrid[ZZ] < 3))
+/* The donors and acceptors that are searched in the current frame,
+ * which are those inside the shell, or all of them without a shell.
+ * The acceptors of each group are put in a neighborhood search.
+ */
+typedef struct
+{
+    std::vector<int>                don[grNR]; /* Donor indices         */
+    std::vector<int>                acc[grNR]; /* Acceptor atom numbers */
+    gmx::AnalysisNeighborhoodSearch search[grNR];
+} t_hbsearch;
+
+/* Computes dx = x1 - x2, with periodic boundary conditions when pbc is set */
+static void hb_dx(const t_pbc* pbc, const rvec x1, const rvec x2, rvec dx)
+{
+    if (pbc)
     {
-        for (i = 0; i < DIM; i++)
-        {
-            ngrid[i] = 1;
-        }
+        pbc_dx(pbc, x1, x2, dx);
     }
     else
     {
-        printf("\nWill do grid-search on %dx%dx%d grid, rcut=%3.8f\n", ngrid[XX], ngrid[YY],
-               ngrid[ZZ], rcut);
-    }
-    if (((ngrid[XX] * ngrid[YY] * ngrid[ZZ]) * sizeof(grid)) > INT_MAX)
-    {
-        gmx_fatal(FARGS,
-                  "Failed to allocate memory for %d x %d x %d grid points, which is larger than "
-                  "the maximum of %zu. "
-                  "You are likely either using a box that is too large (box dimensions are %3.8f "
-                  "nm x%3.8f nm x%3.8f nm) or a cutoff (%3.8f nm) that is too small.",
-                  ngrid[XX], ngrid[YY], ngrid[ZZ], INT_MAX / sizeof(grid), box[XX][XX], box[YY][YY],
-                  box[ZZ][ZZ], rcut);
+        rvec_sub(x1, x2, dx);
     }
-    snew(grid, ngrid[ZZ]);
-    for (z = 0; z < ngrid[ZZ]; z++)
-    {
-        snew((grid)[z], ngrid[YY]);
-        for (y = 0; y < ngrid[YY]; y++)
-        {
-            snew((grid)[z][y], ngrid[XX]);
-        }
-    }
-    return grid;
 }
 
-static void reset_nhbonds(t_donors* ddd)
+static gmx_bool in_shell(const t_pbc* pbc, const rvec x, const rvec xshell, real rshell)
 {
-    int i, j;
+    rvec dshell;
 
-    for (i = 0; (i < ddd->nrd); i++)
+    /* Without a shell everything is inside */
+    if (rshell <= 0)
     {
-        for (j = 0; (j < MAXHH); j++)
-        {
-            ddd->nhbonds[i][j] = 0;
-        }
+        return TRUE;
     }
+    hb_dx(pbc, x, xshell, dshell);
+
+    return norm2(dshell) < gmx::square(rshell);
 }
 
-static void pbc_correct_gem(rvec dx, matrix box, const rvec hbox);
-static void pbc_in_gridbox(rvec dx, matrix box);
-
-static void build_grid(t_hbdata*     hb,
-                       rvec          x[],
-                       rvec          xshell,
-                       gmx_bool      bBox,
-                       matrix        box,
-                       rvec          hbox,
-                       real          rcut,
-                       real          rshell,
-                       ivec          ngrid,
-                       t_gridcell*** grid)
+static void build_search(gmx::AnalysisNeighborhood* nb,
+                         t_hbsearch*                search,
+                         const t_hbdata*            hb,
+                         int                        natoms,
+                         const rvec                 x[],
+                         const t_pbc*               pbc,
+                         const rvec                 xshell,
+                         real                       rshell)
 {
-    int      i, m, gr, xi, yi, zi, nr;
-    int*     ad;
-    ivec     grididx;
-    rvec     invdelta, dshell;
-    t_ncell* newgrid;
-    gmx_bool bDoRshell, bInShell;
-    real     rshell2 = 0;
-    int      gx, gy, gz;
-    int      dum = -1;
-
-    bDoRshell = (rshell > 0);
-    rshell2   = gmx::square(rshell);
-    bInShell  = TRUE;
-
-#define DBB(x)           \
-    if (debug && bDebug) \
-    fprintf(debug, "build_grid, line %d, %s = %d\n", __LINE__, #x, x)
-    DBB(dum);
-    for (m = 0; m < DIM; m++)
-    {
-        hbox[m] = box[m][m] * 0.5;
-        if (bBox)
-        {
-            invdelta[m] = ngrid[m] / box[m][m];
-            if (1 / invdelta[m] < rcut)
-            {
-                gmx_fatal(FARGS,
-                          "Your computational box has shrunk too much.\n"
-                          "%s can not handle this situation, sorry.\n",
-                          gmx::getProgramContext().displayName());
-            }
-        }
-        else
-        {
-            invdelta[m] = 0;
-        }
-    }
-    grididx[XX] = 0;
-    grididx[YY] = 0;
-    grididx[ZZ] = 0;
-    DBB(dum);
-    /* resetting atom counts */
+    int gr, i;
+
     for (gr = 0; (gr < grNR); gr++)
     {
-        for (zi = 0; zi < ngrid[ZZ]; zi++)
+        search->don[gr].clear();
+        search->acc[gr].clear();
+    }
+    for (i = 0; (i < hb->d.nrd); i++)
+    {
+        if (in_shell(pbc, x[hb->d.don[i]], xshell, rshell))
         {
-            for (yi = 0; yi < ngrid[YY]; yi++)
-            {
-                for (xi = 0; xi < ngrid[XX]; xi++)
-                {
-                    grid[zi][yi][xi].d[gr].nr = 0;
-                    grid[zi][yi][xi].a[gr].nr = 0;
-                }
-            }
+            search->don[hb->d.grp[i]].push_back(i);
         }
-        DBB(dum);
-
-        /* put atoms in grid cells */
-        for (int acc = 0; acc < 2; acc++)
+    }
+    for (i = 0; (i < hb->a.nra); i++)
+    {
+        if (in_shell(pbc, x[hb->a.acc[i]], xshell, rshell))
         {
-            if (acc == 1)
-            {
-                nr = hb->a.nra;
-                ad = hb->a.acc;
-            }
-            else
-            {
-                nr = hb->d.nrd;
-                ad = hb->d.don;
-            }
-            DBB(acc);
-            for (i = 0; (i < nr); i++)
-            {
-                /* check if we are inside the shell */
-                /* if bDoRshell=FALSE then bInShell=TRUE always */
-                DBB(i);
-                if (bDoRshell)
-                {
-                    bInShell = TRUE;
-                    rvec_sub(x[ad[i]], xshell, dshell);
-                    if (bBox)
-                    {
-                        gmx_bool bDone = FALSE;
-                        while (!bDone)
-                        {
-                            bDone = TRUE;
-                            for (m = DIM - 1; m >= 0 && bInShell; m--)
-                            {
-                                if (dshell[m] < -hbox[m])
-                                {
-                                    bDone = FALSE;
-                                    rvec_inc(dshell, box[m]);
-                                }
-                                if (dshell[m] >= hbox[m])
-                                {
-                                    bDone = FALSE;
-                                    dshell[m] -= 2 * hbox[m];
-                                }
-                            }
-                        }
-                        for (m = DIM - 1; m >= 0 && bInShell; m--)
-                        {
-                            /* if we're outside the cube, we're outside the sphere also! */
-                            if ((dshell[m] > rshell) || (-dshell[m] > rshell))
-                            {
-                                bInShell = FALSE;
-                            }
-                        }
-                    }
-                    /* if we're inside the cube, check if we're inside the sphere */
-                    if (bInShell)
-                    {
-                        bInShell = norm2(dshell) < rshell2;
-                    }
-                }
-                DBB(i);
-                if (bInShell)
-                {
-                    if (bBox)
-                    {
-                        pbc_in_gridbox(x[ad[i]], box);
-
-                        for (m = DIM - 1; m >= 0; m--)
-                        { /* determine grid index of atom */
-                            grididx[m] = static_cast<int>(x[ad[i]][m] * invdelta[m]);
-                            grididx[m] = (grididx[m] + ngrid[m]) % ngrid[m];
-                        }
-                    }
-
-                    gx = grididx[XX];
-                    gy = grididx[YY];
-                    gz = grididx[ZZ];
-                    range_check(gx, 0, ngrid[XX]);
-                    range_check(gy, 0, ngrid[YY]);
-                    range_check(gz, 0, ngrid[ZZ]);
-                    DBB(gx);
-                    DBB(gy);
-                    DBB(gz);
-                    /* add atom to grid cell */
-                    if (acc == 1)
-                    {
-                        newgrid = &(grid[gz][gy][gx].a[gr]);
-                    }
-                    else
-                    {
-                        newgrid = &(grid[gz][gy][gx].d[gr]);
-                    }
-                    if (newgrid->nr >= newgrid->maxnr)
-                    {
-                        newgrid->maxnr += 10;
-                        DBB(newgrid->maxnr);
-                        srenew(newgrid->atoms, newgrid->maxnr);
-                    }
-                    DBB(newgrid->nr);
-                    newgrid->atoms[newgrid->nr] = ad[i];
-                    newgrid->nr++;
-                }
-            }
+            search->acc[hb->a.grp[i]].push_back(hb->a.acc[i]);
         }
     }
-}
-
-static void count_da_grid(const ivec ngrid, t_gridcell*** grid, t_icell danr)
-{
-    int gr, xi, yi, zi;
-
     for (gr = 0; (gr < grNR); gr++)
     {
-        danr[gr] = 0;
-        for (zi = 0; zi < ngrid[ZZ]; zi++)
+        search->search[gr].reset();
+        if (!search->acc[gr].empty())
         {
-            for (yi = 0; yi < ngrid[YY]; yi++)
-            {
-                for (xi = 0; xi < ngrid[XX]; xi++)
-                {
-                    danr[gr] += grid[zi][yi][xi].d[gr].nr;
-                }
-            }
+            search->search[gr] = nb->initSearch(
+                    pbc, gmx::AnalysisNeighborhoodPositions(x, natoms).indexed(search->acc[gr]));
         }
     }
 }
 
-/* The grid loop.
- * Without a box, the grid is 1x1x1, so all loops are 1 long.
- * With a rectangular box (bTric==FALSE) all loops are 3 long.
- * With a triclinic box all loops are 3 long, except when a cell is
- * located next to one of the box edges which is not parallel to the
- * x/y-plane, in that case all cells in a line or layer are searched.
- * This could be implemented slightly more efficient, but the code
- * would get much more complicated.
- */
-static inline int grid_loop_begin(int n, int x, gmx_bool bTric, gmx_bool bEdge)
-{
-    return ((n == 1) ? x : bTric && bEdge ? 0 : (x - 1));
-}
-static inline int grid_loop_end(int n, int x, gmx_bool bTric, gmx_bool bEdge)
-{
-    return ((n == 1) ? x : bTric && bEdge ? (n - 1) : (x + 1));
-}
-static inline int grid_mod(int j, int n)
-{
-    return (j + n) % (n);
-}
-
-static void dump_grid(FILE* fp, ivec ngrid, t_gridcell*** grid)
+static void count_da_search(const t_hbsearch* search, t_icell danr)
 {
-    int gr, x, y, z, sum[grNR];
+    int gr;
 
-    fprintf(fp, "grid %dx%dx%d\n", ngrid[XX], ngrid[YY], ngrid[ZZ]);
-    for (gr = 0; gr < grNR; gr++)
-    {
-        sum[gr] = 0;
-        fprintf(fp, "GROUP %d (%s)\n", gr, grpnames[gr]);
-        for (z = 0; z < ngrid[ZZ]; z += 2)
-        {
-            fprintf(fp, "Z=%d,%d\n", z, z + 1);
-            for (y = 0; y < ngrid[YY]; y++)
-            {
-                for (x = 0; x < ngrid[XX]; x++)
-                {
-                    fprintf(fp, "%3d", grid[x][y][z].d[gr].nr);
-                    sum[gr] += grid[z][y][x].d[gr].nr;
-                    fprintf(fp, "%3d", grid[x][y][z].a[gr].nr);
-                    sum[gr] += grid[z][y][x].a[gr].nr;
-                }
-                fprintf(fp, " | ");
-                if ((z + 1) < ngrid[ZZ])
-                {
-                    for (x = 0; x < ngrid[XX]; x++)
-                    {
-                        fprintf(fp, "%3d", grid[z + 1][y][x].d[gr].nr);
-                        sum[gr] += grid[z + 1][y][x].d[gr].nr;
-                        fprintf(fp, "%3d", grid[z + 1][y][x].a[gr].nr);
-                        sum[gr] += grid[z + 1][y][x].a[gr].nr;
-                    }
-                }
-                fprintf(fp, "\n");
-            }
-        }
-    }
-    fprintf(fp, "TOTALS:");
-    for (gr = 0; gr < grNR; gr++)
+    for (gr = 0; (gr < grNR); gr++)
     {
-        fprintf(fp, " %d=%d", gr, sum[gr]);
+        danr[gr] = gmx::ssize(search->don[gr]);
     }
-    fprintf(fp, "\n");
 }
 
-/* New GMX record! 5 * in a row. Congratulations!
- * Sorry, only four left.
+/* Returns the acceptor atoms of group grpa that are within the search
+ * cut-off of donor id or, with !bDA, of any of its hydrogens.
  */
-static void free_grid(const ivec ngrid, t_gridcell**** grid)
+static void find_acceptors(const t_hbsearch* search,
+                           const t_hbdata*   hb,
+                           int               id,
+                           int               grpa,
+                           const rvec        x[],
+                           gmx_bool          bDA,
+                           std::vector<int>* acc)
 {
-    int           y, z;
-    t_gridcell*** g = *grid;
+    gmx::AnalysisNeighborhoodPair pair;
+    int                           h;
 
-    for (z = 0; z < ngrid[ZZ]; z++)
+    acc->clear();
+    if (search->acc[grpa].empty())
     {
-        for (y = 0; y < ngrid[YY]; y++)
-        {
-            sfree(g[z][y]);
-        }
-        sfree(g[z]);
+        return;
     }
-    sfree(g);
-    g = nullptr;
-}
-
-static void pbc_correct_gem(rvec dx, matrix box, const rvec hbox)
-{
-    int      m;
-    gmx_bool bDone = FALSE;
-    while (!bDone)
+    for (h = 0; (h < (bDA ? 1 : hb->d.nhydro[id])); h++)
     {
-        bDone = TRUE;
-        for (m = DIM - 1; m >= 0; m--)
-        {
-            if (dx[m] < -hbox[m])
-            {
-                bDone = FALSE;
-                rvec_inc(dx, box[m]);
-            }
-            if (dx[m] >= hbox[m])
-            {
-                bDone = FALSE;
-                rvec_dec(dx, box[m]);
-            }
-        }
-    }
-}
+        const int atom = bDA ? hb->d.don[id] : hb->d.hydro[id][h];
 
-static void pbc_in_gridbox(rvec dx, matrix box)
-{
-    int      m;
-    gmx_bool bDone = FALSE;
-    while (!bDone)
-    {
-        bDone = TRUE;
-        for (m = DIM - 1; m >= 0; m--)
+        gmx::AnalysisNeighborhoodPairSearch pairSearch = search->search[grpa].startPairSearch(
+                gmx::AnalysisNeighborhoodPositions(x[atom]));
+        while (pairSearch.findNextPair(&pair))
         {
-            if (dx[m] < 0)
-            {
-                bDone = FALSE;
-                rvec_inc(dx, box[m]);
-            }
-            if (dx[m] >= box[m][m])
-            {
-                bDone = FALSE;
-                rvec_dec(dx, box[m]);
-            }
+            acc->push_back(search->acc[grpa][pair.refIndex()]);
         }
     }
+    /* An acceptor can be close to several hydrogens of the same donor */
+    std::sort(acc->begin(), acc->end());
+    acc->erase(std::unique(acc->begin(), acc->end()), acc->end());
 }
 
 /* Added argument r2cut, changed contact and implemented
  * use of second cut-off.
  * - Erik Marklund, June 29, 2006
  */
-static int is_hbond(t_hbdata* hb,
-                    int       grpd,
-                    int       grpa,
-                    int       d,
-                    int       a,
-                    real      rcut,
-                    real      r2cut,
-                    real      ccut,
-                    rvec      x[],
-                    gmx_bool  bBox,
-                    matrix    box,
-                    rvec      hbox,
-                    real*     d_ha,
-                    real*     ang,
-                    gmx_bool  bDA,
-                    int*      hhh,
-                    gmx_bool  bContact,
-                    gmx_bool  bMerge)
+static int is_hbond(t_hbdata*    hb,
+                    int          grpd,
+                    int          grpa,
+                    int          d,
+                    int          a,
+                    real         rcut,
+                    real         r2cut,
+                    real         ccut,
+                    const rvec   x[],
+                    const t_pbc* pbc,
+                    real*        d_ha,
+                    real*        ang,
+                    gmx_bool     bDA,
+                    int*         hhh,
+                    gmx_bool     bContact,
+                    gmx_bool     bMerge)
 {
     int      h, hh, id;
     rvec     r_da, r_ha, r_dh;
@@ -1308,7 +1057,7 @@ static int is_hbond(t_hbdata* hb,
     rc2  = rcut * rcut;
     r2c2 = r2cut * r2cut;
 
-    rvec_sub(x[d], x[a], r_da);
+    hb_dx(pbc, x[d], x[a], r_da);
     /* Insert projection code here */
 
     if (bMerge && d > a && isInterchangable(hb, d, a, grpd, grpa))
@@ -1316,14 +1065,13 @@ static int is_hbond(t_hbdata* hb,
         /* Then this hbond/contact will be found again, or it has already been found. */
         /*return hbNo;*/
     }
-    if (bBox)
+    if (pbc)
     {
         if (d > a && bMerge
             && isInterchangable(hb, d, a, grpd, grpa)) /* acceptor is also a donor and vice versa? */
         {                                              /* return hbNo; */
             daSwap = TRUE; /* If so, then their history should be filed with donor and acceptor swapped. */
         }
-        pbc_correct_gem(r_da, box, hbox);
     }
     rda2 = iprod(r_da, r_da);
 
@@ -1359,21 +1107,13 @@ static int is_hbond(t_hbdata* hb,
         rha2 = rc2 + 1;
         if (!bDA)
         {
-            rvec_sub(x[hh], x[a], r_ha);
-            if (bBox)
-            {
-                pbc_correct_gem(r_ha, box, hbox);
-            }
+            hb_dx(pbc, x[hh], x[a], r_ha);
             rha2 = iprod(r_ha, r_ha);
         }
 
         if (bDA || (rha2 <= rc2))
         {
-            rvec_sub(x[d], x[hh], r_dh);
-            if (bBox)
-            {
-                pbc_correct_gem(r_dh, box, hbox);
-            }
+            hb_dx(pbc, x[d], x[hh], r_dh);
 
             if (!bDA)
             {
@@ -1400,72 +1140,48 @@ static int is_hbond(t_hbdata* hb,
     }
 }
 
+/* Shifts the runs in hbexist by shift frames and adds those in other,
+ * shifted by otherShift frames.
+ */
+static void merge_hbexist(std::vector<t_hbrun>* hbexist, int shift, const std::vector<t_hbrun>& other, int otherShift)
+{
+    for (t_hbrun& run : *hbexist)
+    {
+        run.begin += shift;
+        run.end += shift;
+    }
+    for (const t_hbrun& run : other)
+    {
+        hbexist->push_back({ run.begin + otherShift, run.end + otherShift });
+    }
+    coalesce_hb(hbexist);
+}
+
 /* Merging is now done on the fly, so do_merge is most likely obsolete now.
  * Will do some more testing before removing the function entirely.
  * - Erik Marklund, MAY 10 2010 */
-static void do_merge(t_hbdata* hb, int ntmp, bool htmp[], bool gtmp[], t_hbond* hb0, t_hbond* hb1)
+static void do_merge(t_hbond* hb0, t_hbond* hb1)
 {
     /* Here we need to make sure we're treating periodicity in
      * the right way for the geminate recombination kinetics. */
 
-    int m, mm, n00, n01, nn0, nnframes;
+    int n00, n01, nn0;
 
     /* Decide where to start from when merging */
-    n00      = hb0->n0;
-    n01      = hb1->n0;
-    nn0      = std::min(n00, n01);
-    nnframes = std::max(n00 + hb0->nframes, n01 + hb1->nframes) - nn0;
-    /* Initiate tmp arrays */
-    for (m = 0; (m < ntmp); m++)
-    {
-        htmp[m] = false;
-        gtmp[m] = false;
-    }
-    /* Fill tmp arrays with values due to first HB */
-    /* Once again '<' had to be replaced with '<='
-       to catch the last frame in which the hbond
-       appears.
-       - Erik Marklund, June 1, 2006 */
-    for (m = 0; (m <= hb0->nframes); m++)
-    {
-        mm       = m + n00 - nn0;
-        htmp[mm] = is_hb(hb0->h[0], m);
-    }
-    for (m = 0; (m <= hb0->nframes); m++)
-    {
-        mm       = m + n00 - nn0;
-        gtmp[mm] = is_hb(hb0->g[0], m);
-    }
-    /* Next HB */
-    for (m = 0; (m <= hb1->nframes); m++)
-    {
-        mm       = m + n01 - nn0;
-        htmp[mm] = htmp[mm] || is_hb(hb1->h[0], m);
-        gtmp[mm] = gtmp[mm] || is_hb(hb1->g[0], m);
-    }
-    /* Reallocate target array */
-    if (nnframes > hb0->maxframes)
-    {
-        srenew(hb0->h[0], 4 + nnframes / hb->wordlen);
-        srenew(hb0->g[0], 4 + nnframes / hb->wordlen);
-    }
+    n00 = hb0->n0;
+    n01 = hb1->n0;
+    nn0 = std::min(n00, n01);
 
-    /* Copy temp array to target array */
-    for (m = 0; (m <= nnframes); m++)
-    {
-        _set_hb(hb0->h[0], m, htmp[m]);
-        _set_hb(hb0->g[0], m, gtmp[m]);
-    }
+    merge_hbexist(&hb0->h[0], n00 - nn0, hb1->h[0], n01 - nn0);
+    merge_hbexist(&hb0->g[0], n00 - nn0, hb1->g[0], n01 - nn0);
 
     /* Set scalar variables */
-    hb0->n0        = nn0;
-    hb0->maxframes = nnframes;
+    hb0->n0 = nn0;
 }
 
 static void merge_hb(t_hbdata* hb, gmx_bool bTwo, gmx_bool bContact)
 {
-    int      i, inrnew, indnew, j, ii, jj, id, ia, ntmp;
-    bool *   htmp, *gtmp;
+    int      i, inrnew, indnew, j, ii, jj, id, ia;
     t_hbond *hb0, *hb1;
 
     inrnew = hb->nrhb;
@@ -1474,27 +1190,27 @@ static void merge_hb(t_hbdata* hb, gmx_bool bTwo, gmx_bool bContact)
     /* Check whether donors are also acceptors */
     printf("Merging hbonds with Acceptor and Donor swapped\n");
 
-    ntmp = 2 * hb->max_frames;
-    snew(gtmp, ntmp);
-    snew(htmp, ntmp);
     for (i = 0; (i < hb->d.nrd); i++)
     {
         fprintf(stderr, "\r%d/%d", i + 1, hb->d.nrd);
         fflush(stderr);
         id = hb->d.don[i];
         ii = hb->a.aptr[id];
-        for (j = 0; (j < hb->a.nra); j++)
+        for (auto& entry : hb->hbmap[i])
         {
+            j  = entry.first;
             ia = hb->a.acc[j];
             jj = hb->d.dptr[ia];
             if ((id != ia) && (ii != NOTSET) && (jj != NOTSET)
                 && (!bTwo || (hb->d.grp[i] != hb->a.grp[j])))
             {
-                hb0 = hb->hbmap[i][j];
-                hb1 = hb->hbmap[jj][ii];
-                if (hb0 && hb1 && ISHB(hb0->history[0]) && ISHB(hb1->history[0]))
+                auto swapped = hb->hbmap[jj].find(ii);
+
+                hb0 = &entry.second;
+                hb1 = (swapped != hb->hbmap[jj].end()) ? &swapped->second : nullptr;
+                if (hb1 && ISHB(hb0->history[0]) && ISHB(hb1->history[0]))
                 {
-                    do_merge(hb, ntmp, htmp, gtmp, hb0, hb1);
+                    do_merge(hb0, hb1);
                     if (ISHB(hb1->history[0]))
                     {
                         inrnew--;
@@ -1511,10 +1227,8 @@ static void merge_hb(t_hbdata* hb, gmx_bool bTwo, gmx_bool bContact)
                     {
                         gmx_incons("Neither hydrogen bond nor distance");
                     }
-                    sfree(hb1->h[0]);
-                    sfree(hb1->g[0]);
-                    hb1->h[0]       = nullptr;
-                    hb1->g[0]       = nullptr;
+                    hb1->h.clear();
+                    hb1->g.clear();
                     hb1->history[0] = hbNo;
                 }
             }
@@ -1525,8 +1239,6 @@ static void merge_hb(t_hbdata* hb, gmx_bool bTwo, gmx_bool bContact)
     printf("- Reduced number of distances from %d to %d\n", hb->nrdist, indnew);
     hb->nrhb   = inrnew;
     hb->nrdist = indnew;
-    sfree(gtmp);
-    sfree(htmp);
 }
 
 static void do_nhb_dist(FILE* fp, t_hbdata* hb, real t)
@@ -1558,75 +1270,54 @@ static void do_nhb_dist(FILE* fp, t_hbdata* hb, real t)
 
 static void do_hblife(const char* fn, t_hbdata* hb, gmx_bool bMerge, gmx_bool bContact, const gmx_output_env_t* oenv)
 {
-    FILE*          fp;
-    const char*    leg[] = { "p(t)", "t p(t)" };
-    int*           histo;
-    int            i, j, j0, k, m, nh, ihb, ohb, nhydro, ndump = 0;
-    int            nframes = hb->nframes;
-    unsigned int** h;
-    real           t, x1, dt;
-    double         sum, integral;
-    t_hbond*       hbh;
+    FILE*                                    fp;
+    const char*                              leg[] = { "p(t)", "t p(t)" };
+    int*                                     histo;
+    int                                      i, j0, m, nh, nhydro;
+    int                                      nframes = hb->nframes;
+    std::vector<const std::vector<t_hbrun>*> h(hb->maxhydro);
+    real                                     t, x1, dt;
+    double                                   sum, integral;
+    const t_hbond*                           hbh;
 
-    snew(h, hb->maxhydro);
     snew(histo, nframes + 1);
     /* Total number of hbonds analyzed here */
     for (i = 0; (i < hb->d.nrd); i++)
     {
-        for (k = 0; (k < hb->a.nra); k++)
+        for (const auto& entry : hb->hbmap[i])
         {
-            hbh = hb->hbmap[i][k];
-            if (hbh)
+            hbh = &entry.second;
+            if (bMerge)
             {
-                if (bMerge)
+                if (!hbh->h.empty())
                 {
-                    if (hbh->h[0])
-                    {
-                        h[0]   = hbh->h[0];
-                        nhydro = 1;
-                    }
-                    else
-                    {
-                        nhydro = 0;
-                    }
+                    h[0]   = &hbh->h[0];
+                    nhydro = 1;
                 }
                 else
                 {
                     nhydro = 0;
-                    for (m = 0; (m < hb->maxhydro); m++)
-                    {
-                        if (hbh->h[m])
-                        {
-                            h[nhydro++] = bContact ? hbh->g[m] : hbh->h[m];
-                        }
-                    }
                 }
-                for (nh = 0; (nh < nhydro); nh++)
+            }
+            else
+            {
+                nhydro = 0;
+                for (m = 0; (m < gmx::ssize(hbh->h)); m++)
                 {
-                    ohb = 0;
-                    j0  = 0;
-
-                    for (j = 0; (j <= hbh->nframes); j++)
+                    h[nhydro++] = bContact ? &hbh->g[m] : &hbh->h[m];
+                }
+            }
+            for (nh = 0; (nh < nhydro); nh++)
+            {
+                /* Only count the periods that ended before the last
+                 * frame this pair was seen in.
+                 */
+                for (const t_hbrun& run : *h[nh])
+                {
+                    if (run.end <= hbh->nframes)
                     {
-                        ihb = static_cast<int>(is_hb(h[nh], j));
-                        if (debug && (ndump < 10))
-                        {
-                            fprintf(debug, "%5d  %5d\n", j, ihb);
-                        }
-                        if (ihb != ohb)
-                        {
-                            if (ihb)
-                            {
-                                j0 = j;
-                            }
-                            else
-                            {
-                                histo[j - j0]++;
-                            }
-                            ohb = ihb;
-                        }
+                        histo[run.end - run.begin]++;
                     }
-                    ndump++;
                 }
             }
         }
@@ -1669,17 +1360,16 @@ static void do_hblife(const char* fn, t_hbdata* hb, gmx_bool bMerge, gmx_bool bC
     printf("Note that the lifetime obtained in this manner is close to useless\n");
     printf("Use the -ac option instead and check the Forward lifetime\n");
     please_cite(stdout, "Spoel2006b");
-    sfree(h);
     sfree(histo);
 }
 
 static void dump_ac(t_hbdata* hb, gmx_bool oneHB, int nDump)
 {
-    FILE*    fp;
-    int      i, j, k, m, nd, ihb, idist;
-    int      nframes = hb->nframes;
-    gmx_bool bPrint;
-    t_hbond* hbh;
+    FILE*          fp;
+    int            i, j, m, nd, ihb, idist;
+    int            nframes = hb->nframes;
+    gmx_bool       bPrint;
+    const t_hbond* hbh;
 
     if (nDump <= 0)
     {
@@ -1691,14 +1381,15 @@ static void dump_ac(t_hbdata* hb, gmx_bool oneHB, int nDump)
         fprintf(fp, "%10.3f", hb->time[j]);
         for (i = nd = 0; (i < hb->d.nrd) && (nd < nDump); i++)
         {
-            for (k = 0; (k < hb->a.nra) && (nd < nDump); k++)
+            for (auto entry = hb->hbmap[i].begin(); (entry != hb->hbmap[i].end()) && (nd < nDump);
+                 ++entry)
             {
                 bPrint = FALSE;
                 ihb = idist = 0;
-                hbh         = hb->hbmap[i][k];
+                hbh         = &entry->second;
                 if (oneHB)
                 {
-                    if (hbh->h[0])
+                    if (!hbh->h.empty())
                     {
                         ihb    = static_cast<int>(is_hb(hbh->h[0], j));
                         idist  = static_cast<int>(is_hb(hbh->g[0], j));
@@ -1707,12 +1398,10 @@ static void dump_ac(t_hbdata* hb, gmx_bool oneHB, int nDump)
                 }
                 else
                 {
-                    for (m = 0; (m < hb->maxhydro) && !ihb; m++)
+                    for (m = 0; (m < gmx::ssize(hbh->h)) && !ihb; m++)
                     {
-                        ihb   = static_cast<int>((ihb != 0)
-                                               || (((hbh->h[m]) != nullptr) && is_hb(hbh->h[m], j)));
-                        idist = static_cast<int>((idist != 0)
-                                                 || (((hbh->g[m]) != nullptr) && is_hb(hbh->g[m], j)));
+                        ihb   = static_cast<int>((ihb != 0) || is_hb(hbh->h[m], j));
+                        idist = static_cast<int>((idist != 0) || is_hb(hbh->g[m], j));
                     }
                     /* This is not correct! */
                     /* What isn't correct? -Erik M */
@@ -1971,7 +1660,7 @@ static void do_hbac(const char*             fn,
                     int                     nThreads)
 {
     FILE* fp;
-    int   i, j, k, m, ihb, idist, n2, nn;
+    int   i, j, m, n2, nn;
 
     const char* legLuzar[] = { "Ac\\sfin sys\\v{}\\z{}(t)", "Ac(t)", "Cc\\scontact,hb\\v{}\\z{}(t)",
                                "-dAc\\sfs\\v{}\\z{}/dt" };
@@ -1981,11 +1670,12 @@ static void do_hbac(const char*             fn,
     real *      ct, tail, tail2, dtail, *cct;
     const real  tol     = 1e-3;
     int         nframes = hb->nframes;
-    unsigned int **h = nullptr, **g = nullptr;
-    int            nh, nhbonds, nhydro;
-    t_hbond*       hbh;
-    int            acType;
-    int*           dondata = nullptr;
+
+    std::vector<const std::vector<t_hbrun>*> h(hb->maxhydro), g(hb->maxhydro);
+    int                                      nh, nhbonds, nhydro;
+    const t_hbond*                           hbh;
+    int                                      acType;
+    int*                                     dondata = nullptr;
 
     enum
     {
@@ -2013,12 +1703,6 @@ static void do_hbac(const char*             fn,
 
     nn = nframes / 2;
 
-    if (acType != AC_NN || bOMP)
-    {
-        snew(h, hb->maxhydro);
-        snew(g, hb->maxhydro);
-    }
-
     /* Dump hbonds for debugging */
     dump_ac(hb, bMerge || bContact, nDump);
 
@@ -2065,97 +1749,83 @@ static void do_hbac(const char*             fn,
 
     for (i = 0; (i < hb->d.nrd); i++)
     {
-        for (k = 0; (k < hb->a.nra); k++)
+        for (const auto& entry : hb->hbmap[i])
         {
             nhydro = 0;
-            hbh    = hb->hbmap[i][k];
+            hbh    = &entry.second;
 
-            if (hbh)
+            if (bMerge || bContact)
             {
-                if (bMerge || bContact)
+                if (ISHB(hbh->history[0]))
                 {
-                    if (ISHB(hbh->history[0]))
-                    {
-                        h[0]   = hbh->h[0];
-                        g[0]   = hbh->g[0];
-                        nhydro = 1;
-                    }
+                    h[0]   = &hbh->h[0];
+                    g[0]   = &hbh->g[0];
+                    nhydro = 1;
                 }
-                else
+            }
+            else
+            {
+                for (m = 0; (m < hb->maxhydro); m++)
                 {
-                    for (m = 0; (m < hb->maxhydro); m++)
+                    if (bContact ? ISDIST(hbh->history[m]) : ISHB(hbh->history[m]))
                     {
-                        if (bContact ? ISDIST(hbh->history[m]) : ISHB(hbh->history[m]))
-                        {
-                            g[nhydro] = hbh->g[m];
-                            h[nhydro] = hbh->h[m];
-                            nhydro++;
-                        }
+                        g[nhydro] = &hbh->g[m];
+                        h[nhydro] = &hbh->h[m];
+                        nhydro++;
                     }
                 }
+            }
 
-                int nf = hbh->nframes;
-                for (nh = 0; (nh < nhydro); nh++)
+            int nf = hbh->nframes;
+            for (nh = 0; (nh < nhydro); nh++)
+            {
+                int nrint = bContact ? hb->nrdist : hb->nrhb;
+                if ((((nhbonds + 1) % 10) == 0) || (nhbonds + 1 == nrint))
                 {
-                    int nrint = bContact ? hb->nrdist : hb->nrhb;
-                    if ((((nhbonds + 1) % 10) == 0) || (nhbonds + 1 == nrint))
+                    fprintf(stderr, "\rACF %d/%d", nhbonds + 1, nrint);
+                    fflush(stderr);
+                }
+                nhbonds++;
+                expand_hb(*h[nh], nf, nframes, ht);
+                expand_hb(*g[nh], nf, nframes, gt);
+                for (j = 0; (j < nframes); j++)
+                {
+                    rhbex[j] = ht[j];
+                    /* For contacts: if a second cut-off is provided, use it,
+                     * otherwise use g(t) = 1-h(t) */
+                    if (!R2 && bContact)
                     {
-                        fprintf(stderr, "\rACF %d/%d", nhbonds + 1, nrint);
-                        fflush(stderr);
+                        gt[j] = 1 - ht[j];
                     }
-                    nhbonds++;
-                    for (j = 0; (j < nframes); j++)
+                    else
                     {
-                        if (j <= nf)
-                        {
-                            ihb   = static_cast<int>(is_hb(h[nh], j));
-                            idist = static_cast<int>(is_hb(g[nh], j));
-                        }
-                        else
-                        {
-                            ihb = idist = 0;
-                        }
-                        rhbex[j] = ihb;
-                        /* For contacts: if a second cut-off is provided, use it,
-                         * otherwise use g(t) = 1-h(t) */
-                        if (!R2 && bContact)
-                        {
-                            gt[j] = 1 - ihb;
-                        }
-                        else
-                        {
-                            gt[j] = idist * (1 - ihb);
-                        }
-                        ht[j] = rhbex[j];
-                        nhb += ihb;
+                        gt[j] = gt[j] * (1 - ht[j]);
                     }
+                    nhb += ht[j];
+                }
 
-                    /* The autocorrelation function is normalized after summation only */
-                    low_do_autocorr(nullptr, oenv, nullptr, nframes, 1, -1, &rhbex,
-                                    hb->time[1] - hb->time[0], eacNormal, 1, FALSE, bNorm, FALSE, 0,
-                                    -1, 0);
+                /* The autocorrelation function is normalized after summation only */
+                low_do_autocorr(nullptr, oenv, nullptr, nframes, 1, -1, &rhbex,
+                                hb->time[1] - hb->time[0], eacNormal, 1, FALSE, bNorm, FALSE, 0, -1, 0);
 
-                    /* Cross correlation analysis for thermodynamics */
-                    for (j = nframes; (j < n2); j++)
-                    {
-                        ht[j] = 0;
-                        gt[j] = 0;
-                    }
+                /* Cross correlation analysis for thermodynamics */
+                for (j = nframes; (j < n2); j++)
+                {
+                    ht[j] = 0;
+                    gt[j] = 0;
+                }
 
-                    cross_corr(n2, ht, gt, dght);
+                cross_corr(n2, ht, gt, dght);
 
-                    for (j = 0; (j < nn); j++)
-                    {
-                        ct[j] += rhbex[j];
-                        ght[j] += dght[j];
-                    }
+                for (j = 0; (j < nn); j++)
+                {
+                    ct[j] += rhbex[j];
+                    ght[j] += dght[j];
                 }
             }
         }
     }
     fprintf(stderr, "\n");
-    sfree(h);
-    sfree(g);
     normalizeACF(ct, ght, static_cast<int>(nhb), nn);
 
     /* Determine tail value for statistics */
@@ -2253,7 +1923,7 @@ static FILE* open_donor_properties_file(const char* fn, t_hbdata* hb, const gmx_
 
 static void analyse_donor_properties(FILE* fp, t_hbdata* hb, int nframes, real t)
 {
-    int i, j, k, nbound, nb, nhtot;
+    int i, k, nbound, nb, nhtot;
 
     if (!fp || !hb)
     {
@@ -2267,9 +1937,9 @@ static void analyse_donor_properties(FILE* fp, t_hbdata* hb, int nframes, real t
         {
             nb = 0;
             nhtot++;
-            for (j = 0; (j < hb->a.nra) && (nb == 0); j++)
+            for (auto entry = hb->hbmap[i].begin(); (entry != hb->hbmap[i].end()) && (nb == 0); ++entry)
             {
-                if (hb->hbmap[i][j] && hb->hbmap[i][j]->h[k] && is_hb(hb->hbmap[i][j]->h[k], nframes))
+                if (k < gmx::ssize(entry->second.h) && is_hb(entry->second.h[k], nframes))
                 {
                     nb = 1;
                 }
@@ -2291,7 +1961,7 @@ static void dump_hbmap(t_hbdata*      hb,
                        const t_atoms* atoms)
 {
     FILE *   fp, *fplog;
-    int      ddd, hhh, aaa, i, j, k, m, grp;
+    int      ddd, hhh, aaa, i, j, m, grp;
     char     ds[32], hs[32], as[32];
     gmx_bool first;
 
@@ -2355,12 +2025,12 @@ static void dump_hbmap(t_hbdata*      hb,
     for (i = 0; (i < hb->d.nrd); i++)
     {
         ddd = hb->d.don[i];
-        for (k = 0; (k < hb->a.nra); k++)
+        for (const auto& entry : hb->hbmap[i])
         {
-            aaa = hb->a.acc[k];
+            aaa = hb->a.acc[entry.first];
             for (m = 0; (m < hb->d.nhydro[i]); m++)
             {
-                if (hb->hbmap[i][k] && ISHB(hb->hbmap[i][k]->history[m]))
+                if (ISHB(entry.second.history[m]))
                 {
                     sprintf(ds, "%s", mkatomname(atoms, ddd));
                     sprintf(as, "%s", mkatomname(atoms, aaa));
@@ -2480,17 +2150,17 @@ int gmx_hbond(int argc, char* argv[])
         " * [TT]-nhbdist[tt]: compute the number of HBonds per hydrogen in order to",
         "   compare results to Raman Spectroscopy.", "",
         "Note: options [TT]-ac[tt], [TT]-life[tt], [TT]-hbn[tt] and [TT]-hbm[tt]",
-        "require an amount of memory proportional to the total numbers of donors",
-        "times the total number of acceptors in the selected group(s)."
+        "require an amount of memory proportional to the number of times each",
+        "hydrogen bond forms and breaks during the trajectory."
     };
 
-    static real     acut = 30, abin = 1, rcut = 0.35, r2cut = 0, rbin = 0.005, rshell = -1;
-    static real     maxnhb = 0, fit_start = 1, fit_end = 60, temp = 298.15;
-    static gmx_bool bNitAcc = TRUE, bDA = TRUE, bMerge = TRUE;
-    static int      nDump    = 0;
-    static int      nThreads = 0;
+    real     acut = 30, abin = 1, rcut = 0.35, r2cut = 0, rbin = 0.005, rshell = -1;
+    real     maxnhb = 0, fit_start = 1, fit_end = 60, temp = 298.15;
+    gmx_bool bNitAcc = TRUE, bDA = TRUE, bMerge = TRUE;
+    int      nDump    = 0;
+    int      nThreads = 0;
 
-    static gmx_bool bContact = FALSE;
+    gmx_bool bContact = FALSE;
 
     /* options */
     t_pargs pa[] = {
@@ -2604,28 +2274,24 @@ int gmx_hbond(int argc, char* argv[])
     int*              isize;
     char**            grpnames;
     int**             index;
-    rvec *            x, hbox;
+    rvec*             x;
     matrix            box;
+    t_pbc             pbc, *pbcptr;
     real              t, ccut, dist = 0.0, ang = 0.0;
     double            max_nhb, aver_nhb, aver_dist;
     int               h = 0, i = 0, j, k = 0, ogrp, nsel;
-    int               xi = 0, yi, zi, ai;
-    int               xj, yj, zj, aj, xjj, yjj, zjj;
-    gmx_bool          bSelected, bHBmap, bStop, bTwo, bBox, bTric;
+    int               ai, aj;
+    gmx_bool          bSelected, bHBmap, bStop, bTwo, bBox;
     int *             adist, *rdist;
     int               grp, nabin, nrbin, resdist, ihb;
     char**            leg;
     t_hbdata*         hb;
     FILE *            fp, *fpnhb = nullptr, *donor_properties = nullptr;
-    t_gridcell***     grid;
-    t_ncell *         icell, *jcell;
-    ivec              ngrid;
     unsigned char*    datable;
     gmx_output_env_t* oenv;
     int               ii, hh, actual_nThreads;
     int               threadNr = 0;
     gmx_bool          bParallel;
-    gmx_bool          bEdge_yjj, bEdge_xjj;
 
     t_hbdata** p_hb    = nullptr; /* one per thread, then merge after the frame loop */
     int **     p_adist = nullptr, **p_rdist = nullptr; /* a histogram for each thread. */
@@ -2660,7 +2326,8 @@ int gmx_hbond(int argc, char* argv[])
 
     /* Initiate main data structure! */
     bHBmap = (opt2bSet("-ac", NFILE, fnm) || opt2bSet("-life", NFILE, fnm)
-              || opt2bSet("-hbn", NFILE, fnm) || opt2bSet("-hbm", NFILE, fnm));
+              || opt2bSet("-hbn", NFILE, fnm) || opt2bSet("-hbm", NFILE, fnm)
+              || opt2bSet("-don", NFILE, fnm));
 
     if (opt2bSet("-nhbdist", NFILE, fnm))
     {
@@ -2848,13 +2515,20 @@ int gmx_hbond(int argc, char* argv[])
         gmx_fatal(FARGS, "Topology (%d atoms) does not match trajectory (%d atoms)", top.atoms.nr, natoms);
     }
 
-    bBox  = (ir->pbcType != PbcType::No);
-    grid  = init_grid(bBox, box, (rcut > r2cut) ? rcut : r2cut, ngrid);
-    nabin = static_cast<int>(acut / abin);
-    nrbin = static_cast<int>(rcut / rbin);
+    bBox   = (ir->pbcType != PbcType::No);
+    pbcptr = bBox ? &pbc : nullptr;
+    nabin  = static_cast<int>(acut / abin);
+    nrbin  = static_cast<int>(rcut / rbin);
     snew(adist, nabin + 1);
     snew(rdist, nrbin + 1);
 
+    /* With -noda the hydrogens are searched for acceptors within the
+     * cut-off, otherwise the donors.
+     */
+    gmx::AnalysisNeighborhood nb;
+    t_hbsearch                search;
+    nb.setCutoff(bDA ? std::max(rcut, r2cut) : rcut);
+
 #if !GMX_OPENMP
 #    define __ADIST adist
 #    define __RDIST rdist
@@ -2903,7 +2577,6 @@ int gmx_hbond(int argc, char* argv[])
 
             p_hb[i]->bHBmap   = hb->bHBmap;
             p_hb[i]->bDAnr    = hb->bDAnr;
-            p_hb[i]->wordlen  = hb->wordlen;
             p_hb[i]->nframes  = hb->nframes;
             p_hb[i]->maxhydro = hb->maxhydro;
             p_hb[i]->danr     = hb->danr;
@@ -2920,10 +2593,11 @@ int gmx_hbond(int argc, char* argv[])
     /* Make a thread pool here,
      * instead of forking anew at every frame. */
 
-#pragma omp parallel firstprivate(i) private(                                                   \
-        j, h, ii, hh, xi, yi, zi, xj, yj, zj, threadNr, dist, ang, icell, jcell, grp, ogrp, ai, \
-        aj, xjj, yjj, zjj, ihb, resdist, k, bTric, bEdge_xjj, bEdge_yjj) default(shared)
+#pragma omp parallel firstprivate(i) private(j, h, ii, hh, threadNr, dist, ang, grp, ogrp, ai, aj, \
+                                             ihb, resdist, k) default(shared)
     { /* Start of parallel region */
+        std::vector<int> acceptors;
+
         if (bOMP)
         {
             threadNr = gmx_omp_get_thread_num();
@@ -2931,8 +2605,6 @@ int gmx_hbond(int argc, char* argv[])
         do
         {
 
-            bTric = bBox && TRICLINIC(box);
-
             if (bOMP)
             {
                 try
@@ -2945,21 +2617,19 @@ int gmx_hbond(int argc, char* argv[])
             {
                 try
                 {
-                    build_grid(hb, x, x[shatom], bBox, box, hbox, (rcut > r2cut) ? rcut : r2cut,
-                               rshell, ngrid, grid);
-                    reset_nhbonds(&(hb->d));
-
-                    if (debug && bDebug)
+                    if (bBox)
                     {
-                        dump_grid(debug, ngrid, grid);
+                        set_pbc(&pbc, ir->pbcType, box);
                     }
+                    build_search(&nb, &search, hb, natoms, x, pbcptr, x[shatom], rshell);
+                    reset_nhbonds(&(hb->d));
 
                     add_frames(hb, nframes);
                     init_hbframe(hb, nframes, output_env_conv_time(oenv, t));
 
                     if (hb->bDAnr)
                     {
-                        count_da_grid(ngrid, grid, hb->danr[nframes]);
+                        count_da_search(&search, hb->danr[nframes]);
                     }
                 }
                 GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR
@@ -2984,8 +2654,8 @@ int gmx_hbond(int argc, char* argv[])
                             int dd       = index[0][i];
                             int aa       = index[0][i + 2];
                             /* int */ hh = index[0][i + 1];
-                            ihb = is_hbond(hb, ii, ii, dd, aa, rcut, r2cut, ccut, x, bBox, box,
-                                           hbox, &dist, &ang, bDA, &h, bContact, bMerge);
+                            ihb = is_hbond(hb, ii, ii, dd, aa, rcut, r2cut, ccut, x, pbcptr, &dist,
+                                           &ang, bDA, &h, bContact, bMerge);
 
                             if (ihb)
                             {
@@ -3000,130 +2670,84 @@ int gmx_hbond(int argc, char* argv[])
             }     /* if (bSelected) */
             else
             {
-                /* The outer grid loop will have to do for now. */
-#pragma omp for schedule(dynamic)
-                for (xi = 0; xi < ngrid[XX]; xi++)
+                /* loop over donor groups gr0 (always) and gr1 (if necessary) */
+                for (grp = gr0; (grp <= (bTwo ? gr1 : gr0)); grp++)
                 {
-                    try
+                    if (bTwo)
+                    {
+                        ogrp = 1 - grp;
+                    }
+                    else
+                    {
+                        ogrp = grp;
+                    }
+
+                    /* loop over all donors from group (grp) */
+#pragma omp for schedule(dynamic, 16)
+                    for (ai = 0; ai < gmx::ssize(search.don[grp]); ai++)
                     {
-                        for (yi = 0; (yi < ngrid[YY]); yi++)
+                        try
                         {
-                            for (zi = 0; (zi < ngrid[ZZ]); zi++)
+                            int id = search.don[grp][ai];
+
+                            i = hb->d.don[id];
+                            find_acceptors(&search, hb, id, ogrp, x, bDA, &acceptors);
+
+                            /* loop over acceptor atoms from the other group (ogrp)
+                             * within the cut-off
+                             */
+                            for (aj = 0; (aj < gmx::ssize(acceptors)); aj++)
                             {
+                                j = acceptors[aj];
 
-                                /* loop over donor groups gr0 (always) and gr1 (if necessary) */
-                                for (grp = gr0; (grp <= (bTwo ? gr1 : gr0)); grp++)
-                                {
-                                    icell = &(grid[zi][yi][xi].d[grp]);
+                                /* check if this once was a h-bond */
+                                ihb = is_hbond(__HBDATA, grp, ogrp, i, j, rcut, r2cut, ccut, x,
+                                               pbcptr, &dist, &ang, bDA, &h, bContact, bMerge);
 
-                                    if (bTwo)
-                                    {
-                                        ogrp = 1 - grp;
-                                    }
-                                    else
-                                    {
-                                        ogrp = grp;
-                                    }
+                                if (ihb)
+                                {
+                                    /* add to index if not already there */
+                                    /* Add a hbond */
+                                    add_hbond(__HBDATA, i, j, h, grp, ogrp, nframes, bMerge, ihb, bContact);
 
-                                    /* loop over all hydrogen atoms from group (grp)
-                                     * in this gridcell (icell)
-                                     */
-                                    for (ai = 0; (ai < icell->nr); ai++)
+                                    /* make angle and distance distributions */
+                                    if (ihb == hbHB && !bContact)
                                     {
-                                        i = icell->atoms[ai];
-
-                                        /* loop over all adjacent gridcells (xj,yj,zj) */
-                                        for (zjj = grid_loop_begin(ngrid[ZZ], zi, bTric, FALSE);
-                                             zjj <= grid_loop_end(ngrid[ZZ], zi, bTric, FALSE); zjj++)
+                                        if (dist > rcut)
+                                        {
+                                            gmx_fatal(FARGS,
+                                                      "distance is higher than what is allowed "
+                                                      "for an hbond: %f",
+                                                      dist);
+                                        }
+                                        ang *= RAD2DEG;
+                                        __ADIST[static_cast<int>(ang / abin)]++;
+                                        __RDIST[static_cast<int>(dist / rbin)]++;
+                                        if (!bTwo)
                                         {
-                                            zj        = grid_mod(zjj, ngrid[ZZ]);
-                                            bEdge_yjj = (zj == 0) || (zj == ngrid[ZZ] - 1);
-                                            for (yjj = grid_loop_begin(ngrid[YY], yi, bTric, bEdge_yjj);
-                                                 yjj <= grid_loop_end(ngrid[YY], yi, bTric, bEdge_yjj);
-                                                 yjj++)
+                                            if (donor_index(&hb->d, grp, i) == NOTSET)
                                             {
-                                                yj        = grid_mod(yjj, ngrid[YY]);
-                                                bEdge_xjj = (yj == 0) || (yj == ngrid[YY] - 1)
-                                                            || (zj == 0) || (zj == ngrid[ZZ] - 1);
-                                                for (xjj = grid_loop_begin(ngrid[XX], xi, bTric, bEdge_xjj);
-                                                     xjj <= grid_loop_end(ngrid[XX], xi, bTric, bEdge_xjj);
-                                                     xjj++)
-                                                {
-                                                    xj    = grid_mod(xjj, ngrid[XX]);
-                                                    jcell = &(grid[zj][yj][xj].a[ogrp]);
-                                                    /* loop over acceptor atoms from other group
-                                                     * (ogrp) in this adjacent gridcell (jcell)
-                                                     */
-                                                    for (aj = 0; (aj < jcell->nr); aj++)
-                                                    {
-                                                        j = jcell->atoms[aj];
-
-                                                        /* check if this once was a h-bond */
-                                                        ihb = is_hbond(__HBDATA, grp, ogrp, i, j,
-                                                                       rcut, r2cut, ccut, x, bBox,
-                                                                       box, hbox, &dist, &ang, bDA,
-                                                                       &h, bContact, bMerge);
-
-                                                        if (ihb)
-                                                        {
-                                                            /* add to index if not already there */
-                                                            /* Add a hbond */
-                                                            add_hbond(__HBDATA, i, j, h, grp, ogrp,
-                                                                      nframes, bMerge, ihb, bContact);
-
-                                                            /* make angle and distance distributions */
-                                                            if (ihb == hbHB && !bContact)
-                                                            {
-                                                                if (dist > rcut)
-                                                                {
-                                                                    gmx_fatal(
-                                                                            FARGS,
-                                                                            "distance is higher "
-                                                                            "than what is allowed "
-                                                                            "for an hbond: %f",
-                                                                            dist);
-                                                                }
-                                                                ang *= RAD2DEG;
-                                                                __ADIST[static_cast<int>(ang / abin)]++;
-                                                                __RDIST[static_cast<int>(dist / rbin)]++;
-                                                                if (!bTwo)
-                                                                {
-                                                                    if (donor_index(&hb->d, grp, i) == NOTSET)
-                                                                    {
-                                                                        gmx_fatal(
-                                                                                FARGS,
-                                                                                "Invalid donor %d", i);
-                                                                    }
-                                                                    if (acceptor_index(&hb->a, ogrp, j)
-                                                                        == NOTSET)
-                                                                    {
-                                                                        gmx_fatal(FARGS,
-                                                                                  "Invalid "
-                                                                                  "acceptor %d",
-                                                                                  j);
-                                                                    }
-                                                                    resdist = std::abs(
-                                                                            top.atoms.atom[i].resind
-                                                                            - top.atoms.atom[j].resind);
-                                                                    if (resdist >= max_hx)
-                                                                    {
-                                                                        resdist = max_hx - 1;
-                                                                    }
-                                                                    __HBDATA->nhx[nframes][resdist]++;
-                                                                }
-                                                            }
-                                                        }
-                                                    } /* for aj  */
-                                                }     /* for xjj */
-                                            }         /* for yjj */
-                                        }             /* for zjj */
-                                    }                 /* for ai  */
-                                }                     /* for grp */
-                            }                         /* for xi,yi,zi */
+                                                gmx_fatal(FARGS, "Invalid donor %d", i);
+                                            }
+                                            if (acceptor_index(&hb->a, ogrp, j) == NOTSET)
+                                            {
+                                                gmx_fatal(FARGS, "Invalid acceptor %d", j);
+                                            }
+                                            resdist = std::abs(top.atoms.atom[i].resind
+                                                               - top.atoms.atom[j].resind);
+                                            if (resdist >= max_hx)
+                                            {
+                                                resdist = max_hx - 1;
+                                            }
+                                            __HBDATA->nhx[nframes][resdist]++;
+                                        }
+                                    }
+                                }
+                            } /* for aj  */
                         }
-                    }
-                    GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR
-                }
+                        GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR
+                    } /* for ai  */
+                }     /* for grp */
             } /* if (bSelected) {...} else */
 
 
@@ -3243,8 +2867,6 @@ int gmx_hbond(int argc, char* argv[])
                   "Cannot calculate autocorrelation of life times with less than two frames");
     }
 
-    free_grid(ngrid, &grid);
-
     close_trx(status);
 
     if (donor_properties)
@@ -3403,7 +3025,7 @@ int gmx_hbond(int argc, char* argv[])
         if (opt2bSet("-hbm", NFILE, fnm))
         {
             t_matrix mat;
-            int      id, ia, hh, x, y;
+            int      id, hh, x, y;
             mat.flags = 0;
 
             if ((nframes > 0) && (hb->nrhb > 0))
@@ -3419,27 +3041,28 @@ int gmx_hbond(int argc, char* argv[])
                 y = 0;
                 for (id = 0; (id < hb->d.nrd); id++)
                 {
-                    for (ia = 0; (ia < hb->a.nra); ia++)
+                    for (const auto& entry : hb->hbmap[id])
                     {
+                        const t_hbond& hbond = entry.second;
+
                         for (hh = 0; (hh < hb->maxhydro); hh++)
                         {
-                            if (hb->hbmap[id][ia])
+                            if (ISHB(hbond.history[hh]))
                             {
-                                if (ISHB(hb->hbmap[id][ia]->history[hh]))
+                                range_check(y, 0, mat.ny);
+                                for (const t_hbrun& run : hbond.h[hh])
                                 {
-                                    for (x = 0; (x <= hb->hbmap[id][ia]->nframes); x++)
+                                    for (x = run.begin; (x < std::min(run.end, hbond.nframes + 1)); x++)
                                     {
-                                        int nn0 = hb->hbmap[id][ia]->n0;
-                                        range_check(y, 0, mat.ny);
-                                        mat.matrix(x + nn0, y) = static_cast<t_matelmt>(
-                                                is_hb(hb->hbmap[id][ia]->h[hh], x));
+                                        mat.matrix(x + hbond.n0, y) = 1;
                                     }
-                                    y++;
                                 }
+                                y++;
                             }
                         }
                     }
                 }
+                mat.axis_x.resize(mat.nx);
                 std::copy(hb->time, hb->time + mat.nx, mat.axis_x.begin());
                 mat.axis_y.resize(mat.ny);
                 std::iota(mat.axis_y.begin(), mat.axis_y.end(), 0);
@@ -3449,11 +3072,11 @@ int gmx_hbond(int argc, char* argv[])
                 mat.label_y = bContact ? "Contact Index" : "Hydrogen Bond Index";
                 mat.bDiscrete = true;
                 mat.map.resize(2);
-                for (auto& m : mat.map)
+                for (i = 0; i < gmx::ssize(mat.map); i++)
                 {
-                    m.code.c1 = hbmap[i];
-                    m.desc    = hbdesc[i];
-                    m.rgb     = hbrgb[i];
+                    mat.map[i].code.c1 = hbmap[i];
+                    mat.map[i].desc    = hbdesc[i];
+                    mat.map[i].rgb     = hbrgb[i];
                 }
                 fp = opt2FILE("-hbm", NFILE, fnm, "w");
                 write_xpm_m(fp, mat);
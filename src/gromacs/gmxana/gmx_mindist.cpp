@@ -37,11 +37,14 @@
  */
 #include "gmxpre.h"
 
+#include <climits>
 #include <cmath>
+#include <cstdint>
 #include <cstdlib>
 #include <cstring>
 
 #include <algorithm>
+#include <vector>
 
 #include "gromacs/commandline/pargs.h"
 #include "gromacs/commandline/viewit.h"
@@ -54,23 +57,50 @@
 #include "gromacs/mdtypes/md_enums.h"
 #include "gromacs/pbcutil/pbc.h"
 #include "gromacs/pbcutil/rmpbc.h"
+#include "gromacs/selection/nbsearch.h"
 #include "gromacs/topology/index.h"
 #include "gromacs/topology/topology.h"
+#include "gromacs/utility/arrayref.h"
 #include "gromacs/utility/arraysize.h"
 #include "gromacs/utility/cstringutil.h"
+#include "gromacs/utility/exceptions.h"
 #include "gromacs/utility/fatalerror.h"
 #include "gromacs/utility/futil.h"
 #include "gromacs/utility/gmxassert.h"
+#include "gromacs/utility/gmxomp.h"
 #include "gromacs/utility/smalloc.h"
 
 
-static void
-periodic_dist(PbcType pbcType, matrix box, rvec x[], int n, const int index[], real* rmin, real* rmax, int* min_ind)
+/* Below this number of atom pairs the distances are computed with a plain
+ * loop over all pairs on a single thread.
+ */
+static const int c_minPairsForSearch = 10000;
+/* Relative margin on the search cutoff, so differences in rounding between
+ * the grid search and the exact distance calculation never lose a pair.
+ */
+static const real c_cutoffMargin = 1.001;
+
+/* Returns the begin of chunk c out of nchunk chunks of n elements */
+static int chunk_begin(int c, int nchunk, int n)
+{
+    return static_cast<int>((static_cast<int64_t>(c) * n) / nchunk);
+}
+
+static void periodic_dist(PbcType   pbcType,
+                          matrix    box,
+                          rvec      x[],
+                          int       n,
+                          const int index[],
+                          real      rguess,
+                          int       nthreads,
+                          real*     rmin,
+                          real*     rmax,
+                          int*      min_ind)
 {
 #define NSHIFT_MAX 26
     int  nsz, nshift, sx, sy, sz, i, j, s;
     real sqr_box, r2min, r2max, r2;
-    rvec shift[NSHIFT_MAX], d0, d;
+    rvec shift[NSHIFT_MAX], d0;
 
     sqr_box = std::min(norm2(box[XX]), norm2(box[YY]));
     if (pbcType == PbcType::Xyz)
@@ -106,32 +136,152 @@ periodic_dist(PbcType pbcType, matrix box, rvec x[], int n, const int index[], r
         }
     }
 
-    r2min = sqr_box;
+    /* The maximum internal distance: process the atoms in order of
+     * decreasing distance from their center and stop as soon as the
+     * triangle inequality shows no remaining pair can be longer.
+     */
     r2max = 0;
-
-    for (i = 0; i < n; i++)
+    if (n > 1)
     {
-        for (j = i + 1; j < n; j++)
+        dvec center = { 0, 0, 0 };
+        for (i = 0; i < n; i++)
+        {
+            for (int m = 0; m < DIM; m++)
+            {
+                center[m] += x[index[i]][m];
+            }
+        }
+        dsvmul(1.0 / n, center, center);
+        std::vector<double> radius(n);
+        std::vector<int>    order(n);
+        for (i = 0; i < n; i++)
         {
-            rvec_sub(x[index[i]], x[index[j]], d0);
-            r2 = norm2(d0);
-            if (r2 > r2max)
+            dvec dx;
+            for (int m = 0; m < DIM; m++)
+            {
+                dx[m] = x[index[i]][m] - center[m];
+            }
+            radius[i] = dnorm(dx);
+            order[i]  = i;
+        }
+        std::sort(order.begin(), order.end(),
+                  [&radius](int a, int b) { return radius[a] > radius[b]; });
+        double rbound = 0;
+        for (int a = 0; a < n - 1; a++)
+        {
+            if (radius[order[a]] + radius[order[a + 1]] < rbound)
+            {
+                break;
+            }
+            for (int b = a + 1; b < n; b++)
             {
-                r2max = r2;
+                if (radius[order[a]] + radius[order[b]] < rbound)
+                {
+                    break;
+                }
+                rvec_sub(x[index[order[a]]], x[index[order[b]]], d0);
+                r2 = norm2(d0);
+                if (r2 > r2max)
+                {
+                    r2max  = r2;
+                    rbound = std::sqrt(r2max) * (1 - 1e-5);
+                }
             }
+        }
+    }
+
+    /* The minimum distance to a periodic image: search around explicit
+     * shifted copies of the group, increasing the cutoff until the shortest
+     * distance is found within it or the cutoff covers the box.
+     */
+    struct t_pimin
+    {
+        real r2;
+        int  i, j, s;
+    };
+    const auto pimin_less = [](const t_pimin& a, const t_pimin& b) {
+        return a.r2 < b.r2
+               || (a.r2 == b.r2
+                   && (a.i < b.i || (a.i == b.i && (a.j < b.j || (a.j == b.j && a.s < b.s)))));
+    };
+    const real rlimit = std::sqrt(sqr_box);
+    t_pimin    best   = { sqr_box, -1, -1, -1 };
+    if (n > 1)
+    {
+        std::vector<gmx::RVec> image(n * nshift);
+        for (j = 0; j < n; j++)
+        {
             for (s = 0; s < nshift; s++)
             {
-                rvec_add(d0, shift[s], d);
-                r2 = norm2(d);
-                if (r2 < r2min)
+                rvec_sub(x[index[j]], shift[s], image[j * nshift + s]);
+            }
+        }
+        std::vector<gmx::RVec> pos(n);
+        for (i = 0; i < n; i++)
+        {
+            copy_rvec(x[index[i]], pos[i]);
+        }
+        real cutoff = (rguess > 0) ? 1.1 * rguess : 1;
+        bool bDone  = false;
+        while (!bDone)
+        {
+            cutoff = std::min(cutoff, rlimit);
+            gmx::AnalysisNeighborhood nb;
+            nb.setCutoff(cutoff * c_cutoffMargin);
+            gmx::AnalysisNeighborhoodSearch search = nb.initSearch(nullptr, image);
+            const int                       nchunk = std::min(n, 4 * nthreads);
+#pragma omp parallel num_threads(nthreads)
+            {
+                try
                 {
-                    r2min      = r2;
-                    min_ind[0] = i;
-                    min_ind[1] = j;
+                    t_pimin                       tbest = best;
+                    gmx::AnalysisNeighborhoodPair pair;
+#pragma omp for schedule(dynamic)
+                    for (int c = 0; c < nchunk; c++)
+                    {
+                        const int begin = chunk_begin(c, nchunk, n);
+                        const int end   = chunk_begin(c + 1, nchunk, n);
+                        gmx::AnalysisNeighborhoodPairSearch pairSearch = search.startPairSearch(
+                                gmx::AnalysisNeighborhoodPositions(
+                                        as_rvec_array(pos.data()) + begin, end - begin));
+                        while (pairSearch.findNextPair(&pair))
+                        {
+                            t_pimin p;
+                            p.i = begin + pair.testIndex();
+                            p.j = pair.refIndex() / nshift;
+                            p.s = pair.refIndex() % nshift;
+                            if (p.j <= p.i)
+                            {
+                                continue;
+                            }
+                            rvec dp0, dp;
+                            rvec_sub(x[index[p.i]], x[index[p.j]], dp0);
+                            rvec_add(dp0, shift[p.s], dp);
+                            p.r2 = norm2(dp);
+                            if (pimin_less(p, tbest))
+                            {
+                                tbest = p;
+                            }
+                        }
+                    }
+#pragma omp critical
+                    if (pimin_less(tbest, best))
+                    {
+                        best = tbest;
+                    }
                 }
+                GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR
             }
+            bDone = (best.i >= 0 && best.r2 <= gmx::square(cutoff)) || cutoff >= rlimit;
+            cutoff *= 2;
         }
     }
+    r2min = best.r2;
+    if (best.i >= 0)
+    {
+        min_ind[0] = best.i;
+        min_ind[1] = best.j;
+    }
 
     *rmin = std::sqrt(r2min);
     *rmax = std::sqrt(r2max);
@@ -144,6 +294,7 @@ static void periodic_mindist_plot(const char*             trxfn,
                                   int                     n,
                                   int                     index[],
                                   gmx_bool                bSplit,
+                                  int                     nthreads,
                                   const gmx_output_env_t* oenv)
 {
     FILE*        out;
@@ -153,7 +304,7 @@ static void periodic_mindist_plot(const char*             trxfn,
     rvec*        x;
     matrix       box;
     int          natoms, ind_min[2] = { 0, 0 }, ind_mini = 0, ind_minj = 0;
-    real         rmin, rmax, rmint, tmint;
+    real         rmin = 0, rmax, rmint, tmint;
     gmx_bool     bFirst;
     gmx_rmpbc_t  gpbc = nullptr;
 
@@ -185,7 +336,8 @@ static void periodic_mindist_plot(const char*             trxfn,
             gmx_rmpbc(gpbc, natoms, box, x);
         }
 
-        periodic_dist(pbcType, box, x, n, index, &rmin, &rmax, ind_min);
+        periodic_dist(pbcType, box, x, n, index, bFirst ? 0 : rmin, nthreads, &rmin, &rmax,
+                      ind_min);
         if (rmin < rmint)
         {
             rmint    = rmin;
@@ -216,127 +368,329 @@ static void periodic_mindist_plot(const char*             trxfn,
             index[ind_mini] + 1, index[ind_minj] + 1);
 }
 
-static void calc_dist(real     rcut,
-                      gmx_bool bPBC,
-                      PbcType  pbcType,
-                      matrix   box,
-                      rvec     x[],
-                      int      nx1,
-                      int      nx2,
-                      int      index1[],
-                      int      index2[],
-                      gmx_bool bGroup,
-                      real*    rmin,
-                      real*    rmax,
-                      int*     nmin,
-                      int*     nmax,
-                      int*     ixmin,
-                      int*     jxmin,
-                      int*     ixmax,
-                      int*     jxmax)
+/* Nearest (or farthest) atom of the second group for an atom of the first */
+struct t_pairext
 {
-    int   i, j, i0 = 0, j1;
-    int   ix, jx;
-    int*  index3;
-    rvec  dx;
-    real  r2, rmin2, rmax2, rcut2;
-    t_pbc pbc;
-    int   nmin_j, nmax_j;
-
-    *ixmin = -1;
-    *jxmin = -1;
-    *ixmax = -1;
-    *jxmax = -1;
-    *nmin  = 0;
-    *nmax  = 0;
+    real r2;
+    int  j;
+};
 
-    rcut2 = gmx::square(rcut);
+static real pair_dist2(const t_pbc* pbc, const rvec xi, const rvec xj)
+{
+    rvec dx;
 
-    /* Must init pbc every step because of pressure coupling */
-    if (bPBC)
+    if (pbc)
     {
-        set_pbc(&pbc, pbcType, box);
-    }
-    if (index2)
-    {
-        i0     = 0;
-        j1     = nx2;
-        index3 = index2;
+        pbc_dx(pbc, xi, xj, dx);
     }
     else
     {
-        j1     = nx1;
-        index3 = index1;
+        rvec_sub(xi, xj, dx);
     }
-    GMX_RELEASE_ASSERT(index1 != nullptr, "Need a valid index for plotting distances");
+    return iprod(dx, dx);
+}
 
-    rmin2 = 1e12;
-    rmax2 = -1e12;
+/* Stores pair r2-j in ext when it is the closer (bMin) or farther one,
+ * with the lowest j on ties.
+ */
+static void update_pairext(t_pairext* ext, real r2, int j, gmx_bool bMin)
+{
+    if (ext->j < 0 || (bMin ? r2 < ext->r2 : r2 > ext->r2) || (r2 == ext->r2 && j < ext->j))
+    {
+        ext->r2 = r2;
+        ext->j  = j;
+    }
+}
 
-    for (j = 0; (j < j1); j++)
+/* Accumulates the pairs counted by one thread into the totals */
+static void reduce_count(int n, const std::vector<char>& counted, int* ncount,
+                         std::vector<char>* jcounted)
+{
+#pragma omp critical
     {
-        jx = index3[j];
-        if (index2 == nullptr)
+        *ncount += n;
+        for (size_t j = 0; j < counted.size(); j++)
         {
-            i0 = j + 1;
+            (*jcounted)[j] = (*jcounted)[j] || counted[j];
         }
-        nmin_j = 0;
-        nmax_j = 0;
-        for (i = i0; (i < nx1); i++)
+    }
+}
+
+/* Computes the distances between all pairs of positions in index1 and
+ * index2, storing the extreme pair of each position of index1 in ext and
+ * counting the pairs within (bMin) or beyond rcut.
+ */
+static void scan_dist(const t_pbc*            pbc,
+                      const rvec              x[],
+                      int                     nx1,
+                      int                     nx2,
+                      const int               index1[],
+                      const int               index2[],
+                      gmx_bool                bMin,
+                      real                    rcut2,
+                      gmx_bool                bGroup,
+                      int                     nthreads,
+                      std::vector<t_pairext>* ext,
+                      int*                    ncount,
+                      std::vector<char>*      jcounted)
+{
+#pragma omp parallel num_threads(nthreads)
+    {
+        try
         {
-            ix = index1[i];
-            if (ix != jx)
+            std::vector<char> counted(bGroup ? nx2 : 0);
+            int               n = 0;
+#pragma omp for schedule(static)
+            for (int i = 0; i < nx1; i++)
             {
-                if (bPBC)
-                {
-                    pbc_dx(&pbc, x[ix], x[jx], dx);
-                }
-                else
+                const int ix = index1[i];
+                for (int j = 0; j < nx2; j++)
                 {
-                    rvec_sub(x[ix], x[jx], dx);
-                }
-                r2 = iprod(dx, dx);
-                if (r2 < rmin2)
-                {
-                    rmin2  = r2;
-                    *ixmin = ix;
-                    *jxmin = jx;
+                    const int jx = index2[j];
+                    if (ix != jx)
+                    {
+                        const real r2 = pair_dist2(pbc, x[ix], x[jx]);
+                        update_pairext(&(*ext)[i], r2, j, bMin);
+                        if (bMin ? r2 <= rcut2 : r2 > rcut2)
+                        {
+                            n++;
+                            if (bGroup)
+                            {
+                                counted[j] = 1;
+                            }
+                        }
+                    }
                 }
-                if (r2 > rmax2)
+            }
+            reduce_count(n, counted, ncount, jcounted);
+        }
+        GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR
+    }
+}
+
+/* As scan_dist for the minimum distance, but only considering the pairs
+ * that search finds for the positions test of index1. With bCount the
+ * pairs within rcut are counted, the search cutoff should then be rcut.
+ */
+static void search_dist(const gmx::AnalysisNeighborhoodSearch& search,
+                        const t_pbc*                           pbc,
+                        const rvec                             x[],
+                        int                                    natoms,
+                        int                                    nx2,
+                        const int                              index1[],
+                        const int                              index2[],
+                        const std::vector<int>&                test,
+                        real                                   rcut2,
+                        gmx_bool                               bCount,
+                        gmx_bool                               bGroup,
+                        int                                    nthreads,
+                        std::vector<t_pairext>*                ext,
+                        int*                                   ncount,
+                        std::vector<char>*                     jcounted)
+{
+    std::vector<int> testAtoms(test.size());
+    for (size_t k = 0; k < test.size(); k++)
+    {
+        testAtoms[k] = index1[test[k]];
+    }
+    const int ntest  = gmx::ssize(test);
+    const int nchunk = std::min(ntest, 4 * nthreads);
+#pragma omp parallel num_threads(nthreads)
+    {
+        try
+        {
+            std::vector<char>             counted(bCount && bGroup ? nx2 : 0);
+            int                           n = 0;
+            gmx::AnalysisNeighborhoodPair pair;
+#pragma omp for schedule(dynamic)
+            for (int c = 0; c < nchunk; c++)
+            {
+                const int begin = chunk_begin(c, nchunk, ntest);
+                const int end   = chunk_begin(c + 1, nchunk, ntest);
+                const gmx::ArrayRef<const int> atoms =
+                        gmx::constArrayRefFromArray(testAtoms.data() + begin, end - begin);
+                gmx::AnalysisNeighborhoodPairSearch pairSearch = search.startPairSearch(
+                        gmx::AnalysisNeighborhoodPositions(x, natoms).indexed(atoms));
+                while (pairSearch.findNextPair(&pair))
                 {
-                    rmax2  = r2;
-                    *ixmax = ix;
-                    *jxmax = jx;
+                    const int i  = test[begin + pair.testIndex()];
+                    const int j  = pair.refIndex();
+                    const int ix = index1[i];
+                    const int jx = index2[j];
+                    if (ix != jx)
+                    {
+                        const real r2 = pair_dist2(pbc, x[ix], x[jx]);
+                        update_pairext(&(*ext)[i], r2, j, TRUE);
+                        if (bCount && r2 <= rcut2)
+                        {
+                            n++;
+                            if (bGroup)
+                            {
+                                counted[j] = 1;
+                            }
+                        }
+                    }
                 }
-                if (r2 <= rcut2)
+            }
+            reduce_count(n, counted, ncount, jcounted);
+        }
+        GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR
+    }
+}
+
+/* Computes the minimum (bMin) or maximum distance between the positions
+ * index1 and index2 and the number of pairs within or beyond rcut.
+ * With nres > 0 also the minimum or maximum distance of each residue in
+ * index1, given by the ranges in residue, is accumulated into resdist.
+ *
+ * The maximum distance needs all pairs, for the minimum distance the pairs
+ * come from a grid search with a cutoff that is only increased for those
+ * residues that do not have a pair within it. The distances are always
+ * computed exactly as for the plain loop over all pairs, including the
+ * choice of the first pair in case of equal distances.
+ */
+static void calc_dist(real       rcut,
+                      gmx_bool   bPBC,
+                      PbcType    pbcType,
+                      matrix     box,
+                      rvec       x[],
+                      int        natoms,
+                      int        nx1,
+                      int        nx2,
+                      int        index1[],
+                      int        index2[],
+                      gmx_bool   bGroup,
+                      gmx_bool   bMin,
+                      int        nres,
+                      const int* residue,
+                      real*      resdist,
+                      int        nthreads,
+                      real*      rext,
+                      int*       next,
+                      int*       ixext,
+                      int*       jxext)
+{
+    real  rext2, rcut2;
+    t_pbc pbc, *pbcptr = nullptr;
+
+    *ixext = -1;
+    *jxext = -1;
+    *next  = 0;
+
+    rcut2 = gmx::square(rcut);
+
+    /* Must init pbc every step because of pressure coupling */
+    if (bPBC)
+    {
+        set_pbc(&pbc, pbcType, box);
+        pbcptr = &pbc;
+    }
+    GMX_RELEASE_ASSERT(index1 != nullptr && index2 != nullptr,
+                       "Need valid indices for plotting distances");
+
+    std::vector<t_pairext> ext(nx1, { 0, -1 });
+    std::vector<char>      jcounted(bGroup ? nx2 : 0);
+    int                    ncount  = 0;
+    const bool             bSearch = (static_cast<int64_t>(nx1) * nx2 >= c_minPairsForSearch);
+    if (!bMin || !bSearch)
+    {
+        scan_dist(pbcptr, x, nx1, nx2, index1, index2, bMin, rcut2, bGroup, bSearch ? nthreads : 1,
+                  &ext, &ncount, &jcounted);
+    }
+    else
+    {
+        std::vector<int> test(nx1);
+        for (int i = 0; i < nx1; i++)
+        {
+            test[i] = i;
+        }
+        /* Searching first with rcut gives the contacts. The closest pair
+         * of any atom found within the cutoff is exact, the others are
+         * searched again with larger cutoffs if their residue, or the whole
+         * group, has no pair within the cutoff. The last pass has no cutoff.
+         */
+        real cutoff = std::abs(rcut);
+        for (int pass = 0; !test.empty(); pass++)
+        {
+            gmx::AnalysisNeighborhood nb;
+            nb.setCutoff(cutoff * c_cutoffMargin);
+            gmx::AnalysisNeighborhoodSearch search = nb.initSearch(
+                    pbcptr, gmx::AnalysisNeighborhoodPositions(x, natoms)
+                                    .indexed(gmx::constArrayRefFromArray(index2, nx2)));
+            search_dist(search, pbcptr, x, natoms, nx2, index1, index2, test, rcut2, pass == 0,
+                        bGroup, nthreads, &ext, &ncount, &jcounted);
+            if (cutoff == 0)
+            {
+                break;
+            }
+            const real cutoff2  = gmx::square(cutoff);
+            const auto resolved = [&ext, cutoff2](int i) {
+                return ext[i].j >= 0 && ext[i].r2 <= cutoff2;
+            };
+            std::vector<int> retest;
+            for (int r = 0; r < std::max(nres, 1); r++)
+            {
+                const int begin = (nres > 0) ? residue[r] : 0;
+                const int end   = (nres > 0) ? residue[r + 1] : nx1;
+                bool      bDone = false;
+                for (int i = begin; i < end && !bDone; i++)
                 {
-                    nmin_j++;
+                    bDone = resolved(i);
                 }
-                else
+                for (int i = begin; i < end && !bDone; i++)
                 {
-                    nmax_j++;
+                    retest.push_back(i);
                 }
             }
+            test.swap(retest);
+            cutoff = (pass < 3) ? 2 * cutoff : 0;
         }
-        if (bGroup)
+    }
+
+    /* Reduce to the extreme pair, taking the first pair in the order
+     * of the loops in scan_dist on ties
+     */
+    int iext = -1;
+    for (int i = 0; i < nx1; i++)
+    {
+        if (ext[i].j >= 0)
         {
-            if (nmin_j > 0)
+            if (iext < 0 || (bMin ? ext[i].r2 < ext[iext].r2 : ext[i].r2 > ext[iext].r2)
+                || (ext[i].r2 == ext[iext].r2 && ext[i].j < ext[iext].j))
             {
-                (*nmin)++;
-            }
-            if (nmax_j > 0)
-            {
-                (*nmax)++;
+                iext = i;
             }
         }
-        else
+    }
+    rext2 = bMin ? 1e12 : -1e12;
+    if (iext >= 0)
+    {
+        rext2  = ext[iext].r2;
+        *ixext = index1[iext];
+        *jxext = index2[ext[iext].j];
+    }
+    *rext = std::sqrt(rext2);
+
+    if (bGroup)
+    {
+        *next = std::count(jcounted.begin(), jcounted.end(), 1);
+    }
+    else
+    {
+        *next = ncount;
+    }
+
+    for (int r = 0; r < nres; r++)
+    {
+        for (int i = residue[r]; i < residue[r + 1]; i++)
         {
-            *nmin += nmin_j;
-            *nmax += nmax_j;
+            if (ext[i].j >= 0)
+            {
+                const real d = std::sqrt(ext[i].r2);
+                resdist[r]   = bMin ? std::min(resdist[r], d) : std::max(resdist[r], d);
+            }
         }
     }
-    *rmin = std::sqrt(rmin2);
-    *rmax = std::sqrt(rmax2);
 }
 
 static void dist_plot(const char*             fn,
@@ -361,26 +715,26 @@ static void dist_plot(const char*             fn,
                       gmx_bool                bGroup,
                       gmx_bool                bEachResEachTime,
                       gmx_bool                bPrintResName,
+                      int                     nthreads,
                       const gmx_output_env_t* oenv)
 {
     FILE *       atm, *dist, *num;
     t_trxstatus* trxout;
     char         buf[256];
     char**       leg;
-    real         t, dmin, dmax, **mindres = nullptr, **maxdres = nullptr;
-    int          nmin, nmax;
+    real         t, dext, **resdist = nullptr;
+    int          next;
     t_trxstatus* status;
-    int          i = -1, j, k;
-    int          min2, max2, min1r, min2r, max1r, max2r;
-    int          min1 = 0;
-    int          max1 = 0;
+    int          natoms, i = -1, j, k;
+    int          ext1 = 0, ext2;
     int          oindex[2];
     rvec*        x0;
     matrix       box;
     gmx_bool     bFirst;
     FILE*        respertime = nullptr;
 
-    if (read_first_x(oenv, &status, fn, &t, &x0, box) == 0)
+    natoms = read_first_x(oenv, &status, fn, &t, &x0, box);
+    if (natoms == 0)
     {
         gmx_fatal(FARGS, "Could not read coordinates from statusfile\n");
     }
@@ -460,17 +814,14 @@ static void dist_plot(const char*             fn,
 
     if (nres)
     {
-        snew(mindres, ng - 1);
-        snew(maxdres, ng - 1);
+        snew(resdist, ng - 1);
         for (i = 1; i < ng; i++)
         {
-            snew(mindres[i - 1], nres);
-            snew(maxdres[i - 1], nres);
+            snew(resdist[i - 1], nres);
             for (j = 0; j < nres; j++)
             {
-                mindres[i - 1][j] = 1e6;
+                resdist[i - 1][j] = bMin ? 1e6 : 0;
             }
-            /* maxdres[*][*] is already 0 */
         }
     }
     bFirst = TRUE;
@@ -498,12 +849,12 @@ static void dist_plot(const char*             fn,
         {
             if (ng == 1)
             {
-                calc_dist(rcut, bPBC, pbcType, box, x0, gnx[0], gnx[0], index[0], index[0], bGroup,
-                          &dmin, &dmax, &nmin, &nmax, &min1, &min2, &max1, &max2);
-                fprintf(dist, "  %12e", bMin ? dmin : dmax);
+                calc_dist(rcut, bPBC, pbcType, box, x0, natoms, gnx[0], gnx[0], index[0], index[0],
+                          bGroup, bMin, 0, nullptr, nullptr, nthreads, &dext, &next, &ext1, &ext2);
+                fprintf(dist, "  %12e", dext);
                 if (num)
                 {
-                    fprintf(num, "  %8d", bMin ? nmin : nmax);
+                    fprintf(num, "  %8d", next);
                 }
             }
             else
@@ -512,12 +863,13 @@ static void dist_plot(const char*             fn,
                 {
                     for (k = i + 1; (k < ng); k++)
                     {
-                        calc_dist(rcut, bPBC, pbcType, box, x0, gnx[i], gnx[k], index[i], index[k],
-                                  bGroup, &dmin, &dmax, &nmin, &nmax, &min1, &min2, &max1, &max2);
-                        fprintf(dist, "  %12e", bMin ? dmin : dmax);
+                        calc_dist(rcut, bPBC, pbcType, box, x0, natoms, gnx[i], gnx[k], index[i],
+                                  index[k], bGroup, bMin, 0, nullptr, nullptr, nthreads, &dext,
+                                  &next, &ext1, &ext2);
+                        fprintf(dist, "  %12e", dext);
                         if (num)
                         {
-                            fprintf(num, "  %8d", bMin ? nmin : nmax);
+                            fprintf(num, "  %8d", next);
                         }
                     }
                 }
@@ -528,23 +880,13 @@ static void dist_plot(const char*             fn,
             GMX_RELEASE_ASSERT(ng > 1, "Must have more than one group when not using -matrix");
             for (i = 1; (i < ng); i++)
             {
-                calc_dist(rcut, bPBC, pbcType, box, x0, gnx[0], gnx[i], index[0], index[i], bGroup,
-                          &dmin, &dmax, &nmin, &nmax, &min1, &min2, &max1, &max2);
-                fprintf(dist, "  %12e", bMin ? dmin : dmax);
+                calc_dist(rcut, bPBC, pbcType, box, x0, natoms, gnx[0], gnx[i], index[0], index[i],
+                          bGroup, bMin, nres, residue, nres ? resdist[i - 1] : nullptr, nthreads,
+                          &dext, &next, &ext1, &ext2);
+                fprintf(dist, "  %12e", dext);
                 if (num)
                 {
-                    fprintf(num, "  %8d", bMin ? nmin : nmax);
-                }
-                if (nres)
-                {
-                    for (j = 0; j < nres; j++)
-                    {
-                        calc_dist(rcut, bPBC, pbcType, box, x0, residue[j + 1] - residue[j], gnx[i],
-                                  &(index[0][residue[j]]), index[i], bGroup, &dmin, &dmax, &nmin,
-                                  &nmax, &min1r, &min2r, &max1r, &max2r);
-                        mindres[i - 1][j] = std::min(mindres[i - 1][j], dmin);
-                        maxdres[i - 1][j] = std::max(maxdres[i - 1][j], dmax);
-                    }
+                    fprintf(num, "  %8d", next);
                 }
             }
         }
@@ -553,19 +895,19 @@ static void dist_plot(const char*             fn,
         {
             fprintf(num, "\n");
         }
-        if ((bMin ? min1 : max1) != -1)
+        if (ext1 != -1)
         {
             if (atm)
             {
-                fprintf(atm, "%12e  %12d  %12d\n", output_env_conv_time(oenv, t),
-                        1 + (bMin ? min1 : max1), 1 + (bMin ? min2 : max2));
+                fprintf(atm, "%12e  %12d  %12d\n", output_env_conv_time(oenv, t), 1 + ext1,
+                        1 + ext2);
             }
         }
 
         if (trxout)
         {
-            oindex[0] = bMin ? min1 : max1;
-            oindex[1] = bMin ? min2 : max2;
+            oindex[0] = ext1;
+            oindex[1] = ext2;
             write_trx(trxout, 2, oindex, atoms, i, t, box, x0, nullptr, nullptr);
         }
         bFirst = FALSE;
@@ -577,10 +919,9 @@ static void dist_plot(const char*             fn,
             {
                 for (j = 0; j < nres; j++)
                 {
-                    fprintf(respertime, " %7g", bMin ? mindres[i - 1][j] : maxdres[i - 1][j]);
+                    fprintf(respertime, " %7g", resdist[i - 1][j]);
                     /*reset distances for next time point*/
-                    mindres[i - 1][j] = 1e6;
-                    maxdres[i - 1][j] = 0;
+                    resdist[i - 1][j] = bMin ? 1e6 : 0;
                 }
             }
             fprintf(respertime, "\n");
@@ -618,7 +959,7 @@ static void dist_plot(const char*             fn,
             fprintf(res, "%4d", j + 1);
             for (i = 1; i < ng; i++)
             {
-                fprintf(res, " %7g", bMin ? mindres[i - 1][j] : maxdres[i - 1][j]);
+                fprintf(res, " %7g", resdist[i - 1][j]);
             }
             fprintf(res, "\n");
         }
@@ -705,6 +1046,8 @@ int gmx_mindist(int argc, char* argv[])
         "with [TT]-s[tt], either as a .tpr file or a .pdb file with CRYST1 fields.",
         "It also plots the maximum distance within the group and the lengths",
         "of the three box vectors.[PAR]",
+        "Minimum distances are computed with a grid search, in parallel over",
+        "[TT]-nthreads[tt] threads, maximum distances loop over all pairs.[PAR]",
         "Also [gmx-distance] and [gmx-pairdist] calculate distances."
     };
 
@@ -713,6 +1056,7 @@ int gmx_mindist(int argc, char* argv[])
     real     rcutoff          = 0.6;
     int      ng               = 1;
     gmx_bool bEachResEachTime = FALSE, bPrintResName = FALSE;
+    int      nThreads         = 0;
     t_pargs  pa[] = {
         { "-matrix", FALSE, etBOOL, { &bMat }, "Calculate half a matrix of group-group distances" },
         { "-max", FALSE, etBOOL, { &bMax }, "Calculate *maximum* distance instead of minimum" },
@@ -735,7 +1079,13 @@ int gmx_mindist(int argc, char* argv[])
           etBOOL,
           { &bEachResEachTime },
           "When writing per-residue distances, write distance for each time point" },
-        { "-printresname", FALSE, etBOOL, { &bPrintResName }, "Write residue names" }
+        { "-printresname", FALSE, etBOOL, { &bPrintResName }, "Write residue names" },
+        { "-nthreads",
+          FALSE,
+          etINT,
+          { &nThreads },
+          "Number of threads used for the distance calculation. nThreads <= 0 means "
+          "maximum number of threads. Requires linking with OpenMP." }
     };
     gmx_output_env_t* oenv;
     t_topology*       top     = nullptr;
@@ -744,7 +1094,7 @@ int gmx_mindist(int argc, char* argv[])
     matrix            box;
     gmx_bool          bTop = FALSE;
 
-    int         i, nres = 0;
+    int         i, nres = 0, nthreads;
     const char *trxfnm, *tpsfnm, *ndxfnm, *distfnm, *numfnm, *atmfnm, *oxfnm, *resfnm;
     char**      grpname;
     int*        gnx;
@@ -842,15 +1192,18 @@ int gmx_mindist(int argc, char* argv[])
         gmx_fatal(FARGS, "Option -or needs to be set to print residues");
     }
 
+    nthreads = std::min((nThreads <= 0) ? INT_MAX : nThreads, gmx_omp_get_max_threads());
+
     if (bPI)
     {
-        periodic_mindist_plot(trxfnm, distfnm, top, pbcType, gnx[0], index[0], bSplit, oenv);
+        periodic_mindist_plot(trxfnm, distfnm, top, pbcType, gnx[0], index[0], bSplit, nthreads,
+                              oenv);
     }
     else
     {
         dist_plot(trxfnm, atmfnm, distfnm, numfnm, resfnm, oxfnm, rcutoff, bMat,
                   top ? &(top->atoms) : nullptr, ng, index, gnx, grpname, bSplit, !bMax, nres,
-                  residues, bPBC, pbcType, bGroup, bEachResEachTime, bPrintResName, oenv);
+                  residues, bPBC, pbcType, bGroup, bEachResEachTime, bPrintResName, nthreads, oenv);
     }
 
     do_view(oenv, distfnm, "-nxy");
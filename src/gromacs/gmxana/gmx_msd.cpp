@@ -37,13 +37,17 @@
  */
 #include "gmxpre.h"
 
+#include <climits>
 #include <cmath>
 #include <cstring>
 
+#include <algorithm>
 #include <memory>
+#include <vector>
 
 #include "gromacs/commandline/pargs.h"
 #include "gromacs/commandline/viewit.h"
+#include "gromacs/fft/fft.h"
 #include "gromacs/fileio/confio.h"
 #include "gromacs/fileio/trxio.h"
 #include "gromacs/fileio/xvgr.h"
@@ -58,9 +62,11 @@
 #include "gromacs/topology/index.h"
 #include "gromacs/topology/topology.h"
 #include "gromacs/utility/arraysize.h"
+#include "gromacs/utility/exceptions.h"
 #include "gromacs/utility/fatalerror.h"
 #include "gromacs/utility/futil.h"
 #include "gromacs/utility/gmxassert.h"
+#include "gromacs/utility/gmxomp.h"
 #include "gromacs/utility/smalloc.h"
 
 static constexpr double diffusionConversionFactor = 1000.0; /* Convert nm^2/ps to 10e-5 cm^2/s */
@@ -106,6 +112,9 @@ struct t_corr
     std::vector<int>                    n_offs;
     std::vector<std::vector<int>>       ndata; /* the number of msds (particles/mols) per data
                                                   point. */
+    gmx_bool                            bFFT;  /* use all frames as time origins, with FFTs */
+    std::vector<std::vector<real>>      xframes; /* with bFFT, per group the coordinates of all
+                                                    particles, appended for each frame */
     t_corr(int               nrgrp,
            int               type,
            int               axis,
@@ -116,7 +125,8 @@ struct t_corr
            real              dt,
            const t_topology* top,
            real              beginfit,
-           real              endfit) :
+           real              endfit,
+           gmx_bool          bFFT) :
         t0(0),
         delta_t(dt),
         beginfit((1 - 2 * GMX_REAL_EPS) * beginfit),
@@ -133,7 +143,9 @@ struct t_corr
         nframes(0),
         nlast(0),
         ngrp(nrgrp),
-        ndata(nrgrp, std::vector<int>())
+        ndata(nrgrp, std::vector<int>()),
+        bFFT(bFFT),
+        xframes(nrgrp, std::vector<real>())
     {
 
         if (bTen)
@@ -208,7 +220,8 @@ static void corr_print(t_corr*                 curr,
     if (DD)
     {
         fprintf(out, "# MSD gathered over %g %s with %d restarts\n", msdtime,
-                output_env_get_time_unit(oenv).c_str(), curr->nrestart);
+                output_env_get_time_unit(oenv).c_str(),
+                curr->bFFT ? curr->nframes : curr->nrestart);
         fprintf(out, "# Diffusion constants fitted from time %g to %g %s\n", beginfit, endfit,
                 output_env_get_time_unit(oenv).c_str());
         for (i = 0; i < curr->ngrp; i++)
@@ -559,6 +572,261 @@ static real calc1_mol(t_corr*   curr,
     return gtot / nx;
 }
 
+/* returns the number of coordinate dimensions used for the msd type and stores them in dims */
+static int msd_dims(const t_corr* curr, int dims[DIM])
+{
+    int ndim = 0;
+
+    switch (curr->type)
+    {
+        case NORMAL:
+            for (int m = 0; m < DIM; m++)
+            {
+                dims[ndim++] = m;
+            }
+            break;
+        case X:
+        case Y:
+        case Z: dims[ndim++] = curr->type - X; break;
+        case LATERAL:
+            for (int m = 0; m < DIM; m++)
+            {
+                if (m != curr->axis)
+                {
+                    dims[ndim++] = m;
+                }
+            }
+            break;
+        default: gmx_fatal(FARGS, "Error: did not expect option value %d", curr->type);
+    }
+
+    return ndim;
+}
+
+/* with bFFT, stores the coordinates of the particles of group nr for the current frame,
+ * relative to the center of mass when that is removed
+ */
+static void store_coords(t_corr* curr, int nr, int nx, const int index[], rvec xc[], gmx_bool bRmCOMM, const rvec com)
+{
+    int                dims[DIM];
+    const int          ndim    = msd_dims(curr, dims);
+    std::vector<real>& xframes = curr->xframes[nr];
+
+    for (int i = 0; i < nx; i++)
+    {
+        const int ix = (index != nullptr) ? index[i] : i;
+        for (int d = 0; d < ndim; d++)
+        {
+            xframes.push_back(xc[ix][dims[d]] - (bRmCOMM ? com[dims[d]] : 0));
+        }
+    }
+}
+
+/* returns an even FFT length of at least 2*n with only factors 2, 3 and 5 */
+static int msd_fft_length(int n)
+{
+    for (int len = n;; len++)
+    {
+        int rest = len;
+        for (int f : { 2, 3, 5 })
+        {
+            while (rest % f == 0)
+            {
+                rest /= f;
+            }
+        }
+        if (rest == 1)
+        {
+            return 2 * len;
+        }
+    }
+}
+
+/* Computes the MSD of group nr for all lags, using every frame as time origin.
+ * For one coordinate x of a particle, the sum over the origins k of
+ * (x(k+m) - x(k))^2 is the sum of x(k)^2 + x(k+m)^2, which follows from
+ * a running sum, minus twice the autocorrelation of x, which is computed
+ * with zero-padded FFTs. The same holds for the products of two coordinates
+ * in the MSD tensor. The particles are divided over nthreads threads.
+ */
+static void calc_msd_fft(t_corr* curr, int nr, int nx, const int index[], gmx_bool bTen, int nthreads)
+{
+    /* The tensor elements in the order used for the output: xx yy zz yx zx zy */
+    static const int tensorElem[6][2] = { { XX, XX }, { YY, YY }, { ZZ, ZZ },
+                                          { YY, XX }, { ZZ, XX }, { ZZ, YY } };
+
+    int         dims[DIM];
+    const int   nframes = curr->nframes;
+    const int   ndim    = msd_dims(curr, dims);
+    const int   nelem   = bTen ? 6 : 1;
+    const int   nfft    = msd_fft_length(nframes);
+    const int   ncplx   = nfft / 2 + 1;
+    const bool  bMol    = (curr->nmol > 0);
+    const bool  bMW     = (!bMol && !curr->mass.empty());
+    const real* xf      = curr->xframes[nr].data();
+
+    GMX_RELEASE_ASSERT(curr->xframes[nr].size() == static_cast<size_t>(nframes) * nx * ndim,
+                       "Coordinates should have been stored for every frame");
+
+    std::vector<std::vector<double>> threadSum(nthreads);
+    std::vector<double>              threadMass(nthreads, 0);
+#pragma omp parallel num_threads(nthreads)
+    {
+        try
+        {
+            const int thread = gmx_omp_get_thread_num();
+            const int i0     = (thread * nx) / nthreads;
+            const int i1     = ((thread + 1) * nx) / nthreads;
+
+            gmx_fft_t              fft;
+            std::vector<real>      xrel(static_cast<size_t>(ndim) * nframes);
+            std::vector<real>      series(nfft);
+            std::vector<t_complex> spectrum(static_cast<size_t>(ndim) * ncplx);
+            std::vector<t_complex> product(ncplx);
+            std::vector<real>      corr(nfft);
+            std::vector<double>    disp(static_cast<size_t>(nelem) * nframes);
+            std::vector<double>&   sum = threadSum[thread];
+
+            sum.assign(static_cast<size_t>(nelem) * nframes, 0);
+            gmx_fft_init_1d_real(&fft, nfft, GMX_FFT_FLAG_CONSERVATIVE);
+
+            for (int i = i0; i < i1; i++)
+            {
+                const real w = bMW ? curr->mass[index[i]] : 1;
+                if (w == 0)
+                {
+                    continue;
+                }
+                threadMass[thread] += w;
+
+                /* Use coordinates relative to their average to reduce rounding errors */
+                for (int d = 0; d < ndim; d++)
+                {
+                    real*  xd  = xrel.data() + static_cast<size_t>(d) * nframes;
+                    double xav = 0;
+                    for (int k = 0; k < nframes; k++)
+                    {
+                        xd[k] = xf[(static_cast<size_t>(k) * nx + i) * ndim + d];
+                        xav += xd[k];
+                    }
+                    xav /= nframes;
+                    for (int k = 0; k < nframes; k++)
+                    {
+                        xd[k] -= xav;
+                        series[k] = xd[k];
+                    }
+                    std::fill(series.begin() + nframes, series.end(), 0);
+                    gmx_fft_1d_real(fft, GMX_FFT_REAL_TO_COMPLEX, series.data(),
+                                    spectrum.data() + static_cast<size_t>(d) * ncplx);
+                }
+
+                for (int e = 0; e < nelem; e++)
+                {
+                    /* For the tensor we need one product of coordinates, otherwise the sum
+                     * of the squares of all dimensions used.
+                     */
+                    const int da0 = bTen ? tensorElem[e][0] : 0;
+                    const int da1 = bTen ? da0 + 1 : ndim;
+                    for (int j = 0; j < ncplx; j++)
+                    {
+                        real re = 0;
+                        for (int da = da0; da < da1; da++)
+                        {
+                            const int db = bTen ? tensorElem[e][1] : da;
+                            re += spectrum[da * ncplx + j].re * spectrum[db * ncplx + j].re
+                                  + spectrum[da * ncplx + j].im * spectrum[db * ncplx + j].im;
+                        }
+                        product[j].re = re;
+                        product[j].im = 0;
+                    }
+                    gmx_fft_1d_real(fft, GMX_FFT_COMPLEX_TO_REAL, product.data(), corr.data());
+
+                    double  sq    = 0;
+                    double* dispe = disp.data() + static_cast<size_t>(e) * nframes;
+                    auto    prod  = [&](int k) {
+                        double p = 0;
+                        for (int da = da0; da < da1; da++)
+                        {
+                            const int db = bTen ? tensorElem[e][1] : da;
+                            p += xrel[da * nframes + k]
+                                 * static_cast<double>(xrel[db * nframes + k]);
+                        }
+                        return p;
+                    };
+                    for (int k = 0; k < nframes; k++)
+                    {
+                        sq += 2 * prod(k);
+                    }
+                    for (int m = 0; m < nframes; m++)
+                    {
+                        if (m > 0)
+                        {
+                            sq -= prod(m - 1) + prod(nframes - m);
+                        }
+                        /* The displacement at lag 0 is zero, avoid rounding errors */
+                        dispe[m] = (m > 0) ? sq - 2.0 * corr[m] / nfft : 0;
+                        sum[e * nframes + m] += w * dispe[m];
+                    }
+                }
+
+                if (bMol)
+                {
+                    /* Zero displacements at lag 0 are not used for the fits with restarts */
+                    for (int m = 1; m < nframes; m++)
+                    {
+                        const real tt = curr->time[m];
+                        if (tt >= curr->beginfit && (curr->endfit < 0 || tt <= curr->endfit))
+                        {
+                            double g = disp[m];
+                            if (bTen)
+                            {
+                                g += disp[nframes + m] + disp[2 * nframes + m];
+                            }
+                            /* Weigh the lags with the number of origins, as with restarts */
+                            gmx_stats_add_point(curr->lsq[0][i], tt, g / (nframes - m), 0,
+                                                1 / std::sqrt(static_cast<real>(nframes - m)));
+                        }
+                    }
+                }
+            }
+            gmx_fft_destroy(fft);
+        }
+        GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR
+    }
+
+    double norm = 0;
+    for (int t = 0; t < nthreads; t++)
+    {
+        norm += threadMass[t];
+    }
+    for (int m = 0; m < nframes; m++)
+    {
+        double elem[6] = { 0 };
+        for (int t = 0; t < nthreads; t++)
+        {
+            for (int e = 0; e < nelem; e++)
+            {
+                elem[e] += threadSum[t][e * nframes + m];
+            }
+        }
+        /* As with restarts, data is summed over the origins and normalized later */
+        curr->ndata[nr][m] = nframes - m;
+        if (bTen)
+        {
+            curr->data[nr][m] = (elem[0] + elem[1] + elem[2]) / norm;
+            clear_mat(curr->datam[nr][m]);
+            for (int e = 0; e < nelem; e++)
+            {
+                curr->datam[nr][m][tensorElem[e][0]][tensorElem[e][1]] = elem[e] / norm;
+            }
+        }
+        else
+        {
+            curr->data[nr][m] = elem[0] / norm;
+        }
+    }
+}
+
 static void printmol(t_corr*                 curr,
                      const char*             fn,
                      const char*             fn_pdb,
@@ -598,7 +866,8 @@ static void printmol(t_corr*                 curr,
                 gmx_stats_add_point(lsq1, xx, yy, dx, dy);
             }
         }
-        gmx_stats_get_ab(lsq1, elsqWEIGHT_NONE, &a, &b, nullptr, nullptr, nullptr, nullptr);
+        /* Only points from all origins at once have an error set, for their weight */
+        gmx_stats_get_ab(lsq1, elsqWEIGHT_Y, &a, &b, nullptr, nullptr, nullptr, nullptr);
         gmx_stats_free(lsq1);
         D = a * diffusionConversionFactor / curr->dim_factor;
         if (D < 0)
@@ -670,6 +939,7 @@ static int corr_loop(t_corr*                  curr,
                      real                     t_pdb,
                      rvec**                   x_pdb,
                      matrix                   box_pdb,
+                     int                      nthreads,
                      const gmx_output_env_t*  oenv)
 {
     rvec*        x[2];  /* the coordinates to read */
@@ -724,6 +994,18 @@ static int corr_loop(t_corr*                  curr,
         gpbc = gmx_rmpbc_init(&top->idef, pbcType, natoms);
     }
 
+    if (curr->bFFT)
+    {
+        /* All frames are origins, the fits per molecule use a single set of points */
+        curr->nrestart = 1;
+        snew(curr->lsq, 1);
+        snew(curr->lsq[0], curr->nmol);
+        for (i = 0; i < curr->nmol; i++)
+        {
+            curr->lsq[0][i] = gmx_stats_init();
+        }
+    }
+
     /* the loop over all frames */
     do
     {
@@ -744,7 +1026,7 @@ static int corr_loop(t_corr*                  curr,
 
 
         /* check whether we've reached a restart point */
-        if (bRmod(t, curr->t0, dt))
+        if (!curr->bFFT && bRmod(t, curr->t0, dt))
         {
             curr->nrestart++;
 
@@ -841,18 +1123,41 @@ static int corr_loop(t_corr*                  curr,
         /* loop over all groups in index file */
         for (i = 0; (i < curr->ngrp); i++)
         {
-            /* calculate something useful, like mean square displacements */
-            calc_corr(curr, i, gnx[i], index[i], xa[cur], (!gnx_com.empty()), com, calc1, bTen);
+            if (curr->bFFT)
+            {
+                store_coords(curr, i, gnx[i], bMol ? nullptr : index[i], xa[cur],
+                             (!gnx_com.empty()), com);
+            }
+            else
+            {
+                /* calculate something useful, like mean square displacements */
+                calc_corr(curr, i, gnx[i], index[i], xa[cur], (!gnx_com.empty()), com, calc1, bTen);
+            }
         }
         cur    = prev;
         t_prev = t;
 
         curr->nframes++;
     } while (read_next_x(oenv, status, &t, x[cur], box));
-    fprintf(stderr, "\nUsed %d restart points spaced %g %s over %g %s\n\n", curr->nrestart,
-            output_env_conv_time(oenv, dt), output_env_get_time_unit(oenv).c_str(),
-            output_env_conv_time(oenv, curr->time[curr->nframes - 1]),
-            output_env_get_time_unit(oenv).c_str());
+    if (curr->bFFT)
+    {
+        fprintf(stderr, "\nUsing all %d frames as restart points over %g %s\n\n", curr->nframes,
+                output_env_conv_time(oenv, curr->time[curr->nframes - 1]),
+                output_env_get_time_unit(oenv).c_str());
+        for (i = 0; i < curr->ngrp; i++)
+        {
+            calc_msd_fft(curr, i, gnx[i], bMol ? nullptr : index[i], bTen, nthreads);
+            /* The coordinates are no longer needed */
+            std::vector<real>().swap(curr->xframes[i]);
+        }
+    }
+    else
+    {
+        fprintf(stderr, "\nUsed %d restart points spaced %g %s over %g %s\n\n", curr->nrestart,
+                output_env_conv_time(oenv, dt), output_env_get_time_unit(oenv).c_str(),
+                output_env_conv_time(oenv, curr->time[curr->nframes - 1]),
+                output_env_get_time_unit(oenv).c_str());
+    }
 
     if (bMol)
     {
@@ -916,6 +1221,8 @@ static void do_corr(const char*             trx_file,
                     real                    dt,
                     real                    beginfit,
                     real                    endfit,
+                    gmx_bool                bFFT,
+                    int                     nthreads,
                     const gmx_output_env_t* oenv)
 {
     std::unique_ptr<t_corr> msd;
@@ -953,11 +1260,12 @@ static void do_corr(const char*             trx_file,
     }
 
     msd = std::make_unique<t_corr>(nrgrp, type, axis, dim_factor, mol_file == nullptr ? 0 : gnx[0],
-                                   bTen, bMW, dt, top, beginfit, endfit);
+                                   bTen, bMW, dt, top, beginfit, endfit, bFFT);
 
     nat_trx = corr_loop(msd.get(), trx_file, top, pbcType, mol_file ? gnx[0] != 0 : false, gnx.data(),
                         index, (mol_file != nullptr) ? calc1_mol : (bMW ? calc1_mw : calc1_norm),
-                        bTen, gnx_com, index_com, dt, t_pdb, pdb_file ? &x : nullptr, box, oenv);
+                        bTen, gnx_com, index_com, dt, t_pdb, pdb_file ? &x : nullptr, box,
+                        nthreads, oenv);
 
     /* Correct for the number of points */
     for (j = 0; (j < msd->ngrp); j++)
@@ -1069,6 +1377,12 @@ int gmx_msd(int argc, char* argv[])
         "not simulation time). An error estimate given, which is the difference",
         "of the diffusion coefficients obtained from fits over the two halves",
         "of the fit interval.[PAR]",
+        "With [TT]-fft[tt], every frame is used as a reference point and",
+        "[TT]-trestart[tt] is ignored. The MSD for all time lags is then",
+        "computed from autocorrelations of the coordinates with fast Fourier",
+        "transforms, distributed over [TT]-nthreads[tt] threads. This is much faster",
+        "than using many reference points, but all coordinates of the",
+        "selected atoms or molecules are kept in memory.[PAR]",
         "There are three, mutually exclusive, options to determine different",
         "types of mean square displacement: [TT]-type[tt], [TT]-lateral[tt]",
         "and [TT]-ten[tt]. Option [TT]-ten[tt] writes the full MSD tensor for",
@@ -1101,17 +1415,19 @@ int gmx_msd(int argc, char* argv[])
         "the diffusion coefficient of the molecule.",
         "This option implies option [TT]-mol[tt]."
     };
-    static const char* normtype[] = { nullptr, "no", "x", "y", "z", nullptr };
-    static const char* axtitle[]  = { nullptr, "no", "x", "y", "z", nullptr };
-    static int         ngroup     = 1;
-    static real        dt         = 10;
-    static real        t_pdb      = 0;
-    static real        beginfit   = -1;
-    static real        endfit     = -1;
-    static gmx_bool    bTen       = FALSE;
-    static gmx_bool    bMW        = TRUE;
-    static gmx_bool    bRmCOMM    = FALSE;
-    t_pargs            pa[]       = {
+    const char* normtype[] = { nullptr, "no", "x", "y", "z", nullptr };
+    const char* axtitle[]  = { nullptr, "no", "x", "y", "z", nullptr };
+    int         ngroup     = 1;
+    real        dt         = 10;
+    real        t_pdb      = 0;
+    real        beginfit   = -1;
+    real        endfit     = -1;
+    gmx_bool    bTen       = FALSE;
+    gmx_bool    bMW        = TRUE;
+    gmx_bool    bRmCOMM    = FALSE;
+    gmx_bool    bFFT       = FALSE;
+    int         nThreads   = 0;
+    t_pargs     pa[]       = {
         { "-type", FALSE, etENUM, { normtype }, "Compute diffusion coefficient in one direction" },
         { "-lateral",
           FALSE,
@@ -1129,7 +1445,18 @@ int gmx_msd(int argc, char* argv[])
           etTIME,
           { &beginfit },
           "Start time for fitting the MSD (%t), -1 is 10%" },
-        { "-endfit", FALSE, etTIME, { &endfit }, "End time for fitting the MSD (%t), -1 is 90%" }
+        { "-endfit", FALSE, etTIME, { &endfit }, "End time for fitting the MSD (%t), -1 is 90%" },
+        { "-fft",
+          FALSE,
+          etBOOL,
+          { &bFFT },
+          "Use all frames as reference points, computed with FFTs" },
+        { "-nthreads",
+          FALSE,
+          etINT,
+          { &nThreads },
+          "Number of threads used with [TT]-fft[tt]. nThreads <= 0 means "
+          "maximum number of threads. Requires linking with OpenMP." }
     };
 
     t_filenm fnm[] = {
@@ -1145,7 +1472,7 @@ int gmx_msd(int argc, char* argv[])
     const char *      trx_file, *tps_file, *ndx_file, *msd_file, *mol_file, *pdb_file;
     rvec*             xdum;
     gmx_bool          bTop;
-    int               axis, type;
+    int               axis, type, nthreads;
     real              dim_factor;
     gmx_output_env_t* oenv;
 
@@ -1219,8 +1546,10 @@ int gmx_msd(int argc, char* argv[])
         gmx_fatal(FARGS, "Could not read a topology from %s. Try a tpr file instead.", tps_file);
     }
 
+    nthreads = std::min((nThreads <= 0) ? INT_MAX : nThreads, gmx_omp_get_max_threads());
+
     do_corr(trx_file, ndx_file, msd_file, mol_file, pdb_file, t_pdb, ngroup, &top, pbcType, bTen,
-            bMW, bRmCOMM, type, dim_factor, axis, dt, beginfit, endfit, oenv);
+            bMW, bRmCOMM, type, dim_factor, axis, dt, beginfit, endfit, bFFT, nthreads, oenv);
 
     done_top(&top);
     view_all(oenv, NFILE, fnm);
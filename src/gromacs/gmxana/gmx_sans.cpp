@@ -78,6 +78,17 @@ int gmx_sans(int argc, char* argv[])
         "Note: When using Debye direct method computational cost increases as",
         "1/2 * N * (N - 1) where N is atom number in group of interest.",
         "[PAR]",
+        "With [TT]-mode grid[tt] the atoms are put on a grid of cells of size",
+        "[TT]-cellsize[tt]. All pairs of atoms in cells closer than [TT]-rnear[tt]",
+        "are binned exactly, for cells farther apart only the number of atoms,",
+        "centroid and spread per atom type are used to distribute the pair",
+        "distances over the bins. This keeps the mean and variance of the",
+        "distance distribution of each pair of cells. [TT]-levels[tt] coarser",
+        "grids, each doubling the cell size and the near-field distance, are used",
+        "for cells far apart, which makes the cost grow roughly linearly with the",
+        "number of atoms. The error in the intensity grows as the fourth power of",
+        "[TT]-endq[tt] times the largest cell size and decreases with [TT]-rnear[tt].",
+        "[PAR]",
         "WARNING: If sq or pr specified this tool can produce large number of files! Up to ",
         "two times larger than number of frames!"
     };
@@ -87,10 +98,12 @@ int gmx_sans(int argc, char* argv[])
                 grid = 0.05; /* bins shouldn't be smaller then smallest bond (~0.1nm) length */
     static real         start_q = 0.0, end_q = 2.0, q_step = 0.01;
     static real         mcover   = -1;
+    static real         cellsize = 0.5, rnear = 1.0;
+    static int          nlevels  = 1;
     static unsigned int seed     = 0;
     static int          nthreads = -1;
 
-    static const char* emode[]   = { nullptr, "direct", "mc", nullptr };
+    static const char* emode[]   = { nullptr, "direct", "mc", "grid", nullptr };
     static const char* emethod[] = { nullptr, "debye", "fft", nullptr };
 
     gmx_neutron_atomic_structurefactors_t* gnsf;
@@ -106,6 +119,13 @@ int gmx_sans(int argc, char* argv[])
           etREAL,
           { &mcover },
           "Monte-Carlo coverage should be -1(default) or (0,1]" },
+        { "-cellsize", FALSE, etREAL, { &cellsize }, "Cell size (nm) for the grid mode" },
+        { "-rnear",
+          FALSE,
+          etREAL,
+          { &rnear },
+          "Distance (nm) between cells within which the grid mode bins all pairs exactly" },
+        { "-levels", FALSE, etINT, { &nlevels }, "Number of coarser cell levels for the grid mode" },
         { "-method", FALSE, etENUM, { emethod }, "[HIDDEN]Method for sans spectra calculation" },
         { "-pbc",
           FALSE,
@@ -128,6 +148,7 @@ int gmx_sans(int argc, char* argv[])
     gmx_rmpbc_t                          gpbc = nullptr;
     gmx_bool                             bFFT = FALSE, bDEBYE = FALSE;
     gmx_bool                             bMC     = FALSE;
+    gmx_bool                             bGrid   = FALSE;
     PbcType                              pbcType = PbcType::Unset;
     matrix                               box;
     rvec*                                x;
@@ -180,6 +201,7 @@ int gmx_sans(int argc, char* argv[])
             {
                 case 'd': bMC = FALSE; break;
                 case 'm': bMC = TRUE; break;
+                case 'g': bGrid = TRUE; break;
                 default: break;
             }
             break;
@@ -193,6 +215,14 @@ int gmx_sans(int argc, char* argv[])
         {
             fprintf(stderr, "Using Monte Carlo Debye method to calculate spectrum\n");
         }
+        else if (bGrid)
+        {
+            if (cellsize <= 0 || nlevels < 0)
+            {
+                gmx_fatal(FARGS, "cellsize should be positive and levels non-negative");
+            }
+            fprintf(stderr, "Using grid Debye method to calculate spectrum\n");
+        }
         else
         {
             fprintf(stderr, "Using direct Debye method to calculate spectrum\n");
@@ -254,8 +284,16 @@ int gmx_sans(int argc, char* argv[])
             snew(pr, 1);
         }
         /*  realy calc p(r) */
-        prframecurrent = calc_radial_distribution_histogram(gsans, x, box, index, isize, binwidth,
-                                                            bMC, bNORM, mcover, seed);
+        if (bGrid)
+        {
+            prframecurrent = calc_radial_distribution_histogram_grid(
+                    gsans, x, box, index, isize, binwidth, bNORM, cellsize, nlevels, rnear);
+        }
+        else
+        {
+            prframecurrent = calc_radial_distribution_histogram(gsans, x, box, index, isize,
+                                                                binwidth, bMC, bNORM, mcover, seed);
+        }
         /* copy prframecurrent -> pr and summ up pr->gr[i] */
         /* allocate and/or resize memory for pr->gr[i] and pr->r[i] */
         if (pr->gr == nullptr)
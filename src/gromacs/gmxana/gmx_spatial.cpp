@@ -39,9 +39,14 @@
 #include <cmath>
 #include <cstdlib>
 
+#include <algorithm>
+#include <climits>
+#include <vector>
+
 #include "gromacs/commandline/pargs.h"
 #include "gromacs/fileio/confio.h"
 #include "gromacs/fileio/trxio.h"
+#include "gromacs/gmxana/densitygrid.h"
 #include "gromacs/gmxana/gmx_ana.h"
 #include "gromacs/math/vec.h"
 #include "gromacs/pbcutil/pbc.h"
@@ -52,11 +57,30 @@
 #include "gromacs/utility/arraysize.h"
 #include "gromacs/utility/cstringutil.h"
 #include "gromacs/utility/futil.h"
+#include "gromacs/utility/gmxomp.h"
 #include "gromacs/utility/smalloc.h"
 
 static const double bohr =
         0.529177249; /* conversion factor to compensate for VMD plugin conversion... */
 
+/* Returns the lattice coordinate of x for the density grid, where bin b
+ * contains the coordinates (b-1, b] in units of binWidth from minBin.
+ * Counting in the nearest bin keeps the exact boundaries, since the
+ * coordinates in compressed trajectories often lie on them.
+ */
+static real binCoordinate(real x, double minBin, real binWidth, gmx::DensitySpreading spreading)
+{
+    const double u = (x - minBin) / binWidth;
+    if (spreading == gmx::DensitySpreading::NearestBin)
+    {
+        return std::ceil(u) + 0.5;
+    }
+    else
+    {
+        return u + 1;
+    }
+}
+
 int gmx_spatial(int argc, char* argv[])
 {
     const char* desc[] = {
@@ -109,7 +133,19 @@ int gmx_spatial(int argc, char* argv[])
         "that are going to be used in the first and subsequent run through [gmx-trjconv].",
         "However, be sure to set the [TT]-nab[tt] option to a sufficiently high value since",
         "memory is allocated for cube bins based on the initial coordinates and the [TT]-nab[tt]",
-        "option value."
+        "option value.",
+        "",
+        "Spreading and output",
+        "^^^^^^^^^^^^^^^^^^^^",
+        "",
+        "By default each atom is counted in the bin that contains it. With [TT]-spread[tt]",
+        "linear, the atom is distributed over the eight nearest bins by trilinear",
+        "interpolation, and with [TT]-spread[tt] gauss it is spread with a Gaussian of",
+        "width [TT]-sigma[tt], which gives smoother isosurfaces from short trajectories.",
+        "Weight that is spread outside the allocated bins is discarded. Atoms are spread",
+        "over the bins in parallel using [TT]-nthreads[tt] threads.",
+        "With [TT]-omrc[tt] the same normalized map is also written in MRC/CCP4 format,",
+        "which can be read by most molecular viewers and by density fitting tools."
     };
     const char* bugs[] = {
         "When the allocated memory is not large enough, a segmentation fault may occur. ",
@@ -127,6 +163,9 @@ int gmx_spatial(int argc, char* argv[])
     static real     rBINWIDTH    = 0.05; /* nm */
     static gmx_bool bCALCDIV     = TRUE;
     static int      iNAB         = 4;
+    const char*     espread[]    = { nullptr, "nearest", "linear", "gauss", nullptr };
+    real            sigma        = 0.05;
+    int             nThreads     = 0;
 
     t_pargs pa[] = { { "-pbc",
                        FALSE,
@@ -153,7 +192,23 @@ int gmx_spatial(int argc, char* argv[])
                        FALSE,
                        etINT,
                        { &iNAB },
-                       "Number of additional bins to ensure proper memory allocation" } };
+                       "Number of additional bins to ensure proper memory allocation" },
+                     { "-spread",
+                       FALSE,
+                       etENUM,
+                       { espread },
+                       "How to distribute atoms over the bins" },
+                     { "-sigma",
+                       FALSE,
+                       etREAL,
+                       { &sigma },
+                       "Width (nm) of the Gaussian used with [TT]-spread[tt] gauss" },
+                     { "-nthreads",
+                       FALSE,
+                       etINT,
+                       { &nThreads },
+                       "Number of threads used for spreading the atoms. nThreads <= 0 means "
+                       "maximum number of threads. Requires linking with OpenMP." } };
 
     double            MINBIN[3];
     double            MAXBIN[3];
@@ -172,19 +227,19 @@ int gmx_spatial(int argc, char* argv[])
     int               i, nidx, nidxp;
     int               v;
     int               j, k;
-    int***            bin = nullptr;
     int               nbin[3];
     FILE*             flp;
     int               x, y, z, minx, miny, minz, maxx, maxy, maxz;
     int               numfr, numcu;
-    int               tot, maxval, minval;
+    double            tot, maxval, minval;
     double            norm;
     gmx_output_env_t* oenv;
     gmx_rmpbc_t       gpbc = nullptr;
 
     t_filenm fnm[] = { { efTPS, nullptr, nullptr, ffREAD }, /* this is for the topology */
                        { efTRX, "-f", nullptr, ffREAD },    /* and this for the trajectory */
-                       { efNDX, nullptr, nullptr, ffOPTRD } };
+                       { efNDX, nullptr, nullptr, ffOPTRD },
+                       { efMRC, "-omrc", "grid", ffOPTWR } };
 
 #define NFILE asize(fnm)
 
@@ -246,19 +301,15 @@ int gmx_spatial(int argc, char* argv[])
         MINBIN[i] -= iNAB * rBINWIDTH;
         nbin[i] = static_cast<int>(std::ceil((MAXBIN[i] - MINBIN[i]) / rBINWIDTH));
     }
-    snew(bin, nbin[XX]);
-    for (i = 0; i < nbin[XX]; ++i)
-    {
-        snew(bin[i], nbin[YY]);
-        for (j = 0; j < nbin[YY]; ++j)
-        {
-            snew(bin[i][j], nbin[ZZ]);
-        }
-    }
+    const int nthreads = std::min((nThreads <= 0) ? INT_MAX : nThreads, gmx_omp_get_max_threads());
+
+    const gmx::DensitySpreading spreading   = gmx::densitySpreadingFromName(espread[0]);
+    const real                  sigmaInBins = sigma / rBINWIDTH;
+    gmx::DensityGridAccumulator bin(gmx::IVec(nbin[XX], nbin[YY], nbin[ZZ]),
+                                    std::array<bool, DIM>{ { false, false, false } }, spreading,
+                                    gmx::RVec(sigmaInBins, sigmaInBins, sigmaInBins), nthreads);
     copy_mat(box, box_pbc);
     numfr = 0;
-    minx = miny = minz = 999;
-    maxx = maxy = maxz = 0;
 
     if (bPBC)
     {
@@ -290,34 +341,10 @@ int gmx_spatial(int argc, char* argv[])
                        fr.x[index[i]][YY], fr.x[index[i]][ZZ]);
                 exit(1);
             }
-            x = static_cast<int>(std::ceil((fr.x[index[i]][XX] - MINBIN[XX]) / rBINWIDTH));
-            y = static_cast<int>(std::ceil((fr.x[index[i]][YY] - MINBIN[YY]) / rBINWIDTH));
-            z = static_cast<int>(std::ceil((fr.x[index[i]][ZZ] - MINBIN[ZZ]) / rBINWIDTH));
-            ++bin[x][y][z];
-            if (x < minx)
-            {
-                minx = x;
-            }
-            if (x > maxx)
-            {
-                maxx = x;
-            }
-            if (y < miny)
-            {
-                miny = y;
-            }
-            if (y > maxy)
-            {
-                maxy = y;
-            }
-            if (z < minz)
-            {
-                minz = z;
-            }
-            if (z > maxz)
-            {
-                maxz = z;
-            }
+            bin.add(gmx::RVec(binCoordinate(fr.x[index[i]][XX], MINBIN[XX], rBINWIDTH, spreading),
+                              binCoordinate(fr.x[index[i]][YY], MINBIN[YY], rBINWIDTH, spreading),
+                              binCoordinate(fr.x[index[i]][ZZ], MINBIN[ZZ], rBINWIDTH, spreading)),
+                    1);
         }
         numfr++;
         /* printf("%f\t%f\t%f\n",box[XX][XX],box[YY][YY],box[ZZ][ZZ]); */
@@ -329,6 +356,31 @@ int gmx_spatial(int argc, char* argv[])
         gmx_rmpbc_done(gpbc);
     }
 
+    /* Find the cube that contains all occupied bins. The outermost bins are
+     * left for the surface layer that is written with negative -ign.
+     */
+    gmx::ArrayRef<const double> binValues = bin.values();
+    minx = miny = minz = 999;
+    maxx = maxy = maxz = 0;
+    for (x = 1; x < nbin[XX] - 1; x++)
+    {
+        for (y = 1; y < nbin[YY] - 1; y++)
+        {
+            for (z = 1; z < nbin[ZZ] - 1; z++)
+            {
+                if (binValues[bin.index(x, y, z)] != 0)
+                {
+                    minx = std::min(minx, x);
+                    maxx = std::max(maxx, x);
+                    miny = std::min(miny, y);
+                    maxy = std::max(maxy, y);
+                    minz = std::min(minz, z);
+                    maxz = std::max(maxz, z);
+                }
+            }
+        }
+    }
+
     if (!bCUTDOWN)
     {
         minx = miny = minz = 0;
@@ -378,36 +430,7 @@ int gmx_spatial(int argc, char* argv[])
                 fr.x[indexp[i]][YY] * 10.0 / bohr, fr.x[indexp[i]][ZZ] * 10.0 / bohr);
     }
 
-    tot = 0;
-    for (k = 0; k < nbin[XX]; k++)
-    {
-        if (!(k < minx || k > maxx))
-        {
-            continue;
-        }
-        for (j = 0; j < nbin[YY]; j++)
-        {
-            if (!(j < miny || j > maxy))
-            {
-                continue;
-            }
-            for (i = 0; i < nbin[ZZ]; i++)
-            {
-                if (!(i < minz || i > maxz))
-                {
-                    continue;
-                }
-                if (bin[k][j][i] != 0)
-                {
-                    printf("A bin was not empty when it should have been empty. Programming "
-                           "error.\n");
-                    printf("bin[%d][%d][%d] was = %d\n", k, j, i, bin[k][j][i]);
-                    exit(1);
-                }
-            }
-        }
-    }
-
+    tot    = 0;
     minval = 999;
     maxval = 0;
     for (k = 0; k < nbin[XX]; k++)
@@ -428,14 +451,14 @@ int gmx_spatial(int argc, char* argv[])
                 {
                     continue;
                 }
-                tot += bin[k][j][i];
-                if (bin[k][j][i] > maxval)
+                tot += binValues[bin.index(k, j, i)];
+                if (binValues[bin.index(k, j, i)] > maxval)
                 {
-                    maxval = bin[k][j][i];
+                    maxval = binValues[bin.index(k, j, i)];
                 }
-                if (bin[k][j][i] < minval)
+                if (binValues[bin.index(k, j, i)] < minval)
                 {
-                    minval = bin[k][j][i];
+                    minval = binValues[bin.index(k, j, i)];
                 }
             }
         }
@@ -470,7 +493,7 @@ int gmx_spatial(int argc, char* argv[])
                 {
                     continue;
                 }
-                fprintf(flp, "%12.6f ", static_cast<double>(norm * bin[k][j][i]) / numfr);
+                fprintf(flp, "%12.6f ", norm * binValues[bin.index(k, j, i)] / numfr);
             }
             fprintf(flp, "\n");
         }
@@ -478,6 +501,35 @@ int gmx_spatial(int argc, char* argv[])
     }
     gmx_ffclose(flp);
 
+    if (opt2bSet("-omrc", NFILE, fnm))
+    {
+        /* The MRC map has the x index running fastest and its origin at the
+         * center of the first bin, bin x covers (x-1, x] bins from MINBIN.
+         */
+        const gmx::IVec numPoints(maxx - minx + 1 - (2 * iIGNOREOUTER),
+                                  maxy - miny + 1 - (2 * iIGNOREOUTER),
+                                  maxz - minz + 1 - (2 * iIGNOREOUTER));
+        const gmx::RVec origin(MINBIN[XX] + (minx + iIGNOREOUTER - 0.5) * rBINWIDTH,
+                               MINBIN[YY] + (miny + iIGNOREOUTER - 0.5) * rBINWIDTH,
+                               MINBIN[ZZ] + (minz + iIGNOREOUTER - 0.5) * rBINWIDTH);
+        std::vector<float> data;
+        data.reserve(numPoints[XX] * numPoints[YY] * numPoints[ZZ]);
+        for (i = minz + iIGNOREOUTER; i <= maxz - iIGNOREOUTER; i++)
+        {
+            for (j = miny + iIGNOREOUTER; j <= maxy - iIGNOREOUTER; j++)
+            {
+                for (k = minx + iIGNOREOUTER; k <= maxx - iIGNOREOUTER; k++)
+                {
+                    const bool bInGrid = (k >= 0 && k < nbin[XX] && j >= 0 && j < nbin[YY]
+                                          && i >= 0 && i < nbin[ZZ]);
+                    data.push_back(bInGrid ? norm * binValues[bin.index(k, j, i)] / numfr : 0);
+                }
+            }
+        }
+        gmx::writeDensityGridMrc(opt2fn("-omrc", NFILE, fnm), numPoints, origin,
+                                 gmx::RVec(rBINWIDTH, rBINWIDTH, rBINWIDTH), data);
+    }
+
     if (bCALCDIV)
     {
         printf("Counts per frame in all %d cubes divided by %le\n", numcu, 1.0 / norm);
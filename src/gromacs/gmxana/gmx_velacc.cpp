@@ -41,9 +41,13 @@
 #include <cstdio>
 #include <cstring>
 
+#include <memory>
+#include <vector>
+
 #include "gromacs/commandline/pargs.h"
 #include "gromacs/commandline/viewit.h"
 #include "gromacs/correlationfunctions/autocorr.h"
+#include "gromacs/correlationfunctions/multipletaucorrelator.h"
 #include "gromacs/fft/fft.h"
 #include "gromacs/fileio/confio.h"
 #include "gromacs/fileio/trxio.h"
@@ -183,17 +187,28 @@ int gmx_velacc(int argc, char* argv[])
                            "of molecule numbers instead of atom numbers.[PAR]",
                            "By using option [TT]-os[tt] you can also extract the estimated",
                            "(vibrational) power spectrum, which is the Fourier transform of the",
-                           "velocity autocorrelation function.",
+                           "velocity autocorrelation function.[PAR]",
+                           "With option [TT]-mtau[tt] the autocorrelation is computed while",
+                           "reading the trajectory with a multiple-tau correlator, which",
+                           "keeps only a number of values per atom that grows with the logarithm",
+                           "of the number of frames. Lags up to 15 frames are exact, longer lags",
+                           "are computed from block averages and are spaced logarithmically.",
+                           "This can not be combined with [TT]-os[tt].[PAR]",
                            "Be sure that your trajectory contains frames with velocity information",
                            "(i.e. [TT]nstvout[tt] was set in your original [REF].mdp[ref] file),",
                            "and that the time interval between data collection points is",
                            "much shorter than the time scale of the autocorrelation." };
 
-    static gmx_bool bMass = FALSE, bMol = FALSE, bRecip = TRUE;
+    static gmx_bool bMass = FALSE, bMol = FALSE, bRecip = TRUE, bMtau = FALSE;
     t_pargs         pa[] = {
         { "-m", FALSE, etBOOL, { &bMass }, "Calculate the momentum autocorrelation function" },
         { "-recip", FALSE, etBOOL, { &bRecip }, "Use cm^-1 on X-axis instead of 1/ps for spectra." },
-        { "-mol", FALSE, etBOOL, { &bMol }, "Calculate the velocity acf of molecules" }
+        { "-mol", FALSE, etBOOL, { &bMol }, "Calculate the velocity acf of molecules" },
+        { "-mtau",
+          FALSE,
+          etBOOL,
+          { &bMtau },
+          "Compute the acf on the fly with a multiple-tau correlator" }
     };
 
     t_topology top;
@@ -213,6 +228,7 @@ int gmx_velacc(int argc, char* argv[])
     rvec         mv_mol;
     /* Array for the correlation function */
     real**            c1;
+    real*             dest;
     real*             normm = nullptr;
     gmx_output_env_t* oenv;
 
@@ -262,21 +278,35 @@ int gmx_velacc(int argc, char* argv[])
         index_atom2mol(&gnx, index, &top.mols);
     }
 
+    if (bMtau && opt2bSet("-os", NFILE, fnm))
+    {
+        gmx_fatal(FARGS, "The power spectrum needs equidistant time points, so -os can not be "
+                         "combined with -mtau");
+    }
+
     /* Correlation stuff */
     snew(c1, gnx);
     for (i = 0; (i < gnx); i++)
     {
         c1[i] = nullptr;
     }
+    std::unique_ptr<gmx::MultipleTauCorrelator> correlator;
+    std::vector<real>                           sample;
+    if (bMtau)
+    {
+        correlator = std::make_unique<gmx::MultipleTauCorrelator>(gnx, DIM);
+        sample.resize(DIM * gnx);
+    }
 
     read_first_frame(oenv, &status, ftp2fn(efTRN, NFILE, fnm), &fr, TRX_NEED_V);
     t0 = fr.time;
+    dt = 0;
 
     n_alloc = 0;
     counter = 0;
     do
     {
-        if (counter >= n_alloc)
+        if (counter >= n_alloc && !bMtau)
         {
             n_alloc += 100;
             for (i = 0; i < gnx; i++)
@@ -306,9 +336,10 @@ int gmx_velacc(int argc, char* argv[])
                     mv_mol[YY] += mass * fr.v[j][YY];
                     mv_mol[ZZ] += mass * fr.v[j][ZZ];
                 }
-                c1[i][counter_dim + XX] = mv_mol[XX];
-                c1[i][counter_dim + YY] = mv_mol[YY];
-                c1[i][counter_dim + ZZ] = mv_mol[ZZ];
+                dest     = bMtau ? &sample[DIM * i] : &c1[i][counter_dim];
+                dest[XX] = mv_mol[XX];
+                dest[YY] = mv_mol[YY];
+                dest[ZZ] = mv_mol[ZZ];
             }
         }
         else
@@ -323,9 +354,18 @@ int gmx_velacc(int argc, char* argv[])
                 {
                     mass = 1;
                 }
-                c1[i][counter_dim + XX] = mass * fr.v[index[i]][XX];
-                c1[i][counter_dim + YY] = mass * fr.v[index[i]][YY];
-                c1[i][counter_dim + ZZ] = mass * fr.v[index[i]][ZZ];
+                dest     = bMtau ? &sample[DIM * i] : &c1[i][counter_dim];
+                dest[XX] = mass * fr.v[index[i]][XX];
+                dest[YY] = mass * fr.v[index[i]][YY];
+                dest[ZZ] = mass * fr.v[index[i]][ZZ];
+            }
+        }
+        if (bMtau)
+        {
+            correlator->addSample(sample);
+            if (counter == 1)
+            {
+                dt = fr.time - t0;
             }
         }
 
@@ -336,7 +376,16 @@ int gmx_velacc(int argc, char* argv[])
 
     close_trx(status);
 
-    if (counter >= 4)
+    if (bMtau && counter >= 4)
+    {
+        do_multipletau_autocorr(
+                opt2fn("-o", NFILE, fnm), oenv,
+                bMass ? "Momentum Autocorrelation Function" : "Velocity Autocorrelation Function",
+                *correlator, dt, TRUE);
+
+        do_view(oenv, opt2fn("-o", NFILE, fnm), "-nxy");
+    }
+    else if (counter >= 4)
     {
         /* Compute time step between frames */
         dt = (t1 - t0) / (counter - 1);
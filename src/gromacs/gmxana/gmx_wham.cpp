@@ -47,6 +47,7 @@
 
 #include <cassert>
 #include <cctype>
+#include <climits>
 #include <cmath>
 #include <cstdio>
 #include <cstdlib>
@@ -54,8 +55,12 @@
 
 #include <algorithm>
 #include <sstream>
+#include <string>
+#include <vector>
 
 #include "gromacs/commandline/pargs.h"
+#include "gromacs/fileio/columnardata.h"
+#include "gromacs/fileio/filetypes.h"
 #include "gromacs/fileio/tpxio.h"
 #include "gromacs/fileio/xvgr.h"
 #include "gromacs/gmxana/gmx_ana.h"
@@ -80,6 +85,7 @@
 #include "gromacs/utility/path.h"
 #include "gromacs/utility/pleasecite.h"
 #include "gromacs/utility/smalloc.h"
+#include "gromacs/utility/stringutil.h"
 
 //! longest file names allowed in input files
 #define WHAM_MAXFILELEN 2048
@@ -319,7 +325,7 @@ typedef struct UmbrellaOptions // NOLINT(clang-analyzer-optin.performance.Paddin
               long the reaction coordinate xi. Avoids gaps along xi. */
     int histBootStrapBlockLength;
 
-    int bsSeed; //!< random seed for bootstrapping
+    int bsSeed; //!< random seed for bootstrapping, each bootstrap uses its own stream
 
     /* \brief Write cumulative distribution functions (CDFs) of histograms
               and write the generated histograms for each bootstrap */
@@ -333,8 +339,7 @@ typedef struct UmbrellaOptions // NOLINT(clang-analyzer-optin.performance.Paddin
     double * tabX, *tabY, tabMin, tabMax, tabDz;
     int      tabNbins;
     /*!\}*/
-    gmx::DefaultRandomEngine           rng;                //!< gromacs random number generator
-    gmx::TabulatedNormalDistribution<> normalDistribution; //!< Uses default: real output, 14-bit table
+    int nthreads; //!< nr of OpenMP threads for reading input and running WHAM and the bootstraps
 } t_UmbrellaOptions;
 
 //! Make an umbrella window (may contain several histograms)
@@ -947,28 +952,33 @@ static void setup_acc_wham(const double* profile, t_UmbrellaWindow* window, int
         printf("Initialized rapid wham stuff (contrib tolerance %g)\n"
                "Evaluating only %d of %d expressions.\n\n",
                wham_contrib_lim, nContrib, nTot);
+        /* Only cleared here, since the bootstraps call this concurrently afterwards */
+        bFirst = 0;
     }
 
     if (opt->verbose)
     {
         printf("Updated rapid wham stuff. (evaluating only %d of %d contributions)\n", nContrib, nTot);
     }
-    bFirst = 0;
 }
 
 //! Compute the PMF (one of the two main WHAM routines)
-static void calc_profile(double* profile, t_UmbrellaWindow* window, int nWindows, t_UmbrellaOptions* opt, gmx_bool bExact)
+static void calc_profile(double*            profile,
+                         t_UmbrellaWindow*  window,
+                         int                nWindows,
+                         t_UmbrellaOptions* opt,
+                         gmx_bool           bExact,
+                         int                nthreads)
 {
     double ztot_half, ztot, min = opt->min, dz = opt->dz;
 
     ztot      = opt->max - opt->min;
     ztot_half = ztot / 2;
 
-#pragma omp parallel
+#pragma omp parallel num_threads(nthreads)
     {
         try
         {
-            int nthreads  = gmx_omp_get_max_threads();
             int thread_id = gmx_omp_get_thread_num();
             int i;
             int i0 = thread_id * opt->bins / nthreads;
@@ -1024,7 +1034,12 @@ static void calc_profile(double* profile, t_UmbrellaWindow* window, int nWindows
 }
 
 //! Compute the free energy offsets z (one of the two main WHAM routines)
-static double calc_z(const double* profile, t_UmbrellaWindow* window, int nWindows, t_UmbrellaOptions* opt, gmx_bool bExact)
+static double calc_z(const double*      profile,
+                     t_UmbrellaWindow*  window,
+                     int                nWindows,
+                     t_UmbrellaOptions* opt,
+                     gmx_bool           bExact,
+                     int                nthreads)
 {
     double min = opt->min, dz = opt->dz, ztot_half, ztot;
     double maxglob = -1e20;
@@ -1032,11 +1047,10 @@ static double calc_z(const double* profile, t_UmbrellaWindow* window, int nWindo
     ztot      = opt->max - opt->min;
     ztot_half = ztot / 2;
 
-#pragma omp parallel
+#pragma omp parallel num_threads(nthreads)
     {
         try
         {
-            int    nthreads  = gmx_omp_get_max_threads();
             int    thread_id = gmx_omp_get_thread_num();
             int    i;
             int    i0     = thread_id * nWindows / nthreads;
@@ -1259,6 +1273,9 @@ static void getRandomIntArray(int nPull, int blockLength, int* randomArray, gmx:
  *
  * This is used when bootstapping new trajectories and thereby create new histogtrams,
  * but it is not required if we bootstrap complete histograms.
+ *
+ * The table of significant contributions is not shared, since every synthetic
+ * window updates its own table during WHAM.
  */
 static void copy_pullgrp_to_synthwindow(t_UmbrellaWindow* synthWindow, t_UmbrellaWindow* thisWindow, int pullid)
 {
@@ -1267,7 +1284,6 @@ static void copy_pullgrp_to_synthwindow(t_UmbrellaWindow* synthWindow, t_Umbrell
     synthWindow->pos[0]      = thisWindow->pos[pullid];
     synthWindow->z[0]        = thisWindow->z[pullid];
     synthWindow->k[0]        = thisWindow->k[pullid];
-    synthWindow->bContrib[0] = thisWindow->bContrib[pullid];
     synthWindow->g[0]        = thisWindow->g[pullid];
     synthWindow->bsWeight[0] = thisWindow->bsWeight[pullid];
 }
@@ -1375,10 +1391,12 @@ static void searchCumulative(const double xx[], int n, double x, int* j)
 }
 
 //! Bootstrap new trajectories and thereby generate new (bootstrapped) histograms
-static void create_synthetic_histo(t_UmbrellaWindow*  synthWindow,
-                                   t_UmbrellaWindow*  thisWindow,
-                                   int                pullid,
-                                   t_UmbrellaOptions* opt)
+static void create_synthetic_histo(t_UmbrellaWindow*                   synthWindow,
+                                   t_UmbrellaWindow*                   thisWindow,
+                                   int                                 pullid,
+                                   t_UmbrellaOptions*                  opt,
+                                   gmx::DefaultRandomEngine*           rng,
+                                   gmx::TabulatedNormalDistribution<>* normalDistribution)
 {
     int    N, i, nbins, r_index, ibin;
     double r, tausteps = 0.0, a, ap, dt, x, invsqrt2, g, y, sig = 0., z, mu = 0.;
@@ -1419,7 +1437,6 @@ static void create_synthetic_histo(t_UmbrellaWindow*  synthWindow,
     synthWindow->pos[0]      = thisWindow->pos[pullid];
     synthWindow->z[0]        = thisWindow->z[pullid];
     synthWindow->k[0]        = thisWindow->k[pullid];
-    synthWindow->bContrib[0] = thisWindow->bContrib[pullid];
     synthWindow->g[0]        = thisWindow->g[pullid];
     synthWindow->bsWeight[0] = thisWindow->bsWeight[pullid];
 
@@ -1455,14 +1472,14 @@ static void create_synthetic_histo(t_UmbrellaWindow*  synthWindow,
     invsqrt2 = 1.0 / std::sqrt(2.0);
 
     /* init random sequence */
-    x = opt->normalDistribution(opt->rng);
+    x = (*normalDistribution)(*rng);
 
     if (opt->bsMethod == bsMethod_traj)
     {
         /* bootstrap points from the umbrella histograms */
         for (i = 0; i < N; i++)
         {
-            y = opt->normalDistribution(opt->rng);
+            y = (*normalDistribution)(*rng);
             x = a * x + ap * y;
             /* get flat distribution in [0,1] using cumulative distribution function of Gauusian
                Note: CDF(Gaussian) = 0.5*{1+erf[x/sqrt(2)]}
@@ -1482,7 +1499,7 @@ static void create_synthetic_histo(t_UmbrellaWindow*  synthWindow,
         i = 0;
         while (i < N)
         {
-            y    = opt->normalDistribution(opt->rng);
+            y    = (*normalDistribution)(*rng);
             x    = a * x + ap * y;
             z    = x * sig + mu;
             ibin = static_cast<int>(std::floor((z - opt->min) / opt->dz));
@@ -1560,7 +1577,7 @@ static void print_histograms(const char*        fnhist,
 }
 
 //! Make random weights for histograms for the Bayesian bootstrap of complete histograms)
-static void setRandomBsWeights(t_UmbrellaWindow* synthwin, int nAllPull, t_UmbrellaOptions* opt)
+static void setRandomBsWeights(t_UmbrellaWindow* synthwin, int nAllPull, gmx::DefaultRandomEngine* rng)
 {
     int                                i;
     double*                            r;
@@ -1571,7 +1588,7 @@ static void setRandomBsWeights(t_UmbrellaWindow* synthwin, int nAllPull, t_Umbre
     /* generate ordered random numbers between 0 and nAllPull  */
     for (i = 0; i < nAllPull - 1; i++)
     {
-        r[i] = dist(opt->rng);
+        r[i] = dist(*rng);
     }
     std::sort(r, r + nAllPull - 1);
     r[nAllPull - 1] = 1.0 * nAllPull;
@@ -1594,7 +1611,66 @@ static void setRandomBsWeights(t_UmbrellaWindow* synthwin, int nAllPull, t_Umbre
     sfree(r);
 }
 
-//! The main bootstrapping routine
+/*! \brief Make the synthetic windows used in one bootstrap, one for each pull group
+ *
+ * With the trajectory bootstrap methods the synthetic windows own their histograms,
+ * otherwise they point to the histograms of the given windows.
+ */
+static t_UmbrellaWindow* initSynthWindows(int nAllPull, t_UmbrellaOptions* opt)
+{
+    t_UmbrellaWindow* synthWindow;
+
+    snew(synthWindow, nAllPull);
+    for (int i = 0; i < nAllPull; i++)
+    {
+        synthWindow[i].nPull = 1;
+        synthWindow[i].nBin  = opt->bins;
+        snew(synthWindow[i].Histo, 1);
+        if (opt->bsMethod == bsMethod_traj || opt->bsMethod == bsMethod_trajGauss)
+        {
+            snew(synthWindow[i].Histo[0], opt->bins);
+        }
+        snew(synthWindow[i].N, 1);
+        snew(synthWindow[i].pos, 1);
+        snew(synthWindow[i].z, 1);
+        snew(synthWindow[i].k, 1);
+        snew(synthWindow[i].bContrib, 1);
+        snew(synthWindow[i].g, 1);
+        snew(synthWindow[i].bsWeight, 1);
+    }
+
+    return synthWindow;
+}
+
+//! Delete the synthetic windows made with initSynthWindows()
+static void freeSynthWindows(t_UmbrellaWindow* synthWindow, int nAllPull, t_UmbrellaOptions* opt)
+{
+    for (int i = 0; i < nAllPull; i++)
+    {
+        if (opt->bsMethod == bsMethod_traj || opt->bsMethod == bsMethod_trajGauss)
+        {
+            sfree(synthWindow[i].Histo[0]);
+        }
+        sfree(synthWindow[i].Histo);
+        sfree(synthWindow[i].N);
+        sfree(synthWindow[i].pos);
+        sfree(synthWindow[i].z);
+        sfree(synthWindow[i].k);
+        sfree(synthWindow[i].bContrib[0]);
+        sfree(synthWindow[i].bContrib);
+        sfree(synthWindow[i].g);
+        sfree(synthWindow[i].bsWeight);
+    }
+    sfree(synthWindow);
+}
+
+/*! \brief The main bootstrapping routine
+ *
+ * The bootstraps are independent, so they are run in parallel, each with its
+ * own synthetic windows. Every bootstrap draws from its own random stream, and
+ * the profiles are written and averaged in order, so the results only depend
+ * on the seed and not on the number of threads.
+ */
 static void do_bootstrapping(const char*        fnres,
                              const char*        fnprof,
                              const char*        fnhist,
@@ -1605,21 +1681,17 @@ static void do_bootstrapping(const char*        fnres,
                              int                nWindows,
                              t_UmbrellaOptions* opt)
 {
-    t_UmbrellaWindow* synthWindow;
-    double *          bsProfile, *bsProfiles_av, *bsProfiles_av2, maxchange = 1e20, tmp, stddev;
-    int               i, j, *randomArray = nullptr, winid, pullid, ib;
-    int               iAllPull, nAllPull, *allPull_winId, *allPull_pullId;
-    FILE*             fp;
-    gmx_bool          bExact = FALSE;
+    double *bsProfiles_av, *bsProfiles_av2, tmp, stddev;
+    int     i, j;
+    int     iAllPull, nAllPull, *allPull_winId, *allPull_pullId;
+    FILE*   fp;
 
     /* init random generator */
     if (opt->bsSeed == 0)
     {
         opt->bsSeed = static_cast<int>(gmx::makeRandomSeed());
     }
-    opt->rng.seed(opt->bsSeed);
 
-    snew(bsProfile, opt->bins);
     snew(bsProfiles_av, opt->bins);
     snew(bsProfiles_av2, opt->bins);
 
@@ -1645,136 +1717,145 @@ static void do_bootstrapping(const char*        fnres,
         }
     }
 
-    /* setup stuff for synthetic windows */
-    snew(synthWindow, nAllPull);
-    for (i = 0; i < nAllPull; i++)
-    {
-        synthWindow[i].nPull = 1;
-        synthWindow[i].nBin  = opt->bins;
-        snew(synthWindow[i].Histo, 1);
-        if (opt->bsMethod == bsMethod_traj || opt->bsMethod == bsMethod_trajGauss)
-        {
-            snew(synthWindow[i].Histo[0], opt->bins);
-        }
-        snew(synthWindow[i].N, 1);
-        snew(synthWindow[i].pos, 1);
-        snew(synthWindow[i].z, 1);
-        snew(synthWindow[i].k, 1);
-        snew(synthWindow[i].bContrib, 1);
-        snew(synthWindow[i].g, 1);
-        snew(synthWindow[i].bsWeight, 1);
-    }
-
     switch (opt->bsMethod)
     {
         case bsMethod_hist:
             printf("\n\nWhen computing statistical errors by bootstrapping entire histograms:\n");
             please_cite(stdout, "Hub2006");
             break;
-        case bsMethod_BayesianHist:
-            /* just copy all histogams into synthWindow array */
-            for (i = 0; i < nAllPull; i++)
-            {
-                winid  = allPull_winId[i];
-                pullid = allPull_pullId[i];
-                copy_pullgrp_to_synthwindow(synthWindow + i, window + winid, pullid);
-            }
-            break;
+        case bsMethod_BayesianHist: break;
         case bsMethod_traj:
         case bsMethod_trajGauss: calc_cumulatives(window, nWindows, opt, fnhist, xlabel); break;
         default: gmx_fatal(FARGS, "Unknown bootstrap method. That should not have happened.\n");
     }
 
     /* do bootstrapping */
-    fp = xvgropen(fnprof, "Bootstrap profiles", xlabel, ylabel, opt->oenv);
-    for (ib = 0; ib < opt->nBootStrap; ib++)
+    const int nthreads = std::min(opt->nthreads, opt->nBootStrap);
+    fp                 = xvgropen(fnprof, "Bootstrap profiles", xlabel, ylabel, opt->oenv);
+#pragma omp parallel num_threads(nthreads)
     {
-        printf("  *******************************************\n"
-               "  ******** Start bootstrap nr %d ************\n"
-               "  *******************************************\n",
-               ib + 1);
-
-        switch (opt->bsMethod)
+        try
         {
-            case bsMethod_hist:
-                /* bootstrap complete histograms from given histograms */
-                srenew(randomArray, nAllPull);
-                getRandomIntArray(nAllPull, opt->histBootStrapBlockLength, randomArray, &opt->rng);
-                for (i = 0; i < nAllPull; i++)
+            t_UmbrellaWindow*   synthWindow = initSynthWindows(nAllPull, opt);
+            std::vector<int>    randomArray(nAllPull);
+            std::vector<double> bsProfile(opt->bins);
+
+#pragma omp for ordered schedule(dynamic)
+            for (int ib = 0; ib < opt->nBootStrap; ib++)
+            {
+                gmx::DefaultRandomEngine           rng(opt->bsSeed);
+                gmx::TabulatedNormalDistribution<> normalDistribution;
+
+                rng.restart(ib);
+
+                /* Collect the output of this bootstrap to print it in order */
+                std::string log = gmx::formatString(
+                        "  *******************************************\n"
+                        "  ******** Start bootstrap nr %d ************\n"
+                        "  *******************************************\n",
+                        ib + 1);
+
+                switch (opt->bsMethod)
                 {
-                    winid  = allPull_winId[randomArray[i]];
-                    pullid = allPull_pullId[randomArray[i]];
-                    copy_pullgrp_to_synthwindow(synthWindow + i, window + winid, pullid);
+                    case bsMethod_hist:
+                        /* bootstrap complete histograms from given histograms */
+                        getRandomIntArray(nAllPull, opt->histBootStrapBlockLength,
+                                          randomArray.data(), &rng);
+                        for (int k = 0; k < nAllPull; k++)
+                        {
+                            int winid  = allPull_winId[randomArray[k]];
+                            int pullid = allPull_pullId[randomArray[k]];
+                            copy_pullgrp_to_synthwindow(synthWindow + k, window + winid, pullid);
+                        }
+                        break;
+                    case bsMethod_BayesianHist:
+                        /* keep histos, but assign random weights ("Bayesian bootstrap").
+                           Copying them for every bootstrap resets z, which keeps the
+                           result independent of the previous bootstrap of this thread. */
+                        for (int k = 0; k < nAllPull; k++)
+                        {
+                            int winid  = allPull_winId[k];
+                            int pullid = allPull_pullId[k];
+                            copy_pullgrp_to_synthwindow(synthWindow + k, window + winid, pullid);
+                        }
+                        setRandomBsWeights(synthWindow, nAllPull, &rng);
+                        break;
+                    case bsMethod_traj:
+                    case bsMethod_trajGauss:
+                        /* create new histos from given histos, that is generate new hypothetical
+                           trajectories */
+                        for (int k = 0; k < nAllPull; k++)
+                        {
+                            int winid  = allPull_winId[k];
+                            int pullid = allPull_pullId[k];
+                            create_synthetic_histo(synthWindow + k, window + winid, pullid, opt,
+                                                   &rng, &normalDistribution);
+                        }
+                        break;
                 }
-                break;
-            case bsMethod_BayesianHist:
-                /* keep histos, but assign random weights ("Bayesian bootstrap") */
-                setRandomBsWeights(synthWindow, nAllPull, opt);
-                break;
-            case bsMethod_traj:
-            case bsMethod_trajGauss:
-                /* create new histos from given histos, that is generate new hypothetical
-                   trajectories */
-                for (i = 0; i < nAllPull; i++)
+
+                /* do wham, with the threads already busy with the bootstraps */
+                int      iter      = 0;
+                gmx_bool bExact    = FALSE;
+                double   maxchange = 1e20;
+                std::copy(profile, profile + opt->bins, bsProfile.begin()); /* use profile as guess */
+                do
+                {
+                    if ((iter % opt->stepUpdateContrib) == 0)
+                    {
+                        setup_acc_wham(bsProfile.data(), synthWindow, nAllPull, opt);
+                    }
+                    if (maxchange < opt->Tolerance)
+                    {
+                        bExact = TRUE;
+                    }
+                    if (((iter % opt->stepchange) == 0 || iter == 1) && iter != 0)
+                    {
+                        log += gmx::formatString("\t%4d) Maximum change %e\n", iter, maxchange);
+                    }
+                    calc_profile(bsProfile.data(), synthWindow, nAllPull, opt, bExact, 1);
+                    iter++;
+                } while ((maxchange = calc_z(bsProfile.data(), synthWindow, nAllPull, opt, bExact, 1))
+                                 > opt->Tolerance
+                         || !bExact);
+                log += gmx::formatString("\tConverged in %d iterations. Final maximum change %g\n",
+                                         iter, maxchange);
+
+                if (opt->bLog)
                 {
-                    winid  = allPull_winId[i];
-                    pullid = allPull_pullId[i];
-                    create_synthetic_histo(synthWindow + i, window + winid, pullid, opt);
+                    prof_normalization_and_unit(bsProfile.data(), opt);
                 }
-                break;
-        }
 
-        /* write histos in case of verbose output */
-        if (opt->bs_verbose)
-        {
-            print_histograms(fnhist, synthWindow, nAllPull, ib, opt, xlabel);
-        }
+                /* symmetrize profile around z=0 */
+                if (opt->bSym)
+                {
+                    symmetrizeProfile(bsProfile.data(), opt);
+                }
 
-        /* do wham */
-        i         = 0;
-        bExact    = FALSE;
-        maxchange = 1e20;
-        std::memcpy(bsProfile, profile, opt->bins * sizeof(double)); /* use profile as guess */
-        do
-        {
-            if ((i % opt->stepUpdateContrib) == 0)
-            {
-                setup_acc_wham(bsProfile, synthWindow, nAllPull, opt);
-            }
-            if (maxchange < opt->Tolerance)
-            {
-                bExact = TRUE;
-            }
-            if (((i % opt->stepchange) == 0 || i == 1) && i != 0)
-            {
-                printf("\t%4d) Maximum change %e\n", i, maxchange);
-            }
-            calc_profile(bsProfile, synthWindow, nAllPull, opt, bExact);
-            i++;
-        } while ((maxchange = calc_z(bsProfile, synthWindow, nAllPull, opt, bExact)) > opt->Tolerance
-                 || !bExact);
-        printf("\tConverged in %d iterations. Final maximum change %g\n", i, maxchange);
+#pragma omp ordered
+                {
+                    printf("%s", log.c_str());
 
-        if (opt->bLog)
-        {
-            prof_normalization_and_unit(bsProfile, opt);
-        }
+                    /* write histos in case of verbose output */
+                    if (opt->bs_verbose)
+                    {
+                        print_histograms(fnhist, synthWindow, nAllPull, ib, opt, xlabel);
+                    }
 
-        /* symmetrize profile around z=0 */
-        if (opt->bSym)
-        {
-            symmetrizeProfile(bsProfile, opt);
-        }
+                    /* save stuff to get average and stddev */
+                    for (int k = 0; k < opt->bins; k++)
+                    {
+                        bsProfiles_av[k] += bsProfile[k];
+                        bsProfiles_av2[k] += bsProfile[k] * bsProfile[k];
+                        fprintf(fp, "%e\t%e\n", (k + 0.5) * opt->dz + opt->min, bsProfile[k]);
+                    }
+                    fprintf(fp, "%s\n", output_env_get_print_xvgr_codes(opt->oenv) ? "&" : "");
+                }
+            }
 
-        /* save stuff to get average and stddev */
-        for (i = 0; i < opt->bins; i++)
-        {
-            tmp = bsProfile[i];
-            bsProfiles_av[i] += tmp;
-            bsProfiles_av2[i] += tmp * tmp;
-            fprintf(fp, "%e\t%e\n", (i + 0.5) * opt->dz + opt->min, tmp);
+            freeSynthWindows(synthWindow, nAllPull, opt);
         }
-        fprintf(fp, "%s\n", output_env_get_print_xvgr_codes(opt->oenv) ? "&" : "");
+        GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR
     }
     xvgrclose(fp);
 
@@ -1794,9 +1875,14 @@ static void do_bootstrapping(const char*        fnres,
     }
     xvgrclose(fp);
     printf("Wrote boot strap result to %s\n", fnres);
+
+    sfree(bsProfiles_av);
+    sfree(bsProfiles_av2);
+    sfree(allPull_winId);
+    sfree(allPull_pullId);
 }
 
-//! Return type of input file based on file extension (xvg, pdo, or tpr)
+//! Return type of input file based on file extension (xvg, col, pdo, or tpr)
 static int whaminFileType(char* fn)
 {
     int len;
@@ -1805,7 +1891,8 @@ static int whaminFileType(char* fn)
     {
         return whamin_tpr;
     }
-    else if (std::strcmp(fn + len - 3, "xvg") == 0 || std::strcmp(fn + len - 6, "xvg.gz") == 0)
+    else if (std::strcmp(fn + len - 3, "xvg") == 0 || std::strcmp(fn + len - 6, "xvg.gz") == 0
+             || std::strcmp(fn + len - 3, "col") == 0)
     {
         return whamin_pullxf;
     }
@@ -1815,7 +1902,7 @@ static int whaminFileType(char* fn)
     }
     else
     {
-        gmx_fatal(FARGS, "Unknown file type of %s. Should be tpr, xvg, or pdo.\n", fn);
+        gmx_fatal(FARGS, "Unknown file type of %s. Should be tpr, xvg, col, or pdo.\n", fn);
     }
 }
 
@@ -2210,8 +2297,37 @@ static void read_tpr_header(const char* fn, t_UmbrellaHeader* header, t_Umbrella
     first = 0;
 }
 
-//! Read pullx.xvg or pullf.xvg
+/*! \brief Return the column of pull coordinate \p g in a pullx or pullf file
+ *
+ * In pullx files the displacement is the first column of each coordinate,
+ * see read_pull_xf() for the other columns.
+ */
+static int pullxfColumnOfCoord(const t_UmbrellaHeader* header, const t_UmbrellaOptions* opt, int g)
+{
+    if (opt->bPullf)
+    {
+        /* One column per force */
+        return g + 1;
+    }
+
+    int column = 1;
+    for (int j = 0; j < g; j++)
+    {
+        column += 1 + (header->bPrintCOM ? header->pcrd[j].ndim * header->pcrd[j].ngroup : 0)
+                  + (header->bPrintRefValue ? 1 : 0);
+    }
+    return column;
+}
+
+/*! \brief Process the data of pullx.xvg or pullf.xvg
+ *
+ * \p y holds the \p ny columns with \p nt rows each as returned by read_xvg(),
+ * it is freed here.
+ */
 static void read_pull_xf(const char*        fn,
+                         double**           y,
+                         int                nt,
+                         int                ny,
                          t_UmbrellaHeader*  header,
                          t_UmbrellaWindow*  window,
                          t_UmbrellaOptions* opt,
@@ -2220,8 +2336,8 @@ static void read_pull_xf(const char*        fn,
                          real*              maxtmp,
                          t_coordselection*  coordsel)
 {
-    double **       y = nullptr, pos = 0., t, force, time0 = 0., dt;
-    int             ny, nt, bins, ibin, i, g, gUsed, dstep = 1;
+    double          pos = 0., t, force, time0 = 0., dt;
+    int             bins, ibin, i, g, gUsed, dstep = 1;
     int             nColExpect, ntot, column;
     real            min, max, minfound = 1e20, maxfound = -1e20;
     gmx_bool        dt_ok, timeok;
@@ -2283,9 +2399,6 @@ static void read_pull_xf(const char*        fn,
         nColExpect += nColThisCrd[g];
     }
 
-    /* read pullf or pullx. Could be optimized if min and max are given. */
-    nt = read_xvg(fn, &y, &ny);
-
     /* Check consistency */
     quantity = opt->bPullx ? "position" : "force";
     if (nt < 1)
@@ -2464,12 +2577,8 @@ static void read_pull_xf(const char*        fn,
                     /* Pick the correct column index.
                        Note that there is always exactly one displacement column.
                      */
-                    column = 1;
-                    for (int j = 0; j < g; j++)
-                    {
-                        column += nColThisCrd[j];
-                    }
-                    pos = y[column][i];
+                    column = pullxfColumnOfCoord(header, opt, g);
+                    pos    = y[column][i];
                 }
 
                 /* printf("crd %d dpos %f poseq %f pos %f \n",g,dpos,poseq,pos); */
@@ -2548,6 +2657,96 @@ static void read_pull_xf(const char*        fn,
     {
         sfree(y[i]);
     }
+    sfree(y);
+    sfree(nColThisCrd);
+    sfree(nColCOMCrd);
+    sfree(nColRefCrd);
+}
+
+/*! \brief Read the columns of binary pullx or pullf file \p fn that are used by read_pull_xf()
+ *
+ * Returns the number of rows, \p y is set up as by read_xvg(), but with
+ * only the time and the displacement or force columns of the selected
+ * coordinates filled. The other columns are nullptr.
+ */
+static int read_pull_col(const char*             fn,
+                         const t_UmbrellaHeader* header,
+                         const t_UmbrellaOptions* opt,
+                         const t_coordselection* coordsel,
+                         double***               y,
+                         int*                    ny)
+{
+    gmx::ColumnarDataReader reader(fn);
+
+    const int nt = reader.numRows();
+    *ny          = reader.numColumns();
+    snew(*y, *ny);
+
+    std::vector<int> columns = { 0 };
+    for (int g = 0; g < header->npullcrds; g++)
+    {
+        if (coordsel == nullptr || coordsel->bUse[g])
+        {
+            columns.push_back(pullxfColumnOfCoord(header, opt, g));
+        }
+    }
+    for (int column : columns)
+    {
+        /* A column count mismatch is reported by read_pull_xf() */
+        if (column < *ny)
+        {
+            const std::vector<double> values = reader.readColumn(column);
+            snew((*y)[column], nt);
+            std::copy(values.begin(), values.end(), (*y)[column]);
+        }
+    }
+
+    return nt;
+}
+
+/*! \brief Read all pullx or pullf files and process them in order
+ *
+ * Parsing the xvg text dominates the reading time with many windows, so the
+ * files are parsed in parallel. The parsed data is passed on to read_pull_xf()
+ * in file order, so the output does not depend on the number of threads.
+ */
+static void read_pull_xf_files(char**             fnPull,
+                               int                nfiles,
+                               t_UmbrellaHeader*  headers,
+                               t_UmbrellaWindow*  window,
+                               t_UmbrellaOptions* opt,
+                               gmx_bool           bGetMinMax,
+                               real*              mintmp,
+                               real*              maxtmp)
+{
+#pragma omp parallel for ordered num_threads(opt->nthreads) schedule(dynamic)
+    for (int i = 0; i < nfiles; i++)
+    {
+        try
+        {
+            double** y  = nullptr;
+            int      ny = 0;
+            t_coordselection* coordsel = (opt->nCoordsel > 0) ? &opt->coordsel[i] : nullptr;
+            int               nt;
+            if (fn2ftp(fnPull[i]) == efCOL)
+            {
+                /* Only the columns used are read from binary files */
+                nt = read_pull_col(fnPull[i], headers + i, opt, coordsel, &y, &ny);
+            }
+            else
+            {
+                /* Could be optimized if min and max are given. */
+                nt = read_xvg(fnPull[i], &y, &ny);
+            }
+#pragma omp ordered
+            {
+                read_pull_xf(fnPull[i], y, nt, ny, headers + i, bGetMinMax ? nullptr : window + i,
+                             opt, bGetMinMax, bGetMinMax ? mintmp + i : nullptr,
+                             bGetMinMax ? maxtmp + i : nullptr, coordsel);
+            }
+        }
+        GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR
+    }
 }
 
 //! read pullf-files.dat or pullx-files.dat and tpr-files.dat
@@ -2558,38 +2757,49 @@ static void read_tpr_pullxf_files(char**             fnTprs,
                                   t_UmbrellaWindow*  window,
                                   t_UmbrellaOptions* opt)
 {
-    int  i;
-    real mintmp, maxtmp;
+    int i;
+
+    if (nfiles < 1)
+    {
+        gmx_fatal(FARGS, "No files found. Hick.");
+    }
 
     printf("Reading %d tpr and pullf files\n", nfiles);
 
+    /* The tpr files are read once, their headers are needed for each pull file */
+    std::vector<t_UmbrellaHeader> headers(nfiles);
+    for (i = 0; i < nfiles; i++)
+    {
+        if (whaminFileType(fnTprs[i]) != whamin_tpr)
+        {
+            gmx_fatal(FARGS, "Expected the %d'th file in input file to be a tpr file\n", i);
+        }
+        read_tpr_header(fnTprs[i], &headers[i], opt, (opt->nCoordsel > 0) ? &opt->coordsel[i] : nullptr);
+        if (whaminFileType(fnPull[i]) != whamin_pullxf)
+        {
+            gmx_fatal(FARGS,
+                      "Expected the %d'th file in input file to be a xvg (pullx/pullf) file\n", i);
+        }
+    }
+
     /* min and max not given? */
     if (opt->bAuto)
     {
         printf("Automatic determination of boundaries...\n");
+        std::vector<real> mintmp(nfiles), maxtmp(nfiles);
+        read_pull_xf_files(fnPull, nfiles, headers.data(), nullptr, opt, TRUE, mintmp.data(),
+                           maxtmp.data());
         opt->min = 1e20;
         opt->max = -1e20;
         for (i = 0; i < nfiles; i++)
         {
-            if (whaminFileType(fnTprs[i]) != whamin_tpr)
+            if (maxtmp[i] > opt->max)
             {
-                gmx_fatal(FARGS, "Expected the %d'th file in input file to be a tpr file\n", i);
+                opt->max = maxtmp[i];
             }
-            read_tpr_header(fnTprs[i], header, opt, (opt->nCoordsel > 0) ? &opt->coordsel[i] : nullptr);
-            if (whaminFileType(fnPull[i]) != whamin_pullxf)
+            if (mintmp[i] < opt->min)
             {
-                gmx_fatal(FARGS,
-                          "Expected the %d'th file in input file to be a xvg (pullx/pullf) file\n", i);
-            }
-            read_pull_xf(fnPull[i], header, nullptr, opt, TRUE, &mintmp, &maxtmp,
-                         (opt->nCoordsel > 0) ? &opt->coordsel[i] : nullptr);
-            if (maxtmp > opt->max)
-            {
-                opt->max = maxtmp;
-            }
-            if (mintmp < opt->min)
-            {
-                opt->min = mintmp;
+                opt->min = mintmp[i];
             }
         }
         printf("\nDetermined boundaries to %f and %f\n\n", opt->min, opt->max);
@@ -2602,21 +2812,11 @@ static void read_tpr_pullxf_files(char**             fnTprs,
     /* store stepsize in profile */
     opt->dz = (opt->max - opt->min) / opt->bins;
 
+    read_pull_xf_files(fnPull, nfiles, headers.data(), window, opt, FALSE, nullptr, nullptr);
+
     bool foundData = false;
     for (i = 0; i < nfiles; i++)
     {
-        if (whaminFileType(fnTprs[i]) != whamin_tpr)
-        {
-            gmx_fatal(FARGS, "Expected the %d'th file in input file to be a tpr file\n", i);
-        }
-        read_tpr_header(fnTprs[i], header, opt, (opt->nCoordsel > 0) ? &opt->coordsel[i] : nullptr);
-        if (whaminFileType(fnPull[i]) != whamin_pullxf)
-        {
-            gmx_fatal(FARGS,
-                      "Expected the %d'th file in input file to be a xvg (pullx/pullf) file\n", i);
-        }
-        read_pull_xf(fnPull[i], header, window + i, opt, FALSE, nullptr, nullptr,
-                     (opt->nCoordsel > 0) ? &opt->coordsel[i] : nullptr);
         if (window[i].Ntot[0] == 0)
         {
             fprintf(stderr, "\nWARNING, no data points read from file %s (check -b option)\n", fnPull[i]);
@@ -2633,6 +2833,13 @@ static void read_tpr_pullxf_files(char**             fnTprs,
                   "-b option?\n");
     }
 
+    /* All pull coordinates are assumed to have the same units, keep the last header */
+    *header = headers[nfiles - 1];
+    for (i = 0; i < nfiles - 1; i++)
+    {
+        sfree(headers[i].pcrd);
+    }
+
     for (i = 0; i < nfiles; i++)
     {
         sfree(fnTprs[i]);
@@ -3168,7 +3375,7 @@ static void guessPotByIntegration(t_UmbrellaWindow* window, int nWindows, t_Umbr
     {
         pot[j] = std::exp(-pot[j] / (BOLTZ * opt->Temperature));
     }
-    calc_z(pot, window, nWindows, opt, TRUE);
+    calc_z(pot, window, nWindows, opt, TRUE, opt->nthreads);
 
     sfree(pot);
     sfree(f);
@@ -3303,6 +3510,10 @@ int gmx_wham(int argc, char* argv[])
         "  provides the pull force output file names ([TT]pullf.xvg[tt]) with option [TT]-if[tt].",
         "  From the pull force the position in the umbrella potential is",
         "  computed. This does not work with tabulated umbrella potentials.",
+        "",
+        "  The pullx and pullf files can be [REF].xvg[ref] files or binary [REF].col[ref]",
+        "  files, as written by [TT]mdrun[tt] when [TT]-px[tt] or [TT]-pf[tt] has",
+        "  extension [TT].col[tt]. From the latter only the needed columns are read.",
         "* With option [TT]-ip[tt], the user provides file names of (gzipped) [REF].pdo[ref] ",
         "  files, i.e.",
         "  the GROMACS 3.3 umbrella output files. If you have some unusual",
@@ -3449,13 +3660,17 @@ int gmx_wham(int argc, char* argv[])
         "",
         "With [TT]-vbs[tt] (verbose bootstrapping), the histograms of each bootstrap are written, ",
         "and, with bootstrap method [TT]traj[tt], the cumulative distribution functions of ",
-        "the histograms."
+        "the histograms.[PAR]",
+        "The pullx/pullf files are parsed and the bootstraps are run in parallel with ",
+        "[TT]-nthreads[tt] threads. Each bootstrap uses its own random stream derived ",
+        "from [TT]-bs-seed[tt], so the results do not depend on the number of threads."
     };
 
     const char* en_unit[]       = { nullptr, "kJ", "kCal", "kT", nullptr };
     const char* en_unit_label[] = { "", "E (kJ mol\\S-1\\N)", "E (kcal mol\\S-1\\N)", "E (kT)", nullptr };
     const char* en_bsMethod[] = { nullptr, "b-hist", "hist", "traj", "traj-gauss", nullptr };
     static t_UmbrellaOptions opt;
+    int                      nThreads = 0;
 
     t_pargs pa[] = {
         { "-min", FALSE, etREAL, { &opt.min }, "Minimum coordinate in profile" },
@@ -3547,6 +3762,12 @@ int gmx_wham(int argc, char* argv[])
           etINT,
           { &opt.stepUpdateContrib },
           "HIDDENUpdate table with significan contributions to WHAM every ... iterations" },
+        { "-nthreads",
+          FALSE,
+          etINT,
+          { &nThreads },
+          "Number of threads used for reading input, WHAM and bootstrapping. nThreads <= 0 "
+          "means maximum number of threads. Requires linking with OpenMP." },
     };
 
     t_filenm fnm[] = {
@@ -3618,6 +3839,7 @@ int gmx_wham(int argc, char* argv[])
 
     opt.unit     = nenum(en_unit);
     opt.bsMethod = nenum(en_bsMethod);
+    opt.nthreads = std::min((nThreads <= 0) ? INT_MAX : nThreads, gmx_omp_get_max_threads());
 
     opt.bProf0Set = opt2parg_bSet("-zprof0", asize(pa), pa);
 
@@ -3815,13 +4037,14 @@ int gmx_wham(int argc, char* argv[])
             /* if (opt.verbose) */
             printf("Switched to exact iteration in iteration %d\n", i);
         }
-        calc_profile(profile, window, nwins, &opt, bExact);
+        calc_profile(profile, window, nwins, &opt, bExact, opt.nthreads);
         if (((i % opt.stepchange) == 0 || i == 1) && i != 0)
         {
             printf("\t%4d) Maximum change %e\n", i, maxchange);
         }
         i++;
-    } while ((maxchange = calc_z(profile, window, nwins, &opt, bExact)) > opt.Tolerance || !bExact);
+    } while ((maxchange = calc_z(profile, window, nwins, &opt, bExact, opt.nthreads)) > opt.Tolerance
+             || !bExact);
     printf("Converged in %d iterations. Final maximum change %g\n", i, maxchange);
 
     /* calc error from Kumar's formula */
@@ -39,10 +39,14 @@
 
 #include "config.h"
 
+#include <algorithm>
 #include <cmath>
 #include <cstring>
+#include <vector>
 
+#include "gromacs/math/functions.h"
 #include "gromacs/math/vec.h"
+#include "gromacs/math/vectypes.h"
 #include "gromacs/random/threefry.h"
 #include "gromacs/random/uniformintdistribution.h"
 #include "gromacs/topology/topology.h"
@@ -189,6 +193,36 @@ gmx_sans_t* gmx_sans_init(const t_topology* top, gmx_neutron_atomic_structurefac
     return gsans;
 }
 
+/* Allocates a histogram with bins up to the length of the box diagonal */
+static gmx_radial_distribution_histogram_t* new_radial_distribution_histogram(const matrix box,
+                                                                              double binwidth)
+{
+    gmx_radial_distribution_histogram_t* pr = nullptr;
+    rvec                                 dist;
+
+    snew(pr, 1);
+    /* set some fields */
+    pr->binwidth = binwidth;
+
+    /*
+     * create max dist rvec
+     * dist = box[xx] + box[yy] + box[zz]
+     */
+    rvec_add(box[XX], box[YY], dist);
+    rvec_add(box[ZZ], dist, dist);
+
+    pr->grn = static_cast<int>(std::floor(norm(dist) / pr->binwidth) + 1);
+
+    snew(pr->gr, pr->grn);
+    snew(pr->r, pr->grn);
+    for (int i = 0; i < pr->grn; i++)
+    {
+        pr->r[i] = (pr->binwidth * i + pr->binwidth * 0.5);
+    }
+
+    return pr;
+}
+
 gmx_radial_distribution_histogram_t* calc_radial_distribution_histogram(gmx_sans_t*  gsans,
                                                                         rvec*        x,
                                                                         matrix       box,
@@ -201,8 +235,6 @@ gmx_radial_distribution_histogram_t* calc_radial_distribution_histogram(gmx_sans
                                                                         unsigned int seed)
 {
     gmx_radial_distribution_histogram_t* pr = nullptr;
-    rvec                                 dist;
-    double                               rmax;
     int                                  i, j;
 #if GMX_OPENMP
     double**                  tgr;
@@ -214,22 +246,7 @@ gmx_radial_distribution_histogram_t* calc_radial_distribution_histogram(gmx_sans
     gmx::DefaultRandomEngine rng(seed);
 
     /* allocate memory for pr */
-    snew(pr, 1);
-    /* set some fields */
-    pr->binwidth = binwidth;
-
-    /*
-     * create max dist rvec
-     * dist = box[xx] + box[yy] + box[zz]
-     */
-    rvec_add(box[XX], box[YY], dist);
-    rvec_add(box[ZZ], dist, dist);
-
-    rmax = norm(dist);
-
-    pr->grn = static_cast<int>(std::floor(rmax / pr->binwidth) + 1);
-
-    snew(pr->gr, pr->grn);
+    pr = new_radial_distribution_histogram(box, binwidth);
 
     if (bMC)
     {
@@ -363,10 +380,598 @@ gmx_radial_distribution_histogram_t* calc_radial_distribution_histogram(gmx_sans
         normalize_probability(pr->grn, pr->gr);
     }
 
-    snew(pr->r, pr->grn);
-    for (i = 0; i < pr->grn; i++)
+    return pr;
+}
+
+/* Bins the distances between one atom and a run of atoms of a single type.
+ * The distance loop has no dependencies between iterations and is written
+ * so that the compiler can vectorize it, only the histogram update is scalar.
+ */
+static void bin_pair_distances(const rvec  xi,
+                               const real* xj,
+                               const real* yj,
+                               const real* zj,
+                               int         n,
+                               real        invBinwidth,
+                               int         maxBin,
+                               int*        binBuffer,
+                               double*     hist)
+{
+    for (int j = 0; j < n; j++)
     {
-        pr->r[i] = (pr->binwidth * i + pr->binwidth * 0.5);
+        real dx      = xj[j] - xi[XX];
+        real dy      = yj[j] - xi[YY];
+        real dz      = zj[j] - xi[ZZ];
+        int  bin     = static_cast<int>(std::sqrt(dx * dx + dy * dy + dz * dz) * invBinwidth);
+        binBuffer[j] = std::min(bin, maxBin);
+    }
+    for (int j = 0; j < n; j++)
+    {
+        hist[binBuffer[j]] += 1;
+    }
+}
+
+namespace
+{
+
+/* Number of atoms and the first two moments of the atoms of one type in one cell */
+struct CellMoments
+{
+    int    n              = 0;
+    dvec   mean           = { 0, 0, 0 };
+    double cov[DIM][DIM] = { { 0 } };
+};
+
+/* The cells of one level of the grid, each coarser level doubles the cell size */
+struct GridLevel
+{
+    ivec                     numCells;
+    std::vector<int>         count;    /* number of atoms per cell */
+    std::vector<gmx::DVec>   centroid; /* centroid per cell */
+    std::vector<CellMoments> moments;  /* moments per cell and type */
+};
+
+/* Histograms per type pair accumulated by one thread */
+struct DebyeHistograms
+{
+    std::vector<double> near; /* exact pair counts */
+    std::vector<double> far;  /* far-field pair weights */
+    std::vector<double> var;  /* far-field pair weights times distance variance */
+    std::vector<int>    binBuffer;
+};
+
+/* Hierarchical cell grid for histogramming the pair distances of a group */
+class DebyeGrid
+{
+public:
+    DebyeGrid(const rvec*             x,
+              const int*              index,
+              int                     isize,
+              const std::vector<int>& typeOfAtom,
+              int                     ntypes,
+              real                    cellsize,
+              int                     numLevels,
+              real                    rnear,
+              double                  binwidth,
+              int                     grn);
+
+    /* Returns the coarsest level */
+    int topLevel() const { return levels_.size() - 1; }
+    /* Returns the occupied cells at level l */
+    std::vector<int> occupiedCells(int l) const;
+    /* Returns zeroed histograms for one thread */
+    DebyeHistograms makeHistograms() const;
+    /* Adds all pairs of atoms in cells a and b at level l, with a <= b */
+    void addCellPair(int l, int a, int b, DebyeHistograms* h) const;
+
+private:
+    int  cellIndex(const GridLevel& level, const ivec c) const
+    {
+        return (c[XX] * level.numCells[YY] + c[YY]) * level.numCells[ZZ] + c[ZZ];
+    }
+    int  pairOffset(int ti, int tj) const
+    {
+        return (std::min(ti, tj) * ntypes_ + std::max(ti, tj)) * grn_;
+    }
+    int  children(int l, int c, int* child) const;
+    void binSelf(int c, DebyeHistograms* h) const;
+    void binPair(int ca, int cb, DebyeHistograms* h) const;
+    void addFarField(const GridLevel& level, int ca, int cb, DebyeHistograms* h) const;
+
+    int                    ntypes_;
+    real                   rnear_;
+    double                 binwidth_;
+    real                   invBinwidth_;
+    int                    grn_;
+    int                    maxRun_;
+    std::vector<GridLevel> levels_;
+    /* Coordinates sorted on level 0 cell and on type within each cell */
+    std::vector<real> xs_, ys_, zs_;
+    /* Start of the atoms of each level 0 cell and type in the sorted coordinates */
+    std::vector<int> start_;
+};
+
+DebyeGrid::DebyeGrid(const rvec*             x,
+                     const int*              index,
+                     int                     isize,
+                     const std::vector<int>& typeOfAtom,
+                     int                     ntypes,
+                     real                    cellsize,
+                     int                     numLevels,
+                     real                    rnear,
+                     double                  binwidth,
+                     int                     grn) :
+    ntypes_(ntypes),
+    rnear_(rnear),
+    binwidth_(binwidth),
+    invBinwidth_(1.0 / binwidth),
+    grn_(grn),
+    maxRun_(0),
+    levels_(numLevels + 1),
+    xs_(isize),
+    ys_(isize),
+    zs_(isize)
+{
+    /* Put a grid of cubic cells on the bounding box of the group */
+    rvec xmin, xmax;
+    copy_rvec(x[index[0]], xmin);
+    copy_rvec(x[index[0]], xmax);
+    for (int i = 1; i < isize; i++)
+    {
+        for (int d = 0; d < DIM; d++)
+        {
+            xmin[d] = std::min(xmin[d], x[index[i]][d]);
+            xmax[d] = std::max(xmax[d], x[index[i]][d]);
+        }
+    }
+    for (int l = 0; l <= numLevels; l++)
+    {
+        GridLevel& level = levels_[l];
+        for (int d = 0; d < DIM; d++)
+        {
+            level.numCells[d] = (l == 0)
+                                        ? std::max(1, static_cast<int>(std::ceil(
+                                                              (xmax[d] - xmin[d]) / cellsize)))
+                                        : (levels_[l - 1].numCells[d] + 1) / 2;
+        }
+        const int ncells = level.numCells[XX] * level.numCells[YY] * level.numCells[ZZ];
+        level.count.resize(ncells, 0);
+        level.centroid.resize(ncells);
+        level.moments.resize(ncells * ntypes_);
+    }
+
+    /* Sort the atoms on cell and on type within each cell */
+    GridLevel&       level0 = levels_[0];
+    std::vector<int> keyOfAtom(isize);
+    start_.resize(level0.count.size() * ntypes_ + 1, 0);
+    for (int i = 0; i < isize; i++)
+    {
+        ivec c;
+        for (int d = 0; d < DIM; d++)
+        {
+            c[d] = std::min(static_cast<int>((x[index[i]][d] - xmin[d]) / cellsize),
+                            level0.numCells[d] - 1);
+        }
+        keyOfAtom[i] = cellIndex(level0, c) * ntypes_ + typeOfAtom[i];
+        start_[keyOfAtom[i] + 1]++;
+    }
+    for (size_t k = 0; k + 1 < start_.size(); k++)
+    {
+        maxRun_ = std::max(maxRun_, start_[k + 1]);
+        start_[k + 1] += start_[k];
+    }
+    std::vector<int> fill(start_.begin(), start_.end() - 1);
+    for (int i = 0; i < isize; i++)
+    {
+        int s  = fill[keyOfAtom[i]]++;
+        xs_[s] = x[index[i]][XX];
+        ys_[s] = x[index[i]][YY];
+        zs_[s] = x[index[i]][ZZ];
+    }
+
+    /* Sum the coordinates and their products per cell and type, first over
+     * the atoms in the level 0 cells and then over the child cells.
+     */
+    for (size_t k = 0; k < level0.moments.size(); k++)
+    {
+        CellMoments& m = level0.moments[k];
+        m.n            = start_[k + 1] - start_[k];
+        for (int s = start_[k]; s < start_[k + 1]; s++)
+        {
+            const dvec xd = { xs_[s], ys_[s], zs_[s] };
+            for (int d = 0; d < DIM; d++)
+            {
+                m.mean[d] += xd[d];
+                for (int e = 0; e < DIM; e++)
+                {
+                    m.cov[d][e] += xd[d] * xd[e];
+                }
+            }
+        }
+    }
+    for (int l = 1; l <= numLevels; l++)
+    {
+        const GridLevel& fine   = levels_[l - 1];
+        GridLevel&       coarse = levels_[l];
+        ivec             c;
+        for (c[XX] = 0; c[XX] < fine.numCells[XX]; c[XX]++)
+        {
+            for (c[YY] = 0; c[YY] < fine.numCells[YY]; c[YY]++)
+            {
+                for (c[ZZ] = 0; c[ZZ] < fine.numCells[ZZ]; c[ZZ]++)
+                {
+                    const ivec parent = { c[XX] / 2, c[YY] / 2, c[ZZ] / 2 };
+                    for (int t = 0; t < ntypes_; t++)
+                    {
+                        const CellMoments& mf = fine.moments[cellIndex(fine, c) * ntypes_ + t];
+                        CellMoments& mc = coarse.moments[cellIndex(coarse, parent) * ntypes_ + t];
+                        mc.n += mf.n;
+                        dvec_inc(mc.mean, mf.mean);
+                        for (int d = 0; d < DIM; d++)
+                        {
+                            dvec_inc(mc.cov[d], mf.cov[d]);
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    /* Convert the sums to means and covariances */
+    for (GridLevel& level : levels_)
+    {
+        for (size_t c = 0; c < level.count.size(); c++)
+        {
+            dvec sum = { 0, 0, 0 };
+            for (int t = 0; t < ntypes_; t++)
+            {
+                CellMoments& m = level.moments[c * ntypes_ + t];
+                if (m.n == 0)
+                {
+                    continue;
+                }
+                level.count[c] += m.n;
+                dvec_inc(sum, m.mean);
+                for (int d = 0; d < DIM; d++)
+                {
+                    m.mean[d] /= m.n;
+                }
+                for (int d = 0; d < DIM; d++)
+                {
+                    for (int e = 0; e < DIM; e++)
+                    {
+                        m.cov[d][e] = m.cov[d][e] / m.n - m.mean[d] * m.mean[e];
+                    }
+                }
+            }
+            if (level.count[c] > 0)
+            {
+                level.centroid[c] = gmx::DVec(sum[XX], sum[YY], sum[ZZ]) / level.count[c];
+            }
+        }
+    }
+}
+
+std::vector<int> DebyeGrid::occupiedCells(int l) const
+{
+    std::vector<int> occupied;
+    for (size_t c = 0; c < levels_[l].count.size(); c++)
+    {
+        if (levels_[l].count[c] > 0)
+        {
+            occupied.push_back(c);
+        }
+    }
+    return occupied;
+}
+
+DebyeHistograms DebyeGrid::makeHistograms() const
+{
+    DebyeHistograms h;
+    h.near.assign(ntypes_ * ntypes_ * grn_, 0);
+    h.far.assign(ntypes_ * ntypes_ * grn_, 0);
+    h.var.assign(ntypes_ * ntypes_ * grn_, 0);
+    h.binBuffer.resize(maxRun_);
+    return h;
+}
+
+/* Stores the occupied cells at level l-1 that make up cell c at level l,
+ * returns their number
+ */
+int DebyeGrid::children(int l, int c, int* child) const
+{
+    const GridLevel& coarse = levels_[l];
+    const GridLevel& fine   = levels_[l - 1];
+    const ivec       cc     = { c / (coarse.numCells[YY] * coarse.numCells[ZZ]),
+                       (c / coarse.numCells[ZZ]) % coarse.numCells[YY], c % coarse.numCells[ZZ] };
+    int              n      = 0;
+    ivec             f;
+    for (f[XX] = 2 * cc[XX]; f[XX] < std::min(2 * cc[XX] + 2, fine.numCells[XX]); f[XX]++)
+    {
+        for (f[YY] = 2 * cc[YY]; f[YY] < std::min(2 * cc[YY] + 2, fine.numCells[YY]); f[YY]++)
+        {
+            for (f[ZZ] = 2 * cc[ZZ]; f[ZZ] < std::min(2 * cc[ZZ] + 2, fine.numCells[ZZ]); f[ZZ]++)
+            {
+                const int fc = cellIndex(fine, f);
+                if (fine.count[fc] > 0)
+                {
+                    child[n++] = fc;
+                }
+            }
+        }
+    }
+    return n;
+}
+
+void DebyeGrid::binSelf(int c, DebyeHistograms* h) const
+{
+    for (int ti = 0; ti < ntypes_; ti++)
+    {
+        for (int i = start_[c * ntypes_ + ti]; i < start_[c * ntypes_ + ti + 1]; i++)
+        {
+            const rvec xi = { xs_[i], ys_[i], zs_[i] };
+            for (int tj = ti; tj < ntypes_; tj++)
+            {
+                const int j0 = std::max(start_[c * ntypes_ + tj], i + 1);
+                const int j1 = start_[c * ntypes_ + tj + 1];
+                if (j1 > j0)
+                {
+                    bin_pair_distances(xi, &xs_[j0], &ys_[j0], &zs_[j0], j1 - j0, invBinwidth_,
+                                       grn_ - 1, h->binBuffer.data(), &h->near[pairOffset(ti, tj)]);
+                }
+            }
+        }
+    }
+}
+
+void DebyeGrid::binPair(int ca, int cb, DebyeHistograms* h) const
+{
+    for (int ti = 0; ti < ntypes_; ti++)
+    {
+        for (int i = start_[ca * ntypes_ + ti]; i < start_[ca * ntypes_ + ti + 1]; i++)
+        {
+            const rvec xi = { xs_[i], ys_[i], zs_[i] };
+            for (int tj = 0; tj < ntypes_; tj++)
+            {
+                const int j0 = start_[cb * ntypes_ + tj];
+                const int j1 = start_[cb * ntypes_ + tj + 1];
+                if (j1 > j0)
+                {
+                    bin_pair_distances(xi, &xs_[j0], &ys_[j0], &zs_[j0], j1 - j0, invBinwidth_,
+                                       grn_ - 1, h->binBuffer.data(), &h->near[pairOffset(ti, tj)]);
+                }
+            }
+        }
+    }
+}
+
+/* The distances between the atoms of a type pair in two distant cells are
+ * distributed around the centroid distance with a mean and variance given
+ * by the cell moments. The weight is split linearly over the two nearest
+ * bins, the remaining variance is stored to spread it out afterwards.
+ */
+void DebyeGrid::addFarField(const GridLevel& level, int ca, int cb, DebyeHistograms* h) const
+{
+    for (int ti = 0; ti < ntypes_; ti++)
+    {
+        const CellMoments& mi = level.moments[ca * ntypes_ + ti];
+        if (mi.n == 0)
+        {
+            continue;
+        }
+        for (int tj = 0; tj < ntypes_; tj++)
+        {
+            const CellMoments& mj = level.moments[cb * ntypes_ + tj];
+            if (mj.n == 0)
+            {
+                continue;
+            }
+            dvec dx;
+            dvec_sub(mj.mean, mi.mean, dx);
+            const double r2    = diprod(dx, dx);
+            const double r     = std::sqrt(r2);
+            double       trace = 0;
+            double       s2    = 0;
+            for (int d = 0; d < DIM; d++)
+            {
+                trace += mi.cov[d][d] + mj.cov[d][d];
+                for (int e = 0; e < DIM; e++)
+                {
+                    s2 += dx[d] * (mi.cov[d][e] + mj.cov[d][e]) * dx[e];
+                }
+            }
+            s2 /= r2;
+            /* The spread perpendicular to the centroid vector lengthens
+             * the distances to second order.
+             */
+            const double mean   = r + 0.5 * (trace - s2) / r;
+            const double w      = static_cast<double>(mi.n) * mj.n;
+            const double u      = mean * invBinwidth_ - 0.5;
+            const int    k      = static_cast<int>(std::floor(u));
+            const double f      = u - k;
+            const int    k0     = std::min(std::max(k, 0), grn_ - 1);
+            const int    k1     = std::min(std::max(k + 1, 0), grn_ - 1);
+            const double s2Bins = s2 - f * (1 - f) * gmx::square(binwidth_);
+            const int    offset = pairOffset(ti, tj);
+            h->far[offset + k0] += (1 - f) * w;
+            h->far[offset + k1] += f * w;
+            h->var[offset + k0] += (1 - f) * w * s2Bins;
+            h->var[offset + k1] += f * w * s2Bins;
+        }
+    }
+}
+
+void DebyeGrid::addCellPair(int l, int a, int b, DebyeHistograms* h) const
+{
+    if (a != b)
+    {
+        /* The far-field distance scales with the cell size */
+        const GridLevel& level = levels_[l];
+        if ((level.centroid[a] - level.centroid[b]).norm2() >= gmx::square(rnear_ * (1 << l)))
+        {
+            addFarField(level, a, b, h);
+            return;
+        }
+    }
+    if (l == 0)
+    {
+        if (a == b)
+        {
+            binSelf(a, h);
+        }
+        else
+        {
+            binPair(a, b, h);
+        }
+        return;
+    }
+    int childA[8], childB[8];
+    int na = children(l, a, childA);
+    if (a == b)
+    {
+        for (int i = 0; i < na; i++)
+        {
+            for (int j = i; j < na; j++)
+            {
+                addCellPair(l - 1, childA[i], childA[j], h);
+            }
+        }
+    }
+    else
+    {
+        int nb = children(l, b, childB);
+        for (int i = 0; i < na; i++)
+        {
+            for (int j = 0; j < nb; j++)
+            {
+                addCellPair(l - 1, std::min(childA[i], childB[j]), std::max(childA[i], childB[j]), h);
+            }
+        }
+    }
+}
+
+} // namespace
+
+gmx_radial_distribution_histogram_t* calc_radial_distribution_histogram_grid(gmx_sans_t* gsans,
+                                                                             rvec*       x,
+                                                                             matrix      box,
+                                                                             const int*  index,
+                                                                             int         isize,
+                                                                             double      binwidth,
+                                                                             gmx_bool    bNORM,
+                                                                             real        cellsize,
+                                                                             int         nlevels,
+                                                                             real        rnear)
+{
+    gmx_radial_distribution_histogram_t* pr = new_radial_distribution_histogram(box, binwidth);
+
+    /* Atoms with the same scattering length are of the same type, the pair
+     * distances are histogrammed per type pair and weighted only at the end.
+     */
+    std::vector<double> typeSlength;
+    std::vector<int>    typeOfAtom(isize);
+    for (int i = 0; i < isize; i++)
+    {
+        double b = gsans->slength[index[i]];
+        auto   t = std::find(typeSlength.begin(), typeSlength.end(), b);
+        if (t == typeSlength.end())
+        {
+            typeSlength.push_back(b);
+            t = typeSlength.end() - 1;
+        }
+        typeOfAtom[i] = static_cast<int>(t - typeSlength.begin());
+    }
+    const int ntypes = typeSlength.size();
+    const int ntp    = ntypes * ntypes;
+
+    const DebyeGrid grid(x, index, isize, typeOfAtom, ntypes, cellsize, nlevels, rnear, binwidth,
+                         pr->grn);
+
+    const int                    top      = grid.topLevel();
+    const std::vector<int>       occupied = grid.occupiedCells(top);
+    const int                    noccupied = occupied.size();
+    const int                    nthreads = gmx_omp_get_max_threads();
+    std::vector<DebyeHistograms> thist(nthreads);
+
+#pragma omp parallel num_threads(nthreads)
+    {
+        try
+        {
+            DebyeHistograms& h = thist[gmx_omp_get_thread_num()];
+            h                  = grid.makeHistograms();
+#pragma omp for schedule(dynamic)
+            for (int a = 0; a < noccupied; a++)
+            {
+                for (int b = a; b < noccupied; b++)
+                {
+                    grid.addCellPair(top, occupied[a], occupied[b], &h);
+                }
+            }
+        }
+        GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR
+    }
+
+    /* Reduce over threads and spread the far-field weight of each bin with
+     * a Gaussian of the average variance that was deposited in it.
+     */
+    std::vector<double> hist(ntp * pr->grn, 0);
+    for (int tid = 0; tid < nthreads; tid++)
+    {
+        for (int k = 0; k < ntp * pr->grn; k++)
+        {
+            hist[k] += thist[tid].near[k];
+        }
+        if (tid > 0)
+        {
+            for (int k = 0; k < ntp * pr->grn; k++)
+            {
+                thist[0].far[k] += thist[tid].far[k];
+                thist[0].var[k] += thist[tid].var[k];
+            }
+        }
+    }
+    std::vector<double> fraction;
+    for (int k = 0; k < ntp * pr->grn; k++)
+    {
+        const double w   = thist[0].far[k];
+        const double s2  = (w > 0) ? thist[0].var[k] / w : 0;
+        const int    bin = k % pr->grn;
+        if (s2 <= 0.01 * gmx::square(binwidth))
+        {
+            hist[k] += w;
+            continue;
+        }
+        const double scale = binwidth / std::sqrt(2 * s2);
+        const int    range = static_cast<int>(std::ceil(4 / (M_SQRT2 * scale)));
+        double       sum   = 0;
+        fraction.resize(2 * range + 1);
+        for (int j = -range; j <= range; j++)
+        {
+            fraction[j + range] = std::erf((j + 0.5) * scale) - std::erf((j - 0.5) * scale);
+            sum += fraction[j + range];
+        }
+        for (int j = -range; j <= range; j++)
+        {
+            hist[k - bin + std::min(std::max(bin + j, 0), pr->grn - 1)] += w * fraction[j + range] / sum;
+        }
+    }
+
+    for (int ti = 0; ti < ntypes; ti++)
+    {
+        for (int tj = ti; tj < ntypes; tj++)
+        {
+            const double b2     = typeSlength[ti] * typeSlength[tj];
+            const int    offset = (ti * ntypes + tj) * pr->grn;
+            for (int k = 0; k < pr->grn; k++)
+            {
+                pr->gr[k] += b2 * hist[offset + k];
+            }
+        }
+    }
+
+    if (bNORM)
+    {
+        normalize_probability(pr->grn, pr->gr);
     }
 
     return pr;
@@ -94,6 +94,23 @@ gmx_radial_distribution_histogram_t* calc_radial_distribution_histogram(gmx_sans
                                                                         real         mcover,
                                                                         unsigned int seed);
 
+/* Computes the same histogram as calc_radial_distribution_histogram() with
+ * cell lists: pairs of cells with centroids closer than rnear are binned
+ * exactly, farther pairs of cells contribute per atom type pair with the
+ * mean and variance of their distance distribution from the cell moments.
+ * Each of the nlevels coarser levels doubles the cell size and rnear.
+ */
+gmx_radial_distribution_histogram_t* calc_radial_distribution_histogram_grid(gmx_sans_t* gsans,
+                                                                             rvec*       x,
+                                                                             matrix      box,
+                                                                             const int*  index,
+                                                                             int         isize,
+                                                                             double      binwidth,
+                                                                             gmx_bool    bNORM,
+                                                                             real        cellsize,
+                                                                             int         nlevels,
+                                                                             real        rnear);
+
 gmx_static_structurefactor_t* convert_histogram_to_intensity_curve(gmx_radial_distribution_histogram_t* pr,
                                                                    double start_q,
                                                                    double end_q,
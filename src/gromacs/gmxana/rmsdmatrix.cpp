@@ -0,0 +1,366 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2021, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Implements the pairwise RMSD matrix computation for gmx cluster.
+ */
+#include "gmxpre.h"
+
+#include "rmsdmatrix.h"
+
+#include <cinttypes>
+#include <cmath>
+#include <cstdio>
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include "gromacs/math/functions.h"
+#include "gromacs/math/vec.h"
+#include "gromacs/simd/simd.h"
+#include "gromacs/utility/alignedallocator.h"
+
+namespace
+{
+
+//! Number of frames along each side of a tile of the matrix
+constexpr int c_tileSize = 32;
+
+#if GMX_SIMD_HAVE_DOUBLE
+//! Type used for accumulating inner products
+typedef gmx::SimdDouble PackType;
+//! Number of atoms handled per pack
+constexpr int c_packSize = GMX_SIMD_DOUBLE_WIDTH;
+#else
+//! Type used for accumulating inner products
+typedef double PackType;
+//! Number of atoms handled per pack
+constexpr int c_packSize = 1;
+#endif
+
+/*! \brief Coordinates of all frames packed for computing inner products
+ *
+ * Only atoms with non-zero weight are stored. For each frame the x, y
+ * and z components are stored as separate arrays, padded with zeros to
+ * a multiple of the pack size, and scaled by the square root of the
+ * atom weight. The inner products are accumulated in double precision,
+ * because the RMSD follows from the difference of large terms.
+ */
+struct PackedFrames
+{
+    //! Returns the packed coordinates of \p frame
+    const double* frame(int frame) const
+    {
+        return x.data() + static_cast<size_t>(frame) * DIM * numAtomsPadded;
+    }
+
+    //! Number of stored atoms per frame, including padding
+    int numAtomsPadded = 0;
+    //! Sum of the atom weights
+    double totalWeight = 0;
+    //! The packed coordinates
+    std::vector<double, gmx::AlignedAllocator<double>> x;
+    //! The weighted sum of squared coordinates per frame
+    std::vector<double> selfProduct;
+};
+
+PackedFrames packFrames(int nframes, int natoms, rvec* const x[], const real mass[])
+{
+    std::vector<int>  atoms;
+    std::vector<real> sqrtWeight;
+    PackedFrames      packed;
+    for (int i = 0; i < natoms; i++)
+    {
+        if (mass[i] != 0)
+        {
+            atoms.push_back(i);
+            sqrtWeight.push_back(std::sqrt(mass[i]));
+            packed.totalWeight += mass[i];
+        }
+    }
+    const int numAtoms    = atoms.size();
+    packed.numAtomsPadded = ((numAtoms + c_packSize - 1) / c_packSize) * c_packSize;
+    packed.x.resize(static_cast<size_t>(nframes) * DIM * packed.numAtomsPadded, 0.0);
+    packed.selfProduct.resize(nframes);
+    for (int f = 0; f < nframes; f++)
+    {
+        double* dest = packed.x.data() + static_cast<size_t>(f) * DIM * packed.numAtomsPadded;
+        double  sum  = 0;
+        for (int i = 0; i < numAtoms; i++)
+        {
+            for (int d = 0; d < DIM; d++)
+            {
+                const double v = sqrtWeight[i] * x[f][atoms[i]][d];
+
+                dest[d * packed.numAtomsPadded + i] = v;
+                sum += v * v;
+            }
+        }
+        packed.selfProduct[f] = sum;
+    }
+    return packed;
+}
+
+//! Computes the weighted inner product matrix s of frames \p f1 and \p f2
+void innerProduct(const PackedFrames& frames, int f1, int f2, double s[DIM][DIM])
+{
+    const int                  n  = frames.numAtomsPadded;
+    const double* gmx_restrict x1 = frames.frame(f1);
+    const double* gmx_restrict y1 = x1 + n;
+    const double* gmx_restrict z1 = y1 + n;
+    const double* gmx_restrict x2 = frames.frame(f2);
+    const double* gmx_restrict y2 = x2 + n;
+    const double* gmx_restrict z2 = y2 + n;
+
+    PackType sxx(0.0), sxy(0.0), sxz(0.0);
+    PackType syx(0.0), syy(0.0), syz(0.0);
+    PackType szx(0.0), szy(0.0), szz(0.0);
+    for (int i = 0; i < n; i += c_packSize)
+    {
+        const PackType ax = gmx::load<PackType>(x1 + i);
+        const PackType ay = gmx::load<PackType>(y1 + i);
+        const PackType az = gmx::load<PackType>(z1 + i);
+        const PackType bx = gmx::load<PackType>(x2 + i);
+        const PackType by = gmx::load<PackType>(y2 + i);
+        const PackType bz = gmx::load<PackType>(z2 + i);
+
+        sxx = gmx::fma(ax, bx, sxx);
+        sxy = gmx::fma(ax, by, sxy);
+        sxz = gmx::fma(ax, bz, sxz);
+        syx = gmx::fma(ay, bx, syx);
+        syy = gmx::fma(ay, by, syy);
+        syz = gmx::fma(ay, bz, syz);
+        szx = gmx::fma(az, bx, szx);
+        szy = gmx::fma(az, by, szy);
+        szz = gmx::fma(az, bz, szz);
+    }
+    s[XX][XX] = gmx::reduce(sxx);
+    s[XX][YY] = gmx::reduce(sxy);
+    s[XX][ZZ] = gmx::reduce(sxz);
+    s[YY][XX] = gmx::reduce(syx);
+    s[YY][YY] = gmx::reduce(syy);
+    s[YY][ZZ] = gmx::reduce(syz);
+    s[ZZ][XX] = gmx::reduce(szx);
+    s[ZZ][YY] = gmx::reduce(szy);
+    s[ZZ][ZZ] = gmx::reduce(szz);
+}
+
+/*! \brief Returns the largest eigenvalue of the quaternion key matrix
+ *
+ * The key matrix is built from the inner product matrix \p s, its
+ * largest eigenvalue is found by Newton iteration on the characteristic
+ * polynomial, starting from the upper bound \p e0, which is half the
+ * sum of the weighted squared coordinates of both structures. This is
+ * the formulation of Liu, Agrafiotis and Theobald, J. Comput. Chem. 31,
+ * 1561 (2010).
+ */
+double qcpMaxEigenvalue(const double s[DIM][DIM], double e0)
+{
+    const double sxx = s[XX][XX], sxy = s[XX][YY], sxz = s[XX][ZZ];
+    const double syx = s[YY][XX], syy = s[YY][YY], syz = s[YY][ZZ];
+    const double szx = s[ZZ][XX], szy = s[ZZ][YY], szz = s[ZZ][ZZ];
+
+    const double sxx2 = sxx * sxx, syy2 = syy * syy, szz2 = szz * szz;
+    const double sxy2 = sxy * sxy, syz2 = syz * syz, sxz2 = sxz * sxz;
+    const double syx2 = syx * syx, szy2 = szy * szy, szx2 = szx * szx;
+
+    const double syzSzymSyySzz2       = 2.0 * (syz * szy - syy * szz);
+    const double sxx2Syy2Szz2Syz2Szy2 = syy2 + szz2 - sxx2 + syz2 + szy2;
+
+    const double c2 = -2.0 * (sxx2 + syy2 + szz2 + sxy2 + syx2 + sxz2 + szx2 + syz2 + szy2);
+    const double c1 = 8.0
+                      * (sxx * syz * szy + syy * szx * sxz + szz * sxy * syx - sxx * syy * szz
+                         - syz * szx * sxy - szy * syx * sxz);
+
+    const double sxzpSzx          = sxz + szx;
+    const double syzpSzy          = syz + szy;
+    const double sxypSyx          = sxy + syx;
+    const double syzmSzy          = syz - szy;
+    const double sxzmSzx          = sxz - szx;
+    const double sxymSyx          = sxy - syx;
+    const double sxxpSyy          = sxx + syy;
+    const double sxxmSyy          = sxx - syy;
+    const double sxy2Sxz2Syx2Szx2 = sxy2 + sxz2 - syx2 - szx2;
+
+    const double c0 =
+            sxy2Sxz2Syx2Szx2 * sxy2Sxz2Syx2Szx2
+            + (sxx2Syy2Szz2Syz2Szy2 + syzSzymSyySzz2) * (sxx2Syy2Szz2Syz2Szy2 - syzSzymSyySzz2)
+            + (-sxzpSzx * syzmSzy + sxymSyx * (sxxmSyy - szz))
+                      * (-sxzmSzx * syzpSzy + sxymSyx * (sxxmSyy + szz))
+            + (-sxzpSzx * syzpSzy - sxypSyx * (sxxpSyy - szz))
+                      * (-sxzmSzx * syzmSzy - sxypSyx * (sxxpSyy + szz))
+            + (sxypSyx * syzpSzy + sxzpSzx * (sxxmSyy + szz))
+                      * (-sxymSyx * syzmSzy + sxzpSzx * (sxxpSyy + szz))
+            + (sxypSyx * syzmSzy + sxzmSzx * (sxxmSyy - szz))
+                      * (-sxymSyx * syzpSzy + sxzmSzx * (sxxpSyy - szz));
+
+    const double c_tolerance = 1e-11;
+    const int    c_maxIter   = 50;
+
+    double lambda = e0;
+    for (int iter = 0; iter < c_maxIter; iter++)
+    {
+        const double lambdaOld = lambda;
+        const double lambda2   = lambda * lambda;
+        const double b         = (lambda2 + c2) * lambda;
+        const double a         = b + c1;
+        const double delta     = (a * lambda + c0) / (2.0 * lambda2 * lambda + b + a);
+        lambda -= delta;
+        if (std::fabs(lambda - lambdaOld) < std::fabs(c_tolerance * lambda))
+        {
+            break;
+        }
+    }
+    return lambda;
+}
+
+//! Returns the weighted mean squared deviation between two frames
+double pairMsd(const PackedFrames& frames, int f1, int f2, gmx_bool bFit)
+{
+    double s[DIM][DIM];
+    innerProduct(frames, f1, f2, s);
+    const double e0 = 0.5 * (frames.selfProduct[f1] + frames.selfProduct[f2]);
+    /* Without fitting the largest eigenvalue is replaced by the trace */
+    const double lambda = bFit ? qcpMaxEigenvalue(s, e0) : s[XX][XX] + s[YY][YY] + s[ZZ][ZZ];
+    return std::max(0.0, 2.0 * (e0 - lambda)) / frames.totalWeight;
+}
+
+//! Minimum, maximum and sum of the RMSD values of a tile
+struct TileResult
+{
+    //! Minimum off-diagonal RMSD
+    real minrms = 1e20;
+    //! Maximum RMSD
+    real maxrms = 0;
+    //! Sum of RMSD values
+    double sumrms = 0;
+    //! Number of RMSD values computed
+    int64_t count = 0;
+};
+
+} // namespace
+
+real rmsd_qcp(int natoms, const real* w, const rvec* x1, const rvec* x2)
+{
+    double s[DIM][DIM] = { { 0 } };
+    double e0          = 0;
+    double totalWeight = 0;
+    for (int i = 0; i < natoms; i++)
+    {
+        for (int d = 0; d < DIM; d++)
+        {
+            for (int e = 0; e < DIM; e++)
+            {
+                s[d][e] += static_cast<double>(w[i]) * x1[i][d] * x2[i][e];
+            }
+            e0 += 0.5 * w[i] * (gmx::square(x1[i][d]) + gmx::square(x2[i][d]));
+        }
+        totalWeight += w[i];
+    }
+    const double lambda = qcpMaxEigenvalue(s, e0);
+    return std::sqrt(std::max(0.0, 2.0 * (e0 - lambda)) / totalWeight);
+}
+
+void calc_rmsd_matrix(t_mat*      m,
+                      int         nframes,
+                      int         natoms,
+                      rvec* const x[],
+                      const real  mass[],
+                      gmx_bool    bFit,
+                      int         nthreads)
+{
+    const PackedFrames frames = packFrames(nframes, natoms, x, mass);
+
+    /* The upper triangle is split into square tiles, so the coordinates
+     * of the two sets of frames of a tile stay in cache while computing it.
+     */
+    const int                        numBlocks = (nframes + c_tileSize - 1) / c_tileSize;
+    std::vector<std::pair<int, int>> tiles;
+    for (int bi = 0; bi < numBlocks; bi++)
+    {
+        for (int bj = bi; bj < numBlocks; bj++)
+        {
+            tiles.emplace_back(bi, bj);
+        }
+    }
+    std::vector<TileResult> results(tiles.size());
+
+    const int numTiles = tiles.size();
+
+    int64_t nrms = (static_cast<int64_t>(nframes) * static_cast<int64_t>(nframes - 1)) / 2;
+#pragma omp parallel for num_threads(nthreads) schedule(dynamic)
+    for (int t = 0; t < numTiles; t++)
+    {
+        const int   i0     = tiles[t].first * c_tileSize;
+        const int   i1     = std::min(i0 + c_tileSize, nframes);
+        const int   j0     = tiles[t].second * c_tileSize;
+        const int   j1     = std::min(j0 + c_tileSize, nframes);
+        TileResult& result = results[t];
+        for (int i = i0; i < i1; i++)
+        {
+            for (int j = std::max(j0, i + 1); j < j1; j++)
+            {
+                const real rmsd = std::sqrt(pairMsd(frames, i, j, bFit));
+                /* Each element belongs to a single tile */
+                m->mat[i][j] = m->mat[j][i] = rmsd;
+                result.minrms = std::min(result.minrms, rmsd);
+                result.maxrms = std::max(result.maxrms, rmsd);
+                result.sumrms += rmsd;
+                result.count++;
+            }
+        }
+#pragma omp critical
+        {
+            nrms -= result.count;
+            fprintf(stderr, "\r# RMSD calculations left: %" PRId64 "   ", nrms);
+            fflush(stderr);
+        }
+    }
+
+    /* Combine in a fixed order, so the result does not depend on the threading */
+    double sumrms = m->sumrms;
+    for (const TileResult& result : results)
+    {
+        m->minrms = std::min(m->minrms, result.minrms);
+        m->maxrms = std::max(m->maxrms, result.maxrms);
+        sumrms += result.sumrms;
+    }
+    m->sumrms = sumrms;
+    if (nframes > 1)
+    {
+        m->nn = std::max(m->nn, nframes);
+    }
+}
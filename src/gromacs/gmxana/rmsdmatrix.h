@@ -0,0 +1,88 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2021, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Computation of the pairwise RMSD matrix between trajectory frames.
+ */
+#ifndef GMX_GMXANA_RMSDMATRIX_H
+#define GMX_GMXANA_RMSDMATRIX_H
+
+#include "gromacs/gmxana/cmat.h"
+#include "gromacs/math/vectypes.h"
+#include "gromacs/utility/basedefinitions.h"
+#include "gromacs/utility/real.h"
+
+/*! \brief Returns the minimal weighted RMSD between two centered structures
+ *
+ * Computes the RMSD after optimal rotation of \p x2 onto \p x1 from the
+ * inner product matrix of the structures, without constructing the
+ * rotation, using the quaternion characteristic polynomial method of
+ * Theobald (Acta Cryst. A61, 478 (2005)). Both structures should have
+ * their weighted center at the origin.
+ *
+ * \param[in] natoms  Number of atoms
+ * \param[in] w       Weights, atoms with zero weight are ignored
+ * \param[in] x1      Reference structure
+ * \param[in] x2      Structure fitted onto \p x1
+ * \return The weighted RMSD after fitting
+ */
+real rmsd_qcp(int natoms, const real* w, const rvec* x1, const rvec* x2);
+
+/*! \brief Fills the RMSD matrix between all pairs of frames
+ *
+ * The computation is split into tiles of frame pairs that are
+ * distributed over \p nthreads OpenMP threads. Only atoms with non-zero
+ * mass contribute, and the RMSD is mass weighted, as with do_fit() and
+ * rmsdev(). With \p bFit the frames should be centered and the RMSD is
+ * computed after optimal rotation, otherwise without fitting.
+ *
+ * \param[in,out] m        Matrix to store the RMSD values in, also
+ *                         updates the minimum, maximum and sum
+ * \param[in]     nframes  Number of frames
+ * \param[in]     natoms   Number of atoms per frame
+ * \param[in]     x        Coordinates of all frames
+ * \param[in]     mass     Atom masses used as weights
+ * \param[in]     bFit     Whether to fit the frames before computing the RMSD
+ * \param[in]     nthreads Number of threads to use
+ */
+void calc_rmsd_matrix(t_mat*      m,
+                      int         nframes,
+                      int         natoms,
+                      rvec* const x[],
+                      const real  mass[],
+                      gmx_bool    bFit,
+                      int         nthreads);
+
+#endif
@@ -0,0 +1,172 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2021, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Tests for the density grid accumulator used by gmx density, densmap and spatial.
+ */
+#include "gmxpre.h"
+
+#include "gromacs/gmxana/densitygrid.h"
+
+#include <cmath>
+
+#include <array>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "gromacs/math/vectypes.h"
+#include "gromacs/random/threefry.h"
+#include "gromacs/random/uniformrealdistribution.h"
+#include "gromacs/utility/exceptions.h"
+
+#include "testutils/testasserts.h"
+
+namespace
+{
+
+using gmx::DensityGridAccumulator;
+using gmx::DensitySpreading;
+using gmx::test::relativeToleranceAsFloatingPoint;
+
+//! Grid size used in the tests
+const gmx::IVec c_numBins = { 7, 5, 4 };
+
+//! Returns random points with lattice coordinates in [-1, n+1) in each dimension
+std::vector<gmx::RVec> randomPoints(int numPoints)
+{
+    gmx::DefaultRandomEngine           rng(1234, gmx::RandomDomain::Other);
+    std::vector<gmx::RVec>             points(numPoints);
+    gmx::UniformRealDistribution<real> dist(0, 1);
+    for (gmx::RVec& x : points)
+    {
+        for (int d = 0; d < DIM; d++)
+        {
+            x[d] = (c_numBins[d] + 2) * dist(rng) - 1;
+        }
+    }
+    return points;
+}
+
+TEST(DensityGridAccumulatorTest, NearestBinMatchesDirectBinning)
+{
+    /* More points than are buffered, so the grid is spread several times */
+    const std::vector<gmx::RVec> points = randomPoints(150000);
+    std::vector<double>          ref(c_numBins[XX] * c_numBins[YY] * c_numBins[ZZ], 0);
+    DensityGridAccumulator grid(c_numBins, { { false, true, false } }, DensitySpreading::NearestBin,
+                                { 0, 0, 0 }, 2);
+    for (const gmx::RVec& x : points)
+    {
+        grid.add(x, 0.5);
+        std::array<int, DIM> bin;
+        bool                 bInside = true;
+        for (int d = 0; d < DIM; d++)
+        {
+            bin[d] = static_cast<int>(std::floor(x[d]));
+            if (d == YY)
+            {
+                bin[d] = (bin[d] + c_numBins[d]) % c_numBins[d];
+            }
+            bInside = bInside && bin[d] >= 0 && bin[d] < c_numBins[d];
+        }
+        if (bInside)
+        {
+            ref[grid.index(bin[XX], bin[YY], bin[ZZ])] += 0.5;
+        }
+    }
+    gmx::ArrayRef<const double> values = grid.values();
+    ASSERT_EQ(ref.size(), values.size());
+    for (size_t i = 0; i < ref.size(); i++)
+    {
+        EXPECT_EQ(ref[i], values[i]) << "bin " << i;
+    }
+}
+
+TEST(DensityGridAccumulatorTest, PeriodicSpreadingConservesWeight)
+{
+    const std::vector<gmx::RVec> points = randomPoints(1000);
+    for (DensitySpreading spreading : { DensitySpreading::Linear, DensitySpreading::Gaussian })
+    {
+        DensityGridAccumulator grid(c_numBins, { { true, true, true } }, spreading,
+                                    { 0.8, 1.0, 1.5 }, 3);
+        for (const gmx::RVec& x : points)
+        {
+            grid.add(x, 2);
+        }
+        double sum = 0;
+        for (double value : grid.values())
+        {
+            EXPECT_GE(value, 0);
+            sum += value;
+        }
+        EXPECT_DOUBLE_EQ_TOL(2.0 * points.size(), sum,
+                             relativeToleranceAsFloatingPoint(2.0 * points.size(), 1e-9));
+    }
+}
+
+TEST(DensityGridAccumulatorTest, LinearSpreadingInterpolatesBetweenBinCenters)
+{
+    DensityGridAccumulator grid({ 4, 1, 1 }, { { true, true, true } }, DensitySpreading::Linear,
+                                { 0, 0, 0 }, 1);
+    grid.add({ 1.5, 0, 0 }, 1);
+    grid.add({ 3.75, 0, 0 }, 1);
+    gmx::ArrayRef<const double> values = grid.values();
+    EXPECT_REAL_EQ(0.25, values[0]);
+    EXPECT_REAL_EQ(1.0, values[1]);
+    EXPECT_REAL_EQ(0.0, values[2]);
+    EXPECT_REAL_EQ(0.75, values[3]);
+}
+
+TEST(DensityGridAccumulatorTest, GaussianSpreadingIsSymmetric)
+{
+    DensityGridAccumulator grid({ 1, 9, 1 }, { { false, false, false } },
+                                DensitySpreading::Gaussian, { 0, 1, 0 }, 1);
+    grid.add({ 0.5, 4.5, 0.5 }, 1);
+    gmx::ArrayRef<const double> values = grid.values();
+    for (int j = 0; j < 4; j++)
+    {
+        EXPECT_REAL_EQ(values[grid.index(0, j, 0)], values[grid.index(0, 8 - j, 0)]);
+        EXPECT_LT(values[grid.index(0, j, 0)], values[grid.index(0, j + 1, 0)]);
+    }
+}
+
+TEST(DensityGridAccumulatorTest, ThrowsWithNarrowGaussian)
+{
+    EXPECT_THROW_GMX(DensityGridAccumulator(c_numBins, { { true, true, true } },
+                                            DensitySpreading::Gaussian, { 1, 0.4, 1 }, 1),
+                     gmx::InvalidInputError);
+}
+
+} // namespace
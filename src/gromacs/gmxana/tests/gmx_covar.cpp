@@ -0,0 +1,170 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2021, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Tests for gmx covar.
+ */
+#include "gmxpre.h"
+
+#include <string>
+
+#include "gromacs/fileio/xvgr.h"
+#include "gromacs/gmxana/gmx_ana.h"
+#include "gromacs/utility/stringutil.h"
+#include "gromacs/utility/textwriter.h"
+
+#include "testutils/cmdlinetest.h"
+#include "testutils/refdata.h"
+#include "testutils/stdiohelper.h"
+#include "testutils/testasserts.h"
+#include "testutils/testfilemanager.h"
+#include "testutils/textblockmatchers.h"
+#include "testutils/xvgtest.h"
+
+namespace
+{
+
+using gmx::test::CommandLine;
+using gmx::test::StdioTestHelper;
+using gmx::test::XvgMatch;
+
+//! Number of eigenvalues computed with the partial diagonalization methods
+const int c_numEigenvalues = 4;
+
+/*! \brief Test fixture for gmx covar
+ *
+ * hbond.xtc contains 11 frames of water. The analysis uses the first 30
+ * molecules, so the covariance matrix is 270 x 270 with a rank of at most 10.
+ */
+class CovarTest : public gmx::test::CommandLineTestBase
+{
+public:
+    CovarTest()
+    {
+        indexFile_ = fileManager().getTemporaryFilePath(".ndx");
+        gmx::TextWriter writer(indexFile_);
+        writer.writeLine("[ Water ]");
+        for (int i = 1; i <= 90; i++)
+        {
+            writer.writeString(gmx::formatString("%d ", i));
+        }
+        writer.writeLine();
+        writer.close();
+    }
+
+    /*! \brief Runs gmx covar with \p args and returns the name of the eigenvalue file
+     *
+     * All output files are written to temporary files.
+     */
+    std::string runCovar(const CommandLine& args)
+    {
+        StdioTestHelper stdioHelper(&fileManager());
+        stdioHelper.redirectStringToStdin("0\n0\n");
+
+        const char* const command[] = { "covar" };
+        CommandLine       cmdline(command);
+        cmdline.merge(args);
+        cmdline.addOption("-f", fileManager().getInputFilePath("hbond.xtc"));
+        cmdline.addOption("-s", fileManager().getInputFilePath("hbond.tpr"));
+        cmdline.addOption("-n", indexFile_);
+        std::string eigenvalueFile = fileManager().getTemporaryFilePath(".xvg");
+        cmdline.addOption("-o", eigenvalueFile);
+        cmdline.addOption("-v", fileManager().getTemporaryFilePath(".trr"));
+        cmdline.addOption("-av", fileManager().getTemporaryFilePath(".pdb"));
+        cmdline.addOption("-l", fileManager().getTemporaryFilePath(".log"));
+        EXPECT_EQ(0, gmx_covar(cmdline.argc(), cmdline.argv()));
+        return eigenvalueFile;
+    }
+
+    //! Checks that \p method gives the largest eigenvalues of the full diagonalization
+    void checkPartialDiagonalization(const char* method)
+    {
+        const char* const fullCommand[] = { "covar", "-diag", "full" };
+        const std::string fullFile      = runCovar(CommandLine(fullCommand));
+
+        const char* const partialCommand[] = { "covar", "-diag", method };
+        CommandLine       partialArgs(partialCommand);
+        partialArgs.addOption("-last", c_numEigenvalues);
+        const std::string partialFile = runCovar(partialArgs);
+
+        auto full    = readXvgData(fullFile);
+        auto partial = readXvgData(partialFile);
+        ASSERT_EQ(c_numEigenvalues, partial.extent(1));
+        for (int k = 0; k < c_numEigenvalues; k++)
+        {
+            EXPECT_REAL_EQ_TOL(full(1, k), partial(1, k),
+                               gmx::test::relativeToleranceAsFloatingPoint(full(1, 0), 1e-4))
+                    << "for eigenvalue " << k;
+        }
+    }
+
+protected:
+    //! Index file with the group used for fitting and analysis
+    std::string indexFile_;
+};
+
+TEST_F(CovarTest, ComputesEigenvalues)
+{
+    const char* const command[] = { "covar" };
+    CommandLine       args(command);
+    args.addOption("-n", indexFile_);
+    args.addOption("-v", fileManager().getTemporaryFilePath(".trr"));
+    args.addOption("-av", fileManager().getTemporaryFilePath(".pdb"));
+    args.addOption("-l", fileManager().getTemporaryFilePath(".log"));
+    setInputFile("-f", "hbond.xtc");
+    setInputFile("-s", "hbond.tpr");
+    XvgMatch xvg;
+    xvg.tolerance(gmx::test::relativeToleranceAsFloatingPoint(1, 1e-4));
+    setOutputFile("-o", "eigenval.xvg", xvg);
+
+    StdioTestHelper stdioHelper(&fileManager());
+    stdioHelper.redirectStringToStdin("0\n0\n");
+    CommandLine& cmdline = commandLine();
+    cmdline.merge(args);
+    ASSERT_EQ(0, gmx_covar(cmdline.argc(), cmdline.argv()));
+    checkOutputFiles();
+}
+
+TEST_F(CovarTest, LanczosMatchesFullDiagonalization)
+{
+    checkPartialDiagonalization("lanczos");
+}
+
+TEST_F(CovarTest, RandomizedMatchesFullDiagonalization)
+{
+    checkPartialDiagonalization("random");
+}
+
+} // namespace
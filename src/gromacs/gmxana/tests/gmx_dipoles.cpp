@@ -0,0 +1,123 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2021, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Tests for the dipole autocorrelation in gmx dipoles.
+ */
+#include "gmxpre.h"
+
+#include <string>
+
+#include "gromacs/fileio/xvgr.h"
+#include "gromacs/gmxana/gmx_ana.h"
+
+#include "testutils/cmdlinetest.h"
+#include "testutils/stdiohelper.h"
+#include "testutils/testasserts.h"
+#include "testutils/testfilemanager.h"
+
+namespace
+{
+
+using gmx::test::CommandLine;
+using gmx::test::StdioTestHelper;
+
+/*! \brief Test fixture for gmx dipoles
+ *
+ * hbond.xtc contains 11 frames of water, so all lags of the default
+ * correlation length are computed exactly by the multiple-tau correlator.
+ */
+class DipolesTest : public gmx::test::CommandLineTestBase
+{
+public:
+    /*! \brief Runs gmx dipoles with \p args and returns the name of the correlation file
+     *
+     * All output files are written to temporary files.
+     */
+    std::string runDipoles(const CommandLine& args)
+    {
+        StdioTestHelper stdioHelper(&fileManager());
+        stdioHelper.redirectStringToStdin("0\n");
+
+        const char* const command[] = { "dipoles" };
+        CommandLine       cmdline(command);
+        cmdline.merge(args);
+        cmdline.addOption("-f", fileManager().getInputFilePath("hbond.xtc"));
+        cmdline.addOption("-s", fileManager().getInputFilePath("hbond.tpr"));
+        std::string correlationFile = fileManager().getTemporaryFilePath(".xvg");
+        cmdline.addOption("-c", correlationFile);
+        cmdline.addOption("-o", fileManager().getTemporaryFilePath("Mtot.xvg"));
+        cmdline.addOption("-eps", fileManager().getTemporaryFilePath("epsilon.xvg"));
+        cmdline.addOption("-a", fileManager().getTemporaryFilePath("aver.xvg"));
+        cmdline.addOption("-d", fileManager().getTemporaryFilePath("dipdist.xvg"));
+        EXPECT_EQ(0, gmx_dipoles(cmdline.argc(), cmdline.argv()));
+        return correlationFile;
+    }
+
+    //! Checks that -mtau gives the same correlation function as the FFT for \p corrType
+    void checkMultipleTauMatchesFft(const char* corrType)
+    {
+        const char* const fftCommand[] = { "dipoles", "-corr", corrType };
+        const std::string fftFile      = runDipoles(CommandLine(fftCommand));
+
+        const char* const mtauCommand[] = { "dipoles", "-corr", corrType, "-mtau" };
+        const std::string mtauFile      = runDipoles(CommandLine(mtauCommand));
+
+        auto fft  = readXvgData(fftFile);
+        auto mtau = readXvgData(mtauFile);
+        ASSERT_EQ(fft.extent(0), mtau.extent(0));
+        ASSERT_EQ(fft.extent(1), mtau.extent(1));
+        ASSERT_LT(1, fft.extent(1));
+        for (int j = 0; j < fft.extent(1); j++)
+        {
+            EXPECT_REAL_EQ_TOL(fft(0, j), mtau(0, j), gmx::test::absoluteTolerance(1e-3))
+                    << "for the time of lag " << j;
+            EXPECT_REAL_EQ_TOL(fft(1, j), mtau(1, j), gmx::test::absoluteTolerance(1e-4))
+                    << "for lag " << j;
+        }
+    }
+};
+
+TEST_F(DipolesTest, MultipleTauMatchesFftForMolecularDipoles)
+{
+    checkMultipleTauMatchesFft("mol");
+}
+
+TEST_F(DipolesTest, MultipleTauMatchesFftForTotalDipole)
+{
+    checkMultipleTauMatchesFft("total");
+}
+
+} // namespace
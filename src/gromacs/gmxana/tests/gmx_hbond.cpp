@@ -0,0 +1,121 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2021, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Tests for gmx hbond.
+ */
+
+#include "gmxpre.h"
+
+#include "gromacs/gmxana/gmx_ana.h"
+
+#include "testutils/cmdlinetest.h"
+#include "testutils/refdata.h"
+#include "testutils/stdiohelper.h"
+#include "testutils/testfilemanager.h"
+#include "testutils/textblockmatchers.h"
+#include "testutils/xvgtest.h"
+
+namespace
+{
+
+using gmx::test::CommandLine;
+using gmx::test::StdioTestHelper;
+using gmx::test::XvgMatch;
+
+/* hbond.tpr and hbond.xtc contain 348 SPC waters, with 11 frames
+ * spaced 20 fs apart. Both groups are chosen as the whole system.
+ */
+class HbondTest : public gmx::test::CommandLineTestBase
+{
+public:
+    HbondTest()
+    {
+        setInputFile("-f", "hbond.xtc");
+        setInputFile("-s", "hbond.tpr");
+    }
+
+    void runTest(const CommandLine& args)
+    {
+        StdioTestHelper stdioHelper(&fileManager());
+        stdioHelper.redirectStringToStdin("0\n0\n");
+
+        CommandLine& cmdline = commandLine();
+        cmdline.merge(args);
+        ASSERT_EQ(0, gmx_hbond(cmdline.argc(), cmdline.argv()));
+        checkOutputFiles();
+    }
+
+    //! Matcher for outputs that are computed through averaging or FFTs.
+    XvgMatch relaxedXvgMatch()
+    {
+        XvgMatch xvg;
+        xvg.tolerance(gmx::test::relativeToleranceAsFloatingPoint(1, 1e-4));
+        return xvg;
+    }
+};
+
+TEST_F(HbondTest, CountsHydrogenBonds)
+{
+    const char* const command[] = { "hbond" };
+    setOutputFile("-num", "hbnum.xvg", XvgMatch());
+    setOutputFile("-hbn", "hbond.ndx", gmx::test::ExactTextMatch());
+    runTest(CommandLine(command));
+}
+
+TEST_F(HbondTest, ComputesLifetimesAndAutocorrelation)
+{
+    const char* const command[] = { "hbond" };
+    setOutputFile("-life", "hblife.xvg", relaxedXvgMatch());
+    setOutputFile("-ac", "hbac.xvg", relaxedXvgMatch());
+    runTest(CommandLine(command));
+}
+
+TEST_F(HbondTest, CountsContacts)
+{
+    const char* const command[] = { "hbond", "-contact", "-r", "0.35", "-r2", "0.5" };
+    setOutputFile("-num", "hbnum.xvg", XvgMatch());
+    runTest(CommandLine(command));
+}
+
+TEST_F(HbondTest, SearchesFromHydrogensWithoutDonorAcceptorDistance)
+{
+    const char* const command[] = { "hbond", "-noda" };
+    setOutputFile("-num", "hbnum.xvg", XvgMatch());
+    setOutputFile("-ang", "hbang.xvg", relaxedXvgMatch());
+    runTest(CommandLine(command));
+}
+
+} // namespace
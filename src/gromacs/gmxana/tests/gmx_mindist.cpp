@@ -192,6 +192,47 @@ TEST_F(MindistTest, matrixWorks)
     runTest(CommandLine(cmdline), stdIn);
 }
 
-// TODO test periodic image - needs a tpr?
+class MindistSolventTest : public gmx::test::CommandLineTestBase
+{
+public:
+    MindistSolventTest()
+    {
+        setInputFile("-f", "hbond.xtc");
+        setInputFile("-s", "hbond.tpr");
+    }
+
+    void runTest(const CommandLine& args, const char* stringForStdin)
+    {
+        StdioTestHelper stdioHelper(&fileManager());
+        stdioHelper.redirectStringToStdin(stringForStdin);
+
+        CommandLine& cmdline = commandLine();
+        cmdline.merge(args);
+        ASSERT_EQ(0, gmx_mindist(cmdline.argc(), cmdline.argv()));
+        checkOutputFiles();
+    }
+};
+
+/* hbond.tpr is a box of 348 water molecules, enough atom pairs for the
+ * distances to be computed with a grid search
+ */
+
+TEST_F(MindistSolventTest, periodicImageWorks)
+{
+    setOutputFile("-od", "mindist.xvg", XvgMatch());
+    const char* const cmdline[] = { "mindist", "-pi" };
+    const char* const stdIn     = "0";
+    runTest(CommandLine(cmdline), stdIn);
+}
+
+TEST_F(MindistSolventTest, gridSearchWorksWithContactsAndResidues)
+{
+    setOutputFile("-od", "mindist.xvg", XvgMatch());
+    setOutputFile("-on", "ncontacts.xvg", XvgMatch());
+    setOutputFile("-or", "mindistres.xvg", XvgMatch());
+    const char* const cmdline[] = { "mindist", "-group", "-d", "0.3" };
+    const char* const stdIn     = "0 1";
+    runTest(CommandLine(cmdline), stdIn);
+}
 
 } // namespace
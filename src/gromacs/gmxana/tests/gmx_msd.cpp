@@ -167,25 +167,45 @@ TEST_F(MsdTest, oneDimensionalDiffusion)
     runTest(CommandLine(cmdline));
 }
 
+// with -fft all frames are used as time origins
+TEST_F(MsdTest, threeDimensionalDiffusionWithFFT)
+{
+    const char* const cmdline[] = { "msd", "-mw", "no", "-fft" };
+    runTest(CommandLine(cmdline));
+}
+
+TEST_F(MsdTest, tensorWithFFT)
+{
+    const char* const cmdline[] = { "msd", "-mw", "no", "-fft", "-ten", "-nthreads", "2" };
+    runTest(CommandLine(cmdline));
+}
+
 // Test the diffusion per molecule output, mass weighted
 TEST_F(MsdMolTest, diffMolMassWeighted)
 {
-    const char* const cmdline[] = { "msd", "-trestart", "200" };
+    const char* const cmdline[] = { "msd", "-trestart", "200", "-type", "x" };
     runTest(CommandLine(cmdline), "spc5.ndx", "spc5");
 }
 
 // Test the diffusion per molecule output, non-mass weighted
 TEST_F(MsdMolTest, diffMolNonMassWeighted)
 {
-    const char* const cmdline[] = { "msd", "-trestart", "200", "-mw", "no" };
+    const char* const cmdline[] = { "msd", "-trestart", "200", "-mw", "no", "-type", "x" };
     runTest(CommandLine(cmdline), "spc5.ndx", "spc5");
 }
 
 // Test the diffusion per molecule output, with selection
 TEST_F(MsdMolTest, diffMolSelected)
 {
-    const char* const cmdline[] = { "msd", "-trestart", "200" };
+    const char* const cmdline[] = { "msd", "-trestart", "200", "-type", "x" };
     runTest(CommandLine(cmdline), "spc5_3.ndx", "spc5");
 }
 
+// Test the diffusion per molecule output, with all frames as time origins
+TEST_F(MsdMolTest, diffMolWithFFT)
+{
+    const char* const cmdline[] = { "msd", "-fft" };
+    runTest(CommandLine(cmdline), "spc5.ndx", "spc5");
+}
+
 } // namespace
@@ -0,0 +1,294 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2021, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Tests for gmx wham.
+ *
+ * The bootstraps and the reading of the pull files are distributed over
+ * threads. These tests check that the results do not depend on the number
+ * of threads and that the windows are kept in input order.
+ */
+
+#include "gmxpre.h"
+
+#include <cmath>
+#include <cstdlib>
+
+#include <string>
+#include <vector>
+
+#include "gromacs/gmxana/gmx_ana.h"
+#include "gromacs/gmxpreprocess/grompp.h"
+#include "gromacs/random/tabulatednormaldistribution.h"
+#include "gromacs/random/threefry.h"
+#include "gromacs/utility/path.h"
+#include "gromacs/utility/stringutil.h"
+#include "gromacs/utility/textreader.h"
+#include "gromacs/utility/textwriter.h"
+
+#include "testutils/cmdlinetest.h"
+#include "testutils/testfilemanager.h"
+
+namespace gmx
+{
+namespace test
+{
+namespace
+{
+
+//! The number of umbrella windows
+constexpr int c_numWindows = 5;
+//! The number of frames in each pullx file
+constexpr int c_numFrames = 400;
+//! The spacing of the umbrella window centers in nm
+constexpr double c_windowSpacing = 0.1;
+//! The umbrella force constant in kJ/mol/nm^2
+constexpr double c_forceConstant = 1000;
+
+//! Returns the center of umbrella window \p window
+double windowCenter(int window)
+{
+    return 0.5 + c_windowSpacing * window;
+}
+
+//! Returns the data lines of an xvg file, without the header which contains the command line
+std::vector<std::string> readXvgDataLines(const std::string& fileName)
+{
+    std::vector<std::string> lines;
+    TextReader               reader(fileName);
+    std::string              line;
+    while (reader.readLine(&line))
+    {
+        if (!line.empty() && line[0] != '#' && line[0] != '@')
+        {
+            lines.push_back(line);
+        }
+    }
+    return lines;
+}
+
+//! The output files of one gmx wham run
+struct WhamOutput
+{
+    //! The profile
+    std::string profile;
+    //! The histograms
+    std::string histograms;
+    //! The average and error of the bootstrapped profiles
+    std::string bootstrapResult;
+    //! The bootstrapped profiles
+    std::string bootstrapProfiles;
+};
+
+/*! \brief Sets up umbrella windows for two SPC waters and runs gmx wham
+ *
+ * The tpr files are generated with grompp, the pullx files contain
+ * Gaussian distributed distances around the window centers.
+ */
+class WhamTest : public ::testing::TestWithParam<const char*>
+{
+public:
+    void SetUp() override
+    {
+        tprListFile_   = fileManager_.getTemporaryFilePath("tpr-files.dat");
+        pullxListFile_ = fileManager_.getTemporaryFilePath("pullx-files.dat");
+
+        TextWriter tprList(tprListFile_);
+        TextWriter pullxList(pullxListFile_);
+        for (int w = 0; w < c_numWindows; w++)
+        {
+            const std::string tpr   = windowFilePath(w, ".tpr");
+            const std::string pullx = windowFilePath(w, "_pullx.xvg");
+            ASSERT_NO_FATAL_FAILURE(makeTpr(w, tpr));
+            writePullx(w, pullx);
+            tprList.writeLine(tpr);
+            pullxList.writeLine(pullx);
+        }
+        tprList.close();
+        pullxList.close();
+    }
+
+    //! Returns the path of a temporary file for \p window ending in \p suffix
+    std::string windowFilePath(int window, const char* suffix)
+    {
+        return fileManager_.getTemporaryFilePath(formatString("window%d%s", window, suffix));
+    }
+
+    //! Runs grompp to make the tpr file \p tpr for window \p window
+    void makeTpr(int window, const std::string& tpr)
+    {
+        const std::string mdp = windowFilePath(window, ".mdp");
+        TextWriter        writer(mdp);
+        writer.writeLine("cutoff-scheme        = Verlet");
+        writer.writeLine("rcoulomb             = 0.85");
+        writer.writeLine("rvdw                 = 0.85");
+        writer.writeLine("pull                 = yes");
+        writer.writeLine("pull-ngroups         = 2");
+        writer.writeLine("pull-ncoords         = 1");
+        writer.writeLine("pull-group1-name     = FirstWaterMolecule");
+        writer.writeLine("pull-group2-name     = SecondWaterMolecule");
+        writer.writeLine("pull-coord1-type     = umbrella");
+        writer.writeLine("pull-coord1-geometry = distance");
+        writer.writeLine("pull-coord1-groups   = 1 2");
+        writer.writeLine(formatString("pull-coord1-init     = %g", windowCenter(window)));
+        writer.writeLine(formatString("pull-coord1-k        = %g", c_forceConstant));
+        writer.close();
+
+        const std::string simDB = TestFileManager::getTestSimulationDatabaseDirectory();
+        const std::string base  = Path::join(simDB, "spc2");
+
+        CommandLine caller;
+        caller.append("grompp");
+        caller.addOption("-maxwarn", 0);
+        caller.addOption("-f", mdp);
+        caller.addOption("-c", base + ".gro");
+        caller.addOption("-p", base + ".top");
+        caller.addOption("-n", base + ".ndx");
+        caller.addOption("-po", windowFilePath(window, "_out.mdp"));
+        caller.addOption("-o", tpr);
+        ASSERT_EQ(0, gmx_grompp(caller.argc(), caller.argv()));
+    }
+
+    //! Writes the pullx file \p pullx for window \p window
+    static void writePullx(int window, const std::string& pullx)
+    {
+        // The width of the distribution in a harmonic potential at 298 K
+        const double sigma = std::sqrt(2.4777 / c_forceConstant);
+
+        ThreeFry2x64<64>                      rng(1993, RandomDomain::Other);
+        TabulatedNormalDistribution<real, 14> dist;
+        rng.restart(window, 0);
+
+        TextWriter writer(pullx);
+        writer.writeLine("@    title \"Pull COM\"");
+        for (int frame = 0; frame < c_numFrames; frame++)
+        {
+            const double distance = windowCenter(window) + sigma * dist(rng);
+            writer.writeLine(formatString("%g\t%g", 0.1 * frame, distance));
+        }
+        writer.close();
+    }
+
+    /*! \brief Runs gmx wham with \p numThreads threads
+     *
+     * The output file names get the prefix \p prefix.
+     */
+    WhamOutput runWham(int numThreads, const std::string& prefix)
+    {
+        WhamOutput output;
+        output.profile           = fileManager_.getTemporaryFilePath(prefix + "profile.xvg");
+        output.histograms        = fileManager_.getTemporaryFilePath(prefix + "histo.xvg");
+        output.bootstrapResult   = fileManager_.getTemporaryFilePath(prefix + "bsResult.xvg");
+        output.bootstrapProfiles = fileManager_.getTemporaryFilePath(prefix + "bsProfs.xvg");
+
+        CommandLine cmdline;
+        cmdline.append("wham");
+        cmdline.addOption("-it", tprListFile_);
+        cmdline.addOption("-ix", pullxListFile_);
+        cmdline.addOption("-o", output.profile);
+        cmdline.addOption("-hist", output.histograms);
+        cmdline.addOption("-bsres", output.bootstrapResult);
+        cmdline.addOption("-bsprof", output.bootstrapProfiles);
+        cmdline.addOption("-b", 0);
+        cmdline.addOption("-nBootstrap", 5);
+        cmdline.addOption("-bs-method", GetParam());
+        cmdline.addOption("-bs-seed", 1234);
+        // The trajectory bootstrap methods need the autocorrelation times
+        cmdline.append("-ac");
+        cmdline.addOption("-oiact", fileManager_.getTemporaryFilePath(prefix + "iact.xvg"));
+        cmdline.addOption("-nthreads", numThreads);
+        EXPECT_EQ(0, gmx_wham(cmdline.argc(), cmdline.argv()));
+
+        return output;
+    }
+
+private:
+    //! Manages the temporary files
+    TestFileManager fileManager_;
+    //! The file listing the tpr files
+    std::string tprListFile_;
+    //! The file listing the pullx files
+    std::string pullxListFile_;
+};
+
+TEST_P(WhamTest, BootstrapIsIndependentOfThreadCount)
+{
+    const WhamOutput oneThread    = runWham(1, "serial_");
+    const WhamOutput threeThreads = runWham(3, "threaded_");
+
+    EXPECT_EQ(readXvgDataLines(oneThread.profile), readXvgDataLines(threeThreads.profile));
+    EXPECT_EQ(readXvgDataLines(oneThread.histograms), readXvgDataLines(threeThreads.histograms));
+    EXPECT_EQ(readXvgDataLines(oneThread.bootstrapResult),
+              readXvgDataLines(threeThreads.bootstrapResult));
+    EXPECT_EQ(readXvgDataLines(oneThread.bootstrapProfiles),
+              readXvgDataLines(threeThreads.bootstrapProfiles));
+}
+
+TEST_P(WhamTest, WindowsAreReadInInputOrder)
+{
+    const WhamOutput output = runWham(3, "threaded_");
+
+    // Each histogram column should peak at the center of the window in that position of the input
+    const std::vector<std::string> lines = readXvgDataLines(output.histograms);
+    std::vector<double>            peakPosition(c_numWindows, 0);
+    std::vector<double>            peakCount(c_numWindows, -1);
+    for (const std::string& line : lines)
+    {
+        const std::vector<std::string> columns = splitString(line);
+        ASSERT_EQ(1 + c_numWindows, columns.size());
+        const double position = std::strtod(columns[0].c_str(), nullptr);
+        for (int w = 0; w < c_numWindows; w++)
+        {
+            const double count = std::strtod(columns[1 + w].c_str(), nullptr);
+            if (count > peakCount[w])
+            {
+                peakCount[w]    = count;
+                peakPosition[w] = position;
+            }
+        }
+    }
+    for (int w = 0; w < c_numWindows; w++)
+    {
+        EXPECT_NEAR(windowCenter(w), peakPosition[w], 0.5 * c_windowSpacing) << "for window " << w;
+    }
+}
+
+INSTANTIATE_TEST_CASE_P(WithBootstrapMethod,
+                        WhamTest,
+                        ::testing::Values("b-hist", "hist", "traj", "traj-gauss"));
+
+} // namespace
+} // namespace test
+} // namespace gmx
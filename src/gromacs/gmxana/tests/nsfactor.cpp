@@ -0,0 +1,153 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2021, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Tests for the pair distance histograms used by gmx sans.
+ */
+#include "gmxpre.h"
+
+#include "gromacs/gmxana/nsfactor.h"
+
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "gromacs/math/vec.h"
+#include "gromacs/math/vectypes.h"
+#include "gromacs/random/threefry.h"
+#include "gromacs/random/uniformrealdistribution.h"
+#include "gromacs/utility/smalloc.h"
+
+#include "testutils/testasserts.h"
+
+namespace
+{
+
+using gmx::test::relativeToleranceAsFloatingPoint;
+
+//! Random atoms of three types in a cubic box
+class RadialDistributionHistogramTest : public ::testing::Test
+{
+public:
+    RadialDistributionHistogramTest() : natoms_(1500), x_(natoms_), index_(natoms_)
+    {
+        gmx::DefaultRandomEngine           rng(4321, gmx::RandomDomain::Other);
+        gmx::UniformRealDistribution<real> dist(0, 4);
+        const double                       slength[3] = { -3.74, 5.8, 6.6 };
+        slength_.resize(natoms_);
+        for (int i = 0; i < natoms_; i++)
+        {
+            x_[i]       = { dist(rng), dist(rng), dist(rng) };
+            index_[i]   = i;
+            slength_[i] = slength[i % 3];
+        }
+        gsans_.top     = nullptr;
+        gsans_.slength = slength_.data();
+        clear_mat(box_);
+        box_[XX][XX] = box_[YY][YY] = box_[ZZ][ZZ] = 4;
+    }
+
+    //! Returns the histogram computed over all pairs
+    gmx_radial_distribution_histogram_t* direct()
+    {
+        return calc_radial_distribution_histogram(&gsans_, as_rvec_array(x_.data()), box_,
+                                                  index_.data(), natoms_, 0.2, FALSE, FALSE, -1, 0);
+    }
+
+    //! Returns the histogram computed with cell lists
+    gmx_radial_distribution_histogram_t* grid(int nlevels, real rnear)
+    {
+        return calc_radial_distribution_histogram_grid(&gsans_, as_rvec_array(x_.data()), box_,
+                                                       index_.data(), natoms_, 0.2, FALSE, 0.5,
+                                                       nlevels, rnear);
+    }
+
+    //! Frees a histogram
+    static void done(gmx_radial_distribution_histogram_t* pr)
+    {
+        sfree(pr->gr);
+        sfree(pr->r);
+        sfree(pr);
+    }
+
+    int                    natoms_;
+    std::vector<gmx::RVec> x_;
+    std::vector<int>       index_;
+    std::vector<double>    slength_;
+    gmx_sans_t             gsans_;
+    matrix                 box_;
+};
+
+TEST_F(RadialDistributionHistogramTest, GridMatchesDirectWithoutFarField)
+{
+    gmx_radial_distribution_histogram_t* ref = direct();
+    for (int nlevels : { 0, 2 })
+    {
+        gmx_radial_distribution_histogram_t* pr = grid(nlevels, 100);
+        ASSERT_EQ(ref->grn, pr->grn);
+        for (int i = 0; i < ref->grn; i++)
+        {
+            /* Allow for a few pairs at a bin edge to end up in the other bin */
+            EXPECT_NEAR(ref->gr[i], pr->gr[i], 200) << "bin " << i << " levels " << nlevels;
+            EXPECT_EQ(ref->r[i], pr->r[i]);
+        }
+        done(pr);
+    }
+    done(ref);
+}
+
+TEST_F(RadialDistributionHistogramTest, FarFieldConservesWeightAndMean)
+{
+    gmx_radial_distribution_histogram_t* ref = direct();
+    for (int nlevels : { 0, 1 })
+    {
+        gmx_radial_distribution_histogram_t* pr = grid(nlevels, 1.0);
+        ASSERT_EQ(ref->grn, pr->grn);
+        double sumRef = 0, sum = 0, meanRef = 0, mean = 0;
+        for (int i = 0; i < ref->grn; i++)
+        {
+            sumRef += ref->gr[i];
+            sum += pr->gr[i];
+            meanRef += ref->r[i] * ref->gr[i];
+            mean += pr->r[i] * pr->gr[i];
+        }
+        EXPECT_DOUBLE_EQ_TOL(sumRef, sum, relativeToleranceAsFloatingPoint(sumRef, 1e-9));
+        EXPECT_DOUBLE_EQ_TOL(meanRef, mean, relativeToleranceAsFloatingPoint(meanRef, 1e-3));
+        done(pr);
+    }
+    done(ref);
+}
+
+} // namespace
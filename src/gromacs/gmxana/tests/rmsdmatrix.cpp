@@ -0,0 +1,244 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2021, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Tests for the RMSD matrix computation used by gmx cluster.
+ */
+#include "gmxpre.h"
+
+#include "gromacs/gmxana/rmsdmatrix.h"
+
+#include <cmath>
+
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "gromacs/gmxana/cmat.h"
+#include "gromacs/math/do_fit.h"
+#include "gromacs/math/vec.h"
+#include "gromacs/random/threefry.h"
+#include "gromacs/random/uniformrealdistribution.h"
+#include "gromacs/utility/futil.h"
+
+#include "testutils/testasserts.h"
+#include "testutils/testfilemanager.h"
+
+namespace
+{
+
+using gmx::test::relativeToleranceAsFloatingPoint;
+
+//! Generates frames that are randomly rotated and perturbed copies of a reference
+class RmsdMatrixTest : public ::testing::Test
+{
+public:
+    RmsdMatrixTest() : rng_(1234, gmx::RandomDomain::Other), dist_(-1, 1) {}
+
+    //! Fills masses, with zero mass for every fifth atom
+    void makeMasses(int natoms)
+    {
+        gmx::UniformRealDistribution<real> massDist(1, 16);
+        mass_.resize(natoms);
+        for (int i = 0; i < natoms; i++)
+        {
+            mass_[i] = (i % 5 == 4) ? 0 : massDist(rng_);
+        }
+    }
+
+    //! Makes \p nframes centered frames of \p natoms atoms
+    void makeFrames(int nframes, int natoms)
+    {
+        std::vector<gmx::RVec> reference(natoms);
+        for (auto& x : reference)
+        {
+            x = { dist_(rng_), dist_(rng_), dist_(rng_) };
+        }
+        frames_.resize(nframes);
+        framePointers_.resize(nframes);
+        for (int f = 0; f < nframes; f++)
+        {
+            matrix rotation;
+            makeRotation(rotation);
+            frames_[f].resize(natoms);
+            for (int i = 0; i < natoms; i++)
+            {
+                rvec perturbed = { reference[i][XX] + 0.1F * dist_(rng_),
+                                   reference[i][YY] + 0.1F * dist_(rng_),
+                                   reference[i][ZZ] + 0.1F * dist_(rng_) };
+                mvmul(rotation, perturbed, frames_[f][i]);
+            }
+            framePointers_[f] = as_rvec_array(frames_[f].data());
+            reset_x(natoms, nullptr, natoms, nullptr, framePointers_[f], mass_.data());
+        }
+    }
+
+    //! Returns the RMSD between two frames using do_fit() and rmsdev()
+    real referenceRmsd(int f1, int f2, gmx_bool bFit)
+    {
+        const int              natoms = frames_[f1].size();
+        std::vector<gmx::RVec> fitted(frames_[f1]);
+        if (bFit)
+        {
+            do_fit(natoms, mass_.data(), framePointers_[f2], as_rvec_array(fitted.data()));
+        }
+        return rmsdev(natoms, mass_.data(), framePointers_[f2], as_rvec_array(fitted.data()));
+    }
+
+    //! Checks all elements and statistics of a matrix computed with calc_rmsd_matrix()
+    void checkMatrix(int nframes, int natoms, gmx_bool bFit)
+    {
+        makeMasses(natoms);
+        makeFrames(nframes, natoms);
+        t_mat* m = init_mat(nframes, FALSE);
+        calc_rmsd_matrix(m, nframes, natoms, framePointers_.data(), mass_.data(), bFit, 2);
+
+        real   minrms = 1e20, maxrms = 0;
+        double sumrms = 0;
+        for (int i = 0; i < nframes; i++)
+        {
+            EXPECT_EQ(0, m->mat[i][i]);
+            for (int j = i + 1; j < nframes; j++)
+            {
+                const real ref = referenceRmsd(i, j, bFit);
+                EXPECT_REAL_EQ_TOL(ref, m->mat[i][j], relativeToleranceAsFloatingPoint(ref, 1e-4))
+                        << "frames " << i << " and " << j;
+                EXPECT_EQ(m->mat[i][j], m->mat[j][i]);
+                minrms = std::min(minrms, m->mat[i][j]);
+                maxrms = std::max(maxrms, m->mat[i][j]);
+                sumrms += m->mat[i][j];
+            }
+        }
+        EXPECT_EQ(nframes, m->nn);
+        EXPECT_EQ(minrms, m->minrms);
+        EXPECT_EQ(maxrms, m->maxrms);
+        EXPECT_REAL_EQ_TOL(sumrms, m->sumrms, relativeToleranceAsFloatingPoint(sumrms, 1e-6));
+        done_mat(&m);
+    }
+
+    //! Makes a random rotation matrix
+    void makeRotation(matrix rotation)
+    {
+        const real a = M_PI * dist_(rng_);
+        const real b = M_PI * dist_(rng_);
+        const real c = M_PI * dist_(rng_);
+        matrix     rx = { { 1, 0, 0 },
+                          { 0, std::cos(a), -std::sin(a) },
+                          { 0, std::sin(a), std::cos(a) } };
+        matrix     ry = { { std::cos(b), 0, std::sin(b) },
+                          { 0, 1, 0 },
+                          { -std::sin(b), 0, std::cos(b) } };
+        matrix     rz = { { std::cos(c), -std::sin(c), 0 },
+                          { std::sin(c), std::cos(c), 0 },
+                          { 0, 0, 1 } };
+        matrix     rxy;
+        mmul(rx, ry, rxy);
+        mmul(rxy, rz, rotation);
+    }
+
+    gmx::DefaultRandomEngine                    rng_;
+    gmx::UniformRealDistribution<real>          dist_;
+    std::vector<real>                           mass_;
+    std::vector<std::vector<gmx::RVec>>         frames_;
+    std::vector<rvec*>                          framePointers_;
+};
+
+TEST_F(RmsdMatrixTest, QcpMatchesFit)
+{
+    const int natoms = 40;
+    makeMasses(natoms);
+    makeFrames(2, natoms);
+    const real ref = referenceRmsd(0, 1, TRUE);
+    EXPECT_REAL_EQ_TOL(ref, rmsd_qcp(natoms, mass_.data(), framePointers_[0], framePointers_[1]),
+                       relativeToleranceAsFloatingPoint(ref, 1e-4));
+}
+
+TEST_F(RmsdMatrixTest, QcpGivesZeroForRotatedCopy)
+{
+    const int natoms = 30;
+    makeMasses(natoms);
+    makeFrames(1, natoms);
+    matrix rotation;
+    makeRotation(rotation);
+    std::vector<gmx::RVec> rotated(natoms);
+    for (int i = 0; i < natoms; i++)
+    {
+        mvmul(rotation, frames_[0][i], rotated[i]);
+    }
+    const real rmsd =
+            rmsd_qcp(natoms, mass_.data(), framePointers_[0], as_rvec_array(rotated.data()));
+    EXPECT_REAL_EQ_TOL(0, rmsd, gmx::test::absoluteTolerance(1e-3));
+}
+
+TEST_F(RmsdMatrixTest, MatrixMatchesPairwiseFit)
+{
+    /* More frames than fit in one tile */
+    checkMatrix(70, 23, TRUE);
+}
+
+TEST_F(RmsdMatrixTest, MatrixMatchesPairwiseRmsdWithoutFit)
+{
+    checkMatrix(40, 17, FALSE);
+}
+
+TEST(MappedMatrixTest, StoresElementsAndRemovesFile)
+{
+    gmx::test::TestFileManager fileManager;
+    const std::string          fileName = fileManager.getTemporaryFilePath("matrix.dat");
+    t_mat*                     m        = init_mat_mapped(5, TRUE, fileName.c_str());
+    EXPECT_FALSE(gmx_fexist(fileName));
+    for (int i = 0; i < 5; i++)
+    {
+        for (int j = 0; j < 5; j++)
+        {
+            EXPECT_EQ(0, m->mat[i][j]);
+        }
+    }
+    set_mat_entry(m, 1, 3, 0.5);
+    set_mat_entry(m, 0, 4, 0.25);
+    EXPECT_EQ(0.5, m->mat[3][1]);
+    EXPECT_EQ(0.25, m->mat[4][0]);
+    EXPECT_EQ(0.25, m->minrms);
+    EXPECT_EQ(0.5, m->maxrms);
+    /* The rows are contiguous */
+    EXPECT_EQ(0.5, m->mat[0][1 * 5 + 3]);
+    swap_rows(m, 0, 1);
+    EXPECT_EQ(0.5, m->mat[0][3]);
+    EXPECT_EQ(1, m->m_ind[0]);
+    done_mat(&m);
+    EXPECT_EQ(nullptr, m);
+}
+
+} // namespace
@@ -56,6 +56,7 @@
 #include "gromacs/mdtypes/md_enums.h"
 #include "gromacs/mdtypes/mdatom.h"
 #include "gromacs/simd/simd.h"
+#include "gromacs/simd/simd_math.h"
 #include "gromacs/utility/fatalerror.h"
 
 
@@ -307,6 +308,7 @@ static void nb_free_energy_kernel(const t_nblist* gmx_restrict nlist,
     real        coulombTableScaleInvHalf = 0;
     real        vdwTableScale            = 0;
     real        vdwTableScaleInvHalf     = 0;
+    real        ewaldExclusionRange      = 0;
     real        sh_ewald                 = 0;
     if (elecInteractionTypeIsEwald || vdwInteractionTypeIsEwald)
     {
@@ -318,6 +320,7 @@ static void nb_free_energy_kernel(const t_nblist* gmx_restrict nlist,
         ewtab                     = coulombTables.tableFDV0.data();
         coulombTableScale         = coulombTables.scale;
         coulombTableScaleInvHalf  = half / coulombTableScale;
+        ewaldExclusionRange       = (coulombTables.tableF.size() - 1) / coulombTableScale;
     }
     if (vdwInteractionTypeIsEwald)
     {
@@ -402,6 +405,12 @@ static void nb_free_energy_kernel(const t_nblist* gmx_restrict nlist,
 
         for (int k = nj0; k < nj1; k++)
         {
+            if (jjnr[k] < 0)
+            {
+                /* Skip the entries padding the list to the SIMD width */
+                continue;
+            }
+
             int            tj[NSTATES];
             const int      jnr = jjnr[k];
             const int      j3  = 3 * jnr;
@@ -680,7 +689,13 @@ static void nb_free_energy_kernel(const t_nblist* gmx_restrict nlist,
                 }
             }
 
-            if (elecInteractionTypeIsEwald && (r < rcoulomb || !bPairIncluded))
+            /* The Ewald table is extended beyond the cut-off for excluded pairs
+             * within molecules, e.g. with couple-intramol=no. Excluded pairs
+             * beyond the table, such as the periodic images of excluded pairs
+             * that the pair list can contain, do not get a correction.
+             */
+            if (elecInteractionTypeIsEwald
+                && (r < rcoulomb || (!bPairIncluded && r < ewaldExclusionRange)))
             {
                 /* See comment in the preamble. When using Ewald interactions
                  * (unless we use a switch modifier) we subtract the reciprocal-space
@@ -841,6 +856,699 @@ static void nb_free_energy_kernel(const t_nblist* gmx_restrict nlist,
     inc_nrnb(nrnb, eNR_NBKERNEL_FREE_ENERGY, nlist->nri * 12 + nlist->jindex[nri] * 150);
 }
 
+#if GMX_SIMD_HAVE_REAL && GMX_SIMD_HAVE_INT32_ARITHMETICS
+//! Computes r^(1/p) and 1/r^(1/p) for the standard p=6 for the SIMD elements in \p mask
+static inline void pthRoot(const gmx::SimdReal r,
+                           gmx::SimdReal*      pthRoot,
+                           gmx::SimdReal*      invPthRoot,
+                           const gmx::SimdBool mask)
+{
+    *invPthRoot = gmx::maskzInvsqrt(gmx::cbrt(r), mask);
+    *pthRoot    = gmx::maskzInv(*invPthRoot, mask);
+}
+
+/*! \brief Templated SIMD free-energy non-bonded kernel
+ *
+ * Computes the same interactions as nb_free_energy_kernel, but processes
+ * the j-list of each i-entry in chunks of the SIMD width. This requires
+ * the j-lists to be padded to a multiple of the SIMD width with -1 entries.
+ * The per-pair parameters are gathered with scalar loads, all arithmetic
+ * is done in SIMD and the branches of the scalar kernel are replaced by masks.
+ */
+template<bool useSoftCore, bool scLambdasOrAlphasDiffer, bool vdwInteractionTypeIsEwald, bool elecInteractionTypeIsEwald, bool vdwModifierIsPotSwitch>
+static void nb_free_energy_kernel_simd(const t_nblist* gmx_restrict nlist,
+                                       rvec* gmx_restrict         xx,
+                                       gmx::ForceWithShiftForces* forceWithShiftForces,
+                                       const t_forcerec* gmx_restrict fr,
+                                       const t_mdatoms* gmx_restrict mdatoms,
+                                       nb_kernel_data_t* gmx_restrict kernel_data,
+                                       t_nrnb* gmx_restrict nrnb)
+{
+    using RealType = SimdDataTypes::RealType;
+    using IntType  = SimdDataTypes::IntType;
+    using BoolType = gmx::SimdBool;
+
+    constexpr int simdWidth = SimdDataTypes::simdRealWidth;
+
+    constexpr real onetwelfth = 1.0 / 12.0;
+    constexpr real onesixth   = 1.0 / 6.0;
+    constexpr real half       = 0.5;
+    constexpr real one        = 1.0;
+    constexpr real two        = 2.0;
+    constexpr real six        = 6.0;
+
+    const RealType zero_S(0.0);
+    const RealType one_S(1.0);
+
+    GMX_ASSERT(nlist->simd_padding_width % simdWidth == 0,
+               "The free-energy pair list should be padded to the SIMD width");
+
+    /* Extract pointer to non-bonded interaction constants */
+    const interaction_const_t* ic = fr->ic;
+
+    // Extract pair list data
+    const int   nri      = nlist->nri;
+    const int*  iinr     = nlist->iinr;
+    const int*  jindex   = nlist->jindex;
+    const int*  jjnr     = nlist->jjnr;
+    const int*  shift    = nlist->shift;
+    const int*  gid      = nlist->gid;
+    const char* excl_fep = nlist->excl_fep;
+
+    const real* shiftvec      = fr->shift_vec[0];
+    const real* chargeA       = mdatoms->chargeA;
+    const real* chargeB       = mdatoms->chargeB;
+    real*       Vc            = kernel_data->energygrp_elec;
+    const int*  typeA         = mdatoms->typeA;
+    const int*  typeB         = mdatoms->typeB;
+    const int   ntype         = fr->ntype;
+    const real* nbfp          = fr->nbfp.data();
+    const real* nbfp_grid     = fr->ljpme_c6grid;
+    real*       Vv            = kernel_data->energygrp_vdw;
+    const real  lambda_coul   = kernel_data->lambda[efptCOUL];
+    const real  lambda_vdw    = kernel_data->lambda[efptVDW];
+    real*       dvdl          = kernel_data->dvdl;
+    const auto& scParams      = *ic->softCoreParameters;
+    const real  lam_power     = scParams.lambdaPower;
+    const bool  doForces      = ((kernel_data->flags & GMX_NONBONDED_DO_FORCE) != 0);
+    const bool  doShiftForces = ((kernel_data->flags & GMX_NONBONDED_DO_SHIFTFORCE) != 0);
+    const bool  doPotential   = ((kernel_data->flags & GMX_NONBONDED_DO_POTENTIAL) != 0);
+
+    const RealType alpha_coul_S(scParams.alphaCoulomb);
+    const RealType alpha_vdw_S(scParams.alphaVdw);
+    const RealType sigma6_def_S(scParams.sigma6WithInvalidSigma);
+    const RealType sigma6_min_S(scParams.sigma6Minimum);
+
+    // Extract data from interaction_const_t
+    const real     facel = ic->epsfac;
+    const RealType rcoulomb_S(ic->rcoulomb);
+    const real     krf = ic->k_rf;
+    const real     crf = ic->c_rf;
+    const RealType rvdw_S(ic->rvdw);
+    const RealType rvdw_switch_S(ic->rvdw_switch);
+    const real     sh_lj_ewald     = ic->sh_lj_ewald;
+    const real     dispersionShift = ic->dispersion_shift.cpot;
+    const real     repulsionShift  = ic->repulsion_shift.cpot;
+
+    // Note that the nbnxm kernels do not support Coulomb potential switching at all
+    GMX_ASSERT(ic->coulomb_modifier != eintmodPOTSWITCH,
+               "Potential switching is not supported for Coulomb with FEP");
+    GMX_RELEASE_ASSERT(!(vdwInteractionTypeIsEwald && vdwModifierIsPotSwitch),
+                       "Can not apply soft-core to switched Ewald potentials");
+
+    real vdw_swV3, vdw_swV4, vdw_swV5, vdw_swF2, vdw_swF3, vdw_swF4;
+    if (vdwModifierIsPotSwitch)
+    {
+        const real d = ic->rvdw - ic->rvdw_switch;
+        vdw_swV3     = -10.0 / (d * d * d);
+        vdw_swV4     = 15.0 / (d * d * d * d);
+        vdw_swV5     = -6.0 / (d * d * d * d * d);
+        vdw_swF2     = -30.0 / (d * d * d);
+        vdw_swF3     = 60.0 / (d * d * d * d);
+        vdw_swF4     = -30.0 / (d * d * d * d * d);
+    }
+    else
+    {
+        vdw_swV3 = vdw_swV4 = vdw_swV5 = vdw_swF2 = vdw_swF3 = vdw_swF4 = 0.0;
+    }
+
+    real rcutoff_max2 = std::max(ic->rcoulomb, ic->rvdw);
+    rcutoff_max2      = rcutoff_max2 * rcutoff_max2;
+    const RealType rcutoff_max2_S(rcutoff_max2);
+
+    /* With SIMD we compute the Ewald correction within the cut-off analytically,
+     * as the nbnxm SIMD kernels do. The analytical approximations are only
+     * accurate up to beta*r = 4, so for excluded pairs beyond the cut-off
+     * we use the table, as the scalar kernel does. For LJ-PME we keep using
+     * the tables, see the comment at the grid correction below.
+     */
+    const RealType beta_S(ic->ewaldcoeff_q);
+    const RealType beta2_S(ic->ewaldcoeff_q * ic->ewaldcoeff_q);
+    const RealType beta3_S(ic->ewaldcoeff_q * ic->ewaldcoeff_q * ic->ewaldcoeff_q);
+
+    /* The range of the Ewald correction for excluded pairs, see the scalar kernel */
+    const real* ewtab                    = nullptr;
+    real        coulombTableScale        = 0;
+    real        coulombTableScaleInvHalf = 0;
+    real        ewaldExclusionRange      = 0;
+    if (elecInteractionTypeIsEwald)
+    {
+        const auto& coulombTables = *ic->coulombEwaldTables;
+        ewtab                     = coulombTables.tableFDV0.data();
+        coulombTableScale         = coulombTables.scale;
+        coulombTableScaleInvHalf  = half / coulombTableScale;
+        ewaldExclusionRange       = (coulombTables.tableF.size() - 1) / coulombTableScale;
+    }
+    const RealType ewaldExclusionRange_S(ewaldExclusionRange);
+
+    real sh_ewald = 0;
+    if (elecInteractionTypeIsEwald || vdwInteractionTypeIsEwald)
+    {
+        sh_ewald = ic->sh_ewald;
+    }
+
+    const real* tab_ewald_F_lj       = nullptr;
+    const real* tab_ewald_V_lj       = nullptr;
+    real        vdwTableScale        = 0;
+    real        vdwTableScaleInvHalf = 0;
+    if (vdwInteractionTypeIsEwald)
+    {
+        const auto& vdwTables = *ic->vdwEwaldTables;
+        tab_ewald_F_lj        = vdwTables.tableF.data();
+        tab_ewald_V_lj        = vdwTables.tableV.data();
+        vdwTableScale         = vdwTables.scale;
+        vdwTableScaleInvHalf  = half / vdwTableScale;
+    }
+
+    /* Lambda factors for state A, 1-lambda, and state B, lambda,
+     * and the derivatives of the lambda factors
+     */
+    const real LFC[NSTATES] = { one - lambda_coul, lambda_coul };
+    const real LFV[NSTATES] = { one - lambda_vdw, lambda_vdw };
+    const real DLF[NSTATES] = { -1, 1 };
+
+    real           lfac_coul[NSTATES], dlfac_coul[NSTATES], lfac_vdw[NSTATES], dlfac_vdw[NSTATES];
+    constexpr real sc_r_power = 6.0_real;
+    for (int i = 0; i < NSTATES; i++)
+    {
+        lfac_coul[i]  = (lam_power == 2 ? (1 - LFC[i]) * (1 - LFC[i]) : (1 - LFC[i]));
+        dlfac_coul[i] = DLF[i] * lam_power / sc_r_power * (lam_power == 2 ? (1 - LFC[i]) : 1);
+        lfac_vdw[i]   = (lam_power == 2 ? (1 - LFV[i]) * (1 - LFV[i]) : (1 - LFV[i]));
+        dlfac_vdw[i]  = DLF[i] * lam_power / sc_r_power * (lam_power == 2 ? (1 - LFV[i]) : 1);
+    }
+
+    const real* x             = xx[0];
+    real* gmx_restrict f      = &(forceWithShiftForces->force()[0][0]);
+    real* gmx_restrict fshift = &(forceWithShiftForces->shiftForces()[0][0]);
+
+    /* Buffers for the per-pair data which is gathered with scalar loads */
+    alignas(GMX_SIMD_ALIGNMENT) std::int32_t preloadJnr[simdWidth];
+    alignas(GMX_SIMD_ALIGNMENT) std::int32_t preloadTableIndex[simdWidth];
+    alignas(GMX_SIMD_ALIGNMENT) real         preloadIsValid[simdWidth];
+    alignas(GMX_SIMD_ALIGNMENT) real         preloadIsIncluded[simdWidth];
+    alignas(GMX_SIMD_ALIGNMENT) real         preloadSelfFactor[simdWidth];
+    alignas(GMX_SIMD_ALIGNMENT) real         preloadQq[NSTATES][simdWidth];
+    alignas(GMX_SIMD_ALIGNMENT) real         preloadC6[NSTATES][simdWidth];
+    alignas(GMX_SIMD_ALIGNMENT) real         preloadC12[NSTATES][simdWidth];
+    alignas(GMX_SIMD_ALIGNMENT) real         preloadC6Grid[NSTATES][simdWidth];
+    alignas(GMX_SIMD_ALIGNMENT) real         tableF0[simdWidth];
+    alignas(GMX_SIMD_ALIGNMENT) real         tableF1[simdWidth];
+    alignas(GMX_SIMD_ALIGNMENT) real         tableV[simdWidth];
+    alignas(GMX_SIMD_ALIGNMENT) real         forceX[simdWidth];
+    alignas(GMX_SIMD_ALIGNMENT) real         forceY[simdWidth];
+    alignas(GMX_SIMD_ALIGNMENT) real         forceZ[simdWidth];
+    alignas(GMX_SIMD_ALIGNMENT) real         pairIsComputed[simdWidth];
+
+    real dvdl_coul = 0;
+    real dvdl_vdw  = 0;
+
+    for (int n = 0; n < nri; n++)
+    {
+        bool haveInteractions = false;
+
+        const int      is3  = 3 * shift[n];
+        const int      nj0  = jindex[n];
+        const int      nj1  = jindex[n + 1];
+        const int      ii   = iinr[n];
+        const int      ii3  = 3 * ii;
+        const RealType ix_S = RealType(shiftvec[is3] + x[ii3 + 0]);
+        const RealType iy_S = RealType(shiftvec[is3 + 1] + x[ii3 + 1]);
+        const RealType iz_S = RealType(shiftvec[is3 + 2] + x[ii3 + 2]);
+        const real     iqA  = facel * chargeA[ii];
+        const real     iqB  = facel * chargeB[ii];
+        const int      ntiA = 2 * ntype * typeA[ii];
+        const int      ntiB = 2 * ntype * typeB[ii];
+        RealType       vctot_S = zero_S;
+        RealType       vvtot_S = zero_S;
+        RealType       fix_S   = zero_S;
+        RealType       fiy_S   = zero_S;
+        RealType       fiz_S   = zero_S;
+        /* We reduce dV/dl per i-entry, as accumulating it over the whole
+         * list in SIMD loses precision due to cancellation of large terms.
+         */
+        RealType dvdl_coul_S = zero_S;
+        RealType dvdl_vdw_S  = zero_S;
+
+        for (int k = nj0; k < nj1; k += simdWidth)
+        {
+            for (int s = 0; s < simdWidth; s++)
+            {
+                const int jnr = jjnr[k + s];
+                if (jnr >= 0)
+                {
+                    const int tjA = ntiA + 2 * typeA[jnr];
+                    const int tjB = ntiB + 2 * typeB[jnr];
+
+                    preloadJnr[s]        = jnr;
+                    preloadIsValid[s]    = one;
+                    preloadIsIncluded[s] = (excl_fep == nullptr || excl_fep[k + s]) ? one : 0;
+                    /* A self-interaction of an i-particle with itself in its
+                     * neighborlist occurs twice, so we scale it by a half.
+                     */
+                    preloadSelfFactor[s]     = (ii == jnr) ? half : one;
+                    preloadQq[STATE_A][s]    = iqA * chargeA[jnr];
+                    preloadQq[STATE_B][s]    = iqB * chargeB[jnr];
+                    preloadC6[STATE_A][s]    = nbfp[tjA];
+                    preloadC6[STATE_B][s]    = nbfp[tjB];
+                    preloadC12[STATE_A][s]   = nbfp[tjA + 1];
+                    preloadC12[STATE_B][s]   = nbfp[tjB + 1];
+                    if (vdwInteractionTypeIsEwald)
+                    {
+                        preloadC6Grid[STATE_A][s] = nbfp_grid[tjA];
+                        preloadC6Grid[STATE_B][s] = nbfp_grid[tjB];
+                    }
+                }
+                else
+                {
+                    /* Padding entry, use a valid atom index and zero all parameters */
+                    preloadJnr[s]          = ii;
+                    preloadIsValid[s]      = 0;
+                    preloadIsIncluded[s]   = 0;
+                    preloadSelfFactor[s]   = 0;
+                    preloadQq[STATE_A][s]  = 0;
+                    preloadQq[STATE_B][s]  = 0;
+                    preloadC6[STATE_A][s]  = 0;
+                    preloadC6[STATE_B][s]  = 0;
+                    preloadC12[STATE_A][s] = 0;
+                    preloadC12[STATE_B][s] = 0;
+                    if (vdwInteractionTypeIsEwald)
+                    {
+                        preloadC6Grid[STATE_A][s] = 0;
+                        preloadC6Grid[STATE_B][s] = 0;
+                    }
+                }
+            }
+
+            RealType jx_S, jy_S, jz_S;
+            gmx::gatherLoadUTranspose<3>(x, preloadJnr, &jx_S, &jy_S, &jz_S);
+
+            const RealType dx_S  = ix_S - jx_S;
+            const RealType dy_S  = iy_S - jy_S;
+            const RealType dz_S  = iz_S - jz_S;
+            const RealType rsq_S = dx_S * dx_S + dy_S * dy_S + dz_S * dz_S;
+
+            const RealType isIncluded_S = gmx::load<RealType>(preloadIsIncluded);
+            const BoolType isIncluded   = (zero_S < isIncluded_S);
+            const BoolType isExcluded =
+                    (zero_S < gmx::load<RealType>(preloadIsValid)) && (isIncluded_S == zero_S);
+
+            /* As in the scalar kernel, we skip included pairs beyond the
+             * cut-off, but excluded pairs still need the Ewald correction.
+             */
+            const BoolType isComputed = (isIncluded && rsq_S < rcutoff_max2_S) || isExcluded;
+            if (!gmx::anyTrue(isComputed))
+            {
+                continue;
+            }
+            haveInteractions = true;
+
+            const RealType rinv_S = gmx::maskzInvsqrt(rsq_S, isComputed && zero_S < rsq_S);
+            const RealType r_S    = rsq_S * rinv_S;
+
+            RealType rp_S, rpm2_S;
+            if (useSoftCore)
+            {
+                rpm2_S = rsq_S * rsq_S;  /* r4 */
+                rp_S   = rpm2_S * rsq_S; /* r6 */
+            }
+            else
+            {
+                rpm2_S = rinv_S * rinv_S;
+                rp_S   = one_S;
+            }
+
+            const RealType selfFactor_S = gmx::load<RealType>(preloadSelfFactor);
+
+            RealType qq_S[NSTATES], c6_S[NSTATES], c12_S[NSTATES], sigma6_S[NSTATES];
+            for (int i = 0; i < NSTATES; i++)
+            {
+                qq_S[i]  = gmx::load<RealType>(preloadQq[i]);
+                c6_S[i]  = gmx::load<RealType>(preloadC6[i]);
+                c12_S[i] = gmx::load<RealType>(preloadC12[i]);
+                if (useSoftCore)
+                {
+                    /* c12 is stored scaled with 12.0 and c6 with 6.0 - correct for this */
+                    const BoolType haveSigma = (zero_S < c6_S[i]) && (zero_S < c12_S[i]);
+                    sigma6_S[i] = half * c12_S[i] * gmx::maskzInv(c6_S[i], haveSigma);
+                    sigma6_S[i] = gmx::blend(sigma6_def_S, gmx::max(sigma6_S[i], sigma6_min_S),
+                                             haveSigma);
+                }
+            }
+
+            RealType alpha_vdw_eff_S, alpha_coul_eff_S;
+            if (useSoftCore)
+            {
+                /* only use softcore if one of the states has a zero endstate,
+                 * softcore is for avoiding infinities!
+                 */
+                const BoolType bothC12Positive =
+                        (zero_S < c12_S[STATE_A]) && (zero_S < c12_S[STATE_B]);
+                alpha_vdw_eff_S  = gmx::selectByNotMask(alpha_vdw_S, bothC12Positive);
+                alpha_coul_eff_S = gmx::selectByNotMask(alpha_coul_S, bothC12Positive);
+            }
+
+            const BoolType includedAndComputed = isIncluded && isComputed;
+
+            RealType fScal_S = zero_S;
+
+            for (int i = 0; i < NSTATES; i++)
+            {
+                /* Only spend time on A or B state if it is non-zero */
+                const BoolType haveQq      = (qq_S[i] != zero_S);
+                const BoolType haveLJ      = (c6_S[i] != zero_S) || (c12_S[i] != zero_S);
+                const BoolType computeState = includedAndComputed && (haveQq || haveLJ);
+                if (!gmx::anyTrue(computeState))
+                {
+                    continue;
+                }
+
+                RealType rinvC_S, rinvV_S, rC_S, rV_S, rpinvC_S, rpinvV_S;
+                if (useSoftCore)
+                {
+                    rpinvC_S = gmx::maskzInv(alpha_coul_eff_S * lfac_coul[i] * sigma6_S[i] + rp_S,
+                                             computeState);
+                    pthRoot(rpinvC_S, &rinvC_S, &rC_S, computeState);
+                    if (scLambdasOrAlphasDiffer)
+                    {
+                        rpinvV_S = gmx::maskzInv(alpha_vdw_eff_S * lfac_vdw[i] * sigma6_S[i] + rp_S,
+                                                 computeState);
+                        pthRoot(rpinvV_S, &rinvV_S, &rV_S, computeState);
+                    }
+                    else
+                    {
+                        /* We can avoid one expensive pow and one / operation */
+                        rpinvV_S = rpinvC_S;
+                        rinvV_S  = rinvC_S;
+                        rV_S     = rC_S;
+                    }
+                }
+                else
+                {
+                    rpinvC_S = one_S;
+                    rinvC_S  = rinv_S;
+                    rC_S     = r_S;
+
+                    rpinvV_S = one_S;
+                    rinvV_S  = rinv_S;
+                    rV_S     = r_S;
+                }
+
+                /* Only process the coulomb interactions if we have charges
+                 * and if we are within the cutoff.
+                 */
+                const BoolType computeElecInteraction =
+                        computeState && haveQq
+                        && (elecInteractionTypeIsEwald ? (r_S < rcoulomb_S) : (rC_S < rcoulomb_S));
+
+                RealType vCoul_S, fScalC_S;
+                if (elecInteractionTypeIsEwald)
+                {
+                    vCoul_S  = ewaldPotential(qq_S[i], rinvC_S, sh_ewald);
+                    fScalC_S = ewaldScalarForce(qq_S[i], rinvC_S);
+                }
+                else
+                {
+                    vCoul_S  = reactionFieldPotential(qq_S[i], rinvC_S, rC_S, krf, crf);
+                    fScalC_S = reactionFieldScalarForce(qq_S[i], rinvC_S, rC_S, krf, two);
+                }
+                vCoul_S  = gmx::selectByMask(vCoul_S, computeElecInteraction);
+                fScalC_S = gmx::selectByMask(fScalC_S, computeElecInteraction);
+
+                /* Only process the VDW interactions if we have
+                 * some non-zero parameters and if we are within the cutoff.
+                 */
+                const BoolType computeVdwInteraction =
+                        computeState && haveLJ
+                        && (vdwInteractionTypeIsEwald ? (r_S < rvdw_S) : (rV_S < rvdw_S));
+
+                RealType rinv6_S;
+                if (useSoftCore)
+                {
+                    rinv6_S = rpinvV_S;
+                }
+                else
+                {
+                    rinv6_S = calculateRinv6(rinvV_S);
+                }
+                const RealType vVdw6_S  = calculateVdw6(c6_S[i], rinv6_S);
+                const RealType vVdw12_S = calculateVdw12(c12_S[i], rinv6_S);
+
+                RealType vVdw_S = lennardJonesPotential(vVdw6_S, vVdw12_S, c6_S[i], c12_S[i],
+                                                        repulsionShift, dispersionShift, onesixth,
+                                                        onetwelfth);
+                RealType fScalV_S = lennardJonesScalarForce(vVdw6_S, vVdw12_S);
+
+                if (vdwInteractionTypeIsEwald)
+                {
+                    /* Subtract the grid potential at the cut-off */
+                    vVdw_S = vVdw_S
+                             + gmx::load<RealType>(preloadC6Grid[i])
+                                       * RealType(sh_lj_ewald * onesixth);
+                }
+
+                if (vdwModifierIsPotSwitch)
+                {
+                    /* The switch only applies within rvdw, computeVdwInteraction masks this */
+                    const RealType d_S  = gmx::max(rV_S - rvdw_switch_S, zero_S);
+                    const RealType d2_S = d_S * d_S;
+                    const RealType sw_S =
+                            one_S + d2_S * d_S * (vdw_swV3 + d_S * (vdw_swV4 + d_S * vdw_swV5));
+                    const RealType dsw_S = d2_S * (vdw_swF2 + d_S * (vdw_swF3 + d_S * vdw_swF4));
+
+                    fScalV_S = fScalV_S * sw_S - rV_S * vVdw_S * dsw_S;
+                    vVdw_S   = vVdw_S * sw_S;
+                }
+                vVdw_S   = gmx::selectByMask(vVdw_S, computeVdwInteraction);
+                fScalV_S = gmx::selectByMask(fScalV_S, computeVdwInteraction);
+
+                /* fScalC (and fScalV) now contain: dV/drC * rC
+                 * Now we multiply by rC^-p, so it will be: dV/drC * rC^1-p
+                 * Further down we first multiply by r^p-2 and then by
+                 * the vector r, which in total gives: dV/drC * (r/rC)^1-p
+                 */
+                if (useSoftCore)
+                {
+                    fScalC_S = fScalC_S * rpinvC_S;
+                    fScalV_S = fScalV_S * rpinvV_S;
+                }
+
+                /* Assemble A and B states */
+                vctot_S = vctot_S + LFC[i] * vCoul_S;
+                vvtot_S = vvtot_S + LFV[i] * vVdw_S;
+
+                fScal_S = fScal_S + (LFC[i] * fScalC_S + LFV[i] * fScalV_S) * rpm2_S;
+
+                if (useSoftCore)
+                {
+                    dvdl_coul_S =
+                            dvdl_coul_S + vCoul_S * DLF[i]
+                            + LFC[i] * alpha_coul_eff_S * dlfac_coul[i] * fScalC_S * sigma6_S[i];
+                    dvdl_vdw_S = dvdl_vdw_S + vVdw_S * DLF[i]
+                                 + LFV[i] * alpha_vdw_eff_S * dlfac_vdw[i] * fScalV_S * sigma6_S[i];
+                }
+                else
+                {
+                    dvdl_coul_S = dvdl_coul_S + vCoul_S * DLF[i];
+                    dvdl_vdw_S  = dvdl_vdw_S + vVdw_S * DLF[i];
+                }
+            } // end for (int i = 0; i < NSTATES; i++)
+
+            if (!elecInteractionTypeIsEwald && gmx::anyTrue(isExcluded))
+            {
+                /* For excluded pairs we don't use soft-core, see the scalar kernel.
+                 * Note that without Ewald electrostatics we have reaction-field.
+                 */
+                const RealType ff_S = gmx::selectByMask(RealType(-two * krf), isExcluded);
+                const RealType vv_S =
+                        gmx::selectByMask((krf * rsq_S - crf) * selfFactor_S, isExcluded);
+
+                for (int i = 0; i < NSTATES; i++)
+                {
+                    vctot_S     = vctot_S + LFC[i] * qq_S[i] * vv_S;
+                    fScal_S     = fScal_S + LFC[i] * qq_S[i] * ff_S;
+                    dvdl_coul_S = dvdl_coul_S + DLF[i] * qq_S[i] * vv_S;
+                }
+            }
+
+            if (elecInteractionTypeIsEwald)
+            {
+                /* See the scalar kernel, we subtract the reciprocal-space Ewald
+                 * component here. Any Ewald shift has already been applied
+                 * in the normal interaction part above. As in the scalar kernel,
+                 * excluded pairs are only corrected within the range of the table.
+                 */
+                const BoolType computeEwaldAnalytical = isComputed && (r_S < rcoulomb_S);
+                const BoolType computeEwaldTable =
+                        isExcluded && (rcoulomb_S <= r_S) && (r_S < ewaldExclusionRange_S);
+                const RealType brsq_S =
+                        beta2_S * gmx::selectByMask(rsq_S, computeEwaldAnalytical);
+                RealType v_lr_S = gmx::selectByMask(
+                        beta_S * gmx::pmePotentialCorrection(brsq_S) * selfFactor_S,
+                        computeEwaldAnalytical);
+                RealType f_lr_S = gmx::selectByMask(-(beta3_S * gmx::pmeForceCorrection(brsq_S)),
+                                                    computeEwaldAnalytical);
+
+                if (gmx::anyTrue(computeEwaldTable))
+                {
+                    /* Excluded pairs beyond the cut-off are rare, so we gather
+                     * the table entries with scalar loads.
+                     */
+                    const RealType ewrt_S =
+                            gmx::selectByMask(r_S * coulombTableScale, computeEwaldTable);
+                    const IntType  ewitab_S = gmx::cvttR2I(ewrt_S);
+                    const RealType eweps_S  = ewrt_S - gmx::cvtI2R(ewitab_S);
+                    gmx::store(preloadTableIndex, ewitab_S);
+                    for (int s = 0; s < simdWidth; s++)
+                    {
+                        const int ewitab = 4 * preloadTableIndex[s];
+                        tableF0[s]       = ewtab[ewitab];
+                        tableF1[s]       = ewtab[ewitab + 1];
+                        tableV[s]        = ewtab[ewitab + 2];
+                    }
+                    const RealType tableF0_S = gmx::load<RealType>(tableF0);
+                    const RealType fTable_S  = tableF0_S + eweps_S * gmx::load<RealType>(tableF1);
+                    const RealType vTable_S  = gmx::load<RealType>(tableV)
+                                              - coulombTableScaleInvHalf * eweps_S
+                                                        * (tableF0_S + fTable_S);
+                    v_lr_S = gmx::blend(v_lr_S, vTable_S * selfFactor_S, computeEwaldTable);
+                    f_lr_S = gmx::blend(f_lr_S, fTable_S * rinv_S, computeEwaldTable);
+                }
+
+                for (int i = 0; i < NSTATES; i++)
+                {
+                    vctot_S     = vctot_S - LFC[i] * qq_S[i] * v_lr_S;
+                    fScal_S     = fScal_S - LFC[i] * qq_S[i] * f_lr_S;
+                    dvdl_coul_S = dvdl_coul_S - (DLF[i] * qq_S[i]) * v_lr_S;
+                }
+            }
+
+            if (vdwInteractionTypeIsEwald)
+            {
+                /* See the scalar kernel, we subtract the reciprocal-space LJ-Ewald
+                 * component here. We use the tables instead of the analytical form,
+                 * as the latter can cause issues for r close to 0 for
+                 * non-interacting pairs. The table entries are gathered with
+                 * scalar loads.
+                 */
+                const BoolType computeLJEwald = isComputed && (r_S < rvdw_S);
+                const RealType rs_S   = gmx::selectByMask(r_S * vdwTableScale, computeLJEwald);
+                const IntType  ri_S   = gmx::cvttR2I(rs_S);
+                const RealType frac_S = rs_S - gmx::cvtI2R(ri_S);
+                gmx::store(preloadTableIndex, ri_S);
+                for (int s = 0; s < simdWidth; s++)
+                {
+                    const int ri = preloadTableIndex[s];
+                    tableF0[s]   = tab_ewald_F_lj[ri];
+                    tableF1[s]   = tab_ewald_F_lj[ri + 1];
+                    tableV[s]    = tab_ewald_V_lj[ri];
+                }
+                const RealType tableF0_S = gmx::load<RealType>(tableF0);
+                const RealType f_lr_S =
+                        (one_S - frac_S) * tableF0_S + frac_S * gmx::load<RealType>(tableF1);
+                /* TODO: Currently the Ewald LJ table does not contain
+                 * the factor 1/6, we should add this.
+                 */
+                const RealType ff_S =
+                        gmx::selectByMask(f_lr_S * rinv_S * (one / six), computeLJEwald);
+                const RealType vLr_S = gmx::load<RealType>(tableV)
+                                       - vdwTableScaleInvHalf * frac_S * (tableF0_S + f_lr_S);
+                const RealType vv_S =
+                        gmx::selectByMask(vLr_S * (one / six) * selfFactor_S, computeLJEwald);
+
+                for (int i = 0; i < NSTATES; i++)
+                {
+                    const RealType c6grid_S = gmx::load<RealType>(preloadC6Grid[i]);
+                    vvtot_S                 = vvtot_S + LFV[i] * c6grid_S * vv_S;
+                    fScal_S                 = fScal_S + LFV[i] * c6grid_S * ff_S;
+                    dvdl_vdw_S              = dvdl_vdw_S + (DLF[i] * c6grid_S) * vv_S;
+                }
+            }
+
+            if (doForces)
+            {
+                const RealType tx_S = fScal_S * dx_S;
+                const RealType ty_S = fScal_S * dy_S;
+                const RealType tz_S = fScal_S * dz_S;
+                fix_S               = fix_S + tx_S;
+                fiy_S               = fiy_S + ty_S;
+                fiz_S               = fiz_S + tz_S;
+
+                gmx::store(forceX, tx_S);
+                gmx::store(forceY, ty_S);
+                gmx::store(forceZ, tz_S);
+                gmx::store(pairIsComputed, gmx::selectByMask(one_S, isComputed));
+                for (int s = 0; s < simdWidth; s++)
+                {
+                    if (pairIsComputed[s] != 0)
+                    {
+                        /* As in the scalar kernel we use atomics, this kernel
+                         * is expensive enough to take this hit.
+                         */
+                        const int j3 = 3 * preloadJnr[s];
+#pragma omp atomic
+                        f[j3] -= forceX[s];
+#pragma omp atomic
+                        f[j3 + 1] -= forceY[s];
+#pragma omp atomic
+                        f[j3 + 2] -= forceZ[s];
+                    }
+                }
+            }
+        } // end for (int k = nj0; k < nj1; k += simdWidth)
+
+        /* Skip the i-reductions when all pairs are beyond the cut-off */
+        if (haveInteractions)
+        {
+            dvdl_coul += gmx::reduce(dvdl_coul_S);
+            dvdl_vdw += gmx::reduce(dvdl_vdw_S);
+            if (doForces)
+            {
+                const real fix = gmx::reduce(fix_S);
+                const real fiy = gmx::reduce(fiy_S);
+                const real fiz = gmx::reduce(fiz_S);
+#pragma omp atomic
+                f[ii3] += fix;
+#pragma omp atomic
+                f[ii3 + 1] += fiy;
+#pragma omp atomic
+                f[ii3 + 2] += fiz;
+                if (doShiftForces)
+                {
+#pragma omp atomic
+                    fshift[is3] += fix;
+#pragma omp atomic
+                    fshift[is3 + 1] += fiy;
+#pragma omp atomic
+                    fshift[is3 + 2] += fiz;
+                }
+            }
+            if (doPotential)
+            {
+                const real vctot = gmx::reduce(vctot_S);
+                const real vvtot = gmx::reduce(vvtot_S);
+                const int  ggid  = gid[n];
+#pragma omp atomic
+                Vc[ggid] += vctot;
+#pragma omp atomic
+                Vv[ggid] += vvtot;
+            }
+        }
+    } // end for (int n = 0; n < nri; n++)
+
+#pragma omp atomic
+    dvdl[efptCOUL] += dvdl_coul;
+#pragma omp atomic
+    dvdl[efptVDW] += dvdl_vdw;
+
+    /* Estimate flops, average for free energy stuff:
+     * 12  flops per outer iteration
+     * 150 flops per inner iteration
+     */
+#pragma omp atomic
+    inc_nrnb(nrnb, eNR_NBKERNEL_FREE_ENERGY, nlist->nri * 12 + nlist->jindex[nri] * 150);
+}
+#endif
+
 typedef void (*KernelFunction)(const t_nblist* gmx_restrict nlist,
                                rvec* gmx_restrict         xx,
                                gmx::ForceWithShiftForces* forceWithShiftForces,
@@ -855,9 +1563,8 @@ static KernelFunction dispatchKernelOnUseSimd(const bool useSimd)
     if (useSimd)
     {
 #if GMX_SIMD_HAVE_REAL && GMX_SIMD_HAVE_INT32_ARITHMETICS && GMX_USE_SIMD_KERNELS
-        /* FIXME: Here SimdDataTypes should be used to enable SIMD. So far, the code in nb_free_energy_kernel is not adapted to SIMD */
-        return (nb_free_energy_kernel<ScalarDataTypes, useSoftCore, scLambdasOrAlphasDiffer, vdwInteractionTypeIsEwald,
-                                      elecInteractionTypeIsEwald, vdwModifierIsPotSwitch>);
+        return (nb_free_energy_kernel_simd<useSoftCore, scLambdasOrAlphasDiffer, vdwInteractionTypeIsEwald,
+                                           elecInteractionTypeIsEwald, vdwModifierIsPotSwitch>);
 #else
         return (nb_free_energy_kernel<ScalarDataTypes, useSoftCore, scLambdasOrAlphasDiffer, vdwInteractionTypeIsEwald,
                                       elecInteractionTypeIsEwald, vdwModifierIsPotSwitch>);
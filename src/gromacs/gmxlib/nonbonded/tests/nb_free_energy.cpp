@@ -0,0 +1,496 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2021, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Tests that the SIMD flavor of the free-energy kernel agrees with the
+ * plain-C flavor, including for excluded pairs beyond the cut-off.
+ *
+ * \ingroup module_gmxlib
+ */
+#include "gmxpre.h"
+
+#include "gromacs/gmxlib/nonbonded/nb_free_energy.h"
+
+#include "config.h"
+
+#include <cmath>
+
+#include <algorithm>
+#include <memory>
+#include <tuple>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "gromacs/ewald/ewald_utils.h"
+#include "gromacs/gmxlib/nonbonded/nb_kernel.h"
+#include "gromacs/gmxlib/nonbonded/nonbonded.h"
+#include "gromacs/gmxlib/nrnb.h"
+#include "gromacs/math/functions.h"
+#include "gromacs/math/paddedvector.h"
+#include "gromacs/math/units.h"
+#include "gromacs/math/vectypes.h"
+#include "gromacs/mdlib/forcerec.h"
+#include "gromacs/mdtypes/forceoutput.h"
+#include "gromacs/mdtypes/forcerec.h"
+#include "gromacs/mdtypes/inputrec.h"
+#include "gromacs/mdtypes/interaction_const.h"
+#include "gromacs/mdtypes/md_enums.h"
+#include "gromacs/mdtypes/mdatom.h"
+#include "gromacs/mdtypes/nblist.h"
+#include "gromacs/pbcutil/ishift.h"
+#include "gromacs/simd/simd.h"
+#include "gromacs/utility/smalloc.h"
+
+#include "testutils/testasserts.h"
+
+namespace gmx
+{
+namespace test
+{
+namespace
+{
+
+//! The number of atoms in the test system
+constexpr int c_numAtoms = 20;
+//! The number of perturbed atoms, these form one molecule with all pairs excluded
+constexpr int c_numPerturbedAtoms = 8;
+//! The number of atom types, type 1 has no LJ interactions
+constexpr int c_numTypes = 2;
+//! The Coulomb and VdW cut-off
+constexpr real c_cutoff = 0.9;
+//! The table extension length, as set by the table-extension mdp option
+constexpr real c_tableExtension = 1;
+//! The shift index used for the periodic images of the perturbed molecule
+constexpr int c_farShiftIndex = 0;
+//! The switching distance for VdW potential switching
+constexpr real c_vdwSwitchDistance = 0.7;
+
+#if GMX_SIMD_HAVE_REAL && GMX_SIMD_HAVE_INT32_ARITHMETICS && GMX_USE_SIMD_KERNELS
+//! The padding width of the j-lists, as set up by the pair search
+constexpr int c_paddingWidth = GMX_SIMD_REAL_WIDTH;
+#else
+//! The padding width of the j-lists, as set up by the pair search
+constexpr int c_paddingWidth = 1;
+#endif
+
+//! The electrostatics and VdW interaction setups to test
+enum class Interactions
+{
+    PmeWithLJCutoff,
+    PmeWithLJPotentialSwitch,
+    PmeWithLJPme,
+    ReactionFieldWithLJCutoff
+};
+
+//! The soft-core setups to test
+enum class SoftCore
+{
+    //! No soft-core
+    None,
+    //! The same soft-core alpha for Coulomb and VdW
+    CoulombAndVdw,
+    //! Soft-core only for VdW, so the Coulomb and VdW alphas differ
+    VdwOnly
+};
+
+//! The parameters are the interactions, the Coulomb and VdW lambdas and the soft-core setup
+using FreeEnergyKernelTestParameters = std::tuple<Interactions, real, real, SoftCore>;
+
+//! The output of one call to the free-energy kernel
+struct KernelOutput
+{
+    //! The Coulomb energy
+    real vCoulomb = 0;
+    //! The VdW energy
+    real vVdw = 0;
+    //! dV/dlambda for Coulomb and VdW
+    real dvdl[efptNR] = { 0 };
+    //! The forces
+    std::vector<RVec> forces;
+    //! The shift forces
+    std::vector<RVec> shiftForces;
+};
+
+//! Free-energy pair list, the storage for a t_nblist
+struct FepPairList
+{
+    /*! \brief Adds an i-entry for atom \p iAtom with j-atoms \p jAtoms
+     *
+     * Pairs with j-atoms below \p numExcludedAtoms are excluded.
+     */
+    void addEntry(int iAtom, int shiftIndex, const std::vector<int>& jAtoms, int numExcludedAtoms)
+    {
+        iinr.push_back(iAtom);
+        shift.push_back(shiftIndex);
+        gid.push_back(0);
+        for (int j : jAtoms)
+        {
+            jjnr.push_back(j);
+            exclFep.push_back(j >= numExcludedAtoms ? 1 : 0);
+        }
+        while (jjnr.size() % c_paddingWidth != 0)
+        {
+            jjnr.push_back(-1);
+            exclFep.push_back(0);
+        }
+        jindex.push_back(jjnr.size());
+    }
+
+    //! Returns a t_nblist referring to the data in this object
+    t_nblist nblist()
+    {
+        t_nblist nlist           = {};
+        nlist.nri                = iinr.size();
+        nlist.maxnri             = iinr.size();
+        nlist.nrj                = jjnr.size();
+        nlist.maxnrj             = jjnr.size();
+        nlist.iinr               = iinr.data();
+        nlist.gid                = gid.data();
+        nlist.shift              = shift.data();
+        nlist.jindex             = jindex.data();
+        nlist.jjnr               = jjnr.data();
+        nlist.excl_fep           = exclFep.data();
+        nlist.simd_padding_width = c_paddingWidth;
+
+        return nlist;
+    }
+
+    //! The i-atoms
+    std::vector<int> iinr;
+    //! The shift indices
+    std::vector<int> shift;
+    //! The energy group pair indices
+    std::vector<int> gid;
+    //! The j-list start indices
+    std::vector<int> jindex = { 0 };
+    //! The j-atoms
+    std::vector<int> jjnr;
+    //! The exclusion masks, 1 means the pair is included
+    std::vector<char> exclFep;
+};
+
+/*! \brief Sets up a small system with one perturbed molecule and calls the kernels
+ *
+ * The perturbed molecule is longer than the cut-off, so there are excluded
+ * pairs both within the cut-off and between the cut-off and the end of
+ * the Ewald correction table.
+ */
+class FreeEnergyKernelTest : public ::testing::TestWithParam<FreeEnergyKernelTestParameters>
+{
+public:
+    FreeEnergyKernelTest()
+    {
+        const Interactions interactions = std::get<0>(GetParam());
+        const SoftCore     softCore     = std::get<3>(GetParam());
+
+        // A perturbed molecule spanning 1.6 nm along x and other atoms spread over 2 nm
+        for (int a = 0; a < c_numAtoms; a++)
+        {
+            const bool isPerturbed = (a < c_numPerturbedAtoms);
+            if (isPerturbed)
+            {
+                x_.emplace_back(0.23 * a, 0.05 * (a % 3), 0.04 * (a % 2));
+            }
+            else
+            {
+                x_.emplace_back(0.55 * (a % 3) + 0.011 * a, 0.55 * ((a / 3) % 3) + 0.007 * a,
+                                0.55 * (a / 9) + 0.003 * a * a + 0.3);
+            }
+
+            chargeA_.push_back((a % 2 == 0 ? 0.4 : -0.4) + 0.05 * (a % 5));
+            chargeB_.push_back(isPerturbed ? 0 : chargeA_.back());
+            typeA_.push_back(0);
+            typeB_.push_back(isPerturbed ? 1 : 0);
+        }
+
+        // C6 and C12 are stored with factors 6 and 12
+        nbfp_.assign(2 * c_numTypes * c_numTypes, 0);
+        nbfp_[0] = 6 * 0.0026;
+        nbfp_[1] = 12 * 2.6e-6;
+        // The LJ-PME grid C6 values, only the C6 entries are used
+        c6grid_.assign(nbfp_.size(), 0);
+        c6grid_[0] = 6 * 0.0024;
+
+        t_lambda fepvals{};
+        fepvals.sc_alpha     = (softCore == SoftCore::None ? 0 : 0.5);
+        fepvals.sc_power     = 1;
+        fepvals.sc_r_power   = 6;
+        fepvals.sc_sigma     = 0.3;
+        fepvals.sc_sigma_min = 0.3;
+        fepvals.bScCoul      = (softCore == SoftCore::CoulombAndVdw);
+
+        ic_.epsfac   = ONE_4PI_EPS0;
+        ic_.rcoulomb = c_cutoff;
+        ic_.rvdw     = c_cutoff;
+        if (interactions == Interactions::ReactionFieldWithLJCutoff)
+        {
+            // Reaction-field with infinite dielectric constant
+            ic_.eeltype          = eelRF;
+            ic_.coulomb_modifier = eintmodEXACTCUTOFF;
+            ic_.k_rf             = 0.5 / gmx::power3(c_cutoff);
+            ic_.c_rf             = 1 / c_cutoff + ic_.k_rf * gmx::square(c_cutoff);
+        }
+        else
+        {
+            ic_.eeltype          = eelPME;
+            ic_.coulomb_modifier = eintmodPOTSHIFT;
+            ic_.ewaldcoeff_q     = calc_ewaldcoeff_q(c_cutoff, 1e-5);
+            ic_.sh_ewald         = std::erfc(ic_.ewaldcoeff_q * c_cutoff) / c_cutoff;
+        }
+        if (interactions == Interactions::PmeWithLJPotentialSwitch)
+        {
+            ic_.vdwtype      = evdwCUT;
+            ic_.vdw_modifier = eintmodPOTSWITCH;
+            ic_.rvdw_switch  = c_vdwSwitchDistance;
+        }
+        else
+        {
+            ic_.vdwtype               = (interactions == Interactions::PmeWithLJPme) ? evdwPME
+                                                                                     : evdwCUT;
+            ic_.vdw_modifier          = eintmodPOTSHIFT;
+            ic_.dispersion_shift.cpot = -1.0 / gmx::power6(c_cutoff);
+            ic_.repulsion_shift.cpot  = -1.0 / gmx::power12(c_cutoff);
+        }
+        if (interactions == Interactions::PmeWithLJPme)
+        {
+            ic_.ewaldcoeff_lj = calc_ewaldcoeff_lj(c_cutoff, 1e-3);
+            const real crc2   = gmx::square(ic_.ewaldcoeff_lj * c_cutoff);
+            ic_.sh_lj_ewald =
+                    (std::exp(-crc2) * (1 + crc2 + 0.5 * crc2 * crc2) - 1) / gmx::power6(c_cutoff);
+        }
+        ic_.coulombEwaldTables = std::make_unique<EwaldCorrectionTables>();
+        ic_.vdwEwaldTables     = std::make_unique<EwaldCorrectionTables>();
+        init_interaction_const_tables(nullptr, &ic_, c_tableExtension);
+        ic_.softCoreParameters = std::make_unique<interaction_const_t::SoftCoreParameters>(fepvals);
+
+        fr_.ic           = &ic_;
+        fr_.ntype        = c_numTypes;
+        fr_.nbfp         = nbfp_;
+        fr_.ljpme_c6grid = c6grid_.data();
+        snew(fr_.shift_vec, SHIFTS);
+        // An image of the molecule far beyond the table range, as can occur in the pair list
+        fr_.shift_vec[c_farShiftIndex][XX] = 4.2;
+        fr_.shift_vec[c_farShiftIndex][YY] = 0.4;
+
+        mdatoms_.chargeA = chargeA_.data();
+        mdatoms_.chargeB = chargeB_.data();
+        mdatoms_.typeA   = typeA_.data();
+        mdatoms_.typeB   = typeB_.data();
+    }
+
+    /*! \brief Returns the pair list for the perturbed atoms
+     *
+     * With \p addFarImages, entries for all excluded pairs with a periodic
+     * image of the molecule beyond the table range are added.
+     */
+    static FepPairList makePairList(bool addFarImages)
+    {
+        FepPairList list;
+        for (int i = 0; i < c_numPerturbedAtoms; i++)
+        {
+            std::vector<int> jAtoms;
+            for (int j = i; j < c_numAtoms; j++)
+            {
+                jAtoms.push_back(j);
+            }
+            list.addEntry(i, CENTRAL, jAtoms, c_numPerturbedAtoms);
+        }
+        if (addFarImages)
+        {
+            for (int i = 0; i < c_numPerturbedAtoms; i++)
+            {
+                std::vector<int> jAtoms;
+                for (int j = 0; j < c_numPerturbedAtoms; j++)
+                {
+                    jAtoms.push_back(j);
+                }
+                list.addEntry(i, c_farShiftIndex, jAtoms, c_numPerturbedAtoms);
+            }
+        }
+
+        return list;
+    }
+
+    //! Runs the free-energy kernel on \p pairList
+    KernelOutput runKernel(FepPairList* pairList, bool useSimd)
+    {
+        fr_.use_simd_kernels = useSimd;
+
+        real lambda[efptNR] = { 0 };
+        lambda[efptCOUL]    = std::get<1>(GetParam());
+        lambda[efptVDW]     = std::get<2>(GetParam());
+
+        KernelOutput output;
+
+        nb_kernel_data_t kernelData = {};
+        kernelData.flags =
+                GMX_NONBONDED_DO_FORCE | GMX_NONBONDED_DO_SHIFTFORCE | GMX_NONBONDED_DO_POTENTIAL;
+        kernelData.lambda         = lambda;
+        kernelData.dvdl           = output.dvdl;
+        kernelData.energygrp_elec = &output.vCoulomb;
+        kernelData.energygrp_vdw  = &output.vVdw;
+
+        PaddedVector<RVec> forces(c_numAtoms, { 0, 0, 0 });
+        output.shiftForces.assign(SHIFTS, { 0, 0, 0 });
+        ForceWithShiftForces forceWithShiftForces(forces.arrayRefWithPadding(), true,
+                                                  output.shiftForces);
+
+        const t_nblist nlist = pairList->nblist();
+        t_nrnb         nrnb;
+        gmx_nb_free_energy_kernel(&nlist, as_rvec_array(x_.data()), &forceWithShiftForces, &fr_,
+                                  &mdatoms_, &kernelData, &nrnb);
+
+        const auto forceRef = forceWithShiftForces.force();
+        output.forces.assign(forceRef.begin(), forceRef.end());
+
+        return output;
+    }
+
+private:
+    //! The coordinates
+    std::vector<RVec> x_;
+    //! The charges in state A
+    std::vector<real> chargeA_;
+    //! The charges in state B
+    std::vector<real> chargeB_;
+    //! The atom types in state A
+    std::vector<int> typeA_;
+    //! The atom types in state B
+    std::vector<int> typeB_;
+    //! The LJ parameter matrix
+    std::vector<real> nbfp_;
+    //! The LJ-PME grid C6 parameter matrix
+    std::vector<real> c6grid_;
+    //! The interaction constants
+    interaction_const_t ic_;
+    //! The force record, only the fields used by the kernels are set
+    t_forcerec fr_;
+    //! The atom data
+    t_mdatoms mdatoms_ = {};
+};
+
+//! Expects that \p test agrees with \p reference within \p tolerance
+void expectOutputsEqual(const KernelOutput& reference, const KernelOutput& test, real tolerance)
+{
+    real forceMagnitude = 0;
+    for (const RVec& f : reference.forces)
+    {
+        forceMagnitude = std::max(forceMagnitude, norm(f));
+    }
+    const real energyMagnitude =
+            std::max(std::abs(reference.vCoulomb), std::abs(reference.dvdl[efptCOUL]));
+
+    EXPECT_REAL_EQ_TOL(reference.vCoulomb, test.vCoulomb,
+                       relativeToleranceAsFloatingPoint(energyMagnitude, tolerance));
+    EXPECT_REAL_EQ_TOL(reference.vVdw, test.vVdw,
+                       relativeToleranceAsFloatingPoint(reference.vVdw, tolerance));
+    EXPECT_REAL_EQ_TOL(reference.dvdl[efptCOUL], test.dvdl[efptCOUL],
+                       relativeToleranceAsFloatingPoint(energyMagnitude, tolerance));
+    EXPECT_REAL_EQ_TOL(reference.dvdl[efptVDW], test.dvdl[efptVDW],
+                       relativeToleranceAsFloatingPoint(reference.vVdw, tolerance));
+    for (int a = 0; a < c_numAtoms; a++)
+    {
+        for (int d = 0; d < DIM; d++)
+        {
+            EXPECT_REAL_EQ_TOL(reference.forces[a][d], test.forces[a][d],
+                               relativeToleranceAsFloatingPoint(forceMagnitude, tolerance))
+                    << "for atom " << a << " dimension " << d;
+        }
+    }
+    for (int s = 0; s < SHIFTS; s++)
+    {
+        for (int d = 0; d < DIM; d++)
+        {
+            EXPECT_REAL_EQ_TOL(reference.shiftForces[s][d], test.shiftForces[s][d],
+                               relativeToleranceAsFloatingPoint(forceMagnitude, tolerance))
+                    << "for shift " << s << " dimension " << d;
+        }
+    }
+}
+
+TEST_P(FreeEnergyKernelTest, SimdMatchesScalar)
+{
+    FepPairList pairList = makePairList(true);
+
+    const KernelOutput scalar = runKernel(&pairList, false);
+    const KernelOutput simd   = runKernel(&pairList, true);
+
+    // The SIMD kernel computes the Ewald correction within the cut-off analytically
+    expectOutputsEqual(scalar, simd, 1e-4);
+}
+
+TEST_P(FreeEnergyKernelTest, DistantExcludedPairsDoNotContribute)
+{
+    if (std::get<0>(GetParam()) == Interactions::ReactionFieldWithLJCutoff)
+    {
+        // With reaction-field all excluded pairs in the list get a correction
+        return;
+    }
+
+    FepPairList pairList        = makePairList(false);
+    FepPairList pairListWithFar = makePairList(true);
+
+    for (bool useSimd : { false, true })
+    {
+        SCOPED_TRACE(useSimd ? "SIMD kernel" : "scalar kernel");
+
+        const KernelOutput reference = runKernel(&pairList, useSimd);
+        const KernelOutput withFar   = runKernel(&pairListWithFar, useSimd);
+
+        expectOutputsEqual(reference, withFar, 1e-6);
+    }
+}
+
+//! The interaction setups to test
+const auto c_interactionsToTest = ::testing::Values(Interactions::PmeWithLJCutoff,
+                                                    Interactions::PmeWithLJPotentialSwitch,
+                                                    Interactions::PmeWithLJPme,
+                                                    Interactions::ReactionFieldWithLJCutoff);
+
+//! The soft-core setups to test
+const auto c_softCoreToTest =
+        ::testing::Values(SoftCore::None, SoftCore::CoulombAndVdw, SoftCore::VdwOnly);
+
+INSTANTIATE_TEST_CASE_P(WithInteractionsLambdasAndSoftCore,
+                        FreeEnergyKernelTest,
+                        ::testing::Combine(c_interactionsToTest,
+                                           ::testing::Values(0.0, 0.4),
+                                           ::testing::Values(0.0, 0.7),
+                                           c_softCoreToTest));
+
+} // namespace
+} // namespace test
+} // namespace gmx
@@ -59,6 +59,7 @@
 #include "gromacs/mdrun/mdmodules.h"
 #include "gromacs/mdtypes/inputrec.h"
 #include "gromacs/mdtypes/md_enums.h"
+#include "gromacs/mdtypes/multipletimestepping.h"
 #include "gromacs/mdtypes/pull_params.h"
 #include "gromacs/options/options.h"
 #include "gromacs/options/treesupport.h"
@@ -103,7 +104,7 @@ struct gmx_inputrec_strings
             frdim[STRLEN], energy[STRLEN], user1[STRLEN], user2[STRLEN], vcm[STRLEN],
             x_compressed_groups[STRLEN], couple_moltype[STRLEN], orirefitgrp[STRLEN],
             egptable[STRLEN], egpexcl[STRLEN], wall_atomtype[STRLEN], wall_density[STRLEN],
-            deform[STRLEN], QMMM[STRLEN], imd_grp[STRLEN];
+            deform[STRLEN], QMMM[STRLEN], imd_grp[STRLEN], mtsLevel2Forces[STRLEN];
     char                     fep_lambda[efptNR][STRLEN];
     char                     lambda_weights[STRLEN];
     std::vector<std::string> pullGroupNames;
@@ -558,6 +559,14 @@ void check_ir(const char*                   mdparin,
             check_nst("nstcalcenergy", ir->nstcalcenergy, "nstenergy", &ir->nstenergy, wi);
         }
 
+        if (ir->useMts)
+        {
+            for (const std::string& mtsErrorMessage : gmx::checkMtsRequirements(*ir))
+            {
+                warning_error(wi, mtsErrorMessage);
+            }
+        }
+
         // Inquire all MdModules, if their parameters match with the energy
         // calculation frequency
         gmx::EnergyCalculationFrequencyErrors energyCalculationFrequencyErrors(ir->nstcalcenergy);
@@ -1883,6 +1892,31 @@ void get_ir(const char*     mdparin,
     printStringNoNewline(
             &inp, "Part index is updated automatically on checkpointing (keeps files separate)");
     ir->simulation_part = get_eint(&inp, "simulation-part", 1, wi);
+    printStringNoNewline(&inp, "Multiple time-stepping");
+    ir->useMts = (get_eeenum(&inp, "mts", yesno_names, wi) != 0);
+    if (ir->useMts)
+    {
+        const int numMtsLevels = get_eint(&inp, "mts-levels", 2, wi);
+        setStringEntry(&inp, "mts-level2-forces", inputrecStrings->mtsLevel2Forces,
+                       "longrange-nonbonded");
+        const int mtsLevel2Factor = get_eint(&inp, "mts-level2-factor", 2, wi);
+
+        // We clear after reading without dynamics to not force the user to remove MTS mdp options
+        if (!EI_DYNAMICS(ir->eI))
+        {
+            ir->useMts = false;
+        }
+        else
+        {
+            std::vector<std::string> errorMessages;
+            ir->mtsLevels = gmx::setupMtsLevels(numMtsLevels, inputrecStrings->mtsLevel2Forces,
+                                                mtsLevel2Factor, &errorMessages);
+            for (const auto& errorMessage : errorMessages)
+            {
+                warning_error(wi, errorMessage.c_str());
+            }
+        }
+    }
     printStringNoNewline(&inp, "mode for center of mass motion removal");
     ir->comm_mode = get_eeenum(&inp, "comm-mode", ecm_names, wi);
     printStringNoNewline(&inp, "number of steps for center of mass motion removal");
@@ -221,5 +221,18 @@ TEST_F(GetIrTest, AcceptsMimic)
     runTest(joinStrings(inputMdpFile, "\n"));
 }
 
+TEST_F(GetIrTest, AcceptsMultipleTimeStepping)
+{
+    const char* inputMdpFile[] = { "coulombtype = pme", "mts = yes",
+                                   "mts-level2-forces = longrange-nonbonded dihedral" };
+    runTest(joinStrings(inputMdpFile, "\n"));
+}
+
+TEST_F(GetIrTest, RejectsMultipleTimeSteppingWithIncompatibleIntervals)
+{
+    const char* inputMdpFile[] = { "coulombtype = pme", "mts = yes", "mts-level2-factor = 3" };
+    runTest(joinStrings(inputMdpFile, "\n"));
+}
+
 } // namespace test
 } // namespace gmx
@@ -39,7 +39,15 @@
 
 #include "eigensolver.h"
 
+#include <cmath>
+
+#include <algorithm>
+#include <vector>
+
+#include "gromacs/linearalgebra/matrix.h"
 #include "gromacs/linearalgebra/sparsematrix.h"
+#include "gromacs/random/normaldistribution.h"
+#include "gromacs/random/threefry.h"
 #include "gromacs/utility/fatalerror.h"
 #include "gromacs/utility/real.h"
 #include "gromacs/utility/smalloc.h"
@@ -250,7 +258,18 @@ void sparse_parallel_eigensolver(gmx_sparsematrix_t* A, int neig, real* eigenval
 #endif
 
 
-void sparse_eigensolver(gmx_sparsematrix_t* A, int neig, real* eigenvalues, real* eigenvectors, int maxiter)
+/* Determines the neig eigenvalues at the end of the spectrum selected by
+ * which, "SA" for the smallest and "LA" for the largest, with the implicitly
+ * restarted Lanczos method in ARPACK. multiply(x, y) should set y to the
+ * product of the n x n matrix with x.
+ */
+static void arpack_eigensolver(int                                      n,
+                               int                                      neig,
+                               const char*                              which,
+                               const std::function<void(real*, real*)>& multiply,
+                               real*                                    eigenvalues,
+                               real*                                    eigenvectors,
+                               int                                      maxiter)
 {
     int   iwork[80];
     int   iparam[11];
@@ -259,21 +278,11 @@ void sparse_eigensolver(gmx_sparsematrix_t* A, int neig, real* eigenvalues, real
     real* workd;
     real* workl;
     real* v;
-    int   n;
     int   ido, info, lworkl, i, ncv, dovec;
     real  abstol;
     int*  select;
     int   iter;
 
-#ifdef GMX_MPI_NOT
-    MPI_Comm_size(MPI_COMM_WORLD, &n);
-    if (n > 1)
-    {
-        sparse_parallel_eigensolver(A, neig, eigenvalues, eigenvectors, maxiter);
-        return;
-    }
-#endif
-
     if (eigenvectors != nullptr)
     {
         dovec = 1;
@@ -283,7 +292,6 @@ void sparse_eigensolver(gmx_sparsematrix_t* A, int neig, real* eigenvalues, real
         dovec = 0;
     }
 
-    n   = A->nrow;
     ncv = 2 * neig;
 
     if (ncv > n)
@@ -318,16 +326,16 @@ void sparse_eigensolver(gmx_sparsematrix_t* A, int neig, real* eigenvalues, real
     {
 #if GMX_DOUBLE
         F77_FUNC(dsaupd, DSAUPD)
-        (&ido, "I", &n, "SA", &neig, &abstol, resid, &ncv, v, &n, iparam, ipntr, workd, iwork,
+        (&ido, "I", &n, which, &neig, &abstol, resid, &ncv, v, &n, iparam, ipntr, workd, iwork,
          workl, &lworkl, &info);
 #else
         F77_FUNC(ssaupd, SSAUPD)
-        (&ido, "I", &n, "SA", &neig, &abstol, resid, &ncv, v, &n, iparam, ipntr, workd, iwork,
+        (&ido, "I", &n, which, &neig, &abstol, resid, &ncv, v, &n, iparam, ipntr, workd, iwork,
          workl, &lworkl, &info);
 #endif
         if (ido == -1 || ido == 1)
         {
-            gmx_sparsematrix_vector_multiply(A, workd + ipntr[0] - 1, workd + ipntr[1] - 1);
+            multiply(workd + ipntr[0] - 1, workd + ipntr[1] - 1);
         }
 
         fprintf(stderr, "\rIteration %4d: %3d out of %3d Ritz values converged.", iter++, iparam[4], neig);
@@ -353,11 +361,11 @@ void sparse_eigensolver(gmx_sparsematrix_t* A, int neig, real* eigenvalues, real
 
 #if GMX_DOUBLE
     F77_FUNC(dseupd, DSEUPD)
-    (&dovec, "A", select, eigenvalues, eigenvectors, &n, nullptr, "I", &n, "SA", &neig, &abstol,
+    (&dovec, "A", select, eigenvalues, eigenvectors, &n, nullptr, "I", &n, which, &neig, &abstol,
      resid, &ncv, v, &n, iparam, ipntr, workd, workl, &lworkl, &info);
 #else
     F77_FUNC(sseupd, SSEUPD)
-    (&dovec, "A", select, eigenvalues, eigenvectors, &n, nullptr, "I", &n, "SA", &neig, &abstol,
+    (&dovec, "A", select, eigenvalues, eigenvectors, &n, nullptr, "I", &n, which, &neig, &abstol,
      resid, &ncv, v, &n, iparam, ipntr, workd, workl, &lworkl, &info);
 #endif
 
@@ -367,3 +375,194 @@ void sparse_eigensolver(gmx_sparsematrix_t* A, int neig, real* eigenvalues, real
     sfree(workl);
     sfree(select);
 }
+
+void sparse_eigensolver(gmx_sparsematrix_t* A, int neig, real* eigenvalues, real* eigenvectors, int maxiter)
+{
+#ifdef GMX_MPI_NOT
+    int n;
+    MPI_Comm_size(MPI_COMM_WORLD, &n);
+    if (n > 1)
+    {
+        sparse_parallel_eigensolver(A, neig, eigenvalues, eigenvectors, maxiter);
+        return;
+    }
+#endif
+
+    arpack_eigensolver(
+            A->nrow, neig, "SA",
+            [A](real* x, real* y) { gmx_sparsematrix_vector_multiply(A, x, y); },
+            eigenvalues, eigenvectors, maxiter);
+}
+
+void lanczos_eigensolver(const real* a, int n, int neig, real* eigenvalues, real* eigenvectors, int maxiter)
+{
+    if (2 * neig > n)
+    {
+        /* Too many eigenvalues for Lanczos to pay off */
+        std::vector<real> acopy(a, a + static_cast<size_t>(n) * n);
+        std::vector<real> allvalues(n);
+        eigensolver(acopy.data(), n, n - neig, n, allvalues.data(), eigenvectors);
+        std::copy(allvalues.begin(), allvalues.begin() + neig, eigenvalues);
+        return;
+    }
+
+    /* The bundled ARPACK is only used and tested for the smallest eigenvalues,
+     * so we compute those of -A and flip the signs and order afterwards.
+     */
+    arpack_eigensolver(
+            n, neig, "SA",
+            [a, n](real* x, real* y) { symmetric_matrix_vector_product(n, -1, a, x, y); },
+            eigenvalues, eigenvectors, maxiter);
+
+    for (int i = 0; i < neig; i++)
+    {
+        eigenvalues[i] = -eigenvalues[i];
+    }
+    std::reverse(eigenvalues, eigenvalues + neig);
+    if (eigenvectors != nullptr)
+    {
+        for (int i = 0; i < neig / 2; i++)
+        {
+            std::swap_ranges(eigenvectors + static_cast<size_t>(i) * n,
+                             eigenvectors + static_cast<size_t>(i + 1) * n,
+                             eigenvectors + static_cast<size_t>(neig - 1 - i) * n);
+        }
+    }
+}
+
+//! Seed for the random start vectors, fixed to make results reproducible
+static const uint64_t c_randomizedEigensolverSeed = 0x65696773766c7672;
+
+/* Makes the nvec columns of length n in v orthonormal with two passes of
+ * modified Gram-Schmidt, replacing columns that are linearly dependent on
+ * the previous ones by random vectors.
+ */
+static void orthonormalize(int n, int nvec, real* v, gmx::DefaultRandomEngine* rng)
+{
+    gmx::NormalDistribution<real> normalDist;
+
+    for (int k = 0; k < nvec; k++)
+    {
+        real* vk = v + static_cast<size_t>(k) * n;
+        for (int attempt = 0;; attempt++)
+        {
+            double norm2Start = 0;
+            for (int r = 0; r < n; r++)
+            {
+                norm2Start += vk[r] * static_cast<double>(vk[r]);
+            }
+            for (int pass = 0; pass < 2; pass++)
+            {
+                for (int l = 0; l < k; l++)
+                {
+                    const real* vl  = v + static_cast<size_t>(l) * n;
+                    double      dot = 0;
+                    for (int r = 0; r < n; r++)
+                    {
+                        dot += vk[r] * static_cast<double>(vl[r]);
+                    }
+                    for (int r = 0; r < n; r++)
+                    {
+                        vk[r] -= dot * vl[r];
+                    }
+                }
+            }
+            double norm2 = 0;
+            for (int r = 0; r < n; r++)
+            {
+                norm2 += vk[r] * static_cast<double>(vk[r]);
+            }
+            if (norm2 > 1e-8 * norm2Start && norm2 > 0)
+            {
+                const double invNorm = 1 / std::sqrt(norm2);
+                for (int r = 0; r < n; r++)
+                {
+                    vk[r] *= invNorm;
+                }
+                break;
+            }
+            if (attempt == 10)
+            {
+                gmx_fatal(FARGS, "Could not construct %d orthogonal vectors of length %d", nvec, n);
+            }
+            for (int r = 0; r < n; r++)
+            {
+                vk[r] = normalDist(*rng);
+            }
+        }
+    }
+}
+
+void randomized_eigensolver(int                                                 n,
+                            int                                                 neig,
+                            int                                                 niter,
+                            const std::function<void(int, const real*, real*)>& multiply,
+                            real*                                               eigenvalues,
+                            real*                                               eigenvectors)
+{
+    /* Oversampling of the subspace improves the accuracy of the last eigenpairs */
+    const int nvec = std::min(n, neig + 10);
+
+    gmx::DefaultRandomEngine      rng(c_randomizedEigensolverSeed);
+    gmx::NormalDistribution<real> normalDist;
+
+    std::vector<real> q(static_cast<size_t>(n) * nvec);
+    std::vector<real> y(q.size());
+    for (real& value : q)
+    {
+        value = normalDist(rng);
+    }
+    orthonormalize(n, nvec, q.data(), &rng);
+    for (int iter = 0; iter < niter; iter++)
+    {
+        fprintf(stderr, "Subspace iteration %d of %d\n", iter + 1, niter);
+        multiply(nvec, q.data(), y.data());
+        q.swap(y);
+        orthonormalize(n, nvec, q.data(), &rng);
+    }
+
+    /* Rayleigh-Ritz projection of the matrix onto the subspace */
+    multiply(nvec, q.data(), y.data());
+    std::vector<real> b(nvec * nvec);
+    for (int k = 0; k < nvec; k++)
+    {
+        for (int l = 0; l <= k; l++)
+        {
+            const real* qk  = q.data() + static_cast<size_t>(k) * n;
+            const real* ql  = q.data() + static_cast<size_t>(l) * n;
+            const real* yk  = y.data() + static_cast<size_t>(k) * n;
+            const real* yl  = y.data() + static_cast<size_t>(l) * n;
+            double      qky = 0;
+            double      qly = 0;
+            for (int r = 0; r < n; r++)
+            {
+                qky += qk[r] * static_cast<double>(yl[r]);
+                qly += ql[r] * static_cast<double>(yk[r]);
+            }
+            b[k * nvec + l] = 0.5 * (qky + qly);
+            b[l * nvec + k] = b[k * nvec + l];
+        }
+    }
+    std::vector<real> bvalues(nvec);
+    std::vector<real> bvectors(nvec * neig);
+    eigensolver(b.data(), nvec, nvec - neig, nvec, bvalues.data(), bvectors.data());
+
+    std::copy(bvalues.begin(), bvalues.begin() + neig, eigenvalues);
+    if (eigenvectors != nullptr)
+    {
+        for (int k = 0; k < neig; k++)
+        {
+            real* vk = eigenvectors + static_cast<size_t>(k) * n;
+            std::fill(vk, vk + n, 0);
+            for (int l = 0; l < nvec; l++)
+            {
+                const real  c  = bvectors[k * nvec + l];
+                const real* ql = q.data() + static_cast<size_t>(l) * n;
+                for (int r = 0; r < n; r++)
+                {
+                    vk[r] += c * ql[r];
+                }
+            }
+        }
+    }
+}
@@ -37,6 +37,8 @@
 #ifndef GMX_LINEARALGEBRA_EIGENSOLVER_H
 #define GMX_LINEARALGEBRA_EIGENSOLVER_H
 
+#include <functional>
+
 #include "gromacs/linearalgebra/sparsematrix.h"
 #include "gromacs/utility/real.h"
 
@@ -75,4 +77,35 @@ void eigensolver(real* a, int n, int index_lower, int index_upper, real* eigenva
  */
 void sparse_eigensolver(gmx_sparsematrix_t* A, int neig, real* eigenvalues, real* eigenvectors, int maxiter);
 
+/*! \brief Lanczos eigensolver for the largest eigenvalues of a dense matrix.
+ *
+ *  Determines the neig largest eigenvalues of the symmetric n x n matrix a,
+ *  of which only the lower triangle (in Fortran order) is used, with the
+ *  same ARPACK routines as sparse_eigensolver(). This is much faster than
+ *  eigensolver() when only a few eigenvectors are needed of a large matrix.
+ *  The eigenvalues are returned in ascending order, the eigenvectors, when
+ *  the pointer is non-NULL, as rows of length n.
+ */
+void lanczos_eigensolver(const real* a, int n, int neig, real* eigenvalues, real* eigenvectors, int maxiter);
+
+/*! \brief Randomized eigensolver for the largest eigenvalues of a matrix
+ *  that is only known through its products with vectors.
+ *
+ *  Determines approximations of the neig largest eigenvalues of a symmetric
+ *  positive semi-definite n x n matrix by subspace iteration, starting
+ *  from a block of random vectors that is a few vectors larger than neig.
+ *  multiply(nvec, v, av) should store in av the products of the matrix with
+ *  the nvec vectors of length n stored consecutively in v. It is called
+ *  niter + 1 times. The accuracy improves quickly with niter, in particular
+ *  when the eigenvalues decay slowly.
+ *  The eigenvalues are returned in ascending order, the eigenvectors, when
+ *  the pointer is non-NULL, as rows of length n.
+ */
+void randomized_eigensolver(int                                                 n,
+                            int                                                 neig,
+                            int                                                 niter,
+                            const std::function<void(int, const real*, real*)>& multiply,
+                            real*                                               eigenvalues,
+                            real*                                               eigenvectors);
+
 #endif
@@ -154,6 +154,17 @@ extern "C"
                                   double*     c,
                                   int*        ldc);
 
+    void F77_FUNC(dsyrk, DSYRK)(const char* uplo,
+                                const char* trans,
+                                int*        n,
+                                int*        k,
+                                double*     alpha,
+                                double*     a,
+                                int*        lda,
+                                double*     beta,
+                                double*     c,
+                                int*        ldc);
+
     void F77_FUNC(dtrmm, DTRMM)(const char* side,
                                 const char* uplo,
                                 const char* transa,
@@ -270,6 +281,17 @@ extern "C"
                                   float*      c,
                                   int*        ldc);
 
+    void F77_FUNC(ssyrk, SSYRK)(const char* uplo,
+                                const char* trans,
+                                int*        n,
+                                int*        k,
+                                float*      alpha,
+                                float*      a,
+                                int*        lda,
+                                float*      beta,
+                                float*      c,
+                                int*        ldc);
+
     void F77_FUNC(strmm, STRMM)(const char* side,
                                 const char* uplo,
                                 const char* transa,
@@ -41,11 +41,16 @@
 
 #include "config.h"
 
+#include <cstdint>
 #include <stdio.h>
 
+#include <algorithm>
+#include <limits>
+
 #include "gromacs/utility/fatalerror.h"
 #include "gromacs/utility/smalloc.h"
 
+#include "gmx_blas.h"
 #include "gmx_lapack.h"
 
 double** alloc_matrix(int n, int m)
@@ -247,3 +252,112 @@ double multi_regression(FILE* fp, int nrow, double* y, int ncol, double** xx, do
 
     return chi2;
 }
+
+/* Returns the number of columns of an n x n matrix that can be passed to
+ * a BLAS routine at once, such that the 32-bit index arithmetic inside the
+ * routine does not overflow. A positive maxPanelWidth limits the width.
+ */
+static int blasPanelWidth(int n, int maxPanelWidth)
+{
+    const int64_t maxElements = std::numeric_limits<int>::max();
+
+    if (maxPanelWidth > 0 && static_cast<int64_t>(maxPanelWidth) * n <= maxElements)
+    {
+        return maxPanelWidth;
+    }
+    else if (static_cast<int64_t>(n) * n <= maxElements)
+    {
+        return n;
+    }
+    else
+    {
+        return std::max(1, static_cast<int>(maxElements / n) - 1);
+    }
+}
+
+void symmetric_rank_k_update(int n, int k, const real* a, real* c, int maxPanelWidth)
+{
+    real one        = 1;
+    int  panelWidth = blasPanelWidth(n, maxPanelWidth);
+
+    /* The upper triangle in C order is the lower triangle in Fortran order.
+     * For large n we process panels of columns, with 64-bit offsets computed
+     * here: syrk for the diagonal block and gemm for the block below it.
+     */
+    for (int j0 = 0; j0 < n; j0 += panelWidth)
+    {
+        int   width  = std::min(panelWidth, n - j0);
+        int   m      = n - j0 - width;
+        real* aj     = const_cast<real*>(a) + j0;
+        real* ai     = aj + width;
+        real* cDiag  = c + static_cast<int64_t>(j0) * n + j0;
+        real* cBelow = cDiag + width;
+        int   ld     = n;
+#if GMX_DOUBLE
+        F77_FUNC(dsyrk, DSYRK)("L", "N", &width, &k, &one, aj, &ld, &one, cDiag, &ld);
+        if (m > 0)
+        {
+            F77_FUNC(dgemm, DGEMM)
+            ("N", "T", &m, &width, &k, &one, ai, &ld, aj, &ld, &one, cBelow, &ld);
+        }
+#else
+        F77_FUNC(ssyrk, SSYRK)("L", "N", &width, &k, &one, aj, &ld, &one, cDiag, &ld);
+        if (m > 0)
+        {
+            F77_FUNC(sgemm, SGEMM)
+            ("N", "T", &m, &width, &k, &one, ai, &ld, aj, &ld, &one, cBelow, &ld);
+        }
+#endif
+    }
+}
+
+void symmetric_matrix_vector_product(int         n,
+                                     real        alpha,
+                                     const real* c,
+                                     const real* x,
+                                     real*       y,
+                                     int         maxPanelWidth)
+{
+    real one        = 1;
+    int  inc        = 1;
+    int  panelWidth = blasPanelWidth(n, maxPanelWidth);
+
+    for (int i = 0; i < n; i++)
+    {
+        y[i] = 0;
+    }
+    /* As in symmetric_rank_k_update(), we only use the lower triangle in
+     * Fortran order and process panels of columns for large n. The block
+     * below the diagonal block contributes to y through both the block
+     * and its transpose.
+     */
+    for (int j0 = 0; j0 < n; j0 += panelWidth)
+    {
+        int   width  = std::min(panelWidth, n - j0);
+        int   m      = n - j0 - width;
+        real* xj     = const_cast<real*>(x) + j0;
+        real* xi     = xj + width;
+        real* cDiag  = const_cast<real*>(c) + static_cast<int64_t>(j0) * n + j0;
+        real* cBelow = cDiag + width;
+        int   ld     = n;
+#if GMX_DOUBLE
+        F77_FUNC(dsymv, DSYMV)("L", &width, &alpha, cDiag, &ld, xj, &inc, &one, y + j0, &inc);
+        if (m > 0)
+        {
+            F77_FUNC(dgemv, DGEMV)
+            ("N", &m, &width, &alpha, cBelow, &ld, xj, &inc, &one, y + j0 + width, &inc);
+            F77_FUNC(dgemv, DGEMV)
+            ("T", &m, &width, &alpha, cBelow, &ld, xi, &inc, &one, y + j0, &inc);
+        }
+#else
+        F77_FUNC(ssymv, SSYMV)("L", &width, &alpha, cDiag, &ld, xj, &inc, &one, y + j0, &inc);
+        if (m > 0)
+        {
+            F77_FUNC(sgemv, SGEMV)
+            ("N", &m, &width, &alpha, cBelow, &ld, xj, &inc, &one, y + j0 + width, &inc);
+            F77_FUNC(sgemv, SGEMV)
+            ("T", &m, &width, &alpha, cBelow, &ld, xi, &inc, &one, y + j0, &inc);
+        }
+#endif
+    }
+}
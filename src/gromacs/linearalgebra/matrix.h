@@ -39,6 +39,8 @@
 
 #include <stdio.h>
 
+#include "gromacs/utility/real.h"
+
 double** alloc_matrix(int n, int m);
 
 void free_matrix(double** a);
@@ -58,4 +60,26 @@ double multi_regression(FILE* fp, int ny, double* y, int nx, double** xx, double
  * If fp is not NULL debug information will be written to it.
  */
 
+void symmetric_rank_k_update(int n, int k, const real* a, real* c, int maxPanelWidth = 0);
+/* Adds a a^T to the n x n matrix c, where a holds k vectors of length n
+ * consecutively in memory. Only the elements c[i*n + j] with j >= i
+ * are updated. This uses the BLAS syrk routine, which with an optimized
+ * BLAS library is much faster than adding k outer products one by one.
+ * Matrices with more than INT_MAX elements are processed in column panels,
+ * a positive maxPanelWidth sets a smaller panel width, for testing.
+ */
+
+void symmetric_matrix_vector_product(int         n,
+                                     real        alpha,
+                                     const real* c,
+                                     const real* x,
+                                     real*       y,
+                                     int         maxPanelWidth = 0);
+/* Sets y to alpha c x, where c is a symmetric n x n matrix of which only
+ * the elements c[i*n + j] with j >= i, as set by symmetric_rank_k_update(),
+ * are used. This uses the BLAS symv and gemv routines and, as
+ * symmetric_rank_k_update(), also works with more than INT_MAX elements.
+ * maxPanelWidth has the same meaning as for symmetric_rank_k_update().
+ */
+
 #endif
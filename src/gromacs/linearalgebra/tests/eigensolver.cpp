@@ -0,0 +1,205 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2021, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Tests for the partial eigensolvers, against the dense LAPACK eigensolver.
+ */
+#include "gmxpre.h"
+
+#include "gromacs/linearalgebra/eigensolver.h"
+
+#include <cmath>
+#include <cstdint>
+
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "gromacs/random/threefry.h"
+#include "gromacs/random/uniformrealdistribution.h"
+
+#include "testutils/testasserts.h"
+
+namespace
+{
+
+//! Size of the test matrices
+const int c_n = 60;
+//! Number of eigenpairs to compute
+const int c_numEigenpairs = 4;
+
+/*! \brief Returns a symmetric positive semi-definite c_n x c_n matrix of rank \p rank
+ *
+ * The matrix is B B^T, where the columns of B are random vectors that are
+ * scaled down with increasing index, which gives a decaying spectrum.
+ */
+std::vector<real> symmetricTestMatrix(int rank)
+{
+    gmx::DefaultRandomEngine           rng(1234);
+    gmx::UniformRealDistribution<real> dist(-1, 1);
+    std::vector<real>                  b(c_n * rank);
+    for (int l = 0; l < rank; l++)
+    {
+        for (int i = 0; i < c_n; i++)
+        {
+            b[l * c_n + i] = dist(rng) / (1 + l);
+        }
+    }
+    std::vector<real> a(c_n * c_n, 0);
+    for (int i = 0; i < c_n; i++)
+    {
+        for (int j = 0; j < c_n; j++)
+        {
+            for (int l = 0; l < rank; l++)
+            {
+                a[i * c_n + j] += b[l * c_n + i] * b[l * c_n + j];
+            }
+        }
+    }
+    return a;
+}
+
+/*! \brief Checks eigenpairs against those of the dense eigensolver
+ *
+ * Both sets are in ascending order. The eigenvectors only need to agree
+ * up to their sign.
+ */
+void checkAgainstDenseEigensolver(const std::vector<real>& a,
+                                  const std::vector<real>& eigenvalues,
+                                  const std::vector<real>& eigenvectors,
+                                  real                     tolerance)
+{
+    std::vector<real> aCopy(a);
+    std::vector<real> refEigenvalues(c_n);
+    std::vector<real> refEigenvectors(c_numEigenpairs * c_n);
+    eigensolver(aCopy.data(), c_n, c_n - c_numEigenpairs, c_n, refEigenvalues.data(),
+                refEigenvectors.data());
+
+    for (int k = 0; k < c_numEigenpairs; k++)
+    {
+        EXPECT_REAL_EQ_TOL(
+                refEigenvalues[k], eigenvalues[k],
+                gmx::test::relativeToleranceAsFloatingPoint(refEigenvalues[k], tolerance))
+                << "for eigenvalue " << k;
+
+        double dot = 0;
+        for (int i = 0; i < c_n; i++)
+        {
+            dot += refEigenvectors[k * c_n + i] * eigenvectors[k * c_n + i];
+        }
+        EXPECT_NEAR(1.0, std::abs(dot), tolerance) << "for eigenvector " << k;
+    }
+}
+
+TEST(LanczosEigensolverTest, MatchesDenseEigensolver)
+{
+    const std::vector<real> a = symmetricTestMatrix(c_n);
+    std::vector<real>       eigenvalues(c_numEigenpairs);
+    std::vector<real>       eigenvectors(c_numEigenpairs * c_n);
+
+    lanczos_eigensolver(a.data(), c_n, c_numEigenpairs, eigenvalues.data(), eigenvectors.data(),
+                        10000);
+
+    checkAgainstDenseEigensolver(a, eigenvalues, eigenvectors, 1e-4);
+}
+
+TEST(LanczosEigensolverTest, MatchesDenseEigensolverForManyEigenpairs)
+{
+    // With more than half of the eigenpairs the dense solver is used internally
+    const int               n = 2 * c_numEigenpairs - 1;
+    const std::vector<real> a = symmetricTestMatrix(c_n);
+    std::vector<real>       aSmall(n * n);
+    for (int i = 0; i < n; i++)
+    {
+        for (int j = 0; j < n; j++)
+        {
+            aSmall[i * n + j] = a[i * c_n + j];
+        }
+    }
+    std::vector<real> eigenvalues(c_numEigenpairs);
+    lanczos_eigensolver(aSmall.data(), n, c_numEigenpairs, eigenvalues.data(), nullptr, 10000);
+
+    std::vector<real> refEigenvalues(n);
+    eigensolver(aSmall.data(), n, 0, n, refEigenvalues.data(), nullptr);
+    for (int k = 0; k < c_numEigenpairs; k++)
+    {
+        EXPECT_REAL_EQ_TOL(refEigenvalues[n - c_numEigenpairs + k], eigenvalues[k],
+                           gmx::test::relativeToleranceAsFloatingPoint(1, 1e-5))
+                << "for eigenvalue " << k;
+    }
+}
+
+//! Tests the randomized eigensolver for a matrix of rank \p rank
+void testRandomizedEigensolver(int rank, int numIterations, real tolerance)
+{
+    const std::vector<real> a = symmetricTestMatrix(rank);
+    std::vector<real>       eigenvalues(c_numEigenpairs);
+    std::vector<real>       eigenvectors(c_numEigenpairs * c_n);
+    int                     numMultiplications = 0;
+
+    randomized_eigensolver(c_n, c_numEigenpairs, numIterations,
+                           [&a, &numMultiplications](int nvec, const real* v, real* av) {
+                               for (int k = 0; k < nvec; k++)
+                               {
+                                   for (int i = 0; i < c_n; i++)
+                                   {
+                                       real sum = 0;
+                                       for (int j = 0; j < c_n; j++)
+                                       {
+                                           sum += a[i * c_n + j] * v[k * c_n + j];
+                                       }
+                                       av[k * c_n + i] = sum;
+                                   }
+                               }
+                               numMultiplications++;
+                           },
+                           eigenvalues.data(), eigenvectors.data());
+
+    EXPECT_EQ(numIterations + 1, numMultiplications);
+    checkAgainstDenseEigensolver(a, eigenvalues, eigenvectors, tolerance);
+}
+
+TEST(RandomizedEigensolverTest, IsExactForLowRankMatrix)
+{
+    // After one iteration the oversampled subspace spans the whole range of the matrix
+    testRandomizedEigensolver(8, 1, 1e-4);
+}
+
+TEST(RandomizedEigensolverTest, ConvergesForFullRankMatrix)
+{
+    testRandomizedEigensolver(c_n, 8, 1e-3);
+}
+
+} // namespace
@@ -0,0 +1,175 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2021, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Tests for the symmetric matrix routines in matrix.h.
+ */
+#include "gmxpre.h"
+
+#include "gromacs/linearalgebra/matrix.h"
+
+#include <cstdint>
+
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "gromacs/random/threefry.h"
+#include "gromacs/random/uniformrealdistribution.h"
+#include "gromacs/utility/stringutil.h"
+
+#include "testutils/testasserts.h"
+
+namespace
+{
+
+//! Returns n random values between -1 and 1
+std::vector<real> randomValues(int n, uint64_t seed)
+{
+    gmx::DefaultRandomEngine           rng(seed);
+    gmx::UniformRealDistribution<real> dist(-1, 1);
+    std::vector<real>                  values(n);
+    for (real& value : values)
+    {
+        value = dist(rng);
+    }
+    return values;
+}
+
+//! Tests the rank-k update with a given maximum panel width against a dense reference
+void testRankKUpdate(int n, int k, int maxPanelWidth)
+{
+    SCOPED_TRACE(gmx::formatString("n %d, k %d, panel width %d", n, k, maxPanelWidth));
+
+    const std::vector<real> a = randomValues(n * k, 1234);
+    std::vector<real>       c = randomValues(n * n, 5678);
+    std::vector<real>       reference(c);
+
+    for (int i = 0; i < n; i++)
+    {
+        for (int j = 0; j < n; j++)
+        {
+            for (int l = 0; l < k; l++)
+            {
+                reference[i * n + j] += a[l * n + i] * a[l * n + j];
+            }
+        }
+    }
+
+    std::vector<real> cInitial(c);
+    symmetric_rank_k_update(n, k, a.data(), c.data(), maxPanelWidth);
+
+    const gmx::test::FloatingPointTolerance tolerance = gmx::test::absoluteTolerance(1e-5);
+    for (int i = 0; i < n; i++)
+    {
+        for (int j = 0; j < n; j++)
+        {
+            if (j >= i)
+            {
+                EXPECT_REAL_EQ_TOL(reference[i * n + j], c[i * n + j], tolerance)
+                        << "for element " << i << " " << j;
+            }
+            else
+            {
+                EXPECT_EQ(cInitial[i * n + j], c[i * n + j])
+                        << "element " << i << " " << j << " below the diagonal changed";
+            }
+        }
+    }
+}
+
+TEST(SymmetricRankKUpdateTest, MatchesDenseReference)
+{
+    testRankKUpdate(37, 5, 0);
+    testRankKUpdate(1, 3, 0);
+}
+
+TEST(SymmetricRankKUpdateTest, MatchesDenseReferenceWithColumnPanels)
+{
+    testRankKUpdate(37, 5, 1);
+    testRankKUpdate(37, 5, 8);
+    testRankKUpdate(37, 5, 36);
+}
+
+//! Tests the matrix-vector product with a given maximum panel width against a dense reference
+void testMatrixVectorProduct(int n, int maxPanelWidth)
+{
+    SCOPED_TRACE(gmx::formatString("n %d, panel width %d", n, maxPanelWidth));
+
+    /* Only the upper triangle in C order should be used, so we store
+     * garbage below the diagonal.
+     */
+    std::vector<real>       c = randomValues(n * n, 1234);
+    const std::vector<real> x = randomValues(n, 5678);
+    std::vector<real>       y(n);
+    std::vector<real>       reference(n, 0);
+    const real              alpha = -0.5;
+
+    for (int i = 0; i < n; i++)
+    {
+        for (int j = 0; j < n; j++)
+        {
+            const real cij = (j >= i ? c[i * n + j] : c[j * n + i]);
+            reference[i] += alpha * cij * x[j];
+        }
+        for (int j = 0; j < i; j++)
+        {
+            c[i * n + j] = 1000;
+        }
+    }
+
+    symmetric_matrix_vector_product(n, alpha, c.data(), x.data(), y.data(), maxPanelWidth);
+
+    const gmx::test::FloatingPointTolerance tolerance = gmx::test::absoluteTolerance(1e-5);
+    for (int i = 0; i < n; i++)
+    {
+        EXPECT_REAL_EQ_TOL(reference[i], y[i], tolerance) << "for element " << i;
+    }
+}
+
+TEST(SymmetricMatrixVectorProductTest, MatchesDenseReference)
+{
+    testMatrixVectorProduct(37, 0);
+    testMatrixVectorProduct(1, 0);
+}
+
+TEST(SymmetricMatrixVectorProductTest, MatchesDenseReferenceWithColumnPanels)
+{
+    testMatrixVectorProduct(37, 1);
+    testMatrixVectorProduct(37, 8);
+    testMatrixVectorProduct(37, 36);
+}
+
+} // namespace
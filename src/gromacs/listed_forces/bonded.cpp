@@ -239,18 +239,19 @@ inline void spreadBondForces(const real bondForce,
  *       and zero at the equilibrium distance!
  */
 template<BondedKernelFlavor flavor>
-real morse_bonds(int             nbonds,
-                 const t_iatom   forceatoms[],
-                 const t_iparams forceparams[],
-                 const rvec      x[],
-                 rvec4           f[],
-                 rvec            fshift[],
-                 const t_pbc*    pbc,
-                 real            lambda,
-                 real*           dvdlambda,
-                 const t_mdatoms gmx_unused* md,
-                 t_fcdata gmx_unused* fcd,
-                 int gmx_unused* global_atom_index)
+std::enable_if_t<flavor != BondedKernelFlavor::ForcesSimdWhenAvailable || !GMX_SIMD_HAVE_REAL, real>
+morse_bonds(int             nbonds,
+            const t_iatom   forceatoms[],
+            const t_iparams forceparams[],
+            const rvec      x[],
+            rvec4           f[],
+            rvec            fshift[],
+            const t_pbc*    pbc,
+            real            lambda,
+            real*           dvdlambda,
+            const t_mdatoms gmx_unused* md,
+            t_fcdata gmx_unused* fcd,
+            int gmx_unused* global_atom_index)
 {
     const real one = 1.0;
     const real two = 2.0;
@@ -305,6 +306,107 @@ real morse_bonds(int             nbonds,
     return vtot;
 }
 
+#if GMX_SIMD_HAVE_REAL
+
+/* As morse_bonds, but using SIMD to calculate many bonds at once.
+ * This routines does not calculate energies and shift forces.
+ */
+template<BondedKernelFlavor flavor>
+std::enable_if_t<flavor == BondedKernelFlavor::ForcesSimdWhenAvailable, real>
+morse_bonds(int             nbonds,
+            const t_iatom   forceatoms[],
+            const t_iparams forceparams[],
+            const rvec      x[],
+            rvec4           f[],
+            rvec gmx_unused fshift[],
+            const t_pbc*    pbc,
+            real gmx_unused lambda,
+            real gmx_unused* dvdlambda,
+            const t_mdatoms gmx_unused* md,
+            t_fcdata gmx_unused* fcd,
+            int gmx_unused* global_atom_index)
+{
+    constexpr int                            nfa1 = 3;
+    alignas(GMX_SIMD_ALIGNMENT) std::int32_t ai[GMX_SIMD_REAL_WIDTH];
+    alignas(GMX_SIMD_ALIGNMENT) std::int32_t aj[GMX_SIMD_REAL_WIDTH];
+    alignas(GMX_SIMD_ALIGNMENT) real         coeff[3 * GMX_SIMD_REAL_WIDTH];
+    alignas(GMX_SIMD_ALIGNMENT) real         pbc_simd[9 * GMX_SIMD_REAL_WIDTH];
+
+    set_pbc_simd(pbc, pbc_simd);
+
+    /* nbonds is the number of bonds times nfa1, here we step GMX_SIMD_REAL_WIDTH bonds */
+    for (int i = 0; i < nbonds; i += GMX_SIMD_REAL_WIDTH * nfa1)
+    {
+        /* Collect atoms for GMX_SIMD_REAL_WIDTH bonds.
+         * iu indexes into forceatoms, we should not let iu go beyond nbonds.
+         */
+        int iu = i;
+        for (int s = 0; s < GMX_SIMD_REAL_WIDTH; s++)
+        {
+            const int type = forceatoms[iu];
+            ai[s]          = forceatoms[iu + 1];
+            aj[s]          = forceatoms[iu + 2];
+
+            /* At the end fill the arrays with the last atoms and 0 params */
+            if (i + s * nfa1 < nbonds)
+            {
+                coeff[s]                           = forceparams[type].morse.b0A;
+                coeff[GMX_SIMD_REAL_WIDTH + s]     = forceparams[type].morse.betaA;
+                coeff[GMX_SIMD_REAL_WIDTH * 2 + s] = forceparams[type].morse.cbA;
+
+                if (iu + nfa1 < nbonds)
+                {
+                    iu += nfa1;
+                }
+            }
+            else
+            {
+                coeff[s]                           = 0;
+                coeff[GMX_SIMD_REAL_WIDTH + s]     = 0;
+                coeff[GMX_SIMD_REAL_WIDTH * 2 + s] = 0;
+            }
+        }
+
+        SimdReal xi_S, yi_S, zi_S;
+        SimdReal xj_S, yj_S, zj_S;
+
+        gatherLoadUTranspose<3>(reinterpret_cast<const real*>(x), ai, &xi_S, &yi_S, &zi_S);
+        gatherLoadUTranspose<3>(reinterpret_cast<const real*>(x), aj, &xj_S, &yj_S, &zj_S);
+        SimdReal dx_S = xi_S - xj_S;
+        SimdReal dy_S = yi_S - yj_S;
+        SimdReal dz_S = zi_S - zj_S;
+
+        pbc_correct_dx_simd(&dx_S, &dy_S, &dz_S, pbc_simd);
+
+        const SimdReal b0_S = load<SimdReal>(coeff);
+        const SimdReal be_S = load<SimdReal>(coeff + GMX_SIMD_REAL_WIDTH);
+        const SimdReal cb_S = load<SimdReal>(coeff + 2 * GMX_SIMD_REAL_WIDTH);
+
+        /* Note that we do not take precautions for atoms on top of each other,
+         * as the scalar kernel does not do that either.
+         */
+        const SimdReal dr2_S   = norm2(dx_S, dy_S, dz_S);
+        const SimdReal invdr_S = invsqrt(dr2_S);
+        const SimdReal dr_S    = dr2_S * invdr_S;
+
+        const SimdReal temp_S   = exp(be_S * (b0_S - dr_S));
+        const SimdReal omtemp_S = SimdReal(1.0) - temp_S;
+
+        const SimdReal fbond_S = SimdReal(-2.0) * be_S * temp_S * cb_S * omtemp_S * invdr_S;
+
+        const SimdReal fx_S = fbond_S * dx_S;
+        const SimdReal fy_S = fbond_S * dy_S;
+        const SimdReal fz_S = fbond_S * dz_S;
+
+        transposeScatterIncrU<4>(reinterpret_cast<real*>(f), ai, fx_S, fy_S, fz_S);
+        transposeScatterDecrU<4>(reinterpret_cast<real*>(f), aj, fx_S, fy_S, fz_S);
+    }
+
+    return 0;
+}
+
+#endif // GMX_SIMD_HAVE_REAL
+
 //! \cond
 template<BondedKernelFlavor flavor>
 real cubic_bonds(int             nbonds,
@@ -447,18 +549,19 @@ real harmonic(real kA, real kB, real xA, real xB, real x, real lambda, real* V,
 
 
 template<BondedKernelFlavor flavor>
-real bonds(int             nbonds,
-           const t_iatom   forceatoms[],
-           const t_iparams forceparams[],
-           const rvec      x[],
-           rvec4           f[],
-           rvec            fshift[],
-           const t_pbc*    pbc,
-           real            lambda,
-           real*           dvdlambda,
-           const t_mdatoms gmx_unused* md,
-           t_fcdata gmx_unused* fcd,
-           int gmx_unused* global_atom_index)
+std::enable_if_t<flavor != BondedKernelFlavor::ForcesSimdWhenAvailable || !GMX_SIMD_HAVE_REAL, real>
+bonds(int             nbonds,
+      const t_iatom   forceatoms[],
+      const t_iparams forceparams[],
+      const rvec      x[],
+      rvec4           f[],
+      rvec            fshift[],
+      const t_pbc*    pbc,
+      real            lambda,
+      real*           dvdlambda,
+      const t_mdatoms gmx_unused* md,
+      t_fcdata gmx_unused* fcd,
+      int gmx_unused* global_atom_index)
 {
     int  i, ki, ai, aj, type;
     real dr, dr2, fbond, vbond, vtot;
@@ -493,6 +596,103 @@ real bonds(int             nbonds,
     return vtot;
 }
 
+#if GMX_SIMD_HAVE_REAL
+
+/* As bonds, but using SIMD to calculate many bonds at once.
+ * This routines does not calculate energies and shift forces.
+ */
+template<BondedKernelFlavor flavor>
+std::enable_if_t<flavor == BondedKernelFlavor::ForcesSimdWhenAvailable, real>
+bonds(int             nbonds,
+      const t_iatom   forceatoms[],
+      const t_iparams forceparams[],
+      const rvec      x[],
+      rvec4           f[],
+      rvec gmx_unused fshift[],
+      const t_pbc*    pbc,
+      real gmx_unused lambda,
+      real gmx_unused* dvdlambda,
+      const t_mdatoms gmx_unused* md,
+      t_fcdata gmx_unused* fcd,
+      int gmx_unused* global_atom_index)
+{
+    constexpr int                            nfa1 = 3;
+    alignas(GMX_SIMD_ALIGNMENT) std::int32_t ai[GMX_SIMD_REAL_WIDTH];
+    alignas(GMX_SIMD_ALIGNMENT) std::int32_t aj[GMX_SIMD_REAL_WIDTH];
+    alignas(GMX_SIMD_ALIGNMENT) real         coeff[2 * GMX_SIMD_REAL_WIDTH];
+    alignas(GMX_SIMD_ALIGNMENT) real         pbc_simd[9 * GMX_SIMD_REAL_WIDTH];
+
+    set_pbc_simd(pbc, pbc_simd);
+
+    /* nbonds is the number of bonds times nfa1, here we step GMX_SIMD_REAL_WIDTH bonds */
+    for (int i = 0; i < nbonds; i += GMX_SIMD_REAL_WIDTH * nfa1)
+    {
+        /* Collect atoms for GMX_SIMD_REAL_WIDTH bonds.
+         * iu indexes into forceatoms, we should not let iu go beyond nbonds.
+         */
+        int iu = i;
+        for (int s = 0; s < GMX_SIMD_REAL_WIDTH; s++)
+        {
+            const int type = forceatoms[iu];
+            ai[s]          = forceatoms[iu + 1];
+            aj[s]          = forceatoms[iu + 2];
+
+            /* At the end fill the arrays with the last atoms and 0 params */
+            if (i + s * nfa1 < nbonds)
+            {
+                coeff[s]                       = forceparams[type].harmonic.krA;
+                coeff[GMX_SIMD_REAL_WIDTH + s] = forceparams[type].harmonic.rA;
+
+                if (iu + nfa1 < nbonds)
+                {
+                    iu += nfa1;
+                }
+            }
+            else
+            {
+                coeff[s]                       = 0;
+                coeff[GMX_SIMD_REAL_WIDTH + s] = 0;
+            }
+        }
+
+        SimdReal xi_S, yi_S, zi_S;
+        SimdReal xj_S, yj_S, zj_S;
+
+        gatherLoadUTranspose<3>(reinterpret_cast<const real*>(x), ai, &xi_S, &yi_S, &zi_S);
+        gatherLoadUTranspose<3>(reinterpret_cast<const real*>(x), aj, &xj_S, &yj_S, &zj_S);
+        SimdReal dx_S = xi_S - xj_S;
+        SimdReal dy_S = yi_S - yj_S;
+        SimdReal dz_S = zi_S - zj_S;
+
+        pbc_correct_dx_simd(&dx_S, &dy_S, &dz_S, pbc_simd);
+
+        const SimdReal k_S  = load<SimdReal>(coeff);
+        const SimdReal b0_S = load<SimdReal>(coeff + GMX_SIMD_REAL_WIDTH);
+
+        const SimdReal dr2_S = norm2(dx_S, dy_S, dz_S);
+
+        /* The scalar kernel skips bonds of zero length. Here we mask out
+         * the invsqrt result for those, so their force becomes zero.
+         */
+        const SimdBool nonZero_S = (SimdReal(0.0) < dr2_S);
+        const SimdReal invdr_S   = maskzInvsqrt(dr2_S, nonZero_S);
+        const SimdReal dr_S      = dr2_S * invdr_S;
+
+        const SimdReal fbond_S = k_S * (b0_S - dr_S) * invdr_S;
+
+        const SimdReal fx_S = fbond_S * dx_S;
+        const SimdReal fy_S = fbond_S * dy_S;
+        const SimdReal fz_S = fbond_S * dz_S;
+
+        transposeScatterIncrU<4>(reinterpret_cast<real*>(f), ai, fx_S, fy_S, fz_S);
+        transposeScatterDecrU<4>(reinterpret_cast<real*>(f), aj, fx_S, fy_S, fz_S);
+    }
+
+    return 0;
+}
+
+#endif // GMX_SIMD_HAVE_REAL
+
 template<BondedKernelFlavor flavor>
 real restraint_bonds(int             nbonds,
                      const t_iatom   forceatoms[],
@@ -2103,18 +2303,19 @@ rbdihs(int             nbonds,
 
 
 template<BondedKernelFlavor flavor>
-real idihs(int             nbonds,
-           const t_iatom   forceatoms[],
-           const t_iparams forceparams[],
-           const rvec      x[],
-           rvec4           f[],
-           rvec            fshift[],
-           const t_pbc*    pbc,
-           real            lambda,
-           real*           dvdlambda,
-           const t_mdatoms gmx_unused* md,
-           t_fcdata gmx_unused* fcd,
-           int gmx_unused* global_atom_index)
+std::enable_if_t<flavor != BondedKernelFlavor::ForcesSimdWhenAvailable || !GMX_SIMD_HAVE_REAL, real>
+idihs(int             nbonds,
+      const t_iatom   forceatoms[],
+      const t_iparams forceparams[],
+      const rvec      x[],
+      rvec4           f[],
+      rvec            fshift[],
+      const t_pbc*    pbc,
+      real            lambda,
+      real*           dvdlambda,
+      const t_mdatoms gmx_unused* md,
+      t_fcdata gmx_unused* fcd,
+      int gmx_unused* global_atom_index)
 {
     int  i, type, ai, aj, ak, al;
     int  t1, t2, t3;
@@ -2171,6 +2372,108 @@ real idihs(int             nbonds,
     return vtot;
 }
 
+#if GMX_SIMD_HAVE_REAL
+
+/* As idihs above, but using SIMD to calculate multiple dihedrals at once.
+ * This routines does not calculate energies and shift forces.
+ */
+template<BondedKernelFlavor flavor>
+std::enable_if_t<flavor == BondedKernelFlavor::ForcesSimdWhenAvailable, real>
+idihs(int             nbonds,
+      const t_iatom   forceatoms[],
+      const t_iparams forceparams[],
+      const rvec      x[],
+      rvec4           f[],
+      rvec gmx_unused fshift[],
+      const t_pbc*    pbc,
+      real gmx_unused lambda,
+      real gmx_unused* dvdlambda,
+      const t_mdatoms gmx_unused* md,
+      t_fcdata gmx_unused* fcd,
+      int gmx_unused* global_atom_index)
+{
+    constexpr int                            nfa1 = 5;
+    alignas(GMX_SIMD_ALIGNMENT) std::int32_t ai[GMX_SIMD_REAL_WIDTH];
+    alignas(GMX_SIMD_ALIGNMENT) std::int32_t aj[GMX_SIMD_REAL_WIDTH];
+    alignas(GMX_SIMD_ALIGNMENT) std::int32_t ak[GMX_SIMD_REAL_WIDTH];
+    alignas(GMX_SIMD_ALIGNMENT) std::int32_t al[GMX_SIMD_REAL_WIDTH];
+    alignas(GMX_SIMD_ALIGNMENT) real         coeff[2 * GMX_SIMD_REAL_WIDTH];
+    alignas(GMX_SIMD_ALIGNMENT) real         pbc_simd[9 * GMX_SIMD_REAL_WIDTH];
+
+    const SimdReal pi_S(M_PI);
+    const SimdReal twoPi_S(2 * M_PI);
+
+    set_pbc_simd(pbc, pbc_simd);
+
+    /* nbonds is the number of dihedrals times nfa1, here we step GMX_SIMD_REAL_WIDTH dihs */
+    for (int i = 0; i < nbonds; i += GMX_SIMD_REAL_WIDTH * nfa1)
+    {
+        /* Collect atoms quadruplets for GMX_SIMD_REAL_WIDTH dihedrals.
+         * iu indexes into forceatoms, we should not let iu go beyond nbonds.
+         */
+        int iu = i;
+        for (int s = 0; s < GMX_SIMD_REAL_WIDTH; s++)
+        {
+            const int type = forceatoms[iu];
+            ai[s]          = forceatoms[iu + 1];
+            aj[s]          = forceatoms[iu + 2];
+            ak[s]          = forceatoms[iu + 3];
+            al[s]          = forceatoms[iu + 4];
+
+            /* At the end fill the arrays with the last atoms and 0 params */
+            if (i + s * nfa1 < nbonds)
+            {
+                coeff[s]                       = forceparams[type].harmonic.krA;
+                coeff[GMX_SIMD_REAL_WIDTH + s] = forceparams[type].harmonic.rA;
+
+                if (iu + nfa1 < nbonds)
+                {
+                    iu += nfa1;
+                }
+            }
+            else
+            {
+                coeff[s]                       = 0;
+                coeff[GMX_SIMD_REAL_WIDTH + s] = 0;
+            }
+        }
+
+        SimdReal phi_S, mx_S, my_S, mz_S, nx_S, ny_S, nz_S, nrkj_m2_S, nrkj_n2_S, p_S, q_S;
+
+        /* Caclulate GMX_SIMD_REAL_WIDTH dihedral angles at once */
+        dih_angle_simd(x, ai, aj, ak, al, pbc_simd, &phi_S, &mx_S, &my_S, &mz_S, &nx_S, &ny_S,
+                       &nz_S, &nrkj_m2_S, &nrkj_n2_S, &p_S, &q_S);
+
+        const SimdReal k_S    = load<SimdReal>(coeff);
+        const SimdReal phi0_S = load<SimdReal>(coeff + GMX_SIMD_REAL_WIDTH) * DEG2RAD;
+
+        /* Take phi-phi0 modulo (-pi,pi], as make_dp_periodic does */
+        SimdReal dp_S = phi_S - phi0_S;
+        dp_S          = dp_S - selectByMask(twoPi_S, pi_S <= dp_S);
+        dp_S          = dp_S + selectByMask(twoPi_S, dp_S < -pi_S);
+
+        const SimdReal mddphi_S = -k_S * dp_S;
+        const SimdReal sf_i_S   = mddphi_S * nrkj_m2_S;
+        const SimdReal msf_l_S  = mddphi_S * nrkj_n2_S;
+
+        /* After this m?_S will contain f[i] */
+        mx_S = sf_i_S * mx_S;
+        my_S = sf_i_S * my_S;
+        mz_S = sf_i_S * mz_S;
+
+        /* After this m?_S will contain -f[l] */
+        nx_S = msf_l_S * nx_S;
+        ny_S = msf_l_S * ny_S;
+        nz_S = msf_l_S * nz_S;
+
+        do_dih_fup_noshiftf_simd(ai, aj, ak, al, p_S, q_S, mx_S, my_S, mz_S, nx_S, ny_S, nz_S, f);
+    }
+
+    return 0;
+}
+
+#endif // GMX_SIMD_HAVE_REAL
+
 /*! \brief Computes angle restraints of two different types */
 template<BondedKernelFlavor flavor>
 real low_angres(int             nbonds,
@@ -2408,18 +2711,19 @@ real unimplemented(int gmx_unused nbonds,
 }
 
 template<BondedKernelFlavor flavor>
-real restrangles(int             nbonds,
-                 const t_iatom   forceatoms[],
-                 const t_iparams forceparams[],
-                 const rvec      x[],
-                 rvec4           f[],
-                 rvec            fshift[],
-                 const t_pbc*    pbc,
-                 real gmx_unused lambda,
-                 real gmx_unused* dvdlambda,
-                 const t_mdatoms gmx_unused* md,
-                 t_fcdata gmx_unused* fcd,
-                 int gmx_unused* global_atom_index)
+std::enable_if_t<flavor != BondedKernelFlavor::ForcesSimdWhenAvailable || !GMX_SIMD_HAVE_REAL, real>
+restrangles(int             nbonds,
+            const t_iatom   forceatoms[],
+            const t_iparams forceparams[],
+            const rvec      x[],
+            rvec4           f[],
+            rvec            fshift[],
+            const t_pbc*    pbc,
+            real gmx_unused lambda,
+            real gmx_unused* dvdlambda,
+            const t_mdatoms gmx_unused* md,
+            t_fcdata gmx_unused* fcd,
+            int gmx_unused* global_atom_index)
 {
     int    i, d, ai, aj, ak, type, m;
     int    t1, t2;
@@ -2509,6 +2813,124 @@ real restrangles(int             nbonds,
 }
 
 
+#if GMX_SIMD_HAVE_REAL
+
+/* As restrangles above, but using SIMD to calculate many angles at once.
+ * This routines does not calculate energies and shift forces.
+ */
+template<BondedKernelFlavor flavor>
+std::enable_if_t<flavor == BondedKernelFlavor::ForcesSimdWhenAvailable, real>
+restrangles(int             nbonds,
+            const t_iatom   forceatoms[],
+            const t_iparams forceparams[],
+            const rvec      x[],
+            rvec4           f[],
+            rvec gmx_unused fshift[],
+            const t_pbc*    pbc,
+            real gmx_unused lambda,
+            real gmx_unused* dvdlambda,
+            const t_mdatoms gmx_unused* md,
+            t_fcdata gmx_unused* fcd,
+            int gmx_unused* global_atom_index)
+{
+    constexpr int                            nfa1 = 4;
+    alignas(GMX_SIMD_ALIGNMENT) std::int32_t ai[GMX_SIMD_REAL_WIDTH];
+    alignas(GMX_SIMD_ALIGNMENT) std::int32_t aj[GMX_SIMD_REAL_WIDTH];
+    alignas(GMX_SIMD_ALIGNMENT) std::int32_t ak[GMX_SIMD_REAL_WIDTH];
+    alignas(GMX_SIMD_ALIGNMENT) real         coeff[2 * GMX_SIMD_REAL_WIDTH];
+    alignas(GMX_SIMD_ALIGNMENT) real         pbc_simd[9 * GMX_SIMD_REAL_WIDTH];
+
+    set_pbc_simd(pbc, pbc_simd);
+
+    /* nbonds is the number of angles times nfa1, here we step GMX_SIMD_REAL_WIDTH angles */
+    for (int i = 0; i < nbonds; i += GMX_SIMD_REAL_WIDTH * nfa1)
+    {
+        /* Collect atoms for GMX_SIMD_REAL_WIDTH angles.
+         * iu indexes into forceatoms, we should not let iu go beyond nbonds.
+         */
+        int iu = i;
+        for (int s = 0; s < GMX_SIMD_REAL_WIDTH; s++)
+        {
+            const int type = forceatoms[iu];
+            ai[s]          = forceatoms[iu + 1];
+            aj[s]          = forceatoms[iu + 2];
+            ak[s]          = forceatoms[iu + 3];
+
+            /* At the end fill the arrays with the last atoms and 0 params */
+            if (i + s * nfa1 < nbonds)
+            {
+                /* As in compute_factors_restangles(), the equilibrium angle
+                 * is defined between the two bond vectors, hence M_PI - theta0.
+                 */
+                coeff[s] = forceparams[type].harmonic.krA;
+                coeff[GMX_SIMD_REAL_WIDTH + s] =
+                        std::cos(M_PI - forceparams[type].harmonic.rA * DEG2RAD);
+
+                if (iu + nfa1 < nbonds)
+                {
+                    iu += nfa1;
+                }
+            }
+            else
+            {
+                coeff[s]                       = 0;
+                coeff[GMX_SIMD_REAL_WIDTH + s] = 0;
+            }
+        }
+
+        SimdReal xi_S, yi_S, zi_S;
+        SimdReal xj_S, yj_S, zj_S;
+        SimdReal xk_S, yk_S, zk_S;
+
+        gatherLoadUTranspose<3>(reinterpret_cast<const real*>(x), ai, &xi_S, &yi_S, &zi_S);
+        gatherLoadUTranspose<3>(reinterpret_cast<const real*>(x), aj, &xj_S, &yj_S, &zj_S);
+        gatherLoadUTranspose<3>(reinterpret_cast<const real*>(x), ak, &xk_S, &yk_S, &zk_S);
+        SimdReal danx_S = xj_S - xi_S;
+        SimdReal dany_S = yj_S - yi_S;
+        SimdReal danz_S = zj_S - zi_S;
+        SimdReal dpox_S = xk_S - xj_S;
+        SimdReal dpoy_S = yk_S - yj_S;
+        SimdReal dpoz_S = zk_S - zj_S;
+
+        pbc_correct_dx_simd(&danx_S, &dany_S, &danz_S, pbc_simd);
+        pbc_correct_dx_simd(&dpox_S, &dpoy_S, &dpoz_S, pbc_simd);
+
+        const SimdReal k_S     = load<SimdReal>(coeff);
+        const SimdReal cosEq_S = load<SimdReal>(coeff + GMX_SIMD_REAL_WIDTH);
+
+        const SimdReal c_ante_S = norm2(danx_S, dany_S, danz_S);
+        const SimdReal c_cros_S = iprod(danx_S, dany_S, danz_S, dpox_S, dpoy_S, dpoz_S);
+        const SimdReal c_post_S = norm2(dpox_S, dpoy_S, dpoz_S);
+
+        const SimdReal norm_S    = invsqrt(c_ante_S * c_post_S);
+        const SimdReal cos_S     = c_cros_S * norm_S;
+        const SimdReal sin2_S    = SimdReal(1.0) - cos_S * cos_S;
+        const SimdReal invSin2_S = inv(sin2_S);
+
+        const SimdReal ratio_ante_S = c_cros_S * inv(c_ante_S);
+        const SimdReal ratio_post_S = c_cros_S * inv(c_post_S);
+
+        const SimdReal prefactor_S = -k_S * (cos_S - cosEq_S) * norm_S
+                                     * fnma(cos_S, cosEq_S, SimdReal(1.0)) * invSin2_S * invSin2_S;
+
+        const SimdReal f_ix_S = prefactor_S * fms(ratio_ante_S, danx_S, dpox_S);
+        const SimdReal f_iy_S = prefactor_S * fms(ratio_ante_S, dany_S, dpoy_S);
+        const SimdReal f_iz_S = prefactor_S * fms(ratio_ante_S, danz_S, dpoz_S);
+        const SimdReal f_kx_S = prefactor_S * fnma(ratio_post_S, dpox_S, danx_S);
+        const SimdReal f_ky_S = prefactor_S * fnma(ratio_post_S, dpoy_S, dany_S);
+        const SimdReal f_kz_S = prefactor_S * fnma(ratio_post_S, dpoz_S, danz_S);
+
+        transposeScatterIncrU<4>(reinterpret_cast<real*>(f), ai, f_ix_S, f_iy_S, f_iz_S);
+        transposeScatterDecrU<4>(reinterpret_cast<real*>(f), aj, f_ix_S + f_kx_S, f_iy_S + f_ky_S,
+                                 f_iz_S + f_kz_S);
+        transposeScatterIncrU<4>(reinterpret_cast<real*>(f), ak, f_kx_S, f_ky_S, f_kz_S);
+    }
+
+    return 0;
+}
+
+#endif // GMX_SIMD_HAVE_REAL
+
 template<BondedKernelFlavor flavor>
 real restrdihs(int             nbonds,
                const t_iatom   forceatoms[],
@@ -2868,21 +3290,25 @@ int cmap_setup_grid_index(int ip, int grid_spacing, int* ipm1, int* ipp1, int* i
     return ip;
 }
 
-} // namespace
-
-real cmap_dihs(int                 nbonds,
-               const t_iatom       forceatoms[],
-               const t_iparams     forceparams[],
-               const gmx_cmap_t*   cmap_grid,
-               const rvec          x[],
-               rvec4               f[],
-               rvec                fshift[],
-               const struct t_pbc* pbc,
-               real gmx_unused lambda,
-               real gmx_unused* dvdlambda,
-               const t_mdatoms gmx_unused* md,
-               t_fcdata gmx_unused* fcd,
-               int gmx_unused* global_atom_index)
+/*! \brief Compute CMAP dihedral energies and forces
+ *
+ * The energy is computed for all flavors that do not use SIMD.
+ */
+template<BondedKernelFlavor flavor>
+std::enable_if_t<flavor != BondedKernelFlavor::ForcesSimdWhenAvailable || !GMX_SIMD_HAVE_REAL, real>
+cmapDihedrals(int                 nbonds,
+              const t_iatom       forceatoms[],
+              const t_iparams     forceparams[],
+              const gmx_cmap_t*   cmap_grid,
+              const rvec          x[],
+              rvec4               f[],
+              rvec                fshift[],
+              const struct t_pbc* pbc,
+              real gmx_unused lambda,
+              real gmx_unused* dvdlambda,
+              const t_mdatoms gmx_unused* md,
+              t_fcdata gmx_unused* fcd,
+              int gmx_unused* global_atom_index)
 {
     int i, n;
     int ai, aj, ak, al, am;
@@ -3213,7 +3639,7 @@ real cmap_dihs(int                 nbonds,
         }
 
         /* Shift forces */
-        if (fshift != nullptr)
+        if (computeVirial(flavor))
         {
             if (pbc)
             {
@@ -3240,6 +3666,279 @@ real cmap_dihs(int                 nbonds,
     return vtot;
 }
 
+#if GMX_SIMD_HAVE_REAL
+
+/* As cmapDihedrals above, but using SIMD to calculate multiple CMAP torsion pairs at once.
+ * The dihedral angles, the bicubic interpolation and the forces use SIMD,
+ * only the grid lookup is done per lane.
+ * This routine does not calculate energies and shift forces.
+ */
+template<BondedKernelFlavor flavor>
+std::enable_if_t<flavor == BondedKernelFlavor::ForcesSimdWhenAvailable, real>
+cmapDihedrals(int                 nbonds,
+              const t_iatom       forceatoms[],
+              const t_iparams     forceparams[],
+              const gmx_cmap_t*   cmap_grid,
+              const rvec          x[],
+              rvec4               f[],
+              rvec gmx_unused     fshift[],
+              const struct t_pbc* pbc,
+              real gmx_unused lambda,
+              real gmx_unused* dvdlambda,
+              const t_mdatoms gmx_unused* md,
+              t_fcdata gmx_unused* fcd,
+              int gmx_unused* global_atom_index)
+{
+    constexpr int                            nfa1 = 6;
+    alignas(GMX_SIMD_ALIGNMENT) std::int32_t ai[GMX_SIMD_REAL_WIDTH];
+    alignas(GMX_SIMD_ALIGNMENT) std::int32_t aj[GMX_SIMD_REAL_WIDTH];
+    alignas(GMX_SIMD_ALIGNMENT) std::int32_t ak[GMX_SIMD_REAL_WIDTH];
+    alignas(GMX_SIMD_ALIGNMENT) std::int32_t al[GMX_SIMD_REAL_WIDTH];
+    alignas(GMX_SIMD_ALIGNMENT) std::int32_t am[GMX_SIMD_REAL_WIDTH];
+    int                                      cmapType[GMX_SIMD_REAL_WIDTH];
+    alignas(GMX_SIMD_ALIGNMENT) real         phi1[GMX_SIMD_REAL_WIDTH];
+    alignas(GMX_SIMD_ALIGNMENT) real         phi2[GMX_SIMD_REAL_WIDTH];
+    alignas(GMX_SIMD_ALIGNMENT) real         tt[GMX_SIMD_REAL_WIDTH];
+    alignas(GMX_SIMD_ALIGNMENT) real         tu[GMX_SIMD_REAL_WIDTH];
+    alignas(GMX_SIMD_ALIGNMENT) real         tx[16 * GMX_SIMD_REAL_WIDTH];
+    alignas(GMX_SIMD_ALIGNMENT) real         pbc_simd[9 * GMX_SIMD_REAL_WIDTH];
+
+    const int gridSpacing = cmap_grid->grid_spacing;
+    /* The grid spacing in radians and in degrees */
+    const real dxRad = 2 * M_PI / gridSpacing;
+    const real dxDeg = 360.0 / gridSpacing;
+
+    set_pbc_simd(pbc, pbc_simd);
+
+    /* nbonds is the number of torsion pairs times nfa1, here we step GMX_SIMD_REAL_WIDTH pairs */
+    for (int i = 0; i < nbonds; i += GMX_SIMD_REAL_WIDTH * nfa1)
+    {
+        /* Collect the five atoms for GMX_SIMD_REAL_WIDTH torsion pairs.
+         * iu indexes into forceatoms, we should not let iu go beyond nbonds.
+         */
+        int iu = i;
+        for (int s = 0; s < GMX_SIMD_REAL_WIDTH; s++)
+        {
+            const int type = forceatoms[iu];
+            ai[s]          = forceatoms[iu + 1];
+            aj[s]          = forceatoms[iu + 2];
+            ak[s]          = forceatoms[iu + 3];
+            al[s]          = forceatoms[iu + 4];
+            am[s]          = forceatoms[iu + 5];
+
+            /* At the end fill the arrays with the last atoms and mark the lanes unused */
+            if (i + s * nfa1 < nbonds)
+            {
+                cmapType[s] = forceparams[type].cmap.cmapA;
+
+                if (iu + nfa1 < nbonds)
+                {
+                    iu += nfa1;
+                }
+            }
+            else
+            {
+                cmapType[s] = -1;
+            }
+        }
+
+        SimdReal phi1_S, m1x_S, m1y_S, m1z_S, n1x_S, n1y_S, n1z_S;
+        SimdReal nrkj1_m2_S, nrkj1_n2_S, p1_S, q1_S;
+        SimdReal phi2_S, m2x_S, m2y_S, m2z_S, n2x_S, n2y_S, n2z_S;
+        SimdReal nrkj2_m2_S, nrkj2_n2_S, p2_S, q2_S;
+
+        /* Calculate both torsion angles for GMX_SIMD_REAL_WIDTH pairs at once */
+        dih_angle_simd(x, ai, aj, ak, al, pbc_simd, &phi1_S, &m1x_S, &m1y_S, &m1z_S, &n1x_S,
+                       &n1y_S, &n1z_S, &nrkj1_m2_S, &nrkj1_n2_S, &p1_S, &q1_S);
+        dih_angle_simd(x, aj, ak, al, am, pbc_simd, &phi2_S, &m2x_S, &m2y_S, &m2z_S, &n2x_S,
+                       &n2y_S, &n2z_S, &nrkj2_m2_S, &nrkj2_n2_S, &p2_S, &q2_S);
+
+        store(phi1, phi1_S);
+        store(phi2, phi2_S);
+
+        /* Look up the grid cells, the grid data is not contiguous over the lanes */
+        for (int s = 0; s < GMX_SIMD_REAL_WIDTH; s++)
+        {
+            if (cmapType[s] < 0)
+            {
+                /* Zero grid data gives zero forces for the unused lanes */
+                for (int k = 0; k < 16; k++)
+                {
+                    tx[k * GMX_SIMD_REAL_WIDTH + s] = 0;
+                }
+                tt[s] = 0;
+                tu[s] = 0;
+
+                continue;
+            }
+
+            const real* cmapd = cmap_grid->cmapdata[cmapType[s]].cmap.data();
+
+            real xphi1 = phi1[s] + M_PI;
+            real xphi2 = phi2[s] + M_PI;
+
+            /* Range mangling */
+            if (xphi1 < 0)
+            {
+                xphi1 = xphi1 + 2 * M_PI;
+            }
+            else if (xphi1 >= 2 * M_PI)
+            {
+                xphi1 = xphi1 - 2 * M_PI;
+            }
+
+            if (xphi2 < 0)
+            {
+                xphi2 = xphi2 + 2 * M_PI;
+            }
+            else if (xphi2 >= 2 * M_PI)
+            {
+                xphi2 = xphi2 - 2 * M_PI;
+            }
+
+            int ip1m1, ip1p1, ip1p2;
+            int ip2m1, ip2p1, ip2p2;
+
+            const int iphi1 = cmap_setup_grid_index(static_cast<int>(xphi1 / dxRad), gridSpacing,
+                                                    &ip1m1, &ip1p1, &ip1p2);
+            const int iphi2 = cmap_setup_grid_index(static_cast<int>(xphi2 / dxRad), gridSpacing,
+                                                    &ip2m1, &ip2p1, &ip2p2);
+
+            const int pos[4] = { iphi1 * gridSpacing + iphi2, ip1p1 * gridSpacing + iphi2,
+                                 ip1p1 * gridSpacing + ip2p1, iphi1 * gridSpacing + ip2p1 };
+
+            for (int c = 0; c < 4; c++)
+            {
+                tx[c * GMX_SIMD_REAL_WIDTH + s]        = cmapd[pos[c] * 4];
+                tx[(c + 4) * GMX_SIMD_REAL_WIDTH + s]  = cmapd[pos[c] * 4 + 1] * dxDeg;
+                tx[(c + 8) * GMX_SIMD_REAL_WIDTH + s]  = cmapd[pos[c] * 4 + 2] * dxDeg;
+                tx[(c + 12) * GMX_SIMD_REAL_WIDTH + s] = cmapd[pos[c] * 4 + 3] * dxDeg * dxDeg;
+            }
+
+            tt[s] = (xphi1 * RAD2DEG - iphi1 * dxDeg) / dxDeg;
+            tu[s] = (xphi2 * RAD2DEG - iphi2 * dxDeg) / dxDeg;
+        }
+
+        SimdReal tx_S[16];
+        for (int k = 0; k < 16; k++)
+        {
+            tx_S[k] = load<SimdReal>(tx + k * GMX_SIMD_REAL_WIDTH);
+        }
+
+        /* The coefficient matrix is sparse, so we skip the zero elements */
+        SimdReal tc_S[16];
+        for (int idx = 0; idx < 16; idx++)
+        {
+            tc_S[idx] = setZero();
+            for (int k = 0; k < 16; k++)
+            {
+                if (cmap_coeff_matrix[k * 16 + idx] != 0)
+                {
+                    tc_S[idx] = fma(SimdReal(cmap_coeff_matrix[k * 16 + idx]), tx_S[k], tc_S[idx]);
+                }
+            }
+        }
+
+        const SimdReal tt_S = load<SimdReal>(tt);
+        const SimdReal tu_S = load<SimdReal>(tu);
+        const SimdReal two_S(2.0);
+        const SimdReal three_S(3.0);
+
+        SimdReal df1_S = setZero();
+        SimdReal df2_S = setZero();
+        for (int k = 3; k >= 0; k--)
+        {
+            df1_S = fma(tu_S, df1_S,
+                        fma(fma(three_S * tc_S[k + 12], tt_S, two_S * tc_S[k + 8]), tt_S,
+                            tc_S[k + 4]));
+            df2_S = fma(tt_S, df2_S,
+                        fma(fma(three_S * tc_S[k * 4 + 3], tu_S, two_S * tc_S[k * 4 + 2]), tu_S,
+                            tc_S[k * 4 + 1]));
+        }
+
+        const SimdReal fac_S(RAD2DEG / dxDeg);
+
+        /* As in pdihs, the SIMD force update takes minus the derivative */
+        const SimdReal mddphi1_S = -df1_S * fac_S;
+        const SimdReal mddphi2_S = -df2_S * fac_S;
+
+        /* Forces for the first torsion, m1?_S will contain f[i] and n1?_S -f[l] */
+        const SimdReal sf1_i_S  = mddphi1_S * nrkj1_m2_S;
+        const SimdReal msf1_l_S = mddphi1_S * nrkj1_n2_S;
+        m1x_S                   = sf1_i_S * m1x_S;
+        m1y_S                   = sf1_i_S * m1y_S;
+        m1z_S                   = sf1_i_S * m1z_S;
+        n1x_S                   = msf1_l_S * n1x_S;
+        n1y_S                   = msf1_l_S * n1y_S;
+        n1z_S                   = msf1_l_S * n1z_S;
+
+        do_dih_fup_noshiftf_simd(ai, aj, ak, al, p1_S, q1_S, m1x_S, m1y_S, m1z_S, n1x_S, n1y_S,
+                                 n1z_S, f);
+
+        /* Forces for the second torsion */
+        const SimdReal sf2_i_S  = mddphi2_S * nrkj2_m2_S;
+        const SimdReal msf2_l_S = mddphi2_S * nrkj2_n2_S;
+        m2x_S                   = sf2_i_S * m2x_S;
+        m2y_S                   = sf2_i_S * m2y_S;
+        m2z_S                   = sf2_i_S * m2z_S;
+        n2x_S                   = msf2_l_S * n2x_S;
+        n2y_S                   = msf2_l_S * n2y_S;
+        n2z_S                   = msf2_l_S * n2z_S;
+
+        do_dih_fup_noshiftf_simd(aj, ak, al, am, p2_S, q2_S, m2x_S, m2y_S, m2z_S, n2x_S, n2y_S,
+                                 n2z_S, f);
+    }
+
+    return 0;
+}
+
+#endif // GMX_SIMD_HAVE_REAL
+
+//! Function pointer type for the CMAP kernels
+using CmapFunction = real (*)(int                 nbonds,
+                              const t_iatom       forceatoms[],
+                              const t_iparams     forceparams[],
+                              const gmx_cmap_t*   cmap_grid,
+                              const rvec          x[],
+                              rvec4               f[],
+                              rvec                fshift[],
+                              const struct t_pbc* pbc,
+                              real                lambda,
+                              real*               dvdlambda,
+                              const t_mdatoms*    md,
+                              t_fcdata*           fcd,
+                              int*                global_atom_index);
+
+//! The CMAP kernels for each kernel flavor
+const gmx::EnumerationArray<BondedKernelFlavor, CmapFunction> c_cmapFunctionsPerFlavor = {
+    cmapDihedrals<BondedKernelFlavor::ForcesSimdWhenAvailable>,
+    cmapDihedrals<BondedKernelFlavor::ForcesNoSimd>,
+    cmapDihedrals<BondedKernelFlavor::ForcesAndVirialAndEnergy>,
+    cmapDihedrals<BondedKernelFlavor::ForcesAndEnergy>
+};
+
+} // namespace
+
+real cmap_dihs(int                 nbonds,
+               const t_iatom       forceatoms[],
+               const t_iparams     forceparams[],
+               const gmx_cmap_t*   cmap_grid,
+               const rvec          x[],
+               rvec4               f[],
+               rvec                fshift[],
+               const struct t_pbc* pbc,
+               real                lambda,
+               real*               dvdlambda,
+               const t_mdatoms*    md,
+               t_fcdata*           fcd,
+               int gmx_unused*          global_atom_index,
+               const BondedKernelFlavor bondedKernelFlavor)
+{
+    return c_cmapFunctionsPerFlavor[bondedKernelFlavor](nbonds, forceatoms, forceparams, cmap_grid,
+                                                        x, f, fshift, pbc, lambda, dvdlambda, md,
+                                                        fcd, global_atom_index);
+}
+
 namespace
 {
 
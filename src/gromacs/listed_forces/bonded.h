@@ -106,21 +106,6 @@ void do_dih_fup(int                 i,
 /*! \brief Make a dihedral fall in the range (-pi,pi) */
 void make_dp_periodic(real* dp);
 
-/*! \brief Compute CMAP dihedral energies and forces */
-real cmap_dihs(int                 nbonds,
-               const t_iatom       forceatoms[],
-               const t_iparams     forceparams[],
-               const gmx_cmap_t*   cmap_grid,
-               const rvec          x[],
-               rvec4               f[],
-               rvec                fshift[],
-               const struct t_pbc* pbc,
-               real gmx_unused lambda,
-               real gmx_unused* dvdlambda,
-               const t_mdatoms gmx_unused* md,
-               t_fcdata gmx_unused* fcd,
-               int gmx_unused* global_atom_index);
-
 /*! \brief For selecting which flavor of bonded kernel is used for simple bonded types */
 enum class BondedKernelFlavor
 {
@@ -172,6 +157,25 @@ real calculateSimpleBond(int                 ftype,
                          int gmx_unused*    global_atom_index,
                          BondedKernelFlavor bondedKernelFlavor);
 
+/*! \brief Compute CMAP dihedral energies and forces
+ *
+ * \returns the energy, except for the ForcesSimdWhenAvailable flavor which only computes forces.
+ */
+real cmap_dihs(int                 nbonds,
+               const t_iatom       forceatoms[],
+               const t_iparams     forceparams[],
+               const gmx_cmap_t*   cmap_grid,
+               const rvec          x[],
+               rvec4               f[],
+               rvec                fshift[],
+               const struct t_pbc* pbc,
+               real                lambda,
+               real*               dvdlambda,
+               const t_mdatoms*    md,
+               t_fcdata*           fcd,
+               int gmx_unused*    global_atom_index,
+               BondedKernelFlavor bondedKernelFlavor);
+
 //! Getter for finding the flop count for an \c ftype interaction.
 int nrnbIndex(int ftype);
 
@@ -81,17 +81,89 @@
 #include "manage_threading.h"
 #include "utilities.h"
 
-ListedForces::ListedForces(const int numEnergyGroups, const int numThreads, FILE* fplog) :
+ListedForces::ListedForces(const gmx_ffparams_t&      ffparams,
+                           const int                  numEnergyGroups,
+                           const int                  numThreads,
+                           const InteractionSelection interactionSelection,
+                           FILE*                      fplog) :
+    idefSelection_(ffparams),
     threading_(std::make_unique<bonded_threading_t>(numThreads, numEnergyGroups, fplog)),
-    fcdata_(std::make_unique<t_fcdata>())
+    fcdata_(std::make_unique<t_fcdata>()),
+    interactionSelection_(interactionSelection)
 {
 }
 
+ListedForces::ListedForces(ListedForces&& o) noexcept = default;
+
 ListedForces::~ListedForces() = default;
 
+//! Copies the selected interactions from \p idefSrc to \p idef
+static void selectInteractions(InteractionDefinitions*                  idef,
+                               const InteractionDefinitions&            idefSrc,
+                               const ListedForces::InteractionSelection interactionSelection)
+{
+    const bool selectDihedrals =
+            interactionSelection.test(static_cast<int>(ListedForces::InteractionGroup::Dihedrals));
+    const bool selectRest =
+            interactionSelection.test(static_cast<int>(ListedForces::InteractionGroup::Rest));
+
+    for (int ftype = 0; ftype < F_NRE; ftype++)
+    {
+        const t_interaction_function& ifunc = interaction_function[ftype];
+        if (ifunc.flags & IF_BOND)
+        {
+            bool assign = false;
+            if (ftype >= F_PDIHS && ftype <= F_CMAP)
+            {
+                assign = selectDihedrals;
+            }
+            else
+            {
+                assign = selectRest;
+            }
+            if (assign)
+            {
+                idef->il[ftype] = idefSrc.il[ftype];
+            }
+            else
+            {
+                idef->il[ftype].clear();
+            }
+            idef->numNonperturbedInteractions[ftype] = idefSrc.numNonperturbedInteractions[ftype];
+        }
+    }
+}
+
 void ListedForces::setup(const InteractionDefinitions& idef, const int numAtomsForce, const bool useGpu)
 {
-    idef_ = &idef;
+    if (interactionSelection_.all())
+    {
+        // Avoid the overhead of copying all interaction lists by simply setting the reference
+        idef_ = &idef;
+    }
+    else
+    {
+        idef_ = &idefSelection_;
+
+        selectInteractions(&idefSelection_, idef, interactionSelection_);
+
+        idefSelection_.ilsort = idef.ilsort;
+
+        if (interactionSelection_.test(static_cast<int>(ListedForces::InteractionGroup::Rest)))
+        {
+            idefSelection_.iparams_posres   = idef.iparams_posres;
+            idefSelection_.iparams_fbposres = idef.iparams_fbposres;
+        }
+        else
+        {
+            idefSelection_.iparams_posres.clear();
+            idefSelection_.iparams_fbposres.clear();
+        }
+        if (interactionSelection_.test(static_cast<int>(ListedForces::InteractionGroup::Dihedrals)))
+        {
+            idefSelection_.cmap_grid = idef.cmap_grid;
+        }
+    }
 
     setup_bonded_threading(threading_.get(), numAtomsForce, useGpu, *idef_);
 
@@ -381,7 +453,8 @@ real calc_one_bond(int                           thread,
                wallcycle needs to be extended to support calling from
                multiple threads. */
             v = cmap_dihs(nbn, iatoms.data() + nb0, iparams.data(), &idef.cmap_grid, x, f, fshift,
-                          pbc, lambda[efptFTYPE], &(dvdl[efptFTYPE]), md, fcd, global_atom_index);
+                          pbc, lambda[efptFTYPE], &(dvdl[efptFTYPE]), md, fcd, global_atom_index,
+                          flavor);
         }
         else
         {
@@ -483,6 +556,11 @@ bool ListedForces::haveRestraints() const
     GMX_ASSERT(fcdata_, "Need valid fcdata");
     GMX_ASSERT(fcdata_->orires && fcdata_->disres, "NMR restraints objects should be set up");
 
+    if (!interactionSelection_.test(static_cast<int>(InteractionGroup::Rest)))
+    {
+        return false;
+    }
+
     return (!idef_->il[F_POSRES].empty() || !idef_->il[F_FBPOSRES].empty()
             || fcdata_->orires->nr > 0 || fcdata_->disres->nres > 0);
 }
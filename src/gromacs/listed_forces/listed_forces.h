@@ -69,9 +69,11 @@
 #ifndef GMX_LISTED_FORCES_LISTED_FORCES_H
 #define GMX_LISTED_FORCES_LISTED_FORCES_H
 
+#include <bitset>
 #include <memory>
 
 #include "gromacs/math/vectypes.h"
+#include "gromacs/topology/idef.h"
 #include "gromacs/topology/ifunc.h"
 #include "gromacs/utility/arrayref.h"
 #include "gromacs/utility/basedefinitions.h"
@@ -84,7 +86,6 @@ struct gmx_grppairener_t;
 struct gmx_localtop_t;
 struct gmx_multisim_t;
 class history_t;
-class InteractionDefinitions;
 struct t_commrec;
 struct t_fcdata;
 struct t_forcerec;
@@ -124,18 +125,52 @@ BondedFunction bondedFunction(int ftype);
 class ListedForces
 {
 public:
+    /*! \brief Enum for selecting groups of listed interactions
+     *
+     * Used for computing dihedrals at a different multiple time-stepping
+     * level than the other listed interactions.
+     */
+    enum class InteractionGroup : int
+    {
+        Dihedrals, //!< All dihedral types, including CMAP
+        Rest,      //!< All other listed interactions, including restraints
+        Count      //!< The number of items above
+    };
+
+    //! Type for specifying selections of groups of interaction types
+    using InteractionSelection = std::bitset<static_cast<int>(InteractionGroup::Count)>;
+
+    //! Returns a selection with all listed interaction types selected
+    static InteractionSelection interactionSelectionAll()
+    {
+        InteractionSelection is;
+        return is.flip();
+    }
+
     /*! \brief Constructor
      *
+     * \param[in] ffparams         The force field parameters
      * \param[in] numEnergyGroups  The number of energy groups, used for storage of pair energies
      * \param[in] numThreads       The number of threads used for computed listed interactions
+     * \param[in] interactionSelection  Select of interaction groups through bits set
      * \param[in] fplog            Log file for printing env.var. override, can be nullptr
      */
-    ListedForces(int numEnergyGroups, int numThreads, FILE* fplog);
+    ListedForces(const gmx_ffparams_t& ffparams,
+                 int                   numEnergyGroups,
+                 int                   numThreads,
+                 InteractionSelection  interactionSelection,
+                 FILE*                 fplog);
+
+    //! Move constructor, default, but in the source file to hide implementation classes
+    ListedForces(ListedForces&& o) noexcept;
 
     //! Destructor which is actually default but in the source file to hide implementation classes
     ~ListedForces();
 
     /*! \brief Copy the listed interactions from \p idef and set up the thread parallelization
+     *
+     * When not all interaction groups are selected, only the selected
+     * interactions are copied from \p idef.
      *
      * \param[in] idef           The idef with all listed interactions to be computed on this rank
      * \param[in] numAtomsForce  Force are, potentially, computed for atoms 0 to \p numAtomsForce
@@ -187,8 +222,10 @@ public:
     t_fcdata& fcdata() { return *fcdata_; }
 
 private:
-    //! The interaction definitions
+    //! Pointer to the interaction definitions
     InteractionDefinitions const* idef_ = nullptr;
+    //! Interaction definitions used for storing selections
+    InteractionDefinitions idefSelection_;
     //! Thread parallelization setup, unique_ptr to avoid declaring bonded_threading_t
     std::unique_ptr<bonded_threading_t> threading_;
     //! Data for bonded tables and NMR restraining, needs to be refactored
@@ -197,8 +234,10 @@ private:
     std::vector<real> forceBufferLambda_;
     //! Shift force buffer for free-energy forces
     std::vector<gmx::RVec> shiftForceBufferLambda_;
+    //! Interaction groups to compute
+    InteractionSelection interactionSelection_;
 
-    GMX_DISALLOW_COPY_MOVE_AND_ASSIGN(ListedForces);
+    GMX_DISALLOW_COPY_AND_ASSIGN(ListedForces);
 };
 
 #endif
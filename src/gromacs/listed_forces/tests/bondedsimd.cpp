@@ -0,0 +1,344 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2021, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Tests that the SIMD flavors of the bonded kernels agree with the
+ * plain-C flavors, and benchmarks the two against each other.
+ *
+ * \ingroup module_listed_forces
+ */
+#include "gmxpre.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+
+#include <algorithm>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "gromacs/listed_forces/bonded.h"
+#include "gromacs/math/paddedvector.h"
+#include "gromacs/math/units.h"
+#include "gromacs/math/vec.h"
+#include "gromacs/pbcutil/ishift.h"
+#include "gromacs/pbcutil/pbc.h"
+#include "gromacs/random/threefry.h"
+#include "gromacs/random/uniformrealdistribution.h"
+#include "gromacs/topology/idef.h"
+#include "gromacs/topology/ifunc.h"
+#include "gromacs/utility/arrayref.h"
+
+#include "testutils/testasserts.h"
+
+namespace gmx
+{
+namespace
+{
+
+//! Number of parameter types used for each interaction type
+constexpr int c_numTypes = 3;
+
+//! Number of CMAP grid points along each dimension
+constexpr int c_cmapGridSpacing = 24;
+
+/*! \brief Returns the coordinates of a random chain of \p numAtoms atoms
+ *
+ * Bonds are 0.15 nm and the angles between 70 and 150 degrees, so all
+ * angle and dihedral kernels stay away from their singularities.
+ */
+PaddedVector<RVec> makeChain(int numAtoms)
+{
+    DefaultRandomEngine           rng(1234);
+    UniformRealDistribution<real> dist(-1, 1);
+
+    PaddedVector<RVec> x(numAtoms);
+    x[0] = { 0, 0, 0 };
+    RVec previousBond(0.15, 0, 0);
+    for (int a = 1; a < numAtoms; a++)
+    {
+        RVec bond;
+        real cosAngle;
+        do
+        {
+            bond = { dist(rng), dist(rng), dist(rng) };
+            bond *= 0.15 / norm(bond);
+            // The angle is between the bond vectors pointing away from the middle atom
+            cosAngle = -cos_angle(previousBond, bond);
+        } while (cosAngle > std::cos(70 * DEG2RAD) || cosAngle < std::cos(150 * DEG2RAD));
+        x[a]         = x[a - 1] + bond;
+        previousBond = bond;
+    }
+
+    return x;
+}
+
+//! Returns interactions of type \p ftype between all consecutive atoms of a chain
+std::vector<t_iatom> makeChainInteractions(int ftype, int numAtoms)
+{
+    const int            numAtomsPerInteraction = NRAL(ftype);
+    std::vector<t_iatom> iatoms;
+    for (int a = 0; a + numAtomsPerInteraction <= numAtoms; a++)
+    {
+        iatoms.push_back(a % c_numTypes);
+        for (int i = 0; i < numAtomsPerInteraction; i++)
+        {
+            iatoms.push_back(a + i);
+        }
+    }
+
+    return iatoms;
+}
+
+//! Returns \p c_numTypes parameter sets for \p ftype
+std::vector<t_iparams> makeParameters(int ftype)
+{
+    std::vector<t_iparams> iparams(c_numTypes);
+    for (int t = 0; t < c_numTypes; t++)
+    {
+        t_iparams& ip = iparams[t];
+        switch (ftype)
+        {
+            case F_BONDS:
+                ip.harmonic.rA  = 0.14 + 0.01 * t;
+                ip.harmonic.krA = 2e5 + 1e5 * t;
+                break;
+            case F_MORSE:
+                ip.morse.b0A   = 0.14 + 0.01 * t;
+                ip.morse.cbA   = 300 + 100 * t;
+                ip.morse.betaA = 20 + 5 * t;
+                break;
+            case F_IDIHS:
+                ip.harmonic.rA  = -150 + 120 * t;
+                ip.harmonic.krA = 40 + 30 * t;
+                break;
+            case F_RESTRANGLES:
+                ip.harmonic.rA  = 100 + 15 * t;
+                ip.harmonic.krA = 50 + 25 * t;
+                break;
+            case F_CMAP: ip.cmap.cmapA = t % 2; break;
+            default: GMX_RELEASE_ASSERT(false, "Type not supported in this test");
+        }
+    }
+
+    return iparams;
+}
+
+//! Returns two CMAP grids filled with smooth, different surfaces
+gmx_cmap_t makeCmapGrid()
+{
+    gmx_cmap_t cmapGrid;
+    cmapGrid.grid_spacing = c_cmapGridSpacing;
+    cmapGrid.cmapdata.resize(2);
+    for (int g = 0; g < 2; g++)
+    {
+        std::vector<real>& cmap = cmapGrid.cmapdata[g].cmap;
+        cmap.resize(4 * c_cmapGridSpacing * c_cmapGridSpacing);
+        for (int i = 0; i < c_cmapGridSpacing; i++)
+        {
+            const real phi = 2 * M_PI * i / c_cmapGridSpacing;
+            for (int j = 0; j < c_cmapGridSpacing; j++)
+            {
+                const real psi = 2 * M_PI * j / c_cmapGridSpacing;
+                const int  pos = 4 * (i * c_cmapGridSpacing + j);
+                // V = a cos(phi) sin(n psi) with the derivatives per degree
+                const real a = 5 + 3 * g;
+                const real n = g + 1;
+
+                cmap[pos]     = a * std::cos(phi) * std::sin(n * psi);
+                cmap[pos + 1] = -a * std::sin(phi) * std::sin(n * psi) * DEG2RAD;
+                cmap[pos + 2] = a * n * std::cos(phi) * std::cos(n * psi) * DEG2RAD;
+                cmap[pos + 3] = -a * n * std::sin(phi) * std::cos(n * psi) * DEG2RAD * DEG2RAD;
+            }
+        }
+    }
+
+    return cmapGrid;
+}
+
+//! Everything needed to compute the forces for one interaction type on a chain
+class ChainSystem
+{
+public:
+    //! Sets up the system, with PBC when \p usePbc is true
+    ChainSystem(int ftype, int numAtoms, bool usePbc) :
+        ftype_(ftype),
+        x_(makeChain(numAtoms)),
+        iatoms_(makeChainInteractions(ftype, numAtoms)),
+        iparams_(makeParameters(ftype)),
+        cmapGrid_(makeCmapGrid())
+    {
+        matrix box = { { 2.5, 0, 0 }, { 0, 2.5, 0 }, { 0, 0, 2.5 } };
+        if (usePbc)
+        {
+            put_atoms_in_box(PbcType::Xyz, box, x_);
+        }
+        set_pbc(&pbc_, usePbc ? PbcType::Xyz : PbcType::No, box);
+        pbcPtr_ = usePbc ? &pbc_ : nullptr;
+    }
+
+    /*! \brief Computes the forces with \p flavor and stores them in \p f
+     *
+     * \p f should have 4 reals per atom.
+     */
+    void computeForces(BondedKernelFlavor flavor, std::vector<real>* f)
+    {
+        rvec   fshift[SHIFTS] = { { 0 } };
+        real   dvdlambda      = 0;
+        rvec4* fPtr           = reinterpret_cast<rvec4*>(f->data());
+        if (ftype_ == F_CMAP)
+        {
+            cmap_dihs(iatoms_.size(), iatoms_.data(), iparams_.data(), &cmapGrid_,
+                      as_rvec_array(x_.data()), fPtr, fshift, pbcPtr_, 0, &dvdlambda,
+                      nullptr, nullptr, nullptr, flavor);
+        }
+        else
+        {
+            calculateSimpleBond(ftype_, iatoms_.size(), iatoms_.data(), iparams_.data(),
+                                as_rvec_array(x_.data()), fPtr, fshift, pbcPtr_, 0,
+                                &dvdlambda, nullptr, nullptr, nullptr, flavor);
+        }
+    }
+
+    //! Returns the number of atoms
+    int numAtoms() const { return x_.size(); }
+
+    //! Returns the number of interactions
+    int numInteractions() const { return iatoms_.size() / (1 + NRAL(ftype_)); }
+
+private:
+    int                    ftype_;
+    PaddedVector<RVec>     x_;
+    std::vector<t_iatom>   iatoms_;
+    std::vector<t_iparams> iparams_;
+    gmx_cmap_t             cmapGrid_;
+    t_pbc                  pbc_;
+    const t_pbc*           pbcPtr_;
+};
+
+//! The interaction types that have SIMD kernels tested here
+const int c_ftypesWithSimdKernels[] = { F_BONDS, F_MORSE, F_IDIHS, F_RESTRANGLES, F_CMAP };
+
+class BondedSimdTest : public ::testing::TestWithParam<std::tuple<int, bool>>
+{
+};
+
+TEST_P(BondedSimdTest, SimdForcesMatchPlainForces)
+{
+    const int  ftype  = std::get<0>(GetParam());
+    const bool usePbc = std::get<1>(GetParam());
+    SCOPED_TRACE(std::string("Testing ") + interaction_function[ftype].name
+                 + (usePbc ? " with PBC" : " without PBC"));
+
+    // An odd number of atoms, so the last SIMD batch is only partially filled
+    ChainSystem system(ftype, 203, usePbc);
+
+    std::vector<real> fRef(4 * system.numAtoms(), 0);
+    std::vector<real> fSimd(4 * system.numAtoms(), 0);
+    system.computeForces(BondedKernelFlavor::ForcesNoSimd, &fRef);
+    system.computeForces(BondedKernelFlavor::ForcesSimdWhenAvailable, &fSimd);
+
+    real maxForce = 0;
+    for (const real fComponent : fRef)
+    {
+        maxForce = std::max(maxForce, std::abs(fComponent));
+    }
+    ASSERT_GT(maxForce, 0) << "The test should produce forces";
+
+    // The SIMD kernels use float invsqrt and trigonometry while the plain-C
+    // kernels use library functions and in part double precision.
+    const test::FloatingPointTolerance tolerance =
+            test::relativeToleranceAsPrecisionDependentFloatingPoint(maxForce, 1e-5, 1e-10);
+    for (int a = 0; a < system.numAtoms(); a++)
+    {
+        for (int d = 0; d < DIM; d++)
+        {
+            EXPECT_REAL_EQ_TOL(fRef[4 * a + d], fSimd[4 * a + d], tolerance)
+                    << "for atom " << a << " dimension " << d;
+        }
+    }
+}
+
+INSTANTIATE_TEST_CASE_P(WithAllTypes,
+                        BondedSimdTest,
+                        ::testing::Combine(::testing::ValuesIn(c_ftypesWithSimdKernels),
+                                           ::testing::Bool()));
+
+/*! \brief Prints the time per interaction of the plain-C and SIMD force kernels
+ *
+ * This is not run by default. Run with --gtest_also_run_disabled_tests
+ * and a Release build to compare the kernels.
+ */
+TEST(BondedSimdBenchmark, DISABLED_ComparesSimdAndPlainKernels)
+{
+    constexpr int c_numAtoms   = 100000;
+    constexpr int c_numRepeats = 20;
+    using Clock                = std::chrono::steady_clock;
+
+    std::printf("%-14s %14s %14s %9s\n", "Interaction", "plain (ns)", "SIMD (ns)", "speed-up");
+    for (const int ftype : c_ftypesWithSimdKernels)
+    {
+        ChainSystem       system(ftype, c_numAtoms, true);
+        std::vector<real> f(4 * system.numAtoms(), 0);
+
+        double nsPerInteraction[2];
+        int    flavorIndex = 0;
+        for (const auto flavor :
+             { BondedKernelFlavor::ForcesNoSimd, BondedKernelFlavor::ForcesSimdWhenAvailable })
+        {
+            // Warm up the caches and the branch predictors
+            system.computeForces(flavor, &f);
+
+            const auto start = Clock::now();
+            for (int r = 0; r < c_numRepeats; r++)
+            {
+                system.computeForces(flavor, &f);
+            }
+            const std::chrono::duration<double, std::nano> elapsed = Clock::now() - start;
+
+            nsPerInteraction[flavorIndex++] =
+                    elapsed.count() / (c_numRepeats * system.numInteractions());
+        }
+        std::printf("%-14s %14.2f %14.2f %9.2f\n", interaction_function[ftype].name,
+                    nsPerInteraction[0], nsPerInteraction[1],
+                    nsPerInteraction[0] / nsPerInteraction[1]);
+    }
+}
+
+} // namespace
+} // namespace gmx
@@ -1082,6 +1082,8 @@ Constraints::Impl::Impl(const gmx_mtop_t&     mtop_p,
             }
 
             shaked = std::make_unique<shakedata>();
+            /* SHAKE blocks are divided over the same threads as LINCS tasks */
+            shaked->numThreads = gmx_omp_nthreads_get(emntLINCS);
         }
     }
 
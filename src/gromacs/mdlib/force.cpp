@@ -65,6 +65,7 @@
 #include "gromacs/mdtypes/interaction_const.h"
 #include "gromacs/mdtypes/md_enums.h"
 #include "gromacs/mdtypes/mdatom.h"
+#include "gromacs/mdtypes/multipletimestepping.h"
 #include "gromacs/mdtypes/simulation_workload.h"
 #include "gromacs/pbcutil/ishift.h"
 #include "gromacs/pbcutil/pbc.h"
@@ -112,6 +113,7 @@ void do_force_lowlevel(t_forcerec*                          fr,
                        ArrayRef<const RVec>                 xWholeMolecules,
                        history_t*                           hist,
                        gmx::ForceOutputs*                   forceOutputs,
+                       gmx::ForceOutputs*                   forceOutputsMtsLevel1,
                        gmx_enerdata_t*                      enerd,
                        const matrix                         box,
                        const real*                          lambda,
@@ -122,15 +124,13 @@ void do_force_lowlevel(t_forcerec*                          fr,
     // TODO: Replace all uses of x by const coordinates
     const rvec* x = as_rvec_array(coordinates.paddedArrayRef().data());
 
-    auto& forceWithVirial = forceOutputs->forceWithVirial();
-
     /* Call the short range functions all in one go. */
 
     if (ir->nwall)
     {
         /* foreign lambda component for walls */
-        real dvdl_walls = do_walls(*ir, *fr, box, *md, x, &forceWithVirial, lambda[efptVDW],
-                                   enerd->grpp.ener[egLJSR].data(), nrnb);
+        real dvdl_walls = do_walls(*ir, *fr, box, *md, x, &forceOutputs->forceWithVirial(),
+                                   lambda[efptVDW], enerd->grpp.ener[egLJSR].data(), nrnb);
         enerd->dvdl_lin[efptVDW] += dvdl_walls;
     }
 
@@ -138,9 +138,14 @@ void do_force_lowlevel(t_forcerec*                          fr,
         t_pbc pbc;
 
         /* Check whether we need to take into account PBC in listed interactions. */
-        ListedForces& listedForces = *fr->listedForces;
-        const auto    needPbcForListedForces =
-                fr->bMolPBC && stepWork.computeListedForces && listedForces.haveCpuListedForces();
+        bool needPbcForListedForces = false;
+        for (const auto& listedForces : fr->listedForces)
+        {
+            if (fr->bMolPBC && stepWork.computeListedForces && listedForces.haveCpuListedForces())
+            {
+                needPbcForListedForces = true;
+            }
+        }
         if (needPbcForListedForces)
         {
             /* Since all atoms are in the rectangular or triclinic unit-cell,
@@ -149,11 +154,32 @@ void do_force_lowlevel(t_forcerec*                          fr,
             set_pbc_dd(&pbc, fr->pbcType, DOMAINDECOMP(cr) ? cr->dd->numCells : nullptr, TRUE, box);
         }
 
-        listedForces.calculate(wcycle, box, ir->fepvals, cr, ms, x, xWholeMolecules, hist,
-                               forceOutputs, fr, &pbc, enerd, nrnb, lambda, md,
-                               DOMAINDECOMP(cr) ? cr->dd->globalAtomIndices.data() : nullptr, stepWork);
+        /* With MTS, the listed forces of the slow level are only computed at slow steps */
+        for (gmx::index mtsIndex = 0; mtsIndex < gmx::ssize(fr->listedForces); mtsIndex++)
+        {
+            gmx::ForceOutputs* listedForceOutputs =
+                    (mtsIndex == 0 ? forceOutputs : forceOutputsMtsLevel1);
+            if (listedForceOutputs != nullptr)
+            {
+                fr->listedForces[mtsIndex].calculate(
+                        wcycle, box, ir->fepvals, cr, ms, x, xWholeMolecules, hist,
+                        listedForceOutputs, fr, &pbc, enerd, nrnb, lambda, md,
+                        DOMAINDECOMP(cr) ? cr->dd->globalAtomIndices.data() : nullptr, stepWork);
+            }
+        }
     }
 
+    /* With MTS, the long-range forces are computed with the slow forces when
+     * they belong to the slow level. forceOutputsMtsLevel1 is then nullptr
+     * at steps where the slow forces are not computed.
+     */
+    const bool longRangeIsFast =
+            (fr->useMts
+             && gmx::forceGroupMtsLevel(ir->mtsLevels, gmx::MtsForceGroups::LongrangeNonbonded)
+                        == 0);
+    gmx::ForceOutputs* forceOutputsLongRange =
+            (longRangeIsFast ? forceOutputs : forceOutputsMtsLevel1);
+
     const bool computePmeOnCpu = (EEL_PME(fr->ic->eeltype) || EVDW_PME(fr->ic->vdwtype))
                                  && thisRankHasDuty(cr, DUTY_PME)
                                  && (pme_run_mode(fr->pmedata) == PmeRunMode::CPU);
@@ -163,8 +189,11 @@ void do_force_lowlevel(t_forcerec*                          fr,
     /* Do long-range electrostatics and/or LJ-PME
      * and compute PME surface terms when necessary.
      */
-    if (computePmeOnCpu || fr->ic->eeltype == eelEWALD || haveEwaldSurfaceTerm)
+    if (forceOutputsLongRange != nullptr
+        && (computePmeOnCpu || fr->ic->eeltype == eelEWALD || haveEwaldSurfaceTerm))
     {
+        auto& forceWithVirial = forceOutputsLongRange->forceWithVirial();
+
         int  status = 0;
         real Vlr_q = 0, Vlr_lj = 0;
 
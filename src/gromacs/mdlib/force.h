@@ -115,6 +115,11 @@ void do_force(FILE*                               log,
  *
  * xWholeMolecules only needs to contain whole molecules when orientation
  * restraints need to be computed and can be empty otherwise.
+ *
+ * Without multiple time stepping, forceOutputsMtsLevel1 should equal
+ * forceOutputs. With multiple time stepping, forceOutputsMtsLevel1
+ * receives the slow forces and should be nullptr on steps where
+ * the slow forces are not computed.
  */
 void do_force_lowlevel(t_forcerec*                               fr,
                        const t_inputrec*                         ir,
@@ -127,6 +132,7 @@ void do_force_lowlevel(t_forcerec*                               fr,
                        gmx::ArrayRef<const gmx::RVec>            xWholeMolecules,
                        history_t*                                hist,
                        gmx::ForceOutputs*                        forceOutputs,
+                       gmx::ForceOutputs*                        forceOutputsMtsLevel1,
                        gmx_enerdata_t*                           enerd,
                        const matrix                              box,
                        const real*                               lambda,
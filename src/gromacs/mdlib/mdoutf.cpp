@@ -39,6 +39,20 @@
 
 #include "config.h"
 
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <algorithm>
+#include <array>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <thread>
+#include <vector>
+
 #include "gromacs/commandline/filenm.h"
 #include "gromacs/domdec/collect.h"
 #include "gromacs/domdec/domdec_struct.h"
@@ -64,6 +78,7 @@
 #include "gromacs/mdtypes/observableshistory.h"
 #include "gromacs/mdtypes/state.h"
 #include "gromacs/mdtypes/swaphistory.h"
+#include "gromacs/timing/cyclecounter.h"
 #include "gromacs/timing/wallcycle.h"
 #include "gromacs/topology/topology.h"
 #include "gromacs/utility/baseversion.h"
@@ -71,8 +86,83 @@
 #include "gromacs/utility/pleasecite.h"
 #include "gromacs/utility/programcontext.h"
 #include "gromacs/utility/smalloc.h"
+#include "gromacs/utility/stringutil.h"
 #include "gromacs/utility/sysinfo.h"
 
+namespace
+{
+
+/*! \brief Writes checkpoints that were staged in memory on a background thread
+ *
+ * The checkpoint is serialized on the MD thread, so the state can
+ * change again as soon as writing has been started. The background
+ * thread writes and syncs the temporary checkpoint file and all output
+ * files it refers to, and only then moves it to the final name, so a
+ * crash never leaves behind a corrupt checkpoint file.
+ */
+class CheckpointWriterThread
+{
+public:
+    ~CheckpointWriterThread()
+    {
+        if (thread_.joinable())
+        {
+            thread_.join();
+        }
+    }
+
+    //! Starts writing \p data to \p fn via the temporary file \p fntemp
+    void start(const char* fn, const char* fntemp, bool bNumberAndKeep, std::vector<char>&& data);
+    //! Waits for the write in progress, if any, and gives a fatal error if it failed
+    void wait();
+
+private:
+    std::thread thread_;
+    //! Description of the error of the last write, empty on success
+    std::string error_;
+};
+
+/*! \brief Compresses and writes trajectory frames on a background thread
+ *
+ * Frames are queued by the MD thread after collecting them. At most
+ * a fixed number of frames is buffered; when the queue is full, the MD
+ * thread waits for the output thread, which limits the memory used when
+ * the file system can not keep up with the simulation.
+ */
+class TrajectoryWriterThread
+{
+public:
+    //! Starts the output thread, buffering at most \p maxQueuedFrames frames
+    explicit TrajectoryWriterThread(int maxQueuedFrames);
+    ~TrajectoryWriterThread();
+
+    //! Queues writing a frame, waits when the queue is full
+    void push(std::function<void()>&& writeFrame);
+    //! Waits until all queued frames have been written
+    void waitUntilIdle();
+    //! Moves the cycles spent on the output thread until now to counter \p ewc of \p wcycle
+    void addCyclesTo(gmx_wallcycle_t wcycle, int ewc);
+
+private:
+    //! Writes queued frames until stopped
+    void run();
+
+    int                               maxQueuedFrames_;
+    std::queue<std::function<void()>> queue_;
+    //! Whether the output thread is writing a frame
+    bool busy_ = false;
+    bool stop_ = false;
+    //! Number of frames written since the last call to addCyclesTo()
+    int numFramesWritten_ = 0;
+    //! Cycles spent writing since the last call to addCyclesTo()
+    gmx_cycles_t            cycles_ = 0;
+    std::mutex              mutex_;
+    std::condition_variable condition_;
+    std::thread             thread_;
+};
+
+} // namespace
+
 struct gmx_mdoutf
 {
     t_fileio*                     fp_trn;
@@ -97,6 +187,8 @@ struct gmx_mdoutf
     const gmx::MdModulesNotifier* mdModulesNotifier;
     bool                          simulationsShareState;
     MPI_Comm                      mastersComm;
+    CheckpointWriterThread*       checkpointWriter; /* nullptr unless writing in the background */
+    TrajectoryWriterThread*       trajectoryWriter; /* nullptr unless writing in the background */
 };
 
 
@@ -138,6 +230,8 @@ gmx_mdoutf_t init_mdoutf(FILE*                         fplog,
     of->wcycle                  = wcycle;
     of->f_global                = nullptr;
     of->outputProvider          = outputProvider;
+    of->checkpointWriter        = nullptr;
+    of->trajectoryWriter        = nullptr;
 
     GMX_RELEASE_ASSERT(!simulationsShareState || ms != nullptr,
                        "Need valid multisim object when simulations share state");
@@ -206,6 +300,17 @@ gmx_mdoutf_t init_mdoutf(FILE*                         fplog,
         }
         of->fn_cpt = opt2fn("-cpo", nfile, fnm);
 
+        /* Moving the checkpoint to the final name is what protects it
+         * against crashes, and the renames of simulations sharing state
+         * are synchronized with MPI, which we can not call from the
+         * writer thread.
+         */
+        if (getenv("GMX_CPT_ASYNC") != nullptr && !GMX_NO_RENAME && !GMX_FAHCORE
+            && !of->simulationsShareState)
+        {
+            of->checkpointWriter = new CheckpointWriterThread;
+        }
+
         if ((ir->efep != efepNO || ir->bSimTemp) && ir->fepvals->nstdhdl > 0
             && (ir->fepvals->separate_dhdl_file == esepdhdlfileYES) && EI_DYNAMICS(ir->eI))
         {
@@ -241,6 +346,14 @@ gmx_mdoutf_t init_mdoutf(FILE*                         fplog,
         {
             snew(of->f_global, top_global->natoms);
         }
+
+        const char* asyncTrajectoryEnv = getenv("GMX_TRAJ_ASYNC");
+        if (asyncTrajectoryEnv != nullptr && EI_DYNAMICS(ir->eI)
+            && (of->fp_trn || of->fp_xtc || of->tng || of->tng_low_prec))
+        {
+            const int maxQueuedFrames = std::max(std::atoi(asyncTrajectoryEnv), 1);
+            of->trajectoryWriter      = new TrajectoryWriterThread(maxQueuedFrames);
+        }
     }
 
     if (bCiteTng)
@@ -278,10 +391,203 @@ static void mpiBarrierBeforeRename(const bool applyMpiBarrierBeforeRename, MPI_C
 #endif
     }
 }
+
+/*! \brief Moves the temporary checkpoint file \p fntemp to \p fn
+ *
+ * The previous checkpoint is kept with suffix _prev.cpt.
+ * Returns false when the rename failed.
+ */
+static bool moveCheckpointIntoPlace(const char* fn,
+                                    const char* fntemp,
+                                    bool        applyMpiBarrierBeforeRename,
+                                    MPI_Comm    mpiBarrierCommunicator)
+{
+    if (gmx_fexist(fn))
+    {
+        /* Rename the previous checkpoint file */
+        mpiBarrierBeforeRename(applyMpiBarrierBeforeRename, mpiBarrierCommunicator);
+
+        std::string prevName = fn;
+        prevName.insert(std::strlen(fn) - std::strlen(ftp2ext(fn2ftp(fn))) - 1, "_prev");
+        if (!GMX_FAHCORE)
+        {
+            /* we copy here so that if something goes wrong between now and
+             * the rename below, there's always a state.cpt.
+             * If renames are atomic (such as in POSIX systems),
+             * this copying should be unneccesary.
+             */
+            gmx_file_copy(fn, prevName.c_str(), FALSE);
+            /* We don't really care if this fails:
+             * there's already a new checkpoint.
+             */
+        }
+        else
+        {
+            gmx_file_rename(fn, prevName.c_str());
+        }
+    }
+
+    /* Rename the checkpoint file from the temporary to the final name */
+    mpiBarrierBeforeRename(applyMpiBarrierBeforeRename, mpiBarrierCommunicator);
+
+    return gmx_file_rename(fntemp, fn) == 0;
+}
+
+/*! \brief Writes a checkpoint staged in memory to disk
+ *
+ * Runs on the background thread, so errors are returned
+ * as a message instead of being reported directly.
+ */
+static std::string writeStagedCheckpoint(const std::string&       fn,
+                                         const std::string&       fntemp,
+                                         bool                     bNumberAndKeep,
+                                         const std::vector<char>& data)
+{
+    FILE* fp = std::fopen(fntemp.c_str(), "wb");
+    if (fp == nullptr)
+    {
+        return gmx::formatString("Cannot open checkpoint file '%s' for writing", fntemp.c_str());
+    }
+    bool writeOk = (std::fwrite(data.data(), 1, data.size(), fp) == data.size());
+    writeOk      = writeOk && (std::fflush(fp) == 0);
+    bool syncOk  = writeOk && (gmx_fsync(fp) == 0);
+    writeOk      = (std::fclose(fp) == 0) && writeOk;
+    if (!writeOk)
+    {
+        return "Cannot read/write checkpoint; corrupt file, or maybe you are out of disk space?";
+    }
+
+    /* The checkpoint refers to positions in the output files,
+     * so these need to be on disk before the checkpoint is.
+     */
+    std::string syncFailureName = fntemp;
+    t_fileio*   ret             = gmx_fio_all_output_fsync();
+    if (ret)
+    {
+        syncFailureName = gmx_fio_getname(ret);
+        syncOk          = false;
+    }
+    if (!syncOk)
+    {
+        std::string buf = gmx::formatString("Cannot fsync '%s'; maybe you are out of disk space?",
+                                            syncFailureName.c_str());
+        if (getenv(GMX_IGNORE_FSYNC_FAILURE_ENV) == nullptr)
+        {
+            return buf;
+        }
+        gmx_warning("%s", buf.c_str());
+    }
+
+    /* we don't move the checkpoint if the user specified they didn't want it,
+       or if the fsyncs failed */
+    if (!bNumberAndKeep && syncOk
+        && !moveCheckpointIntoPlace(fn.c_str(), fntemp.c_str(), false, MPI_COMM_NULL))
+    {
+        return "Cannot rename checkpoint file; maybe you are out of disk space?";
+    }
+
+    return std::string();
+}
+
+TrajectoryWriterThread::TrajectoryWriterThread(int maxQueuedFrames) :
+    maxQueuedFrames_(maxQueuedFrames)
+{
+    thread_ = std::thread([this]() { run(); });
+}
+
+TrajectoryWriterThread::~TrajectoryWriterThread()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    condition_.notify_all();
+    thread_.join();
+}
+
+void TrajectoryWriterThread::run()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true)
+    {
+        condition_.wait(lock, [this]() { return stop_ || !queue_.empty(); });
+        if (queue_.empty())
+        {
+            return;
+        }
+        std::function<void()> writeFrame = std::move(queue_.front());
+        queue_.pop();
+        busy_ = true;
+        lock.unlock();
+        /* Let the MD thread continue when it was waiting for space */
+        condition_.notify_all();
+
+        gmx_cycles_t start = gmx_cycles_read();
+        writeFrame();
+        gmx_cycles_t cycles = gmx_cycles_read() - start;
+
+        lock.lock();
+        busy_ = false;
+        numFramesWritten_++;
+        cycles_ += cycles;
+        condition_.notify_all();
+    }
+}
+
+void TrajectoryWriterThread::push(std::function<void()>&& writeFrame)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    condition_.wait(lock, [this]() { return static_cast<int>(queue_.size()) < maxQueuedFrames_; });
+    queue_.push(std::move(writeFrame));
+    lock.unlock();
+    condition_.notify_all();
+}
+
+void TrajectoryWriterThread::waitUntilIdle()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    condition_.wait(lock, [this]() { return queue_.empty() && !busy_; });
+}
+
+void TrajectoryWriterThread::addCyclesTo(gmx_wallcycle_t wcycle, int ewc)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    wallcycle_add_cycles(wcycle, ewc, numFramesWritten_, static_cast<double>(cycles_));
+    numFramesWritten_ = 0;
+    cycles_           = 0;
+}
+
+void CheckpointWriterThread::start(const char*         fn,
+                                   const char*         fntemp,
+                                   bool                bNumberAndKeep,
+                                   std::vector<char>&& data)
+{
+    GMX_RELEASE_ASSERT(!thread_.joinable(), "Only one checkpoint can be written at a time");
+
+    thread_ = std::thread([this, fnString = std::string(fn), fntempString = std::string(fntemp),
+                           bNumberAndKeep, stagedData = std::move(data)]() {
+        error_ = writeStagedCheckpoint(fnString, fntempString, bNumberAndKeep, stagedData);
+    });
+}
+
+void CheckpointWriterThread::wait()
+{
+    if (thread_.joinable())
+    {
+        thread_.join();
+    }
+    if (!error_.empty())
+    {
+        gmx_file(error_);
+    }
+}
+
 /*! \brief Write a checkpoint to the filename
  *
  * Appends the _step<step>.cpt with bNumberAndKeep, otherwise moves
  * the previous checkpoint filename with suffix _prev.cpt.
+ * With \p checkpointWriter, the checkpoint is only serialized here and
+ * written to disk on a background thread.
  */
 static void write_checkpoint(const char*                   fn,
                              gmx_bool                      bNumberAndKeep,
@@ -299,7 +605,8 @@ static void write_checkpoint(const char*                   fn,
                              ObservablesHistory*           observablesHistory,
                              const gmx::MdModulesNotifier& mdModulesNotifier,
                              bool                          applyMpiBarrierBeforeRename,
-                             MPI_Comm                      mpiBarrierCommunicator)
+                             MPI_Comm                      mpiBarrierCommunicator,
+                             CheckpointWriterThread*       checkpointWriter)
 {
     t_fileio* fp;
     char*     fntemp; /* the temporary checkpoint file name */
@@ -331,6 +638,12 @@ static void write_checkpoint(const char*                   fn,
     snew(fntemp, std::strlen(fn));
     std::strcpy(fntemp, fn);
 #endif
+    if (checkpointWriter)
+    {
+        /* The previous checkpoint has to be in place before we write the next */
+        checkpointWriter->wait();
+    }
+
     std::string timebuf = gmx_format_current_time();
 
     if (fplog)
@@ -341,7 +654,12 @@ static void write_checkpoint(const char*                   fn,
     /* Get offsets for open files */
     auto outputfiles = gmx_fio_get_output_file_positions();
 
-    fp = gmx_fio_open(fntemp, "w");
+    fp = checkpointWriter ? gmx_fio_open_buffer(efCPT) : nullptr;
+    if (fp == nullptr)
+    {
+        checkpointWriter = nullptr;
+        fp               = gmx_fio_open(fntemp, "w");
+    }
 
     /* We can check many more things now (CPU, acceleration, etc), but
      * it is highly unlikely to have two separate builds with exactly
@@ -395,6 +713,13 @@ static void write_checkpoint(const char*                   fn,
     write_checkpoint_data(fp, headerContents, bExpanded, elamstats, state, observablesHistory,
                           mdModulesNotifier, &outputfiles);
 
+    if (checkpointWriter)
+    {
+        checkpointWriter->start(fn, fntemp, bNumberAndKeep, gmx_fio_close_buffer(fp));
+        sfree(fntemp);
+        return;
+    }
+
     /* we really, REALLY, want to make sure to physically write the checkpoint,
        and all the files it depends on, out to disk. Because we've
        opened the checkpoint with gmx_fio_open(), it's in our list
@@ -426,37 +751,8 @@ static void write_checkpoint(const char*                   fn,
 #if !GMX_NO_RENAME
     if (!bNumberAndKeep && !ret)
     {
-        if (gmx_fexist(fn))
-        {
-            /* Rename the previous checkpoint file */
-            mpiBarrierBeforeRename(applyMpiBarrierBeforeRename, mpiBarrierCommunicator);
-
-            std::strcpy(buf, fn);
-            buf[std::strlen(fn) - std::strlen(ftp2ext(fn2ftp(fn))) - 1] = '\0';
-            std::strcat(buf, "_prev");
-            std::strcat(buf, fn + std::strlen(fn) - std::strlen(ftp2ext(fn2ftp(fn))) - 1);
-            if (!GMX_FAHCORE)
-            {
-                /* we copy here so that if something goes wrong between now and
-                 * the rename below, there's always a state.cpt.
-                 * If renames are atomic (such as in POSIX systems),
-                 * this copying should be unneccesary.
-                 */
-                gmx_file_copy(fn, buf, FALSE);
-                /* We don't really care if this fails:
-                 * there's already a new checkpoint.
-                 */
-            }
-            else
-            {
-                gmx_file_rename(fn, buf);
-            }
-        }
-
-        /* Rename the checkpoint file from the temporary to the final name */
-        mpiBarrierBeforeRename(applyMpiBarrierBeforeRename, mpiBarrierCommunicator);
-
-        if (gmx_file_rename(fntemp, fn) != 0)
+        if (!moveCheckpointIntoPlace(fn, fntemp, applyMpiBarrierBeforeRename,
+                                     mpiBarrierCommunicator))
         {
             gmx_file("Cannot rename checkpoint file; maybe you are out of disk space?");
         }
@@ -476,6 +772,128 @@ static void write_checkpoint(const char*                   fn,
 #endif /* end GMX_FAHCORE block */
 }
 
+/*! \brief Writes the trajectory output selected by \p mdof_flags for one frame
+ *
+ * \p x is needed for (compressed) coordinate output, \p v and \p f only
+ * when velocity and force output are selected. All contain the whole system.
+ */
+static void write_trajectory_frame(gmx_mdoutf_t of,
+                                   int          mdof_flags,
+                                   int          natoms,
+                                   int64_t      step,
+                                   double       t,
+                                   real         lambda,
+                                   const rvec*  box,
+                                   const rvec*  x,
+                                   const rvec*  v,
+                                   const rvec*  f)
+{
+    if (mdof_flags & (MDOF_X | MDOF_V | MDOF_F))
+    {
+        const rvec* xFull = (mdof_flags & MDOF_X) ? x : nullptr;
+
+        if (of->fp_trn)
+        {
+            gmx_trr_write_frame(of->fp_trn, step, t, lambda, box, natoms, xFull, v, f);
+            if (gmx_fio_flush(of->fp_trn) != 0)
+            {
+                gmx_file("Cannot write trajectory; maybe you are out of disk space?");
+            }
+        }
+
+        /* If a TNG file is open for uncompressed coordinate output also write
+           velocities and forces to it. */
+        else if (of->tng)
+        {
+            gmx_fwrite_tng(of->tng, FALSE, step, t, lambda, box, natoms, xFull, v, f);
+        }
+        /* If only a TNG file is open for compressed coordinate output (no uncompressed
+           coordinate output) also write forces and velocities to it. */
+        else if (of->tng_low_prec)
+        {
+            gmx_fwrite_tng(of->tng_low_prec, FALSE, step, t, lambda, box, natoms, xFull, v, f);
+        }
+    }
+    if (mdof_flags & MDOF_X_COMPRESSED)
+    {
+        const rvec* xxtc    = nullptr;
+        rvec*       xsubset = nullptr;
+
+        if (of->natoms_x_compressed == of->natoms_global)
+        {
+            /* We are writing the positions of all of the atoms to
+               the compressed output */
+            xxtc = x;
+        }
+        else
+        {
+            /* We are writing the positions of only a subset of
+               the atoms to the compressed output, so we have to
+               make a copy of the subset of coordinates. */
+            int i, j;
+
+            snew(xsubset, of->natoms_x_compressed);
+            for (i = 0, j = 0; (i < of->natoms_global); i++)
+            {
+                if (getGroupType(*of->groups, SimulationAtomGroupType::CompressedPositionOutput, i) == 0)
+                {
+                    copy_rvec(x[i], xsubset[j++]);
+                }
+            }
+            xxtc = xsubset;
+        }
+        if (write_xtc(of->fp_xtc, of->natoms_x_compressed, step, t, box, xxtc,
+                      of->x_compression_precision)
+            == 0)
+        {
+            gmx_fatal(FARGS,
+                      "XTC error. This indicates you are out of disk space, or a "
+                      "simulation with major instabilities resulting in coordinates "
+                      "that are NaN or too large to be represented in the XTC format.\n");
+        }
+        gmx_fwrite_tng(of->tng_low_prec, TRUE, step, t, lambda, box, of->natoms_x_compressed, xxtc,
+                       nullptr, nullptr);
+        sfree(xsubset);
+    }
+    if (mdof_flags & (MDOF_BOX | MDOF_LAMBDA) && !(mdof_flags & (MDOF_X | MDOF_V | MDOF_F)))
+    {
+        if (of->tng)
+        {
+            real        lambdaOut = -1;
+            const rvec* boxOut    = nullptr;
+            if (mdof_flags & MDOF_BOX)
+            {
+                boxOut = box;
+            }
+            if (mdof_flags & MDOF_LAMBDA)
+            {
+                lambdaOut = lambda;
+            }
+            gmx_fwrite_tng(of->tng, FALSE, step, t, lambdaOut, boxOut, natoms, nullptr, nullptr,
+                           nullptr);
+        }
+    }
+    if (mdof_flags & (MDOF_BOX_COMPRESSED | MDOF_LAMBDA_COMPRESSED)
+        && !(mdof_flags & (MDOF_X_COMPRESSED)))
+    {
+        if (of->tng_low_prec)
+        {
+            real        lambdaOut = -1;
+            const rvec* boxOut    = nullptr;
+            if (mdof_flags & MDOF_BOX_COMPRESSED)
+            {
+                boxOut = box;
+            }
+            if (mdof_flags & MDOF_LAMBDA_COMPRESSED)
+            {
+                lambdaOut = lambda;
+            }
+            gmx_fwrite_tng(of->tng_low_prec, FALSE, step, t, lambdaOut, boxOut, natoms, nullptr,
+                           nullptr, nullptr);
+        }
+    }
+}
+
 void mdoutf_write_to_trajectory_files(FILE*                    fplog,
                                       const t_commrec*         cr,
                                       gmx_mdoutf_t             of,
@@ -528,6 +946,11 @@ void mdoutf_write_to_trajectory_files(FILE*                    fplog,
     {
         if (mdof_flags & MDOF_CPT)
         {
+            if (of->trajectoryWriter)
+            {
+                /* The checkpoint stores the positions in the output files */
+                of->trajectoryWriter->waitUntilIdle();
+            }
             fflush_tng(of->tng);
             fflush_tng(of->tng_low_prec);
             /* Write the checkpoint file.
@@ -541,124 +964,62 @@ void mdoutf_write_to_trajectory_files(FILE*                    fplog,
                              DOMAINDECOMP(cr) ? cr->dd->nnodes : cr->nnodes, of->eIntegrator,
                              of->simulation_part, of->bExpanded, of->elamstats, step, t,
                              state_global, observablesHistory, *(of->mdModulesNotifier),
-                             of->simulationsShareState, of->mastersComm);
+                             of->simulationsShareState, of->mastersComm, of->checkpointWriter);
         }
 
-        if (mdof_flags & (MDOF_X | MDOF_V | MDOF_F))
+        const int frameFlags = mdof_flags
+                               & (MDOF_X | MDOF_V | MDOF_F | MDOF_X_COMPRESSED | MDOF_BOX
+                                  | MDOF_LAMBDA | MDOF_BOX_COMPRESSED | MDOF_LAMBDA_COMPRESSED);
+        if (frameFlags == 0)
         {
-            const rvec* x = (mdof_flags & MDOF_X) ? state_global->x.rvec_array() : nullptr;
-            const rvec* v = (mdof_flags & MDOF_V) ? state_global->v.rvec_array() : nullptr;
-            const rvec* f = (mdof_flags & MDOF_F) ? f_global : nullptr;
+            return;
+        }
 
-            if (of->fp_trn)
-            {
-                gmx_trr_write_frame(of->fp_trn, step, t, state_local->lambda[efptFEP],
-                                    state_local->box, natoms, x, v, f);
-                if (gmx_fio_flush(of->fp_trn) != 0)
-                {
-                    gmx_file("Cannot write trajectory; maybe you are out of disk space?");
-                }
-            }
+        const rvec* x = (mdof_flags & (MDOF_X | MDOF_X_COMPRESSED)) ? state_global->x.rvec_array()
+                                                                    : nullptr;
+        const rvec* v = (mdof_flags & MDOF_V) ? state_global->v.rvec_array() : nullptr;
+        const rvec* f = (mdof_flags & MDOF_F) ? f_global : nullptr;
 
-            /* If a TNG file is open for uncompressed coordinate output also write
-               velocities and forces to it. */
-            else if (of->tng)
-            {
-                gmx_fwrite_tng(of->tng, FALSE, step, t, state_local->lambda[efptFEP],
-                               state_local->box, natoms, x, v, f);
-            }
-            /* If only a TNG file is open for compressed coordinate output (no uncompressed
-               coordinate output) also write forces and velocities to it. */
-            else if (of->tng_low_prec)
-            {
-                gmx_fwrite_tng(of->tng_low_prec, FALSE, step, t, state_local->lambda[efptFEP],
-                               state_local->box, natoms, x, v, f);
-            }
-        }
-        if (mdof_flags & MDOF_X_COMPRESSED)
+        if (of->trajectoryWriter)
         {
-            rvec* xxtc = nullptr;
+            /* Copy the frame, so compression and writing can happen
+             * on the output thread while the state is updated.
+             */
+            auto copyOf = [](const rvec* a, int n) {
+                return a ? std::vector<gmx::RVec>(a, a + n) : std::vector<gmx::RVec>();
+            };
+            std::vector<gmx::RVec>     xCopy  = copyOf(x, of->natoms_global);
+            std::vector<gmx::RVec>     vCopy  = copyOf(v, natoms);
+            std::vector<gmx::RVec>     fCopy  = copyOf(f, natoms);
+            std::array<gmx::RVec, DIM> box    = { { state_local->box[XX], state_local->box[YY],
+                                                 state_local->box[ZZ] } };
+            const real                 lambda = state_local->lambda[efptFEP];
 
-            if (of->natoms_x_compressed == of->natoms_global)
-            {
-                /* We are writing the positions of all of the atoms to
-                   the compressed output */
-                xxtc = state_global->x.rvec_array();
-            }
-            else
-            {
-                /* We are writing the positions of only a subset of
-                   the atoms to the compressed output, so we have to
-                   make a copy of the subset of coordinates. */
-                int i, j;
-
-                snew(xxtc, of->natoms_x_compressed);
-                auto x = makeArrayRef(state_global->x);
-                for (i = 0, j = 0; (i < of->natoms_global); i++)
-                {
-                    if (getGroupType(*of->groups, SimulationAtomGroupType::CompressedPositionOutput, i) == 0)
-                    {
-                        copy_rvec(x[i], xxtc[j++]);
-                    }
-                }
-            }
-            if (write_xtc(of->fp_xtc, of->natoms_x_compressed, step, t, state_local->box, xxtc,
-                          of->x_compression_precision)
-                == 0)
-            {
-                gmx_fatal(FARGS,
-                          "XTC error. This indicates you are out of disk space, or a "
-                          "simulation with major instabilities resulting in coordinates "
-                          "that are NaN or too large to be represented in the XTC format.\n");
-            }
-            gmx_fwrite_tng(of->tng_low_prec, TRUE, step, t, state_local->lambda[efptFEP],
-                           state_local->box, of->natoms_x_compressed, xxtc, nullptr, nullptr);
-            if (of->natoms_x_compressed != of->natoms_global)
-            {
-                sfree(xxtc);
-            }
-        }
-        if (mdof_flags & (MDOF_BOX | MDOF_LAMBDA) && !(mdof_flags & (MDOF_X | MDOF_V | MDOF_F)))
-        {
-            if (of->tng)
-            {
-                real  lambda = -1;
-                rvec* box    = nullptr;
-                if (mdof_flags & MDOF_BOX)
-                {
-                    box = state_local->box;
-                }
-                if (mdof_flags & MDOF_LAMBDA)
-                {
-                    lambda = state_local->lambda[efptFEP];
-                }
-                gmx_fwrite_tng(of->tng, FALSE, step, t, lambda, box, natoms, nullptr, nullptr, nullptr);
-            }
+            of->trajectoryWriter->push([of, frameFlags, natoms, step, t, lambda, box,
+                                        xCopy = std::move(xCopy), vCopy = std::move(vCopy),
+                                        fCopy = std::move(fCopy)]() {
+                write_trajectory_frame(of, frameFlags, natoms, step, t, lambda,
+                                       as_rvec_array(box.data()),
+                                       xCopy.empty() ? nullptr : as_rvec_array(xCopy.data()),
+                                       vCopy.empty() ? nullptr : as_rvec_array(vCopy.data()),
+                                       fCopy.empty() ? nullptr : as_rvec_array(fCopy.data()));
+            });
+            of->trajectoryWriter->addCyclesTo(of->wcycle, ewcTRAJ_OUTPUT_THREAD);
         }
-        if (mdof_flags & (MDOF_BOX_COMPRESSED | MDOF_LAMBDA_COMPRESSED)
-            && !(mdof_flags & (MDOF_X_COMPRESSED)))
+        else
         {
-            if (of->tng_low_prec)
-            {
-                real  lambda = -1;
-                rvec* box    = nullptr;
-                if (mdof_flags & MDOF_BOX_COMPRESSED)
-                {
-                    box = state_local->box;
-                }
-                if (mdof_flags & MDOF_LAMBDA_COMPRESSED)
-                {
-                    lambda = state_local->lambda[efptFEP];
-                }
-                gmx_fwrite_tng(of->tng_low_prec, FALSE, step, t, lambda, box, natoms, nullptr,
-                               nullptr, nullptr);
-            }
+            write_trajectory_frame(of, frameFlags, natoms, step, t, state_local->lambda[efptFEP],
+                                   state_local->box, x, v, f);
         }
     }
 }
 
 void mdoutf_tng_close(gmx_mdoutf_t of)
 {
+    if (of->trajectoryWriter)
+    {
+        of->trajectoryWriter->waitUntilIdle();
+    }
     if (of->tng || of->tng_low_prec)
     {
         wallcycle_start(of->wcycle, ewcTRAJ);
@@ -670,6 +1031,18 @@ void mdoutf_tng_close(gmx_mdoutf_t of)
 
 void done_mdoutf(gmx_mdoutf_t of)
 {
+    if (of->trajectoryWriter != nullptr)
+    {
+        of->trajectoryWriter->waitUntilIdle();
+        of->trajectoryWriter->addCyclesTo(of->wcycle, ewcTRAJ_OUTPUT_THREAD);
+        delete of->trajectoryWriter;
+        of->trajectoryWriter = nullptr;
+    }
+    if (of->checkpointWriter != nullptr)
+    {
+        of->checkpointWriter->wait();
+        delete of->checkpointWriter;
+    }
     if (of->fp_ene != nullptr)
     {
         done_ener_file(of->fp_ene);
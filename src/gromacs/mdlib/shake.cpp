@@ -60,6 +60,7 @@
 #include "gromacs/mdtypes/md_enums.h"
 #include "gromacs/pbcutil/pbc.h"
 #include "gromacs/topology/invblock.h"
+#include "gromacs/utility/exceptions.h"
 #include "gromacs/utility/fatalerror.h"
 #include "gromacs/utility/smalloc.h"
 
@@ -115,10 +116,39 @@ static void pr_sortblock(FILE* fp, const char* title, int nsb, t_sortblock sb[])
     }
 }
 
-//! Reallocates a vector.
+/*! \brief Reallocates the per-constraint data and divides the blocks over the threads
+ *
+ * Each thread gets a contiguous range of blocks. The ranges are chosen
+ * such that the number of constraints per thread is as equal as possible.
+ */
 static void resizeLagrangianData(shakedata* shaked, int ncons)
 {
     shaked->scaled_lagrange_multiplier.resize(ncons);
+    shaked->rij.resize(ncons);
+    shaked->half_of_reduced_mass.resize(ncons);
+    shaked->distance_squared_tolerance.resize(ncons);
+    shaked->constraint_distance_squared.resize(ncons);
+
+    const int numBlocks  = shaked->numShakeBlocks();
+    const int numThreads = std::max(1, std::min(shaked->numThreads, numBlocks));
+
+    shaked->threadBlockStart.resize(numThreads + 1);
+    shaked->threadBlockStart[0] = 0;
+    int block                   = 0;
+    for (int th = 1; th < numThreads; th++)
+    {
+        /* Add blocks to the previous thread while their middle lies before
+         * the target end of that thread, in units of sblock (3*constraints)
+         */
+        const int64_t targetEnd = (int64_t(6) * ncons * th) / numThreads;
+        while (block < numBlocks
+               && shaked->sblock[block] + shaked->sblock[block + 1] <= targetEnd)
+        {
+            block++;
+        }
+        shaked->threadBlockStart[th] = block;
+    }
+    shaked->threadBlockStart[numThreads] = numBlocks;
 }
 
 void make_shake_sblock_serial(shakedata* shaked, InteractionDefinitions* idef, const int numAtoms)
@@ -434,6 +464,7 @@ static void crattle(const int            iatom[],
 //! Applies SHAKE
 static int vec_shakef(FILE*                     fplog,
                       shakedata*                shaked,
+                      int                       firstConstraint,
                       const real                invmass[],
                       int                       ncon,
                       ArrayRef<const t_iparams> ip,
@@ -458,15 +489,16 @@ static int vec_shakef(FILE*                     fplog,
     int  error = 0;
     real constraint_distance;
 
-    shaked->rij.resize(ncon);
-    shaked->half_of_reduced_mass.resize(ncon);
-    shaked->distance_squared_tolerance.resize(ncon);
-    shaked->constraint_distance_squared.resize(ncon);
-
-    ArrayRef<RVec> rij                         = shaked->rij;
-    ArrayRef<real> half_of_reduced_mass        = shaked->half_of_reduced_mass;
-    ArrayRef<real> distance_squared_tolerance  = shaked->distance_squared_tolerance;
-    ArrayRef<real> constraint_distance_squared = shaked->constraint_distance_squared;
+    /* Each block has its own range in the work arrays, so blocks can be
+     * constrained concurrently
+     */
+    ArrayRef<RVec> rij = makeArrayRef(shaked->rij).subArray(firstConstraint, ncon);
+    ArrayRef<real> half_of_reduced_mass =
+            makeArrayRef(shaked->half_of_reduced_mass).subArray(firstConstraint, ncon);
+    ArrayRef<real> distance_squared_tolerance =
+            makeArrayRef(shaked->distance_squared_tolerance).subArray(firstConstraint, ncon);
+    ArrayRef<real> constraint_distance_squared =
+            makeArrayRef(shaked->constraint_distance_squared).subArray(firstConstraint, ncon);
 
     L1            = 1.0_real - lambda;
     const int* ia = iatom;
@@ -670,7 +702,7 @@ static bool bshakef(FILE*                         log,
                     ConstraintVariable            econq)
 {
     real dt_2, dvdl;
-    int  i, n0, ncon, blen, type, ll;
+    int  ncon, type, ll;
     int  tnit = 0, trij = 0;
 
     ncon = idef.il[F_CONSTR].size() / 3;
@@ -680,34 +712,64 @@ static bool bshakef(FILE*                         log,
         shaked->scaled_lagrange_multiplier[ll] = 0;
     }
 
-    // TODO Rewrite this block so that it is obvious that i, iatoms
-    // and lam are all iteration variables. Is this easier if the
-    // sblock data structure is organized differently?
-    const int*     iatoms = &(idef.il[F_CONSTR].iatoms[shaked->sblock[0]]);
-    ArrayRef<real> lam    = shaked->scaled_lagrange_multiplier;
-    for (i = 0; (i < shaked->numShakeBlocks());)
-    {
-        blen = (shaked->sblock[i + 1] - shaked->sblock[i]);
-        blen /= 3;
-        n0 = vec_shakef(log, shaked, invmass, blen, idef.iparams, iatoms, ir.shake_tol, x_s, prime,
-                        pbc, shaked->omega, ir.efep != efepNO, lambda, lam, invdt, v, bCalcVir,
-                        vir_r_m_dr, econq);
+    /* The blocks are independent, so we divide them over the threads.
+     * Each thread reduces its virial contribution into a separate buffer,
+     * these are summed in a fixed order below, so the result does not
+     * depend on the thread scheduling.
+     */
+    const int numThreads = shaked->numThreadBlockRanges();
+    shaked->threadOutput.resize(numThreads);
 
-        if (n0 == 0)
+#pragma omp parallel for num_threads(numThreads) schedule(static)
+    for (int th = 0; th < numThreads; th++)
+    {
+        try
         {
-            if (bDumpOnError && log)
+            ShakeThreadOutput output;
+            for (int b = shaked->threadBlockStart[th]; b < shaked->threadBlockStart[th + 1]; b++)
             {
+                const int      firstConstraint = shaked->sblock[b] / 3;
+                const int      blen            = shaked->sblock[b + 1] / 3 - firstConstraint;
+                const int*     iatoms          = &(idef.il[F_CONSTR].iatoms[shaked->sblock[b]]);
+                ArrayRef<real> lam             = makeArrayRef(shaked->scaled_lagrange_multiplier)
+                                             .subArray(firstConstraint, blen);
+                const int n0 = vec_shakef(log, shaked, firstConstraint, invmass, blen, idef.iparams,
+                                          iatoms, ir.shake_tol, x_s, prime, pbc, shaked->omega,
+                                          ir.efep != efepNO, lambda, lam, invdt, v, bCalcVir,
+                                          output.virial, econq);
+                if (n0 == 0)
                 {
-                    check_cons(log, blen, x_s, prime, v, pbc, idef.iparams, iatoms, invmass, econq);
+                    output.failedBlock = b;
+                    break;
                 }
+                output.numIterations += n0 * blen;
+                output.numConstraints += blen;
+            }
+            /* Store at the end to avoid false sharing during the loop */
+            shaked->threadOutput[th] = output;
+        }
+        GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR
+    }
+
+    for (const ShakeThreadOutput& output : shaked->threadOutput)
+    {
+        if (output.failedBlock >= 0)
+        {
+            if (bDumpOnError && log)
+            {
+                const int  sblockStart = shaked->sblock[output.failedBlock];
+                const int  blen        = (shaked->sblock[output.failedBlock + 1] - sblockStart) / 3;
+                const int* iatoms      = &(idef.il[F_CONSTR].iatoms[sblockStart]);
+                check_cons(log, blen, x_s, prime, v, pbc, idef.iparams, iatoms, invmass, econq);
             }
             return FALSE;
         }
-        tnit += n0 * blen;
-        trij += blen;
-        iatoms += 3 * blen; /* Increment pointer! */
-        lam = lam.subArray(blen, lam.ssize() - blen);
-        i++;
+        if (bCalcVir)
+        {
+            m_add(vir_r_m_dr, output.virial, vir_r_m_dr);
+        }
+        tnit += output.numIterations;
+        trij += output.numConstraints;
     }
     /* only for position part? */
     if (econq == ConstraintVariable::Positions)
@@ -62,6 +62,19 @@ class ArrayRef;
 
 enum class ConstraintVariable : int;
 
+//! Output of the SHAKE blocks constrained by one thread
+struct ShakeThreadOutput
+{
+    //! The constraint virial contribution, r x m delta_r
+    tensor virial = { { 0 } };
+    //! The number of iterations times the number of constraints, summed over blocks
+    int numIterations = 0;
+    //! The number of constraints
+    int numConstraints = 0;
+    //! The first block that did not converge, -1 when all blocks converged
+    int failedBlock = -1;
+};
+
 /*! \libinternal
  * \brief Working data for the SHAKE algorithm
  */
@@ -69,6 +82,8 @@ struct shakedata
 {
     //! Returns the number of SHAKE blocks */
     int numShakeBlocks() const { return sblock.size() - 1; }
+    //! Returns the number of threads the SHAKE blocks are divided over
+    int numThreadBlockRanges() const { return threadBlockStart.size() - 1; }
 
     //! The reference constraint vectors
     std::vector<RVec> rij;
@@ -92,6 +107,16 @@ struct shakedata
      * Value is -2 * eta from p. 336 of the paper, divided by the
      * constraint distance. */
     std::vector<real> scaled_lagrange_multiplier;
+    //! The number of OpenMP threads to use
+    int numThreads = 1;
+    /*! \brief The SHAKE blocks assigned to each thread
+     *
+     * Thread t constrains blocks threadBlockStart[t] to threadBlockStart[t+1].
+     * The ranges are chosen such that the number of constraints per thread
+     * is balanced. */
+    std::vector<int> threadBlockStart = { 0 };
+    //! The output of each thread
+    std::vector<ShakeThreadOutput> threadOutput;
 };
 
 //! Make SHAKE blocks when not using DD.
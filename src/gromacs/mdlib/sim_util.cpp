@@ -44,6 +44,7 @@
 #include <cstring>
 
 #include <array>
+#include <optional>
 
 #include "gromacs/awh/awh.h"
 #include "gromacs/domdec/dlbtiming.h"
@@ -90,6 +91,7 @@
 #include "gromacs/mdtypes/inputrec.h"
 #include "gromacs/mdtypes/md_enums.h"
 #include "gromacs/mdtypes/mdatom.h"
+#include "gromacs/mdtypes/multipletimestepping.h"
 #include "gromacs/mdtypes/simulation_workload.h"
 #include "gromacs/mdtypes/state.h"
 #include "gromacs/mdtypes/state_propagator_data_gpu.h"
@@ -125,6 +127,7 @@ using gmx::DomainLifetimeWorkload;
 using gmx::ForceOutputs;
 using gmx::ForceWithShiftForces;
 using gmx::InteractionLocality;
+using gmx::MtsForceGroups;
 using gmx::RVec;
 using gmx::SimulationWorkload;
 using gmx::StepWorkload;
@@ -381,6 +384,28 @@ static void postProcessForces(const t_commrec*          cr,
     }
 }
 
+/*! \brief Combines MTS level0 and level1 force buffers into a full and MTS-combined force buffer
+ *
+ * \param[in]     numAtoms        The number of atoms to combine forces for
+ * \param[in,out] forceMtsLevel0  Input: F_level0, output: F_level0 + F_level1
+ * \param[in,out] forceMts        Input: F_level1, output: F_level0 + mtsFactor * F_level1
+ * \param[in]     mtsFactor       The factor between the level0 and level1 time step
+ */
+static void combineMtsForces(const int      numAtoms,
+                             ArrayRef<RVec> forceMtsLevel0,
+                             ArrayRef<RVec> forceMts,
+                             const real     mtsFactor)
+{
+    const int gmx_unused numThreads = gmx_omp_nthreads_get(emntDefault);
+#pragma omp parallel for num_threads(numThreads) schedule(static)
+    for (int i = 0; i < numAtoms; i++)
+    {
+        const RVec forceMtsLevel0Tmp = forceMtsLevel0[i];
+        forceMtsLevel0[i] += forceMts[i];
+        forceMts[i] = forceMtsLevel0Tmp + mtsFactor * forceMts[i];
+    }
+}
+
 static void do_nb_verlet(t_forcerec*                fr,
                          const interaction_const_t* ic,
                          gmx_enerdata_t*            enerd,
@@ -579,7 +604,8 @@ static bool haveSpecialForces(const t_inputrec&          inputrec,
  * \param[in]     mdatoms          Per atom properties
  * \param[in]     lambda           Array of free-energy lambda values
  * \param[in]     stepWork         Step schedule flags
- * \param[in,out] forceWithVirial  Force and virial buffers
+ * \param[in,out] forceWithVirialMtsLevel0  Force and virial for MTS level0 forces
+ * \param[in,out] forceWithVirialMtsLevel1  Force and virial for MTS level1 forces, can be nullptr
  * \param[in,out] enerd            Energy buffer
  * \param[in,out] ed               Essential dynamics pointer
  * \param[in]     didNeighborSearch Tells if we did neighbor searching this step, used for ED sampling
@@ -603,7 +629,8 @@ static void computeSpecialForces(FILE*                          fplog,
                                  const t_mdatoms*               mdatoms,
                                  gmx::ArrayRef<const real>      lambda,
                                  const StepWorkload&            stepWork,
-                                 gmx::ForceWithVirial*          forceWithVirial,
+                                 gmx::ForceWithVirial*          forceWithVirialMtsLevel0,
+                                 gmx::ForceWithVirial*          forceWithVirialMtsLevel1,
                                  gmx_enerdata_t*                enerd,
                                  gmx_edsam*                     ed,
                                  bool                           didNeighborSearch)
@@ -614,7 +641,7 @@ static void computeSpecialForces(FILE*                          fplog,
     if (stepWork.computeForces)
     {
         gmx::ForceProviderInput  forceProviderInput(x, *mdatoms, t, box, *cr);
-        gmx::ForceProviderOutput forceProviderOutput(forceWithVirial, enerd);
+        gmx::ForceProviderOutput forceProviderOutput(forceWithVirialMtsLevel0, enerd);
 
         /* Collect forces from modules */
         forceProviders->calculateForces(forceProviderInput, &forceProviderOutput);
@@ -622,17 +649,24 @@ static void computeSpecialForces(FILE*                          fplog,
 
     if (inputrec->bPull && pull_have_potential(pull_work))
     {
-        pull_potential_wrapper(cr, inputrec, box, x, forceWithVirial, mdatoms, enerd, pull_work,
-                               lambda.data(), t, wcycle);
-
-        if (awh)
+        const int mtsLevel = gmx::forceGroupMtsLevel(inputrec->mtsLevels, MtsForceGroups::Pull);
+        if (mtsLevel == 0 || stepWork.computeSlowForces)
         {
-            enerd->term[F_COM_PULL] += awh->applyBiasForcesAndUpdateBias(
-                    inputrec->pbcType, mdatoms->massT, box, forceWithVirial, t, step, wcycle, fplog);
+            auto* forceWithVirial =
+                    (mtsLevel == 0) ? forceWithVirialMtsLevel0 : forceWithVirialMtsLevel1;
+            pull_potential_wrapper(cr, inputrec, box, x, forceWithVirial, mdatoms, enerd, pull_work,
+                                   lambda.data(), t, wcycle);
+
+            if (awh)
+            {
+                enerd->term[F_COM_PULL] += awh->applyBiasForcesAndUpdateBias(
+                        inputrec->pbcType, mdatoms->massT, box, forceWithVirial, t, step, wcycle,
+                        fplog);
+            }
         }
     }
 
-    rvec* f = as_rvec_array(forceWithVirial->force_.data());
+    rvec* f = as_rvec_array(forceWithVirialMtsLevel0->force_.data());
 
     /* Add the forces from enforced rotation potentials (if any) */
     if (inputrec->bRot)
@@ -841,10 +875,22 @@ static DomainLifetimeWorkload setupDomainLifetimeWorkload(const t_inputrec&
     // Note that haveSpecialForces is constant over the whole run
     domainWork.haveSpecialForces =
             haveSpecialForces(inputrec, *fr.forceProviders, pull_work, stepWork.computeForces, ed);
-    domainWork.haveCpuBondedWork  = fr.listedForces->haveCpuBondeds();
-    domainWork.haveGpuBondedWork  = ((fr.gpuBonded != nullptr) && fr.gpuBonded->haveInteractions());
-    domainWork.haveRestraintsWork = fr.listedForces->haveRestraints();
-    domainWork.haveCpuListedForceWork = fr.listedForces->haveCpuListedForces();
+    for (const auto& listedForces : fr.listedForces)
+    {
+        if (listedForces.haveCpuBondeds())
+        {
+            domainWork.haveCpuBondedWork = true;
+        }
+        if (listedForces.haveRestraints())
+        {
+            domainWork.haveRestraintsWork = true;
+        }
+        if (listedForces.haveCpuListedForces())
+        {
+            domainWork.haveCpuListedForceWork = true;
+        }
+    }
+    domainWork.haveGpuBondedWork = ((fr.gpuBonded != nullptr) && fr.gpuBonded->haveInteractions());
     // Note that haveFreeEnergyWork is constant over the whole run
     domainWork.haveFreeEnergyWork = (fr.efep != efepNO && mdatoms.nPerturbed != 0);
     // We assume we have local force work if there are CPU
@@ -860,17 +906,24 @@ static DomainLifetimeWorkload setupDomainLifetimeWorkload(const t_inputrec&
 /*! \brief Set up force flag stuct from the force bitmask.
  *
  * \param[in]      legacyFlags          Force bitmask flags used to construct the new flags
+ * \param[in]      mtsLevels            The multiple time-stepping levels, either empty or 2 levels
+ * \param[in]      step                 The current MD step
  * \param[in]      isNonbondedOn        Global override, if false forces to turn off all nonbonded calculation.
  * \param[in]      simulationWork       Simulation workload description.
  * \param[in]      rankHasPmeDuty       If this rank computes PME.
  *
  * \returns New Stepworkload description.
  */
-static StepWorkload setupStepWorkload(const int                 legacyFlags,
-                                      const bool                isNonbondedOn,
-                                      const SimulationWorkload& simulationWork,
-                                      const bool                rankHasPmeDuty)
+static StepWorkload setupStepWorkload(const int                     legacyFlags,
+                                      ArrayRef<const gmx::MtsLevel> mtsLevels,
+                                      const int64_t                 step,
+                                      const bool                    isNonbondedOn,
+                                      const SimulationWorkload&     simulationWork,
+                                      const bool                    rankHasPmeDuty)
 {
+    GMX_ASSERT(mtsLevels.empty() || mtsLevels.size() == 2, "Expect 0 or 2 MTS levels");
+    const bool computeSlowForces = (mtsLevels.empty() || step % mtsLevels[1].stepFactor == 0);
+
     StepWorkload flags;
     flags.stateChanged           = ((legacyFlags & GMX_FORCE_STATECHANGED) != 0);
     flags.haveDynamicBox         = ((legacyFlags & GMX_FORCE_DYNAMICBOX) != 0);
@@ -881,6 +934,7 @@ static StepWorkload setupStepWorkload(const int                 legacyFlags,
     flags.computeListedForces    = ((legacyFlags & GMX_FORCE_LISTED) != 0);
     flags.computeNonbondedForces = ((legacyFlags & GMX_FORCE_NONBONDED) != 0) && isNonbondedOn;
     flags.computeDhdl            = ((legacyFlags & GMX_FORCE_DHDL) != 0);
+    flags.computeSlowForces      = computeSlowForces;
 
     if (simulationWork.useGpuBufferOps)
     {
@@ -1031,13 +1085,22 @@ void do_force(FILE*                               fplog,
     const SimulationWorkload& simulationWork = runScheduleWork->simulationWork;
 
 
-    runScheduleWork->stepWork    = setupStepWorkload(legacyFlags, fr->bNonbonded, simulationWork,
+    runScheduleWork->stepWork = setupStepWorkload(legacyFlags, inputrec->mtsLevels, step,
+                                                  fr->bNonbonded, simulationWork,
                                                   thisRankHasDuty(cr, DUTY_PME));
     const StepWorkload& stepWork = runScheduleWork->stepWork;
 
 
     const bool useGpuPmeOnThisRank = simulationWork.useGpuPme && thisRankHasDuty(cr, DUTY_PME);
 
+    // With MTS, when the long-range forces are at the slow level, PME-mesh is only computed
+    // on slow steps, also on separate PME ranks
+    const bool mtsLongRangeIsSlow =
+            (fr->useMts
+             && gmx::forceGroupMtsLevel(inputrec->mtsLevels, MtsForceGroups::LongrangeNonbonded)
+                        == 1);
+    const bool computePmeThisStep = (!mtsLongRangeIsSlow || stepWork.computeSlowForces);
+
     /* At a search step we need to start the first balancing region
      * somewhere early inside the step after communication during domain
      * decomposition (and not during the previous step as usual).
@@ -1083,7 +1146,8 @@ void do_force(FILE*                               fplog,
 
     // If coordinates are to be sent to PME task from CPU memory, perform that send here.
     // Otherwise the send will occur after H2D coordinate transfer.
-    if (GMX_MPI && !thisRankHasDuty(cr, DUTY_PME) && !pmeSendCoordinatesFromGpu)
+    if (GMX_MPI && !thisRankHasDuty(cr, DUTY_PME) && !pmeSendCoordinatesFromGpu
+        && computePmeThisStep)
     {
         /* Send particle coordinates to the pme nodes */
         if (!stepWork.doNeighborSearch && simulationWork.useGpuUpdate)
@@ -1498,9 +1562,23 @@ void do_force(FILE*                               fplog,
 
     // Set up and clear force outputs.
     // We use std::move to keep the compiler happy, it has no effect.
-    ForceOutputs forceOut = setupForceOutputs(fr->forceHelperBuffers.get(), pull_work, *inputrec,
+    ForceOutputs forceOut = setupForceOutputs(&fr->forceHelperBuffers[0], pull_work, *inputrec,
                                               std::move(force), stepWork, wcycle);
 
+    // With MTS, the forces of the slow level are accumulated in a separate output,
+    // which is only set up at steps where the slow forces are computed
+    std::optional<ForceOutputs> forceOutMtsLevel1;
+    if (fr->useMts && stepWork.computeSlowForces)
+    {
+        forceOutMtsLevel1.emplace(setupForceOutputs(
+                &fr->forceHelperBuffers[1], pull_work, *inputrec,
+                fr->forceMtsCombined.arrayRefWithPadding(), stepWork, wcycle));
+    }
+
+    // Without MTS, all forces go to the normal force output
+    ForceOutputs* forceOutMtsLevel1Ptr =
+            (fr->useMts ? (forceOutMtsLevel1 ? &forceOutMtsLevel1.value() : nullptr) : &forceOut);
+
     /* We calculate the non-bonded forces, when done on the CPU, here.
      * We do this before calling do_force_lowlevel, because in that
      * function, the listed forces are calculated before PME, which
@@ -1572,14 +1650,16 @@ void do_force(FILE*                               fplog,
     }
     /* Compute the bonded and non-bonded energies and optionally forces */
     do_force_lowlevel(fr, inputrec, cr, ms, nrnb, wcycle, mdatoms, x, xWholeMolecules, hist,
-                      &forceOut, enerd, box, lambda.data(), as_rvec_array(dipoleData.muStateAB),
-                      stepWork, ddBalanceRegionHandler);
+                      &forceOut, forceOutMtsLevel1Ptr, enerd, box, lambda.data(),
+                      as_rvec_array(dipoleData.muStateAB), stepWork, ddBalanceRegionHandler);
 
     wallcycle_stop(wcycle, ewcFORCE);
 
     computeSpecialForces(fplog, cr, inputrec, awh, enforcedRotation, imdSession, pull_work, step, t,
                          wcycle, fr->forceProviders, box, x.unpaddedArrayRef(), mdatoms, lambda,
-                         stepWork, &forceOut.forceWithVirial(), enerd, ed, stepWork.doNeighborSearch);
+                         stepWork, &forceOut.forceWithVirial(),
+                         forceOutMtsLevel1Ptr ? &forceOutMtsLevel1Ptr->forceWithVirial() : nullptr,
+                         enerd, ed, stepWork.doNeighborSearch);
 
 
     // Will store the amount of cycles spent waiting for the GPU that
@@ -1675,6 +1755,11 @@ void do_force(FILE*                               fplog,
                 }
                 dd_move_f(cr->dd, &forceOut.forceWithShiftForces(), wcycle);
             }
+
+            if (forceOutMtsLevel1)
+            {
+                dd_move_f(cr->dd, &forceOutMtsLevel1->forceWithShiftForces(), wcycle);
+            }
         }
     }
 
@@ -1736,7 +1821,7 @@ void do_force(FILE*                               fplog,
 
     // If on GPU PME-PP comms or GPU update path, receive forces from PME before GPU buffer ops
     // TODO refactor this and unify with below default-path call to the same function
-    if (PAR(cr) && !thisRankHasDuty(cr, DUTY_PME)
+    if (PAR(cr) && !thisRankHasDuty(cr, DUTY_PME) && computePmeThisStep
         && (simulationWork.useGpuPmePpCommunication || simulationWork.useGpuUpdate))
     {
         /* In case of node-splitting, the PP nodes receive the long-range
@@ -1843,6 +1928,13 @@ void do_force(FILE*                               fplog,
     {
         postProcessForceWithShiftForces(nrnb, wcycle, box, x.unpaddedArrayRef(), &forceOut,
                                         vir_force, *mdatoms, *fr, vsite, stepWork);
+
+        if (forceOutMtsLevel1)
+        {
+            postProcessForceWithShiftForces(nrnb, wcycle, box, x.unpaddedArrayRef(),
+                                            &forceOutMtsLevel1.value(), vir_force, *mdatoms, *fr,
+                                            vsite, stepWork);
+        }
     }
 
     // VdW dispersion correction, only computed on master rank to avoid double counting
@@ -1867,12 +1959,13 @@ void do_force(FILE*                               fplog,
 
     // TODO refactor this and unify with above GPU PME-PP / GPU update path call to the same function
     if (PAR(cr) && !thisRankHasDuty(cr, DUTY_PME) && !simulationWork.useGpuPmePpCommunication
-        && !simulationWork.useGpuUpdate)
+        && !simulationWork.useGpuUpdate && computePmeThisStep)
     {
         /* In case of node-splitting, the PP nodes receive the long-range
          * forces, virial and energy from the PME nodes here.
          */
-        pme_receive_force_ener(fr, cr, &forceOut.forceWithVirial(), enerd,
+        ForceOutputs& forceOutPme = (mtsLongRangeIsSlow ? forceOutMtsLevel1.value() : forceOut);
+        pme_receive_force_ener(fr, cr, &forceOutPme.forceWithVirial(), enerd,
                                simulationWork.useGpuPmePpCommunication, false, wcycle);
     }
 
@@ -1880,6 +1973,19 @@ void do_force(FILE*                               fplog,
     {
         postProcessForces(cr, step, nrnb, wcycle, box, x.unpaddedArrayRef(), &forceOut, vir_force,
                           mdatoms, fr, vsite, stepWork);
+
+        if (forceOutMtsLevel1)
+        {
+            postProcessForces(cr, step, nrnb, wcycle, box, x.unpaddedArrayRef(),
+                              &forceOutMtsLevel1.value(), vir_force, mdatoms, fr, vsite, stepWork);
+
+            /* Add the slow forces to the normal forces and store the fast forces
+             * plus the slow forces scaled by the MTS factor for the integrator
+             */
+            combineMtsForces(mdatoms->homenr, forceOut.forceWithShiftForces().force(),
+                             forceOutMtsLevel1->forceWithShiftForces().force(),
+                             inputrec->mtsLevels[1].stepFactor);
+        }
     }
 
     if (stepWork.computeEnergy)
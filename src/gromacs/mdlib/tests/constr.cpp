@@ -77,7 +77,7 @@ namespace
  * The test will run for all possible combinations of accessible
  * values of the:
  * 1. PBC setup ("PBCNONE" or "PBCXYZ")
- * 2. The algorithm ("SHAKE", "LINCS" or "LINCS_GPU").
+ * 2. The algorithm ("SHAKE", "SHAKE_TWO_THREADS", "LINCS" or "LINCS_GPU").
  */
 typedef std::tuple<std::string, std::string> ConstraintsTestParameters;
 
@@ -88,6 +88,7 @@ std::vector<std::string> runnersNames;
 std::vector<std::string> getRunnersNames()
 {
     runnersNames.emplace_back("SHAKE");
+    runnersNames.emplace_back("SHAKE_TWO_THREADS");
     runnersNames.emplace_back("LINCS");
     if (GMX_GPU_CUDA && canComputeOnGpu())
     {
@@ -151,6 +152,8 @@ public:
         //
         // SHAKE
         algorithms_["SHAKE"] = applyShake;
+        // SHAKE with the blocks divided over two threads
+        algorithms_["SHAKE_TWO_THREADS"] = applyShakeTwoThreads;
         // LINCS
         algorithms_["LINCS"] = applyLincs;
         // LINCS using GPU (will only be called if GPU is available)
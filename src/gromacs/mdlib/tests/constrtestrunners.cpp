@@ -98,6 +98,25 @@ void applyShake(ConstraintsTestData* testData, t_pbc gmx_unused pbc)
     EXPECT_TRUE(success) << "Test failed with a false return value in SHAKE.";
 }
 
+/*! \brief
+ * Initialize and apply SHAKE constraints with the blocks divided over two threads.
+ *
+ * \param[in] testData        Test data structure.
+ * \param[in] pbc             Periodic boundary data.
+ */
+void applyShakeTwoThreads(ConstraintsTestData* testData, t_pbc gmx_unused pbc)
+{
+    shakedata shaked;
+    shaked.numThreads = 2;
+    make_shake_sblock_serial(&shaked, testData->idef_.get(), testData->numAtoms_);
+    bool success = constrain_shake(
+            nullptr, &shaked, testData->invmass_.data(), *testData->idef_, testData->ir_, testData->x_,
+            testData->xPrime_, testData->xPrime2_, nullptr, &testData->nrnb_, testData->lambda_,
+            &testData->dHdLambda_, testData->invdt_, testData->v_, testData->computeVirial_,
+            testData->virialScaled_, false, gmx::ConstraintVariable::Positions);
+    EXPECT_TRUE(success) << "Test failed with a false return value in SHAKE.";
+}
+
 /*! \brief
  * Initialize and apply LINCS constraints.
  *
@@ -58,6 +58,9 @@ namespace test
 /*! \brief Apply SHAKE constraints to the test data.
  */
 void applyShake(ConstraintsTestData* testData, t_pbc pbc);
+/*! \brief Apply SHAKE constraints with the blocks divided over two threads to the test data.
+ */
+void applyShakeTwoThreads(ConstraintsTestData* testData, t_pbc pbc);
 /*! \brief Apply LINCS constraints to the test data.
  */
 void applyLincs(ConstraintsTestData* testData, t_pbc pbc);
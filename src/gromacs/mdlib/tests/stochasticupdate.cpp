@@ -0,0 +1,406 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2021, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief Tests for the stochastic and Brownian dynamics updates
+ *
+ * The SIMD SD and BD updates should generate the same random noise per atom
+ * as the scalar updates, independently of how the atoms are distributed over
+ * SIMD blocks and threads. The test system has a virtual site and a partially
+ * frozen atom inside SIMD blocks, as well as a number of atoms that is not
+ * a multiple of the SIMD width, so all fall-back paths are exercised.
+ *
+ * \ingroup module_mdlib
+ */
+#include "gmxpre.h"
+
+#include <cmath>
+
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "gromacs/math/paddedvector.h"
+#include "gromacs/math/units.h"
+#include "gromacs/math/vec.h"
+#include "gromacs/math/vectypes.h"
+#include "gromacs/mdlib/gmx_omp_nthreads.h"
+#include "gromacs/mdlib/update.h"
+#include "gromacs/mdtypes/commrec.h"
+#include "gromacs/mdtypes/fcdata.h"
+#include "gromacs/mdtypes/inputrec.h"
+#include "gromacs/mdtypes/mdatom.h"
+#include "gromacs/mdtypes/md_enums.h"
+#include "gromacs/mdtypes/state.h"
+#include "gromacs/random/tabulatednormaldistribution.h"
+#include "gromacs/random/threefry.h"
+#include "gromacs/topology/atoms.h"
+#include "gromacs/utility/arrayref.h"
+#include "gromacs/utility/smalloc.h"
+
+#include "testutils/testasserts.h"
+
+namespace gmx
+{
+namespace test
+{
+namespace
+{
+
+//! Number of atoms, giving fully mobile SIMD blocks and a scalar remainder for any SIMD width
+constexpr int c_numAtoms = 61;
+//! Index of a virtual site, which lies inside the first SIMD block
+constexpr int c_virtualSiteIndex = 3;
+//! Index of an atom that is frozen along y, which lies inside a SIMD block
+constexpr int c_frozenAtomIndex = 21;
+//! The number of steps to integrate
+constexpr int c_numSteps = 3;
+
+//! Coordinates and velocities after the update
+struct UpdateResult
+{
+    //! Updated coordinates
+    std::vector<RVec> x;
+    //! Updated velocities
+    std::vector<RVec> v;
+};
+
+/*! \brief Reference BD update, identical to the scalar update in update.cpp
+ *
+ * Used to check the SIMD update, since with SIMD support the BD update
+ * always uses the SIMD code path.
+ */
+void bdReferenceUpdate(const t_inputrec&    inputRecord,
+                       const t_mdatoms&     mdAtoms,
+                       ArrayRef<const real> rf,
+                       int64_t              step,
+                       ArrayRef<const RVec> f,
+                       std::vector<RVec>*   x,
+                       std::vector<RVec>*   v)
+{
+    const real dt       = inputRecord.delta_t;
+    const real friction = inputRecord.bd_fric;
+
+    ThreeFry2x64<0>                       rng(inputRecord.ld_seed, RandomDomain::UpdateCoordinates);
+    TabulatedNormalDistribution<real, 14> dist;
+
+    for (int n = 0; n < mdAtoms.homenr; n++)
+    {
+        rng.restart(step, n);
+        dist.reset();
+
+        const int gf = mdAtoms.cFREEZE[n];
+        const int gt = mdAtoms.cTC[n];
+        for (int d = 0; d < DIM; d++)
+        {
+            if (mdAtoms.ptype[n] != eptVSite && mdAtoms.ptype[n] != eptShell
+                && !inputRecord.opts.nFreeze[gf][d])
+            {
+                real vn;
+                if (friction != 0)
+                {
+                    vn = (1.0 / friction) * f[n][d] + rf[gt] * dist(rng);
+                }
+                else
+                {
+                    vn = 0.5 * mdAtoms.invmass[n] * f[n][d] * dt
+                         + std::sqrt(0.5 * mdAtoms.invmass[n]) * rf[gt] * dist(rng);
+                }
+                (*v)[n][d] = vn;
+                (*x)[n][d] += vn * dt;
+            }
+            else
+            {
+                (*v)[n][d] = 0;
+            }
+        }
+    }
+}
+
+class StochasticUpdateTest : public ::testing::Test
+{
+public:
+    StochasticUpdateTest() :
+        mdAtoms_{},
+        invmass_(c_numAtoms),
+        ptype_(c_numAtoms, eptAtom),
+        cTC_(c_numAtoms),
+        cFREEZE_(c_numAtoms, 0),
+        cACC_(c_numAtoms, 0),
+        x0_(c_numAtoms),
+        v0_(c_numAtoms),
+        f_(c_numAtoms)
+    {
+        inputRecord_.delta_t = 0.002;
+        inputRecord_.ld_seed = 1993;
+
+        t_grpopts* opts = &inputRecord_.opts;
+        opts->ngtc      = 2;
+        snew(opts->ref_t, opts->ngtc);
+        snew(opts->tau_t, opts->ngtc);
+        snew(opts->anneal_time, opts->ngtc);
+        snew(opts->anneal_temp, opts->ngtc);
+        opts->ref_t[0] = 300;
+        opts->tau_t[0] = 1.0;
+        opts->ref_t[1] = 200;
+        opts->tau_t[1] = 0.1;
+        opts->ngacc    = 1;
+        snew(opts->acc, opts->ngacc);
+        opts->ngfrz = 2;
+        snew(opts->nFreeze, opts->ngfrz);
+        opts->nFreeze[1][YY] = 1;
+
+        for (int i = 0; i < c_numAtoms; i++)
+        {
+            invmass_[i] = 1.0 / (1.0 + i % 17);
+            cTC_[i]     = i % 2;
+            for (int d = 0; d < DIM; d++)
+            {
+                x0_[i][d] = 0.1 * ((i + 3 * d) % 11);
+                v0_[i][d] = 0.3 * ((i + d) % 5) - 0.6;
+                f_[i][d]  = 40.0 * ((2 * i + d) % 7) - 120.0;
+            }
+        }
+        ptype_[c_virtualSiteIndex]   = eptVSite;
+        invmass_[c_virtualSiteIndex] = 0;
+        cFREEZE_[c_frozenAtomIndex]  = 1;
+
+        mdAtoms_.nr                       = c_numAtoms;
+        mdAtoms_.homenr                   = c_numAtoms;
+        mdAtoms_.invmass                  = invmass_.data();
+        mdAtoms_.ptype                    = ptype_.data();
+        mdAtoms_.cTC                      = cTC_.data();
+        mdAtoms_.cFREEZE                  = cFREEZE_.data();
+        mdAtoms_.haveVsites               = true;
+        mdAtoms_.havePartiallyFrozenAtoms = true;
+
+        cr_.nnodes = 1;
+        cr_.dd     = nullptr;
+    }
+
+    /*! \brief Integrates c_numSteps steps with the SD or BD integrator
+     *
+     * \param[in] numThreads       The number of OpenMP threads to use for the update
+     * \param[in] useScalarSD      Force the scalar SD update by setting acceleration groups
+     * \param[in] haveConstraints  Whether to only do the force part of the SD update
+     */
+    UpdateResult integrate(int numThreads, bool useScalarSD, bool haveConstraints)
+    {
+        mdAtoms_.cACC = useScalarSD ? cACC_.data() : nullptr;
+
+        t_state state;
+        state.flags = 0;
+        state.x.resizeWithPadding(c_numAtoms);
+        state.v.resizeWithPadding(c_numAtoms);
+        for (int i = 0; i < c_numAtoms; i++)
+        {
+            state.x[i] = x0_[i];
+            state.v[i] = v0_[i];
+        }
+
+        Update update(inputRecord_, nullptr);
+        update.setNumAtoms(c_numAtoms);
+
+        gmx_omp_nthreads_set(emntUpdate, numThreads);
+
+        t_fcdata fcdata;
+        matrix   M = { { 0 } };
+        for (int step = 0; step < c_numSteps; step++)
+        {
+            update.update_coords(inputRecord_, step, &mdAtoms_, &state, f_.arrayRefWithPadding(),
+                                 fcdata, nullptr, M, etrtPOSITION, &cr_, haveConstraints);
+            update.finish_update(inputRecord_, &mdAtoms_, &state, nullptr, haveConstraints);
+        }
+
+        UpdateResult result;
+        result.x.assign(state.x.begin(), state.x.begin() + c_numAtoms);
+        result.v.assign(state.v.begin(), state.v.begin() + c_numAtoms);
+
+        return result;
+    }
+
+    //! Integrates c_numSteps steps with the reference BD update
+    UpdateResult integrateBDReference()
+    {
+        std::vector<real> rf(inputRecord_.opts.ngtc);
+        for (int gt = 0; gt < inputRecord_.opts.ngtc; gt++)
+        {
+            rf[gt] = std::sqrt(2.0 * BOLTZ * inputRecord_.opts.ref_t[gt]);
+            if (inputRecord_.bd_fric != 0)
+            {
+                rf[gt] /= std::sqrt(inputRecord_.bd_fric * inputRecord_.delta_t);
+            }
+        }
+
+        UpdateResult result;
+        result.x.assign(x0_.begin(), x0_.end());
+        result.v.assign(v0_.begin(), v0_.end());
+        for (int step = 0; step < c_numSteps; step++)
+        {
+            bdReferenceUpdate(inputRecord_, mdAtoms_, rf, step, f_, &result.x, &result.v);
+        }
+
+        return result;
+    }
+
+    //! Checks that \p result and \p reference agree within \p tolerance
+    static void checkResultsMatch(const UpdateResult&           result,
+                                  const UpdateResult&           reference,
+                                  const FloatingPointTolerance& tolerance)
+    {
+        for (int i = 0; i < c_numAtoms; i++)
+        {
+            for (int d = 0; d < DIM; d++)
+            {
+                EXPECT_REAL_EQ_TOL(reference.x[i][d], result.x[i][d], tolerance)
+                        << "for x of atom " << i << " dimension " << d;
+                EXPECT_REAL_EQ_TOL(reference.v[i][d], result.v[i][d], tolerance)
+                        << "for v of atom " << i << " dimension " << d;
+            }
+        }
+    }
+
+    //! Checks that virtual sites and frozen dimensions did not move
+    void checkImmobileAtoms(const UpdateResult& result) const
+    {
+        for (int d = 0; d < DIM; d++)
+        {
+            EXPECT_EQ(x0_[c_virtualSiteIndex][d], result.x[c_virtualSiteIndex][d]);
+            EXPECT_EQ(0, result.v[c_virtualSiteIndex][d]);
+        }
+        EXPECT_EQ(x0_[c_frozenAtomIndex][YY], result.x[c_frozenAtomIndex][YY]);
+        EXPECT_EQ(0, result.v[c_frozenAtomIndex][YY]);
+        EXPECT_NE(x0_[c_frozenAtomIndex][XX], result.x[c_frozenAtomIndex][XX]);
+    }
+
+    //! Input record with the integrator and temperature coupling settings
+    t_inputrec inputRecord_;
+    //! Atom data passed to the update
+    t_mdatoms mdAtoms_;
+    //! Inverse masses, aligned for SIMD loads
+    PaddedVector<real> invmass_;
+    //! Particle types
+    std::vector<unsigned short> ptype_;
+    //! Temperature coupling group indices
+    std::vector<unsigned short> cTC_;
+    //! Freeze group indices
+    std::vector<unsigned short> cFREEZE_;
+    //! Acceleration group indices, all zero, used to force the scalar SD update
+    std::vector<unsigned short> cACC_;
+    //! Starting coordinates
+    std::vector<RVec> x0_;
+    //! Starting velocities
+    std::vector<RVec> v0_;
+    //! Forces
+    PaddedVector<RVec> f_;
+    //! Communication record without domain decomposition
+    t_commrec cr_;
+};
+
+//! The tolerance for comparing SIMD and scalar updates, which only differ in rounding
+FloatingPointTolerance simdTolerance()
+{
+    return relativeToleranceAsFloatingPoint(10.0, GMX_DOUBLE ? 1e-12 : 1e-5);
+}
+
+TEST_F(StochasticUpdateTest, SDSimdMatchesScalar)
+{
+    inputRecord_.eI = eiSD1;
+
+    const UpdateResult scalar = integrate(1, true, false);
+    const UpdateResult simd   = integrate(1, false, false);
+
+    checkResultsMatch(simd, scalar, simdTolerance());
+    checkImmobileAtoms(simd);
+}
+
+TEST_F(StochasticUpdateTest, SDSimdMatchesScalarWithConstraints)
+{
+    inputRecord_.eI = eiSD1;
+
+    const UpdateResult scalar = integrate(1, true, true);
+    const UpdateResult simd   = integrate(1, false, true);
+
+    checkResultsMatch(simd, scalar, simdTolerance());
+    checkImmobileAtoms(simd);
+}
+
+TEST_F(StochasticUpdateTest, SDIsIndependentOfThreadCount)
+{
+    inputRecord_.eI = eiSD1;
+
+    const UpdateResult oneThread    = integrate(1, false, false);
+    const UpdateResult threeThreads = integrate(3, false, false);
+
+    checkResultsMatch(threeThreads, oneThread, ulpTolerance(0));
+}
+
+TEST_F(StochasticUpdateTest, BDWithFrictionMatchesScalar)
+{
+    inputRecord_.eI      = eiBD;
+    inputRecord_.bd_fric = 1000;
+
+    const UpdateResult reference = integrateBDReference();
+    const UpdateResult result    = integrate(1, false, false);
+
+    checkResultsMatch(result, reference, simdTolerance());
+    checkImmobileAtoms(result);
+}
+
+TEST_F(StochasticUpdateTest, BDWithoutFrictionMatchesScalar)
+{
+    inputRecord_.eI      = eiBD;
+    inputRecord_.bd_fric = 0;
+
+    const UpdateResult reference = integrateBDReference();
+    const UpdateResult result    = integrate(1, false, false);
+
+    checkResultsMatch(result, reference, simdTolerance());
+    checkImmobileAtoms(result);
+}
+
+TEST_F(StochasticUpdateTest, BDIsIndependentOfThreadCount)
+{
+    inputRecord_.eI      = eiBD;
+    inputRecord_.bd_fric = 0;
+
+    const UpdateResult oneThread    = integrate(1, false, false);
+    const UpdateResult threeThreads = integrate(3, false, false);
+
+    checkResultsMatch(threeThreads, oneThread, ulpTolerance(0));
+}
+
+} // namespace
+} // namespace test
+} // namespace gmx
@@ -132,6 +132,11 @@ public:
                        const t_commrec*                                 cr,
                        bool                                             haveConstraints);
 
+    void update_for_constraint_virial(const t_inputrec&                                inputRecord,
+                                      const t_mdatoms&                                 md,
+                                      const t_state&                                   state,
+                                      const gmx::ArrayRefWithPadding<const gmx::RVec>& f);
+
     void finish_update(const t_inputrec& inputRecord,
                        const t_mdatoms*  md,
                        t_state*          state,
@@ -210,6 +215,14 @@ void Update::update_coords(const t_inputrec&                                inpu
                                 haveConstraints);
 }
 
+void Update::update_for_constraint_virial(const t_inputrec& inputRecord,
+                                          const t_mdatoms&  md,
+                                          const t_state&    state,
+                                          const gmx::ArrayRefWithPadding<const gmx::RVec>& f)
+{
+    return impl_->update_for_constraint_virial(inputRecord, md, state, f);
+}
+
 void Update::finish_update(const t_inputrec& inputRecord,
                            const t_mdatoms*  md,
                            t_state*          state,
@@ -592,6 +605,29 @@ static void updateMDLeapfrogGeneral(int                   start,
     }
 }
 
+/*! \brief Leap-frog position update without updating the velocities
+ *
+ * Only used for computing the constraint virial with multiple time stepping.
+ * Thermostat and barostat scaling is ignored, which is acceptable for the virial.
+ */
+static void doUpdateMDDoNotUpdateVelocities(int         start,
+                                            int         nrend,
+                                            real        dt,
+                                            const rvec* gmx_restrict x,
+                                            rvec* gmx_restrict xprime,
+                                            const rvec* gmx_restrict v,
+                                            const rvec* gmx_restrict f,
+                                            const rvec* gmx_restrict invMassPerDim)
+{
+    for (int a = start; a < nrend; a++)
+    {
+        for (int d = 0; d < DIM; d++)
+        {
+            xprime[a][d] = x[a][d] + (invMassPerDim[a][d] * f[a][d] * dt + v[a][d]) * dt;
+        }
+    }
+}
+
 /*! \brief Handles the Leap-frog MD x and v integration */
 static void do_update_md(int         start,
                          int         nrend,
@@ -1071,6 +1107,266 @@ static void doSDUpdateGeneral(const gmx_stochd_t&  sd,
     }
 }
 
+#if GMX_HAVE_SIMD_UPDATE
+
+/*! \brief Returns whether all GMX_SIMD_REAL_WIDTH atoms starting at \p start move in all dimensions
+ *
+ * Only for such blocks the SIMD SD and BD updates can be used, since virtual sites,
+ * shells and frozen dimensions are not updated and do not consume random numbers.
+ */
+static bool simdBlockIsFullyMobile(int                  start,
+                                   const ivec           nFreeze[],
+                                   const unsigned short ptype[],
+                                   const unsigned short cFREEZE[])
+{
+    for (int n = start; n < start + GMX_SIMD_REAL_WIDTH; n++)
+    {
+        const int freezeGroup = cFREEZE ? cFREEZE[n] : 0;
+        if (ptype[n] == eptVSite || ptype[n] == eptShell || nFreeze[freezeGroup][XX]
+            || nFreeze[freezeGroup][YY] || nFreeze[freezeGroup][ZZ])
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*! \brief Random block generator producing one stream per SIMD lane for the SD and BD updates */
+using SimdUpdateRandomGenerator = gmx::ThreeFry2x64MultiStream<GMX_SIMD_REAL_WIDTH>;
+
+/*! \brief Returns the end of the range, starting at \p start, that can be updated with SIMD
+ *
+ * This is \p start when \p start is not a multiple of the SIMD width, since the SIMD
+ * loads and stores of rvecs need to be aligned.
+ */
+static int simdUpdateRangeEnd(int start, int nrend)
+{
+    if (start % GMX_SIMD_REAL_WIDTH != 0)
+    {
+        return start;
+    }
+    return start + ((nrend - start) / GMX_SIMD_REAL_WIDTH) * GMX_SIMD_REAL_WIDTH;
+}
+
+/*! \brief Generate normally distributed noise for GMX_SIMD_REAL_WIDTH atoms in rvec layout
+ *
+ * The values are identical to those drawn by the scalar SD and BD updates, which
+ * restart ThreeFry2x64<0> with the step and global atom index for each atom and
+ * use TabulatedNormalDistribution<real, 14> for the three dimensions.
+ *
+ * \param[in]  rng       Random block generator, seeded as in the scalar updates
+ * \param[in]  step      The MD step, first word of the random counter
+ * \param[in]  start     Index of the first atom in the block
+ * \param[in]  gatindex  Global atom indices, can be nullptr
+ * \param[out] noise0    Noise for the first GMX_SIMD_REAL_WIDTH rvec elements
+ * \param[out] noise1    Noise for the second GMX_SIMD_REAL_WIDTH rvec elements
+ * \param[out] noise2    Noise for the third GMX_SIMD_REAL_WIDTH rvec elements
+ */
+static inline void simdNormalNoiseRvecs(const SimdUpdateRandomGenerator& rng,
+                                        int64_t                          step,
+                                        int                              start,
+                                        const int*                       gatindex,
+                                        SimdReal*                        noise0,
+                                        SimdReal*                        noise1,
+                                        SimdReal*                        noise2)
+{
+    using NormalDistribution = gmx::TabulatedNormalDistribution<real, 14>;
+    // The number of random bits used for each normal distribution value
+    constexpr int c_bitsPerValue = 14;
+
+    uint64_t counter1[GMX_SIMD_REAL_WIDTH];
+    uint64_t randomBits[GMX_SIMD_REAL_WIDTH];
+    uint64_t unusedBits[GMX_SIMD_REAL_WIDTH];
+    for (int i = 0; i < GMX_SIMD_REAL_WIDTH; i++)
+    {
+        counter1[i] = gatindex ? gatindex[start + i] : start + i;
+    }
+    rng.generateBlocks(step, counter1, randomBits, unusedBits);
+
+    alignas(GMX_SIMD_ALIGNMENT) real noise[DIM * GMX_SIMD_REAL_WIDTH];
+    for (int i = 0; i < GMX_SIMD_REAL_WIDTH; i++)
+    {
+        for (int d = 0; d < DIM; d++)
+        {
+            const uint64_t bits = randomBits[i] >> (d * c_bitsPerValue);
+            noise[i * DIM + d]  = NormalDistribution::standardValueFromBits(bits);
+        }
+    }
+    *noise0 = simdLoad(noise + 0 * GMX_SIMD_REAL_WIDTH);
+    *noise1 = simdLoad(noise + 1 * GMX_SIMD_REAL_WIDTH);
+    *noise2 = simdLoad(noise + 2 * GMX_SIMD_REAL_WIDTH);
+}
+
+/*! \brief SD integrator update using SIMD
+ *
+ * Blocks of GMX_SIMD_REAL_WIDTH atoms that are all fully mobile are updated
+ * with SIMD, other blocks and the remainder use doSDUpdateGeneral().
+ * The random noise is identical to that of doSDUpdateGeneral(), so the results
+ * only differ by floating-point rounding. Only handles a single acceleration group.
+ */
+template<SDUpdate updateType>
+static void doSDUpdateSimd(const gmx_stochd_t&  sd,
+                           int                  start,
+                           int                  nrend,
+                           real                 dt,
+                           const rvec           accel[],
+                           const ivec           nFreeze[],
+                           const real           invmass[],
+                           const unsigned short ptype[],
+                           const unsigned short cFREEZE[],
+                           const unsigned short cTC[],
+                           const rvec           x[],
+                           rvec                 xprime[],
+                           rvec                 v[],
+                           const rvec           f[],
+                           int64_t              step,
+                           int                  seed,
+                           const int*           gatindex)
+{
+    GMX_ASSERT(isSimdAligned(invmass), "invmass should be aligned");
+
+    const SimdUpdateRandomGenerator rng(seed, gmx::RandomDomain::UpdateCoordinates);
+
+    const SimdReal timestep(dt);
+    const SimdReal halfTimestep(0.5 * dt);
+
+    // The acceleration of the single group in rvec layout
+    alignas(GMX_SIMD_ALIGNMENT) real accelRvecs[DIM * GMX_SIMD_REAL_WIDTH];
+    for (int i = 0; i < DIM * GMX_SIMD_REAL_WIDTH; i++)
+    {
+        accelRvecs[i] = accel[0][i % DIM];
+    }
+    const SimdReal accel0 = simdLoad(accelRvecs + 0 * GMX_SIMD_REAL_WIDTH);
+    const SimdReal accel1 = simdLoad(accelRvecs + 1 * GMX_SIMD_REAL_WIDTH);
+    const SimdReal accel2 = simdLoad(accelRvecs + 2 * GMX_SIMD_REAL_WIDTH);
+
+    const int simdEnd = simdUpdateRangeEnd(start, nrend);
+
+    for (int a = start; a < simdEnd; a += GMX_SIMD_REAL_WIDTH)
+    {
+        if (!simdBlockIsFullyMobile(a, nFreeze, ptype, cFREEZE))
+        {
+            doSDUpdateGeneral<updateType>(sd, a, a + GMX_SIMD_REAL_WIDTH, dt, accel, nFreeze,
+                                          invmass, ptype, cFREEZE, nullptr, cTC, x, xprime, v, f,
+                                          step, seed, gatindex);
+            continue;
+        }
+
+        SimdReal v0, v1, v2;
+        simdLoadRvecs(v, a, &v0, &v1, &v2);
+
+        SimdReal vn0 = v0;
+        SimdReal vn1 = v1;
+        SimdReal vn2 = v2;
+        if (updateType != SDUpdate::FrictionAndNoiseOnly)
+        {
+            SimdReal invMass0, invMass1, invMass2;
+            SimdReal f0, f1, f2;
+            expandScalarsToTriplets(simdLoad(invmass + a), &invMass0, &invMass1, &invMass2);
+            simdLoadRvecs(f, a, &f0, &f1, &f2);
+
+            vn0 = fma(fma(invMass0, f0, accel0), timestep, v0);
+            vn1 = fma(fma(invMass1, f1, accel1), timestep, v1);
+            vn2 = fma(fma(invMass2, f2, accel2), timestep, v2);
+        }
+
+        if (updateType == SDUpdate::ForcesOnly)
+        {
+            SimdReal x0, x1, x2;
+            simdLoadRvecs(x, a, &x0, &x1, &x2);
+
+            simdStoreRvecs(v, a, vn0, vn1, vn2);
+            simdStoreRvecs(xprime, a, fma(vn0, timestep, x0), fma(vn1, timestep, x1),
+                           fma(vn2, timestep, x2));
+            continue;
+        }
+
+        // Gather the friction and noise amplitude, which depend on the atom's T-coupling group
+        alignas(GMX_SIMD_ALIGNMENT) real em[GMX_SIMD_REAL_WIDTH];
+        alignas(GMX_SIMD_ALIGNMENT) real sigma[GMX_SIMD_REAL_WIDTH];
+        for (int i = 0; i < GMX_SIMD_REAL_WIDTH; i++)
+        {
+            const int temperatureGroup = cTC ? cTC[a + i] : 0;
+            em[i]                      = sd.sdc[temperatureGroup].em;
+            sigma[i] = std::sqrt(invmass[a + i]) * sd.sdsig[temperatureGroup].V;
+        }
+        SimdReal em0, em1, em2;
+        SimdReal sigma0, sigma1, sigma2;
+        expandScalarsToTriplets(simdLoad(em), &em0, &em1, &em2);
+        expandScalarsToTriplets(simdLoad(sigma), &sigma0, &sigma1, &sigma2);
+
+        SimdReal noise0, noise1, noise2;
+        simdNormalNoiseRvecs(rng, step, a, gatindex, &noise0, &noise1, &noise2);
+
+        v0 = fma(vn0, em0, sigma0 * noise0);
+        v1 = fma(vn1, em1, sigma1 * noise1);
+        v2 = fma(vn2, em2, sigma2 * noise2);
+        simdStoreRvecs(v, a, v0, v1, v2);
+
+        SimdReal xprime0, xprime1, xprime2;
+        if (updateType == SDUpdate::FrictionAndNoiseOnly)
+        {
+            // The previous phase already updated the positions with a full
+            // v*dt term that must now be half removed.
+            simdLoadRvecs(xprime, a, &xprime0, &xprime1, &xprime2);
+            xprime0 = fma(v0 - vn0, halfTimestep, xprime0);
+            xprime1 = fma(v1 - vn1, halfTimestep, xprime1);
+            xprime2 = fma(v2 - vn2, halfTimestep, xprime2);
+        }
+        else
+        {
+            // Here we include half of the friction+noise update of v into the position update
+            simdLoadRvecs(x, a, &xprime0, &xprime1, &xprime2);
+            xprime0 = fma(vn0 + v0, halfTimestep, xprime0);
+            xprime1 = fma(vn1 + v1, halfTimestep, xprime1);
+            xprime2 = fma(vn2 + v2, halfTimestep, xprime2);
+        }
+        simdStoreRvecs(xprime, a, xprime0, xprime1, xprime2);
+    }
+
+    doSDUpdateGeneral<updateType>(sd, simdEnd, nrend, dt, accel, nFreeze, invmass, ptype, cFREEZE,
+                                  nullptr, cTC, x, xprime, v, f, step, seed, gatindex);
+}
+
+#endif // GMX_HAVE_SIMD_UPDATE
+
+/*! \brief SD integrator update, using SIMD when possible
+ *
+ * See doSDUpdateGeneral() for the meaning of the update types and parameters.
+ */
+template<SDUpdate updateType>
+static void doSDUpdate(const gmx_stochd_t&  sd,
+                       int                  start,
+                       int                  nrend,
+                       real                 dt,
+                       const rvec           accel[],
+                       const ivec           nFreeze[],
+                       const real           invmass[],
+                       const unsigned short ptype[],
+                       const unsigned short cFREEZE[],
+                       const unsigned short cACC[],
+                       const unsigned short cTC[],
+                       const rvec           x[],
+                       rvec                 xprime[],
+                       rvec                 v[],
+                       const rvec           f[],
+                       int64_t              step,
+                       int                  seed,
+                       const int*           gatindex)
+{
+#if GMX_HAVE_SIMD_UPDATE
+    /* The SIMD update only supports a single acceleration group */
+    if (cACC == nullptr)
+    {
+        doSDUpdateSimd<updateType>(sd, start, nrend, dt, accel, nFreeze, invmass, ptype, cFREEZE,
+                                   cTC, x, xprime, v, f, step, seed, gatindex);
+        return;
+    }
+#endif
+    doSDUpdateGeneral<updateType>(sd, start, nrend, dt, accel, nFreeze, invmass, ptype, cFREEZE,
+                                  cACC, cTC, x, xprime, v, f, step, seed, gatindex);
+}
+
 static void do_update_sd(int         start,
                          int         nrend,
                          real        dt,
@@ -1094,35 +1390,35 @@ static void do_update_sd(int         start,
     if (haveConstraints)
     {
         // With constraints, the SD update is done in 2 parts
-        doSDUpdateGeneral<SDUpdate::ForcesOnly>(sd, start, nrend, dt, accel, nFreeze, invmass,
-                                                ptype, cFREEZE, cACC, nullptr, x, xprime, v, f,
-                                                step, seed, nullptr);
+        doSDUpdate<SDUpdate::ForcesOnly>(sd, start, nrend, dt, accel, nFreeze, invmass, ptype,
+                                         cFREEZE, cACC, nullptr, x, xprime, v, f, step, seed,
+                                         nullptr);
     }
     else
     {
-        doSDUpdateGeneral<SDUpdate::Combined>(
+        doSDUpdate<SDUpdate::Combined>(
                 sd, start, nrend, dt, accel, nFreeze, invmass, ptype, cFREEZE, cACC, cTC, x, xprime,
                 v, f, step, seed, DOMAINDECOMP(cr) ? cr->dd->globalAtomIndices.data() : nullptr);
     }
 }
 
-static void do_update_bd(int         start,
-                         int         nrend,
-                         real        dt,
-                         int64_t     step,
-                         const rvec* gmx_restrict x,
-                         rvec* gmx_restrict xprime,
-                         rvec* gmx_restrict v,
-                         const rvec* gmx_restrict f,
-                         const ivec               nFreeze[],
-                         const real               invmass[],
-                         const unsigned short     ptype[],
-                         const unsigned short     cFREEZE[],
-                         const unsigned short     cTC[],
-                         real                     friction_coefficient,
-                         const real*              rf,
-                         int                      seed,
-                         const int*               gatindex)
+static void doBDUpdateGeneral(int         start,
+                              int         nrend,
+                              real        dt,
+                              int64_t     step,
+                              const rvec* gmx_restrict x,
+                              rvec* gmx_restrict xprime,
+                              rvec* gmx_restrict v,
+                              const rvec* gmx_restrict f,
+                              const ivec               nFreeze[],
+                              const real               invmass[],
+                              const unsigned short     ptype[],
+                              const unsigned short     cFREEZE[],
+                              const unsigned short     cTC[],
+                              real                     friction_coefficient,
+                              const real*              rf,
+                              int                      seed,
+                              const int*               gatindex)
 {
     /* note -- these appear to be full step velocities . . .  */
     int  gf = 0, gt = 0;
@@ -1181,6 +1477,123 @@ static void do_update_bd(int         start,
     }
 }
 
+#if GMX_HAVE_SIMD_UPDATE
+
+/*! \brief BD integrator update using SIMD
+ *
+ * Blocks of GMX_SIMD_REAL_WIDTH atoms that are all fully mobile are updated
+ * with SIMD, other blocks and the remainder use doBDUpdateGeneral().
+ * The random noise is identical to that of doBDUpdateGeneral(), so the results
+ * only differ by floating-point rounding.
+ */
+static void doBDUpdateSimd(int         start,
+                           int         nrend,
+                           real        dt,
+                           int64_t     step,
+                           const rvec* gmx_restrict x,
+                           rvec* gmx_restrict xprime,
+                           rvec* gmx_restrict v,
+                           const rvec* gmx_restrict f,
+                           const ivec               nFreeze[],
+                           const real               invmass[],
+                           const unsigned short     ptype[],
+                           const unsigned short     cFREEZE[],
+                           const unsigned short     cTC[],
+                           real                     friction_coefficient,
+                           const real*              rf,
+                           int                      seed,
+                           const int*               gatindex)
+{
+    const SimdUpdateRandomGenerator rng(seed, gmx::RandomDomain::UpdateCoordinates);
+
+    const SimdReal timestep(dt);
+    const real     invfr = (friction_coefficient != 0 ? 1.0 / friction_coefficient : 0);
+
+    const int simdEnd = simdUpdateRangeEnd(start, nrend);
+
+    for (int a = start; a < simdEnd; a += GMX_SIMD_REAL_WIDTH)
+    {
+        if (!simdBlockIsFullyMobile(a, nFreeze, ptype, cFREEZE))
+        {
+            doBDUpdateGeneral(a, a + GMX_SIMD_REAL_WIDTH, dt, step, x, xprime, v, f, nFreeze,
+                              invmass, ptype, cFREEZE, cTC, friction_coefficient, rf, seed,
+                              gatindex);
+            continue;
+        }
+
+        // Gather the force and noise prefactors, which depend on the atom's T-coupling group
+        alignas(GMX_SIMD_ALIGNMENT) real forceScale[GMX_SIMD_REAL_WIDTH];
+        alignas(GMX_SIMD_ALIGNMENT) real noiseScale[GMX_SIMD_REAL_WIDTH];
+        for (int i = 0; i < GMX_SIMD_REAL_WIDTH; i++)
+        {
+            const int temperatureGroup = cTC ? cTC[a + i] : 0;
+            if (friction_coefficient != 0)
+            {
+                forceScale[i] = invfr;
+                noiseScale[i] = rf[temperatureGroup];
+            }
+            else
+            {
+                /* NOTE: invmass = 2/(mass*friction_constant*dt) */
+                forceScale[i] = 0.5 * invmass[a + i] * dt;
+                noiseScale[i] = std::sqrt(0.5 * invmass[a + i]) * rf[temperatureGroup];
+            }
+        }
+        SimdReal forceScale0, forceScale1, forceScale2;
+        SimdReal noiseScale0, noiseScale1, noiseScale2;
+        expandScalarsToTriplets(simdLoad(forceScale), &forceScale0, &forceScale1, &forceScale2);
+        expandScalarsToTriplets(simdLoad(noiseScale), &noiseScale0, &noiseScale1, &noiseScale2);
+
+        SimdReal noise0, noise1, noise2;
+        simdNormalNoiseRvecs(rng, step, a, gatindex, &noise0, &noise1, &noise2);
+
+        SimdReal f0, f1, f2;
+        simdLoadRvecs(f, a, &f0, &f1, &f2);
+
+        SimdReal v0 = fma(forceScale0, f0, noiseScale0 * noise0);
+        SimdReal v1 = fma(forceScale1, f1, noiseScale1 * noise1);
+        SimdReal v2 = fma(forceScale2, f2, noiseScale2 * noise2);
+        simdStoreRvecs(v, a, v0, v1, v2);
+
+        SimdReal x0, x1, x2;
+        simdLoadRvecs(x, a, &x0, &x1, &x2);
+        simdStoreRvecs(xprime, a, fma(v0, timestep, x0), fma(v1, timestep, x1),
+                       fma(v2, timestep, x2));
+    }
+
+    doBDUpdateGeneral(simdEnd, nrend, dt, step, x, xprime, v, f, nFreeze, invmass, ptype, cFREEZE,
+                      cTC, friction_coefficient, rf, seed, gatindex);
+}
+
+#endif // GMX_HAVE_SIMD_UPDATE
+
+static void do_update_bd(int         start,
+                         int         nrend,
+                         real        dt,
+                         int64_t     step,
+                         const rvec* gmx_restrict x,
+                         rvec* gmx_restrict xprime,
+                         rvec* gmx_restrict v,
+                         const rvec* gmx_restrict f,
+                         const ivec               nFreeze[],
+                         const real               invmass[],
+                         const unsigned short     ptype[],
+                         const unsigned short     cFREEZE[],
+                         const unsigned short     cTC[],
+                         real                     friction_coefficient,
+                         const real*              rf,
+                         int                      seed,
+                         const int*               gatindex)
+{
+#if GMX_HAVE_SIMD_UPDATE
+    doBDUpdateSimd(start, nrend, dt, step, x, xprime, v, f, nFreeze, invmass, ptype, cFREEZE, cTC,
+                   friction_coefficient, rf, seed, gatindex);
+#else
+    doBDUpdateGeneral(start, nrend, dt, step, x, xprime, v, f, nFreeze, invmass, ptype, cFREEZE,
+                      cTC, friction_coefficient, rf, seed, gatindex);
+#endif
+}
+
 extern void init_ekinstate(ekinstate_t* ekinstate, const t_inputrec* ir)
 {
     ekinstate->ekin_n = ir->opts.ngtc;
@@ -1321,7 +1734,7 @@ void Update::Impl::update_sd_second_half(const t_inputrec& inputRecord,
                 int start_th, end_th;
                 getThreadAtomRange(nth, th, homenr, &start_th, &end_th);
 
-                doSDUpdateGeneral<SDUpdate::FrictionAndNoiseOnly>(
+                doSDUpdate<SDUpdate::FrictionAndNoiseOnly>(
                         sd_, start_th, end_th, dt, inputRecord.opts.acc, inputRecord.opts.nFreeze,
                         md->invmass, md->ptype, md->cFREEZE, nullptr, md->cTC, state->x.rvec_array(),
                         xp_.rvec_array(), state->v.rvec_array(), nullptr, step, inputRecord.ld_seed,
@@ -1395,6 +1808,38 @@ void Update::Impl::finish_update(const t_inputrec& inputRecord,
     wallcycle_stop(wcycle, ewcUPDATE);
 }
 
+void Update::Impl::update_for_constraint_virial(const t_inputrec& inputRecord,
+                                                const t_mdatoms&  md,
+                                                const t_state&    state,
+                                                const gmx::ArrayRefWithPadding<const gmx::RVec>& f)
+{
+    GMX_ASSERT(inputRecord.eI == eiMD, "Only leap-frog is supported");
+
+    /* Cast to real for faster code, no loss in precision */
+    const real dt = inputRecord.delta_t;
+
+    const int nth = gmx_omp_nthreads_get(emntUpdate);
+
+#pragma omp parallel for num_threads(nth) schedule(static)
+    for (int th = 0; th < nth; th++)
+    {
+        try
+        {
+            int start_th, end_th;
+            getThreadAtomRange(nth, th, md.homenr, &start_th, &end_th);
+
+            const rvec* x_rvec  = state.x.rvec_array();
+            rvec*       xp_rvec = xp_.rvec_array();
+            const rvec* v_rvec  = state.v.rvec_array();
+            const rvec* f_rvec  = as_rvec_array(f.unpaddedConstArrayRef().data());
+
+            doUpdateMDDoNotUpdateVelocities(start_th, end_th, dt, x_rvec, xp_rvec, v_rvec, f_rvec,
+                                            md.invMassPerDim);
+        }
+        GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR
+    }
+}
+
 void Update::Impl::update_coords(const t_inputrec&                                inputRecord,
                                  int64_t                                          step,
                                  const t_mdatoms*                                 md,
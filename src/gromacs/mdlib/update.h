@@ -126,6 +126,23 @@ public:
                        const t_commrec*                                 cr,
                        bool                                             haveConstraints);
 
+    /*! \brief Performs a leap-frog update without updating \p state so the constrain virial
+     * can be computed.
+     *
+     * This is used with multiple time stepping, where the actual update uses
+     * the forces with the slow forces scaled by the MTS factor, which would
+     * give a constraint virial that is too large.
+     *
+     * \param[in] inputRecord  Input record.
+     * \param[in] md           MD atoms data.
+     * \param[in] state        System state object.
+     * \param[in] f            Buffer with the normal (not MTS-combined) forces.
+     */
+    void update_for_constraint_virial(const t_inputrec&                                inputRecord,
+                                      const t_mdatoms&                                 md,
+                                      const t_state&                                   state,
+                                      const gmx::ArrayRefWithPadding<const gmx::RVec>& f);
+
     /*! \brief Finalize the coordinate update.
      *
      * Copy the updated coordinates to the main coordinates buffer for the atoms that are not frozen.
@@ -260,7 +260,7 @@ void gmx::LegacySimulator::do_md()
     const bool doSimulatedAnnealing = initSimulatedAnnealing(ir, &upd);
     const bool useReplicaExchange   = (replExParams.exchangeInterval > 0);
 
-    const t_fcdata& fcdata = fr->listedForces->fcdata();
+    const t_fcdata& fcdata = fr->listedForces[0].fcdata();
 
     bool simulationsShareState = false;
     int  nstSignalComm         = nstglobalcomm;
@@ -305,6 +305,22 @@ void gmx::LegacySimulator::do_md()
     shellfc = init_shell_flexcon(fplog, top_global, constr ? constr->numFlexibleConstraints() : 0,
                                  ir->nstcalcenergy, DOMAINDECOMP(cr));
 
+    if (ir->useMts)
+    {
+        if (shellfc)
+        {
+            gmx_fatal(FARGS,
+                      "Multiple time stepping is not supported with shells or flexible "
+                      "constraints");
+        }
+        if (useReplicaExchange && replExParams.exchangeInterval % ir->mtsLevels[1].stepFactor != 0)
+        {
+            gmx_fatal(FARGS,
+                      "With multiple time stepping, the replica exchange interval should be a "
+                      "multiple of mts-level2-factor");
+        }
+    }
+
     {
         double io = compute_io(ir, top_global->natoms, *groups, energyOutput.numEnergyTerms(), 1);
         if ((io > 2000) && MASTER(cr))
@@ -786,6 +802,13 @@ void gmx::LegacySimulator::do_md()
          */
         bLastStep = bLastStep || stopHandler->stoppingAfterCurrentStep(bNS);
 
+        /* With multiple time stepping we can only compute energies at steps
+         * where the slow forces are computed, so we only output energies
+         * at the last step when it is such a step.
+         */
+        const bool bLastStepWithEnergies =
+                (bLastStep && (!ir->useMts || step % ir->mtsLevels[1].stepFactor == 0));
+
         /* do_log triggers energy and virial calculation. Because this leads
          * to different code paths, forces can be different. Thus for exact
          * continuation we should avoid extra log output.
@@ -793,7 +816,8 @@ void gmx::LegacySimulator::do_md()
          * beyond the last step. But we don't consider that to be an issue.
          */
         do_log     = (do_per_step(step, ir->nstlog)
-                  || (bFirstStep && startingBehavior == StartingBehavior::NewSimulation) || bLastStep);
+                  || (bFirstStep && startingBehavior == StartingBehavior::NewSimulation)
+                  || bLastStepWithEnergies);
         do_verbose = mdrunOptions.verbose
                      && (step % mdrunOptions.verboseStepPrintInterval == 0 || bFirstStep || bLastStep);
 
@@ -899,7 +923,7 @@ void gmx::LegacySimulator::do_md()
         }
         bCalcEner = bCalcEnerStep;
 
-        do_ene = (do_per_step(step, ir->nstenergy) || bLastStep);
+        do_ene = (do_per_step(step, ir->nstenergy) || bLastStepWithEnergies);
 
         if (do_ene || do_log || bDoReplEx)
         {
@@ -1158,6 +1182,12 @@ void gmx::LegacySimulator::do_md()
          * coordinates at time t. We must output all of this before
          * the update.
          */
+        if (ir->bPull && checkpointHandler->isCheckpointingStep())
+        {
+            /* Buffered binary pull output should be in the files before
+             * their positions are stored in the checkpoint. */
+            pull_flush_output(pull_work);
+        }
         do_md_trajectory_writing(fplog, cr, nfile, fnm, step, step_rel, t, ir, state, state_global,
                                  observablesHistory, top_global, fr, outf, energyOutput, ekind, f,
                                  checkpointHandler->isCheckpointingStep(), bRerunMD, bLastStep,
@@ -1295,13 +1325,41 @@ void gmx::LegacySimulator::do_md()
         }
         else
         {
-            upd.update_coords(*ir, step, mdatoms, state, f.arrayRefWithPadding(), fcdata, ekind, M,
-                              etrtPOSITION, cr, constr != nullptr);
+            /* With multiple time stepping we need to do an additional normal
+             * update step to obtain the constraint virial, as the actual MTS
+             * integration uses forces where the slow forces are multiplied
+             * by the MTS factor, which would result in a constraint virial
+             * with a slow force contribution that is that factor too large.
+             * We pass no velocities, so these are not modified here.
+             */
+            const bool computeMtsConstraintVirial = (fr->useMts && bCalcVir && constr != nullptr);
+            if (computeMtsConstraintVirial)
+            {
+                upd.update_for_constraint_virial(*ir, *mdatoms, *state, f.arrayRefWithPadding());
+
+                constr->apply(false, false, step, 1, 1.0, state->x.arrayRefWithPadding(),
+                              upd.xp()->arrayRefWithPadding(), {}, state->box,
+                              state->lambda[efptBONDED], &dvdl_constr, {}, true, shake_vir,
+                              ConstraintVariable::Positions);
+            }
+
+            /* With MTS, at steps where the slow forces are computed, we integrate
+             * with the fast forces plus the slow forces scaled by the MTS factor
+             */
+            const bool useMtsCombinedForces =
+                    (fr->useMts && step % ir->mtsLevels[1].stepFactor == 0);
+            upd.update_coords(*ir, step, mdatoms, state,
+                              useMtsCombinedForces ? fr->forceMtsCombined.arrayRefWithPadding()
+                                                   : f.arrayRefWithPadding(),
+                              fcdata, ekind, M, etrtPOSITION, cr, constr != nullptr);
 
             wallcycle_stop(wcycle, ewcUPDATE);
 
+            real dvdlConstrMts = 0;
             constrain_coordinates(constr, do_log, do_ene, step, state,
-                                  upd.xp()->arrayRefWithPadding(), &dvdl_constr, bCalcVir, shake_vir);
+                                  upd.xp()->arrayRefWithPadding(),
+                                  computeMtsConstraintVirial ? &dvdlConstrMts : &dvdl_constr,
+                                  bCalcVir && !computeMtsConstraintVirial, shake_vir);
 
             upd.update_sd_second_half(*ir, step, &dvdl_constr, mdatoms, state, cr, nrnb, wcycle,
                                       constr, do_log, do_ene);
@@ -1527,7 +1585,7 @@ void gmx::LegacySimulator::do_md()
             {
                 energyOutput.printStepToEnergyFile(mdoutf_get_fp_ene(outf), do_ene, do_dr, do_or,
                                                    do_log ? fplog : nullptr, step, t,
-                                                   &fr->listedForces->fcdata(), awh.get());
+                                                   &fr->listedForces[0].fcdata(), awh.get());
             }
 
             if (ir->bPull)
@@ -1128,7 +1128,7 @@ void LegacySimulator::do_cg()
 
         EnergyOutput::printHeader(fplog, step, step);
         energyOutput.printStepToEnergyFile(mdoutf_get_fp_ene(outf), TRUE, FALSE, FALSE, fplog, step,
-                                           step, &fr->listedForces->fcdata(), nullptr);
+                                           step, &fr->listedForces[0].fcdata(), nullptr);
     }
 
     /* Estimate/guess the initial stepsize */
@@ -1544,7 +1544,7 @@ void LegacySimulator::do_cg()
             }
             energyOutput.printStepToEnergyFile(mdoutf_get_fp_ene(outf), do_ene, FALSE, FALSE,
                                                do_log ? fplog : nullptr, step, step,
-                                               &fr->listedForces->fcdata(), nullptr);
+                                               &fr->listedForces[0].fcdata(), nullptr);
         }
 
         /* Send energies and positions to the IMD client if bIMD is TRUE. */
@@ -1588,7 +1588,7 @@ void LegacySimulator::do_cg()
             /* Write final energy file entries */
             energyOutput.printStepToEnergyFile(mdoutf_get_fp_ene(outf), !do_ene, FALSE, FALSE,
                                                !do_log ? fplog : nullptr, step, step,
-                                               &fr->listedForces->fcdata(), nullptr);
+                                               &fr->listedForces[0].fcdata(), nullptr);
         }
     }
 
@@ -1776,7 +1776,7 @@ void LegacySimulator::do_lbfgs()
 
         EnergyOutput::printHeader(fplog, step, step);
         energyOutput.printStepToEnergyFile(mdoutf_get_fp_ene(outf), TRUE, FALSE, FALSE, fplog, step,
-                                           step, &fr->listedForces->fcdata(), nullptr);
+                                           step, &fr->listedForces[0].fcdata(), nullptr);
     }
 
     /* Set the initial step.
@@ -2269,7 +2269,7 @@ void LegacySimulator::do_lbfgs()
             }
             energyOutput.printStepToEnergyFile(mdoutf_get_fp_ene(outf), do_ene, FALSE, FALSE,
                                                do_log ? fplog : nullptr, step, step,
-                                               &fr->listedForces->fcdata(), nullptr);
+                                               &fr->listedForces[0].fcdata(), nullptr);
         }
 
         /* Send x and E to IMD client, if bIMD is TRUE. */
@@ -2312,7 +2312,7 @@ void LegacySimulator::do_lbfgs()
     {
         energyOutput.printStepToEnergyFile(mdoutf_get_fp_ene(outf), !do_ene, FALSE, FALSE,
                                            !do_log ? fplog : nullptr, step, step,
-                                           &fr->listedForces->fcdata(), nullptr);
+                                           &fr->listedForces[0].fcdata(), nullptr);
     }
 
     /* Print some stuff... */
@@ -2474,8 +2474,9 @@ void LegacySimulator::do_steep()
 
                 const bool do_dr = do_per_step(steps_accepted, inputrec->nstdisreout);
                 const bool do_or = do_per_step(steps_accepted, inputrec->nstorireout);
-                energyOutput.printStepToEnergyFile(mdoutf_get_fp_ene(outf), TRUE, do_dr, do_or, fplog,
-                                                   count, count, &fr->listedForces->fcdata(), nullptr);
+                energyOutput.printStepToEnergyFile(
+                        mdoutf_get_fp_ene(outf), TRUE, do_dr, do_or, fplog, count, count,
+                        &fr->listedForces[0].fcdata(), nullptr);
                 fflush(fplog);
             }
         }
@@ -241,6 +241,10 @@ void gmx::LegacySimulator::do_rerun()
     {
         gmx_fatal(FARGS, "Interactive MD not supported by rerun.");
     }
+    if (ir->useMts)
+    {
+        gmx_fatal(FARGS, "Multiple time stepping not supported by rerun.");
+    }
     if (isMultiSim(ms))
     {
         gmx_fatal(FARGS, "Multiple simulations not supported by rerun.");
@@ -607,7 +611,7 @@ void gmx::LegacySimulator::do_rerun()
             EnergyOutput::printAnnealingTemperatures(do_log ? fplog : nullptr, groups, &(ir->opts));
             energyOutput.printStepToEnergyFile(mdoutf_get_fp_ene(outf), do_ene, do_dr, do_or,
                                                do_log ? fplog : nullptr, step, t,
-                                               &fr->listedForces->fcdata(), awh);
+                                               &fr->listedForces[0].fcdata(), awh);
 
             if (do_per_step(step, ir->nstlog))
             {
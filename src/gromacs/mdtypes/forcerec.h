@@ -42,6 +42,7 @@
 #include <memory>
 #include <vector>
 
+#include "gromacs/math/paddedvector.h"
 #include "gromacs/math/vectypes.h"
 #include "gromacs/mdtypes/md_enums.h"
 #include "gromacs/pbcutil/pbc.h"
@@ -256,8 +257,13 @@ struct t_forcerec
     /* The number of atoms participating in force calculation and constraints */
     int natoms_force_constr = 0;
 
-    /* Helper buffer for ForceOutputs */
-    std::unique_ptr<ForceHelperBuffers> forceHelperBuffers;
+    /* Helper buffer for ForceOutputs, one per MTS level */
+    std::vector<ForceHelperBuffers> forceHelperBuffers;
+
+    /* Whether we use multiple time stepping */
+    bool useMts = false;
+    /* With MTS, the force buffer for the combined fast and slow forces on slow steps */
+    gmx::PaddedVector<gmx::RVec> forceMtsCombined;
 
     /* Data for PPPM/PME/Ewald */
     struct gmx_pme_t* pmedata                = nullptr;
@@ -298,8 +304,8 @@ struct t_forcerec
     real userreal3 = 0;
     real userreal4 = 0;
 
-    /* The listed forces calculation data */
-    std::unique_ptr<ListedForces> listedForces;
+    /* The listed forces calculation data, 1 entry or 2 entries with multiple time stepping */
+    std::vector<ListedForces> listedForces;
 
     /* TODO: Replace the pointer by an object once we got rid of C */
     gmx::GpuBonded* gpuBonded = nullptr;
@@ -41,9 +41,11 @@
 #include <cstdio>
 
 #include <memory>
+#include <vector>
 
 #include "gromacs/math/vectypes.h"
 #include "gromacs/mdtypes/md_enums.h"
+#include "gromacs/mdtypes/multipletimestepping.h"
 #include "gromacs/utility/basedefinitions.h"
 #include "gromacs/utility/real.h"
 
@@ -324,6 +326,10 @@ struct t_inputrec // NOLINT (clang-analyzer-optin.performance.Padding)
     int64_t init_step;
     //! Frequency of energy calc. and T/P coupl. upd.
     int nstcalcenergy;
+    //! Whether we use multiple time stepping
+    bool useMts;
+    //! The multiple time stepping levels, empty without MTS
+    std::vector<gmx::MtsLevel> mtsLevels;
     //! Group or verlet cutoffs
     int cutoff_scheme;
     //! Number of steps before pairlist is generated
@@ -0,0 +1,220 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2021, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief Implements functions for setting up and checking multiple time stepping
+ *
+ * \ingroup module_mdtypes
+ */
+#include "gmxpre.h"
+
+#include "multipletimestepping.h"
+
+#include <cinttypes>
+
+#include "gromacs/mdtypes/awh_params.h"
+#include "gromacs/mdtypes/inputrec.h"
+#include "gromacs/mdtypes/md_enums.h"
+#include "gromacs/mdtypes/pull_params.h"
+#include "gromacs/utility/gmxassert.h"
+#include "gromacs/utility/stringutil.h"
+
+namespace gmx
+{
+
+std::vector<MtsLevel> setupMtsLevels(const int                 numLevels,
+                                     const std::string&        level2Forces,
+                                     const int                 level2Factor,
+                                     std::vector<std::string>* errorMessages)
+{
+    GMX_RELEASE_ASSERT(errorMessages, "Need a valid error message list");
+
+    if (numLevels != 2)
+    {
+        errorMessages->push_back("Only mts-levels = 2 is supported");
+        return {};
+    }
+
+    std::vector<MtsLevel> mtsLevels(numLevels);
+
+    for (const std::string& forceGroupName : splitString(level2Forces))
+    {
+        bool found = false;
+        for (const auto mtsForceGroup : keysOf(c_mtsForceGroupNames))
+        {
+            if (equalCaseInsensitive(forceGroupName, c_mtsForceGroupNames[mtsForceGroup]))
+            {
+                mtsLevels[1].forceGroups.set(static_cast<int>(mtsForceGroup));
+                found = true;
+            }
+        }
+        if (!found)
+        {
+            errorMessages->push_back(
+                    formatString("Unknown MTS force group '%s'", forceGroupName.c_str()));
+        }
+    }
+    if (mtsLevels[1].forceGroups.none())
+    {
+        errorMessages->push_back("mts-level2-forces should contain at least one force group");
+    }
+    /* All groups not assigned to level 2 are computed every step */
+    mtsLevels[0].forceGroups = ~mtsLevels[1].forceGroups;
+
+    if (level2Factor < 2)
+    {
+        errorMessages->push_back("mts-level2-factor should be larger than 1");
+    }
+    mtsLevels[0].stepFactor = 1;
+    mtsLevels[1].stepFactor = level2Factor;
+
+    return mtsLevels;
+}
+
+int forceGroupMtsLevel(ArrayRef<const MtsLevel> mtsLevels, const MtsForceGroups mtsForceGroup)
+{
+    for (gmx::index level = mtsLevels.ssize() - 1; level > 0; level--)
+    {
+        if (mtsLevels[level].forceGroups[static_cast<int>(mtsForceGroup)])
+        {
+            return level;
+        }
+    }
+
+    return 0;
+}
+
+namespace
+{
+
+//! Adds an error message to \p errorMessages when \p nstValue is not a multiple of \p mtsFactor
+void checkMtsInterval(const char*               nstName,
+                      const int64_t             nstValue,
+                      const int                 mtsFactor,
+                      std::vector<std::string>* errorMessages)
+{
+    if (nstValue % mtsFactor != 0)
+    {
+        errorMessages->push_back(formatString(
+                "With MTS, %s = %" PRId64 " should be a multiple of mts-level2-factor = %d",
+                nstName, nstValue, mtsFactor));
+    }
+}
+
+} // namespace
+
+std::vector<std::string> checkMtsRequirements(const t_inputrec& ir)
+{
+    std::vector<std::string> errorMessages;
+
+    if (!ir.useMts)
+    {
+        return errorMessages;
+    }
+
+    if (ir.eI != eiMD)
+    {
+        errorMessages.push_back(formatString(
+                "Multiple time stepping is only supported with integrator %s", ei_names[eiMD]));
+    }
+
+    if (ir.mtsLevels.size() != 2)
+    {
+        /* Errors in the MTS level setup have been reported already */
+        return errorMessages;
+    }
+
+    ArrayRef<const MtsLevel> mtsLevels = ir.mtsLevels;
+    const int                mtsFactor = mtsLevels[1].stepFactor;
+
+    if (forceGroupMtsLevel(mtsLevels, MtsForceGroups::LongrangeNonbonded) > 0
+        && !(EEL_FULL(ir.coulombtype) || EVDW_PME(ir.vdwtype)))
+    {
+        errorMessages.push_back(formatString(
+                "The MTS force group %s requires Ewald-type electrostatics or LJ-PME",
+                c_mtsForceGroupNames[MtsForceGroups::LongrangeNonbonded]));
+    }
+    if (forceGroupMtsLevel(mtsLevels, MtsForceGroups::Pull) > 0 && !ir.bPull)
+    {
+        errorMessages.push_back(formatString("The MTS force group %s requires pulling",
+                                             c_mtsForceGroupNames[MtsForceGroups::Pull]));
+    }
+    if (forceGroupMtsLevel(mtsLevels, MtsForceGroups::Awh) > 0 && !ir.bDoAwh)
+    {
+        errorMessages.push_back(formatString("The MTS force group %s requires AWH",
+                                             c_mtsForceGroupNames[MtsForceGroups::Awh]));
+    }
+    if (ir.bDoAwh
+        && forceGroupMtsLevel(mtsLevels, MtsForceGroups::Pull)
+                   != forceGroupMtsLevel(mtsLevels, MtsForceGroups::Awh))
+    {
+        errorMessages.push_back(
+                "With AWH, the pull and awh force groups should be computed at the same MTS level");
+    }
+
+    /* Energies, virials and forces are only complete at steps
+     * where all force groups are computed.
+     */
+    checkMtsInterval("init-step", ir.init_step, mtsFactor, &errorMessages);
+    checkMtsInterval("nstcalcenergy", ir.nstcalcenergy, mtsFactor, &errorMessages);
+    checkMtsInterval("nstenergy", ir.nstenergy, mtsFactor, &errorMessages);
+    checkMtsInterval("nstlog", ir.nstlog, mtsFactor, &errorMessages);
+    checkMtsInterval("nstfout", ir.nstfout, mtsFactor, &errorMessages);
+    if (ir.efep != efepNO)
+    {
+        checkMtsInterval("nstdhdl", ir.fepvals->nstdhdl, mtsFactor, &errorMessages);
+    }
+    if (ir.bExpanded)
+    {
+        checkMtsInterval("nstexpanded", ir.expandedvals->nstexpanded, mtsFactor, &errorMessages);
+    }
+    if (ir.epc != epcNO)
+    {
+        checkMtsInterval("nstpcouple", ir.nstpcouple, mtsFactor, &errorMessages);
+    }
+    if (ir.bPull && forceGroupMtsLevel(mtsLevels, MtsForceGroups::Pull) > 0)
+    {
+        checkMtsInterval("pull-nstxout", ir.pull->nstxout, mtsFactor, &errorMessages);
+        checkMtsInterval("pull-nstfout", ir.pull->nstfout, mtsFactor, &errorMessages);
+    }
+    if (ir.bDoAwh && forceGroupMtsLevel(mtsLevels, MtsForceGroups::Awh) > 0)
+    {
+        checkMtsInterval("awh-nstsample", ir.awhParams->nstSampleCoord, mtsFactor, &errorMessages);
+        checkMtsInterval("awh-nstout", ir.awhParams->nstOut, mtsFactor, &errorMessages);
+    }
+
+    return errorMessages;
+}
+
+} // namespace gmx
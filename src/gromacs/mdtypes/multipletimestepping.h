@@ -0,0 +1,115 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2021, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \libinternal \file
+ * \brief Defines the force groups and settings for multiple time stepping
+ *
+ * \ingroup module_mdtypes
+ * \inlibraryapi
+ */
+#ifndef GMX_MDTYPES_MULTIPLETIMESTEPPING_H
+#define GMX_MDTYPES_MULTIPLETIMESTEPPING_H
+
+#include <bitset>
+#include <string>
+#include <vector>
+
+#include "gromacs/utility/arrayref.h"
+#include "gromacs/utility/enumerationhelpers.h"
+
+struct t_inputrec;
+
+namespace gmx
+{
+
+/*! \brief Force groups that can be integrated with a larger time step
+ *
+ * All forces not in one of these groups are integrated every step.
+ */
+enum class MtsForceGroups : int
+{
+    LongrangeNonbonded, //!< PME-mesh or Ewald for electrostatics and/or LJ
+    Dihedral,           //!< Dihedrals, including cmap (not restraints)
+    Pull,               //!< COM pulling
+    Awh,                //!< Accelerated weight histogram method
+    Count               //!< The number of groups above
+};
+
+//! Names of the MTS force groups, as used in the mdp options
+static const EnumerationArray<MtsForceGroups, const char*> c_mtsForceGroupNames = {
+    { "longrange-nonbonded", "dihedral", "pull", "awh" }
+};
+
+//! Setting for a single level of multiple time step integration
+struct MtsLevel
+{
+    //! The force groups that are computed at this level
+    std::bitset<static_cast<int>(MtsForceGroups::Count)> forceGroups;
+    //! The factor between the time step of this level and the base, fastest, time step
+    int stepFactor = 1;
+};
+
+/*! \brief Sets up and returns the MTS levels from the mdp option values
+ *
+ * The first level contains all force groups not assigned to the second level
+ * and has step factor 1.
+ *
+ * \param[in]  numLevels      The number of MTS levels, only 2 is supported
+ * \param[in]  level2Forces   Whitespace separated list of force group names for level 2
+ * \param[in]  level2Factor   The step factor for level 2
+ * \param[out] errorMessages  List of error messages, appended to for each invalid setting
+ */
+std::vector<MtsLevel> setupMtsLevels(int                       numLevels,
+                                     const std::string&        level2Forces,
+                                     int                       level2Factor,
+                                     std::vector<std::string>* errorMessages);
+
+/*! \brief Returns the MTS level at which \p mtsForceGroup is computed
+ *
+ * Returns 0 when \p mtsLevels is empty, i.e. without MTS.
+ */
+int forceGroupMtsLevel(ArrayRef<const MtsLevel> mtsLevels, MtsForceGroups mtsForceGroup);
+
+/*! \brief Checks whether the MTS setup in \p ir is consistent with the other settings
+ *
+ * All output intervals that involve energies or forces that depend on
+ * the slow forces should be multiples of the MTS step factor.
+ *
+ * \returns a list of error messages, empty when the setup is consistent
+ */
+std::vector<std::string> checkMtsRequirements(const t_inputrec& ir);
+
+} // namespace gmx
+
+#endif // GMX_MDTYPES_MULTIPLETIMESTEPPING_H
@@ -216,6 +216,10 @@ bool ModularSimulator::isInputCompatible(bool                             exitOn
     isInputCompatible =
             isInputCompatible
             && conditionalAssert(!doRerun, "Rerun is not supported by the modular simulator.");
+    isInputCompatible = isInputCompatible
+                        && conditionalAssert(!inputrec->useMts,
+                                             "Multiple time stepping is not supported by the "
+                                             "modular simulator.");
     isInputCompatible =
             isInputCompatible
             && conditionalAssert(
@@ -361,7 +365,7 @@ void ModularSimulator::checkInputForDisabledFunctionality()
     isInputCompatible(true, legacySimulatorData_->inputrec,
                       legacySimulatorData_->mdrunOptions.rerun, *legacySimulatorData_->top_global,
                       legacySimulatorData_->ms, legacySimulatorData_->replExParams,
-                      &legacySimulatorData_->fr->listedForces->fcdata(),
+                      &legacySimulatorData_->fr->listedForces[0].fcdata(),
                       opt2bSet("-ei", legacySimulatorData_->nfile, legacySimulatorData_->fnm),
                       legacySimulatorData_->membed != nullptr);
     if (legacySimulatorData_->observablesHistory->edsamHistory)
@@ -238,6 +238,13 @@ void nbnxn_init_pairlist_fep(t_nblist* nl)
     nl->jindex   = nullptr;
     nl->jjnr     = nullptr;
     nl->excl_fep = nullptr;
+
+#if GMX_SIMD_HAVE_REAL && GMX_SIMD_HAVE_INT32_ARITHMETICS && GMX_USE_SIMD_KERNELS
+    /* The SIMD free-energy kernel processes j-particles in chunks of the SIMD width */
+    nl->simd_padding_width = GMX_SIMD_REAL_WIDTH;
+#else
+    nl->simd_padding_width = 1;
+#endif
 }
 
 static constexpr int sizeNeededForBufferFlags(const int numAtoms)
@@ -1434,9 +1441,24 @@ static void setExclusionsForIEntry(const Nbnxm::GridSet&   gridSet,
     }
 }
 
+/* Pad the j-list of the last i-entry of the FEP list with -1 entries
+ * up to a multiple of the SIMD padding width of the list.
+ */
+static inline void fep_list_pad_j(t_nblist* nlist)
+{
+    while ((nlist->nrj - nlist->jindex[nlist->nri]) % nlist->simd_padding_width != 0)
+    {
+        nlist->jjnr[nlist->nrj]     = -1;
+        nlist->excl_fep[nlist->nrj] = 0;
+        nlist->nrj++;
+    }
+}
+
 /* Add a new i-entry to the FEP list and copy the i-properties */
 static inline void fep_list_new_nri_copy(t_nblist* nlist)
 {
+    fep_list_pad_j(nlist);
+
     /* Add a new i-entry */
     nlist->nri++;
 
@@ -1473,6 +1495,32 @@ static void reallocate_nblist(t_nblist* nl)
  */
 const int max_nrj_fep = 40;
 
+/* Returns the maximum nrj size of an i-entry, max_nrj_fep rounded up
+ * to a multiple of the SIMD padding width, so splitting does not add padding.
+ */
+static inline int fep_list_max_nrj_per_entry(const t_nblist* nlist)
+{
+    return ((max_nrj_fep + nlist->simd_padding_width - 1) / nlist->simd_padding_width)
+           * nlist->simd_padding_width;
+}
+
+/* Returns the j-list size needed for adding \p numPairs pairs to the FEP list.
+ * Each i-entry adds at most simd_padding_width - 1 padding elements.
+ * A new i-entry is started when an entry reaches \p maxNrjPerEntry pairs
+ * and, with multiple energy groups, when the energy group pair changes.
+ * In the latter case, in the worst case every pair gets its own i-entry.
+ */
+static inline int fep_list_nrj_max(const t_nblist* nlist,
+                                   int              numPairs,
+                                   int              maxNrjPerEntry,
+                                   bool             multipleEnergyGroups)
+{
+    const int maxNumEntries =
+            multipleEnergyGroups ? numPairs : (numPairs + maxNrjPerEntry - 1) / maxNrjPerEntry;
+
+    return nlist->nrj + numPairs + maxNumEntries * (nlist->simd_padding_width - 1);
+}
+
 /* Exclude the perturbed pairs from the Verlet list. This is only done to avoid
  * singularities for overlapping particles (0/0), since the charges and
  * LJ parameters have been zeroed in the nbnxn data structure.
@@ -1522,6 +1570,8 @@ static void make_fep_list(gmx::ArrayRef<const int> atomIndices,
         reallocate_nblist(nlist);
     }
 
+    const int maxNrjPerEntry = fep_list_max_nrj_per_entry(nlist);
+
     const int numAtomsJCluster = jGrid.geometry().numAtomsJCluster;
 
     const nbnxn_atomdata_t::Params& nbatParams = nbat->params();
@@ -1561,9 +1611,11 @@ static void make_fep_list(gmx::ArrayRef<const int> atomIndices,
 
             bFEP_i_all = bFEP_i_all && bFEP_i;
 
-            if (nlist->nrj + (cj_ind_end - cj_ind_start) * nbl->na_cj > nlist->maxnrj)
+            const int nrjMax = fep_list_nrj_max(
+                    nlist, (cj_ind_end - cj_ind_start) * nbl->na_cj, maxNrjPerEntry, ngid > 1);
+            if (nrjMax > nlist->maxnrj)
             {
-                nlist->maxnrj = over_alloc_small(nlist->nrj + (cj_ind_end - cj_ind_start) * nbl->na_cj);
+                nlist->maxnrj = over_alloc_small(nrjMax);
                 srenew(nlist->jjnr, nlist->maxnrj);
                 srenew(nlist->excl_fep, nlist->maxnrj);
             }
@@ -1637,7 +1689,7 @@ static void make_fep_list(gmx::ArrayRef<const int> atomIndices,
                                 nlist->gid[nri] = gid;
                             }
 
-                            if (nlist->nrj - nlist->jindex[nri] >= max_nrj_fep)
+                            if (nlist->nrj - nlist->jindex[nri] >= maxNrjPerEntry)
                             {
                                 fep_list_new_nri_copy(nlist);
                                 nri = nlist->nri;
@@ -1663,6 +1715,7 @@ static void make_fep_list(gmx::ArrayRef<const int> atomIndices,
             if (nlist->nrj > nlist->jindex[nri])
             {
                 /* Actually add this new, non-empty, list */
+                fep_list_pad_j(nlist);
                 nlist->nri++;
                 nlist->jindex[nlist->nri] = nlist->nrj;
             }
@@ -1743,6 +1796,8 @@ static void make_fep_list(gmx::ArrayRef<const int> atomIndices,
         reallocate_nblist(nlist);
     }
 
+    const int maxNrjPerEntry = fep_list_max_nrj_per_entry(nlist);
+
     /* Loop over the atoms in the i super-cluster */
     for (int c = 0; c < c_gpuNumClusterPerCell; c++)
     {
@@ -1767,7 +1822,8 @@ static void make_fep_list(gmx::ArrayRef<const int> atomIndices,
                 yi = nbat->x()[ind_i * nbat->xstride + YY] + shy;
                 zi = nbat->x()[ind_i * nbat->xstride + ZZ] + shz;
 
-                const int nrjMax = nlist->nrj + numJClusterGroups * c_nbnxnGpuJgroupSize * nbl->na_cj;
+                const int numPairsMax = numJClusterGroups * c_nbnxnGpuJgroupSize * nbl->na_cj;
+                const int nrjMax = fep_list_nrj_max(nlist, numPairsMax, maxNrjPerEntry, false);
                 if (nrjMax > nlist->maxnrj)
                 {
                     nlist->maxnrj = over_alloc_small(nrjMax);
@@ -1823,7 +1879,7 @@ static void make_fep_list(gmx::ArrayRef<const int> atomIndices,
                                      */
                                     if (dx * dx + dy * dy + dz * dz < rlist_fep2)
                                     {
-                                        if (nlist->nrj - nlist->jindex[nri] >= max_nrj_fep)
+                                        if (nlist->nrj - nlist->jindex[nri] >= maxNrjPerEntry)
                                         {
                                             fep_list_new_nri_copy(nlist);
                                             nri = nlist->nri;
@@ -1858,6 +1914,7 @@ static void make_fep_list(gmx::ArrayRef<const int> atomIndices,
                 if (nlist->nrj > nlist->jindex[nri])
                 {
                     /* Actually add this new, non-empty, list */
+                    fep_list_pad_j(nlist);
                     nlist->nri++;
                     nlist->jindex[nlist->nri] = nlist->nrj;
                 }
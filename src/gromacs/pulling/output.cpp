@@ -42,8 +42,12 @@
 #include <cstdio>
 
 #include <memory>
+#include <string>
+#include <vector>
 
 #include "gromacs/commandline/filenm.h"
+#include "gromacs/fileio/columnardata.h"
+#include "gromacs/fileio/filetypes.h"
 #include "gromacs/fileio/gmxfio.h"
 #include "gromacs/fileio/xvgr.h"
 #include "gromacs/math/vec.h"
@@ -52,6 +56,7 @@
 #include "gromacs/mdtypes/observableshistory.h"
 #include "gromacs/mdtypes/pullhistory.h"
 #include "gromacs/pulling/pull.h"
+#include "gromacs/utility/arrayref.h"
 #include "gromacs/utility/cstringutil.h"
 #include "gromacs/utility/exceptions.h"
 #include "gromacs/utility/fatalerror.h"
@@ -155,19 +160,22 @@ static void pullResetHistory(PullHistory* history, bool resetXHistory, bool rese
     }
 }
 
-static void pull_print_coord_dr_components(FILE* out, const ivec dim, const dvec dr, const int numValuesInSum)
+static void pull_print_coord_dr_components(std::vector<double>* row,
+                                           const ivec           dim,
+                                           const dvec           dr,
+                                           const int            numValuesInSum)
 {
     for (int m = 0; m < DIM; m++)
     {
         if (dim[m])
         {
-            fprintf(out, "\t%g", dr[m] / numValuesInSum);
+            row->push_back(dr[m] / numValuesInSum);
         }
     }
 }
 
 template<typename T>
-static void pull_print_coord_dr(FILE*                out,
+static void pull_print_coord_dr(std::vector<double>* row,
                                 const pull_params_t& pullParams,
                                 const t_pull_coord&  coordParams,
                                 const T&             pcrdData,
@@ -176,30 +184,53 @@ static void pull_print_coord_dr(FILE*                out,
 {
     const double unit_factor = pull_conversion_factor_internal2userinput(&coordParams);
 
-    fprintf(out, "\t%g", pcrdData.value * unit_factor / numValuesInSum);
+    row->push_back(pcrdData.value * unit_factor / numValuesInSum);
 
     if (pullParams.bPrintRefValue && coordParams.eType != epullEXTERNAL)
     {
-        fprintf(out, "\t%g", referenceValue * unit_factor / numValuesInSum);
+        row->push_back(referenceValue * unit_factor / numValuesInSum);
     }
 
     if (pullParams.bPrintComp)
     {
-        pull_print_coord_dr_components(out, coordParams.dim, pcrdData.dr01, numValuesInSum);
+        pull_print_coord_dr_components(row, coordParams.dim, pcrdData.dr01, numValuesInSum);
         if (coordParams.ngroup >= 4)
         {
-            pull_print_coord_dr_components(out, coordParams.dim, pcrdData.dr23, numValuesInSum);
+            pull_print_coord_dr_components(row, coordParams.dim, pcrdData.dr23, numValuesInSum);
         }
         if (coordParams.ngroup >= 6)
         {
-            pull_print_coord_dr_components(out, coordParams.dim, pcrdData.dr45, numValuesInSum);
+            pull_print_coord_dr_components(row, coordParams.dim, pcrdData.dr45, numValuesInSum);
         }
     }
 }
 
-static void pull_print_x(FILE* out, pull_t* pull, double t)
+/*! \brief Write a row of pull output, starting with the time
+ *
+ * The row is added to \p binaryOut when the binary format is used,
+ * otherwise it is printed as text to \p out.
+ */
+static void pull_print_row(FILE*                       out,
+                           gmx::ColumnarDataWriter*    binaryOut,
+                           gmx::ArrayRef<const double> row)
 {
-    fprintf(out, "%.4f", t);
+    if (binaryOut)
+    {
+        binaryOut->addRow(row);
+        return;
+    }
+
+    fprintf(out, "%.4f", row[0]);
+    for (size_t i = 1; i < row.size(); i++)
+    {
+        fprintf(out, "\t%g", row[i]);
+    }
+    fprintf(out, "\n");
+}
+
+static void pull_print_x(FILE* out, gmx::ColumnarDataWriter* binaryOut, pull_t* pull, double t)
+{
+    std::vector<double> row = { t };
 
     for (size_t c = 0; c < pull->coord.size(); c++)
     {
@@ -212,12 +243,12 @@ static void pull_print_x(FILE* out, pull_t* pull, double t)
             pcrdHistory = &pull->coordForceHistory->pullCoordinateSums[c];
 
             numValuesInSum = pull->coordForceHistory->numValuesInXSum;
-            pull_print_coord_dr(out, pull->params, pcrd.params, *pcrdHistory, pcrdHistory->valueRef,
-                                numValuesInSum);
+            pull_print_coord_dr(&row, pull->params, pcrd.params, *pcrdHistory,
+                                pcrdHistory->valueRef, numValuesInSum);
         }
         else
         {
-            pull_print_coord_dr(out, pull->params, pcrd.params, pcrd.spatialData, pcrd.value_ref,
+            pull_print_coord_dr(&row, pull->params, pcrd.params, pcrd.spatialData, pcrd.value_ref,
                                 numValuesInSum);
         }
 
@@ -232,11 +263,11 @@ static void pull_print_x(FILE* out, pull_t* pull, double t)
                         /* This equates to if (pull->bXOutAverage) */
                         if (pcrdHistory)
                         {
-                            fprintf(out, "\t%g", pcrdHistory->dynaX[m] / numValuesInSum);
+                            row.push_back(pcrdHistory->dynaX[m] / numValuesInSum);
                         }
                         else
                         {
-                            fprintf(out, "\t%g", pull->dyna[c].x[m]);
+                            row.push_back(pull->dyna[c].x[m]);
                         }
                     }
                 }
@@ -249,13 +280,13 @@ static void pull_print_x(FILE* out, pull_t* pull, double t)
                     {
                         if (pull->bXOutAverage)
                         {
-                            fprintf(out, "\t%g",
+                            row.push_back(
                                     pull->coordForceHistory->pullGroupSums[pcrd.params.group[0]].x[m]
-                                            / numValuesInSum);
+                                    / numValuesInSum);
                         }
                         else
                         {
-                            fprintf(out, "\t%g", pull->group[pcrd.params.group[0]].x[m]);
+                            row.push_back(pull->group[pcrd.params.group[0]].x[m]);
                         }
                     }
                 }
@@ -268,20 +299,20 @@ static void pull_print_x(FILE* out, pull_t* pull, double t)
                     {
                         if (pull->bXOutAverage)
                         {
-                            fprintf(out, "\t%g",
+                            row.push_back(
                                     pull->coordForceHistory->pullGroupSums[pcrd.params.group[g]].x[m]
-                                            / numValuesInSum);
+                                    / numValuesInSum);
                         }
                         else
                         {
-                            fprintf(out, "\t%g", pull->group[pcrd.params.group[g]].x[m]);
+                            row.push_back(pull->group[pcrd.params.group[g]].x[m]);
                         }
                     }
                 }
             }
         }
     }
-    fprintf(out, "\n");
+    pull_print_row(out, binaryOut, row);
 
     if (pull->bXOutAverage)
     {
@@ -289,27 +320,29 @@ static void pull_print_x(FILE* out, pull_t* pull, double t)
     }
 }
 
-static void pull_print_f(FILE* out, const pull_t* pull, double t)
+static void pull_print_f(FILE*                    out,
+                         gmx::ColumnarDataWriter* binaryOut,
+                         const pull_t*            pull,
+                         double                   t)
 {
-    fprintf(out, "%.4f", t);
+    std::vector<double> row = { t };
 
     if (pull->bFOutAverage)
     {
         for (size_t c = 0; c < pull->coord.size(); c++)
         {
-            fprintf(out, "\t%g",
-                    pull->coordForceHistory->pullCoordinateSums[c].scalarForce
-                            / pull->coordForceHistory->numValuesInFSum);
+            row.push_back(pull->coordForceHistory->pullCoordinateSums[c].scalarForce
+                          / pull->coordForceHistory->numValuesInFSum);
         }
     }
     else
     {
         for (const pull_coord_work_t& coord : pull->coord)
         {
-            fprintf(out, "\t%g", coord.scalarForce);
+            row.push_back(coord.scalarForce);
         }
     }
-    fprintf(out, "\n");
+    pull_print_row(out, binaryOut, row);
 
     if (pull->bFOutAverage)
     {
@@ -335,7 +368,7 @@ void pull_print_output(struct pull_t* pull, int64_t step, double time)
         }
         if (step % pull->params.nstxout == 0)
         {
-            pull_print_x(pull->out_x, pull, time);
+            pull_print_x(pull->out_x, pull->binaryOut_x.get(), pull, time);
         }
     }
 
@@ -352,15 +385,26 @@ void pull_print_output(struct pull_t* pull, int64_t step, double time)
         }
         if (step % pull->params.nstfout == 0)
         {
-            pull_print_f(pull->out_f, pull, time);
+            pull_print_f(pull->out_f, pull->binaryOut_f.get(), pull, time);
         }
     }
 }
 
+void pull_flush_output(pull_t* pull)
+{
+    if (pull->binaryOut_x)
+    {
+        pull->binaryOut_x->flush();
+    }
+    if (pull->binaryOut_f)
+    {
+        pull->binaryOut_f->flush();
+    }
+}
+
 static void set_legend_for_coord_components(const pull_coord_work_t* pcrd,
                                             int                      coord_index,
-                                            char**                   setname,
-                                            int*                     nsets_ptr)
+                                            std::vector<std::string>* setnames)
 {
     /*  Loop over the distance vectors and print their components. Each vector is made up of two consecutive groups. */
     for (int g = 0; g < pcrd->params.ngroup; g += 2)
@@ -384,30 +428,105 @@ static void set_legend_for_coord_components(const pull_coord_work_t* pcrd,
                     sprintf(legend, "%d g %d-%d d%c", coord_index + 1, g + 1, g + 2, 'X' + m);
                 }
 
-                setname[*nsets_ptr] = gmx_strdup(legend);
-                (*nsets_ptr)++;
+                setnames->emplace_back(legend);
             }
         }
     }
 }
 
-static FILE* open_pull_out(const char*             fn,
-                           struct pull_t*          pull,
-                           const gmx_output_env_t* oenv,
-                           gmx_bool                bCoord,
-                           const bool              restartWithAppending)
+//! Return the legends of the data sets in the pull x or f output
+static std::vector<std::string> pull_output_legends(const pull_t* pull, gmx_bool bCoord)
 {
-    FILE*  fp;
-    int    nsets, m;
-    char **setname, buf[50];
+    std::vector<std::string> setnames;
+    char                     buf[50];
+
+    for (size_t c = 0; c < pull->coord.size(); c++)
+    {
+        if (bCoord)
+        {
+            /* The order of this legend should match the order of printing
+             * the data in print_pull_x above.
+             */
+
+            /* The pull coord distance */
+            sprintf(buf, "%zu", c + 1);
+            setnames.emplace_back(buf);
+            if (pull->params.bPrintRefValue && pull->coord[c].params.eType != epullEXTERNAL)
+            {
+                sprintf(buf, "%zu ref", c + 1);
+                setnames.emplace_back(buf);
+            }
+            if (pull->params.bPrintComp)
+            {
+                set_legend_for_coord_components(&pull->coord[c], c, &setnames);
+            }
+
+            if (pull->params.bPrintCOM)
+            {
+                for (int g = 0; g < pull->coord[c].params.ngroup; g++)
+                {
+                    /* Legend for reference group position */
+                    for (int m = 0; m < DIM; m++)
+                    {
+                        if (pull->coord[c].params.dim[m])
+                        {
+                            sprintf(buf, "%zu g %d %c", c + 1, g + 1, 'X' + m);
+                            setnames.emplace_back(buf);
+                        }
+                    }
+                }
+            }
+        }
+        else
+        {
+            /* For the pull force we always only use one scalar */
+            sprintf(buf, "%zu", c + 1);
+            setnames.emplace_back(buf);
+        }
+    }
+
+    return setnames;
+}
+
+/*! \brief Open a pull output file
+ *
+ * When \p fn has the binary columnar data extension, \p binaryOut
+ * is set to a writer for the file, otherwise an xvg header is written.
+ */
+static FILE* open_pull_out(const char*                               fn,
+                           struct pull_t*                            pull,
+                           const gmx_output_env_t*                   oenv,
+                           gmx_bool                                  bCoord,
+                           const bool                                restartWithAppending,
+                           std::unique_ptr<gmx::ColumnarDataWriter>* binaryOut)
+{
+    FILE* fp;
+    char  buf[50];
+
+    const bool binary = (fn2ftp(fn) == efCOL);
 
     if (restartWithAppending)
     {
-        fp = gmx_fio_fopen(fn, "a+");
+        fp = gmx_fio_fopen(fn, binary ? "a+b" : "a+");
     }
     else
     {
-        fp = gmx_fio_fopen(fn, "w+");
+        fp = gmx_fio_fopen(fn, binary ? "w+b" : "w+");
+    }
+
+    if (binary)
+    {
+        std::vector<std::string> columnNames = pull_output_legends(pull, bCoord);
+        columnNames.insert(columnNames.begin(), "Time (ps)");
+        try
+        {
+            *binaryOut = std::make_unique<gmx::ColumnarDataWriter>(fp, columnNames,
+                                                                   restartWithAppending);
+        }
+        GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR
+    }
+    else if (!restartWithAppending)
+    {
         if (bCoord)
         {
             sprintf(buf, "Position (nm%s)", pull->bAngle ? ", deg" : "");
@@ -433,72 +552,11 @@ static FILE* open_pull_out(const char*             fn,
             }
         }
 
-        /* With default mdp options only the actual coordinate value is printed (1),
-         * but optionally the reference value (+ 1),
-         * the group COMs for all the groups (+ ngroups_max*DIM)
-         * and the components of the distance vectors can be printed (+ (ngroups_max/2)*DIM).
-         */
-        snew(setname, pull->coord.size()
-                              * (1 + 1 + c_pullCoordNgroupMax * DIM + c_pullCoordNgroupMax / 2 * DIM));
-
-        nsets = 0;
-        for (size_t c = 0; c < pull->coord.size(); c++)
-        {
-            if (bCoord)
-            {
-                /* The order of this legend should match the order of printing
-                 * the data in print_pull_x above.
-                 */
-
-                /* The pull coord distance */
-                sprintf(buf, "%zu", c + 1);
-                setname[nsets] = gmx_strdup(buf);
-                nsets++;
-                if (pull->params.bPrintRefValue && pull->coord[c].params.eType != epullEXTERNAL)
-                {
-                    sprintf(buf, "%zu ref", c + 1);
-                    setname[nsets] = gmx_strdup(buf);
-                    nsets++;
-                }
-                if (pull->params.bPrintComp)
-                {
-                    set_legend_for_coord_components(&pull->coord[c], c, setname, &nsets);
-                }
-
-                if (pull->params.bPrintCOM)
-                {
-                    for (int g = 0; g < pull->coord[c].params.ngroup; g++)
-                    {
-                        /* Legend for reference group position */
-                        for (m = 0; m < DIM; m++)
-                        {
-                            if (pull->coord[c].params.dim[m])
-                            {
-                                sprintf(buf, "%zu g %d %c", c + 1, g + 1, 'X' + m);
-                                setname[nsets] = gmx_strdup(buf);
-                                nsets++;
-                            }
-                        }
-                    }
-                }
-            }
-            else
-            {
-                /* For the pull force we always only use one scalar */
-                sprintf(buf, "%zu", c + 1);
-                setname[nsets] = gmx_strdup(buf);
-                nsets++;
-            }
-        }
-        if (nsets > 1)
-        {
-            xvgr_legend(fp, nsets, setname, oenv);
-        }
-        for (int c = 0; c < nsets; c++)
+        const std::vector<std::string> setnames = pull_output_legends(pull, bCoord);
+        if (setnames.size() > 1)
         {
-            sfree(setname[c]);
+            xvgrLegend(fp, setnames, oenv);
         }
-        sfree(setname);
     }
 
     return fp;
@@ -533,8 +591,10 @@ void init_pull_output_files(pull_t*                     pull,
                 pf_appended = append_before_extension(pf_filename, "_pullf");
             }
             GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR
-            pull->out_x = open_pull_out(px_appended.c_str(), pull, oenv, TRUE, restartWithAppending);
-            pull->out_f = open_pull_out(pf_appended.c_str(), pull, oenv, FALSE, restartWithAppending);
+            pull->out_x = open_pull_out(px_appended.c_str(), pull, oenv, TRUE,
+                                        restartWithAppending, &pull->binaryOut_x);
+            pull->out_f = open_pull_out(pf_appended.c_str(), pull, oenv, FALSE,
+                                        restartWithAppending, &pull->binaryOut_f);
             return;
         }
         else
@@ -545,11 +605,13 @@ void init_pull_output_files(pull_t*                     pull,
     }
     if (pull->params.nstxout != 0)
     {
-        pull->out_x = open_pull_out(opt2fn("-px", nfile, fnm), pull, oenv, TRUE, restartWithAppending);
+        pull->out_x = open_pull_out(opt2fn("-px", nfile, fnm), pull, oenv, TRUE,
+                                    restartWithAppending, &pull->binaryOut_x);
     }
     if (pull->params.nstfout != 0)
     {
-        pull->out_f = open_pull_out(opt2fn("-pf", nfile, fnm), pull, oenv, FALSE, restartWithAppending);
+        pull->out_f = open_pull_out(opt2fn("-pf", nfile, fnm), pull, oenv, FALSE,
+                                    restartWithAppending, &pull->binaryOut_f);
     }
 }
 
@@ -86,6 +86,15 @@ void init_pull_output_files(pull_t*                 pull,
  */
 void pull_print_output(pull_t* pull, int64_t step, double time);
 
+/*! \brief Write buffered binary pull output to the output files
+ *
+ * Should be called before the output file positions are stored
+ * in a checkpoint and before the files are closed.
+ *
+ * \param pull     The pull data structure.
+ */
+void pull_flush_output(pull_t* pull);
+
 /*! \brief Allocate and initialize pull work history (for average pull output) and set it in a pull work struct
  *
  * \param pull                The pull work struct
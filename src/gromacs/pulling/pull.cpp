@@ -79,6 +79,7 @@
 #include "gromacs/utility/smalloc.h"
 #include "gromacs/utility/strconvert.h"
 
+#include "output.h"
 #include "pull_internal.h"
 
 namespace gmx
@@ -2336,6 +2337,8 @@ void finish_pull(struct pull_t* pull)
 {
     check_external_potential_registration(pull);
 
+    pull_flush_output(pull);
+
     if (pull->out_x)
     {
         gmx_fio_fclose(pull->out_x);
@@ -55,6 +55,7 @@
 #include <vector>
 
 #include "gromacs/domdec/localatomset.h"
+#include "gromacs/fileio/columnardata.h"
 #include "gromacs/mdtypes/pull_params.h"
 #include "gromacs/utility/gmxmpi.h"
 
@@ -252,6 +253,9 @@ struct pull_t
     FILE* out_x; /* Output file for pull data */
     FILE* out_f; /* Output file for pull data */
 
+    std::unique_ptr<gmx::ColumnarDataWriter> binaryOut_x; /* Writer when out_x is binary */
+    std::unique_ptr<gmx::ColumnarDataWriter> binaryOut_f; /* Writer when out_f is binary */
+
     bool bXOutAverage; /* Output average pull coordinates */
     bool bFOutAverage; /* Output average pull forces */
 
@@ -252,6 +252,21 @@ public:
      */
     result_type max() const { return c_table_[c_table_.size() - 1]; }
 
+    /*! \brief Return the standard normal value tabulated for the lowest tableBits of randomBits
+     *
+     * This is the value a distribution with zero mean and unit standard
+     * deviation returns when it consumes these bits. Successive draws from
+     * one 64-bit random value use successive groups of tableBits bits, so
+     * callers that generate random bits in bulk can reproduce the output
+     * of operator() by shifting the bits tableBits right for each value.
+     *
+     * \param randomBits  Uniform random bits, only the lowest tableBits are used.
+     */
+    static result_type standardValueFromBits(uint64_t randomBits)
+    {
+        return c_table_[randomBits & ((1ULL << tableBits) - 1)];
+    }
+
     /*! \brief Mean of the present normal distribution */
     result_type mean() const { return param_.mean(); }
 
@@ -238,6 +238,44 @@ TEST_F(ThreeFry2x64Test, ExhaustInternalCounter)
     EXPECT_THROW_GMX(rngA(), gmx::InternalError);
 }
 
+TEST_F(ThreeFry2x64Test, MultiStreamMatchesScalarEngine)
+{
+    const int          numStreams = 13;
+    const uint64_t     seed       = 123456;
+    const RandomDomain domain     = RandomDomain::UpdateCoordinates;
+
+    gmx::ThreeFry2x64<0>                     rng(seed, domain);
+    gmx::ThreeFry2x64MultiStream<numStreams> multiStream(seed, domain);
+
+    gmx::ThreeFry2x64Fast<0>                            rngFast(seed, domain);
+    gmx::ThreeFry2x64MultiStreamGeneral<13, numStreams> multiStreamFast(seed, domain);
+
+    const uint64_t counter0 = 0xFFFFFFFFFFFFFFFF;
+    uint64_t       counter1[numStreams];
+    for (int s = 0; s < numStreams; s++)
+    {
+        counter1[s] = 0x123456789ULL * s;
+    }
+    uint64_t word0[numStreams];
+    uint64_t word1[numStreams];
+
+    multiStream.generateBlocks(counter0, counter1, word0, word1);
+    for (int s = 0; s < numStreams; s++)
+    {
+        rng.restart(counter0, counter1[s]);
+        EXPECT_EQ(rng(), word0[s]) << "for stream " << s;
+        EXPECT_EQ(rng(), word1[s]) << "for stream " << s;
+    }
+
+    multiStreamFast.generateBlocks(counter0, counter1, word0, word1);
+    for (int s = 0; s < numStreams; s++)
+    {
+        rngFast.restart(counter0, counter1[s]);
+        EXPECT_EQ(rngFast(), word0[s]) << "for stream " << s;
+        EXPECT_EQ(rngFast(), word1[s]) << "for stream " << s;
+    }
+}
+
 } // namespace
 
 } // namespace gmx
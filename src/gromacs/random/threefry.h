@@ -49,6 +49,7 @@
 
 #include "gromacs/math/functions.h"
 #include "gromacs/random/seed.h"
+#include "gromacs/utility/basedefinitions.h"
 #include "gromacs/utility/classhelpers.h"
 #include "gromacs/utility/exceptions.h"
 
@@ -340,6 +341,10 @@ public:
     typedef std::array<result_type, 2> counter_type;
 
 private:
+    //! The multi-stream generator reuses our block encryption
+    template<unsigned int, int>
+    friend class ThreeFry2x64MultiStreamGeneral;
+
     /*! \brief Rotate value left by specified number of bits
      *
      *  \param i    Value to rotate (result_type, which should be 64-bit).
@@ -347,7 +352,7 @@ private:
      *
      *  \return Input value rotated 'bits' left.
      */
-    result_type rotLeft(result_type i, unsigned int bits)
+    static result_type rotLeft(result_type i, unsigned int bits)
     {
         return (i << bits) | (i >> (std::numeric_limits<result_type>::digits - bits));
     }
@@ -364,7 +369,7 @@ private:
      *
      *  \return Newly encrypted 2x64 block, according to the class template parameters.
      */
-    counter_type generateBlock(const counter_type& key, const counter_type& ctr)
+    static counter_type generateBlock(const counter_type& key, const counter_type& ctr)
     {
         const unsigned int rotations[] = { 16, 42, 12, 31, 16, 32, 24, 21 };
         counter_type       x           = ctr;
@@ -879,6 +884,96 @@ public:
     }
 };
 
+/*! \brief ThreeFry2x64 block generator for several independent counters at once
+ *
+ *  \tparam rounds      The number of encryption iterations used when generating.
+ *  \tparam numStreams  The number of counters, i.e. streams, handled per call.
+ *
+ *  This is a stateless companion to ThreeFry2x64General with zero internal
+ *  counter bits. Instead of returning one value at a time, it encrypts
+ *  numStreams counters that share the first counter word in one call.
+ *  The streams are independent, so the compiler can vectorize the 64-bit
+ *  additions, rotations and xors over the streams, with as many streams per
+ *  instruction as the hardware supports. The GROMACS SIMD module has no 64-bit
+ *  integer type, so we rely on the compiler rather than SIMD intrinsics here.
+ *
+ *  Block word 0 and 1 for stream s are bit-identical to the first two values
+ *  returned by ThreeFry2x64General<rounds, 0> with the same key, after calling
+ *  restart(counter0, counter1[s]). This makes it possible to use this class
+ *  in vectorized code paths that have to reproduce the scalar random streams,
+ *  e.g. with the step as counter0 and the atom indices as counter1.
+ */
+template<unsigned int rounds, int numStreams>
+class ThreeFry2x64MultiStreamGeneral
+{
+    static_assert(rounds >= 13,
+                  "You should not use less than 13 encryption rounds for ThreeFry2x64.");
+    static_assert(numStreams > 0, "We need at least one stream");
+
+public:
+    /*! \brief Integer type for output. */
+    typedef uint64_t result_type;
+
+    /*! \brief Construct block generator with a 64-bit seed and random domain
+     *
+     *  \param key0   Random seed in the form of a 64-bit unsigned value.
+     *  \param domain Random domain, see ThreeFry2x64General.
+     */
+    ThreeFry2x64MultiStreamGeneral(uint64_t key0 = 0, RandomDomain domain = RandomDomain::Other) :
+        key_({ { key0, static_cast<uint64_t>(domain) } })
+    {
+    }
+
+    /*! \brief Encrypt numStreams counters {counter0, counter1[s]}
+     *
+     *  \param[in]  counter0  First counter word, shared by all streams.
+     *  \param[in]  counter1  Second counter word for each of the numStreams streams.
+     *  \param[out] word0     First word of the encrypted block for each stream.
+     *  \param[out] word1     Second word of the encrypted block for each stream.
+     */
+    void generateBlocks(uint64_t                  counter0,
+                        const result_type*        counter1,
+                        result_type* gmx_restrict word0,
+                        result_type* gmx_restrict word1) const
+    {
+        // Loop over the streams with the fully unrolled encryption as body,
+        // which the compiler can vectorize over the streams.
+        for (int s = 0; s < numStreams; s++)
+        {
+            const std::array<result_type, 2> counter = { { counter0, counter1[s] } };
+            const std::array<result_type, 2> block =
+                    ThreeFry2x64General<rounds, 0>::generateBlock(key_, counter);
+            word0[s] = block[0];
+            word1[s] = block[1];
+        }
+    }
+
+private:
+    /*! \brief ThreeFry2x64 key, i.e. the random seed and domain. */
+    std::array<result_type, 2> key_;
+};
+
+/*! \brief ThreeFry2x64 block generator with 20 rounds for several streams
+ *
+ *  \tparam numStreams  The number of counters, i.e. streams, handled per call.
+ *
+ *  Generates the same blocks as ThreeFry2x64<0>, see ThreeFry2x64MultiStreamGeneral.
+ */
+template<int numStreams>
+class ThreeFry2x64MultiStream : public ThreeFry2x64MultiStreamGeneral<20, numStreams>
+{
+public:
+    /*! \brief Construct block generator with a 64-bit seed and random domain, 20 rounds
+     *
+     *  \param key0   Random seed in the form of a 64-bit unsigned value.
+     *  \param domain Random domain, see ThreeFry2x64General.
+     */
+    ThreeFry2x64MultiStream(uint64_t key0 = 0, RandomDomain domain = RandomDomain::Other) :
+        ThreeFry2x64MultiStreamGeneral<20, numStreams>(key0, domain)
+    {
+    }
+};
+
 
 /*! \brief Default fast and accurate random engine in Gromacs
  *
@@ -219,6 +219,20 @@ void gmx_ana_indexgrps_free(gmx_ana_indexgrps_t* g)
     delete g;
 }
 
+/*!
+ * \param[out] dest  Receives a newly allocated copy of \p src.
+ * \param[in]  src   Index groups structure to copy.
+ */
+void gmx_ana_indexgrps_copy(gmx_ana_indexgrps_t** dest, const gmx_ana_indexgrps_t* src)
+{
+    *dest = new gmx_ana_indexgrps_t(src->g.size());
+    for (size_t i = 0; i < src->g.size(); ++i)
+    {
+        gmx_ana_index_copy(&(*dest)->g[i], const_cast<gmx_ana_index_t*>(&src->g[i]), true);
+    }
+    (*dest)->names = src->names;
+}
+
 
 /*!
  * \param[out] dest     Output structure.
@@ -236,6 +236,8 @@ struct gmx_ana_indexmap_t
 void gmx_ana_indexgrps_init(gmx_ana_indexgrps_t** g, gmx_mtop_t* top, const char* fnm);
 /** Frees memory allocated for index groups. */
 void gmx_ana_indexgrps_free(gmx_ana_indexgrps_t* g);
+/** Makes a deep copy of a set of index groups. */
+void gmx_ana_indexgrps_copy(gmx_ana_indexgrps_t** dest, const gmx_ana_indexgrps_t* src);
 /** Returns true if the index group structure is emtpy. */
 bool gmx_ana_indexgrps_is_empty(gmx_ana_indexgrps_t* g);
 
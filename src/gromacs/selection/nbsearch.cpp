@@ -146,6 +146,11 @@ public:
 
     real cutoffSquared() const { return cutoff2_; }
     bool usesGridSearch() const { return bGrid_; }
+    //! Whether the last init() call was for the same array of reference positions.
+    bool wasInitializedFor(const AnalysisNeighborhoodPositions& positions) const
+    {
+        return refPositionsInput_ == positions.x_;
+    }
 
 private:
     /*! \brief
@@ -197,16 +202,16 @@ private:
      */
     int getGridCellIndex(const rvec cell) const;
     /*! \brief
-     * Adds an index into a grid cell.
+     * Moves an index from one grid cell to another.
      *
-     * \param[in]  cell Fractional cell coordinates into which \p i should
-     *     be added.
-     * \param[in]  i    Index to add.
+     * \param[in]  i        Index to move.
+     * \param[in]  oldCell  Linear index of the cell that contains \p i.
+     * \param[in]  newCell  Linear index of the cell to move \p i to.
      *
-     * \p cell should satisfy the conditions that \p mapPointToGridCell()
-     * produces.
+     * Keeps the indices in each cell in ascending order, such that the
+     * cells are identical to those constructed from scratch.
      */
-    void addToGridCell(const rvec cell, int i);
+    void moveToGridCell(int i, int oldCell, int newCell);
     /*! \brief
      * Initializes a cell pair loop for a dimension.
      *
@@ -319,6 +324,15 @@ private:
     ivec ncelldim_;
     //! Data structure to hold the grid cell contents.
     CellList cells_;
+    /*! \brief
+     * Linear grid cell index of each reference position.
+     *
+     * Used to only move the positions that changed cells when the search
+     * is initialized again with the same number of positions and cells.
+     */
+    std::vector<int> refCellIndices_;
+    //! Reference positions of the last init() call, to match sets in later frames.
+    const rvec* refPositionsInput_;
 
     Mutex          createPairSearchMutex_;
     PairSearchList pairSearchList_;
@@ -427,6 +441,7 @@ AnalysisNeighborhoodSearchImpl::AnalysisNeighborhoodSearchImpl(real cutoff)
     refExclusionIds_ = nullptr;
     refIndices_      = nullptr;
     std::memset(&pbc_, 0, sizeof(pbc_));
+    refPositionsInput_ = nullptr;
 
     bGrid_        = false;
     bTric_        = false;
@@ -538,15 +553,12 @@ bool AnalysisNeighborhoodSearchImpl::initGridCells(const matrix box, bool bSingl
     }
     // Never decrease the size of the cell vector to avoid reallocating
     // memory for the nested vectors.  The actual size of the vector is not
-    // used outside this function.
+    // used outside this function.  The cells are cleared in init() if they
+    // cannot be updated from the previous positions.
     if (cells_.size() < static_cast<size_t>(totalCellCount))
     {
         cells_.resize(totalCellCount);
     }
-    for (int ci = 0; ci < totalCellCount; ++ci)
-    {
-        cells_[ci].clear();
-    }
     return true;
 }
 
@@ -708,10 +720,12 @@ int AnalysisNeighborhoodSearchImpl::getGridCellIndex(const rvec cell) const
     return getGridCellIndex(icell);
 }
 
-void AnalysisNeighborhoodSearchImpl::addToGridCell(const rvec cell, int i)
+void AnalysisNeighborhoodSearchImpl::moveToGridCell(int i, int oldCell, int newCell)
 {
-    const int ci = getGridCellIndex(cell);
-    cells_[ci].push_back(i);
+    std::vector<int>& oldIndices = cells_[oldCell];
+    oldIndices.erase(std::lower_bound(oldIndices.begin(), oldIndices.end(), i));
+    std::vector<int>& newIndices = cells_[newCell];
+    newIndices.insert(std::lower_bound(newIndices.begin(), newIndices.end(), i), i);
 }
 
 void AnalysisNeighborhoodSearchImpl::initCellRange(const rvec centerCell, ivec currCell, ivec upperBound, int dim) const
@@ -866,6 +880,13 @@ void AnalysisNeighborhoodSearchImpl::init(AnalysisNeighborhood::SearchMode     m
 {
     GMX_RELEASE_ASSERT(positions.index_ == -1,
                        "Individual indexed positions not supported as reference");
+    // The cells from the previous call can be updated instead of filled
+    // from scratch if the number of positions and the grid size match.
+    const bool bHadGrid         = bGrid_;
+    const int  previousRefCount = nref_;
+    ivec       previousCellCount;
+    copy_ivec(ncelldim_, previousCellCount);
+
     bXY_ = bXY;
     if (bXY_ && pbc != nullptr && pbc->pbcType != PbcType::No)
     {
@@ -909,18 +930,42 @@ void AnalysisNeighborhoodSearchImpl::init(AnalysisNeighborhood::SearchMode     m
         bGrid_ = initGrid(pbc_, positions.count_, positions.x_,
                           mode == AnalysisNeighborhood::eSearchMode_Grid);
     }
-    refIndices_ = positions.indices_;
+    refIndices_        = positions.indices_;
+    refPositionsInput_ = positions.x_;
     if (bGrid_)
     {
         xrefAlloc_.resize(nref_);
         xref_ = as_rvec_array(xrefAlloc_.data());
 
+        const bool bUpdateCells = bHadGrid && nref_ == previousRefCount
+                                  && previousCellCount[XX] == ncelldim_[XX]
+                                  && previousCellCount[YY] == ncelldim_[YY]
+                                  && previousCellCount[ZZ] == ncelldim_[ZZ];
+        if (!bUpdateCells)
+        {
+            const int totalCellCount = ncelldim_[XX] * ncelldim_[YY] * ncelldim_[ZZ];
+            for (int ci = 0; ci < totalCellCount; ++ci)
+            {
+                cells_[ci].clear();
+            }
+            refCellIndices_.resize(nref_);
+        }
         for (int i = 0; i < nref_; ++i)
         {
             const int ii = (refIndices_ != nullptr) ? refIndices_[i] : i;
             rvec      refcell;
             mapPointToGridCell(positions.x_[ii], refcell, xrefAlloc_[i]);
-            addToGridCell(refcell, i);
+            const int ci = getGridCellIndex(refcell);
+            if (!bUpdateCells)
+            {
+                cells_[ci].push_back(i);
+            }
+            else if (ci != refCellIndices_[i])
+            {
+                // Between frames, only a few positions change cells.
+                moveToGridCell(i, refCellIndices_[i], ci);
+            }
+            refCellIndices_[i] = ci;
         }
     }
     else if (refIndices_ != nullptr)
@@ -1239,6 +1284,9 @@ private:
 class AnalysisNeighborhood::Impl
 {
 public:
+    //! Number of searches kept for reuse with different reference positions.
+    static constexpr size_t c_maxSearchesToKeep = 8;
+
     typedef AnalysisNeighborhoodSearch::ImplPointer SearchImplPointer;
     typedef std::vector<SearchImplPointer>          SearchList;
 
@@ -1252,7 +1300,7 @@ public:
         }
     }
 
-    SearchImplPointer getSearch();
+    SearchImplPointer getSearch(const AnalysisNeighborhoodPositions& positions);
 
     Mutex                   createSearchMutex_;
     SearchList              searchList_;
@@ -1262,19 +1310,35 @@ public:
     bool                    bXY_;
 };
 
-AnalysisNeighborhood::Impl::SearchImplPointer AnalysisNeighborhood::Impl::getSearch()
+AnalysisNeighborhood::Impl::SearchImplPointer
+AnalysisNeighborhood::Impl::getSearch(const AnalysisNeighborhoodPositions& positions)
 {
     lock_guard<Mutex> lock(createSearchMutex_);
     // TODO: Consider whether this needs to/can be faster, e.g., by keeping a
     // separate pool of unused search objects.
+    // Prefer the search that was last used for the same reference positions,
+    // such that its grid can be updated instead of constructed from scratch
+    // when several sets of reference positions are searched in each frame.
     SearchList::const_iterator i;
     for (i = searchList_.begin(); i != searchList_.end(); ++i)
     {
-        if (i->unique())
+        if (i->unique() && (*i)->wasInitializedFor(positions))
         {
             return *i;
         }
     }
+    // Keep a search per set of reference positions, up to a limit, so that
+    // input that changes for every call does not grow the list further.
+    if (searchList_.size() >= c_maxSearchesToKeep)
+    {
+        for (i = searchList_.begin(); i != searchList_.end(); ++i)
+        {
+            if (i->unique())
+            {
+                return *i;
+            }
+        }
+    }
     SearchImplPointer search(new internal::AnalysisNeighborhoodSearchImpl(cutoff_));
     searchList_.push_back(search);
     return search;
@@ -1320,7 +1384,7 @@ AnalysisNeighborhood::SearchMode AnalysisNeighborhood::mode() const
 AnalysisNeighborhoodSearch AnalysisNeighborhood::initSearch(const t_pbc* pbc,
                                                             const AnalysisNeighborhoodPositions& positions)
 {
-    Impl::SearchImplPointer search(impl_->getSearch());
+    Impl::SearchImplPointer search(impl_->getSearch(positions));
     search->init(mode(), impl_->bXY_, impl_->excls_, pbc, positions);
     return AnalysisNeighborhoodSearch(search);
 }
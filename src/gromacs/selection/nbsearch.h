@@ -212,6 +212,13 @@ private:
  * use methods in the returned AnalysisNeighborhoodSearch to find the reference
  * positions that are within the given cutoff from a provided position.
  *
+ * The search objects are reused between calls to initSearch().  When it is
+ * called again with the same array of reference positions, e.g., for the next
+ * frame, the grid from the previous call is updated by moving only the
+ * positions that changed cells, as long as the number of positions and the
+ * grid dimensions stay the same.  Searches for different arrays of reference
+ * positions in the same frame do not replace each others grids.
+ *
  * initSearch() is thread-safe and can be called from multiple threads.  Each
  * call returns a different instance of the search object that can be used
  * independently of the others.  The returned AnalysisNeighborhoodSearch
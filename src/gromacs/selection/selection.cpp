@@ -45,6 +45,7 @@
 
 #include "selection.h"
 
+#include <algorithm>
 #include <string>
 
 #include "gromacs/selection/nbsearch.h"
@@ -259,6 +260,21 @@ void SelectionData::restoreOriginalPositions(const gmx_mtop_t* top)
     }
 }
 
+
+void SelectionData::copyCompiledState(const SelectionData& other)
+{
+    const gmx_ana_indexmap_t& src  = other.rawPositions_.m;
+    gmx_ana_indexmap_t&       dest = rawPositions_.m;
+    GMX_RELEASE_ASSERT(src.b.nr == dest.b.nr && src.mapb.nr == dest.mapb.nr,
+                       "Copied selection does not match the original");
+    initCoveredFraction(other.coveredFractionType_);
+    std::copy(src.orgid, src.orgid + src.b.nr, dest.orgid);
+    if (dest.mapid != dest.orgid)
+    {
+        std::copy(src.mapid, src.mapid + src.mapb.nr, dest.mapid);
+    }
+}
+
 } // namespace internal
 
 /********************************************************************
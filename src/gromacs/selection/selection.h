@@ -121,6 +121,8 @@ public:
 
     //! Returns true if the given flag is set.
     bool hasFlag(SelectionFlag flag) const { return flags_.test(flag); }
+    //! Returns the flags for this selection.
+    SelectionFlags flags() const { return flags_; }
     //! Sets the flags for this selection.
     void setFlags(SelectionFlags flags) { flags_ = flags; }
 
@@ -189,6 +191,17 @@ public:
      * Called by SelectionEvaluator::evaluateFinal().
      */
     void restoreOriginalPositions(const gmx_mtop_t* top);
+    /*! \brief
+     * Copies settings made after compilation from another selection.
+     *
+     * \param[in] other  Selection to copy the settings from.
+     *
+     * Copies the covered fraction type and the original IDs of the
+     * positions.  \p other should be compiled from the same selection text
+     * and flags as this selection, and neither should have been evaluated.
+     * Called by the SelectionCollection copy constructor.
+     */
+    void copyCompiledState(const SelectionData& other);
 
 private:
     //! Name of the selection.
@@ -44,6 +44,7 @@
 
 #include "selectioncollection.h"
 
+#include <algorithm>
 #include <cctype>
 #include <cstdio>
 
@@ -87,7 +88,9 @@ namespace gmx
 SelectionCollection::Impl::Impl() :
     debugLevel_(DebugLevel::None),
     bExternalGroupsSet_(false),
-    grps_(nullptr)
+    grps_(nullptr),
+    bRetainGroups_(false),
+    bCompiled_(false)
 {
     sc_.nvars   = 0;
     sc_.varstrs = nullptr;
@@ -530,6 +533,58 @@ SelectionCollection::Impl::requiredTopologyPropertiesForPositionType(const std::
 SelectionCollection::SelectionCollection() : impl_(new Impl) {}
 
 
+SelectionCollection::SelectionCollection(const SelectionCollection& rhs) : impl_(new Impl)
+{
+    const Impl& source = *rhs.impl_;
+    const std::string& rpost = source.bCompiled_ ? source.compiledRpost_ : source.rpost_;
+    const std::string& spost = source.bCompiled_ ? source.compiledSpost_ : source.spost_;
+    impl_->rpost_            = rpost;
+    impl_->spost_            = spost;
+
+    // Variables are parsed first, so that the selections can refer to them.
+    for (int i = 0; i < source.sc_.nvars; ++i)
+    {
+        parseFromString(source.sc_.varstrs[i]);
+    }
+    for (const auto& sel : source.sc_.sel)
+    {
+        const size_t index = impl_->sc_.sel.size();
+        parseFromString(sel->selectionText());
+        if (impl_->sc_.sel.size() != index + 1)
+        {
+            GMX_THROW(InvalidInputError(
+                    formatString("Could not recreate selection '%s'", sel->selectionText())));
+        }
+        impl_->sc_.sel.back()->setFlags(sel->flags());
+        impl_->sourceSelections_.push_back(sel.get());
+    }
+    if (source.sc_.top != nullptr || source.sc_.gall.isize > 0)
+    {
+        // The topology is only read, so it can be shared with the copy.
+        setTopology(const_cast<gmx_mtop_t*>(source.sc_.top), source.sc_.gall.isize);
+    }
+    if (source.retainedGrps_)
+    {
+        impl_->retainedGrps_ = source.retainedGrps_;
+        setIndexGroups(impl_->retainedGrps_.get());
+        setIndexGroups(nullptr);
+    }
+    else if (source.bExternalGroupsSet_ && source.grps_ != nullptr)
+    {
+        setIndexGroups(source.grps_);
+        setIndexGroups(nullptr);
+    }
+    if (source.bCompiled_)
+    {
+        compile();
+        for (size_t i = 0; i < impl_->sc_.sel.size(); ++i)
+        {
+            impl_->sc_.sel[i]->copyCompiledState(*source.sc_.sel[i]);
+        }
+    }
+}
+
+
 SelectionCollection::~SelectionCollection() {}
 
 
@@ -632,6 +687,12 @@ void SelectionCollection::setIndexGroups(gmx_ana_indexgrps_t* grps)
                        "Can only set external groups once or clear them afterwards");
     impl_->grps_               = grps;
     impl_->bExternalGroupsSet_ = true;
+    if (grps != nullptr && impl_->bRetainGroups_ && grps != impl_->retainedGrps_.get())
+    {
+        gmx_ana_indexgrps_t* copy = nullptr;
+        gmx_ana_indexgrps_copy(&copy, grps);
+        impl_->retainedGrps_.reset(copy, &gmx_ana_indexgrps_free);
+    }
 
     ExceptionInitializer        errors("Invalid index group reference(s)");
     SelectionTreeElementPointer root = impl_->sc_.root;
@@ -651,6 +712,11 @@ void SelectionCollection::setIndexGroups(gmx_ana_indexgrps_t* grps)
     }
 }
 
+void SelectionCollection::setRetainIndexGroups(bool bRetain)
+{
+    impl_->bRetainGroups_ = bRetain;
+}
+
 SelectionTopologyProperties SelectionCollection::requiredTopologyProperties() const
 {
     SelectionTopologyProperties props;
@@ -821,6 +887,9 @@ void SelectionCollection::compile()
             }
         }
     }
+    impl_->compiledRpost_ = impl_->rpost_;
+    impl_->compiledSpost_ = impl_->spost_;
+    impl_->bCompiled_     = true;
     impl_->rpost_.clear();
     impl_->spost_.clear();
 }
@@ -903,4 +972,27 @@ void SelectionCollection::printXvgrInfo(FILE* out) const
     std::fprintf(out, "#\n");
 }
 
+
+Selection SelectionCollection::correspondingSelection(const Selection& selection) const
+{
+    if (!selection.isValid())
+    {
+        return selection;
+    }
+    const SelectionDataList& sel = impl_->sc_.sel;
+    for (size_t i = 0; i < impl_->sourceSelections_.size(); ++i)
+    {
+        if (Selection(const_cast<internal::SelectionData*>(impl_->sourceSelections_[i])) == selection)
+        {
+            return Selection(sel[i].get());
+        }
+    }
+    GMX_ASSERT(std::any_of(sel.begin(), sel.end(),
+                           [&selection](const SelectionDataPointer& data) {
+                               return Selection(data.get()) == selection;
+                           }),
+               "Selection does not belong to this collection or its source");
+    return selection;
+}
+
 } // namespace gmx
@@ -136,6 +136,28 @@ public:
      * \throws  std::bad_alloc if out of memory.
      */
     SelectionCollection();
+    /*! \brief
+     * Creates a copy of a selection collection.
+     *
+     * \param[in] rhs  Collection to copy.
+     * \throws  std::bad_alloc if out of memory.
+     * \throws  InvalidInputError if the selections cannot be recreated.
+     *
+     * The copy is constructed by parsing the variables and selections of
+     * \p rhs again, with the same flags, position types, topology and index
+     * groups.  If \p rhs has been compiled, the copy is also compiled, and
+     * per-selection state set after compilation (covered fraction types and
+     * original IDs) is copied from \p rhs.
+     * The copy can be evaluated independently of \p rhs (for example, from
+     * a different thread), and correspondingSelection() can be used to find
+     * its selections.
+     *
+     * If \p rhs uses external index groups, setRetainIndexGroups() must
+     * have been called on it before setIndexGroups().
+     * \p rhs should not be evaluated for any frame before the copy is made,
+     * and it must exist as long as the copy exists.
+     */
+    SelectionCollection(const SelectionCollection& rhs);
     ~SelectionCollection();
 
     /*! \brief
@@ -267,6 +289,19 @@ public:
      * called as setIndexGroups(NULL).
      */
     void setIndexGroups(gmx_ana_indexgrps_t* grps);
+    /*! \brief
+     * Sets whether to keep a copy of the external index groups.
+     *
+     * \param[in] bRetain  Whether to retain the groups.
+     *
+     * If called with true before setIndexGroups(), a copy of the groups
+     * passed to setIndexGroups() is kept in the collection for resolving
+     * group references in copies made with the copy constructor, also after
+     * the caller has freed the groups.
+     *
+     * Does not throw.
+     */
+    void setRetainIndexGroups(bool bRetain);
     /*! \brief
      * Parses selection(s) from standard input.
      *
@@ -411,6 +446,20 @@ public:
      */
     void printXvgrInfo(FILE* fp) const;
 
+    /*! \brief
+     * Returns the selection in this collection that corresponds to a given one.
+     *
+     * \param[in] selection  Selection from this collection, or from the
+     *     collection this collection was copied from.
+     * \returns   The corresponding selection in this collection.
+     *
+     * For a selection that belongs to this collection, returns \p selection
+     * unchanged.  Invalid selections are returned as such.
+     *
+     * Does not throw.
+     */
+    Selection correspondingSelection(const Selection& selection) const;
+
 private:
     class Impl;
 
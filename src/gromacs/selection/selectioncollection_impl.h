@@ -194,6 +194,23 @@ public:
     bool bExternalGroupsSet_;
     //! External index groups (can be NULL).
     gmx_ana_indexgrps_t* grps_;
+    //! Whether to keep a copy of the external index groups.
+    bool bRetainGroups_;
+    //! Copy of the external index groups for constructing copies (can be NULL).
+    std::shared_ptr<gmx_ana_indexgrps_t> retainedGrps_;
+    //! Whether compile() has been called.
+    bool bCompiled_;
+    //! Reference position type that was used in compile().
+    std::string compiledRpost_;
+    //! Output position type that was used in compile().
+    std::string compiledSpost_;
+    /*! \brief
+     * Selections of the collection this one was copied from.
+     *
+     * Empty if this collection was not created with the copy constructor;
+     * otherwise, the selections are in the same order as in \a sc_.
+     */
+    std::vector<const internal::SelectionData*> sourceSelections_;
 };
 
 /*! \internal
@@ -1008,6 +1008,58 @@ TEST_F(NeighborhoodSearchTest, GridSelfPairsSearch)
     testPairSearchFull(&search, data, data.testPositions(), nullptr, {}, {}, true);
 }
 
+TEST_F(NeighborhoodSearchTest, GridSearchUpdatesGridForMovedPositions)
+{
+    const NeighborhoodSearchTestData& data = RandomBoxFullPBCData::get();
+
+    nb_.setCutoff(data.cutoff_);
+    nb_.setMode(gmx::AnalysisNeighborhood::eSearchMode_Grid);
+    // Initialize the grid for displaced positions in the same array, like
+    // for a previous frame, such that some positions change cells.
+    std::vector<gmx::RVec> refPos(data.refPos_);
+    for (size_t i = 0; i < refPos.size(); i += 3)
+    {
+        refPos[i][XX] += 0.6;
+        refPos[i][YY] -= 0.4;
+    }
+    gmx::AnalysisNeighborhoodSearch search =
+            nb_.initSearch(&data.pbc_, gmx::AnalysisNeighborhoodPositions(refPos));
+    ASSERT_EQ(gmx::AnalysisNeighborhood::eSearchMode_Grid, search.mode());
+    search.reset();
+
+    std::copy(data.refPos_.begin(), data.refPos_.end(), refPos.begin());
+    search = nb_.initSearch(&data.pbc_, gmx::AnalysisNeighborhoodPositions(refPos));
+    ASSERT_EQ(gmx::AnalysisNeighborhood::eSearchMode_Grid, search.mode());
+
+    testIsWithin(&search, data);
+    testMinimumDistance(&search, data);
+    testNearestPoint(&search, data);
+    testPairSearch(&search, data);
+}
+
+TEST_F(NeighborhoodSearchTest, GridSelfPairsSearchAfterOtherReferenceSets)
+{
+    const NeighborhoodSearchTestData& data = RandomBoxSelfPairsData::get();
+
+    nb_.setCutoff(data.cutoff_);
+    nb_.setMode(gmx::AnalysisNeighborhood::eSearchMode_Grid);
+    // Alternate between reference sets, as when several sets are searched
+    // in each frame.
+    std::vector<gmx::RVec> otherPos(data.refPos_.rbegin(), data.refPos_.rend());
+    for (int frame = 0; frame < 2; ++frame)
+    {
+        gmx::AnalysisNeighborhoodSearch search = nb_.initSearch(&data.pbc_, data.refPositions());
+        search.reset();
+        search = nb_.initSearch(&data.pbc_, gmx::AnalysisNeighborhoodPositions(otherPos));
+        search.reset();
+        otherPos.pop_back();
+    }
+    gmx::AnalysisNeighborhoodSearch search = nb_.initSearch(&data.pbc_, data.refPositions());
+    ASSERT_EQ(gmx::AnalysisNeighborhood::eSearchMode_Grid, search.mode());
+
+    testPairSearchFull(&search, data, data.testPositions(), nullptr, {}, {}, true);
+}
+
 TEST_F(NeighborhoodSearchTest, HandlesConcurrentSearches)
 {
     const NeighborhoodSearchTestData& data = TrivialTestData::get();
@@ -44,6 +44,9 @@
 
 #include "gromacs/selection/selectioncollection.h"
 
+#include <memory>
+
+#include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
 #include "gromacs/options/basicoptions.h"
@@ -433,6 +436,44 @@ TEST_F(SelectionCollectionTest, HandlesForceRequestForCenterOfGeometry)
     EXPECT_TRUE(sel_[0].hasForces());
 }
 
+TEST_F(SelectionCollectionTest, CopiesCompiledCollection)
+{
+    sc_.setRetainIndexGroups(true);
+    ASSERT_NO_FATAL_FAILURE(loadIndexGroups("simple.ndx"));
+    ASSERT_NO_THROW_GMX(
+            sel_ = sc_.parseFromString("foo = group \"GrpA\" or resnr 3; foo and x < 2;"
+                                       "res_cog of group \"GrpB\""));
+    ASSERT_EQ(2U, sel_.size());
+    // Mimic SelectionOptionBehavior, which frees the groups after parsing.
+    ASSERT_NO_THROW_GMX(sc_.setIndexGroups(nullptr));
+    gmx_ana_indexgrps_free(grps_);
+    grps_ = nullptr;
+    ASSERT_NO_FATAL_FAILURE(loadTopology("simple.gro"));
+    ASSERT_NO_THROW_GMX(sc_.compile());
+    ASSERT_NO_THROW_GMX(sel_[1].initOriginalIdsToGroup(topManager_.topology(), INDEX_RES));
+
+    std::unique_ptr<gmx::SelectionCollection> copy;
+    ASSERT_NO_THROW_GMX(copy = std::make_unique<gmx::SelectionCollection>(sc_));
+    ASSERT_NO_THROW_GMX(sc_.evaluate(topManager_.frame(), nullptr));
+    ASSERT_NO_THROW_GMX(copy->evaluate(topManager_.frame(), nullptr));
+    EXPECT_EQ(sel_[0], sc_.correspondingSelection(sel_[0]));
+    for (const gmx::Selection& sel : sel_)
+    {
+        const gmx::Selection copied = copy->correspondingSelection(sel);
+        ASSERT_TRUE(copied.isValid());
+        EXPECT_NE(sel, copied);
+        EXPECT_STREQ(sel.selectionText(), copied.selectionText());
+        EXPECT_EQ(sel.isDynamic(), copied.isDynamic());
+        ASSERT_EQ(sel.posCount(), copied.posCount());
+        EXPECT_THAT(copied.atomIndices(), ::testing::Pointwise(::testing::Eq(), sel.atomIndices()));
+        for (int i = 0; i < sel.posCount(); ++i)
+        {
+            EXPECT_EQ(sel.position(i).mappedId(), copied.position(i).mappedId());
+            EXPECT_EQ(sel.position(i).x()[XX], copied.position(i).x()[XX]);
+        }
+    }
+}
+
 TEST_F(SelectionCollectionTest, ParsesSelectionsFromFile)
 {
     ASSERT_NO_THROW_GMX(
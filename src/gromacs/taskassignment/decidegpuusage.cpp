@@ -610,6 +610,10 @@ bool decideWhetherToUseGpuForUpdate(const bool                     isDomainDecom
     {
         errorMessage += "Only the md integrator is supported.\n";
     }
+    if (inputrec.useMts)
+    {
+        errorMessage += "Multiple time stepping is not supported.\n";
+    }
     if (inputrec.etc == etcNOSEHOOVER)
     {
         errorMessage += "Nose-Hoover temperature coupling is not supported.\n";
@@ -139,6 +139,7 @@ static const char* wcn[ewcNR] = { "Run",
                                   "COM pull force",
                                   "AWH",
                                   "Write traj.",
+                                  "Traj. output thread",
                                   "Update",
                                   "Constraints",
                                   "Comm. energies",
@@ -358,6 +359,16 @@ void wallcycle_increment_event_count(gmx_wallcycle_t wc, int ewc)
     wc->wcc[ewc].n++;
 }
 
+void wallcycle_add_cycles(gmx_wallcycle_t wc, int ewc, int n, double cycles)
+{
+    if (wc == nullptr)
+    {
+        return;
+    }
+    wc->wcc[ewc].n += n;
+    wc->wcc[ewc].c += static_cast<gmx_cycles_t>(cycles);
+}
+
 void wallcycle_start_nocount(gmx_wallcycle_t wc, int ewc)
 {
     if (wc == nullptr)
@@ -475,6 +486,12 @@ static gmx_bool is_pme_subcounter(int ewc)
     return (ewc >= ewcPME_REDISTXF && ewc < ewcPMEWAITCOMM);
 }
 
+/* Counters for work on separate threads that overlaps with the run */
+static gmx_bool is_background_counter(int ewc)
+{
+    return (ewc == ewcTRAJ_OUTPUT_THREAD);
+}
+
 /* Subtract counter ewc_sub timed inside a timing block for ewc_main */
 static void subtract_cycles(wallcc_t* wcc, int ewc_main, int ewc_sub)
 {
@@ -863,7 +880,7 @@ void wallcycle_print(FILE*                            fplog,
     fprintf(fplog, "%s\n", hline);
     for (i = ewcPPDURINGPME + 1; i < ewcNR; i++)
     {
-        if (is_pme_subcounter(i))
+        if (is_pme_subcounter(i) || is_background_counter(i))
         {
             /* Do not count these at all */
         }
@@ -938,6 +955,20 @@ void wallcycle_print(FILE*                            fplog,
         }
     }
 
+    if (wc->wcc[ewcTRAJ_OUTPUT_THREAD].n > 0)
+    {
+        fprintf(fplog, " Work on background threads, overlapping with the run\n");
+        fprintf(fplog, "%s\n", hline);
+        for (i = ewcPPDURINGPME + 1; i < ewcNR; i++)
+        {
+            if (is_background_counter(i))
+            {
+                print_cycles(fplog, c2t_pp, wcn[i], npp, nth_pp, wc->wcc[i].n, cyc_sum[i], tot);
+            }
+        }
+        fprintf(fplog, "%s\n", hline);
+    }
+
     if (useCycleSubcounters && wc->wcsc)
     {
         fprintf(fplog, " Breakdown of PP computation\n");
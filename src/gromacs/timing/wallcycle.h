@@ -88,6 +88,7 @@ enum
     ewcPULLPOT,
     ewcAWH,
     ewcTRAJ,
+    ewcTRAJ_OUTPUT_THREAD,
     ewcUPDATE,
     ewcCONSTR,
     ewcMoveE,
@@ -158,6 +159,9 @@ double wallcycle_stop(gmx_wallcycle_t wc, int ewc);
 void wallcycle_increment_event_count(gmx_wallcycle_t wc, int ewc);
 /* Only increment call count for ewc by one */
 
+void wallcycle_add_cycles(gmx_wallcycle_t wc, int ewc, int n, double cycles);
+/* Add n calls taking cycles in total, measured on another thread, to ewc */
+
 void wallcycle_get(gmx_wallcycle_t wc, int ewc, int* n, double* c);
 /* Returns the cumulative count and cycle count for ewc */
 
@@ -47,6 +47,7 @@
 
 #include "gromacs/commandline/pargs.h"
 #include "gromacs/fileio/enxio.h"
+#include "gromacs/fileio/gmxfio.h"
 #include "gromacs/fileio/trxio.h"
 #include "gromacs/listed_forces/disre.h"
 #include "gromacs/math/functions.h"
@@ -551,6 +552,16 @@ int gmx_eneconv(int argc, char* argv[])
         in         = open_enx(files[f].c_str(), "r");
         enm        = nullptr;
         do_enxnms(in, &this_nre, &enm);
+        if (remove_dh)
+        {
+            /* Skip the free energy blocks without decoding them */
+            gmx_bool bReadBlock[enxNR];
+            for (i = 0; i < enxNR; i++)
+            {
+                bReadBlock[i] = (i != enxDHCOLL && i != enxDH && i != enxDHHIST);
+            }
+            enx_select_blocks(in, bReadBlock);
+        }
         if (f == 0)
         {
             if (scalefac != 1)
@@ -576,6 +587,18 @@ int gmx_eneconv(int argc, char* argv[])
                     cont_type[f + 1] = TIME_EXPLICIT;
                 }
                 bNewFile = FALSE;
+
+                /* Jump to the first frame that can be written */
+                if (begin > 0 && tadjust + fr->t < begin - GMX_REAL_EPS)
+                {
+                    const gmx_off_t position = gmx_fio_ftell(enx_file_pointer(in));
+                    if (enx_seek_time(in, begin - tadjust - GMX_REAL_EPS))
+                    {
+                        continue;
+                    }
+                    /* Process the remaining frames as usual */
+                    gmx_fio_seek(enx_file_pointer(in), position);
+                }
             }
 
             if (tadjust + fr->t <= last_t)
@@ -0,0 +1,202 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2020, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Implements gmx trjindex.
+ *
+ * \ingroup module_tools
+ */
+#include "gmxpre.h"
+
+#include "trjindex.h"
+
+#include <cstdio>
+
+#include <string>
+
+#include "gromacs/commandline/cmdlineoptionsmodule.h"
+#include "gromacs/fileio/enxindex.h"
+#include "gromacs/fileio/enxio.h"
+#include "gromacs/fileio/filetypes.h"
+#include "gromacs/fileio/gmxfio.h"
+#include "gromacs/fileio/xtcindex.h"
+#include "gromacs/options/basicoptions.h"
+#include "gromacs/options/filenameoption.h"
+#include "gromacs/options/ioptionscontainer.h"
+
+namespace gmx
+{
+
+namespace
+{
+
+class TrjIndex : public ICommandLineOptionsModule
+{
+public:
+    TrjIndex() {}
+
+    // From ICommandLineOptionsModule
+    void init(CommandLineModuleSettings* /*settings*/) override {}
+    void initOptions(IOptionsContainer* options, ICommandLineOptionsModuleSettings* settings) override;
+    void optionsFinished() override {}
+    int  run() override;
+
+private:
+    //! Writes the index of the trajectory.
+    void indexTrajectory() const;
+    //! Writes the index of the energy file.
+    void indexEnergyFile() const;
+
+    //! Name of the input trajectory.
+    std::string inputTrajectoryFileName_;
+    //! Whether the trajectory was given on the command line.
+    bool bTrajectorySet_ = false;
+    //! Name of the input energy file, empty if not given.
+    std::string inputEnergyFileName_;
+    //! Whether an existing valid index is rebuilt.
+    bool bForce_ = false;
+};
+
+void TrjIndex::initOptions(IOptionsContainer* options, ICommandLineOptionsModuleSettings* settings)
+{
+    const char* desc[] = {
+        "[THISMODULE] writes a frame index for an [REF].xtc[ref] trajectory.",
+        "The index is stored next to the trajectory, with [TT].idx[tt] appended",
+        "to the file name, and lists the byte offset, step, time and number of",
+        "atoms of every frame.[PAR]",
+        "When a valid index is present, tools that read the trajectory use it",
+        "to jump directly to the first frame requested with [TT]-b[tt] instead",
+        "of searching for it in the file, and a frame can be located with a",
+        "single seek, which makes it cheap to split the analysis of a trajectory",
+        "over several processes.",
+        "The index is ignored when the trajectory has changed since the index",
+        "was written, e.g., after appending to it.[PAR]",
+        "Indices can also be written automatically whenever an [REF].xtc[ref]",
+        "file without a valid index is read to the end, by setting the",
+        "environment variable [TT]GMX_WRITE_XTC_INDEX[tt].[PAR]",
+        "With [TT]-e[tt], an index is written for an [REF].edr[ref] energy file,",
+        "which [gmx-energy] and [gmx-eneconv] use to jump to the time given",
+        "with [TT]-b[tt]. Without a valid index, these tools build one in memory",
+        "and only write it when the environment variable [TT]GMX_WRITE_EDR_INDEX[tt]",
+        "is set. The trajectory is only indexed when [TT]-f[tt] is given as well."
+    };
+    settings->setHelpText(desc);
+
+    options->addOption(FileNameOption("f")
+                               .legacyType(efXTC)
+                               .inputFile()
+                               .required()
+                               .store(&inputTrajectoryFileName_)
+                               .storeIsSet(&bTrajectorySet_)
+                               .defaultBasename("traj")
+                               .description("Trajectory to index"));
+    options->addOption(FileNameOption("e")
+                               .legacyType(efEDR)
+                               .inputFile()
+                               .store(&inputEnergyFileName_)
+                               .defaultBasename("ener")
+                               .description("Energy file to index"));
+    options->addOption(BooleanOption("force").store(&bForce_).description(
+            "Rebuild the index even when the existing one is valid"));
+}
+
+int TrjIndex::run()
+{
+    if (bTrajectorySet_ || inputEnergyFileName_.empty())
+    {
+        indexTrajectory();
+    }
+    if (!inputEnergyFileName_.empty())
+    {
+        indexEnergyFile();
+    }
+    return 0;
+}
+
+void TrjIndex::indexTrajectory() const
+{
+    const std::string indexFileName = xtcFrameIndexFileName(inputTrajectoryFileName_);
+    if (!bForce_ && loadXtcFrameIndex(inputTrajectoryFileName_) != nullptr)
+    {
+        fprintf(stderr, "%s is up to date\n", indexFileName.c_str());
+        return;
+    }
+    const XtcFrameIndex index = XtcFrameIndex::build(inputTrajectoryFileName_);
+    index.write(indexFileName);
+    fprintf(stderr, "Wrote index of %d frames to %s\n", index.frameCount(), indexFileName.c_str());
+    if (index.frameCount() > 0)
+    {
+        fprintf(stderr, "First frame at time %g, last frame at time %g\n",
+                index.frames().front().time, index.frames().back().time);
+    }
+}
+
+void TrjIndex::indexEnergyFile() const
+{
+    const std::string indexFileName = energyFrameIndexFileName(inputEnergyFileName_);
+    ener_file_t       ef            = open_enx(inputEnergyFileName_.c_str(), "r");
+    int               nre;
+    gmx_enxnm_t*      enm = nullptr;
+    do_enxnms(ef, &nre, &enm);
+    free_enxnms(nre, enm);
+    const gmx_off_t firstFrameOffset = gmx_fio_ftell(enx_file_pointer(ef));
+    if (!bForce_ && loadEnergyFrameIndex(inputEnergyFileName_, ef) != nullptr)
+    {
+        fprintf(stderr, "%s is up to date\n", indexFileName.c_str());
+        done_ener_file(ef);
+        return;
+    }
+    gmx_fio_seek(enx_file_pointer(ef), firstFrameOffset);
+    const EnergyFrameIndex index = EnergyFrameIndex::build(ef);
+    done_ener_file(ef);
+    index.write(indexFileName);
+    fprintf(stderr, "Wrote index of %d frames to %s\n", index.frameCount(), indexFileName.c_str());
+    if (index.frameCount() > 0)
+    {
+        fprintf(stderr, "First frame at time %g, last frame at time %g\n",
+                index.frames().front().time, index.frames().back().time);
+    }
+}
+
+} // namespace
+
+const char TrjIndexInfo::name[]             = "trjindex";
+const char TrjIndexInfo::shortDescription[] = "Write a frame index for fast seeking in xtc and edr files";
+ICommandLineOptionsModulePointer TrjIndexInfo::create()
+{
+    return ICommandLineOptionsModulePointer(std::make_unique<TrjIndex>());
+}
+
+} // namespace gmx
@@ -2209,8 +2209,8 @@ int gmx_tune_pme(int argc, char* argv[])
                               { efXVG, "-tpid", "tpidist", ffOPTWR },
                               { efEDI, "-ei", "sam", ffOPTRD },
                               { efXVG, "-eo", "edsam", ffOPTWR },
-                              { efXVG, "-px", "pullx", ffOPTWR },
-                              { efXVG, "-pf", "pullf", ffOPTWR },
+                              { efTSO, "-px", "pullx", ffOPTWR },
+                              { efTSO, "-pf", "pullf", ffOPTWR },
                               { efXVG, "-ro", "rotation", ffOPTWR },
                               { efLOG, "-ra", "rotangles", ffOPTWR },
                               { efLOG, "-rs", "rotslabs", ffOPTWR },
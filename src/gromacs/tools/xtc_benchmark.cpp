@@ -0,0 +1,230 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2021, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Implements gmx xtc-benchmark.
+ *
+ * \ingroup module_tools
+ */
+#include "gmxpre.h"
+
+#include "xtc_benchmark.h"
+
+#include <cstdio>
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "gromacs/commandline/cmdlineoptionsmodule.h"
+#include "gromacs/fileio/filetypes.h"
+#include "gromacs/fileio/gmxfio.h"
+#include "gromacs/fileio/gmxfio_xdr.h"
+#include "gromacs/fileio/xdrf.h"
+#include "gromacs/nbnxm/benchmark/bench_system.h"
+#include "gromacs/options/basicoptions.h"
+#include "gromacs/options/filenameoption.h"
+#include "gromacs/options/ioptionscontainer.h"
+#include "gromacs/timing/walltime_accounting.h"
+#include "gromacs/utility/exceptions.h"
+#include "gromacs/utility/stringutil.h"
+
+namespace gmx
+{
+
+namespace
+{
+
+//! Signature of the coordinate decoders that are compared.
+typedef int (*XtcDecoder)(XDR*, float*, int*, float*);
+
+class XtcBenchmark : public ICommandLineOptionsModule
+{
+public:
+    XtcBenchmark() {}
+
+    // From ICommandLineOptionsModule
+    void init(CommandLineModuleSettings* /*settings*/) override {}
+    void initOptions(IOptionsContainer* options, ICommandLineOptionsModuleSettings* settings) override;
+    void optionsFinished() override {}
+    int  run() override;
+
+private:
+    /*! \brief
+     * Decodes all frames in the benchmark file with \p decoder.
+     *
+     * Returns the shortest wall time over all iterations and stores the
+     * coordinates of the last frame in \p x.
+     */
+    double timeDecoder(XtcDecoder decoder, std::vector<float>* x) const;
+
+    //! Name of the temporary compressed coordinate file.
+    std::string fileName_;
+    //! The system size is 3000 atoms times this value.
+    int sizeFactor_ = 1;
+    //! Number of frames to write.
+    int numFrames_ = 100;
+    //! Number of times all frames are decoded.
+    int numIterations_ = 5;
+    //! Precision of the compressed coordinates.
+    real precision_ = 1000;
+    //! Number of atoms in the benchmark system.
+    int numAtoms_ = 0;
+};
+
+void XtcBenchmark::initOptions(IOptionsContainer* options, ICommandLineOptionsModuleSettings* settings)
+{
+    const char* desc[] = {
+        "[THISMODULE] measures how fast the compressed coordinates of",
+        "[REF].xtc[ref] frames are decoded.",
+        "It writes a trajectory of a box of water, which is displaced",
+        "randomly between frames, and decodes all frames with both the",
+        "default decoder and the original bit-by-bit reference decoder.",
+        "Only the decoding of the coordinates is timed, the file is read",
+        "into memory by the operating system after the first iteration.[PAR]",
+        "The decoded coordinates of both decoders are compared, and a",
+        "difference is reported as an error."
+    };
+    settings->setHelpText(desc);
+
+    options->addOption(FileNameOption("o")
+                               .legacyType(efXTC)
+                               .outputFile()
+                               .required()
+                               .store(&fileName_)
+                               .defaultBasename("xtcbench")
+                               .description("Temporary trajectory, removed afterwards"));
+    options->addOption(IntegerOption("size").store(&sizeFactor_).description(
+            "The system size is 3000 atoms times this value, should be a power of 2"));
+    options->addOption(IntegerOption("frames").store(&numFrames_).description("Number of frames"));
+    options->addOption(
+            IntegerOption("iter").store(&numIterations_).description("Number of times the frames are decoded"));
+    options->addOption(RealOption("prec").store(&precision_).description("Precision of the coordinates"));
+}
+
+double XtcBenchmark::timeDecoder(XtcDecoder decoder, std::vector<float>* x) const
+{
+    double bestTime = 0;
+    for (int iteration = 0; iteration < numIterations_; iteration++)
+    {
+        t_fileio*    fio       = gmx_fio_open(fileName_.c_str(), "r");
+        XDR*         xdr       = gmx_fio_getxdr(fio);
+        const double startTime = gmx_gettime();
+        for (int frame = 0; frame < numFrames_; frame++)
+        {
+            int   size      = numAtoms_;
+            float precision = 0;
+            if (decoder(xdr, x->data(), &size, &precision) == 0)
+            {
+                GMX_THROW(FileIOError(formatString("Could not decode frame %d", frame)));
+            }
+        }
+        const double time = gmx_gettime() - startTime;
+        gmx_fio_close(fio);
+        bestTime = (iteration == 0 ? time : std::min(bestTime, time));
+    }
+    return bestTime;
+}
+
+int XtcBenchmark::run()
+{
+    const BenchmarkSystem system(sizeFactor_);
+    numAtoms_ = system.coordinates.size();
+
+    std::vector<float> x(DIM * numAtoms_);
+    for (int i = 0; i < numAtoms_; i++)
+    {
+        for (int d = 0; d < DIM; d++)
+        {
+            x[i * DIM + d] = system.coordinates[i][d];
+        }
+    }
+
+    /* Displace the atoms between frames by about the distance they would
+     * move between trajectory output steps in a simulation.
+     */
+    std::mt19937                          rng(numAtoms_);
+    std::uniform_real_distribution<float> displacement(-0.02, 0.02);
+    t_fileio*                             fio = gmx_fio_open(fileName_.c_str(), "w");
+    for (int frame = 0; frame < numFrames_; frame++)
+    {
+        for (float& coordinate : x)
+        {
+            coordinate += displacement(rng);
+        }
+        int   size      = numAtoms_;
+        float precision = precision_;
+        xdr3dfcoord(gmx_fio_getxdr(fio), x.data(), &size, &precision);
+    }
+    gmx_fio_close(fio);
+
+    std::vector<float> xReference(x.size());
+    std::vector<float> xFast(x.size());
+    const double       referenceTime = timeDecoder(xdr3dfcoord_reference, &xReference);
+    const double       fastTime      = timeDecoder(xdr3dfcoord, &xFast);
+    std::remove(fileName_.c_str());
+
+    if (xReference != xFast)
+    {
+        GMX_THROW(InternalError("The reference and optimized decoders produced different coordinates"));
+    }
+
+    fprintf(stdout, "Decoded %d frames of %d atoms, best of %d iterations\n", numFrames_,
+            numAtoms_, numIterations_);
+    fprintf(stdout, "Decoder       time (s)   frames/s  Matoms/s\n");
+    for (const auto& result : { std::make_pair("reference", referenceTime),
+                                std::make_pair("default", fastTime) })
+    {
+        fprintf(stdout, "%-10s %11.4f %10.1f %9.2f\n", result.first, result.second,
+                numFrames_ / result.second, numFrames_ * 1e-6 * numAtoms_ / result.second);
+    }
+    fprintf(stdout, "Speedup of the default decoder: %.2f\n", referenceTime / fastTime);
+
+    return 0;
+}
+
+} // namespace
+
+const char XtcBenchmarkInfo::name[] = "xtc-benchmark";
+const char XtcBenchmarkInfo::shortDescription[] =
+        "Benchmarking tool for decoding compressed trajectory coordinates";
+
+ICommandLineOptionsModulePointer XtcBenchmarkInfo::create()
+{
+    return ICommandLineOptionsModulePointer(std::make_unique<XtcBenchmark>());
+}
+
+} // namespace gmx
@@ -127,10 +127,13 @@ public:
      * SelectionOption.  The return value is the corresponding selection
      * in the selection collection with which this data object was
      * constructed with.
+     * When frames are analyzed in parallel, this collection is a
+     * thread-local copy of the global collection, and its selections are
+     * evaluated separately for each frame.
      *
      * Does not throw.
      */
-    static Selection parallelSelection(const Selection& selection);
+    Selection parallelSelection(const Selection& selection) const;
     /*! \brief
      * Returns a set of selection that corresponds to the given selections.
      *
@@ -140,7 +143,7 @@ public:
      *
      * \see parallelSelection()
      */
-    static SelectionList parallelSelections(const SelectionList& selections);
+    SelectionList parallelSelections(const SelectionList& selections) const;
 
 protected:
     /*! \brief
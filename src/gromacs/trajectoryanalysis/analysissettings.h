@@ -128,6 +128,17 @@ public:
          * \see setRmPBC()
          */
         efNoUserRmPBC = 1 << 5,
+        /*! \brief
+         * Declares that frames can be analyzed in parallel.
+         *
+         * If this flag is specified, a `-nt` option is provided for the user
+         * to set the number of threads, and TrajectoryAnalysisModule::analyzeFrame()
+         * can be called concurrently for different frames.
+         * The module must then keep all its frame-local data in the object
+         * returned by TrajectoryAnalysisModule::startFrames(), and obtain
+         * its selections through TrajectoryAnalysisModuleData.
+         */
+        efFrameParallel = 1 << 6,
     };
 
     //! Initializes default settings.
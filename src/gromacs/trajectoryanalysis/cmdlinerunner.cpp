@@ -44,9 +44,14 @@
 
 #include "cmdlinerunner.h"
 
+#include <exception>
+#include <memory>
+#include <vector>
+
 #include "gromacs/analysisdata/paralleloptions.h"
 #include "gromacs/commandline/cmdlinemodulemanager.h"
 #include "gromacs/commandline/cmdlineoptionsmodule.h"
+#include "gromacs/math/vectypes.h"
 #include "gromacs/options/ioptionscontainer.h"
 #include "gromacs/options/timeunitmanager.h"
 #include "gromacs/pbcutil/pbc.h"
@@ -68,6 +73,56 @@ namespace gmx
 namespace
 {
 
+/********************************************************************
+ * FrameCopy
+ */
+
+/*! \brief
+ * Deep copy of a trajectory frame for analysis in a separate thread.
+ *
+ * The memory for the coordinate arrays is reused between frames.
+ */
+class FrameCopy
+{
+public:
+    FrameCopy() : frame_() {}
+
+    //! Copies \p src into this object.
+    void copyFrom(const t_trxframe& src)
+    {
+        frame_   = src;
+        frame_.x = copyArray(src.bX ? src.x : nullptr, src.natoms, &x_);
+        frame_.v = copyArray(src.bV ? src.v : nullptr, src.natoms, &v_);
+        frame_.f = copyArray(src.bF ? src.f : nullptr, src.natoms, &f_);
+        if (src.bIndex && src.index != nullptr)
+        {
+            index_.assign(src.index, src.index + src.natoms);
+            frame_.index = index_.data();
+        }
+    }
+
+    //! Returns the copied frame.
+    t_trxframe& frame() { return frame_; }
+
+private:
+    //! Copies \p count vectors from \p src into \p dest.
+    static rvec* copyArray(const rvec* src, int count, std::vector<RVec>* dest)
+    {
+        if (src == nullptr)
+        {
+            return nullptr;
+        }
+        dest->assign(src, src + count);
+        return as_rvec_array(dest->data());
+    }
+
+    t_trxframe        frame_;
+    std::vector<RVec> x_;
+    std::vector<RVec> v_;
+    std::vector<RVec> f_;
+    std::vector<int>  index_;
+};
+
 /********************************************************************
  * RunnerModule
  */
@@ -86,6 +141,20 @@ public:
     void optionsFinished() override;
     int  run() override;
 
+    /*! \brief
+     * Analyzes all frames, several of them concurrently.
+     *
+     * \returns  Number of frames analyzed.
+     *
+     * Frames are read in batches of common_.threadCount() frames.
+     * Each frame in a batch is evaluated and analyzed in a separate thread,
+     * using a copy of the selection collection and module data specific to
+     * the position in the batch.  After each batch, the frames are finished
+     * serially in order, such that the data modules receive the frames in
+     * the same order as in serial analysis.
+     */
+    int analyzeFramesInParallel();
+
     TrajectoryAnalysisModulePointer module_;
     TrajectoryAnalysisSettings      settings_;
     TrajectoryAnalysisRunnerCommon  common_;
@@ -113,6 +182,79 @@ void RunnerModule::optionsFinished()
 {
     common_.optionsFinished();
     module_->optionsFinished(&settings_);
+    // Copies of the selection collection need the index groups for parsing.
+    selections_.setRetainIndexGroups(common_.threadCount() > 1);
+}
+
+int RunnerModule::analyzeFramesInParallel()
+{
+    const TopologyInformation& topology    = common_.topologyInformation();
+    const int                  threadCount = common_.threadCount();
+
+    AnalysisDataParallelOptions                       dataOptions(threadCount);
+    std::vector<std::unique_ptr<SelectionCollection>> threadSelections;
+    std::vector<TrajectoryAnalysisModuleDataPointer>  threadData;
+    for (int i = 0; i < threadCount; ++i)
+    {
+        threadSelections.push_back(std::make_unique<SelectionCollection>(selections_));
+        threadData.push_back(module_->startFrames(dataOptions, *threadSelections.back()));
+    }
+    std::vector<FrameCopy>          frames(threadCount);
+    std::vector<t_pbc>              pbc(threadCount);
+    std::vector<std::exception_ptr> exceptions(threadCount);
+
+    int  nframes = 0;
+    bool bMore   = true;
+    while (bMore)
+    {
+        int batchSize = 0;
+        do
+        {
+            common_.initFrame();
+            frames[batchSize].copyFrom(common_.frame());
+            ++batchSize;
+            bMore = common_.readNextFrame();
+        } while (bMore && batchSize < threadCount);
+
+#pragma omp parallel for num_threads(batchSize) schedule(static, 1)
+        for (int i = 0; i < batchSize; ++i)
+        {
+            try
+            {
+                t_trxframe& frame = frames[i].frame();
+                t_pbc*      ppbc  = settings_.hasPBC() ? &pbc[i] : nullptr;
+                if (ppbc != nullptr)
+                {
+                    set_pbc(ppbc, topology.pbcType(), frame.box);
+                }
+                threadSelections[i]->evaluate(&frame, ppbc);
+                module_->analyzeFrame(nframes + i, frame, ppbc, threadData[i].get());
+            }
+            catch (...)
+            {
+                exceptions[i] = std::current_exception();
+            }
+        }
+        for (int i = 0; i < batchSize; ++i)
+        {
+            if (exceptions[i])
+            {
+                std::rethrow_exception(exceptions[i]);
+            }
+            module_->finishFrameSerial(nframes + i);
+        }
+        nframes += batchSize;
+    }
+    for (auto& pdata : threadData)
+    {
+        module_->finishFrames(pdata.get());
+        if (pdata != nullptr)
+        {
+            pdata->finish();
+        }
+        pdata.reset();
+    }
+    return nframes;
 }
 
 int RunnerModule::run()
@@ -126,33 +268,40 @@ int RunnerModule::run()
     common_.initFrameIndexGroup();
     module_->initAfterFirstFrame(settings_, common_.frame());
 
-    t_pbc  pbc;
-    t_pbc* ppbc = settings_.hasPBC() ? &pbc : nullptr;
-
-    int                                 nframes = 0;
-    AnalysisDataParallelOptions         dataOptions;
-    TrajectoryAnalysisModuleDataPointer pdata(module_->startFrames(dataOptions, selections_));
-    do
+    int nframes = 0;
+    if (common_.threadCount() > 1)
+    {
+        nframes = analyzeFramesInParallel();
+    }
+    else
     {
-        common_.initFrame();
-        t_trxframe& frame = common_.frame();
-        if (ppbc != nullptr)
+        t_pbc  pbc;
+        t_pbc* ppbc = settings_.hasPBC() ? &pbc : nullptr;
+
+        AnalysisDataParallelOptions         dataOptions;
+        TrajectoryAnalysisModuleDataPointer pdata(module_->startFrames(dataOptions, selections_));
+        do
         {
-            set_pbc(ppbc, topology.pbcType(), frame.box);
-        }
+            common_.initFrame();
+            t_trxframe& frame = common_.frame();
+            if (ppbc != nullptr)
+            {
+                set_pbc(ppbc, topology.pbcType(), frame.box);
+            }
 
-        selections_.evaluate(&frame, ppbc);
-        module_->analyzeFrame(nframes, frame, ppbc, pdata.get());
-        module_->finishFrameSerial(nframes);
+            selections_.evaluate(&frame, ppbc);
+            module_->analyzeFrame(nframes, frame, ppbc, pdata.get());
+            module_->finishFrameSerial(nframes);
 
-        ++nframes;
-    } while (common_.readNextFrame());
-    module_->finishFrames(pdata.get());
-    if (pdata.get() != nullptr)
-    {
-        pdata->finish();
+            ++nframes;
+        } while (common_.readNextFrame());
+        module_->finishFrames(pdata.get());
+        if (pdata.get() != nullptr)
+        {
+            pdata->finish();
+        }
+        pdata.reset();
     }
-    pdata.reset();
 
     if (common_.hasTrajectory())
     {
@@ -52,6 +52,9 @@
 #include "gromacs/math/vec.h"
 #include "gromacs/pbcutil/pbc.h"
 #include "gromacs/selection/nbsearch.h"
+#include "gromacs/simd/simd.h"
+#include "gromacs/utility/alignedallocator.h"
+#include "gromacs/utility/exceptions.h"
 #include "gromacs/utility/fatalerror.h"
 #include "gromacs/utility/gmxassert.h"
 #include "gromacs/utility/smalloc.h"
@@ -78,41 +81,41 @@ static real safe_asin(real f)
 /* routines for dot distributions on the surface of the unit sphere */
 static real icosaeder_vertices(real* xus)
 {
-    const real rh = std::sqrt(1. - 2. * cos(TORAD(72.))) / (1. - cos(TORAD(72.)));
-    const real rg = cos(TORAD(72.)) / (1. - cos(TORAD(72.)));
+    const real rh = std::sqrt(1. - 2. * std::cos(TORAD(72.))) / (1. - std::cos(TORAD(72.)));
+    const real rg = std::cos(TORAD(72.)) / (1. - std::cos(TORAD(72.)));
     /* icosaeder vertices */
     xus[0]  = 0.;
     xus[1]  = 0.;
     xus[2]  = 1.;
-    xus[3]  = rh * cos(TORAD(72.));
-    xus[4]  = rh * sin(TORAD(72.));
+    xus[3]  = rh * std::cos(TORAD(72.));
+    xus[4]  = rh * std::sin(TORAD(72.));
     xus[5]  = rg;
-    xus[6]  = rh * cos(TORAD(144.));
-    xus[7]  = rh * sin(TORAD(144.));
+    xus[6]  = rh * std::cos(TORAD(144.));
+    xus[7]  = rh * std::sin(TORAD(144.));
     xus[8]  = rg;
-    xus[9]  = rh * cos(TORAD(216.));
-    xus[10] = rh * sin(TORAD(216.));
+    xus[9]  = rh * std::cos(TORAD(216.));
+    xus[10] = rh * std::sin(TORAD(216.));
     xus[11] = rg;
-    xus[12] = rh * cos(TORAD(288.));
-    xus[13] = rh * sin(TORAD(288.));
+    xus[12] = rh * std::cos(TORAD(288.));
+    xus[13] = rh * std::sin(TORAD(288.));
     xus[14] = rg;
     xus[15] = rh;
     xus[16] = 0;
     xus[17] = rg;
-    xus[18] = rh * cos(TORAD(36.));
-    xus[19] = rh * sin(TORAD(36.));
+    xus[18] = rh * std::cos(TORAD(36.));
+    xus[19] = rh * std::sin(TORAD(36.));
     xus[20] = -rg;
-    xus[21] = rh * cos(TORAD(108.));
-    xus[22] = rh * sin(TORAD(108.));
+    xus[21] = rh * std::cos(TORAD(108.));
+    xus[22] = rh * std::sin(TORAD(108.));
     xus[23] = -rg;
     xus[24] = -rh;
     xus[25] = 0;
     xus[26] = -rg;
-    xus[27] = rh * cos(TORAD(252.));
-    xus[28] = rh * sin(TORAD(252.));
+    xus[27] = rh * std::cos(TORAD(252.));
+    xus[28] = rh * std::sin(TORAD(252.));
     xus[29] = -rg;
-    xus[30] = rh * cos(TORAD(324.));
-    xus[31] = rh * sin(TORAD(324.));
+    xus[30] = rh * std::cos(TORAD(324.));
+    xus[31] = rh * std::sin(TORAD(324.));
     xus[32] = -rg;
     xus[33] = 0.;
     xus[34] = 0.;
@@ -141,8 +144,8 @@ divarc(real x1, real y1, real z1, real x2, real y2, real z2, int div1, int div2,
 
     phi  = safe_asin(dd / std::sqrt(d1 * d2));
     phi  = phi * (static_cast<real>(div1)) / (static_cast<real>(div2));
-    sphi = sin(phi);
-    cphi = cos(phi);
+    sphi = std::sin(phi);
+    cphi = std::cos(phi);
     s    = (x1 * xd + y1 * yd + z1 * zd) / dd;
 
     x   = xd * s * (1. - cphi) / dd + x1 * cphi + (yd * z1 - y1 * zd) * sphi / dd;
@@ -176,7 +179,7 @@ static std::vector<real> ico_dot_arc(int densit)
     if (tess > 1)
     {
         tn = 12;
-        a  = rh * rh * 2. * (1. - cos(TORAD(72.)));
+        a  = rh * rh * 2. * (1. - std::cos(TORAD(72.)));
         /* calculate tessalation of icosaeder edges */
         for (i = 0; i < 11; i++)
         {
@@ -292,7 +295,7 @@ static std::vector<real> ico_dot_dod(int densit)
 
     tn = 12;
     /* square of the edge of an icosaeder */
-    a = rh * rh * 2. * (1. - cos(TORAD(72.)));
+    a = rh * rh * 2. * (1. - std::cos(TORAD(72.)));
     /* dodecaeder vertices */
     for (i = 0; i < 10; i++)
     {
@@ -340,7 +343,7 @@ static std::vector<real> ico_dot_dod(int densit)
     {
         tn = 32;
         /* square of the edge of an dodecaeder */
-        adod = 4. * (cos(TORAD(108.)) - cos(TORAD(120.))) / (1. - cos(TORAD(120.)));
+        adod = 4. * (std::cos(TORAD(108.)) - std::cos(TORAD(120.))) / (1. - std::cos(TORAD(120.)));
         /* square of the distance of two adjacent vertices of ico- and dodecaeder */
         ai_d = 2. * (1. - std::sqrt(1. - a / 3.));
 
@@ -581,6 +584,74 @@ static std::vector<real> make_unsp(int densit, int cubus)
     return xus;
 }
 
+namespace
+{
+
+//! Number of neighbors that are sorted by cap size and tested together
+constexpr size_t c_neighborChunkSize = 8;
+
+//! A sphere that overlaps with the sphere whose dots are tested
+struct CoveringNeighbor
+{
+    //! Vector from the center of the tested sphere to the neighbor
+    RVec dx;
+    //! Dots with a projection on dx larger than this are covered
+    real refdot;
+    //! Cosine of the half-angle of the covered cap, smaller covers more dots
+    real capCosine;
+};
+
+/*! \brief
+ * Clears \p alive for the surface dots covered by any of \p neighbors
+ *
+ * The dots are stored in batches of \p packSize, and \p alive is 1 for
+ * uncovered dots and 0 for covered dots and for padding.  Each neighbor
+ * is tested against a full batch of dots at once.  Batches in which all
+ * dots are covered are dropped from \p activeBatches, and the loop over
+ * neighbors stops when no batch is left.  Since the neighbors are sorted
+ * by decreasing cap size, most dots are covered by the first few
+ * neighbors.
+ */
+template<typename T, typename TBool, int packSize>
+void markCoveredDots(const real*                      dotX,
+                     const real*                      dotY,
+                     const real*                      dotZ,
+                     ArrayRef<const CoveringNeighbor> neighbors,
+                     real*                            alive,
+                     std::vector<int>*                activeBatches)
+{
+    const T zero(0.0_real);
+    for (const CoveringNeighbor& neighbor : neighbors)
+    {
+        const T dx(neighbor.dx[XX]);
+        const T dy(neighbor.dx[YY]);
+        const T dz(neighbor.dx[ZZ]);
+        const T refdot(neighbor.refdot);
+
+        size_t numActive = 0;
+        for (int batch : *activeBatches)
+        {
+            const int   offset   = batch * packSize;
+            const T     proj     = fma(load<T>(dotZ + offset), dz,
+                                 fma(load<T>(dotY + offset), dy, load<T>(dotX + offset) * dx));
+            const TBool bCovered = (refdot < proj);
+            const T     aliveNew = selectByNotMask(load<T>(alive + offset), bCovered);
+            store(alive + offset, aliveNew);
+            if (anyTrue(zero < aliveNew))
+            {
+                (*activeBatches)[numActive++] = batch;
+            }
+        }
+        activeBatches->resize(numActive);
+        if (numActive == 0)
+        {
+            break;
+        }
+    }
+}
+
+} // namespace
+
 static void nsc_dclm_pbc(const rvec*                 coords,
                          const ArrayRef<const real>& radius,
                          int                         nat,
@@ -594,7 +665,8 @@ static void nsc_dclm_pbc(const rvec*                 coords,
                          int*                        nu_dots,
                          int                         index[],
                          AnalysisNeighborhood*       nb,
-                         const t_pbc*                pbc)
+                         const t_pbc*                pbc,
+                         int                         nthreads)
 {
     const real dotarea = FOURPI / static_cast<real>(n_dot);
 
@@ -612,10 +684,6 @@ static void nsc_dclm_pbc(const rvec*                 coords,
     real  area = 0.0, vol = 0.0;
     real *dots = nullptr, *atom_area = nullptr;
     int   lfnr = 0, maxdots = 0;
-    if (mode & FLAG_VOLUME)
-    {
-        vol = 0.;
-    }
     if (mode & FLAG_DOTS)
     {
         maxdots = (3 * n_dot * nat) / 10;
@@ -650,64 +718,140 @@ static void nsc_dclm_pbc(const rvec*                 coords,
     pos.indexed(constArrayRefFromArray(index, nat));
     AnalysisNeighborhoodSearch nbsearch(nb->initSearch(pbc, pos));
 
-    std::vector<int> wkdot(n_dot);
-
-    for (int i = 0; i < nat; ++i)
-    {
-        const int                      iat  = index[i];
-        const real                     ai   = radius[iat];
-        const real                     aisq = ai * ai;
-        AnalysisNeighborhoodPairSearch pairSearch(nbsearch.startPairSearch(coords[iat]));
-        AnalysisNeighborhoodPair       pair;
-        std::fill(wkdot.begin(), wkdot.end(), 1);
-        int currDotCount = n_dot;
-        while (currDotCount > 0 && pairSearch.findNextPair(&pair))
+#if GMX_SIMD_HAVE_REAL
+    constexpr int c_packSize = GMX_SIMD_REAL_WIDTH;
+#else
+    constexpr int c_packSize = 1;
+#endif
+    // The unit sphere dots as separate coordinate arrays, padded to full
+    // batches with dots that are never alive.
+    const int                                 numBatches = (n_dot + c_packSize - 1) / c_packSize;
+    const int                                 paddedSize = numBatches * c_packSize;
+    std::vector<real, AlignedAllocator<real>> dotX(paddedSize, 0), dotY(paddedSize, 0),
+            dotZ(paddedSize, 0), initialAlive(paddedSize, 0);
+    for (int l = 0; l < n_dot; l++)
+    {
+        dotX[l]         = xus[3 * l];
+        dotY[l]         = xus[1 + 3 * l];
+        dotZ[l]         = xus[2 + 3 * l];
+        initialAlive[l] = 1;
+    }
+
+    // Per-atom results, summed in atom order afterwards so that the
+    // totals do not depend on the number of threads.
+    std::vector<real>          atomAreas(nat);
+    std::vector<real>          atomVolumes((mode & FLAG_VOLUME) ? nat : 0);
+    std::vector<unsigned char> dotAlive((mode & FLAG_DOTS) ? static_cast<size_t>(nat) * n_dot : 0);
+
+#pragma omp parallel num_threads(nthreads)
+    {
+        try
         {
-            const int  jat = index[pair.refIndex()];
-            const real aj  = radius[jat];
-            const real d2  = pair.distance2();
-            if (iat == jat || d2 > gmx::square(ai + aj))
-            {
-                continue;
-            }
-            const rvec& dx     = pair.dx();
-            const real  refdot = (d2 + aisq - aj * aj) / (2 * ai);
-            // TODO: Consider whether micro-optimizations from the old
-            // implementation would be useful, compared to the complexity that
-            // they bring: instead of this direct loop, the neighbors were
-            // stored into a temporary array, the loop order was
-            // reversed (first over dots, then over neighbors), and for each
-            // dot, it was first checked whether the same neighbor that
-            // resulted in marking the previous dot covered would also cover
-            // this dot. This presumably plays together with sorting of the
-            // surface dots (done in make_unsp) to avoid some of the looping.
-            // Alternatively, we could keep a skip list here to avoid
-            // repeatedly looping over dots that have already marked as
-            // covered.
-            for (int j = 0; j < n_dot; ++j)
+            std::vector<CoveringNeighbor>             neighbors;
+            std::vector<int>                          activeBatches;
+            std::vector<real, AlignedAllocator<real>> alive(paddedSize);
+
+#pragma omp for schedule(dynamic, 16)
+            for (int i = 0; i < nat; ++i)
             {
-                if (wkdot[j] && iprod(&xus[3 * j], dx) > refdot)
+                const int                      iat  = index[i];
+                const real                     ai   = radius[iat];
+                const real                     aisq = ai * ai;
+                AnalysisNeighborhoodPairSearch pairSearch(nbsearch.startPairSearch(coords[iat]));
+                AnalysisNeighborhoodPair       pair;
+                std::copy(initialAlive.begin(), initialAlive.end(), alive.begin());
+                activeBatches.resize(numBatches);
+                for (int b = 0; b < numBatches; b++)
+                {
+                    activeBatches[b] = b;
+                }
+                // Neighbors are collected and sorted in chunks, so that the
+                // pair search can stop early for buried atoms.
+                bool bMorePairs = true;
+                while (bMorePairs && !activeBatches.empty())
                 {
-                    --currDotCount;
-                    wkdot[j] = 0;
+                    neighbors.clear();
+                    while (neighbors.size() < c_neighborChunkSize
+                           && (bMorePairs = pairSearch.findNextPair(&pair)))
+                    {
+                        const int  jat = index[pair.refIndex()];
+                        const real aj  = radius[jat];
+                        const real d2  = pair.distance2();
+                        if (iat == jat || d2 > gmx::square(ai + aj))
+                        {
+                            continue;
+                        }
+                        const real refdot    = (d2 + aisq - aj * aj) / (2 * ai);
+                        const real capCosine = (d2 > 0) ? refdot * invsqrt(d2) : -1;
+                        neighbors.push_back({ pair.dx(), refdot, capCosine });
+                    }
+                    std::sort(neighbors.begin(), neighbors.end(),
+                              [](const CoveringNeighbor& a, const CoveringNeighbor& b) {
+                                  return a.capCosine < b.capCosine;
+                              });
+#if GMX_SIMD_HAVE_REAL
+                    markCoveredDots<SimdReal, SimdBool, c_packSize>(dotX.data(), dotY.data(),
+                                                                    dotZ.data(), neighbors,
+                                                                    alive.data(), &activeBatches);
+#else
+                    markCoveredDots<real, bool, c_packSize>(dotX.data(), dotY.data(),
+                                                            dotZ.data(), neighbors,
+                                                            alive.data(), &activeBatches);
+#endif
+                }
+
+                int  currDotCount = 0;
+                real dx = 0.0, dy = 0.0, dz = 0.0;
+                for (int l = 0; l < n_dot; l++)
+                {
+                    if (alive[l] != 0)
+                    {
+                        currDotCount++;
+                        dx = dx + xus[3 * l];
+                        dy = dy + xus[1 + 3 * l];
+                        dz = dz + xus[2 + 3 * l];
+                    }
+                }
+                atomAreas[i] = aisq * dotarea * currDotCount;
+                if (mode & FLAG_VOLUME)
+                {
+                    const real xi  = coords[iat][XX];
+                    const real yi  = coords[iat][YY];
+                    const real zi  = coords[iat][ZZ];
+                    atomVolumes[i] = aisq
+                                     * (dx * (xi - xs) + dy * (yi - ys) + dz * (zi - zs)
+                                        + ai * currDotCount);
+                }
+                if (mode & FLAG_DOTS)
+                {
+                    for (int l = 0; l < n_dot; l++)
+                    {
+                        dotAlive[static_cast<size_t>(i) * n_dot + l] = (alive[l] != 0);
+                    }
                 }
             }
         }
+        GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR
+    }
 
-        const real a = aisq * dotarea * currDotCount;
-        area         = area + a;
+    for (int i = 0; i < nat; ++i)
+    {
+        const int  iat = index[i];
+        const real ai  = radius[iat];
+        const real a   = atomAreas[i];
+        area           = area + a;
         if (mode & FLAG_ATOM_AREA)
         {
             atom_area[i] = a;
         }
-        const real xi = coords[iat][XX];
-        const real yi = coords[iat][YY];
-        const real zi = coords[iat][ZZ];
         if (mode & FLAG_DOTS)
         {
+            const real xi = coords[iat][XX];
+            const real yi = coords[iat][YY];
+            const real zi = coords[iat][ZZ];
             for (int l = 0; l < n_dot; l++)
             {
-                if (wkdot[l])
+                if (dotAlive[static_cast<size_t>(i) * n_dot + l])
                 {
                     lfnr++;
                     if (maxdots <= 3 * lfnr + 1)
@@ -723,17 +867,7 @@ static void nsc_dclm_pbc(const rvec*                 coords,
         }
         if (mode & FLAG_VOLUME)
         {
-            real dx = 0.0, dy = 0.0, dz = 0.0;
-            for (int l = 0; l < n_dot; l++)
-            {
-                if (wkdot[l])
-                {
-                    dx = dx + xus[3 * l];
-                    dy = dy + xus[1 + 3 * l];
-                    dz = dz + xus[2 + 3 * l];
-                }
-            }
-            vol = vol + aisq * (dx * (xi - xs) + dy * (yi - ys) + dz * (zi - zs) + ai * currDotCount);
+            vol = vol + atomVolumes[i];
         }
     }
 
@@ -767,11 +901,12 @@ namespace gmx
 class SurfaceAreaCalculator::Impl
 {
 public:
-    Impl() : flags_(0) {}
+    Impl() : flags_(0), threadCount_(1) {}
 
     std::vector<real>            unitSphereDots_;
     ArrayRef<const real>         radius_;
     int                          flags_;
+    int                          threadCount_;
     mutable AnalysisNeighborhood nb_;
 };
 
@@ -794,6 +929,11 @@ void SurfaceAreaCalculator::setRadii(const ArrayRef<const real>& radius)
     }
 }
 
+void SurfaceAreaCalculator::setThreadCount(int threadCount)
+{
+    impl_->threadCount_ = std::max(threadCount, 1);
+}
+
 void SurfaceAreaCalculator::setCalculateVolume(bool bVolume)
 {
     if (bVolume)
@@ -876,7 +1016,8 @@ void SurfaceAreaCalculator::calculate(const rvec*  x,
         *n_dots = 0;
     }
     nsc_dclm_pbc(x, impl_->radius_, nat, &impl_->unitSphereDots_[0], impl_->unitSphereDots_.size() / 3,
-                 flags, area, at_area, volume, lidots, n_dots, index, &impl_->nb_, pbc);
+                 flags, area, at_area, volume, lidots, n_dots, index, &impl_->nb_, pbc,
+                 impl_->threadCount_);
 }
 
 } // namespace gmx
@@ -105,6 +105,17 @@ public:
      * Does not throw.
      */
     void setRadii(const ArrayRef<const real>& radius);
+    /*! \brief
+     * Sets the number of OpenMP threads that calculate() uses.
+     *
+     * The atoms are divided over the threads.  The results do not depend
+     * on the number of threads.  When calculate() is called from within a
+     * parallel region, nested parallelism is normally disabled and a single
+     * thread is used.  The default is one thread.
+     *
+     * Does not throw.
+     */
+    void setThreadCount(int threadCount);
 
     /*! \brief
      * Requests calculation of volume.
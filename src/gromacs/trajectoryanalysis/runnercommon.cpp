@@ -44,6 +44,9 @@
 
 #include "runnercommon.h"
 
+#include "config.h"
+
+#include <cstdio>
 #include <cstring>
 
 #include <algorithm>
@@ -127,6 +130,8 @@ public:
     bool        bStartTimeSet_;
     bool        bEndTimeSet_;
     bool        bDeltaTimeSet_;
+    //! Number of frames to analyze concurrently.
+    int threadCount_;
 
     bool bTrajOpen_;
     //! The current frame, or \p NULL if no frame loaded yet.
@@ -146,6 +151,7 @@ TrajectoryAnalysisRunnerCommon::Impl::Impl(TrajectoryAnalysisSettings* settings)
     bStartTimeSet_(false),
     bEndTimeSet_(false),
     bDeltaTimeSet_(false),
+    threadCount_(1),
     bTrajOpen_(false),
     fr(nullptr),
     gpbc_(nullptr),
@@ -384,6 +390,12 @@ void TrajectoryAnalysisRunnerCommon::initOptions(IOptionsContainer* options, Tim
                         .store(&settings.impl_->bPBC)
                         .description("Use periodic boundary conditions for distance calculation"));
     }
+    if (settings.hasFlag(TrajectoryAnalysisSettings::efFrameParallel))
+    {
+        options->addOption(IntegerOption("nt")
+                                   .store(&impl_->threadCount_)
+                                   .description("Number of threads for analyzing frames in parallel"));
+    }
 }
 
 
@@ -400,6 +412,18 @@ void TrajectoryAnalysisRunnerCommon::optionsFinished()
                 InconsistentInputError("-fgroup only makes sense together with a trajectory (-f)"));
     }
 
+    if (impl_->threadCount_ < 1)
+    {
+        GMX_THROW(InvalidInputError("-nt must be at least one"));
+    }
+    if (impl_->threadCount_ > 1 && !GMX_OPENMP)
+    {
+        std::fprintf(stderr,
+                     "NOTE: Analyzing frames in parallel requires OpenMP support, "
+                     "which is not available; using a single thread.\n");
+        impl_->threadCount_ = 1;
+    }
+
     impl_->settings_.impl_->plotSettings.setTimeUnit(impl_->settings_.timeUnit());
 
     if (impl_->bStartTimeSet_)
@@ -466,6 +490,12 @@ bool TrajectoryAnalysisRunnerCommon::hasTrajectory() const
 }
 
 
+int TrajectoryAnalysisRunnerCommon::threadCount() const
+{
+    return impl_->threadCount_;
+}
+
+
 const TopologyInformation& TrajectoryAnalysisRunnerCommon::topologyInformation() const
 {
     return impl_->topInfo_;
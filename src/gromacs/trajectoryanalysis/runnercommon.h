@@ -121,6 +121,8 @@ public:
 
     //! Returns true if input data comes from a trajectory.
     bool hasTrajectory() const;
+    //! Returns the number of frames to analyze concurrently.
+    int threadCount() const;
     //! Returns the topology information object.
     const TopologyInformation& topologyInformation() const;
     //! Returns the currently loaded frame.
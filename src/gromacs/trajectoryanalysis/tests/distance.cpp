@@ -43,9 +43,18 @@
 
 #include "gromacs/trajectoryanalysis/modules/distance.h"
 
+#include <string>
+#include <vector>
+
 #include <gtest/gtest.h>
 
+#include "gromacs/commandline/cmdlineoptionsmodule.h"
+#include "gromacs/trajectoryanalysis/cmdlinerunner.h"
+#include "gromacs/utility/stringutil.h"
+#include "gromacs/utility/textreader.h"
+
 #include "testutils/cmdlinetest.h"
+#include "testutils/testfilemanager.h"
 
 #include "moduletest.h"
 
@@ -90,4 +99,70 @@ TEST_F(DistanceModuleTest, HandlesDynamicSelections)
     runTest(CommandLine(cmdline));
 }
 
+TEST_F(DistanceModuleTest, ComputesDistancesWithFrameParallelism)
+{
+    const char* const cmdline[] = { "distance", "-select", "atomnr 1 to 6", "atomnr 1 4",
+                                    "-len",     "0.3",     "-binw",         "0.05",
+                                    "-nt",      "4" };
+    setTrajectory("extract_cluster.trr");
+    runTest(CommandLine(cmdline));
+}
+
+/*! \brief
+ * Runs gmx distance on a multi-frame trajectory with \p numThreads threads.
+ *
+ * \returns The data lines, without the comments and xmgrace commands,
+ *     of all the output files concatenated.
+ */
+std::string runDistanceWithThreads(gmx::test::TestFileManager* fileManager, int numThreads)
+{
+    const char* const outputOptions[] = { "-oall", "-oxyz", "-oh", "-oallstat" };
+
+    CommandLine cmdline;
+    cmdline.append("distance");
+    cmdline.addOption("-f", gmx::test::TestFileManager::getInputFilePath("extract_cluster.trr"));
+    cmdline.addOption("-select");
+    cmdline.append("atomnr 1 to 6");
+    cmdline.append("atomnr 1 4");
+    cmdline.addOption("-len", "0.3");
+    cmdline.addOption("-binw", "0.05");
+    cmdline.addOption("-nt", numThreads);
+    std::vector<std::string> outputFiles;
+    for (const char* option : outputOptions)
+    {
+        outputFiles.push_back(fileManager->getTemporaryFilePath(
+                gmx::formatString("%s-nt%d.xvg", option + 1, numThreads)));
+        cmdline.addOption(option, outputFiles.back());
+    }
+
+    gmx::ICommandLineOptionsModulePointer runner(
+            gmx::TrajectoryAnalysisCommandLineRunner::createModule(
+                    gmx::analysismodules::DistanceInfo::create()));
+    EXPECT_EQ(0, gmx::test::CommandLineTestHelper::runModuleDirect(std::move(runner), &cmdline));
+
+    std::string data;
+    for (const std::string& outputFile : outputFiles)
+    {
+        gmx::TextReader reader(outputFile);
+        std::string     line;
+        while (reader.readLine(&line))
+        {
+            if (!line.empty() && line[0] != '#' && line[0] != '@')
+            {
+                data += line;
+            }
+        }
+    }
+    return data;
+}
+
+TEST(DistanceFrameParallelismTest, GivesIdenticalOutputWithOneAndMoreThreads)
+{
+    gmx::test::TestFileManager fileManager;
+
+    const std::string serialData = runDistanceWithThreads(&fileManager, 1);
+    EXPECT_FALSE(serialData.empty());
+    EXPECT_EQ(serialData, runDistanceWithThreads(&fileManager, 4));
+}
+
 } // namespace
@@ -131,7 +131,7 @@ public:
         }
     }
 
-    void calculate(int ndots, int flags, bool bPBC)
+    void calculate(int ndots, int flags, bool bPBC, int threadCount = 1)
     {
         volume_ = 0.0;
         sfree(atomArea_);
@@ -147,6 +147,7 @@ public:
         gmx::SurfaceAreaCalculator calculator;
         calculator.setDotCount(ndots);
         calculator.setRadii(radius_);
+        calculator.setThreadCount(threadCount);
         calculator.calculate(as_rvec_array(x_.data()), bPBC ? &pbc : nullptr, index_.size(),
                              index_.data(), flags, &area_, &volume_, &atomArea_, &dots_, &dotCount_);
     }
@@ -299,6 +300,24 @@ TEST_F(SurfaceAreaTest, Computes100Points)
     checkReference(&checker, "100Points", false);
 }
 
+TEST_F(SurfaceAreaTest, Computes100PointsWithThreads)
+{
+    gmx::test::TestReferenceChecker checker(data_.rootChecker());
+    checker.setDefaultTolerance(gmx::test::absoluteTolerance(0.001));
+    box_[XX][XX] = 10.0;
+    box_[YY][YY] = 10.0;
+    box_[ZZ][ZZ] = 10.0;
+    generateRandomPositions(100);
+    ASSERT_NO_FATAL_FAILURE(calculate(24, FLAG_VOLUME | FLAG_ATOM_AREA | FLAG_DOTS, false, 1));
+    const real serialArea   = resultArea();
+    const real serialVolume = resultVolume();
+    ASSERT_NO_FATAL_FAILURE(calculate(24, FLAG_VOLUME | FLAG_ATOM_AREA | FLAG_DOTS, false, 4));
+    // The per-atom results are summed in the same order with any number of threads
+    EXPECT_EQ(serialArea, resultArea());
+    EXPECT_EQ(serialVolume, resultVolume());
+    checkReference(&checker, "100Points", false);
+}
+
 TEST_F(SurfaceAreaTest, Computes100PointsWithRectangularPBC)
 {
     // TODO: It would be nice to check that this produces the same result as
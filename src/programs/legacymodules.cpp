@@ -67,7 +67,9 @@
 #include "gromacs/tools/report_methods.h"
 #include "gromacs/tools/trjcat.h"
 #include "gromacs/tools/trjconv.h"
+#include "gromacs/tools/trjindex.h"
 #include "gromacs/tools/tune_pme.h"
+#include "gromacs/tools/xtc_benchmark.h"
 
 #include "mdrun/mdrun_main.h"
 #include "mdrun/nonbonded_bench.h"
@@ -189,6 +191,9 @@ void registerLegacyModules(gmx::CommandLineModuleManager* manager)
     gmx::ICommandLineOptionsModule::registerModuleFactory(
             manager, gmx::NonbondedBenchmarkInfo::name,
             gmx::NonbondedBenchmarkInfo::shortDescription, &gmx::NonbondedBenchmarkInfo::create);
+    gmx::ICommandLineOptionsModule::registerModuleFactory(manager, gmx::XtcBenchmarkInfo::name,
+                                                          gmx::XtcBenchmarkInfo::shortDescription,
+                                                          &gmx::XtcBenchmarkInfo::create);
 
     gmx::ICommandLineOptionsModule::registerModuleFactory(manager, gmx::InsertMoleculesInfo::name(),
                                                           gmx::InsertMoleculesInfo::shortDescription(),
@@ -221,6 +226,9 @@ void registerLegacyModules(gmx::CommandLineModuleManager* manager)
     registerModule(manager, &gmx_mk_angndx, "mk_angndx", "Generate index files for 'gmx angle'");
     registerModule(manager, &gmx_trjcat, "trjcat", "Concatenate trajectory files");
     registerModule(manager, &gmx_trjconv, "trjconv", "Convert and manipulates trajectory files");
+    gmx::ICommandLineOptionsModule::registerModuleFactory(manager, gmx::TrjIndexInfo::name,
+                                                          gmx::TrjIndexInfo::shortDescription,
+                                                          &gmx::TrjIndexInfo::create);
     registerModule(manager, &gmx_trjorder, "trjorder",
                    "Order molecules according to their distance to a group");
     registerModule(manager, &gmx_xpm2ps, "xpm2ps",
@@ -365,6 +373,7 @@ void registerLegacyModules(gmx::CommandLineModuleManager* manager)
         group.addModule("sigeps");
         group.addModule("trjcat");
         group.addModule("trjconv");
+        group.addModule("trjindex");
         group.addModule("xpm2ps");
     }
     {
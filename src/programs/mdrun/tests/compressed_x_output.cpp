@@ -42,7 +42,10 @@
  */
 #include "gmxpre.h"
 
+#include <fstream>
+#include <iterator>
 #include <string>
+#include <vector>
 
 #include <gtest/gtest.h>
 
@@ -50,6 +53,7 @@
 #include "gromacs/tools/check.h"
 
 #include "testutils/cmdlinetest.h"
+#include "testutils/setenv.h"
 
 #include "moduletest.h"
 
@@ -89,6 +93,56 @@ TEST_P(MdrunCompressedXOutput, ExitsNormally)
     ASSERT_EQ(0, gmx_check(checkCaller.argc(), checkCaller.argv()));
 }
 
+//! Returns the contents of binary file \p filename
+std::vector<char> readBinaryFile(const std::string& filename)
+{
+    std::ifstream stream(filename, std::ios::binary);
+    return std::vector<char>(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+}
+
+/* This test checks that writing on the trajectory output thread gives the same files. */
+TEST_P(MdrunCompressedXOutput, IsTheSameWhenWrittenOnOutputThread)
+{
+    std::string mdpFile(R"(cutoff-scheme = Verlet
+                           verlet-buffer-tolerance = 0.005
+                           nsteps = 6
+                           nstxout = 2
+                           nstxout-compressed = 1
+                           )");
+    std::string compressedXGrpsLine = GetParam();
+    mdpFile += compressedXGrpsLine;
+    runner_.useStringAsMdpFile(mdpFile.c_str());
+    runner_.useTopGroAndNdxFromDatabase("spc2");
+    ASSERT_EQ(0, runner_.callGrompp());
+
+    const char* environmentVariableBackup = getenv("GMX_TRAJ_ASYNC");
+    gmx::test::gmxUnsetenv("GMX_TRAJ_ASYNC");
+    runner_.fullPrecisionTrajectoryFileName_    = fileManager_.getTemporaryFilePath(".trr");
+    runner_.reducedPrecisionTrajectoryFileName_ = fileManager_.getTemporaryFilePath(".xtc");
+    ASSERT_EQ(0, runner_.callMdrun());
+
+    // Use a queue of a single frame, so the MD thread has to wait for the output thread
+    gmx::test::gmxSetenv("GMX_TRAJ_ASYNC", "1", 1);
+    runner_.fullPrecisionTrajectoryFileName_    = fileManager_.getTemporaryFilePath("thread.trr");
+    runner_.reducedPrecisionTrajectoryFileName_ = fileManager_.getTemporaryFilePath("thread.xtc");
+    ASSERT_EQ(0, runner_.callMdrun());
+
+    if (environmentVariableBackup != nullptr)
+    {
+        gmx::test::gmxSetenv("GMX_TRAJ_ASYNC", environmentVariableBackup, 1);
+    }
+    else
+    {
+        gmx::test::gmxUnsetenv("GMX_TRAJ_ASYNC");
+    }
+
+    EXPECT_EQ(readBinaryFile(fileManager_.getTemporaryFilePath(".trr")),
+              readBinaryFile(runner_.fullPrecisionTrajectoryFileName_));
+    EXPECT_EQ(readBinaryFile(fileManager_.getTemporaryFilePath(".xtc")),
+              readBinaryFile(runner_.reducedPrecisionTrajectoryFileName_));
+    EXPECT_FALSE(readBinaryFile(runner_.reducedPrecisionTrajectoryFileName_).empty());
+}
+
 INSTANTIATE_TEST_CASE_P(WithDifferentOutputGroupSettings,
                         MdrunCompressedXOutput,
                         ::testing::Values( // Test writing the whole system via
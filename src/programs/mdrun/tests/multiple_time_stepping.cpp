@@ -0,0 +1,264 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2021, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+
+/*! \internal \file
+ * \brief
+ * Tests for the multiple time-stepping integrator.
+ *
+ * \ingroup module_mdrun_integration_tests
+ */
+#include "gmxpre.h"
+
+#include <cmath>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "gromacs/topology/ifunc.h"
+#include "gromacs/trajectory/energyframe.h"
+#include "gromacs/trajectory/trajectoryframe.h"
+#include "gromacs/utility/stringutil.h"
+
+#include "testutils/testasserts.h"
+
+#include "energycomparison.h"
+#include "energyreader.h"
+#include "moduletest.h"
+#include "trajectorycomparison.h"
+#include "trajectoryreader.h"
+
+namespace gmx
+{
+namespace test
+{
+namespace
+{
+
+//! The MTS factor used in these tests
+constexpr int c_mtsFactor = 2;
+
+/*! \brief Returns the mdp options shared by the single and multiple time-stepping runs
+ *
+ * Energies and forces are computed and written at slow steps only.
+ */
+std::string sharedMdpOptions(int numSteps, int nstenergy, int nstfout)
+{
+    return formatString(
+            "integrator              = md\n"
+            "dt                      = 0.002\n"
+            "nsteps                  = %d\n"
+            "nstcalcenergy           = %d\n"
+            "nstenergy               = %d\n"
+            "nstfout                 = %d\n"
+            "verlet-buffer-tolerance = -1\n"
+            "rlist                   = 0.9\n"
+            "coulombtype             = PME\n"
+            "rcoulomb                = 0.9\n"
+            "rvdw                    = 0.9\n"
+            "fourier-spacing         = 0.12\n"
+            "tcoupl                  = no\n"
+            "pcoupl                  = no\n"
+            "constraints             = h-bonds\n",
+            numSteps, c_mtsFactor, nstenergy, nstfout);
+}
+
+//! Returns the mdp options for MTS with only the PME mesh part in level 2
+std::string mtsMdpOptions()
+{
+    return formatString(
+            "mts                     = yes\n"
+            "mts-levels              = 2\n"
+            "mts-level2-forces       = longrange-nonbonded\n"
+            "mts-level2-factor       = %d\n",
+            c_mtsFactor);
+}
+
+//! Test fixture for runs with multiple time stepping
+class MtsTest : public MdrunTestFixture
+{
+public:
+    //! Runs grompp and mdrun, writing energies to \p edrFileName and forces to \p trrFileName
+    void runSimulation(const std::string& mdpOptions,
+                       const std::string& edrFileName,
+                       const std::string& trrFileName)
+    {
+        runner_.useTopGroAndNdxFromDatabase("spc216");
+        runner_.useStringAsMdpFile(mdpOptions);
+        runner_.tprFileName_ = fileManager_.getTemporaryFilePath(".tpr");
+        ASSERT_EQ(0, runner_.callGrompp());
+
+        runner_.edrFileName_                     = edrFileName;
+        runner_.fullPrecisionTrajectoryFileName_ = trrFileName;
+        ASSERT_EQ(0, runner_.callMdrun());
+    }
+};
+
+/* At step 0 both runs start from the same coordinates, so the forces,
+ * energies and virial should match. The virial tests the extra constraint
+ * pass with the unscaled forces. At later slow steps the runs differ by
+ * the MTS integration error, which is small for the PME mesh part.
+ * When the slow forces are not scaled by the MTS factor, the potential
+ * energy after 4 steps deviates several times more than the tolerance.
+ */
+TEST_F(MtsTest, ReproducesSingleTimeSteppingOnSlowSteps)
+{
+    const int numSteps = 2 * c_mtsFactor;
+
+    const std::string referenceEdrFileName = fileManager_.getTemporaryFilePath("reference.edr");
+    const std::string referenceTrrFileName = fileManager_.getTemporaryFilePath("reference.trr");
+    const std::string mtsEdrFileName       = fileManager_.getTemporaryFilePath("mts.edr");
+    const std::string mtsTrrFileName       = fileManager_.getTemporaryFilePath("mts.trr");
+
+    const std::string mdpOptions = sharedMdpOptions(numSteps, c_mtsFactor, c_mtsFactor);
+    runSimulation(mdpOptions, referenceEdrFileName, referenceTrrFileName);
+    runSimulation(mdpOptions + mtsMdpOptions(), mtsEdrFileName, mtsTrrFileName);
+
+    const std::string potentialName = interaction_function[F_EPOT].longname;
+    const std::string recipName     = interaction_function[F_COUL_RECIP].longname;
+
+    const FloatingPointTolerance firstStepTolerance =
+            relativeToleranceAsPrecisionDependentUlp(10000.0, 50, 20);
+    const FloatingPointTolerance laterStepTolerance = relativeToleranceAsFloatingPoint(10000.0, 5e-4);
+    const FloatingPointTolerance laterStepVirialTolerance =
+            relativeToleranceAsFloatingPoint(1000.0, 0.02);
+
+    EnergyComparison firstStepEnergyComparison({ { potentialName, firstStepTolerance },
+                                                 { recipName, firstStepTolerance },
+                                                 { "Vir-XX", firstStepTolerance },
+                                                 { "Vir-YY", firstStepTolerance },
+                                                 { "Vir-ZZ", firstStepTolerance } });
+    EnergyComparison laterStepEnergyComparison({ { potentialName, laterStepTolerance },
+                                                 { recipName, laterStepTolerance },
+                                                 { "Vir-XX", laterStepVirialTolerance },
+                                                 { "Vir-YY", laterStepVirialTolerance },
+                                                 { "Vir-ZZ", laterStepVirialTolerance } });
+
+    const auto energyNames = firstStepEnergyComparison.getEnergyNames();
+    auto referenceEnergies = openEnergyFileToReadTerms(referenceEdrFileName, energyNames);
+    auto mtsEnergies       = openEnergyFileToReadTerms(mtsEdrFileName, energyNames);
+    int  numEnergyFrames   = 0;
+    while (referenceEnergies->readNextFrame())
+    {
+        ASSERT_TRUE(mtsEnergies->readNextFrame());
+        const EnergyFrame referenceFrame = referenceEnergies->frame();
+        const EnergyFrame mtsFrame       = mtsEnergies->frame();
+        SCOPED_TRACE("Comparing energy " + referenceFrame.frameName());
+        if (numEnergyFrames == 0)
+        {
+            firstStepEnergyComparison(referenceFrame, mtsFrame);
+        }
+        else
+        {
+            laterStepEnergyComparison(referenceFrame, mtsFrame);
+        }
+        numEnergyFrames++;
+    }
+    EXPECT_FALSE(mtsEnergies->readNextFrame());
+    EXPECT_EQ(numSteps / c_mtsFactor + 1, numEnergyFrames);
+
+    const TrajectoryFrameMatchSettings matchSettings{ false,
+                                                      false,
+                                                      false,
+                                                      ComparisonConditions::NoComparison,
+                                                      ComparisonConditions::NoComparison,
+                                                      ComparisonConditions::MustCompare };
+    TrajectoryTolerances firstStepTolerances = TrajectoryComparison::s_defaultTrajectoryTolerances;
+    TrajectoryTolerances laterStepTolerances = TrajectoryComparison::s_defaultTrajectoryTolerances;
+    laterStepTolerances.forces               = relativeToleranceAsFloatingPoint(1000.0, 0.05);
+    TrajectoryComparison firstStepForceComparison(matchSettings, firstStepTolerances);
+    TrajectoryComparison laterStepForceComparison(matchSettings, laterStepTolerances);
+
+    TrajectoryFrameReader referenceTrajectory(referenceTrrFileName);
+    TrajectoryFrameReader mtsTrajectory(mtsTrrFileName);
+    int                   numTrajectoryFrames = 0;
+    while (referenceTrajectory.readNextFrame())
+    {
+        ASSERT_TRUE(mtsTrajectory.readNextFrame());
+        const TrajectoryFrame referenceFrame = referenceTrajectory.frame();
+        const TrajectoryFrame mtsFrame       = mtsTrajectory.frame();
+        SCOPED_TRACE("Comparing trajectory " + referenceFrame.frameName());
+        if (numTrajectoryFrames == 0)
+        {
+            firstStepForceComparison(referenceFrame, mtsFrame);
+        }
+        else
+        {
+            laterStepForceComparison(referenceFrame, mtsFrame);
+        }
+        numTrajectoryFrames++;
+    }
+    EXPECT_FALSE(mtsTrajectory.readNextFrame());
+    EXPECT_EQ(numSteps / c_mtsFactor + 1, numTrajectoryFrames);
+}
+
+/* In an NVE run with MTS the total energy should be conserved about as
+ * well as without MTS. When the slow forces are not scaled by the MTS
+ * factor, the maximum deviation is about five times larger.
+ */
+TEST_F(MtsTest, ConservesEnergyInNve)
+{
+    const int  numSteps            = 500;
+    const int  nstenergy           = 10 * c_mtsFactor;
+    const int  numAtoms            = 648;
+    const real maxDeviationPerAtom = 0.01;
+
+    const std::string edrFileName = fileManager_.getTemporaryFilePath("nve.edr");
+    const std::string trrFileName = fileManager_.getTemporaryFilePath("nve.trr");
+    runSimulation(sharedMdpOptions(numSteps, nstenergy, 0) + mtsMdpOptions(), edrFileName,
+                  trrFileName);
+
+    const std::string totalEnergyName = interaction_function[F_ETOT].longname;
+    auto              energies        = openEnergyFileToReadTerms(edrFileName, { totalEnergyName });
+    ASSERT_TRUE(energies->readNextFrame());
+    const real initialEnergy   = energies->frame().at(totalEnergyName);
+    real       maxDeviation    = 0;
+    int        numEnergyFrames = 1;
+    while (energies->readNextFrame())
+    {
+        const real energy = energies->frame().at(totalEnergyName);
+        maxDeviation      = std::max(maxDeviation, std::abs(energy - initialEnergy));
+        numEnergyFrames++;
+    }
+    EXPECT_EQ(numSteps / nstenergy + 1, numEnergyFrames);
+    EXPECT_LT(maxDeviation, maxDeviationPerAtom * numAtoms)
+            << "The total energy deviates too much from its initial value";
+}
+
+} // namespace
+} // namespace test
+} // namespace gmx
@@ -54,6 +54,7 @@
 #include "gromacs/utility/stringutil.h"
 #include "gromacs/utility/textreader.h"
 
+#include "testutils/setenv.h"
 #include "testutils/testasserts.h"
 #include "testutils/testfilemanager.h"
 
@@ -115,6 +116,55 @@ TEST_F(MdrunTerminationTest, CheckpointRestartAppendsByDefault)
     }
 }
 
+TEST_F(MdrunTerminationTest, CheckpointRestartAppendsWithBackgroundCheckpointWriting)
+{
+    runner_.cptFileName_ = fileManager_.getTemporaryFilePath(".cpt");
+
+    runner_.useTopGroAndNdxFromDatabase("spc2");
+    organizeMdpFile(&runner_);
+    EXPECT_EQ(0, runner_.callGrompp());
+
+    const char* environmentVariableBackup = getenv("GMX_CPT_ASYNC");
+    gmxSetenv("GMX_CPT_ASYNC", "1", 1);
+
+    SCOPED_TRACE("Running the first simulation part writing the checkpoint in the background");
+    {
+        CommandLine firstPart;
+        firstPart.append("mdrun");
+        firstPart.addOption("-cpo", runner_.cptFileName_);
+        ASSERT_EQ(0, runner_.callMdrun(firstPart));
+        ASSERT_TRUE(File::exists(runner_.cptFileName_, File::returnFalseOnError))
+                << runner_.cptFileName_ << " was not found and should be";
+        auto temporaryCptFileName = fileManager_.getTemporaryFilePath("_step2.cpt");
+        EXPECT_FALSE(File::exists(temporaryCptFileName, File::returnFalseOnError))
+                << temporaryCptFileName << " was found and should have been renamed";
+    }
+    SCOPED_TRACE("Running the second simulation part with default appending behavior");
+    {
+        runner_.changeTprNsteps(4);
+
+        CommandLine secondPart;
+        secondPart.append("mdrun");
+        secondPart.addOption("-cpi", runner_.cptFileName_);
+        ASSERT_EQ(0, runner_.callMdrun(secondPart));
+
+        auto logFileContents = TextReader::readFileToString(runner_.logFileName_);
+        EXPECT_NE(
+                std::string::npos,
+                logFileContents.find("Restarting from checkpoint, appending to previous log file"))
+                << "appending was not detected";
+    }
+
+    if (environmentVariableBackup != nullptr)
+    {
+        gmxSetenv("GMX_CPT_ASYNC", environmentVariableBackup, 1);
+    }
+    else
+    {
+        gmxUnsetenv("GMX_CPT_ASYNC");
+    }
+}
+
 TEST_F(MdrunTerminationTest, WritesCheckpointAfterMaxhTerminationAndThenRestarts)
 {
     runner_.cptFileName_ = fileManager_.getTemporaryFilePath(".cpt");